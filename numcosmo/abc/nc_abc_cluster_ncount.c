@@ -602,6 +602,9 @@ _nc_abc_cluster_ncount_update_tkern (NcmABC *abc)
       ncm_abc_update_epsilon (abc, dist);
       break;
     }
+    case NC_ABC_CLUSTER_NCOUNT_EPSILON_UPDATE_ESS:
+      ncm_abc_update_epsilon (abc, ncm_abc_get_adaptive_epsilon (abc, abcnc->epsilon_update));
+      break;
     default:
       g_assert_not_reached ();
       break;
@@ -659,7 +662,9 @@ nc_abc_cluster_ncount_set_scale_cov (NcABCClusterNCount *abcnc, gboolean on)
  * @abcnc: a #NcABCClusterNCount.
  * @q: the quantile $q \in (0, 1)$.
  * 
- * Sets the quantile used to update epsilon.
+ * Sets the quantile used to update epsilon. When using 
+ * #NC_ABC_CLUSTER_NCOUNT_EPSILON_UPDATE_ESS, @q is the fraction of 
+ * the effective sample size kept by the new tolerance.
  * 
  */
 void 
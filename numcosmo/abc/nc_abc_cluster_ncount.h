@@ -76,6 +76,8 @@ typedef enum _NcABCClusterNCountSummary
  * NcABCClusterNCountEpsilonUpdate:
  * @NC_ABC_CLUSTER_NCOUNT_EPSILON_UPDATE_UNIFORM: FIXME
  * @NC_ABC_CLUSTER_NCOUNT_EPSILON_UPDATE_QUANTILE: FIXME
+ * @NC_ABC_CLUSTER_NCOUNT_EPSILON_UPDATE_ESS: the new tolerance keeps the fraction 
+ * #NcABCClusterNCount:epsilon-update of the effective sample size, see ncm_abc_get_adaptive_epsilon().
  * 
  * FIXME
  * 
@@ -83,7 +85,8 @@ typedef enum _NcABCClusterNCountSummary
 typedef enum _NcABCClusterNCountEpsilonUpdate 
 {
   NC_ABC_CLUSTER_NCOUNT_EPSILON_UPDATE_UNIFORM = 0, 
-  NC_ABC_CLUSTER_NCOUNT_EPSILON_UPDATE_QUANTILE, /*< private >*/
+  NC_ABC_CLUSTER_NCOUNT_EPSILON_UPDATE_QUANTILE,
+  NC_ABC_CLUSTER_NCOUNT_EPSILON_UPDATE_ESS,      /*< private >*/
   NC_ABC_CLUSTER_NCOUNT_EPSILON_UPDATE_NTYPE,    /*< skip >*/
 }NcABCClusterNCountEpsilonUpdate;
 
@@ -98,7 +98,7 @@ nc_data_snia_cov_init (NcDataSNIACov *snia_cov)
   snia_cov->sigma_thirdpar    = NULL;
 
   snia_cov->cov_full          = NULL;
-  snia_cov->cov_full_diag     = NULL;
+  snia_cov->cov_full_LLT      = NULL;
   snia_cov->cov_packed        = NULL;
 
   snia_cov->inv_cov_mm        = NULL;
@@ -117,8 +117,18 @@ nc_data_snia_cov_init (NcDataSNIACov *snia_cov)
   snia_cov->cosmo_resample_ctrl = ncm_model_ctrl_new (NULL);
   snia_cov->dcov_resample_ctrl  = ncm_model_ctrl_new (NULL);
   snia_cov->dcov_cov_full_ctrl  = ncm_model_ctrl_new (NULL);
+  snia_cov->dcov_cov_ctrl       = ncm_model_ctrl_new (NULL);
+
+  /* The covariance does not depend on the absolute magnitudes and distance moduli. */
+  ncm_model_ctrl_add_dep (snia_cov->dcov_cov_ctrl, "alpha");
+  ncm_model_ctrl_add_dep (snia_cov->dcov_cov_ctrl, "beta");
+  ncm_model_ctrl_add_dep (snia_cov->dcov_cov_ctrl, "lnsigma_pecz");
+  ncm_model_ctrl_add_dep (snia_cov->dcov_cov_ctrl, "lnsigma_lens");
+  ncm_model_ctrl_add_dep (snia_cov->dcov_cov_ctrl, "lnsigma_int");
 }
 
+static void _nc_data_snia_cov_set_cov_full_ref (NcDataSNIACov *snia_cov, NcmMatrix *cov_full);
+
 static void
 nc_data_snia_cov_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
 {
@@ -162,8 +172,12 @@ nc_data_snia_cov_set_property (GObject *object, guint prop_id, const GValue *val
       break;
     }
     case PROP_COV_FULL:
-      nc_data_snia_cov_set_cov_full (snia_cov, g_value_get_object (value));
+    {
+      NcmMatrix *cov_full = g_value_get_object (value);
+      if (cov_full != NULL)
+        _nc_data_snia_cov_set_cov_full_ref (snia_cov, cov_full);
       break;
+    }
     case PROP_HAS_COMPLETE_COV:
       snia_cov->has_complete_cov = g_value_get_boolean (value);
       break;
@@ -222,7 +236,6 @@ nc_data_snia_cov_get_property (GObject *object, guint prop_id, GValue *value, GP
 
 static void _nc_data_snia_cov_prep_to_resample (NcDataSNIACov *snia_cov, NcSNIADistCov *dcov);
 static void _nc_data_snia_cov_prep_to_estimate (NcDataSNIACov *snia_cov, NcSNIADistCov *dcov);
-static void _nc_data_snia_cov_restore_full_cov (NcDataSNIACov *snia_cov);
 
 static void
 nc_data_snia_cov_constructed (GObject *object)
@@ -244,6 +257,7 @@ nc_data_snia_cov_dispose (GObject *object)
   ncm_model_ctrl_clear (&snia_cov->cosmo_resample_ctrl);
   ncm_model_ctrl_clear (&snia_cov->dcov_resample_ctrl);
   ncm_model_ctrl_clear (&snia_cov->dcov_cov_full_ctrl);
+  ncm_model_ctrl_clear (&snia_cov->dcov_cov_ctrl);
     
   /* Chain up : end */
   G_OBJECT_CLASS (nc_data_snia_cov_parent_class)->dispose (object);
@@ -259,6 +273,7 @@ nc_data_snia_cov_finalize (GObject *object)
 }
 
 static void _nc_data_snia_cov_prepare (NcmData *data, NcmMSet *mset);
+static void _nc_data_snia_cov_share_payload (NcmData *data, NcmSerialize *ser);
 static void _nc_data_snia_cov_resample (NcmData *data, NcmMSet *mset, NcmRNG *rng);
 static void _nc_data_snia_cov_mean_func (NcmDataGaussCov *gauss, NcmMSet *mset, NcmVector *vp);
 static gboolean _nc_data_snia_cov_func (NcmDataGaussCov *gauss, NcmMSet *mset, NcmMatrix *cov);
@@ -357,8 +372,9 @@ nc_data_snia_cov_class_init (NcDataSNIACovClass *klass)
                                                          FALSE,
                                                          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
 
-  data_class->resample   = &_nc_data_snia_cov_resample;
-  data_class->prepare    = &_nc_data_snia_cov_prepare;
+  data_class->resample      = &_nc_data_snia_cov_resample;
+  data_class->prepare       = &_nc_data_snia_cov_prepare;
+  data_class->share_payload = &_nc_data_snia_cov_share_payload;
 
   gauss_class->mean_func = &_nc_data_snia_cov_mean_func;
   gauss_class->cov_func  = &_nc_data_snia_cov_func;
@@ -377,6 +393,23 @@ _nc_data_snia_cov_prepare (NcmData *data, NcmMSet *mset)
   nc_snia_dist_cov_prepare_if_needed (dcov, mset);
 }
 
+static void
+_nc_data_snia_cov_share_payload (NcmData *data, NcmSerialize *ser)
+{
+  NcDataSNIACov *snia_cov = NC_DATA_SNIA_COV (data);
+
+  /* Chain up : start */
+  NCM_DATA_CLASS (nc_data_snia_cov_parent_class)->share_payload (data, ser);
+
+  /* 
+   * cov_full is never written after it is set, the decompositions live in
+   * cov_full_LLT, the components and inv_cov_mm are attached to the
+   * cov_full instance.
+   */
+  if (snia_cov->cov_full != NULL)
+    ncm_serialize_share (ser, snia_cov->cov_full);
+}
+
 static void 
 _nc_data_snia_cov_mean_func (NcmDataGaussCov *gauss, NcmMSet *mset, NcmVector *vp)
 {
@@ -391,6 +424,10 @@ _nc_data_snia_cov_func (NcmDataGaussCov *gauss, NcmMSet *mset, NcmMatrix *cov)
 {
   NcDataSNIACov *snia_cov = NC_DATA_SNIA_COV (gauss);
   NcSNIADistCov *dcov = NC_SNIA_DIST_COV (ncm_mset_peek (mset, nc_snia_dist_cov_id ()));
+
+  if (!ncm_model_ctrl_update (snia_cov->dcov_cov_ctrl, NCM_MODEL (dcov)))
+    return FALSE;
+
   nc_snia_dist_cov_calc (dcov, snia_cov, cov);
   
   return TRUE;
@@ -564,6 +601,9 @@ _nc_data_snia_cov_set_size (NcmDataGaussCov *gauss, guint mu_len)
   {
     NcDataSNIACov *snia_cov = NC_DATA_SNIA_COV (gauss);
 
+    if (snia_cov->dcov_cov_ctrl != NULL)
+      ncm_model_ctrl_force_update (snia_cov->dcov_cov_ctrl);
+
     if (mu_len == 0 || mu_len != snia_cov->mu_len)
     {
       ncm_vector_clear (&snia_cov->z_cmb);
@@ -582,7 +622,7 @@ _nc_data_snia_cov_set_size (NcmDataGaussCov *gauss, guint mu_len)
       ncm_vector_clear (&snia_cov->sigma_thirdpar);
 
       ncm_vector_clear (&snia_cov->cov_packed);
-      ncm_vector_clear (&snia_cov->cov_full_diag);
+      ncm_matrix_clear (&snia_cov->cov_full_LLT);
       ncm_matrix_clear (&snia_cov->cov_full);
 
       ncm_matrix_clear (&snia_cov->inv_cov_mm_LU);
@@ -621,9 +661,7 @@ _nc_data_snia_cov_set_size (NcmDataGaussCov *gauss, guint mu_len)
       snia_cov->sigma_z          = ncm_vector_new (mu_len);
       snia_cov->sigma_thirdpar   = ncm_vector_new (mu_len);
 
-      snia_cov->cov_full_diag    = ncm_vector_new (3 * mu_len);
       snia_cov->cov_full         = ncm_matrix_new (3 * mu_len, 3 * mu_len);
-      snia_cov->cov_packed       = ncm_vector_new (snia_cov->uppertri_len * NC_DATA_SNIA_COV_ORDER_LENGTH);
 
       snia_cov->inv_cov_mm       = ncm_matrix_new (mu_len, mu_len);
       snia_cov->inv_cov_mm_LU    = ncm_matrix_new (mu_len, mu_len);
@@ -649,12 +687,13 @@ static void _nc_data_snia_cov_diag_to_full_cov (NcDataSNIACov *snia_cov,
                                               NcmVector *diag_mag_width, 
                                               NcmVector *diag_mag_colour,
                                               NcmVector *diag_width_colour);
-static void _nc_data_snia_cov_save_cov_lowertri (NcDataSNIACov *snia_cov);
+static void _nc_data_snia_cov_symmetrize_cov_full (NcDataSNIACov *snia_cov);
 
 static void 
 _nc_data_snia_cov_set_data_init (NcDataSNIACov *snia_cov, gint data_bw)
 {
   snia_cov->data_init = snia_cov->data_init | data_bw;
+  ncm_model_ctrl_force_update (snia_cov->dcov_cov_ctrl);
   if ((snia_cov->data_init & NC_DATA_SNIA_COV_INIT_ALL) == snia_cov->data_init)
     ncm_data_set_init (NCM_DATA (snia_cov), TRUE);
   else
@@ -784,8 +823,6 @@ nc_data_snia_cov_peek_abs_mag_set (NcDataSNIACov *snia_cov)
 NcmMatrix *
 nc_data_snia_cov_peek_cov_full (NcDataSNIACov *snia_cov)
 {
-  if (snia_cov->mu_len > 0)
-    _nc_data_snia_cov_restore_full_cov (snia_cov);
   return snia_cov->cov_full;
 }
 
@@ -981,90 +1018,238 @@ nc_data_snia_cov_set_abs_mag_set (NcDataSNIACov *snia_cov, GArray *abs_mag_set)
 }
 
 /**
- * nc_data_snia_cov_set_cov_full:
+ * nc_data_snia_cov_set_abs_mag_lin:
  * @snia_cov: a #NcDataSNIACov
- * @cov_full: the full convariance #NcmMatrix
+ * @enable: whether to remove the absolute magnitudes analytically
  * 
- * Sets the full covariance for the system, the size of @cov_full,
- * must match the system size.
+ * If @enable is TRUE, sets the design matrix of the absolute magnitudes
+ * #NC_SNIA_DIST_COV_M1 and #NC_SNIA_DIST_COV_M2 (selected by the third
+ * parameter of each SNIa) as the linear nuisance parameters of the parent
+ * #NcmDataGaussCov. They are then profiled or marginalized in closed form,
+ * see ncm_data_gauss_cov_set_lin_marg(), and the corresponding parameters
+ * of #NcSNIADistCov must be kept fixed. Magnitudes without any SNIa are
+ * not included. This function must be called again if the third
+ * parameter changes.
  * 
  */
 void 
-nc_data_snia_cov_set_cov_full (NcDataSNIACov *snia_cov, NcmMatrix *cov_full)
+nc_data_snia_cov_set_abs_mag_lin (NcDataSNIACov *snia_cov, gboolean enable)
 {
-  const guint mu_len  = snia_cov->mu_len;
-  const guint tmu_len = 3 * mu_len;
-  guint i, j, ij;
-  
-  if (snia_cov->cov_full != cov_full)
+  NcmDataGaussCov *gauss = NCM_DATA_GAUSS_COV (snia_cov);
+
+  if (enable)
   {
-    g_assert_cmpuint (ncm_matrix_nrows (cov_full), ==, tmu_len);
-    g_assert_cmpuint (ncm_matrix_ncols (cov_full), ==, tmu_len);
+    guint n1 = 0, n2 = 0;
+    guint i;
+
+    g_assert (snia_cov->data_init & NC_DATA_SNIA_COV_INIT_THIRDPAR);
+
+    for (i = 0; i < snia_cov->mu_len; i++)
+    {
+      if (ncm_vector_get (snia_cov->thirdpar, i) < 10.0)
+        n1++;
+      else
+        n2++;
+    }
+
+    {
+      NcmMatrix *D   = ncm_matrix_new (snia_cov->mu_len, (n1 > 0) + (n2 > 0));
+      const guint c2 = (n1 > 0) ? 1 : 0;
 
-    ncm_matrix_memcpy (snia_cov->cov_full, cov_full);
-/*    
-    ncm_matrix_clear (&snia_cov->cov_full);
-    snia_cov->cov_full = ncm_matrix_ref (cov_full);
-*/    
+      ncm_matrix_set_zero (D);
+      for (i = 0; i < snia_cov->mu_len; i++)
+      {
+        if (ncm_vector_get (snia_cov->thirdpar, i) < 10.0)
+          ncm_matrix_set (D, i, 0, 1.0);
+        else
+          ncm_matrix_set (D, i, c2, 1.0);
+      }
+
+      ncm_data_gauss_cov_set_lin_design (gauss, D);
+      ncm_matrix_free (D);
+    }
   }
+  else
+    ncm_data_gauss_cov_set_lin_design (gauss, NULL);
+}
 
-  /* Filling the cov_packed from cov_full. */
+/* Blocks of cov_full (in units of mu_len) holding each NcDataSNIACovOrder component. */
+static const guint _nc_data_snia_cov_comp_block[NC_DATA_SNIA_COV_ORDER_LENGTH][2] = {
+  {0, 0}, /* NC_DATA_SNIA_COV_ORDER_MAG_MAG       */
+  {0, 1}, /* NC_DATA_SNIA_COV_ORDER_MAG_WIDTH     */
+  {0, 2}, /* NC_DATA_SNIA_COV_ORDER_MAG_COLOUR    */
+  {1, 1}, /* NC_DATA_SNIA_COV_ORDER_WIDTH_WIDTH   */
+  {1, 2}, /* NC_DATA_SNIA_COV_ORDER_WIDTH_COLOUR  */
+  {2, 2}, /* NC_DATA_SNIA_COV_ORDER_COLOUR_COLOUR */
+};
+
+/*
+ * The components and the mag-mag block of the inverse of cov_full depend
+ * only on cov_full, so they are attached to the cov_full instance and
+ * computed once. Copies referencing the same cov_full (see
+ * ncm_dataset_share_payload()) share them, including the decomposition
+ * needed by the inverse.
+ *
+ * The components are packed in a single vector: for each element ij of
+ * the upper triangle the six components are stored contiguously, at
+ * NC_DATA_SNIA_COV_ORDER_LENGTH * ij + order.
+ */
+#define _NC_DATA_SNIA_COV_PACKED_KEY "nc-data-snia-cov-packed"
+#define _NC_DATA_SNIA_COV_INV_COV_MM_KEY "nc-data-snia-cov-inv-cov-mm"
+G_LOCK_DEFINE_STATIC (cov_full_qdata);
+
+static void
+_nc_data_snia_cov_update_cov_packed (NcDataSNIACov *snia_cov)
+{
+  const guint mu_len = snia_cov->mu_len;
+  NcmVector *cov_packed;
+  guint i, j, k, ij;
+
+  G_LOCK (cov_full_qdata);
+  cov_packed = g_object_get_data (G_OBJECT (snia_cov->cov_full), _NC_DATA_SNIA_COV_PACKED_KEY);
+
+  if (cov_packed == NULL)
   {
+    cov_packed = ncm_vector_new (snia_cov->uppertri_len * NC_DATA_SNIA_COV_ORDER_LENGTH);
+
     ij = 0;
-    for (i = 0; i < snia_cov->mu_len; i++)
+    for (i = 0; i < mu_len; i++)
     {
-      for (j = i; j < snia_cov->mu_len; j++)
+      for (j = i; j < mu_len; j++)
       {
-        const gdouble mag_mag_i       = 0.5 * (ncm_matrix_get (snia_cov->cov_full, 0 * mu_len + i, 0 * mu_len + j) + 
-                                               ncm_matrix_get (snia_cov->cov_full, 0 * mu_len + j, 0 * mu_len + i));
-        const gdouble mag_width_i     = 0.5 * (ncm_matrix_get (snia_cov->cov_full, 0 * mu_len + i, 1 * mu_len + j) + 
-                                               ncm_matrix_get (snia_cov->cov_full, 0 * mu_len + j, 1 * mu_len + i));
-        const gdouble mag_colour_i    = 0.5 * (ncm_matrix_get (snia_cov->cov_full, 0 * mu_len + i, 2 * mu_len + j) + 
-                                               ncm_matrix_get (snia_cov->cov_full, 0 * mu_len + j, 2 * mu_len + i));
-        const gdouble width_width_i   = 0.5 * (ncm_matrix_get (snia_cov->cov_full, 1 * mu_len + i, 1 * mu_len + j) + 
-                                               ncm_matrix_get (snia_cov->cov_full, 1 * mu_len + j, 1 * mu_len + i));
-        const gdouble width_colour_i  = 0.5 * (ncm_matrix_get (snia_cov->cov_full, 1 * mu_len + i, 2 * mu_len + j) + 
-                                               ncm_matrix_get (snia_cov->cov_full, 1 * mu_len + j, 2 * mu_len + i));
-        const gdouble colour_colour_i = 0.5 * (ncm_matrix_get (snia_cov->cov_full, 2 * mu_len + i, 2 * mu_len + j) + 
-                                               ncm_matrix_get (snia_cov->cov_full, 2 * mu_len + j, 2 * mu_len + i));
-        
-        ncm_vector_set (snia_cov->cov_packed, NC_DATA_SNIA_COV_ORDER_LENGTH * ij + NC_DATA_SNIA_COV_ORDER_MAG_MAG,       mag_mag_i);
-        ncm_vector_set (snia_cov->cov_packed, NC_DATA_SNIA_COV_ORDER_LENGTH * ij + NC_DATA_SNIA_COV_ORDER_MAG_WIDTH,     mag_width_i);
-        ncm_vector_set (snia_cov->cov_packed, NC_DATA_SNIA_COV_ORDER_LENGTH * ij + NC_DATA_SNIA_COV_ORDER_MAG_COLOUR,    mag_colour_i);
-        ncm_vector_set (snia_cov->cov_packed, NC_DATA_SNIA_COV_ORDER_LENGTH * ij + NC_DATA_SNIA_COV_ORDER_WIDTH_WIDTH,   width_width_i);
-        ncm_vector_set (snia_cov->cov_packed, NC_DATA_SNIA_COV_ORDER_LENGTH * ij + NC_DATA_SNIA_COV_ORDER_WIDTH_COLOUR,  width_colour_i);
-        ncm_vector_set (snia_cov->cov_packed, NC_DATA_SNIA_COV_ORDER_LENGTH * ij + NC_DATA_SNIA_COV_ORDER_COLOUR_COLOUR, colour_colour_i);
+        for (k = 0; k < NC_DATA_SNIA_COV_ORDER_LENGTH; k++)
+        {
+          const guint r = _nc_data_snia_cov_comp_block[k][0] * mu_len;
+          const guint c = _nc_data_snia_cov_comp_block[k][1] * mu_len;
+          const gdouble comp_ij = 0.5 * (ncm_matrix_get (snia_cov->cov_full, r + i, c + j) + 
+                                         ncm_matrix_get (snia_cov->cov_full, r + j, c + i));
 
+          ncm_vector_set (cov_packed, NC_DATA_SNIA_COV_ORDER_LENGTH * ij + k, comp_ij);
+        }
         ij++;
       }
     }
+
+    g_object_set_data_full (G_OBJECT (snia_cov->cov_full), _NC_DATA_SNIA_COV_PACKED_KEY, 
+                            cov_packed, (GDestroyNotify) &ncm_vector_free);
   }
-  
-  _nc_data_snia_cov_save_cov_lowertri (snia_cov);
 
-  if (snia_cov->has_complete_cov)
+  ncm_vector_substitute (&snia_cov->cov_packed, cov_packed, TRUE);
+  G_UNLOCK (cov_full_qdata);
+}
+
+static void
+_nc_data_snia_cov_update_inv_cov_mm (NcDataSNIACov *snia_cov)
+{
+  const guint mu_len = snia_cov->mu_len;
+  NcmMatrix *inv_cov_mm;
+  guint i, j;
+
+  G_LOCK (cov_full_qdata);
+  inv_cov_mm = g_object_get_data (G_OBJECT (snia_cov->cov_full), _NC_DATA_SNIA_COV_INV_COV_MM_KEY);
+
+  if (inv_cov_mm == NULL)
   {
+    NcmMatrix *inv_cov_full = ncm_matrix_dup (snia_cov->cov_full);
     gint ret;
-    ret = ncm_matrix_cholesky_decomp (snia_cov->cov_full, 'U');
+
+    ret = ncm_matrix_cholesky_decomp (inv_cov_full, 'U');
     if (ret != 0)
       g_error ("nc_data_snia_cov_set_cov_full[ncm_matrix_cholesky_decomp]: %d.", ret);
-    ret = ncm_matrix_cholesky_inverse (snia_cov->cov_full, 'U');
+    ret = ncm_matrix_cholesky_inverse (inv_cov_full, 'U');
     if (ret != 0)
       g_error ("nc_data_snia_cov_set_cov_full[ncm_matrix_cholesky_inverse]: %d.", ret);
 
-    ncm_matrix_set_zero (snia_cov->inv_cov_mm);
+    inv_cov_mm = ncm_matrix_new (mu_len, mu_len);
+    ncm_matrix_set_zero (inv_cov_mm);
     for (i = 0; i < mu_len; i++)
     {
       for (j = i; j < mu_len; j++)
       {
-        const gdouble inv_cov_full_ij = ncm_matrix_get (snia_cov->cov_full, i, j);
-        ncm_matrix_set (snia_cov->inv_cov_mm, i, j, inv_cov_full_ij);
+        const gdouble inv_cov_full_ij = ncm_matrix_get (inv_cov_full, i, j);
+        ncm_matrix_set (inv_cov_mm, i, j, inv_cov_full_ij);
       }
     }
+
+    ncm_matrix_free (inv_cov_full);
+
+    g_object_set_data_full (G_OBJECT (snia_cov->cov_full), _NC_DATA_SNIA_COV_INV_COV_MM_KEY, 
+                            inv_cov_mm, (GDestroyNotify) &ncm_matrix_free);
   }
+
+  ncm_matrix_substitute (&snia_cov->inv_cov_mm, inv_cov_mm, TRUE);
+  G_UNLOCK (cov_full_qdata);
+}
+
+static void
+_nc_data_snia_cov_prepare_cov_full (NcDataSNIACov *snia_cov)
+{
+  /* Any decomposition in cov_full_LLT refers to the old matrix. */
+  snia_cov->cov_full_state = NC_DATA_SNIA_COV_PREP_TO_NOTHING;
+
+  _nc_data_snia_cov_update_cov_packed (snia_cov);
+
+  if (snia_cov->has_complete_cov)
+    _nc_data_snia_cov_update_inv_cov_mm (snia_cov);
+
   _nc_data_snia_cov_set_data_init (snia_cov, NC_DATA_SNIA_COV_INIT_COV_FULL);
 }
 
+/*
+ * Used by the property setter: @cov_full comes from
+ * nc_data_snia_cov_peek_cov_full(), it is already symmetric and it is
+ * taken by reference, so that shared instances stay shared between copies.
+ */
+static void
+_nc_data_snia_cov_set_cov_full_ref (NcDataSNIACov *snia_cov, NcmMatrix *cov_full)
+{
+  const guint tmu_len = 3 * snia_cov->mu_len;
+
+  g_assert_cmpuint (ncm_matrix_nrows (cov_full), ==, tmu_len);
+  g_assert_cmpuint (ncm_matrix_ncols (cov_full), ==, tmu_len);
+
+  ncm_matrix_substitute (&snia_cov->cov_full, cov_full, FALSE);
+  _nc_data_snia_cov_prepare_cov_full (snia_cov);
+}
+
+/**
+ * nc_data_snia_cov_set_cov_full:
+ * @snia_cov: a #NcDataSNIACov
+ * @cov_full: the full convariance #NcmMatrix
+ * 
+ * Sets the full covariance for the system, the size of @cov_full,
+ * must match the system size. The object keeps a copy of @cov_full,
+ * only its upper triangle is used.
+ * 
+ */
+void 
+nc_data_snia_cov_set_cov_full (NcDataSNIACov *snia_cov, NcmMatrix *cov_full)
+{
+  const guint tmu_len = 3 * snia_cov->mu_len;
+  
+  if (snia_cov->cov_full != cov_full)
+  {
+    NcmMatrix *cov_full_cp;
+
+    g_assert_cmpuint (ncm_matrix_nrows (cov_full), ==, tmu_len);
+    g_assert_cmpuint (ncm_matrix_ncols (cov_full), ==, tmu_len);
+
+    /* A new instance, copies of this object may still reference the old one. */
+    cov_full_cp = ncm_matrix_dup (cov_full);
+    ncm_matrix_substitute (&snia_cov->cov_full, cov_full_cp, FALSE);
+    ncm_matrix_free (cov_full_cp);
+  }
+  else
+  {
+    /* Filled in place by the loaders, the attached data is stale. */
+    g_object_set_data (G_OBJECT (snia_cov->cov_full), _NC_DATA_SNIA_COV_PACKED_KEY, NULL);
+    g_object_set_data (G_OBJECT (snia_cov->cov_full), _NC_DATA_SNIA_COV_INV_COV_MM_KEY, NULL);
+  }
+
+  _nc_data_snia_cov_symmetrize_cov_full (snia_cov);
+  _nc_data_snia_cov_prepare_cov_full (snia_cov);
+}
+
 
 /**
  * nc_data_snia_cov_load_txt:
@@ -1105,7 +1290,6 @@ nc_data_snia_cov_load_txt (NcDataSNIACov *snia_cov, const gchar *filename)
 
   /* Setting everything to zero */
   ncm_matrix_set_zero (snia_cov->cov_full);
-  ncm_vector_set_zero (snia_cov->cov_packed);
   
   if (!g_key_file_has_key (snia_keyfile, 
                            NC_DATA_SNIA_COV_DATA_GROUP,
@@ -1667,8 +1851,6 @@ nc_data_snia_cov_load (NcDataSNIACov *snia_cov, const gchar *filename)
 
   /* Setting everything to zero */
   ncm_matrix_set_zero (snia_cov->cov_full);
-  ncm_vector_set_zero (snia_cov->cov_full_diag);
-  ncm_vector_set_zero (snia_cov->cov_packed);
   
   if (cat_version == 0)
   {
@@ -1901,9 +2083,6 @@ nc_data_snia_cov_save (NcDataSNIACov *snia_cov, const gchar *filename, gboolean
     NcmMatrix *data[NC_DATA_SNIA_COV_V1_TOTAL_LENGTH];
     gint i;
 
-    /* Restoring covariance matrix from Cholesky decomposition. */
-    _nc_data_snia_cov_restore_full_cov (snia_cov);
-
     data[NC_DATA_SNIA_COV_V1_MAG_MAG]       = ncm_matrix_get_submatrix (snia_cov->cov_full, 0 * mu_len, 0 * mu_len, mu_len, mu_len);
     data[NC_DATA_SNIA_COV_V1_MAG_WIDTH]     = ncm_matrix_get_submatrix (snia_cov->cov_full, 0 * mu_len, 1 * mu_len, mu_len, mu_len);
     data[NC_DATA_SNIA_COV_V1_MAG_COLOUR]    = ncm_matrix_get_submatrix (snia_cov->cov_full, 0 * mu_len, 2 * mu_len, mu_len, mu_len);
@@ -1936,47 +2115,22 @@ nc_data_snia_cov_save (NcDataSNIACov *snia_cov, const gchar *filename, gboolean
 
 #endif /* NUMCOSMO_HAVE_CFITSIO */
 
-static void
-_nc_data_snia_cov_restore_full_cov (NcDataSNIACov *snia_cov)
-{
-  const guint mu_len = snia_cov->mu_len;
-  const guint tmu_len = 3 * mu_len;
-  guint i, j;
-
-  for (i = 0; i < tmu_len; i++)
-  {
-    const gdouble diag = ncm_vector_get (snia_cov->cov_full_diag, i);
-    ncm_matrix_set (snia_cov->cov_full, i, i, diag);
-    for (j = i + 1; j < tmu_len; j++)
-    {
-      ncm_matrix_set (snia_cov->cov_full, i, j, ncm_matrix_get (snia_cov->cov_full, j, i));
-    }
-  }
-}
-
 static void
 _nc_data_snia_cov_prep_to_resample (NcDataSNIACov *snia_cov, NcSNIADistCov *dcov)
 {
   const guint mu_len = snia_cov->mu_len;
-  const guint tmu_len = 3 * snia_cov->mu_len;
-  guint i, j;
   gint ret;
 
   if (mu_len == 0 || !snia_cov->has_complete_cov)
     g_error ("_nc_data_snia_cov_prep_to_resample: cannot prepare to resample, empty catalog %d or it hasn't a complete covariance %d.\n",
              mu_len == 0, !snia_cov->has_complete_cov);
-  
-  for (i = 0; i < tmu_len; i++)
-  {
-    const gdouble diag = ncm_vector_get (snia_cov->cov_full_diag, i);
-    ncm_matrix_set (snia_cov->cov_full, i, i, diag);
-    for (j = i + 1; j < tmu_len; j++)
-    {
-      ncm_matrix_set (snia_cov->cov_full, i, j, ncm_matrix_get (snia_cov->cov_full, j, i));
-    }
-  }
 
-  ret = ncm_matrix_cholesky_decomp (snia_cov->cov_full, 'U');
+  if (snia_cov->cov_full_LLT == NULL)
+    snia_cov->cov_full_LLT = ncm_matrix_new (3 * mu_len, 3 * mu_len);
+
+  ncm_matrix_memcpy (snia_cov->cov_full_LLT, snia_cov->cov_full);
+
+  ret = ncm_matrix_cholesky_decomp (snia_cov->cov_full_LLT, 'U');
   if (ret != 0)
     g_error ("_nc_data_snia_cov_prep_to_resample[ncm_matrix_cholesky_decomp]: %d.", ret);
   
@@ -1987,39 +2141,23 @@ static void
 _nc_data_snia_cov_prep_to_estimate (NcDataSNIACov *snia_cov, NcSNIADistCov *dcov)
 {
   const guint mu_len = snia_cov->mu_len;
-  const guint tmu_len = 3 * snia_cov->mu_len;
-  guint i, j;
+  guint i;
   gint ret;
 
   if (mu_len == 0 || !snia_cov->has_complete_cov)
     g_error ("_nc_data_snia_cov_prep_to_estimate: cannot prepare to estimate, empty catalog %d or it hasn't a complete covariance %d.\n",
              mu_len == 0, !snia_cov->has_complete_cov);
 
-  for (i = 0; i < mu_len; i++)
-  {
-    const gdouble diag = ncm_vector_get (snia_cov->cov_full_diag, i) + 
-      nc_snia_dist_cov_extra_var (dcov, snia_cov, i);
-    ncm_matrix_set (snia_cov->cov_full, i, i, diag);
+  if (snia_cov->cov_full_LLT == NULL)
+    snia_cov->cov_full_LLT = ncm_matrix_new (3 * mu_len, 3 * mu_len);
 
-    for (j = i + 1; j < tmu_len; j++)
-    {
-      ncm_matrix_set (snia_cov->cov_full, i, j, ncm_matrix_get (snia_cov->cov_full, j, i));
-    }
-  }
+  ncm_matrix_memcpy (snia_cov->cov_full_LLT, snia_cov->cov_full);
 
-  /* Continue for the last 2 * mu_len. */
-  for (i = mu_len; i < tmu_len; i++)
-  {
-    const gdouble diag = ncm_vector_get (snia_cov->cov_full_diag, i);
-    ncm_matrix_set (snia_cov->cov_full, i, i, diag);
-    for (j = i + 1; j < tmu_len; j++)
-    {
-      ncm_matrix_set (snia_cov->cov_full, i, j, ncm_matrix_get (snia_cov->cov_full, j, i));
-    }
-  }
+  for (i = 0; i < mu_len; i++)
+    ncm_matrix_addto (snia_cov->cov_full_LLT, i, i, nc_snia_dist_cov_extra_var (dcov, snia_cov, i));
 
-  /* Make the Cholesky decomposition substituting the upper triagle of cov_full. */
-  ret = ncm_matrix_cholesky_decomp (snia_cov->cov_full, 'U');
+  /* Make the Cholesky decomposition substituting the upper triagle of cov_full_LLT. */
+  ret = ncm_matrix_cholesky_decomp (snia_cov->cov_full_LLT, 'U');
   if (ret != 0)
     g_error ("_nc_data_snia_cov_prep_to_estimate[ncm_matrix_cholesky_decomp]: %d.", ret);
     
@@ -2027,34 +2165,14 @@ _nc_data_snia_cov_prep_to_estimate (NcDataSNIACov *snia_cov, NcSNIADistCov *dcov
 }
 
 static void
-_nc_data_snia_cov_save_cov_lowertri (NcDataSNIACov *snia_cov)
+_nc_data_snia_cov_symmetrize_cov_full (NcDataSNIACov *snia_cov)
 {
-  const guint mu_len = snia_cov->mu_len;
   const guint tmu_len = 3 * snia_cov->mu_len;
   guint i, j;
 
-  if (snia_cov->cov_full_state != NC_DATA_SNIA_COV_PREP_TO_NOTHING)
-    g_error ("_nc_data_snia_cov_save_cov_lowertri: cannot save since Cholesky decomposition was already done.");
-
-  for (i = 0; i < mu_len; i++)
-  {
-    /* Save the original diagonal terms. */
-    ncm_vector_set (snia_cov->cov_full_diag, i, ncm_matrix_get (snia_cov->cov_full, i, i));
-
-    /* Save the original triangular superior terms in the lower triangle. */
-    for (j = i + 1; j < tmu_len; j++)
-    {
-      ncm_matrix_set (snia_cov->cov_full, j, i, ncm_matrix_get (snia_cov->cov_full, i, j));
-    }
-  }
-
-  /* Continue for the last 2 * mu_len. */
-  for (i = mu_len; i < tmu_len; i++)
+  /* Copy the upper triangle to the lower one. */
+  for (i = 0; i < tmu_len; i++)
   {
-    /* Save the original diagonal terms. */
-    ncm_vector_set (snia_cov->cov_full_diag, i, ncm_matrix_get (snia_cov->cov_full, i, i));
-
-    /* Save the original triangular superior terms in the lower triangle. */
     for (j = i + 1; j < tmu_len; j++)
     {
       ncm_matrix_set (snia_cov->cov_full, j, i, ncm_matrix_get (snia_cov->cov_full, i, j));
@@ -2094,7 +2212,7 @@ _nc_data_snia_cov_resample (NcmData *data, NcmMSet *mset, NcmRNG *rng)
     }
 
     ret = gsl_blas_dtrmv (CblasUpper, CblasTrans, CblasNonUnit, 
-                          ncm_matrix_gsl (snia_cov->cov_full), ncm_vector_gsl (snia_cov->mag_width_colour));
+                          ncm_matrix_gsl (snia_cov->cov_full_LLT), ncm_vector_gsl (snia_cov->mag_width_colour));
     NCM_TEST_GSL_RESULT ("_nc_data_snia_cov_resample", ret);
 
     for (i = 0; i < snia_cov->mu_len; i++)
@@ -2174,7 +2292,7 @@ nc_data_snia_cov_estimate_width_colour (NcDataSNIACov *snia_cov, NcmMSet *mset)
       {
         for (j = i; j < nobs; j++)
         {
-          ncm_matrix_set_colmajor (L, j, i, ncm_matrix_get (snia_cov->cov_full, i, j));
+          ncm_matrix_set_colmajor (L, j, i, ncm_matrix_get (snia_cov->cov_full_LLT, i, j));
         }
       }
       info = ncm_lapack_dggglm_run (ws, L, X, params, obs, y);
@@ -2190,10 +2308,10 @@ nc_data_snia_cov_estimate_width_colour (NcDataSNIACov *snia_cov, NcmMSet *mset)
       gint ret;
       nc_snia_dist_cov_mag_to_width_colour (dcov, cosmo, snia_cov, obs, X, FALSE);
       ret = gsl_blas_dtrsv (CblasUpper, CblasTrans, CblasNonUnit, 
-                            ncm_matrix_gsl (snia_cov->cov_full), ncm_vector_gsl (obs));
+                            ncm_matrix_gsl (snia_cov->cov_full_LLT), ncm_vector_gsl (obs));
       NCM_TEST_GSL_RESULT ("nc_data_snia_estimate_width_colour", ret);
 
-      ret = gsl_blas_dtrsm (CblasLeft, CblasUpper, CblasTrans, CblasNonUnit, 1.0, ncm_matrix_gsl (snia_cov->cov_full), ncm_matrix_gsl (X));
+      ret = gsl_blas_dtrsm (CblasLeft, CblasUpper, CblasTrans, CblasNonUnit, 1.0, ncm_matrix_gsl (snia_cov->cov_full_LLT), ncm_matrix_gsl (X));
       NCM_TEST_GSL_RESULT ("nc_data_snia_estimate_width_colour", ret);
 
       ret = gsl_multifit_linear (ncm_matrix_gsl (X), 
@@ -228,7 +228,7 @@ struct _NcDataSNIACov
   NcmVector *sigma_thirdpar;
   NcmVector *cov_packed;
   NcmMatrix *cov_full;
-  NcmVector *cov_full_diag;
+  NcmMatrix *cov_full_LLT;
   NcmMatrix *inv_cov_mm;
   NcmMatrix *inv_cov_mm_LU;
   gboolean has_complete_cov;
@@ -241,6 +241,7 @@ struct _NcDataSNIACov
   NcmModelCtrl *cosmo_resample_ctrl;
   NcmModelCtrl *dcov_resample_ctrl;
   NcmModelCtrl *dcov_cov_full_ctrl;
+  NcmModelCtrl *dcov_cov_ctrl;
 };
 
 GType nc_data_snia_cov_get_type (void) G_GNUC_CONST;
@@ -270,6 +271,8 @@ void nc_data_snia_cov_set_thirdpar (NcDataSNIACov *snia_cov, NcmVector *thirdpar
 void nc_data_snia_cov_set_abs_mag_set (NcDataSNIACov *snia_cov, GArray *abs_mag_set);
 void nc_data_snia_cov_set_cov_full (NcDataSNIACov *snia_cov, NcmMatrix *cov_full);
 
+void nc_data_snia_cov_set_abs_mag_lin (NcDataSNIACov *snia_cov, gboolean enable);
+
 void nc_data_snia_cov_load_txt (NcDataSNIACov *snia_cov, const gchar *filename);
 #ifdef NUMCOSMO_HAVE_CFITSIO
 void nc_data_snia_cov_load (NcDataSNIACov *snia_cov, const gchar *filename);
@@ -55,6 +55,7 @@ nc_galaxy_acf_new (NcGrowthFunc *gf, NcDistance *dist, NcTransferFunc *tf)
   acf->tf = tf;
   acf->b = 2.0;
   acf->s = ncm_spline_cubic_notaknot_new ();
+  acf->jl_tab = NULL;
   {
 	NcWindow *wp = nc_window_tophat_new ();
 	nc_window_free (wp);
@@ -62,6 +63,27 @@ nc_galaxy_acf_new (NcGrowthFunc *gf, NcDistance *dist, NcTransferFunc *tf)
   return acf;
 }
 
+/**
+ * nc_galaxy_acf_set_sbessel_table:
+ * @acf: a #NcGalaxyAcf
+ * @jl_tab: (allow-none): a #NcmSFSBesselTable
+ *
+ * Sets the table of spherical Bessel functions used to compute the
+ * $\psi_\ell(k)$ kernels. When $\ell + 1$ and $x = k r(z)$ are inside
+ * @jl_tab the functions are interpolated from it, otherwise they are
+ * computed directly. The table can be shared among several objects, see
+ * ncm_sf_sbessel_table_cached_new().
+ *
+ */
+void
+nc_galaxy_acf_set_sbessel_table (NcGalaxyAcf *acf, NcmSFSBesselTable *jl_tab)
+{
+  if (jl_tab != NULL)
+    ncm_sf_sbessel_table_ref (jl_tab);
+  ncm_sf_sbessel_table_clear (&acf->jl_tab);
+  acf->jl_tab = jl_tab;
+}
+
 typedef struct _NcmGalaxyAcfPsiKernel
 {
   gdouble h;
@@ -107,9 +129,23 @@ nc_galaxy_acf_psi_kernel (gdouble z, gpointer p)
   const gdouble x = apk->k * cd;
   const gdouble x2 = x * x;
   const gdouble sel_func = 1.0;
-  const gdouble jl = gsl_sf_bessel_jl (apk->l, x);//ncm_sf_sbessel (apk->l, x);//
-  const gdouble jlp1 = gsl_sf_bessel_jl (apk->l + 1, x); //ncm_sf_sbessel (apk->l + 1, x);//
+  gdouble jl, jlp1;
   gdouble Dz, fz;
+
+  if ((apk->acf->jl_tab != NULL) &&
+      (apk->l >= ncm_sf_sbessel_table_get_lmin (apk->acf->jl_tab)) &&
+      (apk->l + 1 <= ncm_sf_sbessel_table_get_lmax (apk->acf->jl_tab)) &&
+      (x >= ncm_sf_sbessel_table_get_xi (apk->acf->jl_tab)) &&
+      (x <= ncm_sf_sbessel_table_get_xf (apk->acf->jl_tab)))
+  {
+    jl   = ncm_sf_sbessel_table_eval_jl (apk->acf->jl_tab, apk->l, x);
+    jlp1 = ncm_sf_sbessel_table_eval_jl (apk->acf->jl_tab, apk->l + 1, x);
+  }
+  else
+  {
+    jl   = gsl_sf_bessel_jl (apk->l, x);
+    jlp1 = gsl_sf_bessel_jl (apk->l + 1, x);
+  }
   nc_growth_func_eval_both (apk->acf->gf, apk->cosmo, z, &Dz, &fz);
 
   fz *= -(1 + z) / Dz;
@@ -205,12 +241,15 @@ nc_galaxy_acf_prepare_psi (NcGalaxyAcf *acf, NcHICosmo *cosmo, guint l)
 static void
 nc_galaxy_acf_init (NcGalaxyAcf *nc_galaxy_acf)
 {
-  NCM_UNUSED (nc_galaxy_acf);
+  nc_galaxy_acf->jl_tab = NULL;
 }
 
 static void
 nc_galaxy_acf_finalize (GObject *object)
 {
+  NcGalaxyAcf *acf = NC_GALAXY_ACF (object);
+
+  ncm_sf_sbessel_table_clear (&acf->jl_tab);
 
   /* Chain up : end */
   G_OBJECT_CLASS (nc_galaxy_acf_parent_class)->finalize (object);
@@ -32,6 +32,7 @@
 #include <numcosmo/lss/nc_growth_func.h>
 #include <numcosmo/lss/nc_transfer_func.h>
 #include <numcosmo/nc_distance.h>
+#include <numcosmo/math/ncm_sf_sbessel_table.h>
 
 G_BEGIN_DECLS
 
@@ -59,12 +60,14 @@ struct _NcGalaxyAcf
   NcDistance *dist;
   NcTransferFunc *tf;
   NcmSpline *s;
+  NcmSFSBesselTable *jl_tab;
   gdouble b;
 };
 
 GType nc_galaxy_acf_get_type (void) G_GNUC_CONST;
 
 NcGalaxyAcf *nc_galaxy_acf_new (NcGrowthFunc *gf, NcDistance *dist, NcTransferFunc *tf);
+void nc_galaxy_acf_set_sbessel_table (NcGalaxyAcf *acf, NcmSFSBesselTable *jl_tab);
 gdouble nc_galaxy_acf_psi (NcGalaxyAcf *acf, NcHICosmo *cosmo, gdouble k, guint l);
 void nc_galaxy_acf_prepare_psi (NcGalaxyAcf *acf, NcHICosmo *cosmo, guint l);
 
@@ -28,8 +28,26 @@
  * @title: NcmABC
  * @short_description: Abstract class for Approximate Bayesian Computation (ABC).
  *
- * FIXME
- * 
+ * Population Monte Carlo (sequential Monte Carlo) implementation of ABC.
+ * The particles of the first population are drawn from the prior, the
+ * following populations are obtained by moving the particles of the
+ * previous one with the transition kernel and reweighting them, see
+ * ncm_abc_start_update() and ncm_abc_update().
+ *
+ * Each population is generated in three stages. First, the accepted
+ * particles are obtained in parallel, each thread using its own copy of the
+ * model set, of the data set and its own #NcmRNG, the thread counters are
+ * reduced at the end of the stage. Second, when the transition kernel is a
+ * #NcmMSetTransKernGauss, the importance weights are computed in parallel,
+ * using the previous population whitened by the kernel's Cholesky
+ * decomposition. Finally, the particles are added to the catalog in order,
+ * which is synchronized with its file at the end of each population, so
+ * an interrupted run can be resumed from the last complete population.
+ *
+ * The tolerance schedule is controlled by the implementation through
+ * ncm_abc_update_tkern(), ncm_abc_get_adaptive_epsilon() provides an
+ * adaptive schedule based on the effective sample size.
+ *
  */
 
 #ifdef HAVE_CONFIG_H
@@ -39,8 +57,12 @@
 
 #include "math/ncm_abc.h"
 #include "math/ncm_func_eval.h"
+#include "math/ncm_mset_trans_kern_gauss.h"
+#include "math/ncm_c.h"
 
 #include <gsl/gsl_statistics_double.h>
+#include <gsl/gsl_sort.h>
+#include <gsl/gsl_blas.h>
 
 enum
 {
@@ -74,6 +96,8 @@ ncm_abc_init (NcmABC *abc)
   abc->weights       = g_array_new (FALSE, FALSE, sizeof (gdouble));
   abc->weights_tm1   = g_array_new (FALSE, FALSE, sizeof (gdouble));
   abc->dists         = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  abc->pgen          = g_ptr_array_new_with_free_func ((GDestroyNotify) &ncm_vector_free);
+  abc->ztheta_tm1    = NULL;
   abc->dists_sorted  = FALSE;
   abc->epsilon       = 0.0;
   abc->depsilon      = 0.0;
@@ -194,7 +218,9 @@ _ncm_abc_dispose (GObject *object)
   g_clear_pointer (&abc->weights, g_array_unref);
   g_clear_pointer (&abc->weights_tm1, g_array_unref);
   g_clear_pointer (&abc->dists, g_array_unref);
+  g_clear_pointer (&abc->pgen, g_ptr_array_unref);
   g_clear_pointer (&abc->wran, gsl_ran_discrete_free);
+  ncm_matrix_clear (&abc->ztheta_tm1);
 
   if (abc->mp != NULL)
   {
@@ -430,7 +456,8 @@ ncm_abc_set_data_file (NcmABC *abc, const gchar *filename)
  * @abc: a #NcmABC
  * @nthreads: number of threads
  *
- * FIXME
+ * Sets the number of threads, when larger than one the particles and their
+ * weights are computed concurrently.
  *
  */
 void 
@@ -588,17 +615,98 @@ ncm_abc_get_depsilon (NcmABC *abc)
   return abc->depsilon;
 }
 
-void
-_ncm_abc_update (NcmABC *abc, NcmMSet *mset, gdouble dist, gdouble weight)
+/**
+ * ncm_abc_get_ess:
+ * @abc: a #NcmABC
+ * 
+ * Computes the effective sample size of the current population,
+ * $\mathrm{ESS} = (\sum_i w_i)^2 / \sum_i w_i^2$.
+ * 
+ * Returns: the effective sample size.
+ */
+gdouble 
+ncm_abc_get_ess (NcmABC *abc)
+{
+  gdouble sw = 0.0, sw2 = 0.0;
+  guint i;
+
+  if (abc->weights->len < 1)
+    g_error ("ncm_abc_get_ess: no particles calculated.");
+
+  for (i = 0; i < abc->weights->len; i++)
+  {
+    const gdouble w_i = g_array_index (abc->weights, gdouble, i);
+    sw  += w_i;
+    sw2 += w_i * w_i;
+  }
+
+  return sw * sw / sw2;
+}
+
+/**
+ * ncm_abc_get_adaptive_epsilon:
+ * @abc: a #NcmABC
+ * @alpha: fraction of the effective sample size to keep $\alpha \in (0, 1)$
+ * 
+ * Computes the next tolerance of an adaptive schedule. The particles of
+ * the current population are sorted by distance and the returned value is
+ * the smallest tolerance $\epsilon$ such that the effective sample size of
+ * the particles with distance smaller than $\epsilon$ is at least @alpha 
+ * times the effective sample size of the whole population (see 
+ * ncm_abc_get_ess()). The result is never larger than the current 
+ * tolerance.
+ * 
+ * Returns: the next tolerance.
+ */
+gdouble 
+ncm_abc_get_adaptive_epsilon (NcmABC *abc, gdouble alpha)
+{
+  const guint np = abc->dists->len;
+  const gdouble ess_target = alpha * ncm_abc_get_ess (abc);
+  gsize *perm = g_new (gsize, np);
+  gdouble sw = 0.0, sw2 = 0.0;
+  gdouble epsilon = abc->epsilon;
+  guint i;
+
+  g_assert_cmpfloat (alpha, >, 0.0);
+  g_assert_cmpfloat (alpha, <, 1.0);
+  g_assert_cmpuint (abc->weights->len, ==, np);
+
+  gsl_sort_index (perm, (gdouble *) abc->dists->data, 1, np);
+
+  for (i = 0; i < np; i++)
+  {
+    const gdouble w_i = g_array_index (abc->weights, gdouble, perm[i]);
+    sw  += w_i;
+    sw2 += w_i * w_i;
+
+    if (sw * sw / sw2 >= ess_target)
+    {
+      /* The particles are accepted when dist < epsilon, the tolerance is placed between the last one kept and the next. */
+      const gdouble d_i = g_array_index (abc->dists, gdouble, perm[i]);
+      const gdouble d_n = (i + 1 < np) ? g_array_index (abc->dists, gdouble, perm[i + 1]) : d_i;
+      
+      epsilon = GSL_MIN (epsilon, (d_n > d_i) ? 0.5 * (d_i + d_n) : nextafter (d_i, GSL_POSINF));
+      break;
+    }
+  }
+
+  g_free (perm);
+
+  return epsilon;
+}
+
+static void
+_ncm_abc_update (NcmABC *abc, NcmVector *row)
 {
   const guint part = 5;
   const guint step = (abc->n / part) == 0 ? 1 : (abc->n / part);
   const guint pindex = abc->cur_sample_id % abc->nparticles;
 
-  ncm_mset_catalog_add_from_mset (abc->mcat, mset, dist, weight, NULL);
+  ncm_mset_catalog_add_from_vector (abc->mcat, row);
   ncm_timer_task_increment (abc->nt);
-  g_array_index (abc->weights, gdouble, pindex) = weight;
-  g_array_index (abc->dists,   gdouble, pindex) = dist;
+  g_array_index (abc->weights, gdouble, pindex) = ncm_vector_get (row, 1);
+  g_array_index (abc->dists,   gdouble, pindex) = ncm_vector_get (row, 0);
   abc->dists_sorted = FALSE;
   
   switch (abc->mtype)
@@ -819,112 +927,15 @@ ncm_abc_intern_skip (NcmABC *abc, guint n)
   abc->cur_sample_id += n;
 }
 
-static void _ncm_abc_run_single (NcmABC *abc);
-static void _ncm_abc_run_mt (NcmABC *abc);
-
-/**
- * ncm_abc_run:
- * @abc: a #NcmABC
- * @nparticles: total number of particles to generate
- * 
- * Generates particlea until @n particles are accepted.
- *
- */
-void 
-ncm_abc_run (NcmABC *abc, guint nparticles)
-{
-  if (!abc->started)
-    g_error ("ncm_abc_run: run not started, run ncm_abc_start_run() first.");
-  
-  if (nparticles <= (abc->cur_sample_id + 1))
-  {
-    if (abc->mtype > NCM_FIT_RUN_MSGS_NONE)
-    {
-      ncm_cfg_msg_sepa ();
-      g_message ("# NcmABC: Nothing to do, current ABC particle number is already %d of %u\n", abc->cur_sample_id + 1, nparticles);
-    }
-    return;
-  }
-  
-  abc->n = nparticles - (abc->cur_sample_id + 1);
-
-  if (abc->n > 0 && abc->nupdates > 0)
-    g_error ("ncm_abc_run: cannot generate new particles when time t = %u != 0.", abc->nupdates);
-  
-  abc->nparticles = nparticles;
-  g_array_set_size (abc->weights, nparticles);
-  g_array_set_size (abc->dists, nparticles);
-  
-  switch (abc->mtype)
-  {
-    default:
-    case NCM_FIT_RUN_MSGS_FULL:
-    case NCM_FIT_RUN_MSGS_SIMPLE:
-    {
-      ncm_cfg_msg_sepa ();
-      g_message ("# NcmABC: Calculating [%06d] ABC particles [%s]\n", abc->n, ncm_abc_get_desc (abc));
-    }
-    case NCM_FIT_RUN_MSGS_NONE:
-      break;
-  }
-  
-  if (ncm_timer_task_is_running (abc->nt))
-  {
-    ncm_timer_task_add_tasks (abc->nt, abc->n);
-    ncm_timer_task_continue (abc->nt);
-  }
-  else
-  {
-    ncm_timer_task_start (abc->nt, abc->n);
-    ncm_timer_set_name (abc->nt, "NcmABC");
-  }
-  if (abc->mtype > NCM_FIT_RUN_MSGS_NONE)
-    ncm_timer_task_log_start_datetime (abc->nt);
-
-  if (abc->nthreads <= 1)
-    _ncm_abc_run_single (abc);
-  else
-    _ncm_abc_run_mt (abc);
-
-  ncm_timer_task_pause (abc->nt);
-  
-  g_assert_cmpuint (abc->nparticles, ==, abc->cur_sample_id + 1);
-}
-
-static void 
-_ncm_abc_run_single (NcmABC *abc)
-{
-  guint i = 0;
-  
-  for (i = 0; i < abc->n;)
-  {
-    gdouble dist = 0.0, prob = 0.0;
-    ncm_mset_trans_kern_prior_sample (abc->prior, abc->thetastar, abc->mcat->rng);
-
-    ncm_mset_fparams_set_vector (abc->mcat->mset, abc->thetastar);
-    ncm_dataset_resample (abc->dset_mock, abc->mcat->mset, abc->mcat->rng);
-    
-    dist = ncm_abc_mock_distance (abc, abc->dset_mock, abc->theta, abc->thetastar, abc->mcat->rng);
-    prob = ncm_abc_distance_prob (abc, dist);
-
-    abc->ntotal++;
-    
-    if (prob == 1.0 || (prob != 0.0 && gsl_rng_uniform (abc->mcat->rng->r) < prob))
-    {
-      abc->cur_sample_id++;
-      abc->naccepted++;
-      _ncm_abc_update (abc, abc->mcat->mset, dist, 1.0);
-      i++;
-    }
-  }
-}
-
 typedef struct _NcmABCThread
 {
   NcmMSet *mset;
   NcmDataset *dset;
   NcmVector *thetastar;
+  NcmVector *z;
   NcmRNG *rng;
+  guint ntotal;
+  guint naccepted;
 } NcmABCThread;
 
 static gpointer
@@ -936,12 +947,16 @@ _ncm_abc_dup_thread (gpointer userdata)
 
   G_LOCK (dup_thread);
   {
+    /* The resample only touches the mutable part of the data, the rest is shared. */
+    ncm_dataset_share_payload (abc->dset, abc->ser);
+
     abct->mset      = ncm_mset_dup (abc->mcat->mset, abc->ser);
     abct->dset      = ncm_dataset_dup (abc->dset, abc->ser);
     abct->thetastar = ncm_vector_dup (abc->thetastar);
-    abct->rng       = ncm_rng_new (NULL);
-
-    ncm_rng_set_seed (abct->rng, gsl_rng_get (abc->mcat->rng->r));
+    abct->z         = ncm_vector_dup (abc->thetastar);
+    abct->rng       = ncm_rng_new (NCM_RNG_STREAM_ALGO);
+    abct->ntotal    = 0;
+    abct->naccepted = 0;
 
     ncm_serialize_clear_instances (abc->ser);
 
@@ -958,6 +973,7 @@ _ncm_abc_free_thread (gpointer data)
   ncm_mset_clear (&abct->mset);
   ncm_dataset_clear (&abct->dset);
   ncm_vector_clear (&abct->thetastar);
+  ncm_vector_clear (&abct->z);
   ncm_rng_clear (&abct->rng);
   g_free (abct);
 }
@@ -965,59 +981,344 @@ _ncm_abc_free_thread (gpointer data)
 static void 
 _ncm_abc_thread_eval (glong i, glong f, gpointer data)
 {
-  G_LOCK_DEFINE_STATIC (update_lock);
-  NcmABC *abc = NCM_ABC (data);
+  NcmABC *abc             = NCM_ABC (data);
   NcmABCThread **abct_ptr = ncm_memory_pool_get (abc->mp);
-  NcmABCThread *abct = *abct_ptr;
-  guint j;
-  for (j = i; j < f;)
+  NcmABCThread *abct      = *abct_ptr;
+  const guint fparam_len  = ncm_vector_len (abct->thetastar);
+  glong j;
+
+  for (j = i; j < f; j++)
   {
-    gdouble dist, prob;
+    NcmVector *row_j = g_ptr_array_index (abc->pgen, j);
 
-    ncm_mset_trans_kern_prior_sample (abc->prior, abct->thetastar, abct->rng);
+    /* 
+     * Each particle of the chunk uses its own stream of the catalog RNG, 
+     * so the population does not depend on the thread scheduling.
+     */
+    ncm_rng_stream_set (abct->rng, abc->mcat->rng, j);
 
-    ncm_mset_fparams_set_vector (abct->mset, abct->thetastar);
+    while (TRUE)
+    {
+      NcmVector *theta = NULL;
+      gdouble dist, prob;
+
+      if (abc->started_up)
+      {
+        /* The previous population is only read while the particles are generated. */
+        const gsize np = gsl_ran_discrete (abct->rng->r, abc->wran);
+        NcmVector *row = ncm_mset_catalog_peek_row (abc->mcat, abc->nparticles * abc->nupdates + np);
+
+        theta = ncm_vector_get_subvector (row, 2, fparam_len);
+        ncm_mset_trans_kern_generate (abc->tkern, theta, abct->thetastar, abct->rng);
+      }
+      else
+        ncm_mset_trans_kern_prior_sample (abc->prior, abct->thetastar, abct->rng);
 
-    ncm_dataset_resample (abct->dset, abct->mset, abct->rng);
-    dist = ncm_abc_mock_distance (abc, abct->dset, abct->thetastar, abct->thetastar, abct->rng);
-    prob = ncm_abc_distance_prob (abc, dist);
+      ncm_mset_fparams_set_vector (abct->mset, abct->thetastar);
+      ncm_dataset_resample (abct->dset, abct->mset, abct->rng);
 
-    G_LOCK (update_lock);
-    abc->ntotal++;
-    G_UNLOCK (update_lock);
-    if (prob == 1.0 || (prob != 0.0 && gsl_rng_uniform (abct->rng->r) < prob))
+      dist = ncm_abc_mock_distance (abc, abct->dset, (theta != NULL) ? theta : abct->thetastar, abct->thetastar, abct->rng);
+      prob = ncm_abc_distance_prob (abc, dist);
+
+      ncm_vector_clear (&theta);
+      abct->ntotal++;
+
+      if (prob == 1.0 || (prob != 0.0 && gsl_rng_uniform (abct->rng->r) < prob))
+      {
+        ncm_vector_set (row_j, 0, dist);
+        ncm_vector_set (row_j, 1, 1.0);
+        ncm_mset_fparams_get_vector_offset (abct->mset, row_j, 2);
+        abct->naccepted++;
+        break;
+      }
+    }
+  }
+
+  ncm_memory_pool_return (abct_ptr);
+}
+
+static void 
+_ncm_abc_thread_weights_eval (glong i, glong f, gpointer data)
+{
+  NcmABC *abc                   = NCM_ABC (data);
+  NcmMSetTransKernGauss *tkerng = NCM_MSET_TRANS_KERN_GAUSS (abc->tkern);
+  NcmABCThread **abct_ptr       = ncm_memory_pool_get (abc->mp);
+  NcmABCThread *abct            = *abct_ptr;
+  const guint fparam_len        = ncm_vector_len (abct->z);
+  const gdouble *w_tm1          = (const gdouble *) abc->weights_tm1->data;
+  gdouble lnnorm                = -0.5 * fparam_len * ncm_c_ln2pi ();
+  glong j;
+  guint n;
+
+  for (n = 0; n < fparam_len; n++)
+    lnnorm -= log (ncm_matrix_get (tkerng->LLT, n, n));
+
+  for (j = i; j < f; j++)
+  {
+    NcmVector *row_j = g_ptr_array_index (abc->pgen, j);
+    const gdouble *z_j = ncm_vector_ptr (abct->z, 0);
+    gdouble lnK_max = GSL_NEGINF;
+    gdouble sum = 0.0;
+    guint k;
+    gint ret;
+
+    for (n = 0; n < fparam_len; n++)
+      ncm_vector_set (abct->z, n, ncm_vector_get (row_j, n + 2));
+
+    ret = gsl_blas_dtrsv (CblasLower, CblasNoTrans, CblasNonUnit,
+                          ncm_matrix_gsl (tkerng->LLT), ncm_vector_gsl (abct->z));
+    NCM_TEST_GSL_RESULT ("_ncm_abc_thread_weights_eval", ret);
+
+    /* 
+     * The kernel is evaluated against the whitened previous population,
+     * the sum is accumulated relative to its largest term to avoid underflows.
+     */
+    for (k = 0; k < abc->nparticles; k++)
     {
-      G_LOCK (update_lock);
-      abc->cur_sample_id++;
-      abc->naccepted++;
-      _ncm_abc_update (abc, abct->mset, dist, 1.0);
-      j++;
-      G_UNLOCK (update_lock);
+      const gdouble *z_k = ncm_matrix_ptr (abc->ztheta_tm1, k, 0);
+      gdouble d2 = 0.0;
+      gdouble lnK_k;
+
+      for (n = 0; n < fparam_len; n++)
+      {
+        const gdouble dz = z_j[n] - z_k[n];
+        d2 += dz * dz;
+      }
+      lnK_k = -0.5 * d2;
+
+      if (lnK_k > lnK_max)
+      {
+        sum     = sum * exp (lnK_max - lnK_k) + w_tm1[k];
+        lnK_max = lnK_k;
+      }
+      else
+        sum += w_tm1[k] * exp (lnK_k - lnK_max);
     }
+
+    ncm_vector_set (row_j, 1, lnnorm + lnK_max + log (sum));
   }
 
   ncm_memory_pool_return (abct_ptr);
 }
 
+static gdouble
+_ncm_abc_kernel_sum (NcmABC *abc, NcmVector *theta_j)
+{
+  const guint fparam_len = ncm_vector_len (theta_j);
+  gdouble denom = 0.0;
+  guint k;
+
+  for (k = 0; k < abc->nparticles; k++)
+  {
+    NcmVector *row   = ncm_mset_catalog_peek_row (abc->mcat, abc->nparticles * abc->nupdates + k);
+    NcmVector *theta = ncm_vector_get_subvector (row, 2, fparam_len);
+
+    denom += g_array_index (abc->weights_tm1, gdouble, k) * ncm_mset_trans_kern_pdf (abc->tkern, theta, theta_j);
+    ncm_vector_free (theta);
+  }
+
+  return denom;
+}
+
 static void
-_ncm_abc_run_mt (NcmABC *abc)
+_ncm_abc_reduce_counters (NcmABC *abc)
 {
-  const guint nthreads = abc->n > abc->nthreads ? abc->nthreads : (abc->n - 1);
+  guint i;
 
-  if (nthreads == 0)
+  for (i = 0; i < abc->mp->slices->len; i++)
   {
-    _ncm_abc_run_single (abc);
-    return;
+    NcmMemoryPoolSlice *slice = g_ptr_array_index (abc->mp->slices, i);
+    NcmABCThread *abct        = slice->p;
+
+    abc->ntotal    += abct->ntotal;
+    abc->naccepted += abct->naccepted;
+    abct->ntotal    = 0;
+    abct->naccepted = 0;
   }
-  
+}
+
+static void
+_ncm_abc_generate (NcmABC *abc)
+{
+  const guint fparam_len      = ncm_mset_fparam_len (abc->mcat->mset);
+  const gboolean gauss_weight = abc->started_up && (abc->ztheta_tm1 != NULL);
+  const guint chunk           = (abc->n / 10 > 0) ? (abc->n / 10) : 1;
+  guint i;
+
   if (abc->mp != NULL)
     ncm_memory_pool_free (abc->mp, TRUE);
   abc->mp = ncm_memory_pool_new (&_ncm_abc_dup_thread, abc, 
                                  (GDestroyNotify) &_ncm_abc_free_thread);
+
+  while (abc->pgen->len < chunk)
+    g_ptr_array_add (abc->pgen, ncm_vector_new (fparam_len + 2));
+
+  for (i = 0; i < abc->n; i += chunk)
+  {
+    const guint len = GSL_MIN (chunk, abc->n - i);
+    guint j;
+
+    if (abc->nthreads > 1)
+      ncm_func_eval_threaded_loop_full (&_ncm_abc_thread_eval, 0, len, abc);
+    else
+      _ncm_abc_thread_eval (0, len, abc);
+
+    /* Moves the catalog RNG forward so the next chunk uses new streams. */
+    ncm_rng_lock (abc->mcat->rng);
+    gsl_rng_get (abc->mcat->rng->r);
+    ncm_rng_unlock (abc->mcat->rng);
+
+    if (gauss_weight)
+    {
+      if (abc->nthreads > 1)
+        ncm_func_eval_threaded_loop_full (&_ncm_abc_thread_weights_eval, 0, len, abc);
+      else
+        _ncm_abc_thread_weights_eval (0, len, abc);
+    }
+
+    _ncm_abc_reduce_counters (abc);
+
+    /* The catalog is only written here, with all threads finished and in a fixed order. */
+    for (j = 0; j < len; j++)
+    {
+      NcmVector *row_j = g_ptr_array_index (abc->pgen, j);
+
+      if (abc->started_up)
+      {
+        NcmVector *theta_j    = ncm_vector_get_subvector (row_j, 2, fparam_len);
+        const gdouble prior_j = ncm_mset_trans_kern_prior_pdf (abc->prior, theta_j);
+
+        if (gauss_weight)
+          ncm_vector_set (row_j, 1, prior_j * exp (- ncm_vector_get (row_j, 1)));
+        else
+          ncm_vector_set (row_j, 1, prior_j / _ncm_abc_kernel_sum (abc, theta_j));
+
+        ncm_vector_free (theta_j);
+      }
+
+      abc->cur_sample_id++;
+      _ncm_abc_update (abc, row_j);
+    }
+  }
+}
+
+static void
+_ncm_abc_restore_population (NcmABC *abc, guint nparticles)
+{
+  const guint len = abc->cur_sample_id + 1;
+  gdouble dist_max = 0.0;
+  guint t, i;
+
+  if (len % nparticles != 0)
+    g_error ("ncm_abc_run: the catalog contains %u particles, which is not a multiple of the number of particles %u.", 
+             len, nparticles);
+
+  t = len / nparticles - 1;
+
+  abc->nparticles = nparticles;
+  abc->nupdates   = t;
+  g_array_set_size (abc->weights, nparticles);
+  g_array_set_size (abc->dists, nparticles);
+
+  for (i = 0; i < nparticles; i++)
+  {
+    NcmVector *row = ncm_mset_catalog_peek_row (abc->mcat, nparticles * t + i);
+    g_assert (row != NULL);
+
+    g_array_index (abc->dists, gdouble, i)   = ncm_vector_get (row, 0);
+    g_array_index (abc->weights, gdouble, i) = ncm_vector_get (row, 1);
+    dist_max = GSL_MAX (dist_max, ncm_vector_get (row, 0));
+  }
+  abc->dists_sorted = FALSE;
+
+  /* The tolerance used in the last population is not stored, the largest accepted distance bounds it. */
+  if (t > 0)
+    abc->epsilon = GSL_MIN (abc->epsilon, nextafter (dist_max, GSL_POSINF));
+
+  if (abc->mtype > NCM_FIT_RUN_MSGS_NONE)
+    g_message ("# NcmABC: Resuming from population %u with %u particles.\n", t, nparticles);
+}
+
+/**
+ * ncm_abc_run:
+ * @abc: a #NcmABC
+ * @nparticles: total number of particles to generate
+ * 
+ * Generates particles until @nparticles particles are accepted.
+ *
+ */
+void 
+ncm_abc_run (NcmABC *abc, guint nparticles)
+{
+  if (!abc->started)
+    g_error ("ncm_abc_run: run not started, run ncm_abc_start_run() first.");
+  
+  if (nparticles <= (abc->cur_sample_id + 1))
+  {
+    if (abc->nparticles != nparticles)
+      _ncm_abc_restore_population (abc, nparticles);
+
+    if (abc->mtype > NCM_FIT_RUN_MSGS_NONE)
+    {
+      ncm_cfg_msg_sepa ();
+      g_message ("# NcmABC: Nothing to do, current ABC particle number is already %d of %u\n", abc->cur_sample_id + 1, nparticles);
+    }
+    return;
+  }
   
-  g_assert_cmpuint (abc->nthreads, >, 1);
+  abc->n = nparticles - (abc->cur_sample_id + 1);
+
+  if (abc->n > 0 && abc->nupdates > 0)
+    g_error ("ncm_abc_run: cannot generate new particles when time t = %u != 0.", abc->nupdates);
+  
+  abc->nparticles = nparticles;
+  g_array_set_size (abc->weights, nparticles);
+  g_array_set_size (abc->dists, nparticles);
 
-  ncm_func_eval_threaded_loop_full (&_ncm_abc_thread_eval, 0, abc->n, abc);
+  /* Particles already present in a resumed catalog. */
+  {
+    gint i;
+    for (i = 0; i <= abc->cur_sample_id; i++)
+    {
+      NcmVector *row = ncm_mset_catalog_peek_row (abc->mcat, i);
+      g_array_index (abc->dists, gdouble, i)   = ncm_vector_get (row, 0);
+      g_array_index (abc->weights, gdouble, i) = ncm_vector_get (row, 1);
+    }
+    abc->dists_sorted = FALSE;
+  }
+  
+  switch (abc->mtype)
+  {
+    default:
+    case NCM_FIT_RUN_MSGS_FULL:
+    case NCM_FIT_RUN_MSGS_SIMPLE:
+    {
+      ncm_cfg_msg_sepa ();
+      g_message ("# NcmABC: Calculating [%06d] ABC particles [%s]\n", abc->n, ncm_abc_get_desc (abc));
+    }
+    case NCM_FIT_RUN_MSGS_NONE:
+      break;
+  }
+  
+  if (ncm_timer_task_is_running (abc->nt))
+  {
+    ncm_timer_task_add_tasks (abc->nt, abc->n);
+    ncm_timer_task_continue (abc->nt);
+  }
+  else
+  {
+    ncm_timer_task_start (abc->nt, abc->n);
+    ncm_timer_set_name (abc->nt, "NcmABC");
+  }
+  if (abc->mtype > NCM_FIT_RUN_MSGS_NONE)
+    ncm_timer_task_log_start_datetime (abc->nt);
+
+  _ncm_abc_generate (abc);
+  ncm_mset_catalog_sync (abc->mcat, TRUE);
+
+  ncm_timer_task_pause (abc->nt);
+  
+  g_assert_cmpuint (abc->nparticles, ==, abc->cur_sample_id + 1);
 }
 
 /**
@@ -1171,6 +1472,34 @@ ncm_abc_start_update (NcmABC *abc)
   memcpy (abc->weights_tm1->data, abc->weights->data, sizeof (gdouble) * abc->nparticles);
   abc->wran = gsl_ran_discrete_preproc (abc->nparticles, (gdouble *)abc->weights->data);
 
+  ncm_matrix_clear (&abc->ztheta_tm1);
+  if (NCM_IS_MSET_TRANS_KERN_GAUSS (abc->tkern))
+  {
+    NcmMSetTransKernGauss *tkerng = NCM_MSET_TRANS_KERN_GAUSS (abc->tkern);
+    const guint fparam_len = ncm_mset_fparam_len (abc->mcat->mset);
+    guint k, n;
+
+    /* Previous population whitened by the kernel, used by _ncm_abc_thread_weights_eval(). */
+    abc->ztheta_tm1 = ncm_matrix_new (abc->nparticles, fparam_len);
+    for (k = 0; k < abc->nparticles; k++)
+    {
+      NcmVector *row = ncm_mset_catalog_peek_row (abc->mcat, abc->nparticles * abc->nupdates + k);
+      NcmVector *z_k = ncm_matrix_get_row (abc->ztheta_tm1, k);
+      gint ret;
+
+      for (n = 0; n < fparam_len; n++)
+        ncm_vector_set (z_k, n, ncm_vector_get (row, n + 2));
+
+      ret = gsl_blas_dtrsv (CblasLower, CblasNoTrans, CblasNonUnit,
+                            ncm_matrix_gsl (tkerng->LLT), ncm_vector_gsl (z_k));
+      NCM_TEST_GSL_RESULT ("ncm_abc_start_update", ret);
+      ncm_vector_free (z_k);
+    }
+  }
+
+  /* Only complete populations are written to the file, see ncm_abc_update(). */
+  ncm_mset_catalog_set_sync_mode (abc->mcat, NCM_MSET_CATALOG_SYNC_DISABLE);
+
   ncm_mset_catalog_reset_stats (abc->mcat);
   
   if (!ncm_abc_data_summary (abc))
@@ -1205,6 +1534,7 @@ ncm_abc_end_update (NcmABC *abc)
     ncm_timer_task_end (abc->nt);
 
   g_clear_pointer (&abc->wran, gsl_ran_discrete_free);
+  ncm_matrix_clear (&abc->ztheta_tm1);
 
   for (i = 0; i < abc->nparticles; i++)
     WT += g_array_index (abc->weights, gdouble, i);
@@ -1232,15 +1562,13 @@ ncm_abc_end_update (NcmABC *abc)
   abc->started_up = FALSE;
 }
 
-static void _ncm_abc_update_single (NcmABC *abc);
-static void _ncm_abc_update_mt (NcmABC *abc);
-
 /**
  * ncm_abc_update:
  * @abc: a #NcmABC
  * 
- * Runs the Monte Carlo until it reaches the @n-th realization. Note that
- * if the first_id is non-zero it will run @n - first_id realizations.
+ * Generates a new population of particles from the current one, using
+ * the transition kernel and the current tolerance. The catalog is 
+ * synchronized with its file at the end of the population.
  *
  */
 void 
@@ -1249,6 +1577,8 @@ ncm_abc_update (NcmABC *abc)
   if (!abc->started_up)
     g_error ("ncm_abc_update: run not started, run ncm_abc_start_update() first.");
 
+  abc->n = abc->nparticles;
+
   switch (abc->mtype)
   {
     default:
@@ -1274,142 +1604,9 @@ ncm_abc_update (NcmABC *abc)
   if (abc->mtype > NCM_FIT_RUN_MSGS_NONE)
     ncm_timer_task_log_start_datetime (abc->nt);
 
-  if (abc->nthreads <= 1)
-    _ncm_abc_update_single (abc);
-  else
-    _ncm_abc_update_mt (abc);
+  _ncm_abc_generate (abc);
 
   abc->nupdates++;
+  ncm_mset_catalog_sync (abc->mcat, TRUE);
   ncm_timer_task_pause (abc->nt);
 }
-
-static void 
-_ncm_abc_update_single (NcmABC *abc)
-{
-  guint i = 0;
-  
-  for (i = 0; i < abc->n;)
-  {
-    gdouble dist = 0.0, prob = 0.0;
-    gsize np = gsl_ran_discrete (abc->mcat->rng->r, abc->wran);
-
-    NcmVector *row = ncm_mset_catalog_peek_row (abc->mcat, abc->nparticles * abc->nupdates + np);
-    NcmVector *theta = ncm_vector_get_subvector (row, 2, ncm_vector_len (row) - 2);
-    
-    ncm_mset_trans_kern_generate (abc->tkern, theta, abc->thetastar, abc->mcat->rng);
-    ncm_mset_fparams_set_vector (abc->mcat->mset, abc->thetastar);
-    ncm_dataset_resample (abc->dset_mock, abc->mcat->mset, abc->mcat->rng);
-    
-    dist = ncm_abc_mock_distance (abc, abc->dset_mock, abc->theta, abc->thetastar, abc->mcat->rng);
-    prob = ncm_abc_distance_prob (abc, dist);
-    ncm_vector_free (theta);
-
-    abc->ntotal++;
-    
-    if (prob == 1.0 || (prob != 0.0 && gsl_rng_uniform (abc->mcat->rng->r) < prob))
-    {
-      gdouble new_weight = ncm_mset_trans_kern_prior_pdf (abc->prior, abc->thetastar);
-      gdouble denom = 0.0;
-      guint j;
-      for (j = 0; j < abc->nparticles; j++)
-      {        
-        row    = ncm_mset_catalog_peek_row (abc->mcat, abc->nparticles * abc->nupdates + j);
-        theta  = ncm_vector_get_subvector (row, 2, ncm_vector_len (row) - 2);
-        denom += g_array_index (abc->weights_tm1, gdouble, j) * ncm_mset_trans_kern_pdf (abc->tkern, theta, abc->thetastar);
-        ncm_vector_free (theta);
-      }
-      new_weight = new_weight / denom; 
-
-      abc->naccepted++;
-      abc->cur_sample_id++;
-      _ncm_abc_update (abc, abc->mcat->mset, dist, new_weight);
-      i++;
-    }
-  }
-}
-
-static void 
-_ncm_abc_thread_update_eval (glong i, glong f, gpointer data)
-{
-  G_LOCK_DEFINE_STATIC (update_lock);
-  NcmABC *abc = NCM_ABC (data);
-  NcmABCThread **abct_ptr = ncm_memory_pool_get (abc->mp);
-  NcmABCThread *abct = *abct_ptr;
-  guint j;
-
-  for (j = i; j < f;)
-  {
-    gdouble dist = 0.0, prob = 0.0;
-    gsize np = gsl_ran_discrete (abct->rng->r, abc->wran);
-
-    NcmVector *row = ncm_mset_catalog_peek_row (abc->mcat, abc->nparticles * abc->nupdates + np);
-    NcmVector *theta = ncm_vector_get_subvector (row, 2, ncm_vector_len (row) - 2);
-
-    ncm_mset_trans_kern_generate (abc->tkern, theta, abct->thetastar, abct->rng);
-
-    ncm_mset_fparams_set_vector (abct->mset, abct->thetastar);
-    ncm_dataset_resample (abct->dset, abct->mset, abct->rng);
-
-    dist = ncm_abc_mock_distance (abc, abct->dset, theta, abct->thetastar, abct->rng);
-    prob = ncm_abc_distance_prob (abc, dist);
-/*
-    G_LOCK (update_lock);
-    printf ("# choice %zu\n", np);
-    ncm_vector_log_vals (theta,           "# v_choice = ", "% 20.15g");
-    ncm_vector_log_vals (abct->thetastar, "# v_tkern  = ", "% 20.15g");
-    printf ("# dist % 20.15g prob % 20.15g\n", dist, prob);
-    G_UNLOCK (update_lock);
-*/
-    ncm_vector_free (theta);
-    
-    G_LOCK (update_lock);
-    abc->ntotal++;
-    G_UNLOCK (update_lock);
-    
-    if (prob == 1.0 || (prob != 0.0 && gsl_rng_uniform (abct->rng->r) < prob))
-    {
-      gdouble new_weight = ncm_mset_trans_kern_prior_pdf (abc->prior, abct->thetastar);
-      gdouble denom = 0.0;
-      guint k;
-      for (k = 0; k < abc->nparticles; k++)
-      {
-        row    = ncm_mset_catalog_peek_row (abc->mcat, abc->nparticles * abc->nupdates + k);
-        theta  = ncm_vector_get_subvector (row, 2, ncm_vector_len (row) - 2);
-        denom += g_array_index (abc->weights_tm1, gdouble, k) * ncm_mset_trans_kern_pdf (abc->tkern, theta, abct->thetastar);
-        ncm_vector_free (theta);
-      }
-      new_weight = new_weight / denom; 
-
-      G_LOCK (update_lock);
-      abc->cur_sample_id++;
-      abc->naccepted++;
-      _ncm_abc_update (abc, abct->mset, dist, new_weight);
-      j++;
-      G_UNLOCK (update_lock);
-    }
-  }
-
-  ncm_memory_pool_return (abct_ptr);
-}
-
-static void
-_ncm_abc_update_mt (NcmABC *abc)
-{
-  const guint nthreads = abc->n > abc->nthreads ? abc->nthreads : (abc->n - 1);
-
-  if (nthreads == 0)
-  {
-    _ncm_abc_update_single (abc);
-    return;
-  }
-  
-  if (abc->mp != NULL)
-    ncm_memory_pool_free (abc->mp, TRUE);
-  abc->mp = ncm_memory_pool_new (&_ncm_abc_dup_thread, abc, 
-                                 (GDestroyNotify) &_ncm_abc_free_thread);
-  
-  g_assert_cmpuint (abc->nthreads, >, 1);
-
-  ncm_func_eval_threaded_loop_full (&_ncm_abc_thread_update_eval, 0, abc->n, abc);
-}
-
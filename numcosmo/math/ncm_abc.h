@@ -79,6 +79,8 @@ struct _NcmABC
   GArray *weights_tm1;
   GArray *pchoice;
   GArray *dists;
+  GPtrArray *pgen;
+  NcmMatrix *ztheta_tm1;
   gdouble epsilon;
   gdouble depsilon;
   gboolean dists_sorted;
@@ -117,6 +119,8 @@ gdouble ncm_abc_get_accept_ratio (NcmABC *abc);
 void ncm_abc_update_epsilon (NcmABC *abc, gdouble epsilon);
 gdouble ncm_abc_get_epsilon (NcmABC *abc);
 gdouble ncm_abc_get_depsilon (NcmABC *abc);
+gdouble ncm_abc_get_ess (NcmABC *abc);
+gdouble ncm_abc_get_adaptive_epsilon (NcmABC *abc, gdouble alpha);
 
 void ncm_abc_start_run (NcmABC *abc);
 void ncm_abc_end_run (NcmABC *abc);
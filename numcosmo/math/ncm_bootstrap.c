@@ -366,6 +366,28 @@ ncm_bootstrap_get_bsize (NcmBootstrap *bstrap)
   return bstrap->bsize;
 }
 
+/**
+ * ncm_bootstrap_get_weights:
+ * @bstrap: a #NcmBootstrap.
+ * @w: a #NcmVector of length #NcmBootstrap:full-size.
+ * 
+ * Sets @w[$k$] to the number of times the index $k$ appears in the 
+ * current resample, such that a sum over the resampled indexes
+ * $\sum_i f_{k_i}$ equals $\sum_k w_k f_k$.
+ * 
+ */
+void 
+ncm_bootstrap_get_weights (NcmBootstrap *bstrap, NcmVector *w)
+{
+  guint i;
+
+  g_assert_cmpuint (ncm_vector_len (w), ==, bstrap->fsize);
+
+  ncm_vector_set_zero (w);
+  for (i = 0; i < bstrap->bsize; i++)
+    ncm_vector_addto (w, ncm_bootstrap_get (bstrap, i), 1.0);
+}
+
 /**
  * ncm_bootstrap_resample:
  * @bstrap: a #NcmBootstrap.
@@ -31,6 +31,7 @@
 #include <glib-object.h>
 #include <numcosmo/build_cfg.h>
 #include <numcosmo/math/ncm_rng.h>
+#include <numcosmo/math/ncm_vector.h>
 #include <gsl/gsl_randist.h>
 
 G_BEGIN_DECLS
@@ -75,6 +76,7 @@ void ncm_bootstrap_set_fsize (NcmBootstrap *bstrap, guint fsize);
 guint ncm_bootstrap_get_fsize (NcmBootstrap *bstrap);
 void ncm_bootstrap_set_bsize (NcmBootstrap *bstrap, guint bsize);
 guint ncm_bootstrap_get_bsize (NcmBootstrap *bstrap);
+void ncm_bootstrap_get_weights (NcmBootstrap *bstrap, NcmVector *w);
 
 G_INLINE_FUNC void ncm_bootstrap_resample (NcmBootstrap *bstrap, NcmRNG *rng);
 G_INLINE_FUNC void ncm_bootstrap_remix (NcmBootstrap *bstrap, NcmRNG *rng);
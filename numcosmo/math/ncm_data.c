@@ -59,6 +59,24 @@ enum
 
 G_DEFINE_ABSTRACT_TYPE (NcmData, ncm_data, G_TYPE_OBJECT);
 
+/*
+ * The versions are drawn from a single counter, a new version is larger
+ * than every version already given to any #NcmData.
+ */
+static guint64
+_ncm_data_version_next (void)
+{
+  G_LOCK_DEFINE_STATIC (last_version);
+  static guint64 last_version = 0;
+  guint64 version;
+
+  G_LOCK (last_version);
+  version = ++last_version;
+  G_UNLOCK (last_version);
+
+  return version;
+}
+
 static void
 ncm_data_init (NcmData *data)
 {
@@ -66,6 +84,7 @@ ncm_data_init (NcmData *data)
   data->long_desc = NULL;
   data->init      = FALSE;
   data->begin     = FALSE;
+  data->version   = _ncm_data_version_next ();
 }
 
 static void
@@ -234,6 +253,7 @@ ncm_data_class_init (NcmDataClass *klass)
   data_class->m2lnL_val          = NULL;
   data_class->m2lnL_grad         = NULL;
   data_class->m2lnL_val_grad     = NULL;
+  data_class->share_payload      = NULL;
 }
 
 /**
@@ -291,6 +311,28 @@ ncm_data_dup (NcmData *data, NcmSerialize *ser_obj)
   return NCM_DATA (ncm_serialize_dup_obj (ser_obj, G_OBJECT (data)));
 }
 
+/**
+ * ncm_data_share_payload: (virtual share_payload)
+ * @data: a #NcmData.
+ * @ser: a #NcmSerialize.
+ *
+ * Registers the immutable parts of @data (e.g. a constant covariance
+ * matrix) as shared instances in @ser. After this call, the duplicates
+ * of @data created through @ser using ncm_data_dup() hold references
+ * to these objects instead of copies. The mutable state (mean vector,
+ * decompositions, etc.) is still copied.
+ *
+ * It does nothing if the #NcmData implementation does not provide
+ * any shareable object.
+ * 
+ */
+void
+ncm_data_share_payload (NcmData *data, NcmSerialize *ser)
+{
+  if (NCM_DATA_GET_CLASS (data)->share_payload != NULL)
+    NCM_DATA_GET_CLASS (data)->share_payload (data, ser);
+}
+
 /**
  * ncm_data_new_from_file:
  * @filename: file containing a serialized #NcmData child.
@@ -348,12 +390,16 @@ ncm_data_get_dof (NcmData *data)
  * @data: a #NcmData
  * @state: a boolean
  *
- * Sets the @data to initialized or not @state. 
+ * Sets the @data to initialized or not @state. The implementations
+ * call this function after their data are changed, therefore it also
+ * marks @data as changed, see ncm_data_mark_changed().
  * 
  */
 void
 ncm_data_set_init (NcmData *data, gboolean state)
 {
+  ncm_data_mark_changed (data);
+
   if (data->init)
   {
     if (!state)
@@ -372,6 +418,39 @@ ncm_data_set_init (NcmData *data, gboolean state)
   }
 }
 
+/**
+ * ncm_data_mark_changed:
+ * @data: a #NcmData
+ *
+ * Gives a new version to @data. It must be called whenever the value
+ * of $-2\ln(L)$ computed by @data at a fixed #NcmMSet changes, e.g.,
+ * after the data are resampled or replaced. It is called by
+ * ncm_data_set_init(), ncm_data_resample() and the bootstrap functions.
+ *
+ */
+void
+ncm_data_mark_changed (NcmData *data)
+{
+  data->version = _ncm_data_version_next ();
+}
+
+/**
+ * ncm_data_get_version:
+ * @data: a #NcmData
+ *
+ * Gets the version of @data, see ncm_data_mark_changed(). The versions
+ * are unique among all #NcmData objects and increase monotonically,
+ * so results cached for a given version (e.g., by #NcmFit) remain valid
+ * while the version of @data is unchanged.
+ *
+ * Returns: the version of @data.
+ */
+guint64
+ncm_data_get_version (NcmData *data)
+{
+  return data->version;
+}
+
 /**
  * ncm_data_set_desc:
  * @data: a #NcmData.
@@ -514,6 +593,8 @@ ncm_data_bootstrap_create (NcmData *data)
     ncm_bootstrap_set_fsize (data->bstrap, ncm_data_get_length (data));
     ncm_bootstrap_set_bsize (data->bstrap, ncm_data_get_length (data));
   }
+
+  ncm_data_mark_changed (data);
 }
 
 /**
@@ -526,7 +607,11 @@ ncm_data_bootstrap_create (NcmData *data)
 void
 ncm_data_bootstrap_remove (NcmData *data)
 {
-  ncm_bootstrap_clear (&data->bstrap);
+  if (data->bstrap != NULL)
+  {
+    ncm_bootstrap_clear (&data->bstrap);
+    ncm_data_mark_changed (data);
+  }
 }
 
 /**
@@ -550,6 +635,8 @@ ncm_data_bootstrap_set (NcmData *data, NcmBootstrap *bstrap)
   ncm_bootstrap_ref (bstrap);
   ncm_bootstrap_clear (&data->bstrap);
   data->bstrap = bstrap;
+
+  ncm_data_mark_changed (data);
 }
 
 /**
@@ -571,6 +658,7 @@ ncm_data_bootstrap_resample (NcmData *data, NcmRNG *rng)
              ncm_data_get_desc (data));
 
   ncm_bootstrap_resample (data->bstrap, rng);
+  ncm_data_mark_changed (data);
 }
 
 /**
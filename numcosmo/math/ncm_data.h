@@ -67,6 +67,8 @@ typedef struct _NcmData NcmData;
  * @m2lnL_grad: evaluate the gradient of $-2\ln(L)$ with respect to the free
  * parameters in @mset.
  * @m2lnL_val_grad: evaluate the value and the gradient of $-2\ln(L)$.
+ * @share_payload: register the immutable objects of #NcmData as shared
+ * instances in a #NcmSerialize, see ncm_serialize_share().
  * 
  * Virtual table for the #NcmData abstract class.
  * 
@@ -89,6 +91,7 @@ struct _NcmDataClass
   void (*m2lnL_val) (NcmData *data, NcmMSet *mset, gdouble *m2lnL);
   void (*m2lnL_grad) (NcmData *data, NcmMSet *mset, NcmVector *grad);
   void (*m2lnL_val_grad) (NcmData *data, NcmMSet *mset, gdouble *m2lnL, NcmVector *grad);
+  void (*share_payload) (NcmData *data, NcmSerialize *ser);
 };
 
 struct _NcmData
@@ -100,6 +103,7 @@ struct _NcmData
   gboolean init;
   gboolean begin;
   NcmBootstrap *bstrap;
+  guint64 version;
 };
 
 GType ncm_data_get_type (void) G_GNUC_CONST;
@@ -109,11 +113,14 @@ void ncm_data_free (NcmData *data);
 void ncm_data_clear (NcmData **data);
 
 NcmData *ncm_data_dup (NcmData *data, NcmSerialize *ser_obj);
+void ncm_data_share_payload (NcmData *data, NcmSerialize *ser);
 NcmData *ncm_data_new_from_file (const gchar *filename);
 
 guint ncm_data_get_length (NcmData *data);
 guint ncm_data_get_dof (NcmData *data);
 void ncm_data_set_init (NcmData *data, gboolean state);
+void ncm_data_mark_changed (NcmData *data);
+guint64 ncm_data_get_version (NcmData *data);
 
 void ncm_data_set_desc (NcmData *data, const gchar *desc);
 void ncm_data_take_desc (NcmData *data, gchar *desc);
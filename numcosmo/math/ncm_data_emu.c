@@ -0,0 +1,1477 @@
+/***************************************************************************
+ *            ncm_data_emu.c
+ *
+ *  Tue October 20 09:14:27 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_data_emu.c
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:ncm_data_emu
+ * @title: NcmDataEmu
+ * @short_description: Gaussian process emulator for expensive likelihoods.
+ *
+ * This object wraps a #NcmData and replaces its $-2\ln(L)$ by a Gaussian
+ * process (GP) surrogate defined on the free parameter box of a #NcmMSet.
+ * It can be used in place of the original data in any #NcmDataset, for
+ * example, in the chains of #NcmFitESMCMC.
+ *
+ * The GP uses a constant mean and a squared exponential covariance with
+ * one length scale per free parameter, computed in the coordinates
+ * $u_i = (\theta_i - \theta_i^\mathrm{lb}) / (\theta_i^\mathrm{ub} - \theta_i^\mathrm{lb})$.
+ * The mean and the amplitude are profiled and the length scales are chosen
+ * by maximizing the marginal likelihood of the training set.
+ *
+ * The training set is built by ncm_data_emu_train(), which evaluates
+ * the original likelihood in a Latin hypercube design (in parallel when
+ * #NcmDataEmu:nthreads is larger than one), and refined by
+ * ncm_data_emu_refine(), which adds the candidates that maximize the
+ * product of the predicted likelihood and the GP uncertainty.
+ *
+ * When the standard deviation of the GP prediction is larger than
+ * #NcmDataEmu:err-tol, ncm_data_m2lnL_val() falls back to the original
+ * likelihood. The evaluation never changes the training set or the GP,
+ * so the same emulator can be evaluated concurrently. Points are added
+ * only by the training functions, ncm_data_emu_train_at() adds the
+ * current point of a #NcmMSet, for example, after a fallback detected
+ * through ncm_data_emu_predict(). Each new point extends the Cholesky
+ * decomposition of the GP covariance in $O(n^2)$ operations, the whole
+ * decomposition is recomputed only when the length scales are fitted
+ * again, every time the training set grows by 25%. Every change of the
+ * GP gives the emulator a new version (see ncm_data_get_version()), so
+ * the values cached by #NcmFit are not reused after training.
+ *
+ * Resampling the emulated data keeps the training set, use
+ * ncm_data_emu_reset() to discard it when the new realization changes
+ * the likelihood.
+ *
+ * The training set and the GP hyperparameters are properties of the
+ * object, so a trained emulator can be saved and loaded with
+ * #NcmSerialize.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif /* HAVE_CONFIG_H */
+#include "build_cfg.h"
+
+#include "math/ncm_data_emu.h"
+#include "math/ncm_cfg.h"
+#include "math/ncm_util.h"
+#include "math/ncm_serialize.h"
+#include "math/ncm_func_eval.h"
+#include "math/memory_pool.h"
+#include "math/ncm_workspace.h"
+#include "math/ncm_lapack.h"
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_randist.h>
+
+enum
+{
+  PROP_0,
+  PROP_DATA,
+  PROP_ERR_TOL,
+  PROP_MAX_TRAIN,
+  PROP_NTHREADS,
+  PROP_LB,
+  PROP_UB,
+  PROP_LSCALE,
+  PROP_TRAIN_X,
+  PROP_TRAIN_Y,
+  PROP_SIZE,
+};
+
+G_DEFINE_TYPE (NcmDataEmu, ncm_data_emu, NCM_TYPE_DATA);
+
+static void
+ncm_data_emu_init (NcmDataEmu *emu)
+{
+  emu->data      = NULL;
+  emu->tx        = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  emu->ty        = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  emu->lb        = NULL;
+  emu->ub        = NULL;
+  emu->lscale    = NULL;
+  emu->LLT       = NULL;
+  emu->alpha     = NULL;
+  emu->w1        = NULL;
+  emu->wy        = NULL;
+  emu->mu        = 0.0;
+  emu->sigma2    = 0.0;
+  emu->lndet     = 0.0;
+  emu->nugget    = NCM_DATA_EMU_NUGGET;
+  emu->err_tol   = 0.0;
+  emu->dim       = 0;
+  emu->max_train = 0;
+  emu->nthreads  = 0;
+  emu->nhyper    = 0;
+  emu->nfactor   = 0;
+  emu->nemu      = 0;
+  emu->ntrue     = 0;
+  emu->gp_ready  = FALSE;
+}
+
+static void _ncm_data_emu_set_dim (NcmDataEmu *emu, guint dim);
+static void _ncm_data_emu_refactor (NcmDataEmu *emu);
+
+static void
+_ncm_data_emu_set_train_x (NcmDataEmu *emu, NcmMatrix *tx)
+{
+  guint i;
+
+  g_array_set_size (emu->tx, 0);
+  emu->gp_ready = FALSE;
+  emu->nhyper   = 0;
+
+  if (tx == NULL)
+    return;
+
+  _ncm_data_emu_set_dim (emu, ncm_matrix_ncols (tx));
+  for (i = 0; i < ncm_matrix_nrows (tx); i++)
+    g_array_append_vals (emu->tx, ncm_matrix_ptr (tx, i, 0), emu->dim);
+
+  _ncm_data_emu_refactor (emu);
+}
+
+static void
+_ncm_data_emu_set_train_y (NcmDataEmu *emu, NcmVector *ty)
+{
+  guint i;
+
+  g_array_set_size (emu->ty, 0);
+  emu->gp_ready = FALSE;
+  emu->nhyper   = 0;
+
+  if (ty == NULL)
+    return;
+
+  for (i = 0; i < ncm_vector_len (ty); i++)
+  {
+    const gdouble y_i = ncm_vector_get (ty, i);
+    g_array_append_val (emu->ty, y_i);
+  }
+
+  _ncm_data_emu_refactor (emu);
+}
+
+static void
+_ncm_data_emu_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+  NcmDataEmu *emu = NCM_DATA_EMU (object);
+  g_return_if_fail (NCM_IS_DATA_EMU (object));
+
+  switch (prop_id)
+  {
+    case PROP_DATA:
+      emu->data = g_value_dup_object (value);
+      break;
+    case PROP_ERR_TOL:
+      ncm_data_emu_set_err_tol (emu, g_value_get_double (value));
+      break;
+    case PROP_MAX_TRAIN:
+      ncm_data_emu_set_max_train (emu, g_value_get_uint (value));
+      break;
+    case PROP_NTHREADS:
+      ncm_data_emu_set_nthreads (emu, g_value_get_uint (value));
+      break;
+    case PROP_LB:
+    {
+      NcmVector *lb = g_value_get_object (value);
+      if (lb != NULL)
+      {
+        _ncm_data_emu_set_dim (emu, ncm_vector_len (lb));
+        ncm_vector_memcpy (emu->lb, lb);
+      }
+      break;
+    }
+    case PROP_UB:
+    {
+      NcmVector *ub = g_value_get_object (value);
+      if (ub != NULL)
+      {
+        _ncm_data_emu_set_dim (emu, ncm_vector_len (ub));
+        ncm_vector_memcpy (emu->ub, ub);
+      }
+      break;
+    }
+    case PROP_LSCALE:
+    {
+      NcmVector *lscale = g_value_get_object (value);
+      if (lscale != NULL)
+      {
+        _ncm_data_emu_set_dim (emu, ncm_vector_len (lscale));
+        ncm_vector_memcpy (emu->lscale, lscale);
+        _ncm_data_emu_refactor (emu);
+      }
+      break;
+    }
+    case PROP_TRAIN_X:
+      _ncm_data_emu_set_train_x (emu, g_value_get_object (value));
+      break;
+    case PROP_TRAIN_Y:
+      _ncm_data_emu_set_train_y (emu, g_value_get_object (value));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+_ncm_data_emu_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+  NcmDataEmu *emu = NCM_DATA_EMU (object);
+  g_return_if_fail (NCM_IS_DATA_EMU (object));
+
+  switch (prop_id)
+  {
+    case PROP_DATA:
+      g_value_set_object (value, emu->data);
+      break;
+    case PROP_ERR_TOL:
+      g_value_set_double (value, emu->err_tol);
+      break;
+    case PROP_MAX_TRAIN:
+      g_value_set_uint (value, emu->max_train);
+      break;
+    case PROP_NTHREADS:
+      g_value_set_uint (value, emu->nthreads);
+      break;
+    case PROP_LB:
+      g_value_set_object (value, emu->lb);
+      break;
+    case PROP_UB:
+      g_value_set_object (value, emu->ub);
+      break;
+    case PROP_LSCALE:
+      g_value_set_object (value, emu->lscale);
+      break;
+    case PROP_TRAIN_X:
+    {
+      const guint n = emu->ty->len;
+      if (n == 0)
+        g_value_set_object (value, NULL);
+      else
+      {
+        NcmMatrix *tx = ncm_matrix_new (n, emu->dim);
+        memcpy (ncm_matrix_data (tx), emu->tx->data, sizeof (gdouble) * n * emu->dim);
+        g_value_take_object (value, tx);
+      }
+      break;
+    }
+    case PROP_TRAIN_Y:
+    {
+      const guint n = emu->ty->len;
+      if (n == 0)
+        g_value_set_object (value, NULL);
+      else
+      {
+        NcmVector *ty = ncm_vector_new (n);
+        memcpy (ncm_vector_data (ty), emu->ty->data, sizeof (gdouble) * n);
+        g_value_take_object (value, ty);
+      }
+      break;
+    }
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+_ncm_data_emu_constructed (GObject *object)
+{
+  /* Chain up : start */
+  G_OBJECT_CLASS (ncm_data_emu_parent_class)->constructed (object);
+  {
+    NcmDataEmu *emu = NCM_DATA_EMU (object);
+
+    g_assert (emu->data != NULL);
+
+    if (emu->ty->len * emu->dim != emu->tx->len)
+      g_error ("_ncm_data_emu_constructed: inconsistent training set, %u points and %u coordinates in dimension %u.",
+               emu->ty->len, emu->tx->len, emu->dim);
+
+    ncm_data_set_init (NCM_DATA (emu), emu->data->init);
+  }
+}
+
+static void
+_ncm_data_emu_dispose (GObject *object)
+{
+  NcmDataEmu *emu = NCM_DATA_EMU (object);
+
+  ncm_data_clear (&emu->data);
+
+  ncm_vector_clear (&emu->lb);
+  ncm_vector_clear (&emu->ub);
+  ncm_vector_clear (&emu->lscale);
+  ncm_vector_clear (&emu->alpha);
+  ncm_vector_clear (&emu->w1);
+  ncm_vector_clear (&emu->wy);
+
+  ncm_matrix_clear (&emu->LLT);
+
+  /* Chain up : end */
+  G_OBJECT_CLASS (ncm_data_emu_parent_class)->dispose (object);
+}
+
+static void
+_ncm_data_emu_finalize (GObject *object)
+{
+  NcmDataEmu *emu = NCM_DATA_EMU (object);
+
+  g_array_unref (emu->tx);
+  g_array_unref (emu->ty);
+
+  /* Chain up : end */
+  G_OBJECT_CLASS (ncm_data_emu_parent_class)->finalize (object);
+}
+
+static guint _ncm_data_emu_get_length (NcmData *data);
+static guint _ncm_data_emu_get_dof (NcmData *data);
+static void _ncm_data_emu_resample (NcmData *data, NcmMSet *mset, NcmRNG *rng);
+static void _ncm_data_emu_m2lnL_val (NcmData *data, NcmMSet *mset, gdouble *m2lnL);
+
+static void
+ncm_data_emu_class_init (NcmDataEmuClass *klass)
+{
+  GObjectClass* object_class = G_OBJECT_CLASS (klass);
+  NcmDataClass *data_class   = NCM_DATA_CLASS (klass);
+
+  object_class->set_property = &_ncm_data_emu_set_property;
+  object_class->get_property = &_ncm_data_emu_get_property;
+  object_class->constructed  = &_ncm_data_emu_constructed;
+  object_class->dispose      = &_ncm_data_emu_dispose;
+  object_class->finalize     = &_ncm_data_emu_finalize;
+
+  g_object_class_install_property (object_class,
+                                   PROP_DATA,
+                                   g_param_spec_object ("data",
+                                                        NULL,
+                                                        "Emulated data",
+                                                        NCM_TYPE_DATA,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_ERR_TOL,
+                                   g_param_spec_double ("err-tol",
+                                                        NULL,
+                                                        "Maximum emulator standard deviation of -2lnL",
+                                                        0.0, G_MAXDOUBLE, 0.1,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_MAX_TRAIN,
+                                   g_param_spec_uint ("max-train",
+                                                      NULL,
+                                                      "Maximum size of the training set",
+                                                      1, G_MAXUINT, 2000,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_NTHREADS,
+                                   g_param_spec_uint ("nthreads",
+                                                      NULL,
+                                                      "Number of threads to run",
+                                                      0, 100, 0,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_LB,
+                                   g_param_spec_object ("lower-bounds",
+                                                        NULL,
+                                                        "Lower bounds of the emulator box",
+                                                        NCM_TYPE_VECTOR,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_UB,
+                                   g_param_spec_object ("upper-bounds",
+                                                        NULL,
+                                                        "Upper bounds of the emulator box",
+                                                        NCM_TYPE_VECTOR,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_LSCALE,
+                                   g_param_spec_object ("length-scales",
+                                                        NULL,
+                                                        "Covariance length scales",
+                                                        NCM_TYPE_VECTOR,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_TRAIN_X,
+                                   g_param_spec_object ("train-x",
+                                                        NULL,
+                                                        "Training points in box coordinates",
+                                                        NCM_TYPE_MATRIX,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_TRAIN_Y,
+                                   g_param_spec_object ("train-y",
+                                                        NULL,
+                                                        "Training values of -2lnL",
+                                                        NCM_TYPE_VECTOR,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+
+  data_class->name       = "Emulated data";
+  data_class->bootstrap  = FALSE;
+  data_class->get_length = &_ncm_data_emu_get_length;
+  data_class->get_dof    = &_ncm_data_emu_get_dof;
+  data_class->begin      = NULL;
+  data_class->prepare    = NULL;
+  data_class->resample   = &_ncm_data_emu_resample;
+  data_class->m2lnL_val  = &_ncm_data_emu_m2lnL_val;
+}
+
+static void
+_ncm_data_emu_set_dim (NcmDataEmu *emu, guint dim)
+{
+  if (emu->dim == dim)
+    return;
+
+  if (emu->dim != 0)
+    g_error ("_ncm_data_emu_set_dim: the emulator dimension is already set to %u, cannot change to %u.", emu->dim, dim);
+
+  emu->dim    = dim;
+  emu->lb     = ncm_vector_new (dim);
+  emu->ub     = ncm_vector_new (dim);
+  emu->lscale = ncm_vector_new (dim);
+
+  ncm_vector_set_zero (emu->lb);
+  ncm_vector_set_all (emu->ub, 1.0);
+  ncm_vector_set_all (emu->lscale, 0.2);
+}
+
+static void
+_ncm_data_emu_set_box (NcmDataEmu *emu, NcmMSet *mset)
+{
+  const guint fparam_len = ncm_mset_fparams_len (mset);
+
+  if (emu->dim == 0)
+  {
+    guint i;
+
+    _ncm_data_emu_set_dim (emu, fparam_len);
+    for (i = 0; i < fparam_len; i++)
+    {
+      ncm_vector_set (emu->lb, i, ncm_mset_fparam_get_lower_bound (mset, i));
+      ncm_vector_set (emu->ub, i, ncm_mset_fparam_get_upper_bound (mset, i));
+    }
+  }
+  else if (emu->dim != fparam_len)
+    g_error ("_ncm_data_emu_set_box: the emulator was built with %u free parameters but the NcmMSet has %u.",
+             emu->dim, fparam_len);
+}
+
+static void
+_ncm_data_emu_to_box (NcmDataEmu *emu, NcmVector *theta, gdouble *u)
+{
+  guint i;
+  for (i = 0; i < emu->dim; i++)
+  {
+    const gdouble lb_i = ncm_vector_get (emu->lb, i);
+    const gdouble ub_i = ncm_vector_get (emu->ub, i);
+    u[i] = (ncm_vector_get (theta, i) - lb_i) / (ub_i - lb_i);
+  }
+}
+
+static void
+_ncm_data_emu_from_box (NcmDataEmu *emu, const gdouble *u, NcmVector *theta)
+{
+  guint i;
+  for (i = 0; i < emu->dim; i++)
+  {
+    const gdouble lb_i = ncm_vector_get (emu->lb, i);
+    const gdouble ub_i = ncm_vector_get (emu->ub, i);
+    ncm_vector_set (theta, i, lb_i + u[i] * (ub_i - lb_i));
+  }
+}
+
+static gdouble
+_ncm_data_emu_kernel (NcmDataEmu *emu, const gdouble *u, const gdouble *v)
+{
+  gdouble d2 = 0.0;
+  guint i;
+
+  for (i = 0; i < emu->dim; i++)
+  {
+    const gdouble d_i = (u[i] - v[i]) / ncm_vector_get (emu->lscale, i);
+    d2 += d_i * d_i;
+  }
+
+  return exp (-0.5 * d2);
+}
+
+/*
+ * The decomposition is stored in the leading n x n block of LLT, whose
+ * size is the capacity of the training set, so that appending a point
+ * only fills a new column.
+ */
+static void
+_ncm_data_emu_reserve (NcmDataEmu *emu, guint n)
+{
+  const guint cap = (emu->LLT != NULL) ? ncm_matrix_nrows (emu->LLT) : 0;
+
+  if (cap < n)
+  {
+    const guint new_cap = GSL_MAX (GSL_MAX (n, 2 * cap), 16);
+    NcmMatrix *LLT      = ncm_matrix_new (new_cap, new_cap);
+    NcmVector *w1       = ncm_vector_new (new_cap);
+    NcmVector *wy       = ncm_vector_new (new_cap);
+
+    if (emu->nfactor > 0)
+    {
+      gsl_matrix_const_view LLT_old = gsl_matrix_const_submatrix (ncm_matrix_gsl (emu->LLT), 0, 0, emu->nfactor, emu->nfactor);
+      gsl_matrix_view LLT_new       = gsl_matrix_submatrix (ncm_matrix_gsl (LLT), 0, 0, emu->nfactor, emu->nfactor);
+      gsl_vector_const_view w1_old  = gsl_vector_const_subvector (ncm_vector_gsl (emu->w1), 0, emu->nfactor);
+      gsl_vector_const_view wy_old  = gsl_vector_const_subvector (ncm_vector_gsl (emu->wy), 0, emu->nfactor);
+      gsl_vector_view w1_new        = gsl_vector_subvector (ncm_vector_gsl (w1), 0, emu->nfactor);
+      gsl_vector_view wy_new        = gsl_vector_subvector (ncm_vector_gsl (wy), 0, emu->nfactor);
+
+      gsl_matrix_memcpy (&LLT_new.matrix, &LLT_old.matrix);
+      gsl_vector_memcpy (&w1_new.vector, &w1_old.vector);
+      gsl_vector_memcpy (&wy_new.vector, &wy_old.vector);
+    }
+
+    ncm_matrix_clear (&emu->LLT);
+    ncm_vector_clear (&emu->alpha);
+    ncm_vector_clear (&emu->w1);
+    ncm_vector_clear (&emu->wy);
+
+    emu->LLT   = LLT;
+    emu->alpha = ncm_vector_new (new_cap);
+    emu->w1    = w1;
+    emu->wy    = wy;
+  }
+}
+
+/*
+ * Given the decomposition U^T U of the first n points and the solutions
+ * of U^T w1 = 1 and U^T wy = y, computes the profiled mean and amplitude
+ * and alpha = K^{-1}(y - mu). Returns the profiled log-marginal likelihood.
+ */
+static gdouble
+_ncm_data_emu_solve (NcmDataEmu *emu, guint n)
+{
+  gsl_matrix_const_view LLT = gsl_matrix_const_submatrix (ncm_matrix_gsl (emu->LLT), 0, 0, n, n);
+  gsl_vector_const_view w1  = gsl_vector_const_subvector (ncm_vector_gsl (emu->w1), 0, n);
+  gsl_vector_const_view wy  = gsl_vector_const_subvector (ncm_vector_gsl (emu->wy), 0, n);
+  gsl_vector_view alpha     = gsl_vector_subvector (ncm_vector_gsl (emu->alpha), 0, n);
+  gdouble w1w1, w1wy;
+  gint ret;
+
+  ret = gsl_blas_ddot (&w1.vector, &w1.vector, &w1w1);
+  NCM_TEST_GSL_RESULT ("_ncm_data_emu_solve", ret);
+  ret = gsl_blas_ddot (&w1.vector, &wy.vector, &w1wy);
+  NCM_TEST_GSL_RESULT ("_ncm_data_emu_solve", ret);
+
+  emu->mu = w1wy / w1w1;
+
+  gsl_vector_memcpy (&alpha.vector, &wy.vector);
+  ret = gsl_blas_daxpy (-emu->mu, &w1.vector, &alpha.vector);
+  NCM_TEST_GSL_RESULT ("_ncm_data_emu_solve", ret);
+
+  ret = gsl_blas_ddot (&alpha.vector, &alpha.vector, &emu->sigma2);
+  NCM_TEST_GSL_RESULT ("_ncm_data_emu_solve", ret);
+  emu->sigma2 = GSL_MAX (emu->sigma2 / n, GSL_DBL_MIN);
+
+  /* CblasLower, CblasTrans => CblasUpper, CblasNoTrans */
+  ret = gsl_blas_dtrsv (CblasUpper, CblasNoTrans, CblasNonUnit, &LLT.matrix, &alpha.vector);
+  NCM_TEST_GSL_RESULT ("_ncm_data_emu_solve", ret);
+
+  emu->nfactor  = n;
+  emu->gp_ready = TRUE;
+
+  return -0.5 * n * log (emu->sigma2) - emu->lndet;
+}
+
+/*
+ * Builds and decomposes the correlation matrix of the training set and
+ * computes the profiled mean and amplitude. Returns the profiled
+ * log-marginal likelihood or -inf if the decomposition fails.
+ */
+static gdouble
+_ncm_data_emu_factor (NcmDataEmu *emu)
+{
+  const guint n = emu->ty->len;
+  gsl_matrix_view LLT;
+  gsl_vector_view w1, wy;
+  guint i, j;
+  gint ret;
+
+  emu->gp_ready = FALSE;
+  emu->nfactor  = 0;
+  if (n == 0)
+    return GSL_NEGINF;
+
+  _ncm_data_emu_reserve (emu, n);
+  LLT = gsl_matrix_submatrix (ncm_matrix_gsl (emu->LLT), 0, 0, n, n);
+  w1  = gsl_vector_subvector (ncm_vector_gsl (emu->w1), 0, n);
+  wy  = gsl_vector_subvector (ncm_vector_gsl (emu->wy), 0, n);
+
+  for (i = 0; i < n; i++)
+  {
+    const gdouble *x_i = &g_array_index (emu->tx, gdouble, i * emu->dim);
+
+    gsl_matrix_set (&LLT.matrix, i, i, 1.0 + emu->nugget);
+    for (j = i + 1; j < n; j++)
+    {
+      const gdouble *x_j = &g_array_index (emu->tx, gdouble, j * emu->dim);
+      const gdouble k_ij = _ncm_data_emu_kernel (emu, x_i, x_j);
+
+      gsl_matrix_set (&LLT.matrix, i, j, k_ij);
+      gsl_matrix_set (&LLT.matrix, j, i, k_ij);
+    }
+  }
+
+  ret = ncm_lapack_dpotrf ('U', n, LLT.matrix.data, LLT.matrix.tda);
+  if (ret != 0)
+    return GSL_NEGINF;
+
+  emu->lndet = 0.0;
+  for (i = 0; i < n; i++)
+  {
+    emu->lndet += log (gsl_matrix_get (&LLT.matrix, i, i));
+    gsl_vector_set (&w1.vector, i, 1.0);
+    gsl_vector_set (&wy.vector, i, g_array_index (emu->ty, gdouble, i));
+  }
+
+  /* CblasLower, CblasNoTrans => CblasUpper, CblasTrans */
+  ret = gsl_blas_dtrsv (CblasUpper, CblasTrans, CblasNonUnit, &LLT.matrix, &w1.vector);
+  NCM_TEST_GSL_RESULT ("_ncm_data_emu_factor", ret);
+  ret = gsl_blas_dtrsv (CblasUpper, CblasTrans, CblasNonUnit, &LLT.matrix, &wy.vector);
+  NCM_TEST_GSL_RESULT ("_ncm_data_emu_factor", ret);
+
+  return _ncm_data_emu_solve (emu, n);
+}
+
+/*
+ * Appends the point nfactor to the decomposition. With K = U^T U the new
+ * column s solves U^T s = k and the new diagonal element is
+ * d = sqrt (1 + nugget - s^T s), the new elements of w1 and wy follow
+ * from the last row of U'^T. Returns FALSE when d^2 is not positive.
+ */
+static gboolean
+_ncm_data_emu_extend (NcmDataEmu *emu)
+{
+  const guint n      = emu->nfactor;
+  const gdouble *x_n = &g_array_index (emu->tx, gdouble, n * emu->dim);
+  gsl_matrix_view LLT;
+  gsl_vector_view s, w1, wy;
+  gdouble ss, sw1, swy, d;
+  guint j;
+  gint ret;
+
+  _ncm_data_emu_reserve (emu, n + 1);
+  LLT = gsl_matrix_submatrix (ncm_matrix_gsl (emu->LLT), 0, 0, n, n);
+  s   = gsl_matrix_subcolumn (ncm_matrix_gsl (emu->LLT), n, 0, n);
+  w1  = gsl_vector_subvector (ncm_vector_gsl (emu->w1), 0, n);
+  wy  = gsl_vector_subvector (ncm_vector_gsl (emu->wy), 0, n);
+
+  for (j = 0; j < n; j++)
+    gsl_vector_set (&s.vector, j, _ncm_data_emu_kernel (emu, &g_array_index (emu->tx, gdouble, j * emu->dim), x_n));
+
+  ret = gsl_blas_dtrsv (CblasUpper, CblasTrans, CblasNonUnit, &LLT.matrix, &s.vector);
+  NCM_TEST_GSL_RESULT ("_ncm_data_emu_extend", ret);
+
+  ret = gsl_blas_ddot (&s.vector, &s.vector, &ss);
+  NCM_TEST_GSL_RESULT ("_ncm_data_emu_extend", ret);
+  ret = gsl_blas_ddot (&s.vector, &w1.vector, &sw1);
+  NCM_TEST_GSL_RESULT ("_ncm_data_emu_extend", ret);
+  ret = gsl_blas_ddot (&s.vector, &wy.vector, &swy);
+  NCM_TEST_GSL_RESULT ("_ncm_data_emu_extend", ret);
+
+  d = 1.0 + emu->nugget - ss;
+  if (!(d > 0.0))
+    return FALSE;
+  d = sqrt (d);
+
+  ncm_matrix_set (emu->LLT, n, n, d);
+  ncm_vector_set (emu->w1, n, (1.0 - sw1) / d);
+  ncm_vector_set (emu->wy, n, (g_array_index (emu->ty, gdouble, n) - swy) / d);
+  emu->lndet += log (d);
+
+  _ncm_data_emu_solve (emu, n + 1);
+
+  return TRUE;
+}
+
+static void
+_ncm_data_emu_fit_hyper (NcmDataEmu *emu)
+{
+  const gdouble factors[] = {0.5, M_SQRT1_2, M_SQRT2, 2.0};
+  gdouble best_lnL = _ncm_data_emu_factor (emu);
+  guint sweep;
+
+  for (sweep = 0; sweep < 3; sweep++)
+  {
+    gboolean improved = FALSE;
+    guint i;
+
+    for (i = 0; i < emu->dim; i++)
+    {
+      gdouble l_i = ncm_vector_get (emu->lscale, i);
+      guint k;
+
+      for (k = 0; k < G_N_ELEMENTS (factors); k++)
+      {
+        const gdouble try_l_i = GSL_MIN (GSL_MAX (l_i * factors[k], NCM_DATA_EMU_LSCALE_MIN), NCM_DATA_EMU_LSCALE_MAX);
+        gdouble lnL;
+
+        if (try_l_i == l_i)
+          continue;
+
+        ncm_vector_set (emu->lscale, i, try_l_i);
+        lnL = _ncm_data_emu_factor (emu);
+
+        if (lnL > best_lnL)
+        {
+          best_lnL = lnL;
+          l_i      = try_l_i;
+          improved = TRUE;
+        }
+      }
+      ncm_vector_set (emu->lscale, i, l_i);
+    }
+
+    if (!improved)
+      break;
+  }
+
+  if (!gsl_finite (_ncm_data_emu_factor (emu)))
+    g_warning ("_ncm_data_emu_fit_hyper: cannot decompose the training set covariance, using the original likelihood.");
+
+  emu->nhyper = emu->ty->len;
+}
+
+/*
+ * Updates the GP after points were appended to the training set. The
+ * length scales are fitted again every time the training set grows by
+ * 25%, otherwise the decomposition is extended point by point.
+ */
+static void
+_ncm_data_emu_update (NcmDataEmu *emu)
+{
+  const guint n = emu->ty->len;
+
+  ncm_data_mark_changed (NCM_DATA (emu));
+
+  if (n == 0)
+    emu->gp_ready = FALSE;
+  else if ((emu->nhyper == 0) || (4 * n >= 5 * emu->nhyper))
+    _ncm_data_emu_fit_hyper (emu);
+  else if (!emu->gp_ready)
+    _ncm_data_emu_factor (emu);
+  else
+  {
+    while (emu->nfactor < n)
+    {
+      if (!_ncm_data_emu_extend (emu))
+      {
+        _ncm_data_emu_factor (emu);
+        break;
+      }
+    }
+  }
+}
+
+/*
+ * Recomputes the decomposition with the current length scales after the
+ * training set or the length scales are replaced, when both the points
+ * and the values are consistent.
+ */
+static void
+_ncm_data_emu_refactor (NcmDataEmu *emu)
+{
+  const guint n = emu->ty->len;
+
+  emu->gp_ready = FALSE;
+  emu->nfactor  = 0;
+
+  ncm_data_mark_changed (NCM_DATA (emu));
+
+  if ((n > 0) && (emu->dim > 0) && (emu->tx->len == n * emu->dim))
+  {
+    if (emu->nhyper == 0)
+      emu->nhyper = n;
+    _ncm_data_emu_factor (emu);
+  }
+}
+
+static void
+_ncm_data_emu_append (NcmDataEmu *emu, const gdouble *u, gdouble m2lnL)
+{
+  if (!gsl_finite (m2lnL) || (emu->ty->len >= emu->max_train))
+    return;
+
+  g_array_append_vals (emu->tx, u, emu->dim);
+  g_array_append_val (emu->ty, m2lnL);
+}
+
+/*
+ * GP prediction at u, it only reads the emulator, the temporaries come
+ * from the thread workspace.
+ */
+static void
+_ncm_data_emu_predict_u (NcmDataEmu *emu, const gdouble *u, gdouble *mean, gdouble *sd)
+{
+  const guint n = emu->nfactor;
+  NcmWorkspace *ws;
+  NcmVector *r;
+  gsl_matrix_const_view LLT;
+  gsl_vector_const_view alpha;
+  gdouble kalpha, ss;
+  guint j;
+  gint ret;
+
+  if (!emu->gp_ready)
+  {
+    mean[0] = GSL_NAN;
+    sd[0]   = GSL_POSINF;
+    return;
+  }
+
+  ws    = ncm_workspace_peek ();
+  r     = ncm_workspace_borrow_vector (ws, n);
+  LLT   = gsl_matrix_const_submatrix (ncm_matrix_gsl (emu->LLT), 0, 0, n, n);
+  alpha = gsl_vector_const_subvector (ncm_vector_gsl (emu->alpha), 0, n);
+
+  for (j = 0; j < n; j++)
+    ncm_vector_set (r, j, _ncm_data_emu_kernel (emu, u, &g_array_index (emu->tx, gdouble, j * emu->dim)));
+
+  ret = gsl_blas_ddot (ncm_vector_gsl (r), &alpha.vector, &kalpha);
+  NCM_TEST_GSL_RESULT ("_ncm_data_emu_predict_u", ret);
+
+  /* CblasLower, CblasNoTrans => CblasUpper, CblasTrans */
+  ret = gsl_blas_dtrsv (CblasUpper, CblasTrans, CblasNonUnit, &LLT.matrix, ncm_vector_gsl (r));
+  NCM_TEST_GSL_RESULT ("_ncm_data_emu_predict_u", ret);
+  ret = gsl_blas_ddot (ncm_vector_gsl (r), ncm_vector_gsl (r), &ss);
+  NCM_TEST_GSL_RESULT ("_ncm_data_emu_predict_u", ret);
+
+  ncm_workspace_return_vector (ws, r);
+
+  mean[0] = emu->mu + kalpha;
+  sd[0]   = sqrt (emu->sigma2 * GSL_MAX (1.0 + emu->nugget - ss, 0.0));
+}
+
+/*
+ * Converts the current free parameters of mset to box coordinates, the
+ * emulator box must be already set.
+ */
+static void
+_ncm_data_emu_mset_to_box (NcmDataEmu *emu, NcmMSet *mset, gdouble *u)
+{
+  NcmWorkspace *ws = ncm_workspace_peek ();
+  NcmVector *theta = ncm_workspace_borrow_vector (ws, emu->dim);
+
+  if (ncm_mset_fparams_len (mset) != emu->dim)
+    g_error ("_ncm_data_emu_mset_to_box: the emulator was built with %u free parameters but the NcmMSet has %u.",
+             emu->dim, ncm_mset_fparams_len (mset));
+
+  ncm_mset_fparams_get_vector (mset, theta);
+  _ncm_data_emu_to_box (emu, theta, u);
+
+  ncm_workspace_return_vector (ws, theta);
+}
+
+static guint
+_ncm_data_emu_get_length (NcmData *data)
+{
+  NcmDataEmu *emu = NCM_DATA_EMU (data);
+  return ncm_data_get_length (emu->data);
+}
+
+static guint
+_ncm_data_emu_get_dof (NcmData *data)
+{
+  NcmDataEmu *emu = NCM_DATA_EMU (data);
+  return ncm_data_get_dof (emu->data);
+}
+
+static void
+_ncm_data_emu_resample (NcmData *data, NcmMSet *mset, NcmRNG *rng)
+{
+  NcmDataEmu *emu = NCM_DATA_EMU (data);
+
+  ncm_data_resample (emu->data, mset, rng);
+}
+
+static void
+_ncm_data_emu_m2lnL_val (NcmData *data, NcmMSet *mset, gdouble *m2lnL)
+{
+  NcmDataEmu *emu = NCM_DATA_EMU (data);
+
+  if (emu->gp_ready)
+  {
+    NcmWorkspace *ws = ncm_workspace_peek ();
+    NcmVector *u     = ncm_workspace_borrow_vector (ws, emu->dim);
+    gdouble sd;
+
+    _ncm_data_emu_mset_to_box (emu, mset, ncm_vector_data (u));
+    _ncm_data_emu_predict_u (emu, ncm_vector_data (u), m2lnL, &sd);
+    ncm_workspace_return_vector (ws, u);
+
+    if (sd <= emu->err_tol)
+    {
+      g_atomic_int_inc ((gint *) &emu->nemu);
+      return;
+    }
+  }
+
+  ncm_data_m2lnL_val (emu->data, mset, m2lnL);
+  g_atomic_int_inc ((gint *) &emu->ntrue);
+}
+
+/**
+ * ncm_data_emu_new:
+ * @data: the #NcmData to be emulated
+ * @err_tol: maximum standard deviation of the emulated $-2\ln(L)$
+ *
+ * Creates a new emulator for @data. The emulator box is the free
+ * parameter box of the #NcmMSet used in the first training or evaluation.
+ *
+ * Returns: (transfer full): a new #NcmDataEmu.
+ */
+NcmDataEmu *
+ncm_data_emu_new (NcmData *data, gdouble err_tol)
+{
+  NcmDataEmu *emu = g_object_new (NCM_TYPE_DATA_EMU,
+                                  "data", data,
+                                  "err-tol", err_tol,
+                                  NULL);
+  return emu;
+}
+
+/**
+ * ncm_data_emu_free:
+ * @emu: a #NcmDataEmu
+ *
+ * Atomically decrements the reference count of @emu by one. If the reference count drops to 0,
+ * all memory allocated by @emu is released.
+ *
+ */
+void
+ncm_data_emu_free (NcmDataEmu *emu)
+{
+  g_object_unref (emu);
+}
+
+/**
+ * ncm_data_emu_clear:
+ * @emu: a #NcmDataEmu
+ *
+ * Atomically decrements the reference count of @emu by one. If the reference count drops to 0,
+ * all memory allocated by @emu is released. Set pointer to NULL.
+ *
+ */
+void
+ncm_data_emu_clear (NcmDataEmu **emu)
+{
+  g_clear_object (emu);
+}
+
+/**
+ * ncm_data_emu_peek_data:
+ * @emu: a #NcmDataEmu
+ *
+ * Returns: (transfer none): the emulated #NcmData.
+ */
+NcmData *
+ncm_data_emu_peek_data (NcmDataEmu *emu)
+{
+  return emu->data;
+}
+
+/**
+ * ncm_data_emu_set_err_tol:
+ * @emu: a #NcmDataEmu
+ * @err_tol: maximum standard deviation of the emulated $-2\ln(L)$
+ *
+ * Sets the maximum standard deviation of the GP prediction accepted in
+ * place of the original likelihood.
+ *
+ */
+void
+ncm_data_emu_set_err_tol (NcmDataEmu *emu, gdouble err_tol)
+{
+  g_assert_cmpfloat (err_tol, >=, 0.0);
+  emu->err_tol = err_tol;
+
+  ncm_data_mark_changed (NCM_DATA (emu));
+}
+
+/**
+ * ncm_data_emu_set_max_train:
+ * @emu: a #NcmDataEmu
+ * @max_train: maximum size of the training set
+ *
+ * Sets the maximum size of the training set, when it is reached no more
+ * points are added and the fallback evaluations are not stored.
+ *
+ */
+void
+ncm_data_emu_set_max_train (NcmDataEmu *emu, guint max_train)
+{
+  g_assert_cmpuint (max_train, >, 0);
+  emu->max_train = max_train;
+}
+
+/**
+ * ncm_data_emu_set_nthreads:
+ * @emu: a #NcmDataEmu
+ * @nthreads: number of threads
+ *
+ * Sets the number of threads used to evaluate the original likelihood in
+ * ncm_data_emu_train() and ncm_data_emu_refine().
+ *
+ */
+void
+ncm_data_emu_set_nthreads (NcmDataEmu *emu, guint nthreads)
+{
+  emu->nthreads = nthreads;
+}
+
+/**
+ * ncm_data_emu_get_err_tol:
+ * @emu: a #NcmDataEmu
+ *
+ * Returns: the maximum standard deviation of the emulated $-2\ln(L)$.
+ */
+gdouble
+ncm_data_emu_get_err_tol (NcmDataEmu *emu)
+{
+  return emu->err_tol;
+}
+
+/**
+ * ncm_data_emu_get_max_train:
+ * @emu: a #NcmDataEmu
+ *
+ * Returns: the maximum size of the training set.
+ */
+guint
+ncm_data_emu_get_max_train (NcmDataEmu *emu)
+{
+  return emu->max_train;
+}
+
+/**
+ * ncm_data_emu_get_nthreads:
+ * @emu: a #NcmDataEmu
+ *
+ * Returns: the number of threads used in the training.
+ */
+guint
+ncm_data_emu_get_nthreads (NcmDataEmu *emu)
+{
+  return emu->nthreads;
+}
+
+/**
+ * ncm_data_emu_get_ntrain:
+ * @emu: a #NcmDataEmu
+ *
+ * Returns: the current size of the training set.
+ */
+guint
+ncm_data_emu_get_ntrain (NcmDataEmu *emu)
+{
+  return emu->ty->len;
+}
+
+/**
+ * ncm_data_emu_get_amplitude:
+ * @emu: a #NcmDataEmu
+ *
+ * Returns: the profiled amplitude $\sigma$ of the GP covariance, i.e., the
+ * prior standard deviation of $-2\ln(L)$, or zero before the training.
+ */
+gdouble
+ncm_data_emu_get_amplitude (NcmDataEmu *emu)
+{
+  return emu->gp_ready ? sqrt (emu->sigma2) : 0.0;
+}
+
+/**
+ * ncm_data_emu_get_emu_ratio:
+ * @emu: a #NcmDataEmu
+ *
+ * Returns: the fraction of the calls of ncm_data_m2lnL_val() answered by
+ * the emulator.
+ */
+gdouble
+ncm_data_emu_get_emu_ratio (NcmDataEmu *emu)
+{
+  const guint ncalls = emu->nemu + emu->ntrue;
+  return (ncalls == 0) ? 0.0 : ((gdouble) emu->nemu) / ncalls;
+}
+
+/**
+ * ncm_data_emu_reset:
+ * @emu: a #NcmDataEmu
+ *
+ * Removes all points from the training set and resets the call counters.
+ * The emulator box and the length scales are kept.
+ *
+ */
+void
+ncm_data_emu_reset (NcmDataEmu *emu)
+{
+  g_array_set_size (emu->tx, 0);
+  g_array_set_size (emu->ty, 0);
+
+  emu->gp_ready = FALSE;
+  emu->nhyper   = 0;
+  emu->nfactor  = 0;
+  emu->nemu     = 0;
+  emu->ntrue    = 0;
+
+  ncm_data_mark_changed (NCM_DATA (emu));
+}
+
+typedef struct _NcmDataEmuEval
+{
+  NcmDataEmu *emu;
+  NcmMSet *mset;
+  NcmMatrix *pts;
+  NcmVector *m2lnL;
+  NcmSerialize *ser;
+  NcmMemoryPool *mp;
+  GMutex dup_lock;
+} NcmDataEmuEval;
+
+typedef struct _NcmDataEmuWorker
+{
+  NcmMSet *mset;
+  NcmData *data;
+  NcmVector *theta;
+} NcmDataEmuWorker;
+
+static gpointer
+_ncm_data_emu_worker_new (gpointer userdata)
+{
+  NcmDataEmuEval *eval = (NcmDataEmuEval *) userdata;
+  NcmDataEmuWorker *w  = g_new (NcmDataEmuWorker, 1);
+
+  g_mutex_lock (&eval->dup_lock);
+  w->mset = ncm_mset_dup (eval->mset, eval->ser);
+  w->data = ncm_data_dup (eval->emu->data, eval->ser);
+  ncm_serialize_clear_instances (eval->ser);
+  g_mutex_unlock (&eval->dup_lock);
+
+  w->theta = ncm_vector_new (eval->emu->dim);
+
+  return w;
+}
+
+static void
+_ncm_data_emu_worker_free (gpointer data)
+{
+  NcmDataEmuWorker *w = (NcmDataEmuWorker *) data;
+
+  ncm_mset_clear (&w->mset);
+  ncm_data_clear (&w->data);
+  ncm_vector_clear (&w->theta);
+  g_free (w);
+}
+
+static void
+_ncm_data_emu_eval_worker (NcmDataEmuEval *eval, NcmDataEmuWorker *w, glong i, glong f)
+{
+  glong j;
+
+  for (j = i; j < f; j++)
+  {
+    gdouble m2lnL;
+
+    _ncm_data_emu_from_box (eval->emu, ncm_matrix_ptr (eval->pts, j, 0), w->theta);
+    ncm_mset_fparams_set_vector (w->mset, w->theta);
+    ncm_data_m2lnL_val (w->data, w->mset, &m2lnL);
+
+    ncm_vector_set (eval->m2lnL, j, m2lnL);
+  }
+}
+
+static void
+_ncm_data_emu_eval_mt (glong i, glong f, gpointer data)
+{
+  NcmDataEmuEval *eval     = (NcmDataEmuEval *) data;
+  NcmDataEmuWorker **w_ptr = ncm_memory_pool_get (eval->mp);
+
+  _ncm_data_emu_eval_worker (eval, *w_ptr, i, f);
+
+  ncm_memory_pool_return (w_ptr);
+}
+
+/*
+ * Evaluates the original likelihood in the rows of pts (box coordinates)
+ * and adds the results to the training set.
+ */
+static void
+_ncm_data_emu_eval_add (NcmDataEmu *emu, NcmMSet *mset, NcmMatrix *pts)
+{
+  const guint n        = ncm_matrix_nrows (pts);
+  NcmDataEmuEval eval  = {emu, mset, pts, ncm_vector_new (n), NULL, NULL};
+  guint i;
+
+  if (emu->nthreads > 1)
+  {
+    eval.ser = ncm_serialize_new (NCM_SERIALIZE_OPT_CLEAN_DUP);
+    eval.mp  = ncm_memory_pool_new (&_ncm_data_emu_worker_new, &eval, &_ncm_data_emu_worker_free);
+    g_mutex_init (&eval.dup_lock);
+
+    ncm_func_eval_threaded_loop_full (&_ncm_data_emu_eval_mt, 0, n, &eval);
+
+    ncm_memory_pool_free (eval.mp, TRUE);
+    ncm_serialize_clear (&eval.ser);
+    g_mutex_clear (&eval.dup_lock);
+  }
+  else
+  {
+    NcmVector *save = ncm_vector_new (emu->dim);
+    NcmDataEmuWorker w = {mset, emu->data, ncm_vector_new (emu->dim)};
+
+    ncm_mset_fparams_get_vector (mset, save);
+    _ncm_data_emu_eval_worker (&eval, &w, 0, n);
+    ncm_mset_fparams_set_vector (mset, save);
+
+    ncm_vector_free (w.theta);
+    ncm_vector_free (save);
+  }
+
+  for (i = 0; i < n; i++)
+    _ncm_data_emu_append (emu, ncm_matrix_ptr (pts, i, 0), ncm_vector_get (eval.m2lnL, i));
+
+  ncm_vector_free (eval.m2lnL);
+
+  _ncm_data_emu_update (emu);
+}
+
+static void
+_ncm_data_emu_lhs (NcmDataEmu *emu, NcmMatrix *pts, NcmRNG *rng)
+{
+  const guint n = ncm_matrix_nrows (pts);
+  guint *perm   = g_new (guint, n);
+  guint i, j;
+
+  ncm_rng_lock (rng);
+  for (j = 0; j < emu->dim; j++)
+  {
+    for (i = 0; i < n; i++)
+      perm[i] = i;
+    gsl_ran_shuffle (rng->r, perm, n, sizeof (guint));
+
+    for (i = 0; i < n; i++)
+      ncm_matrix_set (pts, i, j, (perm[i] + gsl_rng_uniform (rng->r)) / n);
+  }
+  ncm_rng_unlock (rng);
+
+  g_free (perm);
+}
+
+/**
+ * ncm_data_emu_train:
+ * @emu: a #NcmDataEmu
+ * @mset: a #NcmMSet
+ * @n: number of points
+ * @rng: a #NcmRNG
+ *
+ * Evaluates the original likelihood in a Latin hypercube design with @n
+ * points in the free parameter box of @mset and adds the results to the
+ * training set. The GP hyperparameters are fitted at the end.
+ *
+ */
+void
+ncm_data_emu_train (NcmDataEmu *emu, NcmMSet *mset, guint n, NcmRNG *rng)
+{
+  NcmMatrix *pts;
+
+  g_assert_cmpuint (n, >, 0);
+  _ncm_data_emu_set_box (emu, mset);
+
+  pts = ncm_matrix_new (n, emu->dim);
+  _ncm_data_emu_lhs (emu, pts, rng);
+
+  emu->nhyper = 0;
+  _ncm_data_emu_eval_add (emu, mset, pts);
+
+  ncm_matrix_free (pts);
+}
+
+/**
+ * ncm_data_emu_train_at:
+ * @emu: a #NcmDataEmu
+ * @mset: a #NcmMSet
+ *
+ * Evaluates the original likelihood at the current free parameters of
+ * @mset and adds the result to the training set, for example, after
+ * ncm_data_emu_predict() returned a standard deviation larger than
+ * #NcmDataEmu:err-tol. The GP decomposition is extended by the new point
+ * and the length scales are fitted again only when the training set grew
+ * by 25% since the last fit. Nothing is added when the training set
+ * already has #NcmDataEmu:max-train points.
+ *
+ */
+void
+ncm_data_emu_train_at (NcmDataEmu *emu, NcmMSet *mset)
+{
+  NcmMatrix *pts;
+
+  _ncm_data_emu_set_box (emu, mset);
+
+  pts = ncm_matrix_new (1, emu->dim);
+  _ncm_data_emu_mset_to_box (emu, mset, ncm_matrix_ptr (pts, 0, 0));
+  _ncm_data_emu_eval_add (emu, mset, pts);
+
+  ncm_matrix_free (pts);
+}
+
+typedef struct _NcmDataEmuCand
+{
+  guint i;
+  gdouble score;
+} NcmDataEmuCand;
+
+static gint
+_ncm_data_emu_cand_cmp (gconstpointer a, gconstpointer b)
+{
+  const NcmDataEmuCand *ca = (const NcmDataEmuCand *) a;
+  const NcmDataEmuCand *cb = (const NcmDataEmuCand *) b;
+
+  return (ca->score > cb->score) ? -1 : ((ca->score < cb->score) ? 1 : 0);
+}
+
+/**
+ * ncm_data_emu_refine:
+ * @emu: a #NcmDataEmu
+ * @mset: a #NcmMSet
+ * @ncand: number of candidates
+ * @nadd: number of points to add
+ * @rng: a #NcmRNG
+ *
+ * Active learning step. Draws @ncand candidates in a Latin hypercube
+ * design and evaluates the original likelihood in the @nadd candidates
+ * with the largest score $\sigma(u)\exp\{-[\mu(u) - \min(y)]/2\}$, where
+ * $\mu$ and $\sigma$ are the GP prediction and $y$ the training values,
+ * i.e., where both the posterior mass and the emulator uncertainty are
+ * high. Candidates closer than half a length scale to an already chosen
+ * one are skipped.
+ *
+ */
+void
+ncm_data_emu_refine (NcmDataEmu *emu, NcmMSet *mset, guint ncand, guint nadd, NcmRNG *rng)
+{
+  NcmMatrix *cand, *pts;
+  NcmDataEmuCand *score;
+  gdouble ymin = GSL_POSINF;
+  guint i, nsel = 0;
+
+  if (emu->ty->len == 0)
+    g_error ("ncm_data_emu_refine: the emulator must be trained first, see ncm_data_emu_train().");
+
+  g_assert_cmpuint (nadd, >, 0);
+  g_assert_cmpuint (ncand, >=, nadd);
+  _ncm_data_emu_set_box (emu, mset);
+
+  for (i = 0; i < emu->ty->len; i++)
+    ymin = GSL_MIN (ymin, g_array_index (emu->ty, gdouble, i));
+
+  cand  = ncm_matrix_new (ncand, emu->dim);
+  pts   = ncm_matrix_new (nadd, emu->dim);
+  score = g_new (NcmDataEmuCand, ncand);
+
+  _ncm_data_emu_lhs (emu, cand, rng);
+
+  for (i = 0; i < ncand; i++)
+  {
+    gdouble mean, sd;
+
+    _ncm_data_emu_predict_u (emu, ncm_matrix_ptr (cand, i, 0), &mean, &sd);
+
+    score[i].i     = i;
+    score[i].score = gsl_finite (mean) ? sd * exp (-0.5 * GSL_MAX (mean - ymin, 0.0)) : 0.0;
+  }
+
+  qsort (score, ncand, sizeof (NcmDataEmuCand), &_ncm_data_emu_cand_cmp);
+
+  for (i = 0; (i < ncand) && (nsel < nadd); i++)
+  {
+    const gdouble *u = ncm_matrix_ptr (cand, score[i].i, 0);
+    gboolean accept  = TRUE;
+    guint j;
+
+    for (j = 0; j < nsel; j++)
+    {
+      if (_ncm_data_emu_kernel (emu, u, ncm_matrix_ptr (pts, j, 0)) > exp (-0.125))
+      {
+        accept = FALSE;
+        break;
+      }
+    }
+
+    if (accept)
+    {
+      memcpy (ncm_matrix_ptr (pts, nsel, 0), u, sizeof (gdouble) * emu->dim);
+      nsel++;
+    }
+  }
+
+  if (nsel > 0)
+  {
+    NcmMatrix *sel = ncm_matrix_get_submatrix (pts, 0, 0, nsel, emu->dim);
+    _ncm_data_emu_eval_add (emu, mset, sel);
+    ncm_matrix_free (sel);
+  }
+
+  ncm_matrix_free (cand);
+  ncm_matrix_free (pts);
+  g_free (score);
+}
+
+/**
+ * ncm_data_emu_predict:
+ * @emu: a #NcmDataEmu
+ * @mset: a #NcmMSet
+ * @m2lnL: (out): emulated $-2\ln(L)$
+ * @sd: (out): standard deviation of @m2lnL
+ *
+ * Computes the GP prediction at the current free parameters of @mset
+ * without falling back to the original likelihood. Before the training
+ * @m2lnL is NaN and @sd is infinite. This function does not change @emu.
+ *
+ */
+void
+ncm_data_emu_predict (NcmDataEmu *emu, NcmMSet *mset, gdouble *m2lnL, gdouble *sd)
+{
+  if (!emu->gp_ready)
+  {
+    m2lnL[0] = GSL_NAN;
+    sd[0]    = GSL_POSINF;
+  }
+  else
+  {
+    NcmWorkspace *ws = ncm_workspace_peek ();
+    NcmVector *u     = ncm_workspace_borrow_vector (ws, emu->dim);
+
+    _ncm_data_emu_mset_to_box (emu, mset, ncm_vector_data (u));
+    _ncm_data_emu_predict_u (emu, ncm_vector_data (u), m2lnL, sd);
+
+    ncm_workspace_return_vector (ws, u);
+  }
+}
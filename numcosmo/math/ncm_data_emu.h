@@ -0,0 +1,115 @@
+/***************************************************************************
+ *            ncm_data_emu.h
+ *
+ *  Tue October 20 09:14:27 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_data_emu.h
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _NCM_DATA_EMU_H_
+#define _NCM_DATA_EMU_H_
+
+#include <glib.h>
+#include <glib-object.h>
+#include <numcosmo/build_cfg.h>
+#include <numcosmo/math/ncm_data.h>
+#include <numcosmo/math/ncm_mset.h>
+#include <numcosmo/math/ncm_rng.h>
+#include <numcosmo/math/ncm_vector.h>
+#include <numcosmo/math/ncm_matrix.h>
+
+G_BEGIN_DECLS
+
+#define NCM_TYPE_DATA_EMU             (ncm_data_emu_get_type ())
+#define NCM_DATA_EMU(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), NCM_TYPE_DATA_EMU, NcmDataEmu))
+#define NCM_DATA_EMU_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), NCM_TYPE_DATA_EMU, NcmDataEmuClass))
+#define NCM_IS_DATA_EMU(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), NCM_TYPE_DATA_EMU))
+#define NCM_IS_DATA_EMU_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), NCM_TYPE_DATA_EMU))
+#define NCM_DATA_EMU_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), NCM_TYPE_DATA_EMU, NcmDataEmuClass))
+
+typedef struct _NcmDataEmuClass NcmDataEmuClass;
+typedef struct _NcmDataEmu NcmDataEmu;
+
+struct _NcmDataEmuClass
+{
+  /*< private >*/
+  NcmDataClass parent_class;
+};
+
+struct _NcmDataEmu
+{
+  /*< private >*/
+  NcmData parent_instance;
+  NcmData *data;
+  GArray *tx;
+  GArray *ty;
+  NcmVector *lb;
+  NcmVector *ub;
+  NcmVector *lscale;
+  NcmMatrix *LLT;
+  NcmVector *alpha;
+  NcmVector *w1;
+  NcmVector *wy;
+  gdouble mu;
+  gdouble sigma2;
+  gdouble lndet;
+  gdouble nugget;
+  gdouble err_tol;
+  guint dim;
+  guint max_train;
+  guint nthreads;
+  guint nhyper;
+  guint nfactor;
+  guint nemu;
+  guint ntrue;
+  gboolean gp_ready;
+};
+
+GType ncm_data_emu_get_type (void) G_GNUC_CONST;
+
+NcmDataEmu *ncm_data_emu_new (NcmData *data, gdouble err_tol);
+void ncm_data_emu_free (NcmDataEmu *emu);
+void ncm_data_emu_clear (NcmDataEmu **emu);
+
+NcmData *ncm_data_emu_peek_data (NcmDataEmu *emu);
+
+void ncm_data_emu_set_err_tol (NcmDataEmu *emu, gdouble err_tol);
+void ncm_data_emu_set_max_train (NcmDataEmu *emu, guint max_train);
+void ncm_data_emu_set_nthreads (NcmDataEmu *emu, guint nthreads);
+gdouble ncm_data_emu_get_err_tol (NcmDataEmu *emu);
+guint ncm_data_emu_get_max_train (NcmDataEmu *emu);
+guint ncm_data_emu_get_nthreads (NcmDataEmu *emu);
+guint ncm_data_emu_get_ntrain (NcmDataEmu *emu);
+gdouble ncm_data_emu_get_amplitude (NcmDataEmu *emu);
+gdouble ncm_data_emu_get_emu_ratio (NcmDataEmu *emu);
+
+void ncm_data_emu_reset (NcmDataEmu *emu);
+void ncm_data_emu_train (NcmDataEmu *emu, NcmMSet *mset, guint n, NcmRNG *rng);
+void ncm_data_emu_train_at (NcmDataEmu *emu, NcmMSet *mset);
+void ncm_data_emu_refine (NcmDataEmu *emu, NcmMSet *mset, guint ncand, guint nadd, NcmRNG *rng);
+void ncm_data_emu_predict (NcmDataEmu *emu, NcmMSet *mset, gdouble *m2lnL, gdouble *sd);
+
+#define NCM_DATA_EMU_NUGGET (1.0e-8)
+#define NCM_DATA_EMU_LSCALE_MIN (1.0e-2)
+#define NCM_DATA_EMU_LSCALE_MAX (1.0e1)
+
+G_END_DECLS
+
+#endif /* _NCM_DATA_EMU_H_ */
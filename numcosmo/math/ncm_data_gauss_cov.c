@@ -29,6 +29,22 @@
  * @short_description: Gaussian data -- covariance provided.
  *
  * Generic gaussian distribution which uses the covariance matrix as input.
+ *
+ * Nuisance parameters that enter the mean linearly, i.e.,
+ * $\mu(\theta, a) = \mu(\theta) + D a$, can be removed from the
+ * likelihood in closed form. The subclass (or the user) provides the
+ * design matrix $D$ through ncm_data_gauss_cov_set_lin_design() and,
+ * when it depends on the models, the #NcmDataGaussCovClass.lin_func
+ * virtual function. Using the already computed Cholesky decomposition
+ * $C = LL^T$, the whitened design $\tilde{D} = L^{-1}D$ and residual
+ * $\tilde{r} = L^{-1}(y - \mu)$ give $F = \tilde{D}^T\tilde{D}$ and
+ * $b = \tilde{D}^T\tilde{r}$, and the profiled likelihood reads
+ * $-2\ln L = \tilde{r}^T\tilde{r} - b^TF^{-1}b$. When
+ * #NcmDataGaussCov:lin-marg is TRUE the parameters $a$ are marginalized
+ * with a flat prior instead, which adds $\ln\det F$ (and
+ * $-n_a\ln 2\pi$ when #NcmDataGaussCov:use-norma is set). In both
+ * cases the result does not depend on the values of $a$ used in the
+ * mean, the corresponding model parameters should be kept fixed.
  * 
  */
 
@@ -41,6 +57,7 @@
 #include "math/ncm_cfg.h"
 #include "math/ncm_c.h"
 #include "math/ncm_lapack.h"
+#include "math/ncm_workspace.h"
 
 #include <gsl/gsl_linalg.h>
 #include <gsl/gsl_blas.h>
@@ -53,6 +70,8 @@ enum
   PROP_USE_NORMA,
   PROP_MEAN,
   PROP_COV,
+  PROP_LIN_DESIGN,
+  PROP_LIN_MARG,
   PROP_SIZE,
 };
 
@@ -68,6 +87,10 @@ ncm_data_gauss_cov_init (NcmDataGaussCov *gauss)
   gauss->LLT              = NULL;
   gauss->prepared_LLT     = FALSE;
   gauss->use_norma        = FALSE;
+  gauss->lin_D            = NULL;
+  gauss->lin              = ncm_data_gauss_lin_new ();
+  gauss->lin_marg         = FALSE;
+  gauss->prepared_lin     = FALSE;
 }
 
 static void
@@ -79,6 +102,16 @@ _ncm_data_gauss_cov_constructed (GObject *object)
   }
 }
 
+static void
+_ncm_data_gauss_cov_set_lin_design_ref (NcmDataGaussCov *gauss, NcmMatrix *D)
+{
+  if (D != NULL)
+    g_assert_cmpuint (ncm_matrix_ncols (D), >, 0);
+
+  ncm_matrix_substitute (&gauss->lin_D, D, FALSE);
+  gauss->prepared_lin = FALSE;
+}
+
 static void
 _ncm_data_gauss_cov_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
 {
@@ -102,6 +135,13 @@ _ncm_data_gauss_cov_set_property (GObject *object, guint prop_id, const GValue *
     case PROP_COV:
       ncm_matrix_substitute (&gauss->cov, g_value_get_object (value), TRUE);
       break;
+    case PROP_LIN_DESIGN:
+      /* Taken by reference, so that shared instances stay shared between copies. */
+      _ncm_data_gauss_cov_set_lin_design_ref (gauss, g_value_get_object (value));
+      break;
+    case PROP_LIN_MARG:
+      ncm_data_gauss_cov_set_lin_marg (gauss, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -128,6 +168,12 @@ _ncm_data_gauss_cov_get_property (GObject *object, guint prop_id, GValue *value,
     case PROP_COV:
       g_value_set_object (value, gauss->cov);
       break;
+    case PROP_LIN_DESIGN:
+      g_value_set_object (value, gauss->lin_D);
+      break;
+    case PROP_LIN_MARG:
+      g_value_set_boolean (value, gauss->lin_marg);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -144,6 +190,9 @@ _ncm_data_gauss_cov_dispose (GObject *object)
   ncm_matrix_clear (&gauss->cov);
   ncm_matrix_clear (&gauss->LLT);
 
+  ncm_matrix_clear (&gauss->lin_D);
+  ncm_data_gauss_lin_clear (&gauss->lin);
+
   /* Chain up : end */
   G_OBJECT_CLASS (ncm_data_gauss_cov_parent_class)->dispose (object);
 }
@@ -157,10 +206,12 @@ _ncm_data_gauss_cov_finalize (GObject *object)
 }
 
 static guint _ncm_data_gauss_cov_get_length (NcmData *data); 
+static guint _ncm_data_gauss_cov_get_dof (NcmData *data); 
 /* static void _ncm_data_gauss_cov_begin (NcmData *data); */
 static void _ncm_data_gauss_cov_resample (NcmData *data, NcmMSet *mset, NcmRNG *rng);
 static void _ncm_data_gauss_cov_m2lnL_val (NcmData *data, NcmMSet *mset, gdouble *m2lnL);
 static void _ncm_data_gauss_cov_leastsquares_f (NcmData *data, NcmMSet *mset, NcmVector *v);
+static void _ncm_data_gauss_cov_share_payload (NcmData *data, NcmSerialize *ser);
 static void _ncm_data_gauss_cov_set_size (NcmDataGaussCov *gauss, guint np);
 static guint _ncm_data_gauss_cov_get_size (NcmDataGaussCov *gauss);
 static void _ncm_data_gauss_cov_lnNorma2 (NcmDataGaussCov *gauss, NcmMSet *mset, gdouble *m2lnL);
@@ -210,18 +261,37 @@ ncm_data_gauss_cov_class_init (NcmDataGaussCovClass *klass)
                                                         "Data covariance",
                                                         NCM_TYPE_MATRIX,
                                                         G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+
+  g_object_class_install_property (object_class,
+                                   PROP_LIN_DESIGN,
+                                   g_param_spec_object ("lin-design",
+                                                        NULL,
+                                                        "Design matrix of the linear nuisance parameters",
+                                                        NCM_TYPE_MATRIX,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+
+  g_object_class_install_property (object_class,
+                                   PROP_LIN_MARG,
+                                   g_param_spec_boolean ("lin-marg",
+                                                         NULL,
+                                                         "Marginalize (instead of profile) the linear nuisance parameters",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
   
   data_class->bootstrap          = TRUE;
   
   data_class->get_length         = &_ncm_data_gauss_cov_get_length;
+  data_class->get_dof            = &_ncm_data_gauss_cov_get_dof;
   data_class->begin              = NULL;
 
   data_class->resample           = &_ncm_data_gauss_cov_resample;
   data_class->m2lnL_val          = &_ncm_data_gauss_cov_m2lnL_val;
   data_class->leastsquares_f     = &_ncm_data_gauss_cov_leastsquares_f;
+  data_class->share_payload      = &_ncm_data_gauss_cov_share_payload;
 
   gauss_cov_class->mean_func    = NULL;
   gauss_cov_class->cov_func     = NULL;
+  gauss_cov_class->lin_func     = NULL;
   gauss_cov_class->lnNorma2     = &_ncm_data_gauss_cov_lnNorma2;
   gauss_cov_class->lnNorma2_bs  = &_ncm_data_gauss_cov_lnNorma2_bs;
   gauss_cov_class->set_size     = &_ncm_data_gauss_cov_set_size;
@@ -234,6 +304,33 @@ _ncm_data_gauss_cov_get_length (NcmData *data)
   return NCM_DATA_GAUSS_COV (data)->np; 
 }
 
+static guint 
+_ncm_data_gauss_cov_get_dof (NcmData *data) 
+{ 
+  NcmDataGaussCov *gauss = NCM_DATA_GAUSS_COV (data);
+  const guint nlin = ncm_data_gauss_cov_lin_len (gauss);
+  
+  return (gauss->np > nlin) ? gauss->np - nlin : 0;
+}
+
+static void
+_ncm_data_gauss_cov_share_payload (NcmData *data, NcmSerialize *ser)
+{
+  NcmDataGaussCov *gauss = NCM_DATA_GAUSS_COV (data);
+  NcmDataGaussCovClass *gauss_cov_class = NCM_DATA_GAUSS_COV_GET_CLASS (gauss);
+
+  /* 
+   * Without cov_func the covariance is never written after it is set,
+   * the decomposition lives in LLT. The same holds for the design matrix
+   * without lin_func (the whitened version lives in lin).
+   */
+  if ((gauss_cov_class->cov_func == NULL) && (gauss->cov != NULL))
+    ncm_serialize_share (ser, gauss->cov);
+
+  if ((gauss_cov_class->lin_func == NULL) && (gauss->lin_D != NULL))
+    ncm_serialize_share (ser, gauss->lin_D);
+}
+
 static void
 _ncm_data_gauss_cov_prepare_LLT (NcmData *data)
 {
@@ -241,15 +338,53 @@ _ncm_data_gauss_cov_prepare_LLT (NcmData *data)
   NcmDataGaussCov *gauss = NCM_DATA_GAUSS_COV (data);
 
   if (gauss->LLT == NULL)
-    gauss->LLT = ncm_matrix_dup (gauss->cov);
-  else
-    ncm_matrix_memcpy (gauss->LLT, gauss->cov);
+    gauss->LLT = ncm_matrix_new_aligned (gauss->np, gauss->np);
+
+  ncm_matrix_memcpy (gauss->LLT, gauss->cov);
 
   ret = ncm_matrix_cholesky_decomp (gauss->LLT, 'U');
   if (ret != 0)
     g_error ("_ncm_data_gauss_cov_prepare_LLT[ncm_matrix_cholesky_decomp]: %d.", ret);
   
   gauss->prepared_LLT = TRUE;
+  gauss->prepared_lin = FALSE;
+}
+
+static void
+_ncm_data_gauss_cov_prepare_lin (NcmDataGaussCov *gauss, NcmMSet *mset)
+{
+  NcmDataGaussCovClass *gauss_cov_class = NCM_DATA_GAUSS_COV_GET_CLASS (gauss);
+  gboolean lin_update = FALSE;
+
+  if (gauss_cov_class->lin_func != NULL)
+    lin_update = gauss_cov_class->lin_func (gauss, mset, gauss->lin_D);
+
+  if (lin_update || !gauss->prepared_lin)
+  {
+    NcmMatrix *DW;
+
+    if (ncm_matrix_nrows (gauss->lin_D) != gauss->np)
+      g_error ("_ncm_data_gauss_cov_prepare_lin: design matrix has %u rows, expected %u.", 
+               ncm_matrix_nrows (gauss->lin_D), gauss->np);
+
+    DW = ncm_data_gauss_lin_peek_DW (gauss->lin, gauss->np, ncm_matrix_ncols (gauss->lin_D));
+    ncm_matrix_memcpy (DW, gauss->lin_D);
+
+    /* CblasLower, CblasNoTrans => CblasUpper, CblasTrans */
+    ncm_matrix_dtrsm (gauss->LLT, 'U', 'T', 1.0, DW);
+
+    ncm_data_gauss_lin_prepare (gauss->lin);
+    gauss->prepared_lin = TRUE;
+  }
+}
+
+static void
+_ncm_data_gauss_cov_lin_m2lnL (NcmDataGaussCov *gauss, NcmVector *bw, gdouble *m2lnL)
+{
+  ncm_data_gauss_lin_m2lnL (gauss->lin, gauss->v, bw, gauss->lin_marg, m2lnL);
+
+  if (gauss->lin_marg && gauss->use_norma)
+    *m2lnL -= ncm_matrix_ncols (gauss->lin_D) * ncm_c_ln2pi ();
 }
 
 static void
@@ -352,30 +487,37 @@ _ncm_data_gauss_cov_m2lnL_val (NcmData *data, NcmMSet *mset, gdouble *m2lnL)
 
   if (!ncm_data_bootstrap_enabled (data))
   {
-    ret = gsl_blas_ddot (ncm_vector_gsl (gauss->v),
-                         ncm_vector_gsl (gauss->v),
-                         m2lnL);
-    NCM_TEST_GSL_RESULT ("_ncm_data_gauss_cov_m2lnL_val", ret);
+    *m2lnL += ncm_vector_wsumsq (gauss->v, NULL);
 
-    if (gauss->use_norma)
+    if (gauss->lin_D != NULL)
     {
-      gauss_cov_class->lnNorma2 (gauss, mset, m2lnL);
+      _ncm_data_gauss_cov_prepare_lin (gauss, mset);
+      _ncm_data_gauss_cov_lin_m2lnL (gauss, NULL, m2lnL);
     }
+
+    if (gauss->use_norma)
+      gauss_cov_class->lnNorma2 (gauss, mset, m2lnL);
   }
   else
   {
-    const guint bsize = ncm_bootstrap_get_bsize (data->bstrap);
-    guint i;
+    NcmWorkspace *ws = ncm_workspace_peek ();
+    NcmVector *bw    = ncm_workspace_borrow_vector (ws, gauss->np);
+
     g_assert (ncm_bootstrap_is_init (data->bstrap));
 
-    for (i = 0; i < bsize; i++)
+    ncm_bootstrap_get_weights (data->bstrap, bw);
+    *m2lnL += ncm_vector_wsumsq (gauss->v, bw);
+
+    if (gauss->lin_D != NULL)
     {
-      guint k = ncm_bootstrap_get (data->bstrap, i);
-      const gdouble u_i = ncm_vector_get (gauss->v, k); 
-      *m2lnL += u_i * u_i;
-    }    
+      _ncm_data_gauss_cov_prepare_lin (gauss, mset);
+      _ncm_data_gauss_cov_lin_m2lnL (gauss, bw, m2lnL);
+    }
+
     if (gauss->use_norma)
       gauss_cov_class->lnNorma2_bs (gauss, mset, data->bstrap, m2lnL);
+
+    ncm_workspace_return_vector (ws, bw);
   }
 }
 
@@ -403,6 +545,13 @@ _ncm_data_gauss_cov_leastsquares_f (NcmData *data, NcmMSet *mset, NcmVector *v)
   ret = gsl_blas_dtrsv (CblasUpper, CblasTrans, CblasNonUnit, 
                         ncm_matrix_gsl (gauss->LLT), ncm_vector_gsl (v));
   NCM_TEST_GSL_RESULT ("_ncm_data_gauss_cov_leastsquares_f", ret);
+
+  /* Projects out the linear parameters, v <- v - D F^{-1} D^T v. */
+  if (gauss->lin_D != NULL)
+  {
+    _ncm_data_gauss_cov_prepare_lin (gauss, mset);
+    ncm_data_gauss_lin_project (gauss->lin, v);
+  }
 }
 
 static void 
@@ -421,9 +570,9 @@ _ncm_data_gauss_cov_set_size (NcmDataGaussCov *gauss, guint np)
   if ((np != 0) && (np != gauss->np))
   {
     gauss->np  = np;
-    gauss->y   = ncm_vector_new (gauss->np);
-    gauss->v   = ncm_vector_new (gauss->np);
-    gauss->cov = ncm_matrix_new (gauss->np, gauss->np);
+    gauss->y   = ncm_vector_new_aligned (gauss->np);
+    gauss->v   = ncm_vector_new_aligned (gauss->np);
+    gauss->cov = ncm_matrix_new_aligned (gauss->np, gauss->np);
     if (ncm_data_bootstrap_enabled (data))
     {
       ncm_bootstrap_set_fsize (data->bstrap, np);
@@ -467,3 +616,169 @@ ncm_data_gauss_cov_get_size (NcmDataGaussCov *gauss)
 {
   return NCM_DATA_GAUSS_COV_GET_CLASS (gauss)->get_size (gauss);
 }
+
+/**
+ * ncm_data_gauss_cov_set_lin_design:
+ * @gauss: a #NcmDataGaussCov
+ * @D: (allow-none): a #NcmMatrix
+ *
+ * Sets the design matrix @D ($n_p\times n_a$) of the nuisance parameters
+ * $a$ entering the mean linearly. These parameters are then profiled or
+ * marginalized analytically, see ncm_data_gauss_cov_set_lin_marg(). 
+ * The object keeps its own copy of @D, later changes to @D are not seen.
+ * If the subclass implements #NcmDataGaussCovClass.lin_func, the copy is 
+ * updated by it before each evaluation. Passing NULL disables the 
+ * linear nuisance parameters.
+ * 
+ */
+void 
+ncm_data_gauss_cov_set_lin_design (NcmDataGaussCov *gauss, NcmMatrix *D)
+{
+  if (D != NULL)
+  {
+    NcmMatrix *D_cp = ncm_matrix_dup (D);
+
+    _ncm_data_gauss_cov_set_lin_design_ref (gauss, D_cp);
+    ncm_matrix_free (D_cp);
+  }
+  else
+    _ncm_data_gauss_cov_set_lin_design_ref (gauss, NULL);
+}
+
+/**
+ * ncm_data_gauss_cov_peek_lin_design:
+ * @gauss: a #NcmDataGaussCov
+ *
+ * Returns: (transfer none) (allow-none): the design matrix of the linear nuisance parameters.
+ */
+NcmMatrix *
+ncm_data_gauss_cov_peek_lin_design (NcmDataGaussCov *gauss)
+{
+  return gauss->lin_D;
+}
+
+/**
+ * ncm_data_gauss_cov_set_lin_marg:
+ * @gauss: a #NcmDataGaussCov
+ * @lin_marg: whether to marginalize the linear nuisance parameters
+ *
+ * If @lin_marg is TRUE the linear nuisance parameters are marginalized
+ * assuming a flat prior, otherwise they are set to their best fit values
+ * (profiled). The least squares residuals are always the profiled ones.
+ * 
+ */
+void 
+ncm_data_gauss_cov_set_lin_marg (NcmDataGaussCov *gauss, gboolean lin_marg)
+{
+  gauss->lin_marg = lin_marg;
+}
+
+/**
+ * ncm_data_gauss_cov_get_lin_marg:
+ * @gauss: a #NcmDataGaussCov
+ *
+ * Returns: whether the linear nuisance parameters are marginalized.
+ */
+gboolean 
+ncm_data_gauss_cov_get_lin_marg (NcmDataGaussCov *gauss)
+{
+  return gauss->lin_marg;
+}
+
+/**
+ * ncm_data_gauss_cov_lin_len:
+ * @gauss: a #NcmDataGaussCov
+ *
+ * Returns: the number of linear nuisance parameters (zero if disabled).
+ */
+guint 
+ncm_data_gauss_cov_lin_len (NcmDataGaussCov *gauss)
+{
+  return (gauss->lin_D != NULL) ? ncm_matrix_ncols (gauss->lin_D) : 0;
+}
+
+/**
+ * ncm_data_gauss_cov_eval_mean:
+ * @gauss: a #NcmDataGaussCov
+ * @mset: a #NcmMSet
+ * @mu: a #NcmVector
+ *
+ * Prepares @gauss using @mset and evaluates the theoretical mean 
+ * into @mu, which must have the same size as the data.
+ * 
+ */
+void 
+ncm_data_gauss_cov_eval_mean (NcmDataGaussCov *gauss, NcmMSet *mset, NcmVector *mu)
+{
+  g_assert_cmpuint (ncm_vector_len (mu), ==, gauss->np);
+
+  ncm_data_prepare (NCM_DATA (gauss), mset);
+  NCM_DATA_GAUSS_COV_GET_CLASS (gauss)->mean_func (gauss, mset, mu);
+}
+
+/**
+ * ncm_data_gauss_cov_has_cov_func:
+ * @gauss: a #NcmDataGaussCov
+ *
+ * Returns: whether the covariance of @gauss depends on the models, 
+ * i.e., whether #NcmDataGaussCovClass.cov_func is implemented.
+ */
+gboolean 
+ncm_data_gauss_cov_has_cov_func (NcmDataGaussCov *gauss)
+{
+  return (NCM_DATA_GAUSS_COV_GET_CLASS (gauss)->cov_func != NULL);
+}
+
+/**
+ * ncm_data_gauss_cov_eval_cov:
+ * @gauss: a #NcmDataGaussCov
+ * @mset: a #NcmMSet
+ * @cov: a #NcmMatrix
+ *
+ * Prepares @gauss using @mset and copies the covariance matrix 
+ * evaluated at @mset into @cov. When the covariance does not depend 
+ * on the models this is just a copy of the data covariance.
+ * 
+ */
+void 
+ncm_data_gauss_cov_eval_cov (NcmDataGaussCov *gauss, NcmMSet *mset, NcmMatrix *cov)
+{
+  NcmDataGaussCovClass *gauss_cov_class = NCM_DATA_GAUSS_COV_GET_CLASS (gauss);
+
+  ncm_data_prepare (NCM_DATA (gauss), mset);
+
+  /* cov_func may skip the evaluation when the models did not change, so it is always called on gauss->cov. */
+  if ((gauss_cov_class->cov_func != NULL) && gauss_cov_class->cov_func (gauss, mset, gauss->cov))
+    gauss->prepared_LLT = FALSE;
+
+  ncm_matrix_memcpy (cov, gauss->cov);
+}
+
+/**
+ * ncm_data_gauss_cov_peek_cholesky:
+ * @gauss: a #NcmDataGaussCov
+ * @mset: a #NcmMSet
+ *
+ * Prepares @gauss using @mset and returns the Cholesky decomposition 
+ * of the covariance matrix, as used in the likelihood evaluation. The 
+ * upper triangle of the returned matrix contains $U$ such that 
+ * $U^TU = C$.
+ * 
+ * Returns: (transfer none): the Cholesky decomposition of the covariance.
+ */
+NcmMatrix *
+ncm_data_gauss_cov_peek_cholesky (NcmDataGaussCov *gauss, NcmMSet *mset)
+{
+  NcmDataGaussCovClass *gauss_cov_class = NCM_DATA_GAUSS_COV_GET_CLASS (gauss);
+  gboolean cov_update = FALSE;
+
+  ncm_data_prepare (NCM_DATA (gauss), mset);
+
+  if (gauss_cov_class->cov_func != NULL)
+    cov_update = gauss_cov_class->cov_func (gauss, mset, gauss->cov);
+
+  if (cov_update || !gauss->prepared_LLT)
+    _ncm_data_gauss_cov_prepare_LLT (NCM_DATA (gauss));
+
+  return gauss->LLT;
+}
@@ -30,6 +30,7 @@
 #include <glib-object.h>
 #include <numcosmo/build_cfg.h>
 #include <numcosmo/math/ncm_data.h>
+#include <numcosmo/math/ncm_data_gauss_lin.h>
 #include <numcosmo/math/ncm_bootstrap.h>
 
 G_BEGIN_DECLS
@@ -50,6 +51,7 @@ struct _NcmDataGaussCovClass
   NcmDataClass parent_class;
   void (*mean_func) (NcmDataGaussCov *gauss, NcmMSet *mset, NcmVector *vp);
   gboolean (*cov_func) (NcmDataGaussCov *gauss, NcmMSet *mset, NcmMatrix *cov);
+  gboolean (*lin_func) (NcmDataGaussCov *gauss, NcmMSet *mset, NcmMatrix *D);
   void (*lnNorma2) (NcmDataGaussCov *gauss, NcmMSet *mset, gdouble *m2lnL);
   void (*lnNorma2_bs) (NcmDataGaussCov *gauss, NcmMSet *mset, NcmBootstrap *bstrap, gdouble *m2lnL);
   void (*set_size) (NcmDataGaussCov *gauss, guint np);
@@ -67,6 +69,10 @@ struct _NcmDataGaussCov
   NcmMatrix *LLT;
   gboolean prepared_LLT;
   gboolean use_norma;
+  NcmMatrix *lin_D;
+  NcmDataGaussLin *lin;
+  gboolean lin_marg;
+  gboolean prepared_lin;
 };
 
 GType ncm_data_gauss_cov_get_type (void) G_GNUC_CONST;
@@ -74,6 +80,17 @@ GType ncm_data_gauss_cov_get_type (void) G_GNUC_CONST;
 void ncm_data_gauss_cov_set_size (NcmDataGaussCov *gauss, guint np);
 guint ncm_data_gauss_cov_get_size (NcmDataGaussCov *gauss);
 
+void ncm_data_gauss_cov_set_lin_design (NcmDataGaussCov *gauss, NcmMatrix *D);
+NcmMatrix *ncm_data_gauss_cov_peek_lin_design (NcmDataGaussCov *gauss);
+void ncm_data_gauss_cov_set_lin_marg (NcmDataGaussCov *gauss, gboolean lin_marg);
+gboolean ncm_data_gauss_cov_get_lin_marg (NcmDataGaussCov *gauss);
+guint ncm_data_gauss_cov_lin_len (NcmDataGaussCov *gauss);
+
+void ncm_data_gauss_cov_eval_mean (NcmDataGaussCov *gauss, NcmMSet *mset, NcmVector *mu);
+gboolean ncm_data_gauss_cov_has_cov_func (NcmDataGaussCov *gauss);
+void ncm_data_gauss_cov_eval_cov (NcmDataGaussCov *gauss, NcmMSet *mset, NcmMatrix *cov);
+NcmMatrix *ncm_data_gauss_cov_peek_cholesky (NcmDataGaussCov *gauss, NcmMSet *mset);
+
 G_END_DECLS
 
 #endif /* _NCM_DATA_GAUSS_COV_H_ */
@@ -29,6 +29,12 @@
  * @short_description: Gaussian data -- diagonal covariance provided.
  *
  * Gaussian distribution which uses a diagonal covariance matrix as input.
+ *
+ * As in #NcmDataGaussCov, nuisance parameters entering the mean linearly
+ * can be profiled or marginalized analytically by providing their design
+ * matrix, see ncm_data_gauss_diag_set_lin_design(). The property
+ * #NcmDataGaussDiag:w-mean is the particular case of a single constant 
+ * offset and cannot be used together with a design matrix.
  * 
  */
 
@@ -39,6 +45,8 @@
 
 #include "math/ncm_data_gauss_diag.h"
 #include "math/ncm_cfg.h"
+#include "math/ncm_util.h"
+#include "math/ncm_workspace.h"
 
 #include <gsl/gsl_linalg.h>
 #include <gsl/gsl_blas.h>
@@ -52,6 +60,8 @@ enum
   PROP_WMEAN,
   PROP_MEAN,
   PROP_SIGMA,
+  PROP_LIN_DESIGN,
+  PROP_LIN_MARG,
   PROP_SIZE,
 };
 
@@ -68,6 +78,11 @@ ncm_data_gauss_diag_init (NcmDataGaussDiag *diag)
   diag->wt         = 0.0;
   diag->prepared_w = FALSE;
   diag->wmean      = FALSE;
+
+  diag->lin_D        = NULL;
+  diag->lin          = ncm_data_gauss_lin_new ();
+  diag->lin_marg     = FALSE;
+  diag->prepared_lin = FALSE;
 }
 
 static void
@@ -78,6 +93,16 @@ _ncm_data_gauss_diag_constructed (GObject *object)
 
 }
 
+static void
+_ncm_data_gauss_diag_set_lin_design_ref (NcmDataGaussDiag *diag, NcmMatrix *D)
+{
+  if (D != NULL)
+    g_assert_cmpuint (ncm_matrix_ncols (D), >, 0);
+
+  ncm_matrix_substitute (&diag->lin_D, D, FALSE);
+  diag->prepared_lin = FALSE;
+}
+
 static void
 ncm_data_gauss_diag_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
 {
@@ -98,6 +123,13 @@ ncm_data_gauss_diag_set_property (GObject *object, guint prop_id, const GValue *
     case PROP_SIGMA:
       ncm_vector_substitute (&diag->sigma, g_value_get_object (value), TRUE);
       break;
+    case PROP_LIN_DESIGN:
+      /* Taken by reference, so that shared instances stay shared between copies. */
+      _ncm_data_gauss_diag_set_lin_design_ref (diag, g_value_get_object (value));
+      break;
+    case PROP_LIN_MARG:
+      ncm_data_gauss_diag_set_lin_marg (diag, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -124,6 +156,12 @@ ncm_data_gauss_diag_get_property (GObject *object, guint prop_id, GValue *value,
     case PROP_SIGMA:
       g_value_set_object (value, diag->sigma);
       break;
+    case PROP_LIN_DESIGN:
+      g_value_set_object (value, diag->lin_D);
+      break;
+    case PROP_LIN_MARG:
+      g_value_set_boolean (value, diag->lin_marg);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -140,6 +178,9 @@ ncm_data_gauss_diag_dispose (GObject *object)
   ncm_vector_clear (&diag->sigma);
   ncm_vector_clear (&diag->weight);
 
+  ncm_matrix_clear (&diag->lin_D);
+  ncm_data_gauss_lin_clear (&diag->lin);
+
   /* Chain up : end */
   G_OBJECT_CLASS (ncm_data_gauss_diag_parent_class)->dispose (object);
 }
@@ -158,6 +199,7 @@ static guint _ncm_data_gauss_diag_get_dof (NcmData *data);
 static void _ncm_data_gauss_diag_resample (NcmData *data, NcmMSet *mset, NcmRNG *rng);
 static void _ncm_data_gauss_diag_m2lnL_val (NcmData *data, NcmMSet *mset, gdouble *m2lnL);
 static void _ncm_data_gauss_diag_leastsquares_f (NcmData *data, NcmMSet *mset, NcmVector *v);
+static void _ncm_data_gauss_diag_share_payload (NcmData *data, NcmSerialize *ser);
 static void _ncm_data_gauss_diag_set_size (NcmDataGaussDiag *diag, guint np);
 static guint _ncm_data_gauss_diag_get_size (NcmDataGaussDiag *diag);
 
@@ -205,6 +247,22 @@ ncm_data_gauss_diag_class_init (NcmDataGaussDiagClass *klass)
                                                         "Data standard deviation",
                                                         NCM_TYPE_VECTOR,
                                                         G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+
+  g_object_class_install_property (object_class,
+                                   PROP_LIN_DESIGN,
+                                   g_param_spec_object ("lin-design",
+                                                        NULL,
+                                                        "Design matrix of the linear nuisance parameters",
+                                                        NCM_TYPE_MATRIX,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+
+  g_object_class_install_property (object_class,
+                                   PROP_LIN_MARG,
+                                   g_param_spec_boolean ("lin-marg",
+                                                         NULL,
+                                                         "Marginalize (instead of profile) the linear nuisance parameters",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
   
   data_class->bootstrap        = TRUE;
   data_class->get_length       = &_ncm_data_gauss_diag_get_length;
@@ -212,9 +270,11 @@ ncm_data_gauss_diag_class_init (NcmDataGaussDiagClass *klass)
   data_class->resample         = &_ncm_data_gauss_diag_resample;
   data_class->m2lnL_val        = &_ncm_data_gauss_diag_m2lnL_val;
   data_class->leastsquares_f   = &_ncm_data_gauss_diag_leastsquares_f;
+  data_class->share_payload    = &_ncm_data_gauss_diag_share_payload;
 
   gauss_diag_class->mean_func  = NULL;
   gauss_diag_class->sigma_func = NULL;
+  gauss_diag_class->lin_func   = NULL;
   gauss_diag_class->set_size   = &_ncm_data_gauss_diag_set_size;
   gauss_diag_class->get_size   = &_ncm_data_gauss_diag_get_size;
 }
@@ -229,9 +289,23 @@ static guint
 _ncm_data_gauss_diag_get_dof (NcmData *data) 
 { 
   guint dof = NCM_DATA_GAUSS_DIAG (data)->np;
+  const guint nlin = ncm_data_gauss_diag_lin_len (NCM_DATA_GAUSS_DIAG (data));
   if (NCM_DATA_GAUSS_DIAG (data)->wmean && dof > 0)
     dof--;
-  return dof;
+  return (dof > nlin) ? dof - nlin : 0;
+}
+
+static void
+_ncm_data_gauss_diag_share_payload (NcmData *data, NcmSerialize *ser)
+{
+  NcmDataGaussDiag *diag = NCM_DATA_GAUSS_DIAG (data);
+  NcmDataGaussDiagClass *gauss_diag_class = NCM_DATA_GAUSS_DIAG_GET_CLASS (diag);
+
+  if ((gauss_diag_class->sigma_func == NULL) && (diag->sigma != NULL))
+    ncm_serialize_share (ser, diag->sigma);
+
+  if ((gauss_diag_class->lin_func == NULL) && (diag->lin_D != NULL))
+    ncm_serialize_share (ser, diag->lin_D);
 }
 
 static void
@@ -241,7 +315,7 @@ _ncm_data_gauss_prepare_weight (NcmData *data)
   guint i;
 
   if (diag->weight == NULL)
-    diag->weight = ncm_vector_new (diag->np);
+    diag->weight = ncm_vector_new_aligned (diag->np);
 
   diag->wt = 0.0;
   for (i = 0; i < diag->np; i++)
@@ -255,6 +329,68 @@ _ncm_data_gauss_prepare_weight (NcmData *data)
   diag->prepared_w = TRUE;
 }
 
+static void
+_ncm_data_gauss_diag_prepare_lin (NcmDataGaussDiag *diag, NcmMSet *mset, gboolean sigma_update)
+{
+  NcmDataGaussDiagClass *gauss_diag_class = NCM_DATA_GAUSS_DIAG_GET_CLASS (diag);
+  gboolean lin_update = FALSE;
+
+  if (diag->wmean)
+    g_error ("_ncm_data_gauss_diag_prepare_lin: w-mean cannot be used together with a design matrix.");
+
+  if (gauss_diag_class->lin_func != NULL)
+    lin_update = gauss_diag_class->lin_func (diag, mset, diag->lin_D);
+
+  if (lin_update || sigma_update || !diag->prepared_lin)
+  {
+    const guint nlin = ncm_matrix_ncols (diag->lin_D);
+    NcmMatrix *DW;
+    guint i, a;
+
+    if (ncm_matrix_nrows (diag->lin_D) != diag->np)
+      g_error ("_ncm_data_gauss_diag_prepare_lin: design matrix has %u rows, expected %u.", 
+               ncm_matrix_nrows (diag->lin_D), diag->np);
+
+    DW = ncm_data_gauss_lin_peek_DW (diag->lin, diag->np, nlin);
+
+    for (i = 0; i < diag->np; i++)
+    {
+      const gdouble sigma_i = ncm_vector_get (diag->sigma, i);
+      for (a = 0; a < nlin; a++)
+        ncm_matrix_set (DW, i, a, ncm_matrix_get (diag->lin_D, i, a) / sigma_i);
+    }
+
+    ncm_data_gauss_lin_prepare (diag->lin);
+    diag->prepared_lin = TRUE;
+  }
+}
+
+static void
+_ncm_data_gauss_diag_lin_m2lnL_val (NcmDataGaussDiag *diag, NcmMSet *mset, gboolean sigma_update, gdouble *m2lnL)
+{
+  NcmData *data    = NCM_DATA (diag);
+  NcmWorkspace *ws = ncm_workspace_peek ();
+  NcmVector *bw    = NULL;
+
+  _ncm_data_gauss_diag_prepare_lin (diag, mset, sigma_update);
+
+  ncm_vector_sub (diag->v, diag->y);
+  ncm_vector_div (diag->v, diag->sigma);
+
+  if (ncm_data_bootstrap_enabled (data))
+  {
+    bw = ncm_workspace_borrow_vector (ws, diag->np);
+    ncm_bootstrap_get_weights (data->bstrap, bw);
+  }
+
+  *m2lnL += ncm_vector_wsumsq (diag->v, bw);
+
+  ncm_data_gauss_lin_m2lnL (diag->lin, diag->v, bw, diag->lin_marg, m2lnL);
+
+  if (bw != NULL)
+    ncm_workspace_return_vector (ws, bw);
+}
+
 static void
 _ncm_data_gauss_diag_resample (NcmData *data, NcmMSet *mset, NcmRNG *rng)
 {
@@ -292,73 +428,65 @@ _ncm_data_gauss_diag_m2lnL_val (NcmData *data, NcmMSet *mset, gdouble *m2lnL)
 
   gauss_diag_class->mean_func (diag, mset, diag->v);
 
-  if (diag->wmean)
+  if (diag->lin_D != NULL)
+  {
+    _ncm_data_gauss_diag_lin_m2lnL_val (diag, mset, sigma_update, m2lnL);
+  }
+  else if (diag->wmean)
   {
+    gdouble rw;
+    gint ret;
+
     if (sigma_update || !diag->prepared_w)
       _ncm_data_gauss_prepare_weight (data);
 
+    ncm_vector_sub (diag->v, diag->y);
+
     if (!ncm_data_bootstrap_enabled (data))
     {
-      gdouble tmp = 0.0;
+      ret = gsl_blas_ddot (ncm_vector_gsl (diag->v), ncm_vector_gsl (diag->weight), &rw);
+      NCM_TEST_GSL_RESULT ("_ncm_data_gauss_diag_m2lnL_val", ret);
 
-      for (i = 0; i < diag->np; i++)
-      {
-        const gdouble y_i = ncm_vector_get (diag->y, i);
-        const gdouble yt_i = ncm_vector_get (diag->v, i);
-        const gdouble r_i = (yt_i - y_i);
-        const gdouble w_i = ncm_vector_get (diag->weight, i);
-        const gdouble r_i2 = r_i * r_i;
-        *m2lnL += r_i2 * w_i;
-        tmp += r_i * w_i;
-      }
-      *m2lnL -= tmp * tmp / diag->wt;
+      *m2lnL = ncm_vector_wsumsq (diag->v, diag->weight) - rw * rw / diag->wt;
     }
     else
     {
-      const guint bsize = ncm_bootstrap_get_bsize (data->bstrap);
-      gdouble tmp = 0.0;
-      gdouble wt = 0.0;
-      
-      for (i = 0; i < bsize; i++)
-      {
-        guint k = ncm_bootstrap_get (data->bstrap, i);
-        const gdouble y_k = ncm_vector_get (diag->y, k);
-        const gdouble yt_k = ncm_vector_get (diag->v, k);
-        const gdouble r_k = (yt_k - y_k);
-        const gdouble w_k = ncm_vector_get (diag->weight, k);
-        const gdouble r_k2 = r_k * r_k;
-        *m2lnL += r_k2 * w_k;
-        tmp += r_k * w_k;
-        wt += w_k;
-      }
-      *m2lnL -= tmp * tmp / wt;
+      NcmWorkspace *ws = ncm_workspace_peek ();
+      NcmVector *bw    = ncm_workspace_borrow_vector (ws, diag->np);
+      gdouble wt;
+
+      /* Weights times the bootstrap multiplicities. */
+      ncm_bootstrap_get_weights (data->bstrap, bw);
+      for (i = 0; i < diag->np; i++)
+        ncm_vector_mulby (bw, i, ncm_vector_get (diag->weight, i));
+
+      wt  = ncm_vector_sum_cpts (bw);
+      ret = gsl_blas_ddot (ncm_vector_gsl (diag->v), ncm_vector_gsl (bw), &rw);
+      NCM_TEST_GSL_RESULT ("_ncm_data_gauss_diag_m2lnL_val", ret);
+
+      *m2lnL = ncm_vector_wsumsq (diag->v, bw) - rw * rw / wt;
+
+      ncm_workspace_return_vector (ws, bw);
     }
   }
   else
   {
+    ncm_vector_sub (diag->v, diag->y);
+    ncm_vector_div (diag->v, diag->sigma);
+
     if (!ncm_data_bootstrap_enabled (data))
     {
-      for (i = 0; i < diag->np; i++)
-      {
-        const gdouble y_i = ncm_vector_get (diag->y, i);
-        const gdouble yt_i = ncm_vector_get (diag->v, i);
-        const gdouble sigma_i = ncm_vector_get (diag->sigma, i);
-        const gdouble r_i = (yt_i - y_i) / sigma_i;
-        *m2lnL += r_i * r_i;
-      }
+      *m2lnL = ncm_vector_wsumsq (diag->v, NULL);
     }
     else
     {
-      const guint bsize = ncm_bootstrap_get_bsize (data->bstrap);
-      for (i = 0; i < bsize; i++)
-      {
-        guint k = ncm_bootstrap_get (data->bstrap, i);
-        const gdouble y_k = ncm_vector_get (diag->y, k);
-        const gdouble yt_k = ncm_vector_get (diag->v, k);
-        const gdouble sigma_k = ncm_vector_get (diag->sigma, k);
-        const gdouble r_k = (yt_k - y_k) / sigma_k;
-        *m2lnL += r_k * r_k;
-      }
+      NcmWorkspace *ws = ncm_workspace_peek ();
+      NcmVector *bw    = ncm_workspace_borrow_vector (ws, diag->np);
+
+      ncm_bootstrap_get_weights (data->bstrap, bw);
+      *m2lnL = ncm_vector_wsumsq (diag->v, bw);
+
+      ncm_workspace_return_vector (ws, bw);
     }
   }
 }
@@ -369,7 +497,6 @@ _ncm_data_gauss_diag_leastsquares_f (NcmData *data, NcmMSet *mset, NcmVector *v)
   NcmDataGaussDiag *diag = NCM_DATA_GAUSS_DIAG (data);
   NcmDataGaussDiagClass *gauss_diag_class = NCM_DATA_GAUSS_DIAG_GET_CLASS (diag);
   gboolean sigma_update = FALSE;
-  guint i;
 
   if (ncm_data_bootstrap_enabled (data))
     g_error ("NcmDataGaussDiag: does not support bootstrap with least squares");
@@ -393,22 +520,19 @@ _ncm_data_gauss_diag_leastsquares_f (NcmData *data, NcmMSet *mset, NcmVector *v)
                              ncm_vector_gsl (v)->stride,
                              ncm_vector_gsl (v)->size);
 
-    for (i = 0; i < diag->np; i++)
-    {
-      const gdouble sigma_i = ncm_vector_get (diag->sigma, i);
-      const gdouble v_i = ncm_vector_get (v, i);
-      ncm_vector_set (v, i, (v_i - wmean) / sigma_i);
-    }
+    ncm_vector_add_constant (v, -wmean);
+    ncm_vector_div (v, diag->sigma);
   }
   else
   {
-    for (i = 0; i < diag->np; i++)
+    ncm_vector_sub (v, diag->y);
+    ncm_vector_div (v, diag->sigma);
+
+    /* Projects out the linear parameters, v <- v - D F^{-1} D^T v. */
+    if (diag->lin_D != NULL)
     {
-      const gdouble y_i = ncm_vector_get (diag->y, i);
-      const gdouble yt_i = ncm_vector_get (v, i);
-      const gdouble sigma_i = ncm_vector_get (diag->sigma, i);
-      const gdouble r_i = (yt_i - y_i) / sigma_i;
-      ncm_vector_set (v, i, r_i);
+      _ncm_data_gauss_diag_prepare_lin (diag, mset, sigma_update);
+      ncm_data_gauss_lin_project (diag->lin, v);
     }
   }
 }
@@ -429,9 +553,9 @@ _ncm_data_gauss_diag_set_size (NcmDataGaussDiag *diag, guint np)
   if ((np != 0) && (np != diag->np))
   {
     diag->np    = np;
-    diag->y     = ncm_vector_new (diag->np);
-    diag->v     = ncm_vector_new (diag->np);
-    diag->sigma = ncm_vector_new (diag->np);
+    diag->y     = ncm_vector_new_aligned (diag->np);
+    diag->v     = ncm_vector_new_aligned (diag->np);
+    diag->sigma = ncm_vector_new_aligned (diag->np);
     if (ncm_data_bootstrap_enabled (data))
     {
       ncm_bootstrap_set_fsize (data->bstrap, np);
@@ -475,3 +599,137 @@ ncm_data_gauss_diag_get_size (NcmDataGaussDiag *diag)
 {
   return NCM_DATA_GAUSS_DIAG_GET_CLASS (diag)->get_size (diag);
 }
+
+/**
+ * ncm_data_gauss_diag_set_lin_design:
+ * @diag: a #NcmDataGaussDiag
+ * @D: (allow-none): a #NcmMatrix
+ *
+ * Sets the design matrix @D ($n_p\times n_a$) of the nuisance parameters
+ * entering the mean linearly, see ncm_data_gauss_cov_set_lin_design().
+ * @D is copied. Passing NULL disables the linear nuisance parameters.
+ * 
+ */
+void 
+ncm_data_gauss_diag_set_lin_design (NcmDataGaussDiag *diag, NcmMatrix *D)
+{
+  if (D != NULL)
+  {
+    NcmMatrix *D_cp = ncm_matrix_dup (D);
+
+    _ncm_data_gauss_diag_set_lin_design_ref (diag, D_cp);
+    ncm_matrix_free (D_cp);
+  }
+  else
+    _ncm_data_gauss_diag_set_lin_design_ref (diag, NULL);
+}
+
+/**
+ * ncm_data_gauss_diag_peek_lin_design:
+ * @diag: a #NcmDataGaussDiag
+ *
+ * Returns: (transfer none) (allow-none): the design matrix of the linear nuisance parameters.
+ */
+NcmMatrix *
+ncm_data_gauss_diag_peek_lin_design (NcmDataGaussDiag *diag)
+{
+  return diag->lin_D;
+}
+
+/**
+ * ncm_data_gauss_diag_set_lin_marg:
+ * @diag: a #NcmDataGaussDiag
+ * @lin_marg: whether to marginalize the linear nuisance parameters
+ *
+ * If @lin_marg is TRUE the linear nuisance parameters are marginalized
+ * assuming a flat prior, otherwise they are profiled.
+ * 
+ */
+void 
+ncm_data_gauss_diag_set_lin_marg (NcmDataGaussDiag *diag, gboolean lin_marg)
+{
+  diag->lin_marg = lin_marg;
+}
+
+/**
+ * ncm_data_gauss_diag_get_lin_marg:
+ * @diag: a #NcmDataGaussDiag
+ *
+ * Returns: whether the linear nuisance parameters are marginalized.
+ */
+gboolean 
+ncm_data_gauss_diag_get_lin_marg (NcmDataGaussDiag *diag)
+{
+  return diag->lin_marg;
+}
+
+/**
+ * ncm_data_gauss_diag_lin_len:
+ * @diag: a #NcmDataGaussDiag
+ *
+ * Returns: the number of linear nuisance parameters (zero if disabled).
+ */
+guint 
+ncm_data_gauss_diag_lin_len (NcmDataGaussDiag *diag)
+{
+  return (diag->lin_D != NULL) ? ncm_matrix_ncols (diag->lin_D) : 0;
+}
+
+/**
+ * ncm_data_gauss_diag_eval_mean:
+ * @diag: a #NcmDataGaussDiag
+ * @mset: a #NcmMSet
+ * @mu: a #NcmVector
+ *
+ * Prepares @diag using @mset and evaluates the theoretical mean 
+ * into @mu, which must have the same size as the data.
+ * 
+ */
+void 
+ncm_data_gauss_diag_eval_mean (NcmDataGaussDiag *diag, NcmMSet *mset, NcmVector *mu)
+{
+  g_assert_cmpuint (ncm_vector_len (mu), ==, diag->np);
+
+  ncm_data_prepare (NCM_DATA (diag), mset);
+  NCM_DATA_GAUSS_DIAG_GET_CLASS (diag)->mean_func (diag, mset, mu);
+}
+
+/**
+ * ncm_data_gauss_diag_has_sigma_func:
+ * @diag: a #NcmDataGaussDiag
+ *
+ * Returns: whether the standard deviations of @diag depend on the models, 
+ * i.e., whether #NcmDataGaussDiagClass.sigma_func is implemented.
+ */
+gboolean 
+ncm_data_gauss_diag_has_sigma_func (NcmDataGaussDiag *diag)
+{
+  return (NCM_DATA_GAUSS_DIAG_GET_CLASS (diag)->sigma_func != NULL);
+}
+
+/**
+ * ncm_data_gauss_diag_eval_sigma:
+ * @diag: a #NcmDataGaussDiag
+ * @mset: a #NcmMSet
+ * @sigma: a #NcmVector
+ *
+ * Prepares @diag using @mset and copies the standard deviations 
+ * evaluated at @mset into @sigma.
+ * 
+ */
+void 
+ncm_data_gauss_diag_eval_sigma (NcmDataGaussDiag *diag, NcmMSet *mset, NcmVector *sigma)
+{
+  NcmDataGaussDiagClass *gauss_diag_class = NCM_DATA_GAUSS_DIAG_GET_CLASS (diag);
+
+  ncm_data_prepare (NCM_DATA (diag), mset);
+
+  /* The cached weights and design are rebuilt by the next evaluation. */
+  if ((gauss_diag_class->sigma_func != NULL) && gauss_diag_class->sigma_func (diag, mset, diag->sigma))
+  {
+    diag->prepared_w   = FALSE;
+    diag->prepared_lin = FALSE;
+  }
+
+  ncm_vector_memcpy (sigma, diag->sigma);
+}
@@ -30,6 +30,7 @@
 #include <glib-object.h>
 #include <numcosmo/build_cfg.h>
 #include <numcosmo/math/ncm_data.h>
+#include <numcosmo/math/ncm_data_gauss_lin.h>
 
 G_BEGIN_DECLS
 
@@ -49,6 +50,7 @@ struct _NcmDataGaussDiagClass
   NcmDataClass parent_class;
   void (*mean_func) (NcmDataGaussDiag *diag, NcmMSet *mset, NcmVector *vp);
   gboolean (*sigma_func) (NcmDataGaussDiag *diag, NcmMSet *mset, NcmVector *var);
+  gboolean (*lin_func) (NcmDataGaussDiag *diag, NcmMSet *mset, NcmMatrix *D);
   void (*set_size) (NcmDataGaussDiag *diag, guint np);
   guint (*get_size) (NcmDataGaussDiag *diag);
 };
@@ -65,6 +67,10 @@ struct _NcmDataGaussDiag
   gdouble wt;
   gboolean prepared_w;
   gboolean wmean;
+  NcmMatrix *lin_D;
+  NcmDataGaussLin *lin;
+  gboolean lin_marg;
+  gboolean prepared_lin;
 };
 
 GType ncm_data_gauss_diag_get_type (void) G_GNUC_CONST;
@@ -72,6 +78,16 @@ GType ncm_data_gauss_diag_get_type (void) G_GNUC_CONST;
 void ncm_data_gauss_diag_set_size (NcmDataGaussDiag *diag, guint np);
 guint ncm_data_gauss_diag_get_size (NcmDataGaussDiag *diag);
 
+void ncm_data_gauss_diag_set_lin_design (NcmDataGaussDiag *diag, NcmMatrix *D);
+NcmMatrix *ncm_data_gauss_diag_peek_lin_design (NcmDataGaussDiag *diag);
+void ncm_data_gauss_diag_set_lin_marg (NcmDataGaussDiag *diag, gboolean lin_marg);
+gboolean ncm_data_gauss_diag_get_lin_marg (NcmDataGaussDiag *diag);
+guint ncm_data_gauss_diag_lin_len (NcmDataGaussDiag *diag);
+
+void ncm_data_gauss_diag_eval_mean (NcmDataGaussDiag *diag, NcmMSet *mset, NcmVector *mu);
+gboolean ncm_data_gauss_diag_has_sigma_func (NcmDataGaussDiag *diag);
+void ncm_data_gauss_diag_eval_sigma (NcmDataGaussDiag *diag, NcmMSet *mset, NcmVector *sigma);
+
 G_END_DECLS
 
 #endif /* _NCM_DATA_GAUSS_DIAG_H_ */
@@ -0,0 +1,284 @@
+/***************************************************************************
+ *            ncm_data_gauss_lin.c
+ *
+ *  Mon October 19 19:41:20 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_data_gauss_lin.c
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:ncm_data_gauss_lin
+ * @title: NcmDataGaussLin
+ * @short_description: Linear parameters of Gaussian likelihoods.
+ *
+ * Common code of #NcmDataGaussCov and #NcmDataGaussDiag for the nuisance
+ * parameters that enter the mean linearly, $\mu \to \mu + D\,p$. Given
+ * the whitened design matrix $D_W = L^{-1}D$ and residual $r = L^{-1}(\mu
+ * - y)$, where $LL^\intercal$ is the covariance, the parameters are
+ * removed in closed form: with $F = D_W^\intercal B D_W$ and $b =
+ * D_W^\intercal B r$, where $B$ contains the bootstrap multiplicities
+ * (identity without bootstrap), the profiled $-2\ln(L)$ is $r^\intercal
+ * B r - b^\intercal F^{-1} b$ and the flat-prior marginal adds $\ln\det F$.
+ *
+ * The owner fills the matrix returned by ncm_data_gauss_lin_peek_DW()
+ * and calls ncm_data_gauss_lin_prepare(), which computes and keeps the
+ * Cholesky decomposition of $F$. This decomposition is reused by every
+ * evaluation without bootstrap until the design matrix or the covariance
+ * change, with bootstrap the weighted $F$ is decomposed at each call.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif /* HAVE_CONFIG_H */
+#include "build_cfg.h"
+
+#include "math/ncm_data_gauss_lin.h"
+#include "math/ncm_util.h"
+#include "math/ncm_workspace.h"
+
+#include <gsl/gsl_blas.h>
+
+/**
+ * ncm_data_gauss_lin_new: (skip)
+ *
+ * Creates a new empty #NcmDataGaussLin.
+ *
+ * Returns: a new #NcmDataGaussLin.
+ */
+NcmDataGaussLin *
+ncm_data_gauss_lin_new (void)
+{
+  NcmDataGaussLin *lin = g_slice_new (NcmDataGaussLin);
+
+  lin->DW       = NULL;
+  lin->F        = NULL;
+  lin->Fb       = NULL;
+  lin->b        = NULL;
+  lin->prepared = FALSE;
+
+  return lin;
+}
+
+/**
+ * ncm_data_gauss_lin_free: (skip)
+ * @lin: a #NcmDataGaussLin
+ *
+ * Frees @lin and its matrices.
+ *
+ */
+void
+ncm_data_gauss_lin_free (NcmDataGaussLin *lin)
+{
+  ncm_matrix_clear (&lin->DW);
+  ncm_matrix_clear (&lin->F);
+  ncm_matrix_clear (&lin->Fb);
+  ncm_vector_clear (&lin->b);
+
+  g_slice_free (NcmDataGaussLin, lin);
+}
+
+/**
+ * ncm_data_gauss_lin_clear: (skip)
+ * @lin: a #NcmDataGaussLin
+ *
+ * If *@lin is not NULL frees it and sets *@lin to NULL.
+ *
+ */
+void
+ncm_data_gauss_lin_clear (NcmDataGaussLin **lin)
+{
+  g_clear_pointer (lin, ncm_data_gauss_lin_free);
+}
+
+/**
+ * ncm_data_gauss_lin_peek_DW: (skip)
+ * @lin: a #NcmDataGaussLin
+ * @np: number of data points
+ * @nlin: number of linear parameters
+ *
+ * Gets the @np x @nlin whitened design matrix, reallocating it when
+ * the dimensions changed. The decomposition of $F$ is invalidated,
+ * ncm_data_gauss_lin_prepare() must be called after filling the matrix.
+ *
+ * Returns: (transfer none): the whitened design matrix $D_W$.
+ */
+NcmMatrix *
+ncm_data_gauss_lin_peek_DW (NcmDataGaussLin *lin, const guint np, const guint nlin)
+{
+  if ((lin->DW == NULL) || (ncm_matrix_nrows (lin->DW) != np) || (ncm_matrix_ncols (lin->DW) != nlin))
+  {
+    ncm_matrix_clear (&lin->DW);
+    ncm_matrix_clear (&lin->F);
+    ncm_matrix_clear (&lin->Fb);
+    ncm_vector_clear (&lin->b);
+
+    lin->DW = ncm_matrix_new_aligned (np, nlin);
+    lin->F  = ncm_matrix_new_aligned (nlin, nlin);
+    lin->Fb = ncm_matrix_new_aligned (nlin, nlin);
+    lin->b  = ncm_vector_new_aligned (nlin);
+  }
+
+  lin->prepared = FALSE;
+
+  return lin->DW;
+}
+
+/* Computes F = DW^T DW and its Cholesky decomposition. */
+static void
+_ncm_data_gauss_lin_decomp (NcmMatrix *F, NcmMatrix *DW)
+{
+  gint ret;
+
+  ncm_matrix_dsyrk (F, 'U', 'T', 1.0, DW, 0.0);
+  ncm_matrix_copy_triangle (F, 'U');
+
+  ret = ncm_matrix_cholesky_decomp (F, 'U');
+  if (ret != 0)
+    g_error ("_ncm_data_gauss_lin_decomp[ncm_matrix_cholesky_decomp]: %d, degenerated design matrix.", ret);
+}
+
+/**
+ * ncm_data_gauss_lin_prepare: (skip)
+ * @lin: a #NcmDataGaussLin
+ *
+ * Computes and keeps the Cholesky decomposition of $F = D_W^\intercal
+ * D_W$ for the current content of the whitened design matrix.
+ *
+ */
+void
+ncm_data_gauss_lin_prepare (NcmDataGaussLin *lin)
+{
+  g_assert (lin->DW != NULL);
+
+  _ncm_data_gauss_lin_decomp (lin->F, lin->DW);
+  lin->prepared = TRUE;
+}
+
+/*
+ * Leaves L_F^{-1} b in lin->b and returns the decomposition of F used,
+ * the kept one without bootstrap (bw == NULL) or the one computed with
+ * the multiplicities in bw.
+ */
+static NcmMatrix *
+_ncm_data_gauss_lin_solve (NcmDataGaussLin *lin, NcmVector *r, NcmVector *bw)
+{
+  NcmMatrix *F;
+  gint ret;
+
+  g_assert (lin->prepared);
+
+  if (bw == NULL)
+  {
+    F   = lin->F;
+    ret = gsl_blas_dgemv (CblasTrans, 1.0, ncm_matrix_gsl (lin->DW), ncm_vector_gsl (r),
+                          0.0, ncm_vector_gsl (lin->b));
+    NCM_TEST_GSL_RESULT ("_ncm_data_gauss_lin_solve", ret);
+  }
+  else
+  {
+    NcmWorkspace *ws = ncm_workspace_peek ();
+    const guint np   = ncm_matrix_nrows (lin->DW);
+    const guint nlin = ncm_matrix_ncols (lin->DW);
+    NcmMatrix *DWb   = ncm_workspace_borrow_matrix (ws, np, nlin);
+    NcmVector *rb    = ncm_workspace_borrow_vector (ws, np);
+    guint k, a;
+
+    /* Rows scaled by the square root of the multiplicities: F = DWb^T DWb. */
+    for (k = 0; k < np; k++)
+    {
+      const gdouble s_k = sqrt (ncm_vector_get (bw, k));
+
+      for (a = 0; a < nlin; a++)
+        ncm_matrix_set (DWb, k, a, s_k * ncm_matrix_get (lin->DW, k, a));
+      ncm_vector_set (rb, k, s_k * ncm_vector_get (r, k));
+    }
+
+    F = lin->Fb;
+    _ncm_data_gauss_lin_decomp (F, DWb);
+
+    ret = gsl_blas_dgemv (CblasTrans, 1.0, ncm_matrix_gsl (DWb), ncm_vector_gsl (rb),
+                          0.0, ncm_vector_gsl (lin->b));
+    NCM_TEST_GSL_RESULT ("_ncm_data_gauss_lin_solve", ret);
+
+    ncm_workspace_return_vector (ws, rb);
+    ncm_workspace_return_matrix (ws, DWb);
+  }
+
+  ret = gsl_blas_dtrsv (CblasUpper, CblasTrans, CblasNonUnit,
+                        ncm_matrix_gsl (F), ncm_vector_gsl (lin->b));
+  NCM_TEST_GSL_RESULT ("_ncm_data_gauss_lin_solve", ret);
+
+  return F;
+}
+
+/**
+ * ncm_data_gauss_lin_m2lnL: (skip)
+ * @lin: a #NcmDataGaussLin
+ * @r: whitened residual
+ * @bw: (allow-none): bootstrap multiplicities
+ * @marg: whether to marginalize instead of profile
+ * @m2lnL: (inout): $-2\ln(L)$
+ *
+ * Removes the linear parameters from @m2lnL, which must already
+ * contain $r^\intercal B r$, subtracting $b^\intercal F^{-1} b$ and,
+ * when @marg is TRUE, adding $\ln\det F$.
+ *
+ */
+void
+ncm_data_gauss_lin_m2lnL (NcmDataGaussLin *lin, NcmVector *r, NcmVector *bw, gboolean marg, gdouble *m2lnL)
+{
+  NcmMatrix *F = _ncm_data_gauss_lin_solve (lin, r, bw);
+
+  *m2lnL -= ncm_vector_wsumsq (lin->b, NULL);
+
+  if (marg)
+  {
+    const guint nlin = ncm_matrix_ncols (F);
+    guint a;
+
+    for (a = 0; a < nlin; a++)
+      *m2lnL += 2.0 * log (ncm_matrix_get (F, a, a));
+  }
+}
+
+/**
+ * ncm_data_gauss_lin_project: (skip)
+ * @lin: a #NcmDataGaussLin
+ * @r: whitened residual
+ *
+ * Projects out the linear parameters from the least squares residual,
+ * $r \to r - D_W F^{-1} D_W^\intercal r$.
+ *
+ */
+void
+ncm_data_gauss_lin_project (NcmDataGaussLin *lin, NcmVector *r)
+{
+  NcmMatrix *F = _ncm_data_gauss_lin_solve (lin, r, NULL);
+  gint ret;
+
+  ret = gsl_blas_dtrsv (CblasUpper, CblasNoTrans, CblasNonUnit,
+                        ncm_matrix_gsl (F), ncm_vector_gsl (lin->b));
+  NCM_TEST_GSL_RESULT ("ncm_data_gauss_lin_project", ret);
+
+  ret = gsl_blas_dgemv (CblasNoTrans, -1.0, ncm_matrix_gsl (lin->DW), ncm_vector_gsl (lin->b),
+                        1.0, ncm_vector_gsl (r));
+  NCM_TEST_GSL_RESULT ("ncm_data_gauss_lin_project", ret);
+}
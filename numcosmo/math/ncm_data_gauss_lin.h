@@ -0,0 +1,67 @@
+/***************************************************************************
+ *            ncm_data_gauss_lin.h
+ *
+ *  Mon October 19 19:41:20 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_data_gauss_lin.h
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _NCM_DATA_GAUSS_LIN_H_
+#define _NCM_DATA_GAUSS_LIN_H_
+
+#include <glib.h>
+#include <glib-object.h>
+#include <numcosmo/build_cfg.h>
+#include <numcosmo/math/ncm_vector.h>
+#include <numcosmo/math/ncm_matrix.h>
+
+G_BEGIN_DECLS
+
+typedef struct _NcmDataGaussLin NcmDataGaussLin;
+
+/**
+ * NcmDataGaussLin:
+ *
+ * Whitened design matrix of the linear parameters of a Gaussian
+ * likelihood and the Cholesky decomposition of its Fisher matrix.
+ */
+struct _NcmDataGaussLin
+{
+  /*< private >*/
+  NcmMatrix *DW;
+  NcmMatrix *F;
+  NcmMatrix *Fb;
+  NcmVector *b;
+  gboolean prepared;
+};
+
+NcmDataGaussLin *ncm_data_gauss_lin_new (void);
+void ncm_data_gauss_lin_free (NcmDataGaussLin *lin);
+void ncm_data_gauss_lin_clear (NcmDataGaussLin **lin);
+
+NcmMatrix *ncm_data_gauss_lin_peek_DW (NcmDataGaussLin *lin, const guint np, const guint nlin);
+void ncm_data_gauss_lin_prepare (NcmDataGaussLin *lin);
+
+void ncm_data_gauss_lin_m2lnL (NcmDataGaussLin *lin, NcmVector *r, NcmVector *bw, gboolean marg, gdouble *m2lnL);
+void ncm_data_gauss_lin_project (NcmDataGaussLin *lin, NcmVector *r);
+
+G_END_DECLS
+
+#endif /* _NCM_DATA_GAUSS_LIN_H_ */
@@ -28,7 +28,30 @@
  * @title: NcmDataset
  * @short_description: A set of NcmData objects
  *
- * FIXME
+ * A #NcmDataset is a collection of #NcmData objects whose likelihoods
+ * are combined assuming they are independent, i.e., the total $-2\ln(L)$
+ * is the sum of the individual ones and the least squares vectors and
+ * Jacobians are stacked in the order the data were appended.
+ *
+ * When ncm_dataset_set_nthreads() is called with a value larger than one
+ * the evaluations of ncm_dataset_m2lnL_val(), ncm_dataset_m2lnL_vec() and
+ * ncm_dataset_leastsquares_f(), ncm_dataset_leastsquares_J() and
+ * ncm_dataset_leastsquares_f_J() are performed concurrently using the
+ * thread pool (see ncm_func_eval_threaded_loop_full()). First, every
+ * #NcmData is prepared serially in order, this guarantees that the
+ * objects shared among them (#NcDistance, #NcHaloMassFunction, etc) are
+ * prepared only once and in a fixed order. Then, the data are split in
+ * independent groups: two #NcmData belong to the same group when they
+ * share, directly or through their object properties, any object (see
+ * ncm_dataset_update_dependencies()). The groups are evaluated
+ * concurrently while the members of each group are evaluated serially,
+ * therefore lazily computed quantities in shared objects are never
+ * accessed by two threads. The partial results are stored per #NcmData
+ * and combined in the dataset order, such that the result is identical
+ * to the serial evaluation.
+ *
+ * The parallel mode should not be enabled when the #NcmDataset is itself
+ * evaluated inside the thread pool, e.g., by a multithreaded sampler.
  *
  */
 
@@ -39,6 +62,8 @@
 
 #include "math/ncm_dataset.h"
 #include "math/ncm_cfg.h"
+#include "math/ncm_func_eval.h"
+#include "math/ncm_workspace.h"
 #include "ncm_enum_types.h"
 
 enum
@@ -46,6 +71,7 @@ enum
   PROP_0,
   PROP_BSTYPE,
   PROP_OA,
+  PROP_RNG_STREAMS,
   PROP_SIZE,
 };
 
@@ -56,10 +82,18 @@ G_DEFINE_TYPE (NcmDataset, ncm_dataset, G_TYPE_OBJECT);
 static void
 ncm_dataset_init (NcmDataset *dset)
 {
-  dset->bstype    = NCM_DATASET_BSTRAP_DISABLE;
-  dset->oa        = ncm_obj_array_sized_new (_NCM_DATASET_INITIAL_ALLOC);
-  dset->data_prob = g_array_sized_new (FALSE, FALSE, sizeof (gdouble), _NCM_DATASET_INITIAL_ALLOC);
-  dset->bstrap    = g_array_sized_new (FALSE, FALSE, sizeof (guint), _NCM_DATASET_INITIAL_ALLOC);
+  dset->bstype      = NCM_DATASET_BSTRAP_DISABLE;
+  dset->oa          = ncm_obj_array_sized_new (_NCM_DATASET_INITIAL_ALLOC);
+  dset->data_prob   = g_array_sized_new (FALSE, FALSE, sizeof (gdouble), _NCM_DATASET_INITIAL_ALLOC);
+  dset->bstrap      = g_array_sized_new (FALSE, FALSE, sizeof (guint), _NCM_DATASET_INITIAL_ALLOC);
+  dset->rng_streams = FALSE;
+  dset->nthreads    = 0;
+  dset->nindep      = 0;
+  dset->dep_valid   = FALSE;
+  dset->dep_order   = g_array_new (FALSE, FALSE, sizeof (guint));
+  dset->dep_start   = g_array_new (FALSE, FALSE, sizeof (guint));
+  dset->dep_pos     = g_array_new (FALSE, FALSE, sizeof (guint));
+  dset->m2lnL_i     = g_array_new (FALSE, FALSE, sizeof (gdouble));
 }
 
 static void
@@ -76,6 +110,9 @@ ncm_dataset_set_property (GObject *object, guint prop_id, const GValue *value, G
     case PROP_OA:
       ncm_dataset_set_data_array (dset, (NcmObjArray *) g_value_get_boxed (value));
       break;
+    case PROP_RNG_STREAMS:
+      ncm_dataset_set_rng_streams (dset, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -96,6 +133,9 @@ ncm_dataset_get_property (GObject *object, guint prop_id, GValue *value, GParamS
     case PROP_OA:
       g_value_set_boxed (value, ncm_dataset_peek_data_array (dset));
       break;
+    case PROP_RNG_STREAMS:
+      g_value_set_boolean (value, ncm_dataset_get_rng_streams (dset));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -127,6 +167,12 @@ ncm_dataset_dispose (GObject *object)
 static void
 ncm_dataset_finalize (GObject *object)
 {
+  NcmDataset *dset = NCM_DATASET (object);
+
+  g_array_unref (dset->dep_order);
+  g_array_unref (dset->dep_start);
+  g_array_unref (dset->dep_pos);
+  g_array_unref (dset->m2lnL_i);
 
   /* Chain up : end */
   G_OBJECT_CLASS (ncm_dataset_parent_class)->finalize (object);
@@ -168,6 +214,20 @@ ncm_dataset_class_init (NcmDatasetClass *klass)
                                                        "NcmData array",
                                                        NCM_TYPE_OBJ_ARRAY,
                                                        G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  /**
+   * NcmDataset:rng-streams:
+   *
+   * Whether each #NcmData is resampled from its own stream, see
+   * ncm_dataset_set_rng_streams().
+   *
+   */
+  g_object_class_install_property (object_class,
+                                   PROP_RNG_STREAMS,
+                                   g_param_spec_boolean ("rng-streams",
+                                                         NULL,
+                                                         "Whether to resample each data from its own stream",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
 }
 
 /**
@@ -233,6 +293,28 @@ ncm_dataset_dup (NcmDataset *dset, NcmSerialize *ser)
   return NCM_DATASET (ncm_serialize_dup_obj (ser, G_OBJECT (dset)));
 }
 
+/**
+ * ncm_dataset_share_payload:
+ * @dset: a #NcmDataset
+ * @ser: a #NcmSerialize
+ *
+ * Calls ncm_data_share_payload() for every #NcmData in @dset, after
+ * this the duplicates created by ncm_dataset_dup() using @ser share
+ * the immutable objects of the original data.
+ *
+ */
+void
+ncm_dataset_share_payload (NcmDataset *dset, NcmSerialize *ser)
+{
+  guint i;
+
+  for (i = 0; i < dset->oa->len; i++)
+  {
+    NcmData *data = ncm_dataset_peek_data (dset, i);
+    ncm_data_share_payload (data, ser);
+  }
+}
+
 /**
  * ncm_dataset_copy:
  * @dset: pointer to type defined by #NcmDataset
@@ -270,6 +352,7 @@ ncm_dataset_append_data (NcmDataset *dset, NcmData *data)
   gboolean enable = (dset->bstype != NCM_DATASET_BSTRAP_DISABLE) ? TRUE : FALSE;
 
   ncm_obj_array_add (dset->oa, G_OBJECT (data));
+  dset->dep_valid = FALSE;
 
   if (enable)
     ncm_data_bootstrap_create (data);
@@ -424,6 +507,7 @@ ncm_dataset_set_data_array (NcmDataset *dset, NcmObjArray *oa)
 
   dset->oa = ncm_obj_array_ref (oa);
   ncm_obj_array_unref (old_oa);
+  dset->dep_valid = FALSE;
 
   for (i = 0; i < dset->oa->len; i++)
   {
@@ -432,6 +516,9 @@ ncm_dataset_set_data_array (NcmDataset *dset, NcmObjArray *oa)
       ncm_data_bootstrap_remove (data);
     else
       ncm_data_bootstrap_create (data);
+
+    /* The new set may be a subset of the old one, see ncm_dataset_get_version(). */
+    ncm_data_mark_changed (data);
   }
 
   _ncm_dataset_update_bstrap (dset);
@@ -489,6 +576,77 @@ ncm_dataset_clear (NcmDataset **dset)
   g_clear_object (dset);
 }
 
+/**
+ * ncm_dataset_set_rng_streams:
+ * @dset: a #NcmDataset
+ * @rng_streams: whether to use one stream per #NcmData
+ *
+ * When @rng_streams is TRUE, ncm_dataset_resample() and
+ * ncm_dataset_bootstrap_resample() derive one Philox4x32-10 stream from
+ * the #NcmRNG passed (see ncm_rng_stream_new()) and the i-th #NcmData
+ * draws from its i-th substream (see ncm_rng_jump()). Each realization of
+ * a #NcmData then does not depend on the number of draws used by the
+ * others, and the #NcmRNG passed is advanced by a single draw. The state
+ * of the #NcmRNG passed is hashed once per call.
+ *
+ * The default is FALSE, in which case every #NcmData draws in order from
+ * the #NcmRNG passed, as in previous versions.
+ *
+ */
+void
+ncm_dataset_set_rng_streams (NcmDataset *dset, gboolean rng_streams)
+{
+  dset->rng_streams = rng_streams;
+}
+
+/**
+ * ncm_dataset_get_rng_streams:
+ * @dset: a #NcmDataset
+ *
+ * Returns: whether each #NcmData is resampled from its own stream, see
+ * ncm_dataset_set_rng_streams().
+ */
+gboolean
+ncm_dataset_get_rng_streams (NcmDataset *dset)
+{
+  return dset->rng_streams;
+}
+
+/*
+ * Returns the generator used by the first #NcmData, a new stream derived
+ * from @rng when the streams are enabled. It is local to the call, so
+ * that concurrent resamplings of different datasets do not share it.
+ */
+static NcmRNG *
+_ncm_dataset_streams_start (NcmDataset *dset, NcmRNG *rng)
+{
+  if (dset->rng_streams)
+    return ncm_rng_stream_new (rng, 0);
+  else
+    return ncm_rng_ref (rng);
+}
+
+/* Moves to the substream of the next #NcmData. */
+static void
+_ncm_dataset_streams_next (NcmDataset *dset, NcmRNG *srng)
+{
+  if (dset->rng_streams)
+    ncm_rng_jump (srng);
+}
+
+static void
+_ncm_dataset_streams_end (NcmDataset *dset, NcmRNG *rng, NcmRNG *srng)
+{
+  ncm_rng_free (srng);
+
+  if (dset->rng_streams)
+  {
+    ncm_rng_lock (rng);
+    gsl_rng_get (rng->r);
+    ncm_rng_unlock (rng);
+  }
+}
+
 /**
  * ncm_dataset_resample:
  * @dset: a #NcmDataset
@@ -496,18 +654,25 @@ ncm_dataset_clear (NcmDataset **dset)
  * @rng: a #NcmRNG
  *
  * Resamples every #NcmData in @dset with the models contained in @mset.
+ * See ncm_dataset_set_rng_streams() for how @rng is used.
  *
  */
 void
 ncm_dataset_resample (NcmDataset *dset, NcmMSet *mset, NcmRNG *rng)
 {
+  NcmRNG *srng = _ncm_dataset_streams_start (dset, rng);
   guint i;
 
   for (i = 0; i < dset->oa->len; i++)
   {
     NcmData *data = ncm_dataset_peek_data (dset, i);
-    ncm_data_resample (data, mset, rng);
+
+    if (i > 0)
+      _ncm_dataset_streams_next (dset, srng);
+    ncm_data_resample (data, mset, srng);
   }
+
+  _ncm_dataset_streams_end (dset, rng, srng);
 }
 
 /**
@@ -547,22 +712,29 @@ ncm_dataset_bootstrap_set (NcmDataset *dset, NcmDatasetBStrapType bstype)
  * @rng: a #NcmRNG.
  *
  * Perform one bootstrap as in ncm_data_bootstrap_resample() in every #NcmData
- * in @dset.
+ * in @dset. See ncm_dataset_set_rng_streams() for how @rng is used, the
+ * multinomial draw of #NCM_DATASET_BSTRAP_TOTAL always uses @rng.
  *
  */
 void
 ncm_dataset_bootstrap_resample (NcmDataset *dset, NcmRNG *rng)
 {
+  NcmRNG *srng = NULL;
   guint i;
+
   switch (dset->bstype)
   {
     case NCM_DATASET_BSTRAP_PARTIAL:
     {
+      srng = _ncm_dataset_streams_start (dset, rng);
       for (i = 0; i < dset->oa->len; i++)
       {
         NcmData *data = ncm_dataset_peek_data (dset, i);
+
+        if (i > 0)
+          _ncm_dataset_streams_next (dset, srng);
         ncm_bootstrap_set_bsize (data->bstrap, data->bstrap->fsize);
-        ncm_data_bootstrap_resample (data, rng);
+        ncm_data_bootstrap_resample (data, srng);
       }
       break;
     }
@@ -575,13 +747,17 @@ ncm_dataset_bootstrap_resample (NcmDataset *dset, NcmRNG *rng)
                            (guint *)dset->bstrap->data);
       ncm_rng_unlock (rng);
 
+      srng = _ncm_dataset_streams_start (dset, rng);
       for (i = 0; i < dset->oa->len; i++)
       {
         NcmData *data = ncm_dataset_peek_data (dset, i);
         guint bsize = g_array_index (dset->bstrap, guint, i);
+
+        if (i > 0)
+          _ncm_dataset_streams_next (dset, srng);
         ncm_bootstrap_set_bsize (data->bstrap, bsize);
         if (bsize > 0)
-          ncm_data_bootstrap_resample (data, rng);
+          ncm_data_bootstrap_resample (data, srng);
       }
       break;
     }
@@ -589,6 +765,8 @@ ncm_dataset_bootstrap_resample (NcmDataset *dset, NcmRNG *rng)
       g_error ("ncm_dataset_bootstrap_resample: bootstrap is disabled.");
       break;
   }
+
+  _ncm_dataset_streams_end (dset, rng, srng);
 }
 
 /**
@@ -646,6 +824,385 @@ ncm_dataset_get_info (NcmDataset *dset)
   return g_string_free (desc, FALSE);
 }
 
+/**
+ * ncm_dataset_set_nthreads:
+ * @dset: a #NcmDataset
+ * @nthreads: number of threads
+ *
+ * Sets the number of threads used to evaluate the #NcmData in @dset,
+ * when @nthreads is larger than one the independent groups of #NcmData
+ * are evaluated concurrently using the thread pool, with at most
+ * @nthreads groups running at the same time. This setting is not
+ * serialized, therefore duplicates of @dset are always serial.
+ *
+ * The models in the #NcmMSet are shared by every #NcmData and are not
+ * part of the dependency graph (see ncm_dataset_update_dependencies()).
+ * During a concurrent evaluation the #NcmData must only read the models,
+ * the parameter stamps used by ncm_model_ctrl_update() are protected by
+ * a lock in each #NcmModel, any other lazily computed state must live in
+ * objects reachable through the #NcmData properties.
+ *
+ */
+void
+ncm_dataset_set_nthreads (NcmDataset *dset, guint nthreads)
+{
+  dset->nthreads = nthreads;
+}
+
+/**
+ * ncm_dataset_get_nthreads:
+ * @dset: a #NcmDataset
+ *
+ * Returns: the number of threads used to evaluate @dset.
+ */
+guint
+ncm_dataset_get_nthreads (NcmDataset *dset)
+{
+  return dset->nthreads;
+}
+
+static void _ncm_dataset_collect_props (GObject *obj, GHashTable *objs);
+
+static void
+_ncm_dataset_collect_obj (GObject *child, GHashTable *objs)
+{
+  if ((child == NULL) || g_hash_table_lookup (objs, child) != NULL)
+    return;
+
+  g_hash_table_insert (objs, child, child);
+  _ncm_dataset_collect_props (child, objs);
+}
+
+static void
+_ncm_dataset_collect_props (GObject *obj, GHashTable *objs)
+{
+  guint nprops = 0;
+  GParamSpec **pspecs = g_object_class_list_properties (G_OBJECT_GET_CLASS (obj), &nprops);
+  guint i;
+
+  for (i = 0; i < nprops; i++)
+  {
+    GParamSpec *pspec = pspecs[i];
+    const GType vtype = G_PARAM_SPEC_VALUE_TYPE (pspec);
+    GValue val = G_VALUE_INIT;
+
+    if (!(pspec->flags & G_PARAM_READABLE))
+      continue;
+
+    /* Vectors and matrices hold no prepare-able state. */
+    if (g_type_is_a (vtype, NCM_TYPE_VECTOR) || g_type_is_a (vtype, NCM_TYPE_MATRIX))
+      continue;
+
+    if (g_type_is_a (vtype, G_TYPE_OBJECT))
+    {
+      g_value_init (&val, vtype);
+      g_object_get_property (obj, pspec->name, &val);
+      _ncm_dataset_collect_obj (g_value_get_object (&val), objs);
+      g_value_unset (&val);
+    }
+    else if (vtype == NCM_TYPE_OBJ_ARRAY)
+    {
+      NcmObjArray *oa;
+
+      g_value_init (&val, vtype);
+      g_object_get_property (obj, pspec->name, &val);
+      oa = g_value_get_boxed (&val);
+      if (oa != NULL)
+      {
+        guint j;
+        for (j = 0; j < oa->len; j++)
+          _ncm_dataset_collect_obj (ncm_obj_array_peek (oa, j), objs);
+      }
+      g_value_unset (&val);
+    }
+  }
+
+  g_free (pspecs);
+}
+
+static guint
+_ncm_dataset_dep_root (guint *parent, guint i)
+{
+  while (parent[i] != i)
+  {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+/**
+ * ncm_dataset_update_dependencies:
+ * @dset: a #NcmDataset
+ *
+ * Rebuilds the dependency graph of the #NcmData in @dset. Each #NcmData
+ * is connected to every object reachable through its object properties
+ * (recursively), two #NcmData sharing any of these objects are placed
+ * in the same group and are never evaluated concurrently.
+ *
+ * The graph is rebuilt automatically when data are added to @dset, this
+ * function must be called when the objects referenced by the #NcmData
+ * are changed after the first evaluation.
+ *
+ * Only objects reachable through properties are seen, state kept in
+ * private fields or static variables is not accounted for. The models
+ * of the #NcmMSet are not included since every #NcmData depends on them,
+ * see ncm_dataset_set_nthreads() for the constraints this imposes.
+ *
+ */
+void
+ncm_dataset_update_dependencies (NcmDataset *dset)
+{
+  const guint len   = dset->oa->len;
+  GHashTable *owner = g_hash_table_new (g_direct_hash, g_direct_equal);
+  guint *parent     = g_new (guint, len);
+  guint *gid        = g_new (guint, len);
+  guint i;
+
+  for (i = 0; i < len; i++)
+  {
+    GHashTable *objs = g_hash_table_new (g_direct_hash, g_direct_equal);
+    GHashTableIter iter;
+    gpointer obj;
+
+    parent[i] = i;
+    _ncm_dataset_collect_obj (G_OBJECT (ncm_dataset_peek_data (dset, i)), objs);
+
+    g_hash_table_iter_init (&iter, objs);
+    while (g_hash_table_iter_next (&iter, &obj, NULL))
+    {
+      gpointer o = g_hash_table_lookup (owner, obj);
+
+      if (o == NULL)
+        g_hash_table_insert (owner, obj, GUINT_TO_POINTER (i + 1));
+      else
+      {
+        const guint ri = _ncm_dataset_dep_root (parent, i);
+        const guint rj = _ncm_dataset_dep_root (parent, GPOINTER_TO_UINT (o) - 1);
+
+        /* The root is always the first member of the group. */
+        parent[MAX (ri, rj)] = MIN (ri, rj);
+      }
+    }
+
+    g_hash_table_unref (objs);
+  }
+
+  dset->nindep = 0;
+  for (i = 0; i < len; i++)
+  {
+    const guint r = _ncm_dataset_dep_root (parent, i);
+    gid[i] = (r == i) ? dset->nindep++ : gid[r];
+  }
+
+  g_array_set_size (dset->dep_start, dset->nindep + 1);
+  g_array_set_size (dset->dep_order, len);
+
+  for (i = 0; i <= dset->nindep; i++)
+    g_array_index (dset->dep_start, guint, i) = 0;
+  for (i = 0; i < len; i++)
+    g_array_index (dset->dep_start, guint, gid[i] + 1)++;
+  for (i = 0; i < dset->nindep; i++)
+    g_array_index (dset->dep_start, guint, i + 1) += g_array_index (dset->dep_start, guint, i);
+
+  {
+    guint *next = g_memdup (dset->dep_start->data, sizeof (guint) * dset->nindep);
+    for (i = 0; i < len; i++)
+      g_array_index (dset->dep_order, guint, next[gid[i]]++) = i;
+    g_free (next);
+  }
+
+  dset->dep_valid = TRUE;
+
+  g_hash_table_unref (owner);
+  g_free (parent);
+  g_free (gid);
+}
+
+/**
+ * ncm_dataset_get_nindep:
+ * @dset: a #NcmDataset
+ *
+ * Gets the number of independent groups of #NcmData in @dset, see
+ * ncm_dataset_update_dependencies().
+ *
+ * Returns: the number of independent groups.
+ */
+guint
+ncm_dataset_get_nindep (NcmDataset *dset)
+{
+  if (!dset->dep_valid || dset->dep_order->len != dset->oa->len)
+    ncm_dataset_update_dependencies (dset);
+
+  return dset->nindep;
+}
+
+/**
+ * ncm_dataset_get_version:
+ * @dset: a #NcmDataset
+ *
+ * Gets the largest version of the #NcmData in @dset, see
+ * ncm_data_get_version(). Since a new version is larger than all
+ * previous ones, the value changes whenever any #NcmData in @dset
+ * changes, is resampled or is added to @dset.
+ *
+ * Returns: the version of @dset.
+ */
+guint64
+ncm_dataset_get_version (NcmDataset *dset)
+{
+  guint64 version = 0;
+  guint i;
+
+  for (i = 0; i < dset->oa->len; i++)
+    version = MAX (version, ncm_data_get_version (ncm_dataset_peek_data (dset, i)));
+
+  return version;
+}
+
+typedef enum _NcmDatasetEvalType
+{
+  _NCM_DATASET_EVAL_M2LNL = 0,
+  _NCM_DATASET_EVAL_F,
+  _NCM_DATASET_EVAL_J,
+  _NCM_DATASET_EVAL_F_J,
+} NcmDatasetEvalType;
+
+typedef struct _NcmDatasetEval
+{
+  NcmDataset *dset;
+  NcmMSet *mset;
+  NcmVector *f;
+  NcmMatrix *J;
+  NcmDatasetEvalType type;
+} NcmDatasetEval;
+
+static gboolean
+_ncm_dataset_use_mt (NcmDataset *dset)
+{
+  if ((dset->nthreads < 2) || (dset->oa->len < 2))
+    return FALSE;
+  else
+    return (ncm_dataset_get_nindep (dset) > 1);
+}
+
+static void
+_ncm_dataset_eval_data (NcmDatasetEval *eval, guint i)
+{
+  NcmDataset *dset = eval->dset;
+  NcmData *data    = ncm_dataset_peek_data (dset, i);
+  NcmWorkspace *ws = ncm_workspace_peek ();
+  const guint pos  = g_array_index (dset->dep_pos, guint, i);
+  const guint n    = ncm_data_get_length (data);
+
+  switch (eval->type)
+  {
+    case _NCM_DATASET_EVAL_M2LNL:
+      NCM_DATA_GET_CLASS (data)->m2lnL_val (data, eval->mset, &g_array_index (dset->m2lnL_i, gdouble, i));
+      break;
+    case _NCM_DATASET_EVAL_F:
+    {
+      NcmVector *f_i = ncm_workspace_borrow_subvector (ws, eval->f, pos, n);
+      NCM_DATA_GET_CLASS (data)->leastsquares_f (data, eval->mset, f_i);
+      ncm_workspace_return_vector (ws, f_i);
+      break;
+    }
+    case _NCM_DATASET_EVAL_J:
+    {
+      NcmMatrix *J_i = ncm_workspace_borrow_submatrix (ws, eval->J, pos, 0, n, ncm_matrix_ncols (eval->J));
+      NCM_DATA_GET_CLASS (data)->leastsquares_J (data, eval->mset, J_i);
+      ncm_workspace_return_matrix (ws, J_i);
+      break;
+    }
+    case _NCM_DATASET_EVAL_F_J:
+    {
+      NcmVector *f_i = ncm_workspace_borrow_subvector (ws, eval->f, pos, n);
+      NcmMatrix *J_i = ncm_workspace_borrow_submatrix (ws, eval->J, pos, 0, n, ncm_matrix_ncols (eval->J));
+
+      if (NCM_DATA_GET_CLASS (data)->leastsquares_f_J != NULL)
+        NCM_DATA_GET_CLASS (data)->leastsquares_f_J (data, eval->mset, f_i, J_i);
+      else
+      {
+        NCM_DATA_GET_CLASS (data)->leastsquares_f (data, eval->mset, f_i);
+        NCM_DATA_GET_CLASS (data)->leastsquares_J (data, eval->mset, J_i);
+      }
+
+      ncm_workspace_return_matrix (ws, J_i);
+      ncm_workspace_return_vector (ws, f_i);
+      break;
+    }
+    default:
+      g_assert_not_reached ();
+      break;
+  }
+}
+
+static void
+_ncm_dataset_eval_group (glong i, glong f, gpointer data)
+{
+  NcmDatasetEval *eval = (NcmDatasetEval *) data;
+  NcmDataset *dset     = eval->dset;
+  glong g;
+
+  for (g = i; g < f; g++)
+  {
+    guint k;
+    for (k = g_array_index (dset->dep_start, guint, g); k < g_array_index (dset->dep_start, guint, g + 1); k++)
+      _ncm_dataset_eval_data (eval, g_array_index (dset->dep_order, guint, k));
+  }
+}
+
+static void
+_ncm_dataset_eval_mt (NcmDataset *dset, NcmMSet *mset, NcmDatasetEvalType type, NcmVector *f, NcmMatrix *J)
+{
+  NcmDatasetEval eval = {dset, mset, f, J, type};
+  guint pos = 0;
+  guint i;
+
+  g_array_set_size (dset->dep_pos, dset->oa->len);
+  g_array_set_size (dset->m2lnL_i, dset->oa->len);
+
+  for (i = 0; i < dset->oa->len; i++)
+  {
+    NcmData *data = ncm_dataset_peek_data (dset, i);
+
+    switch (type)
+    {
+      case _NCM_DATASET_EVAL_M2LNL:
+        if (!NCM_DATA_GET_CLASS (data)->m2lnL_val)
+          g_error ("ncm_dataset_m2lnL_val: %s dont implement m2lnL", G_OBJECT_TYPE_NAME (data));
+        break;
+      case _NCM_DATASET_EVAL_F:
+        if (!NCM_DATA_GET_CLASS (data)->leastsquares_f)
+          g_error ("ncm_dataset_leastsquares_f: %s dont implement leastsquares vector f", G_OBJECT_TYPE_NAME (data));
+        break;
+      case _NCM_DATASET_EVAL_J:
+        if (!NCM_DATA_GET_CLASS (data)->leastsquares_J)
+          g_error ("ncm_dataset_leastsquares_J: %s dont implement leastsquares matrix J", G_OBJECT_TYPE_NAME (data));
+        break;
+      case _NCM_DATASET_EVAL_F_J:
+        if ((NCM_DATA_GET_CLASS (data)->leastsquares_f_J == NULL) &&
+            (NCM_DATA_GET_CLASS (data)->leastsquares_f == NULL || NCM_DATA_GET_CLASS (data)->leastsquares_J == NULL))
+          g_error ("ncm_dataset_leastsquares_f_J: %s dont implement leastsquares f J", G_OBJECT_TYPE_NAME (data));
+        break;
+      default:
+        g_assert_not_reached ();
+        break;
+    }
+
+    g_array_index (dset->dep_pos, guint, i) = pos;
+    pos += ncm_data_get_length (data);
+
+    ncm_data_prepare (data, mset);
+  }
+
+  /* At most dset->nthreads groups are evaluated at the same time. */
+  if (dset->nthreads < dset->nindep)
+    ncm_func_eval_threaded_loop_nw (&_ncm_dataset_eval_group, 0, dset->nindep, &eval, dset->nthreads);
+  else
+    ncm_func_eval_threaded_loop_full (&_ncm_dataset_eval_group, 0, dset->nindep, &eval);
+}
+
 
 
 /**
@@ -818,8 +1375,15 @@ ncm_dataset_has_m2lnL_val_grad (NcmDataset *dset)
 void
 ncm_dataset_leastsquares_f (NcmDataset *dset, NcmMSet *mset, NcmVector *f)
 {
+  NcmWorkspace *ws = ncm_workspace_peek ();
   guint pos = 0, i;
 
+  if (_ncm_dataset_use_mt (dset))
+  {
+    _ncm_dataset_eval_mt (dset, mset, _NCM_DATASET_EVAL_F, f, NULL);
+    return;
+  }
+
   for (i = 0; i < dset->oa->len; i++)
   {
     NcmData *data = ncm_dataset_peek_data (dset, i);
@@ -829,11 +1393,11 @@ ncm_dataset_leastsquares_f (NcmDataset *dset, NcmMSet *mset, NcmVector *f)
       g_error ("ncm_dataset_leastsquares_f: %s dont implement leastsquares vector f", G_OBJECT_TYPE_NAME (data));
     else
     {
-      NcmVector *f_i = ncm_vector_get_subvector (f, pos, n);
+      NcmVector *f_i = ncm_workspace_borrow_subvector (ws, f, pos, n);
       ncm_data_prepare (data, mset);
       NCM_DATA_GET_CLASS (data)->leastsquares_f (data, mset, f_i);
       pos += n;
-      ncm_vector_free (f_i);
+      ncm_workspace_return_vector (ws, f_i);
     }
   }
 
@@ -852,8 +1416,15 @@ ncm_dataset_leastsquares_f (NcmDataset *dset, NcmMSet *mset, NcmVector *f)
 void
 ncm_dataset_leastsquares_J (NcmDataset *dset, NcmMSet *mset, NcmMatrix *J)
 {
+  NcmWorkspace *ws = ncm_workspace_peek ();
   guint pos = 0, i;
 
+  if (_ncm_dataset_use_mt (dset))
+  {
+    _ncm_dataset_eval_mt (dset, mset, _NCM_DATASET_EVAL_J, NULL, J);
+    return;
+  }
+
   for (i = 0; i < dset->oa->len; i++)
   {
     NcmData *data = ncm_dataset_peek_data (dset, i);
@@ -863,13 +1434,13 @@ ncm_dataset_leastsquares_J (NcmDataset *dset, NcmMSet *mset, NcmMatrix *J)
       g_error ("ncm_dataset_leastsquares_J: %s dont implement leastsquares matrix J", G_OBJECT_TYPE_NAME (data));
     else
     {
-      NcmMatrix *J_i = ncm_matrix_get_submatrix (J, pos, 0, n, ncm_matrix_ncols (J));
+      NcmMatrix *J_i = ncm_workspace_borrow_submatrix (ws, J, pos, 0, n, ncm_matrix_ncols (J));
       ncm_data_prepare (data, mset);
 
       NCM_DATA_GET_CLASS (data)->leastsquares_J (data, mset, J_i);
 
       pos += n;
-      ncm_matrix_free (J_i);
+      ncm_workspace_return_matrix (ws, J_i);
     }
   }
 
@@ -888,14 +1459,21 @@ ncm_dataset_leastsquares_J (NcmDataset *dset, NcmMSet *mset, NcmMatrix *J)
 void
 ncm_dataset_leastsquares_f_J (NcmDataset *dset, NcmMSet *mset, NcmVector *f, NcmMatrix *J)
 {
+  NcmWorkspace *ws = ncm_workspace_peek ();
   guint pos = 0, i;
 
+  if (_ncm_dataset_use_mt (dset))
+  {
+    _ncm_dataset_eval_mt (dset, mset, _NCM_DATASET_EVAL_F_J, f, J);
+    return;
+  }
+
   for (i = 0; i < dset->oa->len; i++)
   {
     NcmData *data = ncm_dataset_peek_data (dset, i);
     guint n = ncm_data_get_length (data);
-    NcmMatrix *J_i = ncm_matrix_get_submatrix (J, pos, 0, n, ncm_matrix_ncols (J));
-    NcmVector *f_i = ncm_vector_get_subvector (f, pos, n);
+    NcmMatrix *J_i = ncm_workspace_borrow_submatrix (ws, J, pos, 0, n, ncm_matrix_ncols (J));
+    NcmVector *f_i = ncm_workspace_borrow_subvector (ws, f, pos, n);
     ncm_data_prepare (data, mset);
 
     if (NCM_DATA_GET_CLASS (data)->leastsquares_f_J != NULL)
@@ -909,8 +1487,8 @@ ncm_dataset_leastsquares_f_J (NcmDataset *dset, NcmMSet *mset, NcmVector *f, Ncm
       g_error ("ncm_dataset_leastsquares_f_J: %s dont implement leastsquares f J", G_OBJECT_TYPE_NAME (data));
 
     pos += n;
-    ncm_matrix_free (J_i);
-    ncm_vector_free (f_i);
+    ncm_workspace_return_vector (ws, f_i);
+    ncm_workspace_return_matrix (ws, J_i);
   }
 }
 
@@ -928,6 +1506,14 @@ ncm_dataset_m2lnL_val (NcmDataset *dset, NcmMSet *mset, gdouble *m2lnL)
   guint i;
   *m2lnL = 0.0;
 
+  if (_ncm_dataset_use_mt (dset))
+  {
+    _ncm_dataset_eval_mt (dset, mset, _NCM_DATASET_EVAL_M2LNL, NULL, NULL);
+    for (i = 0; i < dset->oa->len; i++)
+      *m2lnL += g_array_index (dset->m2lnL_i, gdouble, i);
+    return;
+  }
+
   for (i = 0; i < dset->oa->len; i++)
   {
     NcmData *data = ncm_dataset_peek_data (dset, i);
@@ -962,6 +1548,14 @@ ncm_dataset_m2lnL_vec (NcmDataset *dset, NcmMSet *mset, NcmVector *m2lnL_v)
 
   g_assert (ncm_vector_len (m2lnL_v) >= dset->oa->len);
 
+  if (_ncm_dataset_use_mt (dset))
+  {
+    _ncm_dataset_eval_mt (dset, mset, _NCM_DATASET_EVAL_M2LNL, NULL, NULL);
+    for (i = 0; i < dset->oa->len; i++)
+      ncm_vector_set (m2lnL_v, i, g_array_index (dset->m2lnL_i, gdouble, i));
+    return;
+  }
+
   for (i = 0; i < dset->oa->len; i++)
   {
     NcmData *data = ncm_dataset_peek_data (dset, i);
@@ -1023,9 +1617,10 @@ ncm_dataset_m2lnL_i_val (NcmDataset *dset, NcmMSet *mset, guint i, gdouble *m2ln
 void
 ncm_dataset_m2lnL_grad (NcmDataset *dset, NcmMSet *mset, NcmVector *grad)
 {
+  NcmWorkspace *ws = ncm_workspace_peek ();
   guint i;
   guint free_params_len = ncm_mset_fparams_len (mset);
-  NcmVector *grad_i = ncm_vector_new (free_params_len);
+  NcmVector *grad_i = ncm_workspace_borrow_vector (ws, free_params_len);
 
   ncm_vector_set_zero (grad);
 
@@ -1043,7 +1638,7 @@ ncm_dataset_m2lnL_grad (NcmDataset *dset, NcmMSet *mset, NcmVector *grad)
     }
   }
 
-  ncm_vector_free (grad_i);
+  ncm_workspace_return_vector (ws, grad_i);
 
   return;
 }
@@ -1060,9 +1655,10 @@ ncm_dataset_m2lnL_grad (NcmDataset *dset, NcmMSet *mset, NcmVector *grad)
 void
 ncm_dataset_m2lnL_val_grad (NcmDataset *dset, NcmMSet *mset, gdouble *m2lnL, NcmVector *grad)
 {
+  NcmWorkspace *ws = ncm_workspace_peek ();
   guint i;
   guint free_params_len = ncm_mset_fparams_len (mset);
-  NcmVector *grad_i = ncm_vector_new (free_params_len);
+  NcmVector *grad_i = ncm_workspace_borrow_vector (ws, free_params_len);
 
   ncm_vector_set_zero (grad);
   *m2lnL = 0.0;
@@ -1088,5 +1684,5 @@ ncm_dataset_m2lnL_val_grad (NcmDataset *dset, NcmMSet *mset, gdouble *m2lnL, Ncm
     ncm_vector_add (grad, grad_i);
   }
 
-  ncm_vector_free (grad_i);
+  ncm_workspace_return_vector (ws, grad_i);
 }
@@ -78,12 +78,21 @@ struct _NcmDataset
   NcmDatasetBStrapType bstype;
   GArray *data_prob;
   GArray *bstrap;
+  gboolean rng_streams;
+  guint nthreads;
+  guint nindep;
+  gboolean dep_valid;
+  GArray *dep_order;
+  GArray *dep_start;
+  GArray *dep_pos;
+  GArray *m2lnL_i;
 };
 
 GType ncm_dataset_get_type (void) G_GNUC_CONST;
 
 NcmDataset *ncm_dataset_new (void);
 NcmDataset *ncm_dataset_dup (NcmDataset *dset, NcmSerialize *ser);
+void ncm_dataset_share_payload (NcmDataset *dset, NcmSerialize *ser);
 NcmDataset *ncm_dataset_ref (NcmDataset *dset);
 NcmDataset *ncm_dataset_copy (NcmDataset *dset);
 void ncm_dataset_free (NcmDataset *dset);
@@ -102,12 +111,20 @@ void ncm_dataset_set_data_array (NcmDataset *dset, NcmObjArray *oa);
 NcmObjArray *ncm_dataset_get_data_array (NcmDataset *dset);
 NcmObjArray *ncm_dataset_peek_data_array (NcmDataset *dset);
 
+void ncm_dataset_set_rng_streams (NcmDataset *dset, gboolean rng_streams);
+gboolean ncm_dataset_get_rng_streams (NcmDataset *dset);
 void ncm_dataset_resample (NcmDataset *dset, NcmMSet *mset, NcmRNG *rng);
 void ncm_dataset_bootstrap_set (NcmDataset *dset, NcmDatasetBStrapType bstype);
 void ncm_dataset_bootstrap_resample (NcmDataset *dset, NcmRNG *rng);
 void ncm_dataset_log_info (NcmDataset *dset);
 gchar *ncm_dataset_get_info (NcmDataset *dset);
 
+void ncm_dataset_set_nthreads (NcmDataset *dset, guint nthreads);
+guint ncm_dataset_get_nthreads (NcmDataset *dset);
+void ncm_dataset_update_dependencies (NcmDataset *dset);
+guint ncm_dataset_get_nindep (NcmDataset *dset);
+guint64 ncm_dataset_get_version (NcmDataset *dset);
+
 gboolean ncm_dataset_has_leastsquares_f (NcmDataset *dset);
 gboolean ncm_dataset_has_leastsquares_J (NcmDataset *dset);
 gboolean ncm_dataset_has_leastsquares_f_J (NcmDataset *dset);
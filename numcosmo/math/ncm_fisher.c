@@ -0,0 +1,996 @@
+/***************************************************************************
+ *            ncm_fisher.c
+ *
+ *  Tue October 20 16:42:05 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_fisher.c
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:ncm_fisher
+ * @title: NcmFisher
+ * @short_description: Fisher matrix forecasts for Gaussian data.
+ *
+ * This object computes the Fisher matrix of the free parameters of a
+ * #NcmMSet for a #NcmDataset containing only Gaussian data, i.e.,
+ * #NcmDataGaussCov and #NcmDataGaussDiag objects. For each data object
+ * with mean $\mu(\theta)$ and covariance $C(\theta)$ the contribution is
+ * $$F_{ab} = \partial_a\mu^T C^{-1} \partial_b\mu + \frac{1}{2}\mathrm{tr}\left(C^{-1}\partial_aC\,C^{-1}\partial_bC\right),$$
+ * where the second term is included only when the covariance depends on
+ * the models, i.e., when the data implements
+ * #NcmDataGaussCovClass.cov_func or #NcmDataGaussDiagClass.sigma_func.
+ * Everything is evaluated at the current values of the free parameters
+ * (the fiducial model), the data vector itself is not used.
+ *
+ * The derivatives are computed using central differences with steps
+ * $h_k = h_0 2^{-k}$, $k = 0,\dots,n-1$, where $h_0$ is
+ * #NcmFisher:step times the scale of the parameter and $n$ is
+ * #NcmFisher:richardson-levels, which are then combined using Richardson
+ * extrapolation. Each free parameter is an independent task, when
+ * #NcmFisher:nthreads is larger than one they are evaluated in parallel
+ * using copies of the #NcmMSet and #NcmDataset.
+ *
+ * The products by $C^{-1}$ reuse the Cholesky decomposition of the
+ * covariance computed by the data object. Linear nuisance parameters
+ * (see ncm_data_gauss_cov_set_lin_design()) and the weighted mean
+ * subtraction of #NcmDataGaussDiag:w-mean are projected out, i.e., the
+ * resulting Fisher matrix is the one of the remaining parameters after
+ * profiling (or marginalizing) over them.
+ *
+ * The inverse of the Fisher matrix, ncm_fisher_peek_covar(), is a
+ * forecast of the parameter covariance and can be printed using
+ * ncm_mset_fparams_log_covar().
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif /* HAVE_CONFIG_H */
+#include "build_cfg.h"
+
+#include "math/ncm_fisher.h"
+#include "math/ncm_data_gauss_cov.h"
+#include "math/ncm_data_gauss_diag.h"
+#include "math/ncm_cfg.h"
+#include "math/ncm_util.h"
+#include "math/ncm_serialize.h"
+#include "math/ncm_func_eval.h"
+#include "math/memory_pool.h"
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_linalg.h>
+#include <gsl/gsl_permutation.h>
+
+enum
+{
+  PROP_0,
+  PROP_DATASET,
+  PROP_MSET,
+  PROP_NTHREADS,
+  PROP_STEP,
+  PROP_RICHARDSON_LEVELS,
+  PROP_SIZE,
+};
+
+/*
+ * Derivatives of one data object, row a contains the derivatives with
+ * respect to the a-th free parameter. dcov contains the derivatives of
+ * the covariance (row major, np * np) for NcmDataGaussCov or of the
+ * standard deviations (np) for NcmDataGaussDiag, it is NULL when these
+ * do not depend on the models.
+ */
+typedef struct _NcmFisherDeriv
+{
+  NcmMatrix *dmean;
+  NcmMatrix *dcov;
+} NcmFisherDeriv;
+
+G_DEFINE_TYPE (NcmFisher, ncm_fisher, G_TYPE_OBJECT);
+
+static void
+_ncm_fisher_deriv_clear (gpointer data)
+{
+  NcmFisherDeriv *dd = (NcmFisherDeriv *) data;
+
+  ncm_matrix_clear (&dd->dmean);
+  ncm_matrix_clear (&dd->dcov);
+}
+
+static void
+ncm_fisher_init (NcmFisher *fisher)
+{
+  fisher->dset      = NULL;
+  fisher->mset      = NULL;
+  fisher->nthreads  = 0;
+  fisher->nrich     = 0;
+  fisher->step      = 0.0;
+  fisher->theta0    = NULL;
+  fisher->deriv_err = NULL;
+  fisher->deriv     = g_array_new (FALSE, TRUE, sizeof (NcmFisherDeriv));
+  fisher->F         = NULL;
+  fisher->covar     = NULL;
+
+  g_array_set_clear_func (fisher->deriv, &_ncm_fisher_deriv_clear);
+}
+
+static void
+_ncm_fisher_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+  NcmFisher *fisher = NCM_FISHER (object);
+  g_return_if_fail (NCM_IS_FISHER (object));
+
+  switch (prop_id)
+  {
+    case PROP_DATASET:
+      fisher->dset = g_value_dup_object (value);
+      break;
+    case PROP_MSET:
+      fisher->mset = g_value_dup_object (value);
+      break;
+    case PROP_NTHREADS:
+      ncm_fisher_set_nthreads (fisher, g_value_get_uint (value));
+      break;
+    case PROP_STEP:
+      ncm_fisher_set_step (fisher, g_value_get_double (value));
+      break;
+    case PROP_RICHARDSON_LEVELS:
+      ncm_fisher_set_richardson_levels (fisher, g_value_get_uint (value));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+_ncm_fisher_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+  NcmFisher *fisher = NCM_FISHER (object);
+  g_return_if_fail (NCM_IS_FISHER (object));
+
+  switch (prop_id)
+  {
+    case PROP_DATASET:
+      g_value_set_object (value, fisher->dset);
+      break;
+    case PROP_MSET:
+      g_value_set_object (value, fisher->mset);
+      break;
+    case PROP_NTHREADS:
+      g_value_set_uint (value, fisher->nthreads);
+      break;
+    case PROP_STEP:
+      g_value_set_double (value, fisher->step);
+      break;
+    case PROP_RICHARDSON_LEVELS:
+      g_value_set_uint (value, fisher->nrich);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+_ncm_fisher_dispose (GObject *object)
+{
+  NcmFisher *fisher = NCM_FISHER (object);
+
+  ncm_dataset_clear (&fisher->dset);
+  ncm_mset_clear (&fisher->mset);
+
+  ncm_vector_clear (&fisher->theta0);
+  ncm_vector_clear (&fisher->deriv_err);
+
+  ncm_matrix_clear (&fisher->F);
+  ncm_matrix_clear (&fisher->covar);
+
+  g_array_set_size (fisher->deriv, 0);
+
+  /* Chain up : end */
+  G_OBJECT_CLASS (ncm_fisher_parent_class)->dispose (object);
+}
+
+static void
+_ncm_fisher_finalize (GObject *object)
+{
+  NcmFisher *fisher = NCM_FISHER (object);
+
+  g_array_unref (fisher->deriv);
+
+  /* Chain up : end */
+  G_OBJECT_CLASS (ncm_fisher_parent_class)->finalize (object);
+}
+
+static void
+ncm_fisher_class_init (NcmFisherClass *klass)
+{
+  GObjectClass* object_class = G_OBJECT_CLASS (klass);
+
+  object_class->set_property = &_ncm_fisher_set_property;
+  object_class->get_property = &_ncm_fisher_get_property;
+  object_class->dispose      = &_ncm_fisher_dispose;
+  object_class->finalize     = &_ncm_fisher_finalize;
+
+  g_object_class_install_property (object_class,
+                                   PROP_DATASET,
+                                   g_param_spec_object ("dataset",
+                                                        NULL,
+                                                        "Dataset",
+                                                        NCM_TYPE_DATASET,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_MSET,
+                                   g_param_spec_object ("mset",
+                                                        NULL,
+                                                        "Fiducial models",
+                                                        NCM_TYPE_MSET,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_NTHREADS,
+                                   g_param_spec_uint ("nthreads",
+                                                      NULL,
+                                                      "Number of threads to run",
+                                                      0, 100, 0,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_STEP,
+                                   g_param_spec_double ("step",
+                                                        NULL,
+                                                        "Initial derivative step relative to the parameter scale",
+                                                        GSL_DBL_EPSILON, 1.0, NCM_FISHER_DEFAULT_STEP,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_RICHARDSON_LEVELS,
+                                   g_param_spec_uint ("richardson-levels",
+                                                      NULL,
+                                                      "Number of steps used in the Richardson extrapolation",
+                                                      1, 10, NCM_FISHER_DEFAULT_RICHARDSON_LEVELS,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+}
+
+/**
+ * ncm_fisher_new:
+ * @dset: a #NcmDataset
+ * @mset: a #NcmMSet
+ *
+ * Creates a new Fisher matrix calculator for the data in @dset using
+ * the models in @mset. The free parameters of @mset at the moment of
+ * ncm_fisher_compute() define the fiducial model.
+ *
+ * Returns: (transfer full): a new #NcmFisher.
+ */
+NcmFisher *
+ncm_fisher_new (NcmDataset *dset, NcmMSet *mset)
+{
+  NcmFisher *fisher = g_object_new (NCM_TYPE_FISHER,
+                                    "dataset", dset,
+                                    "mset", mset,
+                                    NULL);
+  return fisher;
+}
+
+/**
+ * ncm_fisher_ref:
+ * @fisher: a #NcmFisher
+ *
+ * Increases the reference count of @fisher by one.
+ *
+ * Returns: (transfer full): @fisher.
+ */
+NcmFisher *
+ncm_fisher_ref (NcmFisher *fisher)
+{
+  return g_object_ref (fisher);
+}
+
+/**
+ * ncm_fisher_free:
+ * @fisher: a #NcmFisher
+ *
+ * Atomically decrements the reference count of @fisher by one. If the reference count drops to 0,
+ * all memory allocated by @fisher is released.
+ *
+ */
+void
+ncm_fisher_free (NcmFisher *fisher)
+{
+  g_object_unref (fisher);
+}
+
+/**
+ * ncm_fisher_clear:
+ * @fisher: a #NcmFisher
+ *
+ * Atomically decrements the reference count of @fisher by one. If the reference count drops to 0,
+ * all memory allocated by @fisher is released. Set pointer to NULL.
+ *
+ */
+void
+ncm_fisher_clear (NcmFisher **fisher)
+{
+  g_clear_object (fisher);
+}
+
+/**
+ * ncm_fisher_set_nthreads:
+ * @fisher: a #NcmFisher
+ * @nthreads: number of threads
+ *
+ * Sets the number of threads used to compute the derivatives, at most
+ * @nthreads free parameters are evaluated at the same time. Values
+ * smaller than two run everything in the calling thread.
+ *
+ */
+void
+ncm_fisher_set_nthreads (NcmFisher *fisher, guint nthreads)
+{
+  fisher->nthreads = nthreads;
+}
+
+/**
+ * ncm_fisher_set_step:
+ * @fisher: a #NcmFisher
+ * @step: initial step relative to the parameter scale
+ *
+ * Sets the largest step used in the derivatives, in units of the
+ * scale of each parameter, see ncm_mset_fparam_get_scale().
+ *
+ */
+void
+ncm_fisher_set_step (NcmFisher *fisher, gdouble step)
+{
+  g_assert_cmpfloat (step, >, 0.0);
+  fisher->step = step;
+}
+
+/**
+ * ncm_fisher_set_richardson_levels:
+ * @fisher: a #NcmFisher
+ * @nrich: number of steps
+ *
+ * Sets the number of central differences, each one with half of the
+ * previous step, combined in the Richardson extrapolation. When @nrich
+ * is one a simple central difference is used.
+ *
+ */
+void
+ncm_fisher_set_richardson_levels (NcmFisher *fisher, guint nrich)
+{
+  g_assert_cmpuint (nrich, >, 0);
+  fisher->nrich = nrich;
+}
+
+/**
+ * ncm_fisher_get_nthreads:
+ * @fisher: a #NcmFisher
+ *
+ * Returns: the number of threads used to compute the derivatives.
+ */
+guint
+ncm_fisher_get_nthreads (NcmFisher *fisher)
+{
+  return fisher->nthreads;
+}
+
+/**
+ * ncm_fisher_get_step:
+ * @fisher: a #NcmFisher
+ *
+ * Returns: the initial step relative to the parameter scale.
+ */
+gdouble
+ncm_fisher_get_step (NcmFisher *fisher)
+{
+  return fisher->step;
+}
+
+/**
+ * ncm_fisher_get_richardson_levels:
+ * @fisher: a #NcmFisher
+ *
+ * Returns: the number of steps used in the Richardson extrapolation.
+ */
+guint
+ncm_fisher_get_richardson_levels (NcmFisher *fisher)
+{
+  return fisher->nrich;
+}
+
+static void
+_ncm_fisher_data_eval (NcmData *data, NcmMSet *mset, NcmVector *mu, NcmVector *c)
+{
+  if (NCM_IS_DATA_GAUSS_COV (data))
+  {
+    NcmDataGaussCov *gauss = NCM_DATA_GAUSS_COV (data);
+
+    ncm_data_gauss_cov_eval_mean (gauss, mset, mu);
+    if (c != NULL)
+    {
+      const guint np = ncm_vector_len (mu);
+      NcmMatrix *cov = ncm_matrix_new_data_static (ncm_vector_data (c), np, np);
+
+      ncm_data_gauss_cov_eval_cov (gauss, mset, cov);
+      ncm_matrix_free (cov);
+    }
+  }
+  else
+  {
+    NcmDataGaussDiag *diag = NCM_DATA_GAUSS_DIAG (data);
+
+    ncm_data_gauss_diag_eval_mean (diag, mset, mu);
+    if (c != NULL)
+      ncm_data_gauss_diag_eval_sigma (diag, mset, c);
+  }
+}
+
+/*
+ * Computes the derivatives of the mean (dmu) and of the covariance (dc,
+ * when not NULL) of data with respect to the a-th free parameter. The
+ * central differences D_k with steps h_0 2^{-k} are combined in place
+ * using Neville's algorithm, at stage j the error term O(h^{2j}) is
+ * removed using D_k <- (4^j D_k - D_{k-1}) / (4^j - 1). Returns the
+ * relative difference between the last two extrapolations of the mean.
+ */
+static gdouble
+_ncm_fisher_deriv_data (NcmFisher *fisher, NcmData *data, NcmMSet *mset, guint a, NcmVector *dmu, NcmVector *dc)
+{
+  const guint nrich = fisher->nrich;
+  const guint nmu   = ncm_vector_len (dmu);
+  const guint nc    = (dc != NULL) ? ncm_vector_len (dc) : 0;
+  const gdouble p   = ncm_vector_get (fisher->theta0, a);
+  GPtrArray *Dmu    = g_ptr_array_new_with_free_func ((GDestroyNotify) &ncm_vector_free);
+  GPtrArray *Dc     = g_ptr_array_new_with_free_func ((GDestroyNotify) &ncm_vector_free);
+  NcmVector *mu_m   = ncm_vector_new_aligned (nmu);
+  NcmVector *c_m    = (dc != NULL) ? ncm_vector_new_aligned (nc) : NULL;
+  gdouble h         = fisher->step * ncm_mset_fparam_get_scale (mset, a);
+  gdouble err       = 0.0;
+  guint j, k;
+
+  for (k = 0; k < nrich; k++)
+  {
+    NcmVector *mu_p = ncm_vector_new_aligned (nmu);
+    NcmVector *c_p  = (dc != NULL) ? ncm_vector_new_aligned (nc) : NULL;
+
+    ncm_mset_fparam_set (mset, a, p + h);
+    _ncm_fisher_data_eval (data, mset, mu_p, c_p);
+
+    ncm_mset_fparam_set (mset, a, p - h);
+    _ncm_fisher_data_eval (data, mset, mu_m, c_m);
+
+    ncm_vector_axpby (mu_p, -0.5 / h, mu_m, 0.5 / h);
+    g_ptr_array_add (Dmu, mu_p);
+
+    if (dc != NULL)
+    {
+      ncm_vector_axpby (c_p, -0.5 / h, c_m, 0.5 / h);
+      g_ptr_array_add (Dc, c_p);
+    }
+
+    h *= 0.5;
+  }
+  ncm_mset_fparam_set (mset, a, p);
+
+  for (j = 1; j < nrich; j++)
+  {
+    const gdouble fac = gsl_pow_int (4.0, j);
+
+    for (k = nrich - 1; k >= j; k--)
+    {
+      ncm_vector_axpby (g_ptr_array_index (Dmu, k), -1.0 / (fac - 1.0), g_ptr_array_index (Dmu, k - 1), fac / (fac - 1.0));
+      if (dc != NULL)
+        ncm_vector_axpby (g_ptr_array_index (Dc, k), -1.0 / (fac - 1.0), g_ptr_array_index (Dc, k - 1), fac / (fac - 1.0));
+    }
+  }
+
+  ncm_vector_memcpy (dmu, g_ptr_array_index (Dmu, nrich - 1));
+  if (dc != NULL)
+    ncm_vector_memcpy (dc, g_ptr_array_index (Dc, nrich - 1));
+
+  if (nrich > 1)
+  {
+    gdouble absmin, diff_max, dmu_max;
+
+    ncm_vector_memcpy (mu_m, dmu);
+    ncm_vector_axpby (mu_m, -1.0, g_ptr_array_index (Dmu, nrich - 2), 1.0);
+
+    ncm_vector_get_absminmax (mu_m, &absmin, &diff_max);
+    ncm_vector_get_absminmax (dmu, &absmin, &dmu_max);
+
+    err = (dmu_max > 0.0) ? diff_max / dmu_max : diff_max;
+  }
+
+  g_ptr_array_unref (Dmu);
+  g_ptr_array_unref (Dc);
+  ncm_vector_free (mu_m);
+  if (c_m != NULL)
+    ncm_vector_free (c_m);
+
+  return err;
+}
+
+static void
+_ncm_fisher_eval_col (NcmFisher *fisher, NcmDataset *dset, NcmMSet *mset, guint a)
+{
+  const guint ndata = ncm_dataset_get_length (dset);
+  gdouble err = 0.0;
+  guint i;
+
+  for (i = 0; i < ndata; i++)
+  {
+    NcmFisherDeriv *dd = &g_array_index (fisher->deriv, NcmFisherDeriv, i);
+    NcmVector *dmu     = ncm_matrix_get_row (dd->dmean, a);
+    NcmVector *dc      = (dd->dcov != NULL) ? ncm_matrix_get_row (dd->dcov, a) : NULL;
+    const gdouble err_i = _ncm_fisher_deriv_data (fisher, ncm_dataset_peek_data (dset, i), mset, a, dmu, dc);
+
+    err = GSL_MAX (err, err_i);
+
+    ncm_vector_free (dmu);
+    if (dc != NULL)
+      ncm_vector_free (dc);
+  }
+
+  ncm_vector_set (fisher->deriv_err, a, err);
+}
+
+typedef struct _NcmFisherEval
+{
+  NcmFisher *fisher;
+  NcmSerialize *ser;
+  NcmMemoryPool *mp;
+  GMutex dup_lock;
+} NcmFisherEval;
+
+typedef struct _NcmFisherWorker
+{
+  NcmMSet *mset;
+  NcmDataset *dset;
+} NcmFisherWorker;
+
+static gpointer
+_ncm_fisher_worker_new (gpointer userdata)
+{
+  NcmFisherEval *eval = (NcmFisherEval *) userdata;
+  NcmFisherWorker *w  = g_new (NcmFisherWorker, 1);
+
+  g_mutex_lock (&eval->dup_lock);
+  /* Only the mean and the model dependent covariances are written by the copies. */
+  ncm_dataset_share_payload (eval->fisher->dset, eval->ser);
+
+  w->mset = ncm_mset_dup (eval->fisher->mset, eval->ser);
+  w->dset = ncm_dataset_dup (eval->fisher->dset, eval->ser);
+  ncm_serialize_clear_instances (eval->ser);
+  g_mutex_unlock (&eval->dup_lock);
+
+  return w;
+}
+
+static void
+_ncm_fisher_worker_free (gpointer data)
+{
+  NcmFisherWorker *w = (NcmFisherWorker *) data;
+
+  ncm_mset_clear (&w->mset);
+  ncm_dataset_clear (&w->dset);
+  g_free (w);
+}
+
+static void
+_ncm_fisher_eval_mt (glong i, glong f, gpointer data)
+{
+  NcmFisherEval *eval     = (NcmFisherEval *) data;
+  NcmFisherWorker **w_ptr = ncm_memory_pool_get (eval->mp);
+  NcmFisherWorker *w      = *w_ptr;
+  glong a;
+
+  ncm_mset_fparams_set_vector (w->mset, eval->fisher->theta0);
+  for (a = i; a < f; a++)
+    _ncm_fisher_eval_col (eval->fisher, w->dset, w->mset, a);
+
+  ncm_memory_pool_return (w_ptr);
+}
+
+/*
+ * Removes the information absorbed by the linear nuisance parameters,
+ * F <- F - Jw^T Dw (Dw^T Dw)^{-1} Dw^T Jw, where Dw and Jw are the
+ * whitened design matrix and mean derivatives. With G = Dw^T Dw = U^T U
+ * this is F <- F - T^T T where T = U^{-T} Dw^T Jw.
+ */
+static void
+_ncm_fisher_project_lin (NcmFisher *fisher, NcmMatrix *Dw, NcmMatrix *Jw)
+{
+  const guint nlin  = ncm_matrix_ncols (Dw);
+  const guint nfree = ncm_matrix_ncols (Jw);
+  NcmMatrix *G      = ncm_matrix_new (nlin, nlin);
+  NcmMatrix *T      = ncm_matrix_new (nlin, nfree);
+  gint ret;
+
+  ncm_matrix_dsyrk (G, 'U', 'T', 1.0, Dw, 0.0);
+  ncm_matrix_copy_triangle (G, 'U');
+
+  ret = ncm_matrix_cholesky_decomp (G, 'U');
+  if (ret != 0)
+    g_error ("_ncm_fisher_project_lin[ncm_matrix_cholesky_decomp]: %d, degenerated design matrix.", ret);
+
+  ret = gsl_blas_dgemm (CblasTrans, CblasNoTrans, 1.0, ncm_matrix_gsl (Dw), ncm_matrix_gsl (Jw), 0.0, ncm_matrix_gsl (T));
+  NCM_TEST_GSL_RESULT ("_ncm_fisher_project_lin", ret);
+
+  ncm_matrix_dtrsm (G, 'U', 'T', 1.0, T);
+  ncm_matrix_dsyrk (fisher->F, 'U', 'T', -1.0, T, 1.0);
+
+  ncm_matrix_free (G);
+  ncm_matrix_free (T);
+}
+
+static void
+_ncm_fisher_add_gauss_cov (NcmFisher *fisher, NcmDataGaussCov *gauss, NcmFisherDeriv *dd)
+{
+  const guint nfree = ncm_matrix_nrows (dd->dmean);
+  const guint np    = ncm_matrix_ncols (dd->dmean);
+  NcmMatrix *LLT    = ncm_data_gauss_cov_peek_cholesky (gauss, fisher->mset);
+  NcmMatrix *D      = ncm_data_gauss_cov_peek_lin_design (gauss);
+  NcmMatrix *Jw     = ncm_matrix_new_aligned (np, nfree);
+  guint i, a;
+
+  for (i = 0; i < np; i++)
+  {
+    for (a = 0; a < nfree; a++)
+      ncm_matrix_set (Jw, i, a, ncm_matrix_get (dd->dmean, a, i));
+  }
+
+  /* Jw = L^{-1} J, the mean term is Jw^T Jw. */
+  ncm_matrix_dtrsm (LLT, 'U', 'T', 1.0, Jw);
+  ncm_matrix_dsyrk (fisher->F, 'U', 'T', 1.0, Jw, 1.0);
+
+  if (D != NULL)
+  {
+    NcmMatrix *Dw = ncm_matrix_dup (D);
+
+    ncm_matrix_dtrsm (LLT, 'U', 'T', 1.0, Dw);
+    _ncm_fisher_project_lin (fisher, Dw, Jw);
+
+    ncm_matrix_free (Dw);
+  }
+
+  /*
+   * With M_a = L^{-1} C_a L^{-T} the covariance term is
+   * tr (C^{-1} C_a C^{-1} C_b) / 2 = vec (M_a) . vec (M_b) / 2.
+   */
+  if (dd->dcov != NULL)
+  {
+    NcmMatrix *M = ncm_matrix_dup (dd->dcov);
+
+    for (a = 0; a < nfree; a++)
+    {
+      NcmMatrix *M_a = ncm_matrix_new_data_static (ncm_matrix_ptr (M, a, 0), np, np);
+
+      ncm_matrix_dtrsm (LLT, 'U', 'T', 1.0, M_a);
+      ncm_matrix_transpose (M_a);
+      ncm_matrix_dtrsm (LLT, 'U', 'T', 1.0, M_a);
+
+      ncm_matrix_free (M_a);
+    }
+
+    ncm_matrix_dsyrk (fisher->F, 'U', 'N', 0.5, M, 1.0);
+    ncm_matrix_free (M);
+  }
+
+  ncm_matrix_free (Jw);
+}
+
+static void
+_ncm_fisher_add_gauss_diag (NcmFisher *fisher, NcmDataGaussDiag *diag, NcmFisherDeriv *dd)
+{
+  const guint nfree = ncm_matrix_nrows (dd->dmean);
+  const guint np    = ncm_matrix_ncols (dd->dmean);
+  NcmMatrix *D      = ncm_data_gauss_diag_peek_lin_design (diag);
+  NcmVector *sigma  = ncm_vector_new_aligned (np);
+  NcmMatrix *Jw     = ncm_matrix_new_aligned (np, nfree);
+  guint i, a;
+
+  ncm_data_gauss_diag_eval_sigma (diag, fisher->mset, sigma);
+
+  for (i = 0; i < np; i++)
+  {
+    const gdouble sigma_i = ncm_vector_get (sigma, i);
+    for (a = 0; a < nfree; a++)
+      ncm_matrix_set (Jw, i, a, ncm_matrix_get (dd->dmean, a, i) / sigma_i);
+  }
+
+  ncm_matrix_dsyrk (fisher->F, 'U', 'T', 1.0, Jw, 1.0);
+
+  /* The weighted mean subtraction is a profiled constant offset. */
+  if (diag->wmean || (D != NULL))
+  {
+    const guint nlin = diag->wmean ? 1 : ncm_matrix_ncols (D);
+    NcmMatrix *Dw    = ncm_matrix_new (np, nlin);
+
+    for (i = 0; i < np; i++)
+    {
+      const gdouble sigma_i = ncm_vector_get (sigma, i);
+      for (a = 0; a < nlin; a++)
+        ncm_matrix_set (Dw, i, a, (diag->wmean ? 1.0 : ncm_matrix_get (D, i, a)) / sigma_i);
+    }
+
+    _ncm_fisher_project_lin (fisher, Dw, Jw);
+    ncm_matrix_free (Dw);
+  }
+
+  /* For C = diag (sigma^2) the covariance term is 2 sum_i sigma_a,i sigma_b,i / sigma_i^2. */
+  if (dd->dcov != NULL)
+  {
+    NcmMatrix *S = ncm_matrix_dup (dd->dcov);
+
+    for (a = 0; a < nfree; a++)
+    {
+      for (i = 0; i < np; i++)
+        ncm_matrix_set (S, a, i, ncm_matrix_get (S, a, i) / ncm_vector_get (sigma, i));
+    }
+
+    ncm_matrix_dsyrk (fisher->F, 'U', 'N', 2.0, S, 1.0);
+    ncm_matrix_free (S);
+  }
+
+  ncm_vector_free (sigma);
+  ncm_matrix_free (Jw);
+}
+
+static void
+_ncm_fisher_invert (NcmFisher *fisher)
+{
+  gint ret;
+
+  ncm_matrix_memcpy (fisher->covar, fisher->F);
+
+  ret = ncm_matrix_cholesky_decomp (fisher->covar, 'U');
+  if (ret == 0)
+  {
+    ret = ncm_matrix_cholesky_inverse (fisher->covar, 'U');
+    if (ret != 0)
+      g_error ("_ncm_fisher_invert[ncm_matrix_cholesky_inverse]: %d.", ret);
+    ncm_matrix_copy_triangle (fisher->covar, 'U');
+  }
+  else if (ret > 0)
+  {
+    NcmMatrix *LU      = ncm_matrix_dup (fisher->F);
+    gsl_permutation *p = gsl_permutation_alloc (ncm_matrix_nrows (LU));
+    gint signum;
+    gint ret1;
+
+    g_warning ("_ncm_fisher_invert: Fisher matrix not positive definite, the forecast is not trustworthy.");
+
+    ret1 = gsl_linalg_LU_decomp (ncm_matrix_gsl (LU), p, &signum);
+    NCM_TEST_GSL_RESULT ("_ncm_fisher_invert[gsl_linalg_LU_decomp]", ret1);
+
+    ret1 = gsl_linalg_LU_invert (ncm_matrix_gsl (LU), p, ncm_matrix_gsl (fisher->covar));
+    NCM_TEST_GSL_RESULT ("_ncm_fisher_invert[gsl_linalg_LU_invert]", ret1);
+
+    gsl_permutation_free (p);
+    ncm_matrix_free (LU);
+  }
+  else
+    g_error ("_ncm_fisher_invert[ncm_matrix_cholesky_decomp]: %d.", ret);
+}
+
+/**
+ * ncm_fisher_compute:
+ * @fisher: a #NcmFisher
+ *
+ * Computes the derivatives of the means and covariances of all data
+ * at the current free parameters of #NcmFisher:mset, the Fisher matrix
+ * and its inverse. The #NcmMSet is left at the fiducial point.
+ *
+ */
+void
+ncm_fisher_compute (NcmFisher *fisher)
+{
+  const guint nfree = ncm_mset_fparam_len (fisher->mset);
+  const guint ndata = ncm_dataset_get_length (fisher->dset);
+  guint i;
+
+  if (nfree == 0)
+    g_error ("ncm_fisher_compute: mset object has 0 free parameters.");
+
+  ncm_vector_clear (&fisher->theta0);
+  ncm_vector_clear (&fisher->deriv_err);
+  ncm_matrix_clear (&fisher->F);
+  ncm_matrix_clear (&fisher->covar);
+  g_array_set_size (fisher->deriv, 0);
+
+  fisher->theta0    = ncm_vector_new (nfree);
+  fisher->deriv_err = ncm_vector_new (nfree);
+  fisher->F         = ncm_matrix_new_aligned (nfree, nfree);
+  fisher->covar     = ncm_matrix_new_aligned (nfree, nfree);
+
+  ncm_mset_fparams_get_vector (fisher->mset, fisher->theta0);
+
+  for (i = 0; i < ndata; i++)
+  {
+    NcmData *data     = ncm_dataset_peek_data (fisher->dset, i);
+    NcmFisherDeriv dd = {NULL, NULL};
+    guint np;
+
+    if (NCM_IS_DATA_GAUSS_COV (data))
+    {
+      NcmDataGaussCov *gauss = NCM_DATA_GAUSS_COV (data);
+
+      np = gauss->np;
+      if (ncm_data_gauss_cov_has_cov_func (gauss))
+        dd.dcov = ncm_matrix_new_aligned (nfree, np * np);
+    }
+    else if (NCM_IS_DATA_GAUSS_DIAG (data))
+    {
+      NcmDataGaussDiag *diag = NCM_DATA_GAUSS_DIAG (data);
+
+      np = diag->np;
+      if (ncm_data_gauss_diag_has_sigma_func (diag))
+        dd.dcov = ncm_matrix_new_aligned (nfree, np);
+    }
+    else
+    {
+      g_error ("ncm_fisher_compute: data `%s' is not a NcmDataGaussCov or NcmDataGaussDiag.", ncm_data_peek_desc (data));
+      np = 0;
+    }
+
+    dd.dmean = ncm_matrix_new_aligned (nfree, np);
+    g_array_append_val (fisher->deriv, dd);
+  }
+
+  if ((fisher->nthreads > 1) && (nfree > 1))
+  {
+    NcmFisherEval eval = {fisher, NULL, NULL};
+
+    eval.ser = ncm_serialize_new (NCM_SERIALIZE_OPT_CLEAN_DUP);
+    eval.mp  = ncm_memory_pool_new (&_ncm_fisher_worker_new, &eval, &_ncm_fisher_worker_free);
+    g_mutex_init (&eval.dup_lock);
+
+    /* At most fisher->nthreads parameters are evaluated at the same time. */
+    if (fisher->nthreads < nfree)
+      ncm_func_eval_threaded_loop_nw (&_ncm_fisher_eval_mt, 0, nfree, &eval, fisher->nthreads);
+    else
+      ncm_func_eval_threaded_loop_full (&_ncm_fisher_eval_mt, 0, nfree, &eval);
+
+    ncm_memory_pool_free (eval.mp, TRUE);
+    ncm_serialize_clear (&eval.ser);
+    g_mutex_clear (&eval.dup_lock);
+  }
+  else
+  {
+    guint a;
+
+    for (a = 0; a < nfree; a++)
+      _ncm_fisher_eval_col (fisher, fisher->dset, fisher->mset, a);
+  }
+
+  ncm_mset_fparams_set_vector (fisher->mset, fisher->theta0);
+  ncm_matrix_set_zero (fisher->F);
+
+  for (i = 0; i < ndata; i++)
+  {
+    NcmData *data      = ncm_dataset_peek_data (fisher->dset, i);
+    NcmFisherDeriv *dd = &g_array_index (fisher->deriv, NcmFisherDeriv, i);
+
+    if (NCM_IS_DATA_GAUSS_COV (data))
+    {
+      NcmDataGaussCov *gauss = NCM_DATA_GAUSS_COV (data);
+
+      /* A full evaluation at the fiducial point updates a model dependent design matrix. */
+      if (ncm_data_gauss_cov_lin_len (gauss) > 0)
+      {
+        gdouble m2lnL;
+        ncm_data_m2lnL_val (data, fisher->mset, &m2lnL);
+      }
+
+      _ncm_fisher_add_gauss_cov (fisher, gauss, dd);
+    }
+    else
+    {
+      NcmDataGaussDiag *diag = NCM_DATA_GAUSS_DIAG (data);
+
+      if (ncm_data_gauss_diag_lin_len (diag) > 0)
+      {
+        gdouble m2lnL;
+        ncm_data_m2lnL_val (data, fisher->mset, &m2lnL);
+      }
+
+      _ncm_fisher_add_gauss_diag (fisher, diag, dd);
+    }
+  }
+
+  ncm_matrix_copy_triangle (fisher->F, 'U');
+  _ncm_fisher_invert (fisher);
+}
+
+/**
+ * ncm_fisher_peek_matrix:
+ * @fisher: a #NcmFisher
+ *
+ * Returns: (transfer none) (allow-none): the Fisher matrix computed by the
+ * last call of ncm_fisher_compute().
+ */
+NcmMatrix *
+ncm_fisher_peek_matrix (NcmFisher *fisher)
+{
+  return fisher->F;
+}
+
+/**
+ * ncm_fisher_peek_covar:
+ * @fisher: a #NcmFisher
+ *
+ * Returns: (transfer none) (allow-none): the inverse of the Fisher matrix
+ * computed by the last call of ncm_fisher_compute().
+ */
+NcmMatrix *
+ncm_fisher_peek_covar (NcmFisher *fisher)
+{
+  return fisher->covar;
+}
+
+/**
+ * ncm_fisher_peek_deriv_err:
+ * @fisher: a #NcmFisher
+ *
+ * The error estimate of the derivatives with respect to each free
+ * parameter, the maximum over all data of the relative difference
+ * between the last two Richardson extrapolations. It is zero when
+ * #NcmFisher:richardson-levels is one.
+ *
+ * Returns: (transfer none) (allow-none): the error estimates of the derivatives.
+ */
+NcmVector *
+ncm_fisher_peek_deriv_err (NcmFisher *fisher)
+{
+  return fisher->deriv_err;
+}
+
+/**
+ * ncm_fisher_peek_mean_deriv:
+ * @fisher: a #NcmFisher
+ * @n: data index
+ *
+ * Gets the derivatives of the mean of the @n-th data in #NcmFisher:dataset,
+ * the row $a$ contains the derivative with respect to the $a$-th free
+ * parameter.
+ *
+ * Returns: (transfer none): the mean derivatives of the @n-th data.
+ */
+NcmMatrix *
+ncm_fisher_peek_mean_deriv (NcmFisher *fisher, guint n)
+{
+  g_assert_cmpuint (n, <, fisher->deriv->len);
+  return g_array_index (fisher->deriv, NcmFisherDeriv, n).dmean;
+}
+
+/**
+ * ncm_fisher_log_covar:
+ * @fisher: a #NcmFisher
+ *
+ * Prints the forecast standard deviations and correlations of the free
+ * parameters, see ncm_mset_fparams_log_covar().
+ *
+ */
+void
+ncm_fisher_log_covar (NcmFisher *fisher)
+{
+  g_assert (fisher->covar != NULL);
+  ncm_mset_fparams_log_covar (fisher->mset, fisher->covar);
+}
@@ -0,0 +1,99 @@
+/***************************************************************************
+ *            ncm_fisher.h
+ *
+ *  Tue October 20 16:42:05 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_fisher.h
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _NCM_FISHER_H_
+#define _NCM_FISHER_H_
+
+#include <glib.h>
+#include <glib-object.h>
+#include <numcosmo/build_cfg.h>
+#include <numcosmo/math/ncm_dataset.h>
+#include <numcosmo/math/ncm_mset.h>
+#include <numcosmo/math/ncm_vector.h>
+#include <numcosmo/math/ncm_matrix.h>
+
+G_BEGIN_DECLS
+
+#define NCM_TYPE_FISHER             (ncm_fisher_get_type ())
+#define NCM_FISHER(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), NCM_TYPE_FISHER, NcmFisher))
+#define NCM_FISHER_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), NCM_TYPE_FISHER, NcmFisherClass))
+#define NCM_IS_FISHER(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), NCM_TYPE_FISHER))
+#define NCM_IS_FISHER_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), NCM_TYPE_FISHER))
+#define NCM_FISHER_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), NCM_TYPE_FISHER, NcmFisherClass))
+
+typedef struct _NcmFisherClass NcmFisherClass;
+typedef struct _NcmFisher NcmFisher;
+
+struct _NcmFisherClass
+{
+  /*< private >*/
+  GObjectClass parent_class;
+};
+
+struct _NcmFisher
+{
+  /*< private >*/
+  GObject parent_instance;
+  NcmDataset *dset;
+  NcmMSet *mset;
+  guint nthreads;
+  guint nrich;
+  gdouble step;
+  NcmVector *theta0;
+  NcmVector *deriv_err;
+  GArray *deriv;
+  NcmMatrix *F;
+  NcmMatrix *covar;
+};
+
+GType ncm_fisher_get_type (void) G_GNUC_CONST;
+
+NcmFisher *ncm_fisher_new (NcmDataset *dset, NcmMSet *mset);
+NcmFisher *ncm_fisher_ref (NcmFisher *fisher);
+void ncm_fisher_free (NcmFisher *fisher);
+void ncm_fisher_clear (NcmFisher **fisher);
+
+void ncm_fisher_set_nthreads (NcmFisher *fisher, guint nthreads);
+void ncm_fisher_set_step (NcmFisher *fisher, gdouble step);
+void ncm_fisher_set_richardson_levels (NcmFisher *fisher, guint nrich);
+guint ncm_fisher_get_nthreads (NcmFisher *fisher);
+gdouble ncm_fisher_get_step (NcmFisher *fisher);
+guint ncm_fisher_get_richardson_levels (NcmFisher *fisher);
+
+void ncm_fisher_compute (NcmFisher *fisher);
+
+NcmMatrix *ncm_fisher_peek_matrix (NcmFisher *fisher);
+NcmMatrix *ncm_fisher_peek_covar (NcmFisher *fisher);
+NcmVector *ncm_fisher_peek_deriv_err (NcmFisher *fisher);
+NcmMatrix *ncm_fisher_peek_mean_deriv (NcmFisher *fisher, guint n);
+
+void ncm_fisher_log_covar (NcmFisher *fisher);
+
+#define NCM_FISHER_DEFAULT_STEP (5.0e-2)
+#define NCM_FISHER_DEFAULT_RICHARDSON_LEVELS (4)
+
+G_END_DECLS
+
+#endif /* _NCM_FISHER_H_ */
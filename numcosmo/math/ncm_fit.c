@@ -42,6 +42,7 @@
 #include "math/ncm_util.h"
 #include "math/integral.h"
 #include "math/memory_pool.h"
+#include "math/ncm_workspace.h"
 #include "math/ncm_fit_gsl_ls.h"
 #include "math/ncm_fit_gsl_mm.h"
 #include "math/ncm_fit_gsl_mms.h"
@@ -72,6 +73,7 @@ enum
   PROP_EQC,
   PROP_INEQC,
   PROP_SUBFIT,
+  PROP_CACHE_SIZE,
   PROP_SIZE,
 };
 
@@ -144,6 +146,15 @@ ncm_fit_init (NcmFit *fit)
   g_ptr_array_set_free_func (fit->inequality_constraints, (GDestroyNotify) &ncm_fit_constraint_free);
 
   fit->sub_fit = NULL;
+
+  fit->cache         = NULL;
+  fit->cache_lru     = NULL;
+  fit->cache_key     = NULL;
+  fit->cache_version = 0;
+  fit->cache_npriors = 0;
+  fit->cache_size    = 0;
+  fit->cache_nhit    = 0;
+  fit->cache_nmiss   = 0;
 }
 
 static void
@@ -249,6 +260,9 @@ _ncm_fit_set_property (GObject *object, guint prop_id, const GValue *value, GPar
     case PROP_SUBFIT:
       ncm_fit_set_sub_fit (fit, g_value_get_object (value));
       break;
+    case PROP_CACHE_SIZE:
+      ncm_fit_set_cache_size (fit, g_value_get_uint (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -296,6 +310,9 @@ _ncm_fit_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec
     case PROP_SUBFIT:
       g_value_set_object (value, fit->sub_fit);
       break;
+    case PROP_CACHE_SIZE:
+      g_value_set_uint (value, ncm_fit_get_cache_size (fit));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -316,6 +333,8 @@ ncm_fit_dispose (GObject *object)
 
   ncm_fit_clear (&fit->sub_fit);
 
+  ncm_fit_set_cache_size (fit, 0);
+
   /* Chain up : end */
   G_OBJECT_CLASS (ncm_fit_parent_class)->dispose (object);
 }
@@ -427,8 +446,18 @@ ncm_fit_class_init (NcmFitClass *klass)
                                                         "Subsidiary fit",
                                                         NCM_TYPE_FIT,
                                                         G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+
+  g_object_class_install_property (object_class,
+                                   PROP_CACHE_SIZE,
+                                   g_param_spec_uint ("cache-size",
+                                                      NULL,
+                                                      "Maximum number of points in the likelihood cache",
+                                                      0, G_MAXUINT32, 0,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
 }
 
+static void _ncm_fit_cache_drop (NcmFit *fit);
+
 static void
 _ncm_fit_reset (NcmFit *fit)
 {
@@ -448,6 +477,12 @@ _ncm_fit_reset (NcmFit *fit)
                            NCM_FIT_GET_CLASS (fit)->is_least_squares);
     ncm_fit_state_reset (fit->fstate);
   }
+
+  /*
+   * The data may have been resampled or the fixed parameters changed since
+   * the last run, the cached points are no longer valid.
+   */
+  _ncm_fit_cache_drop (fit);
 }
 
 /**
@@ -663,6 +698,9 @@ ncm_fit_set_grad_type (NcmFit *fit, NcmFitGradType gtype)
 {
   fit->grad.gtype = gtype;
 
+  /* The cached gradients were computed with the previous method. */
+  _ncm_fit_cache_drop (fit);
+
   if ((gtype == NCM_FIT_GRAD_ANALYTICAL) && !ncm_likelihood_has_m2lnL_grad (fit->lh))
     g_error ("Likelihood do not support analytical gradient, try to use a numerical algorithm.");
 
@@ -794,6 +832,332 @@ ncm_fit_get_params_reltol (NcmFit *fit)
   return fit->params_reltol;
 }
 
+typedef struct _NcmFitCacheEntry
+{
+  GBytes *key;
+  GList *link;
+  gboolean has_m2lnL;
+  gdouble m2lnL;
+  NcmVector *grad;
+  NcmVector *f;
+} NcmFitCacheEntry;
+
+static void
+_ncm_fit_cache_entry_free (gpointer data)
+{
+  NcmFitCacheEntry *entry = (NcmFitCacheEntry *) data;
+
+  g_bytes_unref (entry->key);
+  ncm_vector_clear (&entry->grad);
+  ncm_vector_clear (&entry->f);
+
+  g_slice_free (NcmFitCacheEntry, entry);
+}
+
+static void
+_ncm_fit_cache_drop (NcmFit *fit)
+{
+  if (fit->cache != NULL)
+  {
+    g_queue_clear (fit->cache_lru);
+    g_hash_table_remove_all (fit->cache);
+  }
+}
+
+static void
+_ncm_fit_cache_evict (NcmFit *fit, guint max_len)
+{
+  while (g_queue_get_length (fit->cache_lru) > max_len)
+  {
+    NcmFitCacheEntry *entry = g_queue_pop_tail (fit->cache_lru);
+    g_hash_table_remove (fit->cache, entry->key);
+  }
+}
+
+/*
+ * The key is the full parameter vector of the mset, so changing a fixed
+ * parameter also misses the cache. Comparison is bitwise (exact match).
+ * All points are dropped when the dataset version or the number of
+ * priors changed since they were computed.
+ */
+static NcmFitCacheEntry *
+_ncm_fit_cache_peek (NcmFit *fit)
+{
+  const guint total_len = ncm_mset_total_len (fit->mset);
+  const guint64 version = ncm_dataset_get_version (fit->lh->dset);
+  const guint npriors   = ncm_likelihood_priors_length_f (fit->lh) + ncm_likelihood_priors_length_m2lnL (fit->lh);
+  NcmFitCacheEntry *entry;
+  GBytes *key;
+
+  if ((fit->cache_key == NULL) || (ncm_vector_len (fit->cache_key) != total_len))
+  {
+    _ncm_fit_cache_drop (fit);
+    ncm_vector_clear (&fit->cache_key);
+    fit->cache_key = ncm_vector_new (total_len);
+  }
+
+  if ((version != fit->cache_version) || (npriors != fit->cache_npriors))
+  {
+    _ncm_fit_cache_drop (fit);
+    fit->cache_version = version;
+    fit->cache_npriors = npriors;
+  }
+
+  ncm_mset_param_get_vector (fit->mset, fit->cache_key);
+
+  key   = g_bytes_new_static (ncm_vector_data (fit->cache_key), sizeof (gdouble) * total_len);
+  entry = g_hash_table_lookup (fit->cache, key);
+  g_bytes_unref (key);
+
+  if (entry != NULL)
+  {
+    g_queue_unlink (fit->cache_lru, entry->link);
+    g_queue_push_head_link (fit->cache_lru, entry->link);
+  }
+
+  return entry;
+}
+
+static NcmFitCacheEntry *
+_ncm_fit_cache_fetch (NcmFit *fit)
+{
+  NcmFitCacheEntry *entry = _ncm_fit_cache_peek (fit);
+
+  if (entry == NULL)
+  {
+    entry = g_slice_new0 (NcmFitCacheEntry);
+
+    entry->key = g_bytes_new (ncm_vector_data (fit->cache_key), sizeof (gdouble) * ncm_vector_len (fit->cache_key));
+    g_queue_push_head (fit->cache_lru, entry);
+    entry->link = g_queue_peek_head_link (fit->cache_lru);
+
+    g_hash_table_insert (fit->cache, entry->key, entry);
+    _ncm_fit_cache_evict (fit, fit->cache_size);
+  }
+
+  return entry;
+}
+
+/**
+ * ncm_fit_set_cache_size:
+ * @fit: a #NcmFit
+ * @cache_size: maximum number of cached points
+ *
+ * Sets the maximum number of parameter points kept in the likelihood
+ * cache of @fit. For each point the cache stores the value of $-2\ln(L)$,
+ * its gradient and the least squares residual vector, whichever were
+ * computed. When full, the least recently used point is discarded.
+ * Setting @cache_size to zero disables the cache.
+ *
+ * The cache is emptied by ncm_fit_reset() (and therefore at the
+ * beginning of every ncm_fit_run()), when the gradient method is changed
+ * and whenever the version of the #NcmDataset changes (see
+ * ncm_dataset_get_version()), e.g., after a resample or after a
+ * #NcmDataEmu is trained. Changes in the models that are not reflected
+ * in the parameters of the #NcmMSet, or in a #NcmData that does not
+ * call ncm_data_mark_changed(), are not detected, in these cases
+ * ncm_fit_cache_clear() must be called before evaluating @fit.
+ *
+ */
+void
+ncm_fit_set_cache_size (NcmFit *fit, guint cache_size)
+{
+  if (cache_size == 0)
+  {
+    g_clear_pointer (&fit->cache, g_hash_table_unref);
+    if (fit->cache_lru != NULL)
+    {
+      g_queue_free (fit->cache_lru);
+      fit->cache_lru = NULL;
+    }
+    ncm_vector_clear (&fit->cache_key);
+  }
+  else if (fit->cache == NULL)
+  {
+    fit->cache     = g_hash_table_new_full (&g_bytes_hash, &g_bytes_equal, NULL, &_ncm_fit_cache_entry_free);
+    fit->cache_lru = g_queue_new ();
+  }
+  else
+    _ncm_fit_cache_evict (fit, cache_size);
+
+  fit->cache_size = cache_size;
+}
+
+/**
+ * ncm_fit_get_cache_size:
+ * @fit: a #NcmFit
+ *
+ * Returns: the maximum number of points in the likelihood cache of @fit.
+ */
+guint
+ncm_fit_get_cache_size (NcmFit *fit)
+{
+  return fit->cache_size;
+}
+
+/**
+ * ncm_fit_cache_clear:
+ * @fit: a #NcmFit
+ *
+ * Removes all points from the likelihood cache and resets its
+ * hit/miss counters.
+ *
+ */
+void
+ncm_fit_cache_clear (NcmFit *fit)
+{
+  _ncm_fit_cache_drop (fit);
+  fit->cache_nhit  = 0;
+  fit->cache_nmiss = 0;
+}
+
+/**
+ * ncm_fit_cache_get_stats:
+ * @fit: a #NcmFit
+ * @nhit: (out): number of cache hits
+ * @nmiss: (out): number of cache misses
+ *
+ * Gets the number of evaluations answered by the likelihood cache (@nhit)
+ * and the number of evaluations that had to be computed (@nmiss) since
+ * the last call to ncm_fit_cache_clear().
+ *
+ */
+void
+ncm_fit_cache_get_stats (NcmFit *fit, gulong *nhit, gulong *nmiss)
+{
+  *nhit  = fit->cache_nhit;
+  *nmiss = fit->cache_nmiss;
+}
+
+/**
+ * ncm_fit_cache_m2lnL_val:
+ * @fit: a #NcmFit
+ * @m2lnL: (out): minus two times the logarithm base e of the likelihood.
+ *
+ * Same as ncm_fit_m2lnL_val() but using the likelihood cache, which must
+ * be enabled.
+ *
+ */
+void
+ncm_fit_cache_m2lnL_val (NcmFit *fit, gdouble *m2lnL)
+{
+  NcmFitCacheEntry *entry = _ncm_fit_cache_peek (fit);
+
+  if ((entry != NULL) && entry->has_m2lnL)
+  {
+    fit->cache_nhit++;
+    *m2lnL = entry->m2lnL;
+    return;
+  }
+
+  fit->cache_nmiss++;
+  ncm_likelihood_m2lnL_val (fit->lh, fit->mset, m2lnL);
+  fit->fstate->func_eval++;
+
+  entry = _ncm_fit_cache_fetch (fit);
+  entry->m2lnL     = *m2lnL;
+  entry->has_m2lnL = TRUE;
+}
+
+/**
+ * ncm_fit_cache_ls_f:
+ * @fit: a #NcmFit
+ * @f: a #NcmVector
+ *
+ * Same as ncm_fit_ls_f() but using the likelihood cache, which must
+ * be enabled.
+ *
+ */
+void
+ncm_fit_cache_ls_f (NcmFit *fit, NcmVector *f)
+{
+  NcmFitCacheEntry *entry = _ncm_fit_cache_peek (fit);
+
+  if ((entry != NULL) && (entry->f != NULL))
+  {
+    fit->cache_nhit++;
+    ncm_vector_memcpy (f, entry->f);
+    return;
+  }
+
+  fit->cache_nmiss++;
+  ncm_likelihood_leastsquares_f (fit->lh, fit->mset, f);
+  fit->fstate->func_eval++;
+
+  entry = _ncm_fit_cache_fetch (fit);
+  if (entry->f == NULL)
+    entry->f = ncm_vector_dup (f);
+  else
+    ncm_vector_memcpy (entry->f, f);
+}
+
+/**
+ * ncm_fit_cache_m2lnL_grad:
+ * @fit: a #NcmFit
+ * @df: a #NcmVector
+ *
+ * Same as ncm_fit_m2lnL_grad() but using the likelihood cache, which must
+ * be enabled.
+ *
+ */
+void
+ncm_fit_cache_m2lnL_grad (NcmFit *fit, NcmVector *df)
+{
+  NcmFitCacheEntry *entry = _ncm_fit_cache_peek (fit);
+
+  if ((entry != NULL) && (entry->grad != NULL))
+  {
+    fit->cache_nhit++;
+    ncm_vector_memcpy (df, entry->grad);
+    return;
+  }
+
+  fit->cache_nmiss++;
+  fit->grad.m2lnL_grad (fit, df);
+
+  /* The numerical gradient evaluates other points, the entry must be fetched again. */
+  entry = _ncm_fit_cache_fetch (fit);
+  if (entry->grad == NULL)
+    entry->grad = ncm_vector_dup (df);
+  else
+    ncm_vector_memcpy (entry->grad, df);
+}
+
+/**
+ * ncm_fit_cache_m2lnL_val_grad:
+ * @fit: a #NcmFit
+ * @result: (out): minus two times the logarithm base e of the likelihood.
+ * @df: a #NcmVector
+ *
+ * Same as ncm_fit_m2lnL_val_grad() but using the likelihood cache, which
+ * must be enabled.
+ *
+ */
+void
+ncm_fit_cache_m2lnL_val_grad (NcmFit *fit, gdouble *result, NcmVector *df)
+{
+  NcmFitCacheEntry *entry = _ncm_fit_cache_peek (fit);
+
+  if ((entry != NULL) && entry->has_m2lnL && (entry->grad != NULL))
+  {
+    fit->cache_nhit++;
+    *result = entry->m2lnL;
+    ncm_vector_memcpy (df, entry->grad);
+    return;
+  }
+
+  fit->cache_nmiss++;
+  fit->grad.m2lnL_val_grad (fit, result, df);
+
+  entry = _ncm_fit_cache_fetch (fit);
+  entry->m2lnL     = *result;
+  entry->has_m2lnL = TRUE;
+  if (entry->grad == NULL)
+    entry->grad = ncm_vector_dup (df);
+  else
+    ncm_vector_memcpy (entry->grad, df);
+}
+
 /**
  * ncm_fit_params_set_vector:
  * @fit: a #NcmFit.
@@ -1357,6 +1721,17 @@ ncm_fit_log_info (NcmFit *fit)
   ncm_dataset_log_info (fit->lh->dset);
   ncm_mset_pretty_log (fit->mset);
 
+  if (fit->cache_size > 0)
+  {
+    const gulong ntot = fit->cache_nhit + fit->cache_nmiss;
+    ncm_cfg_msg_sepa ();
+    g_message ("# Likelihood cache:\n");
+    g_message ("#   - size:     %u\n", fit->cache_size);
+    g_message ("#   - hits:     %lu\n", fit->cache_nhit);
+    g_message ("#   - misses:   %lu\n", fit->cache_nmiss);
+    g_message ("#   - hit rate: %6.2f%%\n", (ntot > 0) ? (100.0 * fit->cache_nhit) / ntot : 0.0);
+  }
+
   if (FALSE)
   {
     gdouble ks_test, mean, sd, skew, kurtosis, max;
@@ -1553,7 +1928,8 @@ ncm_fit_m2lnL_hessian_nd_ce (NcmFit *fit, NcmMatrix *hessian)
 {
   guint i;
   guint fparam_len = ncm_mset_fparam_len (fit->mset);
-  NcmVector *tmp = ncm_vector_new (fparam_len);
+  NcmWorkspace *ws = ncm_workspace_peek ();
+  NcmVector *tmp   = ncm_workspace_borrow_vector (ws, fparam_len);
 
   for (i = 0; i < fparam_len; i++)
   {
@@ -1580,7 +1956,7 @@ ncm_fit_m2lnL_hessian_nd_ce (NcmFit *fit, NcmMatrix *hessian)
     ncm_vector_free (row);
   }
 
-  ncm_vector_free (tmp);
+  ncm_workspace_return_vector (ws, tmp);
   fit->fstate->grad_eval++;
 }
 
@@ -2112,6 +2488,128 @@ ncm_fit_numdiff_m2lnL_lndet_covar (NcmFit *fit)
 }
 
 
+/**
+ * ncm_fit_m2lnL_block_time:
+ * @fit: a #NcmFit
+ * @block: (element-type guint): free parameters indices
+ * @ntries: number of evaluations
+ *
+ * Estimates the mean wall time spent to compute $-2\ln(L)$ after changing
+ * only the free parameters listed in @block. Each parameter in @block is
+ * moved by a small fraction of its scale before each of the @ntries evaluations,
+ * in this way only the objects depending on these parameters are re-prepared.
+ * The free parameters are restored before returning.
+ *
+ * Returns: the mean time (in seconds) of one evaluation.
+ */
+gdouble
+ncm_fit_m2lnL_block_time (NcmFit *fit, GArray *block, guint ntries)
+{
+  const guint fparam_len = ncm_mset_fparam_len (fit->mset);
+  NcmVector *theta       = ncm_vector_new (fparam_len);
+  GTimer *block_timer    = g_timer_new ();
+  gdouble total_time     = 0.0;
+  gdouble m2lnL;
+  guint t;
+
+  g_assert_cmpuint (ntries, >, 0);
+
+  ncm_mset_fparams_get_vector (fit->mset, theta);
+  ncm_fit_m2lnL_val (fit, &m2lnL);
+
+  for (t = 0; t < ntries; t++)
+  {
+    const gdouble sign = (t % 2 == 0) ? 1.0 : -1.0;
+    guint j;
+
+    for (j = 0; j < block->len; j++)
+    {
+      const guint n         = g_array_index (block, guint, j);
+      const gdouble p       = ncm_vector_get (theta, n);
+      const gdouble p_scale = ncm_mset_fparam_get_scale (fit->mset, n);
+      const gdouble lb      = ncm_mset_fparam_get_lower_bound (fit->mset, n);
+      const gdouble ub      = ncm_mset_fparam_get_upper_bound (fit->mset, n);
+      
+      ncm_mset_fparam_set (fit->mset, n, GSL_MIN (GSL_MAX (p + sign * 1.0e-3 * p_scale, lb), ub));
+    }
+
+    g_timer_start (block_timer);
+    ncm_fit_m2lnL_val (fit, &m2lnL);
+    total_time += g_timer_elapsed (block_timer, NULL);
+  }
+
+  ncm_mset_fparams_set_vector (fit->mset, theta);
+
+  g_timer_destroy (block_timer);
+  ncm_vector_free (theta);
+
+  return total_time / ntries;
+}
+
+/**
+ * ncm_fit_fparams_blocks_oversampling:
+ * @fit: a #NcmFit
+ * @max_os: maximum oversampling factor
+ * @block_os: (out) (transfer full) (element-type guint): oversampling factor of each block
+ * @block_time: (out) (transfer full) (element-type gdouble): mean evaluation time of each block
+ *
+ * Splits the free parameters in blocks using ncm_mset_fparams_get_blocks(),
+ * i.e., one block per model, and measures the cost of each block using
+ * ncm_fit_m2lnL_block_time(). The blocks are returned sorted from the 
+ * slowest to the fastest and the oversampling factor of each block is the 
+ * ratio between the slowest time and its own time, truncated to the interval
+ * [1, @max_os]. This is the input used by the fast/slow parameter blocking in
+ * the samplers.
+ *
+ * Returns: (transfer full) (element-type GArray): the free parameters blocks.
+ */
+GPtrArray *
+ncm_fit_fparams_blocks_oversampling (NcmFit *fit, guint max_os, GArray **block_os, GArray **block_time)
+{
+  GPtrArray *blocks = ncm_mset_fparams_get_blocks (fit->mset);
+  const guint nblocks = blocks->len;
+  gdouble *btime = g_new (gdouble, nblocks);
+  guint i;
+
+  g_assert_cmpuint (max_os, >, 0);
+
+  for (i = 0; i < nblocks; i++)
+    btime[i] = ncm_fit_m2lnL_block_time (fit, g_ptr_array_index (blocks, i), NCM_FIT_BLOCK_TIME_NTRIES);
+
+  /* Insertion sort, slowest blocks first. */
+  for (i = 1; i < nblocks; i++)
+  {
+    gpointer block_i = g_ptr_array_index (blocks, i);
+    const gdouble t_i = btime[i];
+    gint j = i - 1;
+
+    while (j >= 0 && btime[j] < t_i)
+    {
+      btime[j + 1] = btime[j];
+      g_ptr_array_index (blocks, j + 1) = g_ptr_array_index (blocks, j);
+      j--;
+    }
+    btime[j + 1] = t_i;
+    g_ptr_array_index (blocks, j + 1) = block_i;
+  }
+
+  *block_os   = g_array_sized_new (FALSE, FALSE, sizeof (guint), nblocks);
+  *block_time = g_array_sized_new (FALSE, FALSE, sizeof (gdouble), nblocks);
+
+  for (i = 0; i < nblocks; i++)
+  {
+    const gdouble ratio = (btime[i] > 0.0) ? (btime[0] / btime[i]) : max_os;
+    const guint os = GSL_MIN (GSL_MAX (floor (ratio), 1.0), max_os);
+
+    g_array_append_val (*block_os, os);
+    g_array_append_val (*block_time, btime[i]);
+  }
+
+  g_free (btime);
+
+  return blocks;
+}
+
 /**
  * ncm_fit_residual_ks_test:
  * @fit: a #NcmFit.
@@ -2462,8 +2960,9 @@ ncm_fit_function_error (NcmFit *fit, NcmMSetFunc *func, gdouble *x, gboolean pre
   }
   else
   {
-    NcmVector *v = ncm_mset_func_numdiff_fparams (func, fit->mset, x, NULL);
-    NcmVector *tmp1 = ncm_vector_dup (v);
+    NcmWorkspace *ws = ncm_workspace_peek ();
+    NcmVector *v     = ncm_mset_func_numdiff_fparams (func, fit->mset, x, NULL);
+    NcmVector *tmp1  = ncm_workspace_borrow_vector (ws, ncm_vector_len (v));
     gdouble result;
     gint ret;
 
@@ -2480,8 +2979,8 @@ ncm_fit_function_error (NcmFit *fit, NcmMSetFunc *func, gdouble *x, gboolean pre
     if (pretty_print)
       g_message ("# % -12.4g +/- % -12.4g\n", *f, *sigma_f);
 
+    ncm_workspace_return_vector (ws, tmp1);
     ncm_vector_free (v);
-    ncm_vector_free (tmp1);
 
     return;
   }
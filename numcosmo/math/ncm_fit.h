@@ -161,6 +161,14 @@ struct _NcmFit
   GPtrArray *equality_constraints;
   GPtrArray *inequality_constraints;
   NcmFit *sub_fit;
+  GHashTable *cache;
+  GQueue *cache_lru;
+  NcmVector *cache_key;
+  guint64 cache_version;
+  guint cache_npriors;
+  guint cache_size;
+  gulong cache_nhit;
+  gulong cache_nmiss;
 };
 
 struct _NcmFitConstraint
@@ -199,6 +207,15 @@ gdouble ncm_fit_get_m2lnL_reltol (NcmFit *fit);
 gdouble ncm_fit_get_m2lnL_abstol (NcmFit *fit);
 gdouble ncm_fit_get_params_reltol (NcmFit *fit);
 
+void ncm_fit_set_cache_size (NcmFit *fit, guint cache_size);
+guint ncm_fit_get_cache_size (NcmFit *fit);
+void ncm_fit_cache_clear (NcmFit *fit);
+void ncm_fit_cache_get_stats (NcmFit *fit, gulong *nhit, gulong *nmiss);
+void ncm_fit_cache_m2lnL_val (NcmFit *fit, gdouble *m2lnL);
+void ncm_fit_cache_ls_f (NcmFit *fit, NcmVector *f);
+void ncm_fit_cache_m2lnL_grad (NcmFit *fit, NcmVector *df);
+void ncm_fit_cache_m2lnL_val_grad (NcmFit *fit, gdouble *result, NcmVector *df);
+
 G_INLINE_FUNC void ncm_fit_params_set (NcmFit *fit, guint i, const gdouble x);
 G_INLINE_FUNC void ncm_fit_params_set_vector (NcmFit *fit, NcmVector *x);
 G_INLINE_FUNC void ncm_fit_params_set_vector_offset (NcmFit *fit, NcmVector *x, guint offset);
@@ -259,6 +276,8 @@ void ncm_fit_numdiff_m2lnL_hessian (NcmFit *fit, NcmMatrix *H, gdouble reltol);
 void ncm_fit_numdiff_m2lnL_covar (NcmFit *fit);
 void ncm_fit_ls_covar (NcmFit *fit);
 gdouble ncm_fit_numdiff_m2lnL_lndet_covar (NcmFit *fit);
+gdouble ncm_fit_m2lnL_block_time (NcmFit *fit, GArray *block, guint ntries);
+GPtrArray *ncm_fit_fparams_blocks_oversampling (NcmFit *fit, guint max_os, GArray **block_os, GArray **block_time);
 
 gdouble ncm_fit_covar_var (NcmFit *fit, NcmModelID mid, guint pid);
 gdouble ncm_fit_covar_sd (NcmFit *fit, NcmModelID mid, guint pid);
@@ -288,6 +307,7 @@ gdouble ncm_fit_function_cov (NcmFit *fit, NcmMSetFunc *func1, gdouble z1, NcmMS
 #define NCM_FIT_DEFAULT_M2LNL_ABSTOL (0.0)
 #define NCM_FIT_DEFAULT_PARAMS_RELTOL (1e-5)
 #define NCM_FIT_DEFAULT_MAXITER 10000
+#define NCM_FIT_BLOCK_TIME_NTRIES 3
 
 G_END_DECLS
 
@@ -359,27 +379,43 @@ ncm_fit_priors_m2lnL_val (NcmFit *fit, gdouble *priors_m2lnL)
 G_INLINE_FUNC void
 ncm_fit_m2lnL_val (NcmFit *fit, gdouble *m2lnL)
 {
-  ncm_likelihood_m2lnL_val (fit->lh, fit->mset, m2lnL);
-  fit->fstate->func_eval++;
+  if (fit->cache_size > 0)
+    ncm_fit_cache_m2lnL_val (fit, m2lnL);
+  else
+  {
+    ncm_likelihood_m2lnL_val (fit->lh, fit->mset, m2lnL);
+    fit->fstate->func_eval++;
+  }
 }
 
 G_INLINE_FUNC void
 ncm_fit_ls_f (NcmFit *fit, NcmVector *f)
 {
-  ncm_likelihood_leastsquares_f (fit->lh, fit->mset, f);
-  fit->fstate->func_eval++;
+  if (fit->cache_size > 0)
+    ncm_fit_cache_ls_f (fit, f);
+  else
+  {
+    ncm_likelihood_leastsquares_f (fit->lh, fit->mset, f);
+    fit->fstate->func_eval++;
+  }
 }
 
 G_INLINE_FUNC void
 ncm_fit_m2lnL_grad (NcmFit *fit, NcmVector *df)
 {
-  fit->grad.m2lnL_grad (fit, df);
+  if (fit->cache_size > 0)
+    ncm_fit_cache_m2lnL_grad (fit, df);
+  else
+    fit->grad.m2lnL_grad (fit, df);
 }
 
 G_INLINE_FUNC void
 ncm_fit_m2lnL_val_grad (NcmFit *fit, gdouble *result, NcmVector *df)
 {
-  fit->grad.m2lnL_val_grad (fit, result, df);
+  if (fit->cache_size > 0)
+    ncm_fit_cache_m2lnL_val_grad (fit, result, df);
+  else
+    fit->grad.m2lnL_val_grad (fit, result, df);
 }
 
 G_INLINE_FUNC void
@@ -40,9 +40,11 @@
 #include "math/ncm_fit_esmcmc.h"
 #include "math/ncm_cfg.h"
 #include "math/ncm_func_eval.h"
+#include "math/ncm_workspace.h"
 #include "ncm_enum_types.h"
 
 #include <gsl/gsl_statistics_double.h>
+#include <gsl/gsl_randist.h>
 
 enum
 {
@@ -55,6 +57,8 @@ enum
   PROP_NTHREADS,
   PROP_DATA_FILE,
   PROP_FUNCS_ARRAY,
+  PROP_FAST_SLOW,
+  PROP_MAX_OVERSAMPLING,
 };
 
 G_DEFINE_TYPE (NcmFitESMCMC, ncm_fit_esmcmc, G_TYPE_OBJECT);
@@ -92,6 +96,10 @@ ncm_fit_esmcmc_init (NcmFitESMCMC *esmcmc)
   esmcmc->jumps           = NULL;
   esmcmc->accepted        = g_array_new (TRUE, TRUE, sizeof (gboolean));
   esmcmc->offboard        = g_array_new (TRUE, TRUE, sizeof (gboolean));
+  esmcmc->blocks          = NULL;
+  esmcmc->block_os        = NULL;
+  esmcmc->fast_rand       = NULL;
+  esmcmc->fast_accepted   = g_array_new (TRUE, TRUE, sizeof (guint));
 
   esmcmc->funcs_oa        = NULL;
   esmcmc->funcs_oa_file   = NULL;
@@ -103,10 +111,15 @@ ncm_fit_esmcmc_init (NcmFitESMCMC *esmcmc)
   esmcmc->ntotal          = 0;
   esmcmc->naccepted       = 0;
   esmcmc->noffboard       = 0;
+  esmcmc->nfast_rand      = 0;
+  esmcmc->nfast_steps     = 0;
+  esmcmc->nfast_total     = 0;
+  esmcmc->nfast_accepted  = 0;
+  esmcmc->max_os          = 0;
+  esmcmc->fast_slow       = FALSE;
   esmcmc->started         = FALSE;
 
   g_mutex_init (&esmcmc->dup_fit);
-  g_mutex_init (&esmcmc->resample_lock);
   g_mutex_init (&esmcmc->update_lock);
   g_cond_init (&esmcmc->write_cond);
 }
@@ -121,6 +134,11 @@ _ncm_fit_esmcmc_constructed (GObject *object)
     guint k;
 
     g_assert_cmpint (esmcmc->nwalkers, >, 0);
+    if (esmcmc->fast_slow && (esmcmc->nwalkers < 4))
+      g_error ("ncm_fit_esmcmc_set_fast_slow: the fast/slow blocking needs at least four walkers, "
+               "the sub-step widths are estimated from the complementary half of the ensemble [nwalkers = %d].", 
+               esmcmc->nwalkers);
+
     esmcmc->fparam_len = ncm_mset_fparam_len (esmcmc->fit->mset);
     {
       const guint nfuncs    = (esmcmc->funcs_oa != NULL) ? esmcmc->funcs_oa->len : 0;
@@ -178,6 +196,7 @@ _ncm_fit_esmcmc_constructed (GObject *object)
     esmcmc->jumps = ncm_vector_new (esmcmc->nwalkers);
     g_array_set_size (esmcmc->accepted, esmcmc->nwalkers);
     g_array_set_size (esmcmc->offboard, esmcmc->nwalkers);
+    g_array_set_size (esmcmc->fast_accepted, esmcmc->nwalkers);
     
     if (esmcmc->walker == NULL)
       esmcmc->walker = ncm_fit_esmcmc_walker_new_from_name ("NcmFitESMCMCWalkerStretch");
@@ -218,6 +237,12 @@ ncm_fit_esmcmc_set_property (GObject *object, guint prop_id, const GValue *value
     case PROP_DATA_FILE:
       ncm_fit_esmcmc_set_data_file (esmcmc, g_value_get_string (value));
       break;
+    case PROP_FAST_SLOW:
+      ncm_fit_esmcmc_set_fast_slow (esmcmc, g_value_get_boolean (value));
+      break;
+    case PROP_MAX_OVERSAMPLING:
+      ncm_fit_esmcmc_set_max_oversampling (esmcmc, g_value_get_uint (value));
+      break;
     case PROP_FUNCS_ARRAY:
     {
       esmcmc->funcs_oa = g_value_dup_boxed (value);
@@ -272,6 +297,12 @@ ncm_fit_esmcmc_get_property (GObject *object, guint prop_id, GValue *value, GPar
     case PROP_FUNCS_ARRAY:
       g_value_set_boxed (value, esmcmc->funcs_oa);
       break;
+    case PROP_FAST_SLOW:
+      g_value_set_boolean (value, esmcmc->fast_slow);
+      break;
+    case PROP_MAX_OVERSAMPLING:
+      g_value_set_uint (value, esmcmc->max_os);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -306,6 +337,11 @@ ncm_fit_esmcmc_dispose (GObject *object)
   g_clear_pointer (&esmcmc->accepted, g_array_unref);
   g_clear_pointer (&esmcmc->offboard, g_array_unref);
 
+  g_clear_pointer (&esmcmc->blocks, g_ptr_array_unref);
+  g_clear_pointer (&esmcmc->block_os, g_array_unref);
+  g_clear_pointer (&esmcmc->fast_accepted, g_array_unref);
+  ncm_matrix_clear (&esmcmc->fast_rand);
+
   if (esmcmc->walker_pool != NULL)
   {
     ncm_memory_pool_free (esmcmc->walker_pool, TRUE);
@@ -322,7 +358,6 @@ ncm_fit_esmcmc_finalize (GObject *object)
   NcmFitESMCMC *esmcmc = NCM_FIT_ESMCMC (object);
 
   g_mutex_clear (&esmcmc->dup_fit);
-  g_mutex_clear (&esmcmc->resample_lock);
   g_mutex_clear (&esmcmc->update_lock);
   g_cond_clear (&esmcmc->write_cond);
   
@@ -399,12 +434,27 @@ ncm_fit_esmcmc_class_init (NcmFitESMCMCClass *klass)
                                                        "Functions array",
                                                        NCM_TYPE_OBJ_ARRAY,
                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_FAST_SLOW,
+                                   g_param_spec_boolean ("fast-slow",
+                                                         NULL,
+                                                         "Whether to use fast/slow parameter blocking",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_MAX_OVERSAMPLING,
+                                   g_param_spec_uint ("max-oversampling",
+                                                      NULL,
+                                                      "Maximum oversampling factor of the fast blocks",
+                                                      1, G_MAXUINT32, 20,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
 }
 
 typedef struct _NcmFitESMCMCWorker
 {
   NcmFit *fit;
   NcmObjArray *funcs_array;
+  NcmRNG *rng;
 } NcmFitESMCMCWorker;
 
 static gpointer
@@ -416,6 +466,9 @@ _ncm_fit_esmcmc_worker_dup (gpointer userdata)
   G_LOCK (dup_thread);
   {
     NcmFitESMCMCWorker *fw = g_new (NcmFitESMCMCWorker, 1);
+
+    /* The immutable data objects are shared by all walkers. */
+    ncm_dataset_share_payload (esmcmc->fit->lh->dset, esmcmc->ser);
     
     fw->fit = ncm_fit_dup (esmcmc->fit, esmcmc->ser);
 
@@ -424,6 +477,8 @@ _ncm_fit_esmcmc_worker_dup (gpointer userdata)
     else
       fw->funcs_array = NULL;
 
+    fw->rng = ncm_rng_new (NCM_RNG_STREAM_ALGO);
+
     ncm_serialize_reset (esmcmc->ser);
     
     G_UNLOCK (dup_thread);
@@ -439,6 +494,7 @@ _ncm_fit_esmcmc_worker_free (gpointer userdata)
 
   ncm_fit_clear (&fw->fit);
   ncm_obj_array_clear (&fw->funcs_array);
+  ncm_rng_clear (&fw->rng);
 
   g_free (fw);
 }
@@ -634,6 +690,83 @@ ncm_fit_esmcmc_set_rng (NcmFitESMCMC *esmcmc, NcmRNG *rng)
   ncm_mset_catalog_set_rng (esmcmc->mcat, rng);
 }
 
+/**
+ * ncm_fit_esmcmc_set_fast_slow:
+ * @esmcmc: a #NcmFitESMCMC
+ * @fast_slow: whether to use fast/slow parameter blocking
+ *
+ * Enables or disables the fast/slow parameter blocking. When enabled, the free
+ * parameters are divided in blocks, one for each model in the #NcmMSet, and
+ * the cost of each block is measured when the run starts (see
+ * ncm_fit_fparams_blocks_oversampling()). The ensemble move of each walker
+ * is then followed by several Metropolis–Hastings sub-steps restricted to 
+ * each block faster than the slowest one, the number of sub-steps being the
+ * oversampling factor of the block. The sub-steps use a Gaussian proposal 
+ * whose widths are given by the standard deviations of the complementary 
+ * half of the ensemble (which is fixed while the walker is updated), so the
+ * target distribution of the ensemble is preserved.
+ *
+ * The blocking requires at least four walkers.
+ * 
+ */
+void 
+ncm_fit_esmcmc_set_fast_slow (NcmFitESMCMC *esmcmc, gboolean fast_slow)
+{
+  if (esmcmc->started)
+    g_error ("ncm_fit_esmcmc_set_fast_slow: Cannot change the blocking scheme during a run, call ncm_fit_esmcmc_end_run() first.");
+
+  /* During the construction the number of walkers may not be set yet, it is checked again in constructed. */
+  if (fast_slow && (esmcmc->nwalkers > 0) && (esmcmc->nwalkers < 4))
+    g_error ("ncm_fit_esmcmc_set_fast_slow: the fast/slow blocking needs at least four walkers, "
+             "the sub-step widths are estimated from the complementary half of the ensemble [nwalkers = %d].", 
+             esmcmc->nwalkers);
+
+  esmcmc->fast_slow = fast_slow;
+}
+
+/**
+ * ncm_fit_esmcmc_set_max_oversampling:
+ * @esmcmc: a #NcmFitESMCMC
+ * @max_os: maximum oversampling factor
+ *
+ * Sets the maximum number of sub-steps done in a fast block after each 
+ * ensemble move, see ncm_fit_esmcmc_set_fast_slow().
+ * 
+ */
+void 
+ncm_fit_esmcmc_set_max_oversampling (NcmFitESMCMC *esmcmc, guint max_os)
+{
+  g_assert_cmpuint (max_os, >, 0);
+  if (esmcmc->started)
+    g_error ("ncm_fit_esmcmc_set_max_oversampling: Cannot change the blocking scheme during a run, call ncm_fit_esmcmc_end_run() first.");
+
+  esmcmc->max_os = max_os;
+}
+
+/**
+ * ncm_fit_esmcmc_get_fast_slow:
+ * @esmcmc: a #NcmFitESMCMC
+ *
+ * Returns: whether the fast/slow parameter blocking is enabled.
+ */
+gboolean 
+ncm_fit_esmcmc_get_fast_slow (NcmFitESMCMC *esmcmc)
+{
+  return esmcmc->fast_slow;
+}
+
+/**
+ * ncm_fit_esmcmc_get_max_oversampling:
+ * @esmcmc: a #NcmFitESMCMC
+ *
+ * Returns: the maximum oversampling factor.
+ */
+guint 
+ncm_fit_esmcmc_get_max_oversampling (NcmFitESMCMC *esmcmc)
+{
+  return esmcmc->max_os;
+}
+
 /**
  * ncm_fit_esmcmc_get_accept_ratio:
  * @esmcmc: a #NcmFitESMCMC
@@ -696,7 +829,10 @@ _ncm_fit_esmcmc_update (NcmFitESMCMC *esmcmc, guint ki, guint kf)
       esmcmc->noffboard++;
       g_array_index (esmcmc->offboard, gboolean, k) = FALSE;
     }
-    
+
+    esmcmc->nfast_total    += esmcmc->nfast_steps;
+    esmcmc->nfast_accepted += g_array_index (esmcmc->fast_accepted, guint, k);
+    g_array_index (esmcmc->fast_accepted, guint, k) = 0;
   }
 
   switch (esmcmc->mtype)
@@ -717,6 +853,9 @@ _ncm_fit_esmcmc_update (NcmFitESMCMC *esmcmc, guint ki, guint kf)
         g_message ("# NcmFitESMCMC:acceptance ratio %7.4f%%, offboard ratio %7.4f%%.\n", 
                    ncm_fit_esmcmc_get_accept_ratio (esmcmc) * 100.0,
                    ncm_fit_esmcmc_get_offboard_ratio (esmcmc) * 100.0);
+        if (esmcmc->nfast_total > 0)
+          g_message ("# NcmFitESMCMC:fast blocks acceptance ratio %7.4f%%.\n", 
+                     esmcmc->nfast_accepted * 100.0 / (esmcmc->nfast_total * 1.0));
         /* ncm_timer_task_accumulate (esmcmc->nt, acc); */
         ncm_timer_task_log_elapsed (esmcmc->nt);
         ncm_timer_task_log_mean_time (esmcmc->nt);
@@ -745,6 +884,9 @@ _ncm_fit_esmcmc_update (NcmFitESMCMC *esmcmc, guint ki, guint kf)
         g_message ("# NcmFitESMCMC:acceptance ratio %7.4f%%, offboard ratio %7.4f%%.\n", 
                    ncm_fit_esmcmc_get_accept_ratio (esmcmc) * 100.0,
                    ncm_fit_esmcmc_get_offboard_ratio (esmcmc) * 100.0);
+        if (esmcmc->nfast_total > 0)
+          g_message ("# NcmFitESMCMC:fast blocks acceptance ratio %7.4f%%.\n", 
+                     esmcmc->nfast_accepted * 100.0 / (esmcmc->nfast_total * 1.0));
         /* ncm_timer_task_increment (esmcmc->nt); */
         ncm_timer_task_log_elapsed (esmcmc->nt);
         ncm_timer_task_log_mean_time (esmcmc->nt);
@@ -758,6 +900,58 @@ _ncm_fit_esmcmc_update (NcmFitESMCMC *esmcmc, guint ki, guint kf)
 
 static void ncm_fit_esmcmc_intern_skip (NcmFitESMCMC *esmcmc, guint n);
 
+static void
+_ncm_fit_esmcmc_prepare_blocks (NcmFitESMCMC *esmcmc)
+{
+  g_clear_pointer (&esmcmc->blocks, g_ptr_array_unref);
+  g_clear_pointer (&esmcmc->block_os, g_array_unref);
+  ncm_matrix_clear (&esmcmc->fast_rand);
+
+  esmcmc->nfast_rand  = 0;
+  esmcmc->nfast_steps = 0;
+
+  if (esmcmc->fast_slow)
+  {
+    GArray *block_time = NULL;
+    guint b;
+
+    g_assert_cmpint (esmcmc->nwalkers, >=, 4);
+
+    esmcmc->blocks = ncm_fit_fparams_blocks_oversampling (esmcmc->fit, esmcmc->max_os, &esmcmc->block_os, &block_time);
+
+    /* The slowest block (the first one) is moved only by the ensemble move. */
+    for (b = 1; b < esmcmc->blocks->len; b++)
+    {
+      GArray *block  = g_ptr_array_index (esmcmc->blocks, b);
+      const guint os = g_array_index (esmcmc->block_os, guint, b);
+
+      esmcmc->nfast_steps += os;
+      esmcmc->nfast_rand  += os * (block->len + 1);
+    }
+
+    if (esmcmc->nfast_rand > 0)
+      esmcmc->fast_rand = ncm_matrix_new (esmcmc->nwalkers, esmcmc->nfast_rand);
+    
+    if (esmcmc->mtype > NCM_FIT_RUN_MSGS_NONE)
+    {
+      ncm_cfg_msg_sepa ();
+      g_message ("# NcmFitESMCMC: Using fast/slow parameter blocking with %u blocks:\n", esmcmc->blocks->len);
+      for (b = 0; b < esmcmc->blocks->len; b++)
+      {
+        GArray *block  = g_ptr_array_index (esmcmc->blocks, b);
+        const guint n0 = g_array_index (block, guint, 0);
+        
+        g_message ("# NcmFitESMCMC: - block %u [%s, ...] % 3u parameters, time per evaluation %10.5e s, oversampling %u.\n",
+                   b, ncm_mset_fparam_name (esmcmc->fit->mset, n0), block->len, 
+                   g_array_index (block_time, gdouble, b),
+                   (b == 0) ? 1 : g_array_index (esmcmc->block_os, guint, b));
+      }
+    }
+
+    g_array_unref (block_time);
+  }
+}
+
 static void 
 _ncm_fit_esmcmc_gen_init_points_mt_eval (glong i, glong f, gpointer data)
 {
@@ -772,11 +966,12 @@ _ncm_fit_esmcmc_gen_init_points_mt_eval (glong i, glong f, gpointer data)
     NcmVector *theta_k      = g_ptr_array_index (esmcmc->theta, k);
     gdouble *m2lnL          = ncm_vector_ptr (full_theta_k, NCM_FIT_ESMCMC_M2LNL_ID);
 
+    /* Each walker draws its initial point from its own stream of the catalog RNG. */
+    ncm_rng_stream_set (fk_ptr[0]->rng, esmcmc->mcat->rng, k);
+
     do
     {
-      g_mutex_lock (&esmcmc->resample_lock);
-      ncm_mset_trans_kern_prior_sample (esmcmc->sampler, theta_k, esmcmc->mcat->rng);
-      g_mutex_unlock (&esmcmc->resample_lock);
+      ncm_mset_trans_kern_prior_sample (esmcmc->sampler, theta_k, fk_ptr[0]->rng);
 
       ncm_mset_fparams_set_vector (fit_k->mset, theta_k);
       ncm_fit_m2lnL_val (fit_k, m2lnL);
@@ -820,6 +1015,10 @@ _ncm_fit_esmcmc_gen_init_points (NcmFitESMCMC *esmcmc)
     _ncm_fit_esmcmc_gen_init_points_mt_eval (esmcmc->cur_sample_id + 1, esmcmc->nwalkers, esmcmc);
   }
 
+  ncm_rng_lock (esmcmc->mcat->rng);
+  gsl_rng_get (esmcmc->mcat->rng->r);
+  ncm_rng_unlock (esmcmc->mcat->rng);
+
   _ncm_fit_esmcmc_update (esmcmc, esmcmc->cur_sample_id + 1, esmcmc->nwalkers); 
   ncm_mset_catalog_sync (esmcmc->mcat, FALSE);
 }
@@ -868,6 +1067,8 @@ ncm_fit_esmcmc_start_run (NcmFitESMCMC *esmcmc)
 
   esmcmc->started = TRUE;
 
+  _ncm_fit_esmcmc_prepare_blocks (esmcmc);
+
   ncm_mset_catalog_set_sync_mode (esmcmc->mcat, NCM_MSET_CATALOG_SYNC_TIMED);
   ncm_mset_catalog_set_sync_interval (esmcmc->mcat, NCM_FIT_ESMCMC_MIN_SYNC_INTERVAL);
   
@@ -877,6 +1078,8 @@ ncm_fit_esmcmc_start_run (NcmFitESMCMC *esmcmc)
   esmcmc->ntotal    = 0;
   esmcmc->naccepted = 0;
   esmcmc->noffboard = 0;
+  esmcmc->nfast_total    = 0;
+  esmcmc->nfast_accepted = 0;
   g_mutex_unlock (&esmcmc->update_lock);
 
   if (esmcmc->mcat->first_id > 0)
@@ -916,6 +1119,8 @@ ncm_fit_esmcmc_start_run (NcmFitESMCMC *esmcmc)
     esmcmc->ntotal    = 0;
     esmcmc->naccepted = 0;
     esmcmc->noffboard = 0;
+    esmcmc->nfast_total    = 0;
+    esmcmc->nfast_accepted = 0;
     g_mutex_unlock (&esmcmc->update_lock);
   }
   else
@@ -981,6 +1186,8 @@ ncm_fit_esmcmc_reset (NcmFitESMCMC *esmcmc)
   esmcmc->ntotal          = 0;
   esmcmc->naccepted       = 0;
   esmcmc->noffboard       = 0;
+  esmcmc->nfast_total     = 0;
+  esmcmc->nfast_accepted  = 0;
   esmcmc->started         = FALSE;  
   ncm_mset_catalog_reset (esmcmc->mcat);
 }
@@ -1071,12 +1278,108 @@ ncm_fit_esmcmc_run (NcmFitESMCMC *esmcmc, guint n)
   ncm_timer_task_pause (esmcmc->nt);
 }
 
+static void
+_ncm_fit_esmcmc_fast_steps (NcmFitESMCMC *esmcmc, NcmFitESMCMCWorker *fw, guint k, gdouble *fast_sd)
+{
+  NcmFit *fit_k             = fw->fit;
+  NcmVector *full_theta_k   = g_ptr_array_index (esmcmc->full_theta, k);
+  NcmVector *full_thetastar = g_ptr_array_index (esmcmc->full_thetastar, k);
+  NcmVector *theta_k        = g_ptr_array_index (esmcmc->theta, k);
+  NcmVector *thetastar      = g_ptr_array_index (esmcmc->thetastar, k);
+  const guint nwalkers_2    = esmcmc->nwalkers / 2;
+  /* Walkers in the complementary half are not moved while walker k is updated. */
+  const guint ci            = (k < nwalkers_2) ? nwalkers_2 : 0;
+  const guint cf            = (k < nwalkers_2) ? esmcmc->nwalkers : nwalkers_2;
+  gboolean at_theta_k       = FALSE;
+  guint accepted            = 0;
+  guint b, r = 0;
+
+  for (b = 1; b < esmcmc->blocks->len; b++)
+  {
+    GArray *block      = g_ptr_array_index (esmcmc->blocks, b);
+    const guint os     = g_array_index (esmcmc->block_os, guint, b);
+    const gdouble sfac = 2.38 / sqrt (block->len);
+    guint o, j, c;
+
+    for (j = 0; j < block->len; j++)
+    {
+      const guint n = g_array_index (block, guint, j);
+      gdouble mean = 0.0, var = 0.0;
+
+      for (c = ci; c < cf; c++)
+      {
+        const gdouble x_c = ncm_vector_get (g_ptr_array_index (esmcmc->theta, c), n);
+        const gdouble d_c = x_c - mean;
+
+        mean += d_c / (c - ci + 1.0);
+        var  += d_c * (x_c - mean);
+      }
+
+      fast_sd[n] = sfac * sqrt (var / (cf - ci - 1.0));
+    }
+
+    for (o = 0; o < os; o++)
+    {
+      gdouble *m2lnL_cur  = ncm_vector_ptr (full_theta_k, NCM_FIT_ESMCMC_M2LNL_ID);
+      gdouble *m2lnL_star = ncm_vector_ptr (full_thetastar, NCM_FIT_ESMCMC_M2LNL_ID);
+      gdouble prob        = 0.0;
+      gdouble jump;
+
+      ncm_vector_memcpy (thetastar, theta_k);
+      for (j = 0; j < block->len; j++)
+      {
+        const guint n = g_array_index (block, guint, j);
+        ncm_vector_addto (thetastar, n, fast_sd[n] * ncm_matrix_get (esmcmc->fast_rand, k, r++));
+      }
+      jump = ncm_matrix_get (esmcmc->fast_rand, k, r++);
+
+      if (ncm_mset_fparam_valid_bounds (fit_k->mset, thetastar))
+      {
+        ncm_mset_fparams_set_vector (fit_k->mset, thetastar);
+        ncm_fit_m2lnL_val (fit_k, m2lnL_star);
+
+        if (gsl_finite (m2lnL_star[0]))
+          prob = GSL_MIN (exp ((m2lnL_cur[0] - m2lnL_star[0]) * 0.5), 1.0);
+        at_theta_k = FALSE;
+      }
+
+      if (jump < prob)
+      {
+        ncm_vector_memcpy (theta_k, thetastar);
+        m2lnL_cur[0] = m2lnL_star[0];
+        at_theta_k   = TRUE;
+        accepted++;
+      }
+    }
+  }
+
+  if ((accepted > 0) && (fw->funcs_array != NULL))
+  {
+    guint j;
+
+    if (!at_theta_k)
+      ncm_mset_fparams_set_vector (fit_k->mset, theta_k);
+    
+    for (j = 0; j < fw->funcs_array->len; j++)
+    {
+      NcmMSetFunc *func = NCM_MSET_FUNC (ncm_obj_array_peek (fw->funcs_array, j));
+      const gdouble a_j = ncm_mset_func_eval0 (func, fit_k->mset);
+
+      ncm_vector_set (full_theta_k, j + 1, a_j);
+    }
+  }
+
+  g_array_index (esmcmc->fast_accepted, guint, k) = accepted;
+}
+
 static void 
 _ncm_fit_esmcmc_mt_eval (glong i, glong f, gpointer data)
 {
   NcmFitESMCMC *esmcmc        = NCM_FIT_ESMCMC (data);
   NcmFitESMCMCWorker **fk_ptr = ncm_memory_pool_get (esmcmc->walker_pool);
   NcmFit *fit_k               = fk_ptr[0]->fit;
+  NcmWorkspace *ws            = ncm_workspace_peek ();
+  NcmVector *fast_sd          = (esmcmc->fast_rand != NULL) ? ncm_workspace_borrow_vector (ws, esmcmc->fparam_len) : NULL;
   guint k = i;
 
   while (k < f)
@@ -1125,9 +1428,15 @@ _ncm_fit_esmcmc_mt_eval (glong i, glong f, gpointer data)
       ncm_vector_memcpy (full_theta_k, full_thetastar);
       g_array_index (esmcmc->accepted, gboolean, k) = TRUE;
     }
+
+    if (esmcmc->fast_rand != NULL)
+      _ncm_fit_esmcmc_fast_steps (esmcmc, fk_ptr[0], k, ncm_vector_data (fast_sd));
+
     k++;
   }
 
+  if (fast_sd != NULL)
+    ncm_workspace_return_vector (ws, fast_sd);
   ncm_memory_pool_return (fk_ptr);
 }
 
@@ -1141,6 +1450,28 @@ _ncm_fit_esmcmc_get_jumps (NcmFitESMCMC *esmcmc, guint ki, guint kf)
     const gdouble jump = gsl_rng_uniform (esmcmc->mcat->rng->r);; 
     ncm_vector_set (esmcmc->jumps, k, jump);
   }
+
+  if (esmcmc->fast_rand != NULL)
+  {
+    /* The fast sub-steps random numbers are also drawn here, so the chain does not depend on the threads scheduling. */
+    for (k = ki; k < kf; k++)
+    {
+      guint b, r = 0;
+      for (b = 1; b < esmcmc->blocks->len; b++)
+      {
+        GArray *block  = g_ptr_array_index (esmcmc->blocks, b);
+        const guint os = g_array_index (esmcmc->block_os, guint, b);
+        guint o, j;
+
+        for (o = 0; o < os; o++)
+        {
+          for (j = 0; j < block->len; j++)
+            ncm_matrix_set (esmcmc->fast_rand, k, r++, gsl_ran_ugaussian (esmcmc->mcat->rng->r));
+          ncm_matrix_set (esmcmc->fast_rand, k, r++, gsl_rng_uniform (esmcmc->mcat->rng->r));
+        }
+      }
+    }
+  }
 }
 
 
@@ -77,6 +77,10 @@ struct _NcmFitESMCMC
   NcmVector *jumps;
   GArray *accepted;
   GArray *offboard;
+  GPtrArray *blocks;
+  GArray *block_os;
+  NcmMatrix *fast_rand;
+  GArray *fast_accepted;
   NcmObjArray *funcs_oa;
   gchar *funcs_oa_file;
   guint nadd_vals;
@@ -88,9 +92,14 @@ struct _NcmFitESMCMC
   guint ntotal;
   guint naccepted;
   guint noffboard;
+  guint nfast_rand;
+  guint nfast_steps;
+  guint nfast_total;
+  guint nfast_accepted;
+  guint max_os;
+  gboolean fast_slow;
   gboolean started;
   GMutex dup_fit;
-  GMutex resample_lock;
   GMutex update_lock;
   GCond write_cond;
 };
@@ -109,6 +118,11 @@ void ncm_fit_esmcmc_set_sampler (NcmFitESMCMC *esmcmc, NcmMSetTransKern *sampler
 void ncm_fit_esmcmc_set_mtype (NcmFitESMCMC *esmcmc, NcmFitRunMsgs mtype);
 void ncm_fit_esmcmc_set_nthreads (NcmFitESMCMC *esmcmc, guint nthreads);
 void ncm_fit_esmcmc_set_rng (NcmFitESMCMC *esmcmc, NcmRNG *rng);
+void ncm_fit_esmcmc_set_fast_slow (NcmFitESMCMC *esmcmc, gboolean fast_slow);
+void ncm_fit_esmcmc_set_max_oversampling (NcmFitESMCMC *esmcmc, guint max_os);
+
+gboolean ncm_fit_esmcmc_get_fast_slow (NcmFitESMCMC *esmcmc);
+guint ncm_fit_esmcmc_get_max_oversampling (NcmFitESMCMC *esmcmc);
 
 gdouble ncm_fit_esmcmc_get_accept_ratio (NcmFitESMCMC *esmcmc);
 gdouble ncm_fit_esmcmc_get_offboard_ratio (NcmFitESMCMC *esmcmc);
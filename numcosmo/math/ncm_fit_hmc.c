@@ -0,0 +1,1331 @@
+/***************************************************************************
+ *            ncm_fit_hmc.c
+ *
+ *  Mon October 19 20:41:13 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_fit_hmc.c
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:ncm_fit_hmc
+ * @title: NcmFitHMC
+ * @short_description: Hamiltonian Monte Carlo with the No-U-Turn sampler.
+ *
+ * Hamiltonian Monte Carlo sampler of the posterior $L(\theta)$ defined by a
+ * #NcmFit, using the No-U-Turn sampler (NUTS) of [Hoffman & Gelman (2014)]
+ * to choose the trajectory length. The potential energy is
+ * $U(\theta) = -\ln L(\theta)$ and its gradient is obtained from
+ * ncm_fit_m2lnL_val_grad(), hence the #NcmFit gradient type determines the
+ * cost of each step, analytical gradients should be used whenever the
+ * models provide them. Points outside the parameter bounds are treated as
+ * having zero likelihood.
+ *
+ * The first #NcmFitHMC:nwarmup steps, done by ncm_fit_hmc_start_run(), are
+ * used to tune the sampler and are not added to the catalog. The step size
+ * is adapted by dual averaging to reach the mean acceptance probability
+ * #NcmFitHMC:target-accept. The inverse mass matrix is estimated from the
+ * warmup samples with a #NcmStatsVec in windows of doubling size, as in
+ * Stan, and can be either diagonal or dense (#NcmFitHMC:dense-mass).
+ *
+ * The samples are added to a #NcmMSetCatalog. The efficiency of the sampler
+ * is summarized by the effective sample size per gradient evaluation, see
+ * ncm_fit_hmc_get_ess_per_grad().
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif /* HAVE_CONFIG_H */
+#include "build_cfg.h"
+
+#include "math/ncm_fit_hmc.h"
+#include "math/ncm_cfg.h"
+#include "math/ncm_util.h"
+#include "ncm_enum_types.h"
+
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_blas.h>
+
+enum
+{
+  PROP_0,
+  PROP_FIT,
+  PROP_MTYPE,
+  PROP_DATA_FILE,
+  PROP_NWARMUP,
+  PROP_MAX_DEPTH,
+  PROP_TARGET_ACCEPT,
+  PROP_DENSE_MASS,
+};
+
+struct _NcmFitHMCPoint
+{
+  NcmVector *theta;
+  NcmVector *p;
+  NcmVector *grad;
+  gdouble m2lnL;
+};
+
+G_DEFINE_TYPE (NcmFitHMC, ncm_fit_hmc, G_TYPE_OBJECT);
+
+static void
+ncm_fit_hmc_init (NcmFitHMC *hmc)
+{
+  hmc->fit           = NULL;
+  hmc->mcat          = NULL;
+  hmc->mtype         = NCM_FIT_RUN_MSGS_NONE;
+  hmc->nt            = ncm_timer_new ();
+  hmc->wstats        = NULL;
+  hmc->minv          = NULL;
+  hmc->minv_L        = NULL;
+  hmc->dtheta        = NULL;
+  hmc->vel           = NULL;
+  hmc->row           = NULL;
+  hmc->cur           = NULL;
+  hmc->minus         = NULL;
+  hmc->plus          = NULL;
+  hmc->inner         = NULL;
+  hmc->prop          = NULL;
+  hmc->tree_inner    = g_ptr_array_new ();
+  hmc->tree_prop     = g_ptr_array_new ();
+  hmc->windows       = g_array_new (FALSE, FALSE, sizeof (guint));
+  hmc->eps           = 0.0;
+  hmc->eps_bar       = 0.0;
+  hmc->Hbar          = 0.0;
+  hmc->mu            = 0.0;
+  hmc->target_accept = 0.0;
+  hmc->sum_accept    = 0.0;
+  hmc->fparam_len    = 0;
+  hmc->nwarmup       = 0;
+  hmc->max_depth     = 0;
+  hmc->n             = 0;
+  hmc->ngrad         = 0;
+  hmc->ngrad_warmup  = 0;
+  hmc->ndivergent    = 0;
+  hmc->nsteps        = 0;
+  hmc->cur_sample_id = -1; /* Represents that no samples were calculated yet. */
+  hmc->dense_mass    = FALSE;
+  hmc->started       = FALSE;
+}
+
+static NcmFitHMCPoint *
+_ncm_fit_hmc_point_new (guint len)
+{
+  NcmFitHMCPoint *pt = g_new (NcmFitHMCPoint, 1);
+
+  pt->theta = ncm_vector_new (len);
+  pt->p     = ncm_vector_new (len);
+  pt->grad  = ncm_vector_new (len);
+  pt->m2lnL = GSL_POSINF;
+
+  return pt;
+}
+
+static void
+_ncm_fit_hmc_point_free (NcmFitHMCPoint *pt)
+{
+  ncm_vector_free (pt->theta);
+  ncm_vector_free (pt->p);
+  ncm_vector_free (pt->grad);
+  g_free (pt);
+}
+
+static void
+_ncm_fit_hmc_point_clear (NcmFitHMCPoint **pt)
+{
+  g_clear_pointer (pt, _ncm_fit_hmc_point_free);
+}
+
+static void
+_ncm_fit_hmc_point_copy (NcmFitHMCPoint *dest, NcmFitHMCPoint *src)
+{
+  ncm_vector_memcpy (dest->theta, src->theta);
+  ncm_vector_memcpy (dest->p, src->p);
+  ncm_vector_memcpy (dest->grad, src->grad);
+  dest->m2lnL = src->m2lnL;
+}
+
+static void
+_ncm_fit_hmc_constructed (GObject *object)
+{
+  /* Chain up : start */
+  G_OBJECT_CLASS (ncm_fit_hmc_parent_class)->constructed (object);
+  {
+    NcmFitHMC *hmc = NCM_FIT_HMC (object);
+    const guint len = hmc->fparam_len = ncm_mset_fparam_len (hmc->fit->mset);
+    guint i;
+
+    g_assert_cmpuint (len, >, 0);
+
+    hmc->mcat = ncm_mset_catalog_new (hmc->fit->mset, 1, 1, FALSE,
+                                      NCM_MSET_CATALOG_M2LNL_COLNAME, NCM_MSET_CATALOG_M2LNL_SYMBOL,
+                                      NULL);
+    ncm_mset_catalog_set_run_type (hmc->mcat, "Hamiltonian Monte Carlo (NUTS)");
+
+    hmc->minv   = ncm_matrix_new (len, len);
+    hmc->minv_L = ncm_matrix_new (len, len);
+    hmc->dtheta = ncm_vector_new (len);
+    hmc->vel    = ncm_vector_new (len);
+    hmc->row    = ncm_vector_new (len + 1);
+
+    hmc->cur    = _ncm_fit_hmc_point_new (len);
+    hmc->minus  = _ncm_fit_hmc_point_new (len);
+    hmc->plus   = _ncm_fit_hmc_point_new (len);
+    hmc->inner  = _ncm_fit_hmc_point_new (len);
+    hmc->prop   = _ncm_fit_hmc_point_new (len);
+
+    ncm_matrix_set_zero (hmc->minv);
+    for (i = 0; i < len; i++)
+    {
+      const gdouble scale_i = ncm_mset_fparam_get_scale (hmc->fit->mset, i);
+      ncm_matrix_set (hmc->minv, i, i, scale_i * scale_i);
+    }
+  }
+}
+
+static void
+ncm_fit_hmc_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+  NcmFitHMC *hmc = NCM_FIT_HMC (object);
+  g_return_if_fail (NCM_IS_FIT_HMC (object));
+
+  switch (prop_id)
+  {
+    case PROP_FIT:
+      g_assert (hmc->fit == NULL);
+      hmc->fit = g_value_dup_object (value);
+      break;
+    case PROP_MTYPE:
+      ncm_fit_hmc_set_mtype (hmc, g_value_get_enum (value));
+      break;
+    case PROP_DATA_FILE:
+      ncm_fit_hmc_set_data_file (hmc, g_value_get_string (value));
+      break;
+    case PROP_NWARMUP:
+      ncm_fit_hmc_set_nwarmup (hmc, g_value_get_uint (value));
+      break;
+    case PROP_MAX_DEPTH:
+      ncm_fit_hmc_set_max_depth (hmc, g_value_get_uint (value));
+      break;
+    case PROP_TARGET_ACCEPT:
+      ncm_fit_hmc_set_target_accept (hmc, g_value_get_double (value));
+      break;
+    case PROP_DENSE_MASS:
+      ncm_fit_hmc_set_dense_mass (hmc, g_value_get_boolean (value));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+ncm_fit_hmc_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+  NcmFitHMC *hmc = NCM_FIT_HMC (object);
+  g_return_if_fail (NCM_IS_FIT_HMC (object));
+
+  switch (prop_id)
+  {
+    case PROP_FIT:
+      g_value_set_object (value, hmc->fit);
+      break;
+    case PROP_MTYPE:
+      g_value_set_enum (value, hmc->mtype);
+      break;
+    case PROP_DATA_FILE:
+      g_value_set_string (value, ncm_mset_catalog_peek_filename (hmc->mcat));
+      break;
+    case PROP_NWARMUP:
+      g_value_set_uint (value, hmc->nwarmup);
+      break;
+    case PROP_MAX_DEPTH:
+      g_value_set_uint (value, hmc->max_depth);
+      break;
+    case PROP_TARGET_ACCEPT:
+      g_value_set_double (value, hmc->target_accept);
+      break;
+    case PROP_DENSE_MASS:
+      g_value_set_boolean (value, hmc->dense_mass);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+ncm_fit_hmc_dispose (GObject *object)
+{
+  NcmFitHMC *hmc = NCM_FIT_HMC (object);
+
+  ncm_fit_clear (&hmc->fit);
+  ncm_mset_catalog_clear (&hmc->mcat);
+  ncm_timer_clear (&hmc->nt);
+  ncm_stats_vec_clear (&hmc->wstats);
+
+  ncm_matrix_clear (&hmc->minv);
+  ncm_matrix_clear (&hmc->minv_L);
+  ncm_vector_clear (&hmc->dtheta);
+  ncm_vector_clear (&hmc->vel);
+  ncm_vector_clear (&hmc->row);
+
+  _ncm_fit_hmc_point_clear (&hmc->cur);
+  _ncm_fit_hmc_point_clear (&hmc->minus);
+  _ncm_fit_hmc_point_clear (&hmc->plus);
+  _ncm_fit_hmc_point_clear (&hmc->inner);
+  _ncm_fit_hmc_point_clear (&hmc->prop);
+
+  if (hmc->tree_inner != NULL)
+  {
+    g_ptr_array_set_free_func (hmc->tree_inner, (GDestroyNotify) &_ncm_fit_hmc_point_free);
+    g_clear_pointer (&hmc->tree_inner, g_ptr_array_unref);
+  }
+  if (hmc->tree_prop != NULL)
+  {
+    g_ptr_array_set_free_func (hmc->tree_prop, (GDestroyNotify) &_ncm_fit_hmc_point_free);
+    g_clear_pointer (&hmc->tree_prop, g_ptr_array_unref);
+  }
+  g_clear_pointer (&hmc->windows, g_array_unref);
+
+  /* Chain up : end */
+  G_OBJECT_CLASS (ncm_fit_hmc_parent_class)->dispose (object);
+}
+
+static void
+ncm_fit_hmc_finalize (GObject *object)
+{
+  /* Chain up : end */
+  G_OBJECT_CLASS (ncm_fit_hmc_parent_class)->finalize (object);
+}
+
+static void
+ncm_fit_hmc_class_init (NcmFitHMCClass *klass)
+{
+  GObjectClass* object_class = G_OBJECT_CLASS (klass);
+
+  object_class->constructed  = &_ncm_fit_hmc_constructed;
+  object_class->set_property = &ncm_fit_hmc_set_property;
+  object_class->get_property = &ncm_fit_hmc_get_property;
+  object_class->dispose      = &ncm_fit_hmc_dispose;
+  object_class->finalize     = &ncm_fit_hmc_finalize;
+
+  g_object_class_install_property (object_class,
+                                   PROP_FIT,
+                                   g_param_spec_object ("fit",
+                                                        NULL,
+                                                        "Fit object",
+                                                        NCM_TYPE_FIT,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_MTYPE,
+                                   g_param_spec_enum ("mtype",
+                                                      NULL,
+                                                      "Run messages type",
+                                                      NCM_TYPE_FIT_RUN_MSGS, NCM_FIT_RUN_MSGS_SIMPLE,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_DATA_FILE,
+                                   g_param_spec_string ("data-file",
+                                                        NULL,
+                                                        "Data filename",
+                                                        NULL,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_NWARMUP,
+                                   g_param_spec_uint ("nwarmup",
+                                                      NULL,
+                                                      "Number of warmup steps",
+                                                      0, G_MAXUINT32, 1000,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_MAX_DEPTH,
+                                   g_param_spec_uint ("max-depth",
+                                                      NULL,
+                                                      "Maximum tree depth",
+                                                      1, 30, 10,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_TARGET_ACCEPT,
+                                   g_param_spec_double ("target-accept",
+                                                        NULL,
+                                                        "Target acceptance probability",
+                                                        0.0, 1.0, 0.8,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_DENSE_MASS,
+                                   g_param_spec_boolean ("dense-mass",
+                                                         NULL,
+                                                         "Whether to use a dense mass matrix",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+}
+
+/**
+ * ncm_fit_hmc_new:
+ * @fit: a #NcmFit
+ * @mtype: a #NcmFitRunMsgs
+ *
+ * Creates a new NUTS sampler for the likelihood and model set of @fit,
+ * the chain starts at the current free parameters of the #NcmMSet.
+ *
+ * Returns: (transfer full): a new #NcmFitHMC.
+ */
+NcmFitHMC *
+ncm_fit_hmc_new (NcmFit *fit, NcmFitRunMsgs mtype)
+{
+  NcmFitHMC *hmc = g_object_new (NCM_TYPE_FIT_HMC,
+                                 "fit",   fit,
+                                 "mtype", mtype,
+                                 NULL);
+  return hmc;
+}
+
+/**
+ * ncm_fit_hmc_free:
+ * @hmc: a #NcmFitHMC
+ *
+ * Decreases the reference count of @hmc.
+ *
+ */
+void
+ncm_fit_hmc_free (NcmFitHMC *hmc)
+{
+  g_object_unref (hmc);
+}
+
+/**
+ * ncm_fit_hmc_clear:
+ * @hmc: a #NcmFitHMC
+ *
+ * Decreases the reference count of *@hmc and sets the pointer *@hmc to NULL.
+ *
+ */
+void
+ncm_fit_hmc_clear (NcmFitHMC **hmc)
+{
+  g_clear_object (hmc);
+}
+
+/**
+ * ncm_fit_hmc_set_data_file:
+ * @hmc: a #NcmFitHMC
+ * @filename: a filename.
+ *
+ * Sets the catalog file. If it already contains samples the chain
+ * continues from the last one, the warmup is done again but its samples
+ * are not added to the catalog.
+ *
+ */
+void
+ncm_fit_hmc_set_data_file (NcmFitHMC *hmc, const gchar *filename)
+{
+  const gchar *cur_filename = ncm_mset_catalog_peek_filename (hmc->mcat);
+
+  if (hmc->started && cur_filename != NULL)
+    g_error ("ncm_fit_hmc_set_data_file: Cannot change data file during a run, call ncm_fit_hmc_end_run() first.");
+
+  if (cur_filename != NULL && strcmp (cur_filename, filename) == 0)
+    return;
+
+  ncm_mset_catalog_set_file (hmc->mcat, filename);
+
+  if (hmc->started)
+    g_assert_cmpint (hmc->cur_sample_id, ==, hmc->mcat->cur_id);
+}
+
+/**
+ * ncm_fit_hmc_set_mtype:
+ * @hmc: a #NcmFitHMC
+ * @mtype: a #NcmFitRunMsgs
+ *
+ * Sets the verbosity of the run.
+ *
+ */
+void
+ncm_fit_hmc_set_mtype (NcmFitHMC *hmc, NcmFitRunMsgs mtype)
+{
+  hmc->mtype = mtype;
+}
+
+/**
+ * ncm_fit_hmc_set_rng:
+ * @hmc: a #NcmFitHMC
+ * @rng: a #NcmRNG
+ *
+ * Sets the random number generator.
+ *
+ */
+void
+ncm_fit_hmc_set_rng (NcmFitHMC *hmc, NcmRNG *rng)
+{
+  if (hmc->started)
+    g_error ("ncm_fit_hmc_set_rng: Cannot change the RNG object during a run, call ncm_fit_hmc_end_run() first.");
+
+  ncm_mset_catalog_set_rng (hmc->mcat, rng);
+}
+
+/**
+ * ncm_fit_hmc_set_nwarmup:
+ * @hmc: a #NcmFitHMC
+ * @nwarmup: number of warmup steps
+ *
+ * Sets the number of steps used to tune the step size and the mass
+ * matrix. With less than 20 steps only the step size is adapted.
+ *
+ */
+void
+ncm_fit_hmc_set_nwarmup (NcmFitHMC *hmc, guint nwarmup)
+{
+  if (hmc->started)
+    g_error ("ncm_fit_hmc_set_nwarmup: Cannot change the warmup during a run, call ncm_fit_hmc_end_run() first.");
+
+  hmc->nwarmup = nwarmup;
+}
+
+/**
+ * ncm_fit_hmc_set_max_depth:
+ * @hmc: a #NcmFitHMC
+ * @max_depth: maximum tree depth
+ *
+ * Sets the maximum depth of the trajectory tree, each step uses at most
+ * $2^\mathrm{max\_depth} - 1$ gradient evaluations.
+ *
+ */
+void
+ncm_fit_hmc_set_max_depth (NcmFitHMC *hmc, guint max_depth)
+{
+  if (hmc->started)
+    g_error ("ncm_fit_hmc_set_max_depth: Cannot change the maximum depth during a run, call ncm_fit_hmc_end_run() first.");
+
+  g_assert_cmpuint (max_depth, >, 0);
+  hmc->max_depth = max_depth;
+}
+
+/**
+ * ncm_fit_hmc_set_target_accept:
+ * @hmc: a #NcmFitHMC
+ * @target_accept: target acceptance probability $\in (0, 1)$
+ *
+ * Sets the mean acceptance probability targeted by the step size
+ * adaptation.
+ *
+ */
+void
+ncm_fit_hmc_set_target_accept (NcmFitHMC *hmc, gdouble target_accept)
+{
+  g_assert_cmpfloat (target_accept, >, 0.0);
+  g_assert_cmpfloat (target_accept, <, 1.0);
+  hmc->target_accept = target_accept;
+}
+
+/**
+ * ncm_fit_hmc_set_dense_mass:
+ * @hmc: a #NcmFitHMC
+ * @dense_mass: whether to use a dense mass matrix
+ *
+ * Sets whether the inverse mass matrix estimated during the warmup is
+ * the full covariance of the samples or only its diagonal.
+ *
+ */
+void
+ncm_fit_hmc_set_dense_mass (NcmFitHMC *hmc, gboolean dense_mass)
+{
+  if (hmc->started)
+    g_error ("ncm_fit_hmc_set_dense_mass: Cannot change the mass matrix type during a run, call ncm_fit_hmc_end_run() first.");
+
+  hmc->dense_mass = dense_mass;
+}
+
+/**
+ * ncm_fit_hmc_get_nwarmup:
+ * @hmc: a #NcmFitHMC
+ *
+ * Returns: the number of warmup steps.
+ */
+guint
+ncm_fit_hmc_get_nwarmup (NcmFitHMC *hmc)
+{
+  return hmc->nwarmup;
+}
+
+/**
+ * ncm_fit_hmc_get_max_depth:
+ * @hmc: a #NcmFitHMC
+ *
+ * Returns: the maximum tree depth.
+ */
+guint
+ncm_fit_hmc_get_max_depth (NcmFitHMC *hmc)
+{
+  return hmc->max_depth;
+}
+
+/**
+ * ncm_fit_hmc_get_target_accept:
+ * @hmc: a #NcmFitHMC
+ *
+ * Returns: the target acceptance probability.
+ */
+gdouble
+ncm_fit_hmc_get_target_accept (NcmFitHMC *hmc)
+{
+  return hmc->target_accept;
+}
+
+/**
+ * ncm_fit_hmc_get_dense_mass:
+ * @hmc: a #NcmFitHMC
+ *
+ * Returns: whether the mass matrix is dense.
+ */
+gboolean
+ncm_fit_hmc_get_dense_mass (NcmFitHMC *hmc)
+{
+  return hmc->dense_mass;
+}
+
+/**
+ * ncm_fit_hmc_get_step_size:
+ * @hmc: a #NcmFitHMC
+ *
+ * Returns: the current leapfrog step size.
+ */
+gdouble
+ncm_fit_hmc_get_step_size (NcmFitHMC *hmc)
+{
+  return hmc->eps;
+}
+
+/**
+ * ncm_fit_hmc_get_accept_ratio:
+ * @hmc: a #NcmFitHMC
+ *
+ * Returns: the mean acceptance probability of the steps added to the
+ * catalog in the current run.
+ */
+gdouble
+ncm_fit_hmc_get_accept_ratio (NcmFitHMC *hmc)
+{
+  return hmc->sum_accept / (hmc->nsteps * 1.0);
+}
+
+/**
+ * ncm_fit_hmc_get_ngrad:
+ * @hmc: a #NcmFitHMC
+ *
+ * Returns: the number of likelihood gradient evaluations in the current
+ * run, including the warmup.
+ */
+guint
+ncm_fit_hmc_get_ngrad (NcmFitHMC *hmc)
+{
+  return hmc->ngrad;
+}
+
+/**
+ * ncm_fit_hmc_get_ess:
+ * @hmc: a #NcmFitHMC
+ *
+ * Estimates the effective sample size of the catalog, $N / \tau$, where
+ * $\tau$ is the largest integrated autocorrelation time among the free
+ * parameters, see ncm_mset_catalog_estimate_autocorrelation_tau().
+ *
+ * Returns: the effective sample size.
+ */
+gdouble
+ncm_fit_hmc_get_ess (NcmFitHMC *hmc)
+{
+  const guint len = ncm_mset_catalog_len (hmc->mcat);
+  NcmVector *tau;
+  gdouble tau_max = 1.0;
+  guint i;
+
+  if (len < 2)
+    return len;
+
+  ncm_mset_catalog_estimate_autocorrelation_tau (hmc->mcat);
+  tau = ncm_mset_catalog_peek_autocorrelation_tau (hmc->mcat);
+
+  for (i = 0; i < hmc->fparam_len; i++)
+    tau_max = GSL_MAX (tau_max, ncm_vector_get (tau, i));
+
+  return len / tau_max;
+}
+
+/**
+ * ncm_fit_hmc_get_ess_per_grad:
+ * @hmc: a #NcmFitHMC
+ *
+ * Computes the effective sample size (see ncm_fit_hmc_get_ess()) divided
+ * by the number of gradient evaluations done after the warmup. When the
+ * catalog was resumed from a file only the gradients of the current run
+ * are known, and the result is an upper bound.
+ *
+ * Returns: the effective sample size per gradient evaluation.
+ */
+gdouble
+ncm_fit_hmc_get_ess_per_grad (NcmFitHMC *hmc)
+{
+  const guint ngrad = hmc->ngrad - hmc->ngrad_warmup;
+
+  if (ngrad == 0)
+    return 0.0;
+
+  return ncm_fit_hmc_get_ess (hmc) / ngrad;
+}
+
+static void
+_ncm_fit_hmc_eval (NcmFitHMC *hmc, NcmFitHMCPoint *pt)
+{
+  if (!ncm_mset_fparam_valid_bounds (hmc->fit->mset, pt->theta))
+  {
+    pt->m2lnL = GSL_POSINF;
+    return;
+  }
+
+  ncm_mset_fparams_set_vector (hmc->fit->mset, pt->theta);
+  ncm_fit_m2lnL_val_grad (hmc->fit, &pt->m2lnL, pt->grad);
+  hmc->ngrad++;
+
+  if (!gsl_finite (pt->m2lnL))
+    pt->m2lnL = GSL_POSINF;
+}
+
+static void
+_ncm_fit_hmc_velocity (NcmFitHMC *hmc, NcmVector *p)
+{
+  gint ret = gsl_blas_dgemv (CblasNoTrans, 1.0, ncm_matrix_gsl (hmc->minv), ncm_vector_gsl (p), 0.0, ncm_vector_gsl (hmc->vel));
+  NCM_TEST_GSL_RESULT ("_ncm_fit_hmc_velocity", ret);
+}
+
+static gdouble
+_ncm_fit_hmc_log_joint (NcmFitHMC *hmc, NcmFitHMCPoint *pt)
+{
+  gdouble pMp = 0.0;
+  gint ret;
+
+  if (!gsl_finite (pt->m2lnL))
+    return GSL_NEGINF;
+
+  _ncm_fit_hmc_velocity (hmc, pt->p);
+  ret = gsl_blas_ddot (ncm_vector_gsl (pt->p), ncm_vector_gsl (hmc->vel), &pMp);
+  NCM_TEST_GSL_RESULT ("_ncm_fit_hmc_log_joint", ret);
+
+  return -0.5 * (pt->m2lnL + pMp);
+}
+
+static void
+_ncm_fit_hmc_leapfrog (NcmFitHMC *hmc, NcmFitHMCPoint *pt, const gdouble eps)
+{
+  gint ret;
+
+  /* The gradient of U = -lnL is half the gradient of -2lnL. */
+  ret = gsl_blas_daxpy (-0.25 * eps, ncm_vector_gsl (pt->grad), ncm_vector_gsl (pt->p));
+  NCM_TEST_GSL_RESULT ("_ncm_fit_hmc_leapfrog", ret);
+
+  _ncm_fit_hmc_velocity (hmc, pt->p);
+  ret = gsl_blas_daxpy (eps, ncm_vector_gsl (hmc->vel), ncm_vector_gsl (pt->theta));
+  NCM_TEST_GSL_RESULT ("_ncm_fit_hmc_leapfrog", ret);
+
+  _ncm_fit_hmc_eval (hmc, pt);
+
+  if (gsl_finite (pt->m2lnL))
+  {
+    ret = gsl_blas_daxpy (-0.25 * eps, ncm_vector_gsl (pt->grad), ncm_vector_gsl (pt->p));
+    NCM_TEST_GSL_RESULT ("_ncm_fit_hmc_leapfrog", ret);
+  }
+}
+
+static void
+_ncm_fit_hmc_sample_momentum (NcmFitHMC *hmc, NcmFitHMCPoint *pt)
+{
+  NcmRNG *rng = hmc->mcat->rng;
+  guint i;
+  gint ret;
+
+  for (i = 0; i < hmc->fparam_len; i++)
+    ncm_vector_set (pt->p, i, gsl_ran_ugaussian (rng->r));
+
+  /* p = L^{-T} z is distributed as N (0, M) with M^{-1} = L L^T. */
+  ret = gsl_blas_dtrsv (CblasLower, CblasTrans, CblasNonUnit,
+                        ncm_matrix_gsl (hmc->minv_L), ncm_vector_gsl (pt->p));
+  NCM_TEST_GSL_RESULT ("_ncm_fit_hmc_sample_momentum", ret);
+}
+
+static gboolean
+_ncm_fit_hmc_no_uturn (NcmFitHMC *hmc, NcmFitHMCPoint *minus, NcmFitHMCPoint *plus)
+{
+  gdouble dm = 0.0, dp = 0.0;
+
+  ncm_vector_memcpy (hmc->dtheta, plus->theta);
+  ncm_vector_sub (hmc->dtheta, minus->theta);
+
+  _ncm_fit_hmc_velocity (hmc, minus->p);
+  gsl_blas_ddot (ncm_vector_gsl (hmc->dtheta), ncm_vector_gsl (hmc->vel), &dm);
+
+  _ncm_fit_hmc_velocity (hmc, plus->p);
+  gsl_blas_ddot (ncm_vector_gsl (hmc->dtheta), ncm_vector_gsl (hmc->vel), &dp);
+
+  return (dm >= 0.0) && (dp >= 0.0);
+}
+
+static void
+_ncm_fit_hmc_build_tree (NcmFitHMC *hmc, NcmFitHMCPoint *edge, NcmFitHMCPoint *inner, NcmFitHMCPoint *prop,
+                         const gint v, const guint j, const gdouble lnu, const gdouble H0,
+                         guint *n, gboolean *s, gdouble *alpha, guint *nalpha)
+{
+  if (j == 0)
+  {
+    gdouble H;
+
+    _ncm_fit_hmc_leapfrog (hmc, edge, v * hmc->eps);
+    H = _ncm_fit_hmc_log_joint (hmc, edge);
+
+    _ncm_fit_hmc_point_copy (inner, edge);
+    _ncm_fit_hmc_point_copy (prop, edge);
+
+    *n      = (lnu <= H) ? 1 : 0;
+    *s      = (lnu < H + NCM_FIT_HMC_DELTA_MAX);
+    *alpha  = gsl_finite (H) ? GSL_MIN (1.0, exp (H - H0)) : 0.0;
+    *nalpha = 1;
+
+    if (!*s)
+      hmc->ndivergent++;
+  }
+  else
+  {
+    /* The first half extends edge and sets inner, the second half uses the level j work space. */
+    NcmFitHMCPoint *inner2 = g_ptr_array_index (hmc->tree_inner, j);
+    NcmFitHMCPoint *prop2  = g_ptr_array_index (hmc->tree_prop, j);
+
+    _ncm_fit_hmc_build_tree (hmc, edge, inner, prop, v, j - 1, lnu, H0, n, s, alpha, nalpha);
+
+    if (*s)
+    {
+      guint n2, nalpha2;
+      gboolean s2;
+      gdouble alpha2;
+
+      _ncm_fit_hmc_build_tree (hmc, edge, inner2, prop2, v, j - 1, lnu, H0, &n2, &s2, &alpha2, &nalpha2);
+
+      if ((n2 > 0) && (gsl_rng_uniform (hmc->mcat->rng->r) * (*n + n2) < n2))
+        _ncm_fit_hmc_point_copy (prop, prop2);
+
+      *alpha  += alpha2;
+      *nalpha += nalpha2;
+      *n      += n2;
+      *s       = s2 && ((v > 0) ? _ncm_fit_hmc_no_uturn (hmc, inner, edge) : _ncm_fit_hmc_no_uturn (hmc, edge, inner));
+    }
+  }
+}
+
+static gdouble
+_ncm_fit_hmc_transition (NcmFitHMC *hmc)
+{
+  NcmRNG *rng      = hmc->mcat->rng;
+  gdouble sum_alpha = 0.0;
+  guint sum_nalpha  = 0;
+  guint n           = 1;
+  gboolean s        = TRUE;
+  guint j           = 0;
+  gdouble H0, lnu;
+
+  _ncm_fit_hmc_sample_momentum (hmc, hmc->cur);
+  H0  = _ncm_fit_hmc_log_joint (hmc, hmc->cur);
+  lnu = H0 + log (gsl_rng_uniform_pos (rng->r));
+
+  _ncm_fit_hmc_point_copy (hmc->minus, hmc->cur);
+  _ncm_fit_hmc_point_copy (hmc->plus, hmc->cur);
+
+  while (s && (j < hmc->max_depth))
+  {
+    const gint v = (gsl_rng_uniform (rng->r) < 0.5) ? -1 : 1;
+    guint n1, nalpha1;
+    gboolean s1;
+    gdouble alpha1;
+
+    if (v < 0)
+      _ncm_fit_hmc_build_tree (hmc, hmc->minus, hmc->inner, hmc->prop, v, j, lnu, H0, &n1, &s1, &alpha1, &nalpha1);
+    else
+      _ncm_fit_hmc_build_tree (hmc, hmc->plus, hmc->inner, hmc->prop, v, j, lnu, H0, &n1, &s1, &alpha1, &nalpha1);
+
+    if (s1 && (n1 > 0) && (gsl_rng_uniform (rng->r) * n < n1))
+      _ncm_fit_hmc_point_copy (hmc->cur, hmc->prop);
+
+    n          += n1;
+    s           = s1 && _ncm_fit_hmc_no_uturn (hmc, hmc->minus, hmc->plus);
+    sum_alpha  += alpha1;
+    sum_nalpha += nalpha1;
+    j++;
+  }
+
+  return sum_alpha / sum_nalpha;
+}
+
+static void
+_ncm_fit_hmc_init_step_size (NcmFitHMC *hmc)
+{
+  gdouble H0, H;
+  gint a, i;
+
+  if (hmc->eps <= 0.0)
+    hmc->eps = 1.0;
+
+  _ncm_fit_hmc_sample_momentum (hmc, hmc->cur);
+  H0 = _ncm_fit_hmc_log_joint (hmc, hmc->cur);
+
+  _ncm_fit_hmc_point_copy (hmc->prop, hmc->cur);
+  _ncm_fit_hmc_leapfrog (hmc, hmc->prop, hmc->eps);
+  H = _ncm_fit_hmc_log_joint (hmc, hmc->prop);
+
+  /* Doubles or halves the step until the acceptance probability crosses 1/2. */
+  a = (H - H0 > -M_LN2) ? 1 : -1;
+  for (i = 0; i < 100; i++)
+  {
+    if (!(a * (H - H0) > -a * M_LN2))
+      break;
+
+    hmc->eps = (a > 0) ? 2.0 * hmc->eps : 0.5 * hmc->eps;
+
+    _ncm_fit_hmc_point_copy (hmc->prop, hmc->cur);
+    _ncm_fit_hmc_leapfrog (hmc, hmc->prop, hmc->eps);
+    H = _ncm_fit_hmc_log_joint (hmc, hmc->prop);
+  }
+
+  hmc->mu      = log (10.0 * hmc->eps);
+  hmc->Hbar    = 0.0;
+  hmc->eps_bar = 1.0;
+}
+
+static void
+_ncm_fit_hmc_adapt_step_size (NcmFitHMC *hmc, const guint m, const gdouble accept)
+{
+  const gdouble t0    = 10.0;
+  const gdouble gamma = 0.05;
+  const gdouble kappa = 0.75;
+  const gdouble w     = 1.0 / (m + t0);
+  const gdouble eta   = pow (m, -kappa);
+  gdouble lneps;
+
+  hmc->Hbar    = (1.0 - w) * hmc->Hbar + w * (hmc->target_accept - accept);
+  lneps        = hmc->mu - sqrt (m) / gamma * hmc->Hbar;
+  hmc->eps     = exp (lneps);
+  hmc->eps_bar = exp (eta * lneps + (1.0 - eta) * log (hmc->eps_bar));
+}
+
+static void
+_ncm_fit_hmc_set_minv (NcmFitHMC *hmc)
+{
+  gint ret;
+
+  ncm_matrix_memcpy (hmc->minv_L, hmc->minv);
+  ret = ncm_matrix_cholesky_decomp (hmc->minv_L, 'L');
+  if (ret != 0)
+    g_error ("_ncm_fit_hmc_set_minv: inverse mass matrix is not positive definite [%d].", ret);
+}
+
+static void
+_ncm_fit_hmc_update_metric (NcmFitHMC *hmc)
+{
+  const gdouble n = ncm_stats_vec_get_weight (hmc->wstats);
+  const gdouble a = n / (n + 5.0);
+  guint i, j;
+
+  /* The covariance is shrunk towards its diagonal, as the identity shrinkage of Stan would not be scale free. */
+  for (i = 0; i < hmc->fparam_len; i++)
+  {
+    ncm_matrix_set (hmc->minv, i, i, ncm_stats_vec_get_var (hmc->wstats, i));
+
+    for (j = 0; j < i; j++)
+    {
+      const gdouble cov_ij = hmc->dense_mass ? a * ncm_stats_vec_get_cov (hmc->wstats, i, j) : 0.0;
+
+      ncm_matrix_set (hmc->minv, i, j, cov_ij);
+      ncm_matrix_set (hmc->minv, j, i, cov_ij);
+    }
+  }
+
+  _ncm_fit_hmc_set_minv (hmc);
+  ncm_stats_vec_reset (hmc->wstats, FALSE);
+}
+
+static void
+_ncm_fit_hmc_prepare_windows (NcmFitHMC *hmc)
+{
+  const guint W  = hmc->nwarmup;
+  guint init     = 75;
+  guint term     = 50;
+  guint base     = 25;
+  guint start, w;
+
+  g_array_set_size (hmc->windows, 0);
+
+  if (W < 20)
+    return;
+
+  if (init + term + base > W)
+  {
+    init = 0.15 * W;
+    term = 0.1 * W;
+    base = W - init - term;
+  }
+
+  /* windows = [init, end_1, end_2, ...], the metric is estimated in [end_{k-1}, end_k). */
+  g_array_append_val (hmc->windows, init);
+
+  start = init;
+  w     = base;
+  while (TRUE)
+  {
+    guint end = start + w;
+
+    if (end + 2 * w > W - term)
+      end = W - term;
+
+    g_array_append_val (hmc->windows, end);
+
+    if (end >= W - term)
+      break;
+
+    start  = end;
+    w     *= 2;
+  }
+}
+
+static void
+_ncm_fit_hmc_warmup (NcmFitHMC *hmc)
+{
+  guint m, mi = 0, k = 1;
+
+  _ncm_fit_hmc_prepare_windows (hmc);
+  _ncm_fit_hmc_init_step_size (hmc);
+
+  if (hmc->mtype > NCM_FIT_RUN_MSGS_NONE)
+  {
+    ncm_cfg_msg_sepa ();
+    g_message ("# NcmFitHMC: Running %u warmup steps, initial step size %.5g.\n", hmc->nwarmup, hmc->eps);
+  }
+
+  for (m = 0; m < hmc->nwarmup; m++)
+  {
+    const gdouble accept = _ncm_fit_hmc_transition (hmc);
+
+    mi++;
+    _ncm_fit_hmc_adapt_step_size (hmc, mi, accept);
+
+    if (k < hmc->windows->len)
+    {
+      if (m >= g_array_index (hmc->windows, guint, k - 1))
+      {
+        ncm_vector_memcpy (ncm_stats_vec_peek_x (hmc->wstats), hmc->cur->theta);
+        ncm_stats_vec_update (hmc->wstats);
+      }
+
+      if (m + 1 == g_array_index (hmc->windows, guint, k))
+      {
+        _ncm_fit_hmc_update_metric (hmc);
+        _ncm_fit_hmc_init_step_size (hmc);
+        mi = 0;
+        k++;
+
+        if (hmc->mtype > NCM_FIT_RUN_MSGS_NONE)
+          g_message ("# NcmFitHMC: Warmup step %u, mass matrix updated, step size %.5g.\n", m + 1, hmc->eps);
+      }
+    }
+  }
+
+  if (hmc->nwarmup > 0)
+    hmc->eps = hmc->eps_bar;
+
+  hmc->ngrad_warmup = hmc->ngrad;
+
+  if (hmc->mtype > NCM_FIT_RUN_MSGS_NONE)
+    g_message ("# NcmFitHMC: Warmup finished, step size %.5g, %u gradient evaluations, %u divergent trajectories.\n",
+               hmc->eps, hmc->ngrad_warmup, hmc->ndivergent);
+}
+
+/**
+ * ncm_fit_hmc_start_run:
+ * @hmc: a #NcmFitHMC
+ *
+ * Prepares the run and tunes the sampler with the warmup steps. If the
+ * catalog already contains samples, the chain starts at the last one.
+ *
+ */
+void
+ncm_fit_hmc_start_run (NcmFitHMC *hmc)
+{
+  guint j;
+
+  if (hmc->started)
+    g_error ("ncm_fit_hmc_start_run: run already started, run ncm_fit_hmc_end_run() first.");
+
+  switch (hmc->mtype)
+  {
+    default:
+    case NCM_FIT_RUN_MSGS_FULL:
+      ncm_cfg_msg_sepa ();
+      g_message ("# NcmFitHMC: Starting Hamiltonian Monte Carlo (NUTS)...\n");
+      ncm_dataset_log_info (hmc->fit->lh->dset);
+      ncm_cfg_msg_sepa ();
+      g_message ("# NcmFitHMC: Model set:\n");
+      ncm_mset_pretty_log (hmc->fit->mset);
+      break;
+    case NCM_FIT_RUN_MSGS_SIMPLE:
+      break;
+    case NCM_FIT_RUN_MSGS_NONE:
+      break;
+  }
+
+  if (hmc->mcat->rng == NULL)
+  {
+    NcmRNG *rng = ncm_rng_new (NULL);
+    ncm_rng_set_random_seed (rng, FALSE);
+    ncm_fit_hmc_set_rng (hmc, rng);
+    if (hmc->mtype > NCM_FIT_RUN_MSGS_NONE)
+      g_message ("# NcmFitHMC: No RNG was defined, using algorithm: `%s' and seed: %lu.\n",
+                 ncm_rng_get_algo (rng), ncm_rng_get_seed (rng));
+    ncm_rng_free (rng);
+  }
+
+  hmc->started    = TRUE;
+  hmc->ngrad      = 0;
+  hmc->ndivergent = 0;
+  hmc->nsteps     = 0;
+  hmc->sum_accept = 0.0;
+
+  ncm_mset_catalog_set_sync_mode (hmc->mcat, NCM_MSET_CATALOG_SYNC_TIMED);
+  ncm_mset_catalog_set_sync_interval (hmc->mcat, NCM_FIT_HMC_MIN_SYNC_INTERVAL);
+  ncm_mset_catalog_sync (hmc->mcat, TRUE);
+
+  if (hmc->mcat->first_id > 0)
+    g_error ("ncm_fit_hmc_start_run: cannot use catalogs with first_id > 0.");
+
+  ncm_stats_vec_clear (&hmc->wstats);
+  hmc->wstats = ncm_stats_vec_new (hmc->fparam_len, hmc->dense_mass ? NCM_STATS_VEC_COV : NCM_STATS_VEC_VAR, FALSE);
+
+  /* Work space for the trajectory tree, one pair of points per level. */
+  while (hmc->tree_inner->len < hmc->max_depth)
+  {
+    g_ptr_array_add (hmc->tree_inner, _ncm_fit_hmc_point_new (hmc->fparam_len));
+    g_ptr_array_add (hmc->tree_prop, _ncm_fit_hmc_point_new (hmc->fparam_len));
+  }
+
+  if (hmc->mcat->cur_id > hmc->cur_sample_id)
+  {
+    NcmVector *row = ncm_mset_catalog_peek_row (hmc->mcat, hmc->mcat->cur_id);
+    g_assert (row != NULL);
+
+    for (j = 0; j < hmc->fparam_len; j++)
+      ncm_vector_set (hmc->cur->theta, j, ncm_vector_get (row, j + 1));
+
+    if (hmc->mtype > NCM_FIT_RUN_MSGS_NONE)
+    {
+      ncm_cfg_msg_sepa ();
+      g_message ("# NcmFitHMC: Continuing the chain from the point %d.\n", hmc->mcat->cur_id + 1);
+    }
+    hmc->cur_sample_id = hmc->mcat->cur_id;
+  }
+  else if (hmc->mcat->cur_id < hmc->cur_sample_id)
+    g_error ("ncm_fit_hmc_start_run: Unknown error cur_id < cur_sample_id [%d < %d].",
+             hmc->mcat->cur_id, hmc->cur_sample_id);
+  else if (hmc->cur_sample_id < 0)
+    ncm_mset_fparams_get_vector (hmc->fit->mset, hmc->cur->theta);
+
+  _ncm_fit_hmc_eval (hmc, hmc->cur);
+  if (!gsl_finite (hmc->cur->m2lnL))
+    g_error ("ncm_fit_hmc_start_run: the likelihood is zero at the initial point.");
+
+  _ncm_fit_hmc_set_minv (hmc);
+  _ncm_fit_hmc_warmup (hmc);
+}
+
+/**
+ * ncm_fit_hmc_end_run:
+ * @hmc: a #NcmFitHMC
+ *
+ * Ends the run and synchronizes the catalog with its file.
+ *
+ */
+void
+ncm_fit_hmc_end_run (NcmFitHMC *hmc)
+{
+  if (ncm_timer_task_is_running (hmc->nt))
+    ncm_timer_task_end (hmc->nt);
+
+  ncm_mset_catalog_sync (hmc->mcat, TRUE);
+  hmc->started = FALSE;
+}
+
+/**
+ * ncm_fit_hmc_reset:
+ * @hmc: a #NcmFitHMC
+ *
+ * Discards all samples and resets the catalog.
+ *
+ */
+void
+ncm_fit_hmc_reset (NcmFitHMC *hmc)
+{
+  hmc->n             = 0;
+  hmc->cur_sample_id = -1;
+  hmc->ngrad         = 0;
+  hmc->ngrad_warmup  = 0;
+  hmc->ndivergent    = 0;
+  hmc->nsteps        = 0;
+  hmc->sum_accept    = 0.0;
+  hmc->started       = FALSE;
+  ncm_mset_catalog_reset (hmc->mcat);
+}
+
+static void
+_ncm_fit_hmc_update (NcmFitHMC *hmc)
+{
+  const guint part = 5;
+  const guint step = (hmc->n / part) == 0 ? 1 : (hmc->n / part);
+  guint j;
+
+  ncm_vector_set (hmc->row, NCM_FIT_HMC_M2LNL_ID, hmc->cur->m2lnL);
+  for (j = 0; j < hmc->fparam_len; j++)
+    ncm_vector_set (hmc->row, j + 1, ncm_vector_get (hmc->cur->theta, j));
+
+  ncm_mset_catalog_add_from_vector (hmc->mcat, hmc->row);
+  hmc->cur_sample_id++;
+  ncm_timer_task_increment (hmc->nt);
+
+  switch (hmc->mtype)
+  {
+    case NCM_FIT_RUN_MSGS_NONE:
+      break;
+    case NCM_FIT_RUN_MSGS_SIMPLE:
+    {
+      guint stepi = hmc->nt->task_pos % step;
+      gboolean log_timeout = FALSE;
+      if ((hmc->nt->pos_time - hmc->nt->last_log_time) > 60.0)
+        log_timeout = TRUE;
+      if (log_timeout || (stepi == 0) || (hmc->nt->task_pos == hmc->nt->task_len))
+      {
+        ncm_mset_catalog_log_current_stats (hmc->mcat);
+        g_message ("# NcmFitHMC:acceptance ratio %7.4f%%, %u gradient evaluations, %u divergent.\n",
+                   ncm_fit_hmc_get_accept_ratio (hmc) * 100.0, hmc->ngrad, hmc->ndivergent);
+        ncm_timer_task_log_elapsed (hmc->nt);
+        ncm_timer_task_log_mean_time (hmc->nt);
+        ncm_timer_task_log_time_left (hmc->nt);
+        ncm_timer_task_log_end_datetime (hmc->nt);
+      }
+      break;
+    }
+    default:
+    case NCM_FIT_RUN_MSGS_FULL:
+      ncm_mset_fparams_set_vector (hmc->fit->mset, hmc->cur->theta);
+      ncm_fit_state_set_m2lnL_curval (hmc->fit->fstate, hmc->cur->m2lnL);
+      hmc->fit->mtype = hmc->mtype;
+      ncm_fit_log_state (hmc->fit);
+      ncm_mset_catalog_log_current_stats (hmc->mcat);
+      g_message ("# NcmFitHMC:acceptance ratio %7.4f%%, %u gradient evaluations, %u divergent.\n",
+                 ncm_fit_hmc_get_accept_ratio (hmc) * 100.0, hmc->ngrad, hmc->ndivergent);
+      ncm_timer_task_log_elapsed (hmc->nt);
+      ncm_timer_task_log_mean_time (hmc->nt);
+      ncm_timer_task_log_time_left (hmc->nt);
+      ncm_timer_task_log_end_datetime (hmc->nt);
+      break;
+  }
+}
+
+/**
+ * ncm_fit_hmc_run:
+ * @hmc: a #NcmFitHMC
+ * @n: total number of samples
+ *
+ * Runs the sampler until the catalog contains @n samples.
+ *
+ */
+void
+ncm_fit_hmc_run (NcmFitHMC *hmc, guint n)
+{
+  if (!hmc->started)
+    g_error ("ncm_fit_hmc_run: run not started, run ncm_fit_hmc_start_run() first.");
+
+  if (n <= (hmc->cur_sample_id + 1))
+  {
+    if (hmc->mtype > NCM_FIT_RUN_MSGS_NONE)
+    {
+      ncm_cfg_msg_sepa ();
+      g_message ("# NcmFitHMC: Nothing to do, current sample number is %d\n", hmc->cur_sample_id + 1);
+    }
+    return;
+  }
+
+  hmc->n = n - (hmc->cur_sample_id + 1);
+
+  if (hmc->mtype > NCM_FIT_RUN_MSGS_NONE)
+  {
+    ncm_cfg_msg_sepa ();
+    g_message ("# NcmFitHMC: Calculating [%06d] Hamiltonian Monte Carlo (NUTS) samples, step size %.5g.\n",
+               hmc->n, hmc->eps);
+  }
+
+  if (ncm_timer_task_is_running (hmc->nt))
+  {
+    ncm_timer_task_add_tasks (hmc->nt, hmc->n);
+    ncm_timer_task_continue (hmc->nt);
+  }
+  else
+  {
+    ncm_timer_task_start (hmc->nt, hmc->n);
+    ncm_timer_set_name (hmc->nt, "NcmFitHMC");
+  }
+  if (hmc->mtype > NCM_FIT_RUN_MSGS_NONE)
+    ncm_timer_task_log_start_datetime (hmc->nt);
+
+  while (hmc->cur_sample_id + 1 < n)
+  {
+    hmc->sum_accept += _ncm_fit_hmc_transition (hmc);
+    hmc->nsteps++;
+
+    _ncm_fit_hmc_update (hmc);
+  }
+
+  ncm_timer_task_pause (hmc->nt);
+
+  if (hmc->mtype > NCM_FIT_RUN_MSGS_NONE)
+  {
+    const gdouble ess = ncm_fit_hmc_get_ess (hmc);
+
+    ncm_cfg_msg_sepa ();
+    g_message ("# NcmFitHMC: Effective sample size %.1f, %.4e per gradient evaluation (%u gradients after warmup).\n",
+               ess, ncm_fit_hmc_get_ess_per_grad (hmc), hmc->ngrad - hmc->ngrad_warmup);
+  }
+}
+
+/**
+ * ncm_fit_hmc_get_catalog:
+ * @hmc: a #NcmFitHMC
+ *
+ * Gets the catalog containing the samples.
+ *
+ * Returns: (transfer full): the #NcmMSetCatalog.
+ */
+NcmMSetCatalog *
+ncm_fit_hmc_get_catalog (NcmFitHMC *hmc)
+{
+  return ncm_mset_catalog_ref (hmc->mcat);
+}
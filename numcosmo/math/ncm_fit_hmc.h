@@ -0,0 +1,134 @@
+/***************************************************************************
+ *            ncm_fit_hmc.h
+ *
+ *  Mon October 19 20:41:13 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_fit_hmc.h
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _NCM_FIT_HMC_H_
+#define _NCM_FIT_HMC_H_
+
+#include <glib.h>
+#include <glib-object.h>
+#include <numcosmo/build_cfg.h>
+#include <numcosmo/math/ncm_fit.h>
+#include <numcosmo/math/ncm_mset_catalog.h>
+#include <numcosmo/math/ncm_stats_vec.h>
+#include <numcosmo/math/ncm_timer.h>
+
+G_BEGIN_DECLS
+
+#define NCM_TYPE_FIT_HMC             (ncm_fit_hmc_get_type ())
+#define NCM_FIT_HMC(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), NCM_TYPE_FIT_HMC, NcmFitHMC))
+#define NCM_FIT_HMC_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), NCM_TYPE_FIT_HMC, NcmFitHMCClass))
+#define NCM_IS_FIT_HMC(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), NCM_TYPE_FIT_HMC))
+#define NCM_IS_FIT_HMC_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), NCM_TYPE_FIT_HMC))
+#define NCM_FIT_HMC_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), NCM_TYPE_FIT_HMC, NcmFitHMCClass))
+
+typedef struct _NcmFitHMCClass NcmFitHMCClass;
+typedef struct _NcmFitHMC NcmFitHMC;
+typedef struct _NcmFitHMCPoint NcmFitHMCPoint;
+
+struct _NcmFitHMCClass
+{
+  /*< private >*/
+  GObjectClass parent_class;
+};
+
+struct _NcmFitHMC
+{
+  /*< private >*/
+  GObject parent_instance;
+  NcmFit *fit;
+  NcmMSetCatalog *mcat;
+  NcmFitRunMsgs mtype;
+  NcmTimer *nt;
+  NcmStatsVec *wstats;
+  NcmMatrix *minv;
+  NcmMatrix *minv_L;
+  NcmVector *dtheta;
+  NcmVector *vel;
+  NcmVector *row;
+  NcmFitHMCPoint *cur;
+  NcmFitHMCPoint *minus;
+  NcmFitHMCPoint *plus;
+  NcmFitHMCPoint *inner;
+  NcmFitHMCPoint *prop;
+  GPtrArray *tree_inner;
+  GPtrArray *tree_prop;
+  GArray *windows;
+  gdouble eps;
+  gdouble eps_bar;
+  gdouble Hbar;
+  gdouble mu;
+  gdouble target_accept;
+  gdouble sum_accept;
+  guint fparam_len;
+  guint nwarmup;
+  guint max_depth;
+  guint n;
+  guint ngrad;
+  guint ngrad_warmup;
+  guint ndivergent;
+  guint nsteps;
+  gint cur_sample_id;
+  gboolean dense_mass;
+  gboolean started;
+};
+
+GType ncm_fit_hmc_get_type (void) G_GNUC_CONST;
+
+NcmFitHMC *ncm_fit_hmc_new (NcmFit *fit, NcmFitRunMsgs mtype);
+void ncm_fit_hmc_free (NcmFitHMC *hmc);
+void ncm_fit_hmc_clear (NcmFitHMC **hmc);
+
+void ncm_fit_hmc_set_data_file (NcmFitHMC *hmc, const gchar *filename);
+void ncm_fit_hmc_set_mtype (NcmFitHMC *hmc, NcmFitRunMsgs mtype);
+void ncm_fit_hmc_set_rng (NcmFitHMC *hmc, NcmRNG *rng);
+void ncm_fit_hmc_set_nwarmup (NcmFitHMC *hmc, guint nwarmup);
+void ncm_fit_hmc_set_max_depth (NcmFitHMC *hmc, guint max_depth);
+void ncm_fit_hmc_set_target_accept (NcmFitHMC *hmc, gdouble target_accept);
+void ncm_fit_hmc_set_dense_mass (NcmFitHMC *hmc, gboolean dense_mass);
+
+guint ncm_fit_hmc_get_nwarmup (NcmFitHMC *hmc);
+guint ncm_fit_hmc_get_max_depth (NcmFitHMC *hmc);
+gdouble ncm_fit_hmc_get_target_accept (NcmFitHMC *hmc);
+gboolean ncm_fit_hmc_get_dense_mass (NcmFitHMC *hmc);
+gdouble ncm_fit_hmc_get_step_size (NcmFitHMC *hmc);
+gdouble ncm_fit_hmc_get_accept_ratio (NcmFitHMC *hmc);
+guint ncm_fit_hmc_get_ngrad (NcmFitHMC *hmc);
+gdouble ncm_fit_hmc_get_ess (NcmFitHMC *hmc);
+gdouble ncm_fit_hmc_get_ess_per_grad (NcmFitHMC *hmc);
+
+void ncm_fit_hmc_start_run (NcmFitHMC *hmc);
+void ncm_fit_hmc_end_run (NcmFitHMC *hmc);
+void ncm_fit_hmc_reset (NcmFitHMC *hmc);
+void ncm_fit_hmc_run (NcmFitHMC *hmc, guint n);
+
+NcmMSetCatalog *ncm_fit_hmc_get_catalog (NcmFitHMC *hmc);
+
+#define NCM_FIT_HMC_MIN_SYNC_INTERVAL (10.0)
+#define NCM_FIT_HMC_M2LNL_ID (0)
+#define NCM_FIT_HMC_DELTA_MAX (1000.0)
+
+G_END_DECLS
+
+#endif /* _NCM_FIT_HMC_H_ */
@@ -28,7 +28,17 @@
  * @title: NcmFitMC
  * @short_description: Monte Carlo analysis.
  *
- * FIXME
+ * Monte Carlo analysis of a #NcmFit: each realization resamples the
+ * #NcmDataset (from the fiducial model or by bootstrap), fits it and adds
+ * the best-fit to a #NcmMSetCatalog.
+ *
+ * The random numbers of each realization are drawn from its own stream,
+ * determined by the initial state of the catalog #NcmRNG and by the
+ * realization index. When #NcmFitMC:nthreads is larger than one the
+ * realizations are fitted concurrently, each thread with its own copies of
+ * the #NcmFit and of the fiducial #NcmMSet, and the results go through a
+ * reorder buffer so that the catalog is always written in order. Hence, the
+ * catalog does not depend on the number of threads.
  * 
  */
 
@@ -73,13 +83,13 @@ ncm_fit_mc_init (NcmFitMC *mc)
   mc->n               = 0;
   mc->keep_order      = FALSE;
   mc->mp              = NULL;
+  mc->reorder         = g_ptr_array_new_with_free_func ((GDestroyNotify) &ncm_vector_free);
+  mc->root_rng        = NULL;
   mc->cur_sample_id   = -1; /* Represents that no samples were calculated yet. */
   mc->write_index     = 0;
   mc->started         = FALSE;
   g_mutex_init (&mc->dup_fit);
-  g_mutex_init (&mc->resample_lock);
   g_mutex_init (&mc->update_lock);
-  g_cond_init (&mc->write_cond);
 }
 
 static void _ncm_fit_mc_set_fit_obj (NcmFitMC *mc, NcmFit *fit);
@@ -165,6 +175,8 @@ ncm_fit_mc_dispose (GObject *object)
   ncm_timer_clear (&mc->nt);
   ncm_serialize_clear (&mc->ser);
   ncm_mset_catalog_clear (&mc->mcat);
+  g_clear_pointer (&mc->reorder, g_ptr_array_unref);
+  ncm_rng_clear (&mc->root_rng);
 
   if (mc->mp != NULL)
   {
@@ -182,9 +194,7 @@ ncm_fit_mc_finalize (GObject *object)
   NcmFitMC *mc = NCM_FIT_MC (object);
 
   g_mutex_clear (&mc->dup_fit);
-  g_mutex_clear (&mc->resample_lock);
   g_mutex_clear (&mc->update_lock);
-  g_cond_clear (&mc->write_cond);
   
   /* Chain up : end */
   G_OBJECT_CLASS (ncm_fit_mc_parent_class)->finalize (object);
@@ -355,12 +365,27 @@ ncm_fit_mc_set_mtype (NcmFitMC *mc, NcmFitRunMsgs mtype)
 
 static void _ncm_fit_mc_resample_bstrap (NcmDataset *dset, NcmMSet *mset, NcmRNG *rng);
 
-static gint
-_ncm_fit_mc_resample (NcmFitMC *mc, NcmFit *fit)
+static void
+_ncm_fit_mc_set_root_rng (NcmFitMC *mc)
 {
-  mc->resample (fit->lh->dset, mc->fiduc, mc->mcat->rng);
-  mc->cur_sample_id++;
-  return mc->cur_sample_id;
+  /* 
+   * The realization streams are derived from the initial state of the catalog 
+   * RNG, which is also saved in the catalog file.
+   */
+  ncm_rng_clear (&mc->root_rng);
+  mc->root_rng = ncm_rng_new (ncm_rng_get_algo (mc->mcat->rng));
+  ncm_rng_set_state (mc->root_rng, mc->mcat->rng_inis);
+}
+
+static void
+_ncm_fit_mc_resample (NcmFitMC *mc, NcmFit *fit, NcmMSet *fiduc, NcmRNG *rng, gint sample_id)
+{
+  /*
+   * Each realization has its own stream depending only on the catalog RNG and 
+   * on its index, so the results do not depend on the number of threads.
+   */
+  ncm_rng_stream_set (rng, mc->root_rng, sample_id);
+  mc->resample (fit->lh->dset, fiduc, rng);
 }
 
 /**
@@ -420,9 +445,11 @@ ncm_fit_mc_set_nthreads (NcmFitMC *mc, guint nthreads)
 /**
  * ncm_fit_mc_keep_order:
  * @mc: a #NcmFitMC
- * @keep_order: FIXME
+ * @keep_order: whether to keep the catalog in order
  *
- * FIXME
+ * The realizations are always added to the catalog in order of their
+ * index through a reorder buffer, without blocking the threads, so this
+ * option is kept only for compatibility and has no effect.
  *
  */
 void 
@@ -472,13 +499,15 @@ ncm_fit_mc_set_rng (NcmFitMC *mc, NcmRNG *rng)
   ncm_mset_catalog_set_rng (mc->mcat, rng);
 }
 
-void
-_ncm_fit_mc_update (NcmFitMC *mc, NcmFit *fit)
+static void
+_ncm_fit_mc_update (NcmFitMC *mc, NcmVector *row)
 {
   const guint part = 5;
   const guint step = (mc->n / part) == 0 ? 1 : (mc->n / part);
 
-  ncm_mset_catalog_add_from_mset (mc->mcat, fit->mset, ncm_fit_state_get_m2lnL_curval (fit->fstate), NULL);
+  ncm_mset_catalog_add_from_vector (mc->mcat, row);
+  mc->cur_sample_id++;
+  mc->write_index++;
   ncm_timer_task_increment (mc->nt);
 
   switch (mc->mtype)
@@ -505,8 +534,13 @@ _ncm_fit_mc_update (NcmFitMC *mc, NcmFit *fit)
     }
     default:
     case NCM_FIT_RUN_MSGS_FULL:
-      fit->mtype = mc->mtype;
-      ncm_fit_log_state (fit);
+      /* The main fit object is also the source of the threads copies. */
+      g_mutex_lock (&mc->dup_fit);
+      ncm_mset_fparams_set_vector_offset (mc->fit->mset, row, 1);
+      ncm_fit_state_set_m2lnL_curval (mc->fit->fstate, ncm_vector_get (row, 0));
+      mc->fit->mtype = mc->mtype;
+      ncm_fit_log_state (mc->fit);
+      g_mutex_unlock (&mc->dup_fit);
       ncm_mset_catalog_log_current_stats (mc->mcat);
       /* ncm_timer_task_increment (mc->nt); */
       ncm_timer_task_log_elapsed (mc->nt);
@@ -574,6 +608,7 @@ ncm_fit_mc_start_run (NcmFitMC *mc)
   }
 
   mc->started = TRUE;
+  _ncm_fit_mc_set_root_rng (mc);
 
   ncm_mset_catalog_set_sync_mode (mc->mcat, NCM_MSET_CATALOG_SYNC_TIMED);
   ncm_mset_catalog_set_sync_interval (mc->mcat, NCM_FIT_MC_MIN_SYNC_INTERVAL);
@@ -745,103 +780,133 @@ ncm_fit_mc_run (NcmFitMC *mc, guint n)
   ncm_timer_task_pause (mc->nt);
 }
 
+static void
+_ncm_fit_mc_fill_row (NcmFit *fit, NcmVector *row)
+{
+  ncm_vector_set (row, 0, ncm_fit_state_get_m2lnL_curval (fit->fstate));
+  ncm_mset_fparams_get_vector_offset (fit->mset, row, 1);
+}
+
 static void 
 _ncm_fit_mc_run_single (NcmFitMC *mc)
 {
+  NcmRNG *rng    = ncm_rng_new (NCM_RNG_STREAM_ALGO);
+  NcmVector *row = ncm_vector_new (ncm_mset_fparam_len (mc->fit->mset) + 1);
   guint i;
 
   for (i = 0; i < mc->n; i++)
   {
     ncm_mset_param_set_vector (mc->fit->mset, mc->bf);
-    _ncm_fit_mc_resample (mc, mc->fit);
+    _ncm_fit_mc_resample (mc, mc->fit, mc->fiduc, rng, mc->cur_sample_id + 1);
     ncm_fit_run (mc->fit, NCM_FIT_RUN_MSGS_NONE);
 
-    _ncm_fit_mc_update (mc, mc->fit);
-    mc->write_index++;
+    _ncm_fit_mc_fill_row (mc->fit, row);
+    _ncm_fit_mc_update (mc, row);
   }
+
+  ncm_vector_free (row);
+  ncm_rng_free (rng);
 }
 
+typedef struct _NcmFitMCWorker
+{
+  NcmFit *fit;
+  NcmMSet *fiduc;
+  NcmRNG *rng;
+} NcmFitMCWorker;
+
 static gpointer
-_ncm_fit_mc_dup_fit (gpointer userdata)
+_ncm_fit_mc_worker_new (gpointer userdata)
 {
   NcmFitMC *mc = NCM_FIT_MC (userdata);
   g_mutex_lock (&mc->dup_fit);
   {
-    NcmFit *fit = ncm_fit_dup (mc->fit, mc->ser);
-    ncm_serialize_clear_instances (mc->ser);
-    g_mutex_unlock (&mc->dup_fit);
-    return fit;
-  }
-}
-
-static void 
-_ncm_fit_mc_mt_eval_keep_order (glong i, glong f, gpointer data)
-{
-  NcmFitMC *mc = NCM_FIT_MC (data);
-  NcmFit **fit_ptr = ncm_memory_pool_get (mc->mp);
-  NcmFit *fit = *fit_ptr;
-  guint j;
+    NcmFitMCWorker *w = g_new (NcmFitMCWorker, 1);
 
-  for (j = i; j < f; j++)
-  {
-    gint sample_index;
+    /* The resample only touches the mutable part of the data, the rest is shared. */
+    ncm_dataset_share_payload (mc->fit->lh->dset, mc->ser);
 
-    ncm_mset_param_set_vector (fit->mset, mc->bf);
+    w->fit = ncm_fit_dup (mc->fit, mc->ser);
+    ncm_serialize_clear_instances (mc->ser);
 
-    g_mutex_lock (&mc->resample_lock);
-    sample_index = _ncm_fit_mc_resample (mc, fit);
-    g_mutex_unlock (&mc->resample_lock);
+    /* Resampling computes the fiducial models, so they cannot be shared by the threads. */
+    w->fiduc = ncm_mset_dup (mc->fiduc, mc->ser);
+    ncm_serialize_clear_instances (mc->ser);
 
-    ncm_fit_run (fit, NCM_FIT_RUN_MSGS_NONE);
+    w->rng = ncm_rng_new (NCM_RNG_STREAM_ALGO);
 
-    g_mutex_lock (&mc->update_lock);    
-    while (mc->write_index != sample_index)
-      g_cond_wait (&mc->write_cond, &mc->update_lock);
+    g_mutex_unlock (&mc->dup_fit);
+    return w;
+  }
+}
 
-    _ncm_fit_mc_update (mc, fit);
-    mc->write_index++;
-    g_cond_broadcast (&mc->write_cond);
+static void
+_ncm_fit_mc_worker_free (gpointer data)
+{
+  NcmFitMCWorker *w = data;
 
-    g_mutex_unlock (&mc->update_lock);    
-  }
+  ncm_fit_free (w->fit);
+  ncm_mset_free (w->fiduc);
+  ncm_rng_free (w->rng);
 
-  ncm_memory_pool_return (fit_ptr);
+  g_free (w);
 }
 
+typedef struct _NcmFitMCRun
+{
+  NcmFitMC *mc;
+  gint first_id;
+} NcmFitMCRun;
 
 static void 
 _ncm_fit_mc_mt_eval (glong i, glong f, gpointer data)
 {
-  G_LOCK_DEFINE_STATIC (update_lock);
-  NcmFitMC *mc = NCM_FIT_MC (data);
-  NcmFit **fit_ptr = ncm_memory_pool_get (mc->mp);
-  NcmFit *fit = *fit_ptr;
-  guint j;
+  NcmFitMCRun *run      = (NcmFitMCRun *) data;
+  NcmFitMC *mc          = run->mc;
+  NcmFitMCWorker **w_ptr = ncm_memory_pool_get (mc->mp);
+  NcmFitMCWorker *w     = *w_ptr;
+  const guint row_len   = ncm_mset_fparam_len (w->fit->mset) + 1;
+  glong j;
 
   for (j = i; j < f; j++)
   {
-    ncm_mset_param_set_vector (fit->mset, mc->bf);
-
-    g_mutex_lock (&mc->resample_lock);
-    _ncm_fit_mc_resample (mc, fit);
-    g_mutex_unlock (&mc->resample_lock);
+    NcmVector *row = ncm_vector_new (row_len);
+
+    ncm_mset_param_set_vector (w->fit->mset, mc->bf);
+    _ncm_fit_mc_resample (mc, w->fit, w->fiduc, w->rng, run->first_id + j);
+    ncm_fit_run (w->fit, NCM_FIT_RUN_MSGS_NONE);
+    _ncm_fit_mc_fill_row (w->fit, row);
+
+    /* 
+     * The finished realization is stored in the reorder buffer and the 
+     * thread writes all the consecutive realizations available, instead
+     * of waiting for its turn.
+     */
+    g_mutex_lock (&mc->update_lock);
+    g_ptr_array_index (mc->reorder, j) = row;
+    while (mc->write_index - run->first_id < (gint) mc->reorder->len)
+    {
+      const guint k     = mc->write_index - run->first_id;
+      NcmVector *row_k = g_ptr_array_index (mc->reorder, k);
 
-    ncm_fit_run (fit, NCM_FIT_RUN_MSGS_NONE);
+      if (row_k == NULL)
+        break;
 
-    G_LOCK (update_lock);    
-    _ncm_fit_mc_update (mc, fit);
-    mc->write_index++;
-    G_UNLOCK (update_lock);
+      _ncm_fit_mc_update (mc, row_k);
+      ncm_vector_free (row_k);
+      g_ptr_array_index (mc->reorder, k) = NULL;
+    }
+    g_mutex_unlock (&mc->update_lock);
   }
 
-  ncm_memory_pool_return (fit_ptr);
+  ncm_memory_pool_return (w_ptr);
 }
 
-
 static void
 _ncm_fit_mc_run_mt (NcmFitMC *mc)
 {
   const guint nthreads = mc->n > mc->nthreads ? mc->nthreads : (mc->n - 1);
+  NcmFitMCRun run      = {mc, mc->cur_sample_id + 1};
 
   if (nthreads == 0)
   {
@@ -851,22 +916,24 @@ _ncm_fit_mc_run_mt (NcmFitMC *mc)
   
   if (mc->mp != NULL)
     ncm_memory_pool_free (mc->mp, TRUE);
-  mc->mp = ncm_memory_pool_new (&_ncm_fit_mc_dup_fit, mc, 
-                                (GDestroyNotify) &ncm_fit_free);
+  mc->mp = ncm_memory_pool_new (&_ncm_fit_mc_worker_new, mc, 
+                                &_ncm_fit_mc_worker_free);
 
   /*
-   * The line below added de main fit object to the pool, but can cause
-   * several race conditions as it is used to make the copies for the other
-   * threads. So, no.
+   * The main fit object is not added to the pool, as it is used to make the
+   * copies for the other threads. 
    */
-  //ncm_memory_pool_add (mc->mp, mc->fit);
 
   g_assert_cmpuint (mc->nthreads, >, 1);
+  g_assert_cmpint (mc->write_index, ==, run.first_id);
 
-  if (mc->keep_order)
-    ncm_func_eval_threaded_loop_full (&_ncm_fit_mc_mt_eval_keep_order, 0, mc->n, mc);
-  else
-    ncm_func_eval_threaded_loop_full (&_ncm_fit_mc_mt_eval, 0, mc->n, mc);  
+  g_ptr_array_set_size (mc->reorder, 0);
+  g_ptr_array_set_size (mc->reorder, mc->n);
+
+  ncm_func_eval_threaded_loop_full (&_ncm_fit_mc_mt_eval, 0, mc->n, &run);
+
+  g_assert_cmpint (mc->write_index - run.first_id, ==, mc->n);
+  g_ptr_array_set_size (mc->reorder, 0);
 }
 
 /**
@@ -92,14 +92,14 @@ struct _NcmFitMC
   guint n;
   gboolean keep_order;
   NcmMemoryPool *mp;
+  GPtrArray *reorder;
+  NcmRNG *root_rng;
   gint write_index;
   gint cur_sample_id;
   gint first_sample_id;
   gboolean started;
   GMutex dup_fit;
-  GMutex resample_lock;
   GMutex update_lock;
-  GCond write_cond;
 };
 
 GType ncm_fit_mc_get_type (void) G_GNUC_CONST;
@@ -28,8 +28,23 @@
  * @title: NcmFitMCBS
  * @short_description: Monte Carlo and bootstrap analysis.
  *
- * FIXME
- * 
+ * This object performs a nested Monte Carlo and bootstrap analysis. For
+ * each Monte Carlo realization the data are resampled from the fiducial
+ * model and fitted, the best fit $\hat{\theta}$ is then used as the
+ * starting point of @nbstraps bootstrap fits of the same realization. The
+ * bootstrap fits run concurrently through the internal #NcmFitMC object
+ * (see ncm_fit_mc_set_nthreads()), each bootstrap sample being drawn from
+ * its own counter-based stream, so the results do not depend on the
+ * number of threads.
+ *
+ * The bootstrap mean of each realization is streamed to the catalog
+ * as soon as the realization finishes. At the same time the percentile
+ * and bias-corrected and accelerated (BCa) intervals of the realization
+ * are computed and the running statistics of the estimator bias and
+ * variance, the bootstrap bias and standard deviation and the coverage of
+ * the fiducial values are updated, see ncm_fit_mcbs_get_estimator_bias(),
+ * ncm_fit_mcbs_get_bstrap_sd() and ncm_fit_mcbs_get_coverage().
+ *
  */
 
 #ifdef HAVE_CONFIG_H
@@ -38,15 +53,22 @@
 #include "build_cfg.h"
 
 #include "math/ncm_fit_mcbs.h"
+#include "math/ncm_c.h"
 #include "math/ncm_cfg.h"
+#include "ncm_enum_types.h"
 
 #include <gio/gio.h>
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_cdf.h>
+#include <gsl/gsl_sort.h>
+#include <gsl/gsl_statistics_double.h>
 
 enum
 {
   PROP_0,
   PROP_FIT,
   PROP_FILE,
+  PROP_CLEVEL,
 };
 
 G_DEFINE_TYPE (NcmFitMCBS, ncm_fit_mcbs, G_TYPE_OBJECT);
@@ -59,6 +81,14 @@ ncm_fit_mcbs_init (NcmFitMCBS *mcbs)
   mcbs->mc_bstrap = NULL;
   mcbs->mcat = NULL;
   mcbs->base_name = NULL;
+  mcbs->theta_fiduc = NULL;
+  mcbs->theta_hat = NULL;
+  mcbs->bs_sorted = NULL;
+  mcbs->est_stats = NULL;
+  mcbs->bias_stats = NULL;
+  mcbs->sd_stats = NULL;
+  mcbs->cover_stats = NULL;
+  mcbs->clevel = 0.0;
 }
 
 static void
@@ -77,10 +107,14 @@ ncm_fit_mcbs_set_property (GObject *object, guint prop_id, const GValue *value,
                                          NCM_MSET_CATALOG_M2LNL_COLNAME, NCM_MSET_CATALOG_M2LNL_SYMBOL, 
                                          NULL);
       ncm_mset_catalog_set_run_type (mcbs->mcat, NCM_MSET_CATALOG_RTYPE_BSTRAP_MEAN);
+      ncm_mset_catalog_set_sync_mode (mcbs->mcat, NCM_MSET_CATALOG_SYNC_AUTO);
       break;
     case PROP_FILE:
       ncm_fit_mcbs_set_filename (mcbs, g_value_get_string (value));
       break;
+    case PROP_CLEVEL:
+      ncm_fit_mcbs_set_clevel (mcbs, g_value_get_double (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -101,6 +135,9 @@ ncm_fit_mcbs_get_property (GObject *object, guint prop_id, GValue *value, GParam
     case PROP_FILE:
       g_value_set_string (value, mcbs->mcat->file);
       break;
+    case PROP_CLEVEL:
+      g_value_set_double (value, mcbs->clevel);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -119,6 +156,15 @@ _ncm_fit_mcbs_dispose (GObject *object)
 
   ncm_mset_catalog_clear (&mcbs->mcat);
 
+  ncm_vector_clear (&mcbs->theta_fiduc);
+  ncm_vector_clear (&mcbs->theta_hat);
+  ncm_vector_clear (&mcbs->bs_sorted);
+
+  ncm_stats_vec_clear (&mcbs->est_stats);
+  ncm_stats_vec_clear (&mcbs->bias_stats);
+  ncm_stats_vec_clear (&mcbs->sd_stats);
+  ncm_stats_vec_clear (&mcbs->cover_stats);
+
   /* Chain up : end */
   G_OBJECT_CLASS (ncm_fit_mcbs_parent_class)->dispose (object);
 }
@@ -159,6 +205,14 @@ ncm_fit_mcbs_class_init (NcmFitMCBSClass *klass)
                                                         "Data filename",
                                                         NULL,
                                                         G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+
+  g_object_class_install_property (object_class,
+                                   PROP_CLEVEL,
+                                   g_param_spec_double ("clevel",
+                                                        NULL,
+                                                        "Confidence level of the bootstrap intervals",
+                                                        G_MINDOUBLE, 1.0 - GSL_DBL_EPSILON, ncm_c_stats_1sigma (),
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
 }
 
 /**
@@ -264,20 +318,145 @@ ncm_fit_mcbs_set_rng (NcmFitMCBS *mcbs, NcmRNG *rng)
   ncm_mset_catalog_set_rng (mcbs->mcat, rng);
 }
 
+/**
+ * ncm_fit_mcbs_set_clevel:
+ * @mcbs: a #NcmFitMCBS
+ * @clevel: confidence level
+ *
+ * Sets the confidence level of the bootstrap intervals used to
+ * compute the coverage of the fiducial values, see
+ * ncm_fit_mcbs_get_coverage().
+ *
+ */
+void
+ncm_fit_mcbs_set_clevel (NcmFitMCBS *mcbs, gdouble clevel)
+{
+  g_assert_cmpfloat (clevel, >, 0.0);
+  g_assert_cmpfloat (clevel, <, 1.0);
+
+  /* The confidence level can be set during construction before the fit. */
+  if ((mcbs->mc_bstrap != NULL) && mcbs->mc_bstrap->started)
+    g_error ("ncm_fit_mcbs_set_clevel: Cannot change the confidence level during a run.");
+
+  mcbs->clevel = clevel;
+}
+
+/**
+ * ncm_fit_mcbs_get_clevel:
+ * @mcbs: a #NcmFitMCBS
+ *
+ * Returns: the confidence level of the bootstrap intervals.
+ */
+gdouble
+ncm_fit_mcbs_get_clevel (NcmFitMCBS *mcbs)
+{
+  return mcbs->clevel;
+}
+
+static void
+_ncm_fit_mcbs_alloc_stats (NcmFitMCBS *mcbs, guint fparam_len)
+{
+  if ((mcbs->theta_hat == NULL) || (ncm_vector_len (mcbs->theta_hat) != fparam_len))
+  {
+    ncm_vector_clear (&mcbs->theta_fiduc);
+    ncm_vector_clear (&mcbs->theta_hat);
+
+    ncm_stats_vec_clear (&mcbs->est_stats);
+    ncm_stats_vec_clear (&mcbs->bias_stats);
+    ncm_stats_vec_clear (&mcbs->sd_stats);
+    ncm_stats_vec_clear (&mcbs->cover_stats);
+
+    mcbs->theta_fiduc = ncm_vector_new (fparam_len);
+    mcbs->theta_hat   = ncm_vector_new (fparam_len);
+
+    mcbs->est_stats   = ncm_stats_vec_new (fparam_len, NCM_STATS_VEC_VAR, FALSE);
+    mcbs->bias_stats  = ncm_stats_vec_new (fparam_len, NCM_STATS_VEC_VAR, FALSE);
+    mcbs->sd_stats    = ncm_stats_vec_new (fparam_len, NCM_STATS_VEC_VAR, FALSE);
+    mcbs->cover_stats = ncm_stats_vec_new (fparam_len * NCM_FIT_MCBS_INTERVAL_LEN, NCM_STATS_VEC_MEAN, FALSE);
+  }
+  else
+  {
+    ncm_stats_vec_reset (mcbs->est_stats, TRUE);
+    ncm_stats_vec_reset (mcbs->bias_stats, TRUE);
+    ncm_stats_vec_reset (mcbs->sd_stats, TRUE);
+    ncm_stats_vec_reset (mcbs->cover_stats, TRUE);
+  }
+}
+
+static void
+_ncm_fit_mcbs_update_stats (NcmFitMCBS *mcbs, NcmFitRunMsgs mtype)
+{
+  NcmMSetCatalog *bcat   = mcbs->mc_bstrap->mcat;
+  const guint fparam_len = ncm_vector_len (mcbs->theta_hat);
+  guint fpi;
+
+  for (fpi = 0; fpi < fparam_len; fpi++)
+  {
+    const guint col          = bcat->nadd_vals + fpi;
+    const gdouble theta_hat  = ncm_vector_get (mcbs->theta_hat, fpi);
+    const gdouble theta_fid  = ncm_vector_get (mcbs->theta_fiduc, fpi);
+    const gdouble bs_mean    = ncm_stats_vec_get_mean (bcat->pstats, col);
+    const gdouble bs_sd      = ncm_stats_vec_get_sd (bcat->pstats, col);
+    gint itype;
+
+    ncm_stats_vec_set (mcbs->est_stats, fpi, theta_hat - theta_fid);
+    ncm_stats_vec_set (mcbs->bias_stats, fpi, bs_mean - theta_hat);
+    ncm_stats_vec_set (mcbs->sd_stats, fpi, bs_sd);
+
+    for (itype = 0; itype < NCM_FIT_MCBS_INTERVAL_LEN; itype++)
+    {
+      gdouble lb, ub;
+      ncm_fit_mcbs_get_interval (mcbs, fpi, itype, mcbs->clevel, &lb, &ub);
+      ncm_stats_vec_set (mcbs->cover_stats, itype * fparam_len + fpi, ((lb <= theta_fid) && (theta_fid <= ub)) ? 1.0 : 0.0);
+    }
+  }
+
+  ncm_stats_vec_update (mcbs->est_stats);
+  ncm_stats_vec_update (mcbs->bias_stats);
+  ncm_stats_vec_update (mcbs->sd_stats);
+  ncm_stats_vec_update (mcbs->cover_stats);
+
+  if (mtype > NCM_FIT_RUN_MSGS_NONE)
+  {
+    NcmMSet *mset = mcbs->fit->mset;
+
+    ncm_message ("# NcmFitMCBS: %u realization(s), intervals at %.2f%% CL.\n", 
+                 ncm_fit_mcbs_get_nrealizations (mcbs), mcbs->clevel * 100.0);
+    ncm_message ("#   %-20s % 12s % 12s % 12s % 12s % 8s % 8s\n", 
+                 "parameter", "est-bias", "est-sd", "bstrap-bias", "bstrap-sd", "cov-pct", "cov-bca");
+    for (fpi = 0; fpi < fparam_len; fpi++)
+    {
+      ncm_message ("#   %-20s % 12.5g % 12.5g % 12.5g % 12.5g % 8.4f % 8.4f\n",
+                   ncm_mset_fparam_name (mset, fpi),
+                   ncm_fit_mcbs_get_estimator_bias (mcbs, fpi),
+                   ncm_fit_mcbs_get_estimator_sd (mcbs, fpi),
+                   ncm_fit_mcbs_get_bstrap_bias (mcbs, fpi),
+                   ncm_fit_mcbs_get_bstrap_sd (mcbs, fpi),
+                   ncm_fit_mcbs_get_coverage (mcbs, fpi, NCM_FIT_MCBS_INTERVAL_PERCENTILE),
+                   ncm_fit_mcbs_get_coverage (mcbs, fpi, NCM_FIT_MCBS_INTERVAL_BCA));
+    }
+  }
+}
+
 /**
  * ncm_fit_mcbs_run:
  * @mcbs: a #NcmFitMCBS
- * @fiduc: FIXME
- * @ni: FIXME
- * @nf: FIXME
- * @nbstraps: FIXME
- * @rtype: FIXME
- * @mtype: FIXME
- * @bsmt: FIXME
+ * @fiduc: fiducial #NcmMSet
+ * @ni: index of the first realization
+ * @nf: index of the last realization plus one
+ * @nbstraps: number of bootstrap fits per realization
+ * @rtype: a bootstrap #NcmFitMCResampleType
+ * @mtype: a #NcmFitRunMsgs
+ * @bsmt: number of threads used in the bootstrap fits
  * 
- * FIXME
- * 
- * WARNING not working correctly with bsmt > 0 FIXME
+ * Runs the realizations from @ni to @nf - 1. Each realization is resampled
+ * from @fiduc and fitted, then @nbstraps bootstrap samples of it are
+ * fitted using @bsmt threads, all of them starting from the best fit of
+ * the realization. The bootstrap mean is added to the catalog and the
+ * running statistics are updated at the end of each realization.
+ *
+ * The bootstrap catalog of the last realization is kept after the run,
+ * so ncm_fit_mcbs_get_interval() can be called on it.
  *
  */
 void 
@@ -312,13 +491,24 @@ ncm_fit_mcbs_run (NcmFitMCBS *mcbs, NcmMSet *fiduc, guint ni, guint nf, guint nb
   
   if (rtype == NCM_FIT_MC_RESAMPLE_FROM_MODEL)
     g_error ("ncm_fit_mcbs_run: the internal run must be a bootstrap: NCM_FIT_MC_RESAMPLE_BOOTSTRAP_*.");
+
+  if (nbstraps < 2)
+    g_error ("ncm_fit_mcbs_run: at least two bootstrap fits are required per realization.");
+
+  _ncm_fit_mcbs_alloc_stats (mcbs, ncm_mset_fparams_len (mcbs->fit->mset));
+  ncm_mset_fparams_get_vector (fiduc, mcbs->theta_fiduc);
   
   for (i = ni; i < nf; i++)
   {
     ncm_dataset_bootstrap_set (mcbs->fit->lh->dset, NCM_DATASET_BSTRAP_DISABLE);
-    //ncm_fit_mc_set_first_sample_id (mcbs->mc_resample, i + 1);
     ncm_fit_mc_run (mcbs->mc_resample, i + 1);
+
+    /* The fit object is left at the best fit of the realization, it is */
+    /* also the starting point of all bootstrap fits (see ncm_fit_mc_start_run()). */
+    ncm_mset_fparams_get_vector (mcbs->fit->mset, mcbs->theta_hat);
     ncm_dataset_bootstrap_set (mcbs->fit->lh->dset, rtype);
+
+    ncm_fit_mc_reset (mcbs->mc_bstrap);
     
     if (mcbs->base_name != NULL)
     {
@@ -333,8 +523,9 @@ ncm_fit_mcbs_run (NcmFitMCBS *mcbs, NcmMSet *fiduc, guint ni, guint nf, guint nb
     ncm_mset_catalog_add_from_vector (mcbs->mcat, mcbs->mc_bstrap->mcat->pstats->mean);
     ncm_mset_catalog_log_current_stats (mcbs->mcat);
 
+    _ncm_fit_mcbs_update_stats (mcbs, mtype);
+
     ncm_fit_mc_end_run (mcbs->mc_bstrap);
-    ncm_fit_mc_reset (mcbs->mc_bstrap);
   }
 
   ncm_mset_catalog_get_mean (mcbs->mcat, &mcbs->fit->fstate->fparams);
@@ -358,3 +549,185 @@ ncm_fit_mcbs_get_catalog (NcmFitMCBS *mcbs)
   return ncm_mset_catalog_ref (mcbs->mcat);
 }
 
+/**
+ * ncm_fit_mcbs_get_interval:
+ * @mcbs: a #NcmFitMCBS
+ * @fpi: free parameter index
+ * @itype: a #NcmFitMCBSInterval
+ * @clevel: confidence level
+ * @lb: (out): lower bound
+ * @ub: (out): upper bound
+ *
+ * Computes the bootstrap interval of type @itype for the free parameter
+ * @fpi, using the bootstrap fits of the current (or last) realization.
+ *
+ * The BCa interval uses the bias correction $z_0 = \Phi^{-1}(f)$, where $f$ is
+ * the fraction of bootstrap fits with $\theta^\star < \hat{\theta}$, and the
+ * acceleration $a \approx \gamma_1/6$, where $\gamma_1$ is the skewness of
+ * the bootstrap distribution. The interval is given by the quantiles
+ * $\Phi\left(z_0 + (z_0 + z_\alpha)/[1 - a(z_0 + z_\alpha)]\right)$ of the
+ * bootstrap distribution.
+ *
+ */
+void
+ncm_fit_mcbs_get_interval (NcmFitMCBS *mcbs, guint fpi, NcmFitMCBSInterval itype, gdouble clevel, gdouble *lb, gdouble *ub)
+{
+  NcmMSetCatalog *bcat = mcbs->mc_bstrap->mcat;
+  const guint nb       = ncm_mset_catalog_len (bcat);
+  const guint col      = bcat->nadd_vals + fpi;
+  gdouble p_lb         = 0.5 * (1.0 - clevel);
+  gdouble p_ub         = 0.5 * (1.0 + clevel);
+  gdouble *x;
+  guint i;
+
+  g_assert_cmpfloat (clevel, >, 0.0);
+  g_assert_cmpfloat (clevel, <, 1.0);
+
+  if (nb < 2)
+    g_error ("ncm_fit_mcbs_get_interval: not enough bootstrap fits to compute the interval [%u].", nb);
+
+  if (mcbs->theta_hat == NULL || fpi >= ncm_vector_len (mcbs->theta_hat))
+    g_error ("ncm_fit_mcbs_get_interval: invalid free parameter index %u.", fpi);
+
+  if ((mcbs->bs_sorted == NULL) || (ncm_vector_len (mcbs->bs_sorted) != nb))
+  {
+    ncm_vector_clear (&mcbs->bs_sorted);
+    mcbs->bs_sorted = ncm_vector_new (nb);
+  }
+
+  x = ncm_vector_ptr (mcbs->bs_sorted, 0);
+  for (i = 0; i < nb; i++)
+    x[i] = ncm_vector_get (ncm_mset_catalog_peek_row (bcat, i), col);
+  gsl_sort (x, 1, nb);
+
+  switch (itype)
+  {
+    case NCM_FIT_MCBS_INTERVAL_PERCENTILE:
+      break;
+    case NCM_FIT_MCBS_INTERVAL_BCA:
+    {
+      const gdouble theta_hat = ncm_vector_get (mcbs->theta_hat, fpi);
+      const gdouble z_lb      = gsl_cdf_ugaussian_Pinv (p_lb);
+      const gdouble z_ub      = gsl_cdf_ugaussian_Pinv (p_ub);
+      gdouble nless           = 0.0;
+      gdouble frac, z0, a;
+
+      for (i = 0; i < nb; i++)
+      {
+        if (x[i] < theta_hat)
+          nless += 1.0;
+        else if (x[i] == theta_hat)
+          nless += 0.5;
+        else
+          break;
+      }
+
+      frac = nless / nb;
+      frac = MIN (MAX (frac, 1.0 / (nb + 1.0)), nb / (nb + 1.0));
+      z0   = gsl_cdf_ugaussian_Pinv (frac);
+
+      a = gsl_stats_skew (x, 1, nb) / 6.0;
+      if (!gsl_finite (a))
+        a = 0.0;
+
+      p_lb = gsl_cdf_ugaussian_P (z0 + (z0 + z_lb) / (1.0 - a * (z0 + z_lb)));
+      p_ub = gsl_cdf_ugaussian_P (z0 + (z0 + z_ub) / (1.0 - a * (z0 + z_ub)));
+      break;
+    }
+    default:
+      g_assert_not_reached ();
+      break;
+  }
+
+  lb[0] = gsl_stats_quantile_from_sorted_data (x, 1, nb, p_lb);
+  ub[0] = gsl_stats_quantile_from_sorted_data (x, 1, nb, p_ub);
+}
+
+/**
+ * ncm_fit_mcbs_get_nrealizations:
+ * @mcbs: a #NcmFitMCBS
+ *
+ * Returns: the number of realizations accumulated in the running statistics.
+ */
+guint
+ncm_fit_mcbs_get_nrealizations (NcmFitMCBS *mcbs)
+{
+  if (mcbs->est_stats == NULL)
+    return 0;
+  else
+    return mcbs->est_stats->nitens;
+}
+
+/**
+ * ncm_fit_mcbs_get_estimator_bias:
+ * @mcbs: a #NcmFitMCBS
+ * @fpi: free parameter index
+ *
+ * Returns: the mean of $\hat{\theta} - \theta_\mathrm{fiduc}$ over the realizations.
+ */
+gdouble
+ncm_fit_mcbs_get_estimator_bias (NcmFitMCBS *mcbs, guint fpi)
+{
+  g_assert (mcbs->est_stats != NULL);
+  return ncm_stats_vec_get_mean (mcbs->est_stats, fpi);
+}
+
+/**
+ * ncm_fit_mcbs_get_estimator_sd:
+ * @mcbs: a #NcmFitMCBS
+ * @fpi: free parameter index
+ *
+ * Returns: the standard deviation of $\hat{\theta}$ over the realizations.
+ */
+gdouble
+ncm_fit_mcbs_get_estimator_sd (NcmFitMCBS *mcbs, guint fpi)
+{
+  g_assert (mcbs->est_stats != NULL);
+  return ncm_stats_vec_get_sd (mcbs->est_stats, fpi);
+}
+
+/**
+ * ncm_fit_mcbs_get_bstrap_bias:
+ * @mcbs: a #NcmFitMCBS
+ * @fpi: free parameter index
+ *
+ * Returns: the mean over the realizations of the bootstrap bias estimate
+ * $\bar{\theta}^\star - \hat{\theta}$.
+ */
+gdouble
+ncm_fit_mcbs_get_bstrap_bias (NcmFitMCBS *mcbs, guint fpi)
+{
+  g_assert (mcbs->bias_stats != NULL);
+  return ncm_stats_vec_get_mean (mcbs->bias_stats, fpi);
+}
+
+/**
+ * ncm_fit_mcbs_get_bstrap_sd:
+ * @mcbs: a #NcmFitMCBS
+ * @fpi: free parameter index
+ *
+ * Returns: the mean over the realizations of the bootstrap standard deviation.
+ */
+gdouble
+ncm_fit_mcbs_get_bstrap_sd (NcmFitMCBS *mcbs, guint fpi)
+{
+  g_assert (mcbs->sd_stats != NULL);
+  return ncm_stats_vec_get_mean (mcbs->sd_stats, fpi);
+}
+
+/**
+ * ncm_fit_mcbs_get_coverage:
+ * @mcbs: a #NcmFitMCBS
+ * @fpi: free parameter index
+ * @itype: a #NcmFitMCBSInterval
+ *
+ * Returns: the fraction of realizations where the interval of type @itype,
+ * at the confidence level ncm_fit_mcbs_get_clevel(), contains the fiducial value.
+ */
+gdouble
+ncm_fit_mcbs_get_coverage (NcmFitMCBS *mcbs, guint fpi, NcmFitMCBSInterval itype)
+{
+  g_assert (mcbs->cover_stats != NULL);
+  g_assert_cmpuint (itype, <, NCM_FIT_MCBS_INTERVAL_LEN);
+  return ncm_stats_vec_get_mean (mcbs->cover_stats, itype * ncm_vector_len (mcbs->theta_hat) + fpi);
+}
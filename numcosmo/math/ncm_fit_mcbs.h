@@ -31,6 +31,7 @@
 #include <numcosmo/build_cfg.h>
 #include <numcosmo/math/ncm_fit.h>
 #include <numcosmo/math/ncm_fit_mc.h>
+#include <numcosmo/math/ncm_stats_vec.h>
 
 G_BEGIN_DECLS
 
@@ -44,6 +45,21 @@ G_BEGIN_DECLS
 typedef struct _NcmFitMCBSClass NcmFitMCBSClass;
 typedef struct _NcmFitMCBS NcmFitMCBS;
 
+/**
+ * NcmFitMCBSInterval:
+ * @NCM_FIT_MCBS_INTERVAL_PERCENTILE: percentile bootstrap interval.
+ * @NCM_FIT_MCBS_INTERVAL_BCA: bias-corrected and accelerated (BCa) bootstrap interval.
+ *
+ * Bootstrap confidence interval types.
+ *
+ */
+typedef enum _NcmFitMCBSInterval
+{
+  NCM_FIT_MCBS_INTERVAL_PERCENTILE = 0,
+  NCM_FIT_MCBS_INTERVAL_BCA, /*< private >*/
+  NCM_FIT_MCBS_INTERVAL_LEN, /*< skip >*/
+} NcmFitMCBSInterval;
+
 struct _NcmFitMCBSClass
 {
   /*< private >*/
@@ -59,6 +75,14 @@ struct _NcmFitMCBS
   NcmFitMC *mc_bstrap;
   NcmMSetCatalog *mcat;
   gchar *base_name;
+  NcmVector *theta_fiduc;
+  NcmVector *theta_hat;
+  NcmVector *bs_sorted;
+  NcmStatsVec *est_stats;
+  NcmStatsVec *bias_stats;
+  NcmStatsVec *sd_stats;
+  NcmStatsVec *cover_stats;
+  gdouble clevel;
 };
 
 GType ncm_fit_mcbs_get_type (void) G_GNUC_CONST;
@@ -69,10 +93,21 @@ void ncm_fit_mcbs_clear (NcmFitMCBS **mcbs);
 
 void ncm_fit_mcbs_set_filename (NcmFitMCBS *mcbs, const gchar *filename);
 void ncm_fit_mcbs_set_rng (NcmFitMCBS *mcbs, NcmRNG *rng);
+void ncm_fit_mcbs_set_clevel (NcmFitMCBS *mcbs, gdouble clevel);
+gdouble ncm_fit_mcbs_get_clevel (NcmFitMCBS *mcbs);
+
 void ncm_fit_mcbs_run (NcmFitMCBS *mcbs, NcmMSet *fiduc, guint ni, guint nf, guint nbstraps, NcmFitMCResampleType rtype, NcmFitRunMsgs mtype, guint bsmt);
 
 NcmMSetCatalog *ncm_fit_mcbs_get_catalog (NcmFitMCBS *mcbs);
 
+void ncm_fit_mcbs_get_interval (NcmFitMCBS *mcbs, guint fpi, NcmFitMCBSInterval itype, gdouble clevel, gdouble *lb, gdouble *ub);
+gdouble ncm_fit_mcbs_get_estimator_bias (NcmFitMCBS *mcbs, guint fpi);
+gdouble ncm_fit_mcbs_get_estimator_sd (NcmFitMCBS *mcbs, guint fpi);
+gdouble ncm_fit_mcbs_get_bstrap_bias (NcmFitMCBS *mcbs, guint fpi);
+gdouble ncm_fit_mcbs_get_bstrap_sd (NcmFitMCBS *mcbs, guint fpi);
+gdouble ncm_fit_mcbs_get_coverage (NcmFitMCBS *mcbs, guint fpi, NcmFitMCBSInterval itype);
+guint ncm_fit_mcbs_get_nrealizations (NcmFitMCBS *mcbs);
+
 G_END_DECLS
 
 #endif /* _NCM_FIT_MCBS_H_ */
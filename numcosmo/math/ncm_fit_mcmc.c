@@ -32,6 +32,13 @@
  * 
  * Metropolis–Hastings sampler.
  * 
+ * When more than one chain is requested (see ncm_fit_mcmc_set_nchains()),
+ * the chains are evolved independently, each one using its own copy of the
+ * #NcmFit object and its own #NcmRNG, and they are evolved concurrently if
+ * #NcmFitMCMC:nthreads is larger than one. The catalog then keeps track of
+ * each chain and the Gelman-Rubin shrink factor can be used to stop the run
+ * automatically, see ncm_fit_mcmc_set_max_shrink().
+ * 
  */
 
 #ifdef HAVE_CONFIG_H
@@ -42,9 +49,12 @@
 #include "math/ncm_fit_mcmc.h"
 #include "math/ncm_cfg.h"
 #include "math/ncm_func_eval.h"
+#include "math/ncm_mset_trans_kern_gauss.h"
 #include "ncm_enum_types.h"
 
 #include <gsl/gsl_statistics_double.h>
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_blas.h>
 
 enum
 {
@@ -53,11 +63,59 @@ enum
   PROP_SAMPLER,
   PROP_MTYPE,
   PROP_NTHREADS,
+  PROP_NCHAINS,
+  PROP_MAX_SHRINK,
   PROP_DATA_FILE,
+  PROP_FAST_SLOW,
+  PROP_MAX_OVERSAMPLING,
 };
 
 G_DEFINE_TYPE (NcmFitMCMC, ncm_fit_mcmc, G_TYPE_OBJECT);
 
+typedef struct _NcmFitMCMCChain
+{
+  NcmRNG *rng;
+  NcmVector *theta;
+  NcmVector *thetastar;
+  NcmVector *theta_b;
+  NcmVector *cur;
+  GPtrArray *rows;
+  guint naccepted;
+  guint ntotal;
+  guint nbaccepted;
+  guint nbtotal;
+} NcmFitMCMCChain;
+
+static NcmFitMCMCChain *
+_ncm_fit_mcmc_chain_new (guint fparam_len, NcmRNG *rng)
+{
+  NcmFitMCMCChain *chain = g_new0 (NcmFitMCMCChain, 1);
+
+  chain->rng       = ncm_rng_ref (rng);
+  chain->theta     = ncm_vector_new (fparam_len);
+  chain->thetastar = ncm_vector_new (fparam_len);
+  chain->theta_b   = ncm_vector_new (fparam_len);
+  chain->cur       = ncm_vector_new (fparam_len + 1);
+  chain->rows      = g_ptr_array_new_with_free_func ((GDestroyNotify) &ncm_vector_free);
+
+  return chain;
+}
+
+static void
+_ncm_fit_mcmc_chain_free (gpointer data)
+{
+  NcmFitMCMCChain *chain = data;
+
+  ncm_rng_free (chain->rng);
+  ncm_vector_free (chain->theta);
+  ncm_vector_free (chain->thetastar);
+  ncm_vector_free (chain->theta_b);
+  ncm_vector_free (chain->cur);
+  g_ptr_array_unref (chain->rows);
+  
+  g_free (chain);
+}
+
 static void
 ncm_fit_mcmc_init (NcmFitMCMC *mcmc)
 {
@@ -68,19 +126,27 @@ ncm_fit_mcmc_init (NcmFitMCMC *mcmc)
   mcmc->ser             = ncm_serialize_new (NCM_SERIALIZE_OPT_CLEAN_DUP);
   mcmc->theta           = NULL;
   mcmc->thetastar       = NULL;
+  mcmc->theta_b         = NULL;
+  mcmc->blocks          = NULL;
+  mcmc->block_os        = NULL;
+  mcmc->block_LLT       = NULL;
+  mcmc->fast_slow       = FALSE;
+  mcmc->max_os          = 0;
   mcmc->nthreads        = 0;
+  mcmc->nchains         = 1;
+  mcmc->max_shrink      = 0.0;
+  mcmc->chains          = NULL;
   mcmc->n               = 0;
   mcmc->mp              = NULL;
   mcmc->cur_sample_id   = -1; /* Represents that no samples were calculated yet. */
   mcmc->naccepted       = 0;
   mcmc->ntotal          = 0;
+  mcmc->nbaccepted      = 0;
+  mcmc->nbtotal         = 0;
   mcmc->write_index     = 0;
   mcmc->started         = FALSE;
 
   g_mutex_init (&mcmc->dup_fit);
-  g_mutex_init (&mcmc->resample_lock);
-  g_mutex_init (&mcmc->update_lock);
-  g_cond_init (&mcmc->write_cond);
 }
 
 static void _ncm_fit_mcmc_set_fit_obj (NcmFitMCMC *mcmc, NcmFit *fit);
@@ -105,9 +171,21 @@ ncm_fit_mcmc_set_property (GObject *object, guint prop_id, const GValue *value,
     case PROP_NTHREADS:
       ncm_fit_mcmc_set_nthreads (mcmc, g_value_get_uint (value));
       break;
+    case PROP_NCHAINS:
+      ncm_fit_mcmc_set_nchains (mcmc, g_value_get_uint (value));
+      break;
+    case PROP_MAX_SHRINK:
+      ncm_fit_mcmc_set_max_shrink (mcmc, g_value_get_double (value));
+      break;
     case PROP_DATA_FILE:
       ncm_fit_mcmc_set_data_file (mcmc, g_value_get_string (value));
       break;    
+    case PROP_FAST_SLOW:
+      ncm_fit_mcmc_set_fast_slow (mcmc, g_value_get_boolean (value));
+      break;
+    case PROP_MAX_OVERSAMPLING:
+      ncm_fit_mcmc_set_max_oversampling (mcmc, g_value_get_uint (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -134,9 +212,21 @@ ncm_fit_mcmc_get_property (GObject *object, guint prop_id, GValue *value, GParam
     case PROP_NTHREADS:
       g_value_set_uint (value, mcmc->nthreads);
       break;
+    case PROP_NCHAINS:
+      g_value_set_uint (value, mcmc->nchains);
+      break;
+    case PROP_MAX_SHRINK:
+      g_value_set_double (value, mcmc->max_shrink);
+      break;
     case PROP_DATA_FILE:
       g_value_set_string (value, ncm_mset_catalog_peek_filename (mcmc->mcat));
       break;
+    case PROP_FAST_SLOW:
+      g_value_set_boolean (value, mcmc->fast_slow);
+      break;
+    case PROP_MAX_OVERSAMPLING:
+      g_value_set_uint (value, mcmc->max_os);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -155,6 +245,12 @@ ncm_fit_mcmc_dispose (GObject *object)
   ncm_mset_catalog_clear (&mcmc->mcat);
   ncm_vector_clear (&mcmc->theta);
   ncm_vector_clear (&mcmc->thetastar);
+  ncm_vector_clear (&mcmc->theta_b);
+
+  g_clear_pointer (&mcmc->blocks, g_ptr_array_unref);
+  g_clear_pointer (&mcmc->block_os, g_array_unref);
+  g_clear_pointer (&mcmc->block_LLT, g_ptr_array_unref);
+  g_clear_pointer (&mcmc->chains, g_ptr_array_unref);
 
   if (mcmc->mp != NULL)
   {
@@ -172,9 +268,6 @@ ncm_fit_mcmc_finalize (GObject *object)
   NcmFitMCMC *mcmc = NCM_FIT_MCMC (object);
 
   g_mutex_clear (&mcmc->dup_fit);
-  g_mutex_clear (&mcmc->resample_lock);
-  g_mutex_clear (&mcmc->update_lock);
-  g_cond_clear (&mcmc->write_cond);
   
   /* Chain up : end */
   G_OBJECT_CLASS (ncm_fit_mcmc_parent_class)->finalize (object);
@@ -219,6 +312,34 @@ ncm_fit_mcmc_class_init (NcmFitMCMCClass *klass)
                                                       "Number of threads to run",
                                                       0, 100, 0,
                                                       G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_NCHAINS,
+                                   g_param_spec_uint ("nchains",
+                                                      NULL,
+                                                      "Number of independent chains",
+                                                      1, G_MAXUINT32, 1,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_MAX_SHRINK,
+                                   g_param_spec_double ("max-shrink",
+                                                        NULL,
+                                                        "Shrink factor below which the chains are considered converged",
+                                                        0.0, G_MAXDOUBLE, 0.0,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_FAST_SLOW,
+                                   g_param_spec_boolean ("fast-slow",
+                                                         NULL,
+                                                         "Whether to use fast/slow parameter blocking",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_MAX_OVERSAMPLING,
+                                   g_param_spec_uint ("max-oversampling",
+                                                      NULL,
+                                                      "Maximum oversampling factor of the fast blocks",
+                                                      1, G_MAXUINT32, 20,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
 }
 
 static void 
@@ -226,7 +347,7 @@ _ncm_fit_mcmc_set_fit_obj (NcmFitMCMC *mcmc, NcmFit *fit)
 {
   g_assert (mcmc->fit == NULL);
   mcmc->fit = ncm_fit_ref (fit);
-  mcmc->mcat = ncm_mset_catalog_new (fit->mset, 1, 1, FALSE, 
+  mcmc->mcat = ncm_mset_catalog_new (fit->mset, 1, mcmc->nchains, FALSE, 
                                      NCM_MSET_CATALOG_M2LNL_COLNAME, NCM_MSET_CATALOG_M2LNL_SYMBOL, 
                                      NULL);
 }
@@ -340,9 +461,11 @@ ncm_fit_mcmc_set_trans_kern (NcmFitMCMC *mcmc, NcmMSetTransKern *tkern)
 /**
  * ncm_fit_mcmc_set_nthreads:
  * @mcmc: a #NcmFitMCMC
- * @nthreads: FIXME
+ * @nthreads: number of threads
  *
- * FIXME
+ * Sets the number of threads. When @nthreads is larger than one the chains
+ * are evolved concurrently, see ncm_fit_mcmc_set_nchains(). A single chain
+ * is always evolved serially.
  *
  */
 void 
@@ -351,6 +474,74 @@ ncm_fit_mcmc_set_nthreads (NcmFitMCMC *mcmc, guint nthreads)
   mcmc->nthreads = nthreads;
 }
 
+/**
+ * ncm_fit_mcmc_set_nchains:
+ * @mcmc: a #NcmFitMCMC
+ * @nchains: number of chains
+ *
+ * Sets the number of independent chains. Each chain uses its own copy of 
+ * the #NcmFit object (taken from an internal memory pool) and its own
+ * #NcmRNG seeded from the catalog RNG. Each step adds one row per chain 
+ * to the catalog, chain $k$ being the rows with index $i$ such that
+ * $i \bmod n_\mathrm{chains} = k$. The first chain starts at the current 
+ * point of the model set and the others at points drawn from the transition
+ * kernel around it.
+ *
+ * The number of chains must be set before the data file, see 
+ * ncm_fit_mcmc_set_data_file().
+ * 
+ */
+void 
+ncm_fit_mcmc_set_nchains (NcmFitMCMC *mcmc, guint nchains)
+{
+  g_assert_cmpuint (nchains, >, 0);
+  if (mcmc->started)
+    g_error ("ncm_fit_mcmc_set_nchains: Cannot change the number of chains during a run, call ncm_fit_mcmc_end_run() first.");
+
+  if (nchains == mcmc->nchains)
+    return;
+
+  mcmc->nchains = nchains;
+
+  if (mcmc->mcat != NULL)
+  {
+    NcmMSetCatalog *mcat = mcmc->mcat;
+
+    if ((ncm_mset_catalog_peek_filename (mcat) != NULL) || !ncm_mset_catalog_is_empty (mcat))
+      g_error ("ncm_fit_mcmc_set_nchains: the number of chains must be set before the data file and before any run.");
+
+    mcmc->mcat = ncm_mset_catalog_new (mcmc->fit->mset, 1, mcmc->nchains, FALSE, 
+                                       NCM_MSET_CATALOG_M2LNL_COLNAME, NCM_MSET_CATALOG_M2LNL_SYMBOL, 
+                                       NULL);
+    if (mcat->rng != NULL)
+      ncm_mset_catalog_set_rng (mcmc->mcat, mcat->rng);
+    if (mcmc->tkern != NULL)
+      ncm_mset_catalog_set_run_type (mcmc->mcat, ncm_mset_trans_kern_get_name (mcmc->tkern));
+
+    ncm_mset_catalog_free (mcat);
+  }
+}
+
+/**
+ * ncm_fit_mcmc_set_max_shrink:
+ * @mcmc: a #NcmFitMCMC
+ * @max_shrink: maximum shrink factor
+ *
+ * When using more than one chain and @max_shrink is larger than one, 
+ * ncm_fit_mcmc_run() stops as soon as the multivariate Gelman-Rubin 
+ * shrink factor (see ncm_mset_catalog_get_shrink_factor()) is smaller than
+ * @max_shrink. The test is done at the end of each batch of steps, and 
+ * only after each chain has at least #NCM_FIT_MCMC_MIN_CONV_STEPS points.
+ * Use zero to disable the test.
+ * 
+ */
+void 
+ncm_fit_mcmc_set_max_shrink (NcmFitMCMC *mcmc, gdouble max_shrink)
+{
+  g_assert_cmpfloat (max_shrink, >=, 0.0);
+  mcmc->max_shrink = max_shrink;
+}
+
 /**
  * ncm_fit_mcmc_set_rng:
  * @mcmc: a #NcmFitMCMC
@@ -368,6 +559,108 @@ ncm_fit_mcmc_set_rng (NcmFitMCMC *mcmc, NcmRNG *rng)
   ncm_mset_catalog_set_rng (mcmc->mcat, rng);
 }
 
+/**
+ * ncm_fit_mcmc_set_fast_slow:
+ * @mcmc: a #NcmFitMCMC
+ * @fast_slow: whether to use fast/slow parameter blocking
+ *
+ * Enables or disables the fast/slow parameter blocking. When enabled, the free
+ * parameters are divided in blocks, one for each model in the #NcmMSet, and
+ * the cost of each block is measured when the run starts (see
+ * ncm_fit_fparams_blocks_oversampling()). Each step then consists in one 
+ * Metropolis–Hastings sub-step for the slowest block followed by several 
+ * sub-steps for each faster block, the number of sub-steps being given by 
+ * the time ratio between the slowest block and the block itself (limited by 
+ * #NcmFitMCMC:max-oversampling). Only the parameters of the block are moved
+ * in each sub-step and one catalog row is written per step.
+ *
+ * When the transition kernel is a #NcmMSetTransKernGauss the sub-steps draw
+ * only the block components, using the Cholesky decomposition of the block
+ * of the kernel covariance taken when the run starts. Other kernels draw a
+ * full proposal and only the block components are used.
+ *
+ * The acceptance ratio (ncm_fit_mcmc_get_accept_ratio()) still counts one
+ * try per step, a step being accepted when at least one of its sub-steps 
+ * was. The ratio of the sub-steps is given by 
+ * ncm_fit_mcmc_get_block_accept_ratio().
+ * 
+ */
+void 
+ncm_fit_mcmc_set_fast_slow (NcmFitMCMC *mcmc, gboolean fast_slow)
+{
+  if (mcmc->started)
+    g_error ("ncm_fit_mcmc_set_fast_slow: Cannot change the blocking scheme during a run, call ncm_fit_mcmc_end_run() first.");
+
+  mcmc->fast_slow = fast_slow;
+}
+
+/**
+ * ncm_fit_mcmc_set_max_oversampling:
+ * @mcmc: a #NcmFitMCMC
+ * @max_os: maximum oversampling factor
+ *
+ * Sets the maximum number of sub-steps done in a fast block per step, see
+ * ncm_fit_mcmc_set_fast_slow().
+ * 
+ */
+void 
+ncm_fit_mcmc_set_max_oversampling (NcmFitMCMC *mcmc, guint max_os)
+{
+  g_assert_cmpuint (max_os, >, 0);
+  if (mcmc->started)
+    g_error ("ncm_fit_mcmc_set_max_oversampling: Cannot change the blocking scheme during a run, call ncm_fit_mcmc_end_run() first.");
+
+  mcmc->max_os = max_os;
+}
+
+/**
+ * ncm_fit_mcmc_get_fast_slow:
+ * @mcmc: a #NcmFitMCMC
+ *
+ * Returns: whether the fast/slow parameter blocking is enabled.
+ */
+gboolean 
+ncm_fit_mcmc_get_fast_slow (NcmFitMCMC *mcmc)
+{
+  return mcmc->fast_slow;
+}
+
+/**
+ * ncm_fit_mcmc_get_max_oversampling:
+ * @mcmc: a #NcmFitMCMC
+ *
+ * Returns: the maximum oversampling factor.
+ */
+guint 
+ncm_fit_mcmc_get_max_oversampling (NcmFitMCMC *mcmc)
+{
+  return mcmc->max_os;
+}
+
+/**
+ * ncm_fit_mcmc_get_nchains:
+ * @mcmc: a #NcmFitMCMC
+ *
+ * Returns: the number of chains.
+ */
+guint 
+ncm_fit_mcmc_get_nchains (NcmFitMCMC *mcmc)
+{
+  return mcmc->nchains;
+}
+
+/**
+ * ncm_fit_mcmc_get_max_shrink:
+ * @mcmc: a #NcmFitMCMC
+ *
+ * Returns: the maximum shrink factor used to stop the run, see ncm_fit_mcmc_set_max_shrink().
+ */
+gdouble 
+ncm_fit_mcmc_get_max_shrink (NcmFitMCMC *mcmc)
+{
+  return mcmc->max_shrink;
+}
+
 /**
  * ncm_fit_mcmc_get_accept_ratio:
  * @mcmc: a #NcmFitMCMC
@@ -382,15 +675,43 @@ ncm_fit_mcmc_get_accept_ratio (NcmFitMCMC *mcmc)
   return mcmc->naccepted * 1.0 / (mcmc->ntotal * 1.0);
 }
 
+/**
+ * ncm_fit_mcmc_get_block_accept_ratio:
+ * @mcmc: a #NcmFitMCMC
+ *
+ * Acceptance ratio of the block sub-steps when the fast/slow blocking is
+ * enabled, see ncm_fit_mcmc_set_fast_slow(). Without blocking it is the same
+ * as ncm_fit_mcmc_get_accept_ratio().
+ * 
+ * Returns: the acceptance ratio of the sub-steps.
+ */
+gdouble 
+ncm_fit_mcmc_get_block_accept_ratio (NcmFitMCMC *mcmc)
+{
+  if (mcmc->blocks == NULL)
+    return ncm_fit_mcmc_get_accept_ratio (mcmc);
+  else
+    return mcmc->nbaccepted * 1.0 / (mcmc->nbtotal * 1.0);
+}
+
 void
-_ncm_fit_mcmc_update (NcmFitMCMC *mcmc, NcmFit *fit)
+_ncm_fit_mcmc_update (NcmFitMCMC *mcmc, NcmFit *fit, NcmVector *row)
 {
   const guint part = 5;
   const guint step = (mcmc->n / part) == 0 ? 1 : (mcmc->n / part);
 
-  ncm_mset_catalog_add_from_mset (mcmc->mcat, fit->mset, ncm_fit_state_get_m2lnL_curval (fit->fstate), NULL);
+  if (row == NULL)
+    ncm_mset_catalog_add_from_mset (mcmc->mcat, fit->mset, ncm_fit_state_get_m2lnL_curval (fit->fstate), NULL);
+  else
+    ncm_mset_catalog_add_from_vector (mcmc->mcat, row);
+
+  mcmc->cur_sample_id++;
   ncm_timer_task_increment (mcmc->nt);
 
+  /* With several chains log only when all chains are at the same step. */
+  if ((mcmc->cur_sample_id + 1) % mcmc->nchains != 0)
+    return;
+
   switch (mcmc->mtype)
   {
     case NCM_FIT_RUN_MSGS_NONE:
@@ -405,7 +726,11 @@ _ncm_fit_mcmc_update (NcmFitMCMC *mcmc, NcmFit *fit)
       {
         /* guint acc = stepi == 0 ? step : stepi; */
         ncm_mset_catalog_log_current_stats (mcmc->mcat);
+        if (mcmc->nchains > 1)
+          ncm_mset_catalog_log_current_chain_stats (mcmc->mcat);
         g_message ("# NcmFitMCMC:acceptance ratio %7.4f%%.\n", ncm_fit_mcmc_get_accept_ratio (mcmc) * 100.0);
+        if (mcmc->blocks != NULL)
+          g_message ("# NcmFitMCMC:block acceptance ratio %7.4f%%.\n", ncm_fit_mcmc_get_block_accept_ratio (mcmc) * 100.0);
 
         /* ncm_timer_task_accumulate (mcmc->nt, acc); */
         ncm_timer_task_log_elapsed (mcmc->nt);
@@ -417,9 +742,16 @@ _ncm_fit_mcmc_update (NcmFitMCMC *mcmc, NcmFit *fit)
     }
     default:
     case NCM_FIT_RUN_MSGS_FULL:
+      if (row != NULL)
+      {
+        ncm_mset_fparams_set_vector_offset (fit->mset, row, 1);
+        ncm_fit_state_set_m2lnL_curval (fit->fstate, ncm_vector_get (row, 0));
+      }
       fit->mtype = mcmc->mtype;
       ncm_fit_log_state (fit);
       ncm_mset_catalog_log_current_stats (mcmc->mcat);
+      if (mcmc->nchains > 1)
+        ncm_mset_catalog_log_current_chain_stats (mcmc->mcat);
       g_message ("# NcmFitMCMC:acceptance ratio %7.4f%%.\n", ncm_fit_mcmc_get_accept_ratio (mcmc) * 100.0);
       /* ncm_timer_task_increment (mcmc->nt); */
       ncm_timer_task_log_elapsed (mcmc->nt);
@@ -432,6 +764,170 @@ _ncm_fit_mcmc_update (NcmFitMCMC *mcmc, NcmFit *fit)
 
 static void ncm_fit_mcmc_intern_skip (NcmFitMCMC *mcmc, guint n);
 
+static void
+_ncm_fit_mcmc_prepare_blocks (NcmFitMCMC *mcmc)
+{
+  g_clear_pointer (&mcmc->blocks, g_ptr_array_unref);
+  g_clear_pointer (&mcmc->block_os, g_array_unref);
+  g_clear_pointer (&mcmc->block_LLT, g_ptr_array_unref);
+
+  if (mcmc->fast_slow)
+  {
+    GArray *block_time = NULL;
+    guint i;
+
+    mcmc->blocks = ncm_fit_fparams_blocks_oversampling (mcmc->fit, mcmc->max_os, &mcmc->block_os, &block_time);
+
+    /* 
+     * The marginal of a Gaussian proposal on the block is the Gaussian with 
+     * the block of the covariance, so only the block components are drawn.
+     */
+    if (NCM_IS_MSET_TRANS_KERN_GAUSS (mcmc->tkern) && NCM_MSET_TRANS_KERN_GAUSS (mcmc->tkern)->init)
+    {
+      NcmMatrix *cov = ncm_mset_trans_kern_gauss_get_cov (NCM_MSET_TRANS_KERN_GAUSS (mcmc->tkern));
+
+      mcmc->block_LLT = g_ptr_array_new_with_free_func ((GDestroyNotify) &ncm_matrix_free);
+      for (i = 0; i < mcmc->blocks->len; i++)
+      {
+        GArray *block = g_ptr_array_index (mcmc->blocks, i);
+        NcmMatrix *LLT = ncm_matrix_new (block->len, block->len);
+        guint j, k;
+        gint ret;
+
+        for (j = 0; j < block->len; j++)
+        {
+          for (k = 0; k < block->len; k++)
+          {
+            ncm_matrix_set (LLT, j, k, ncm_matrix_get (cov, 
+                                                       g_array_index (block, guint, j), 
+                                                       g_array_index (block, guint, k)));
+          }
+        }
+
+        ret = ncm_matrix_cholesky_decomp (LLT, 'L');
+        if (ret != 0)
+          g_error ("_ncm_fit_mcmc_prepare_blocks: the block %u of the transition kernel covariance is not positive definite [%d].", i, ret);
+
+        g_ptr_array_add (mcmc->block_LLT, LLT);
+      }
+      ncm_matrix_free (cov);
+    }
+
+    if (mcmc->mtype > NCM_FIT_RUN_MSGS_NONE)
+    {
+      ncm_cfg_msg_sepa ();
+      g_message ("# NcmFitMCMC: Using fast/slow parameter blocking with %u blocks:\n", mcmc->blocks->len);
+      for (i = 0; i < mcmc->blocks->len; i++)
+      {
+        GArray *block = g_ptr_array_index (mcmc->blocks, i);
+        const guint n0 = g_array_index (block, guint, 0);
+        
+        g_message ("# NcmFitMCMC: - block %u [%s, ...] % 3u parameters, time per evaluation %10.5e s, oversampling %u.\n",
+                   i, ncm_mset_fparam_name (mcmc->fit->mset, n0), block->len, 
+                   g_array_index (block_time, gdouble, i),
+                   g_array_index (mcmc->block_os, guint, i));
+      }
+    }
+
+    g_array_unref (block_time);
+  }
+}
+
+static gpointer _ncm_fit_mcmc_dup_fit (gpointer userdata);
+
+static void
+_ncm_fit_mcmc_prepare_chains (NcmFitMCMC *mcmc)
+{
+  const guint fparam_len = ncm_mset_fparam_len (mcmc->fit->mset);
+  guint k;
+
+  g_clear_pointer (&mcmc->chains, g_ptr_array_unref);
+
+  if (mcmc->nchains == 1)
+    return;
+
+  if (mcmc->mp != NULL)
+    ncm_memory_pool_free (mcmc->mp, TRUE);
+  mcmc->mp = ncm_memory_pool_new (&_ncm_fit_mcmc_dup_fit, mcmc, 
+                                  (GDestroyNotify) &ncm_fit_free);
+
+  mcmc->chains = g_ptr_array_new_with_free_func (&_ncm_fit_mcmc_chain_free);
+
+  /* Each chain has its own RNG seeded from the catalog RNG. */
+  ncm_rng_lock (mcmc->mcat->rng);
+  for (k = 0; k < mcmc->nchains; k++)
+  {
+    NcmRNG *rng = ncm_rng_seeded_new (ncm_rng_get_algo (mcmc->mcat->rng), gsl_rng_get (mcmc->mcat->rng->r));
+
+    g_ptr_array_add (mcmc->chains, _ncm_fit_mcmc_chain_new (fparam_len, rng));
+    ncm_rng_free (rng);
+  }
+  ncm_rng_unlock (mcmc->mcat->rng);
+}
+
+static void 
+_ncm_fit_mcmc_chains_init_eval (glong i, glong f, gpointer data)
+{
+  NcmFitMCMC *mcmc = NCM_FIT_MCMC (data);
+  NcmFit **fit_ptr = ncm_memory_pool_get (mcmc->mp);
+  NcmFit *fit      = *fit_ptr;
+  glong k;
+
+  for (k = i; k < f; k++)
+  {
+    NcmFitMCMCChain *chain = g_ptr_array_index (mcmc->chains, k);
+    gdouble *m2lnL         = ncm_vector_ptr (chain->cur, 0);
+
+    ncm_mset_fparams_get_vector (mcmc->fit->mset, chain->theta);
+
+    do
+    {
+      if (k > 0)
+        ncm_mset_trans_kern_generate (mcmc->tkern, chain->theta, chain->thetastar, chain->rng);
+      else
+        ncm_vector_memcpy (chain->thetastar, chain->theta);
+
+      ncm_mset_fparams_set_vector (fit->mset, chain->thetastar);
+      ncm_fit_m2lnL_val (fit, m2lnL);
+
+      if ((k == 0) && !gsl_finite (m2lnL[0]))
+        g_error ("_ncm_fit_mcmc_chains_init_eval: the likelihood is not finite at the initial point.");
+
+    } while (!gsl_finite (m2lnL[0]));
+
+    ncm_mset_fparams_get_vector_offset (fit->mset, chain->cur, 1);
+  }
+
+  ncm_memory_pool_return (fit_ptr);
+}
+
+static void
+_ncm_fit_mcmc_chains_init (NcmFitMCMC *mcmc)
+{
+  const guint len = ncm_mset_catalog_len (mcmc->mcat);
+  guint k;
+
+  if (len % mcmc->nchains != 0)
+    g_error ("_ncm_fit_mcmc_chains_init: the catalog contains %u points, which is not a multiple of the number of chains %u.", 
+             len, mcmc->nchains);
+
+  if (len > 0)
+  {
+    for (k = 0; k < mcmc->nchains; k++)
+    {
+      NcmFitMCMCChain *chain = g_ptr_array_index (mcmc->chains, k);
+      NcmVector *cur_row     = ncm_mset_catalog_peek_row (mcmc->mcat, len - mcmc->nchains + k);
+      g_assert (cur_row != NULL);
+
+      ncm_vector_memcpy (chain->cur, cur_row);
+    }
+  }
+  else if (mcmc->nthreads > 1)
+    ncm_func_eval_threaded_loop_full (&_ncm_fit_mcmc_chains_init_eval, 0, mcmc->nchains, mcmc);
+  else
+    _ncm_fit_mcmc_chains_init_eval (0, mcmc->nchains, mcmc);
+}
+
 /**
  * ncm_fit_mcmc_start_run:
  * @mcmc: a #NcmFitMCMC
@@ -484,10 +980,17 @@ ncm_fit_mcmc_start_run (NcmFitMCMC *mcmc)
     }
     mcmc->theta = ncm_vector_new (fparam_len);
     mcmc->thetastar = ncm_vector_new (fparam_len);
+    ncm_vector_clear (&mcmc->theta_b);
+    mcmc->theta_b = ncm_vector_new (fparam_len);
   }
 
-  mcmc->naccepted = 0;
-  mcmc->ntotal = 0;
+  _ncm_fit_mcmc_prepare_blocks (mcmc);
+  _ncm_fit_mcmc_prepare_chains (mcmc);
+
+  mcmc->naccepted  = 0;
+  mcmc->ntotal     = 0;
+  mcmc->nbaccepted = 0;
+  mcmc->nbtotal    = 0;
   
   ncm_mset_catalog_set_sync_mode (mcmc->mcat, NCM_MSET_CATALOG_SYNC_TIMED);
   ncm_mset_catalog_set_sync_interval (mcmc->mcat, NCM_FIT_MCMC_MIN_SYNC_INTERVAL);
@@ -502,6 +1005,11 @@ ncm_fit_mcmc_start_run (NcmFitMCMC *mcmc)
     g_error ("ncm_fit_mcmc_set_data_file: Unknown error cur_id < cur_sample_id [%d < %d].", 
              mcmc->mcat->cur_id, mcmc->cur_sample_id);
   
+  if (mcmc->nchains > 1)
+  {
+    _ncm_fit_mcmc_chains_init (mcmc);
+  }
+  else
   {
     NcmVector *cur_row = NULL;
     
@@ -538,6 +1046,7 @@ ncm_fit_mcmc_end_run (NcmFitMCMC *mcmc)
     ncm_memory_pool_free (mcmc->mp, TRUE);
     mcmc->mp = NULL;
   }
+  g_clear_pointer (&mcmc->chains, g_ptr_array_unref);
 
   ncm_mset_catalog_sync (mcmc->mcat, TRUE);
   
@@ -559,6 +1068,8 @@ ncm_fit_mcmc_reset (NcmFitMCMC *mcmc)
   mcmc->write_index     = 0;
   mcmc->ntotal          = 0;
   mcmc->naccepted       = 0;
+  mcmc->nbtotal         = 0;
+  mcmc->nbaccepted      = 0;
   mcmc->started         = FALSE;  
   ncm_mset_catalog_reset (mcmc->mcat);
 }
@@ -611,7 +1122,7 @@ ncm_fit_mcmc_set_first_sample_id (NcmFitMCMC *mcmc, gint first_sample_id)
 }
 
 static void _ncm_fit_mcmc_run_single (NcmFitMCMC *mcmc);
-static void _ncm_fit_mcmc_run_mt (NcmFitMCMC *mcmc);
+static void _ncm_fit_mcmc_run_chains (NcmFitMCMC *mcmc);
 
 /**
  * ncm_fit_mcmc_run:
@@ -620,6 +1131,10 @@ static void _ncm_fit_mcmc_run_mt (NcmFitMCMC *mcmc);
  * 
  * Runs the Markov Chain Monte Carlo until it reaches the @n-th realization. Note that
  * if the first_id is non-zero it will run @n - first_id realizations.
+ * 
+ * When using more than one chain @n is rounded up to a multiple of the number
+ * of chains, so all chains have the same length, and the run may stop before
+ * @n if the chains converged, see ncm_fit_mcmc_set_max_shrink().
  *
  */
 void 
@@ -637,6 +1152,9 @@ ncm_fit_mcmc_run (NcmFitMCMC *mcmc, guint n)
     }
     return;
   }
+
+  if (n % mcmc->nchains != 0)
+    n += mcmc->nchains - n % mcmc->nchains;
   
   mcmc->n = n - (mcmc->cur_sample_id + 1);
   
@@ -666,52 +1184,165 @@ ncm_fit_mcmc_run (NcmFitMCMC *mcmc, guint n)
   if (mcmc->mtype > NCM_FIT_RUN_MSGS_NONE)
     ncm_timer_task_log_start_datetime (mcmc->nt);
 
-  if (mcmc->nthreads <= 1)
+  if (mcmc->nchains == 1)
     _ncm_fit_mcmc_run_single (mcmc);
   else
-    _ncm_fit_mcmc_run_mt (mcmc);
+    _ncm_fit_mcmc_run_chains (mcmc);
 
   ncm_timer_task_pause (mcmc->nt);
 }
 
-static void 
-_ncm_fit_mcmc_run_single (NcmFitMCMC *mcmc)
+/*
+ * Draws a proposal for the block @b in @theta_b, which must contain the 
+ * current point. Only the block components are drawn and checked against
+ * the parameter bounds, @thetastar is used as scratch space.
+ */
+static void
+_ncm_fit_mcmc_block_generate (NcmFitMCMC *mcmc, NcmFit *fit, NcmRNG *rng, NcmVector *theta, NcmVector *thetastar, NcmVector *theta_b, guint b)
 {
-  guint i = 0;
-  
-  for (i = 0; i < mcmc->n; i++)
+  GArray *block        = g_ptr_array_index (mcmc->blocks, b);
+  NcmMatrix *LLT       = g_ptr_array_index (mcmc->block_LLT, b);
+  gsl_vector_view u    = gsl_vector_subvector (ncm_vector_gsl (thetastar), 0, block->len);
+  gboolean valid       = FALSE;
+  guint j;
+
+  while (!valid)
   {
-    gdouble m2lnL_cur = ncm_fit_state_get_m2lnL_curval (mcmc->fit->fstate);
-    gdouble m2lnL_star, prob, jump = 0.0;
-    
-    ncm_mset_fparams_get_vector (mcmc->fit->mset, mcmc->theta);
-    ncm_mset_trans_kern_generate (mcmc->tkern, mcmc->theta, mcmc->thetastar, mcmc->mcat->rng);
-    ncm_mset_fparams_set_vector (mcmc->fit->mset, mcmc->thetastar);
+    gint ret;
+
+    ncm_rng_lock (rng);
+    for (j = 0; j < block->len; j++)
+      gsl_vector_set (&u.vector, j, gsl_ran_ugaussian (rng->r));
+    ncm_rng_unlock (rng);
+
+    ret = gsl_blas_dtrmv (CblasLower, CblasNoTrans, CblasNonUnit,
+                          ncm_matrix_gsl (LLT), &u.vector);
+    NCM_TEST_GSL_RESULT ("_ncm_fit_mcmc_block_generate", ret);
+
+    valid = TRUE;
+    for (j = 0; j < block->len; j++)
+    {
+      const guint n    = g_array_index (block, guint, j);
+      const gdouble pn = ncm_vector_get (theta, n) + gsl_vector_get (&u.vector, j);
+
+      if ((pn < ncm_mset_fparam_get_lower_bound (fit->mset, n)) || (pn > ncm_mset_fparam_get_upper_bound (fit->mset, n)))
+      {
+        valid = FALSE;
+        break;
+      }
+      ncm_vector_set (theta_b, n, pn);
+    }
+  }
+}
+
+static gboolean
+_ncm_fit_mcmc_mh_step (NcmFitMCMC *mcmc, NcmFit *fit, NcmRNG *rng, NcmVector *theta, NcmVector *thetastar, NcmVector *theta_b, gint b)
+{
+  gdouble m2lnL_cur = ncm_fit_state_get_m2lnL_curval (fit->fstate);
+  gdouble m2lnL_star, prob, jump = 0.0;
+
+  ncm_mset_fparams_get_vector (fit->mset, theta);
+
+  if (b < 0)
+  {
+    ncm_mset_trans_kern_generate (mcmc->tkern, theta, thetastar, rng);
+    ncm_mset_fparams_set_vector (fit->mset, thetastar);
+  }
+  else 
+  {
+    /* Moves only the parameters in the block, the marginal of the proposal is still symmetric. */
+    ncm_vector_memcpy (theta_b, theta);
+
+    if (mcmc->block_LLT != NULL)
+      _ncm_fit_mcmc_block_generate (mcmc, fit, rng, theta, thetastar, theta_b, b);
+    else
+    {
+      GArray *block = g_ptr_array_index (mcmc->blocks, b);
+      guint j;
+
+      ncm_mset_trans_kern_generate (mcmc->tkern, theta, thetastar, rng);
+      for (j = 0; j < block->len; j++)
+      {
+        const guint n = g_array_index (block, guint, j);
+        ncm_vector_set (theta_b, n, ncm_vector_get (thetastar, n));
+      }
+    }
+    ncm_mset_fparams_set_vector (fit->mset, theta_b);
+  }
 
-    ncm_fit_m2lnL_val (mcmc->fit, &m2lnL_star);
-    mcmc->ntotal++;
-    mcmc->naccepted++;
+  ncm_fit_m2lnL_val (fit, &m2lnL_star);
 /*
-    ncm_vector_log_vals (mcmc->theta, "# Theta  : ", "% 8.5g");
-    ncm_vector_log_vals (mcmc->thetastar, "# Theta* : ", "% 8.5g");
+  ncm_vector_log_vals (theta, "# Theta  : ", "% 8.5g");
+  ncm_vector_log_vals (thetastar, "# Theta* : ", "% 8.5g");
 */
-    prob = GSL_MIN (exp ((m2lnL_cur - m2lnL_star) * 0.5), 1.0);
-    ncm_fit_state_set_m2lnL_curval (mcmc->fit->fstate, m2lnL_star);
-    
-    /*printf ("# Prob %e [% 21.16g % 21.16g] % 21.16g\n", prob, m2lnL_cur, m2lnL_star, m2lnL_cur - m2lnL_star);*/    
+  prob = GSL_MIN (exp ((m2lnL_cur - m2lnL_star) * 0.5), 1.0);
+  ncm_fit_state_set_m2lnL_curval (fit->fstate, m2lnL_star);
+
+  /*printf ("# Prob %e [% 21.16g % 21.16g] % 21.16g\n", prob, m2lnL_cur, m2lnL_star, m2lnL_cur - m2lnL_star);*/    
 
-    if (prob != 1.0)
+  if (prob != 1.0)
+  {
+    jump = gsl_rng_uniform (rng->r);
+    if (jump > prob)
     {
-      jump = gsl_rng_uniform (mcmc->mcat->rng->r);
-      if (jump > prob)
+      ncm_mset_fparams_set_vector (fit->mset, theta);
+      ncm_fit_state_set_m2lnL_curval (fit->fstate, m2lnL_cur);
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/*
+ * One step writes one catalog row. With blocking a step is accepted when
+ * any of its sub-steps is, the sub-steps are counted in @nbaccepted and
+ * @nbtotal.
+ */
+static void
+_ncm_fit_mcmc_step (NcmFitMCMC *mcmc, NcmFit *fit, NcmRNG *rng, NcmVector *theta, NcmVector *thetastar, NcmVector *theta_b, 
+                    guint *naccepted, guint *ntotal, guint *nbaccepted, guint *nbtotal)
+{
+  if (mcmc->blocks == NULL)
+  {
+    naccepted[0] += _ncm_fit_mcmc_mh_step (mcmc, fit, rng, theta, thetastar, theta_b, -1) ? 1 : 0;
+  }
+  else
+  {
+    gboolean moved = FALSE;
+    guint b;
+    
+    for (b = 0; b < mcmc->blocks->len; b++)
+    {
+      const guint os = g_array_index (mcmc->block_os, guint, b);
+      guint o;
+
+      for (o = 0; o < os; o++)
       {
-        ncm_mset_fparams_set_vector (mcmc->fit->mset, mcmc->theta);
-        ncm_fit_state_set_m2lnL_curval (mcmc->fit->fstate, m2lnL_cur);
-        mcmc->naccepted--;
+        if (_ncm_fit_mcmc_mh_step (mcmc, fit, rng, theta, thetastar, theta_b, b))
+        {
+          nbaccepted[0]++;
+          moved = TRUE;
+        }
+        nbtotal[0]++;
       }
     }
+    naccepted[0] += moved ? 1 : 0;
+  }
+  ntotal[0]++;
+}
+
+static void 
+_ncm_fit_mcmc_run_single (NcmFitMCMC *mcmc)
+{
+  guint i = 0;
+  
+  for (i = 0; i < mcmc->n; i++)
+  {
+    _ncm_fit_mcmc_step (mcmc, mcmc->fit, mcmc->mcat->rng, mcmc->theta, mcmc->thetastar, mcmc->theta_b, 
+                        &mcmc->naccepted, &mcmc->ntotal, &mcmc->nbaccepted, &mcmc->nbtotal);
     
-    _ncm_fit_mcmc_update (mcmc, mcmc->fit);
+    _ncm_fit_mcmc_update (mcmc, mcmc->fit, NULL);
     mcmc->write_index++;
   }
 }
@@ -729,69 +1360,119 @@ _ncm_fit_mcmc_dup_fit (gpointer userdata)
   }
 }
 
+typedef struct _NcmFitMCMCBatch
+{
+  NcmFitMCMC *mcmc;
+  guint nsteps;
+} NcmFitMCMCBatch;
+
 static void 
-_ncm_fit_mcmc_mt_eval (glong i, glong f, gpointer data)
+_ncm_fit_mcmc_chains_eval (glong i, glong f, gpointer data)
 {
-  NcmFitMCMC *mcmc = NCM_FIT_MCMC (data);
-  NcmFit **fit_ptr = ncm_memory_pool_get (mcmc->mp);
-  NcmFit *fit = *fit_ptr;
-  guint j;
-  
-  g_assert_not_reached (); /* FIXME not implemented */
+  NcmFitMCMCBatch *batch = (NcmFitMCMCBatch *) data;
+  NcmFitMCMC *mcmc       = batch->mcmc;
+  NcmFit **fit_ptr       = ncm_memory_pool_get (mcmc->mp);
+  NcmFit *fit            = *fit_ptr;
+  glong k;
 
-  for (j = i; j < f; j++)
+  for (k = i; k < f; k++)
   {
-    gint sample_index;
-
-//    ncm_mset_param_set_vector (fit->mset, mcmc->bf);
+    NcmFitMCMCChain *chain = g_ptr_array_index (mcmc->chains, k);
+    guint s;
 
-    g_mutex_lock (&mcmc->resample_lock);
-//    sample_index = _ncm_fit_mcmc_resample (mc, fit);
-    sample_index = 0;
-    g_mutex_unlock (&mcmc->resample_lock);
+    /* The fit object is shared by the chains evolved in this thread, so the state is restored first. */
+    ncm_mset_fparams_set_vector_offset (fit->mset, chain->cur, 1);
+    ncm_fit_state_set_m2lnL_curval (fit->fstate, ncm_vector_get (chain->cur, 0));
 
-    ncm_fit_run (fit, NCM_FIT_RUN_MSGS_NONE);
+    for (s = 0; s < batch->nsteps; s++)
+    {
+      NcmVector *row_s = g_ptr_array_index (chain->rows, s);
 
-    g_mutex_lock (&mcmc->update_lock);    
-    while (mcmc->write_index != sample_index)
-      g_cond_wait (&mcmc->write_cond, &mcmc->update_lock);
+      _ncm_fit_mcmc_step (mcmc, fit, chain->rng, chain->theta, chain->thetastar, chain->theta_b, 
+                          &chain->naccepted, &chain->ntotal, &chain->nbaccepted, &chain->nbtotal);
 
-    _ncm_fit_mcmc_update (mcmc, fit);
-    mcmc->write_index++;
-    g_cond_broadcast (&mcmc->write_cond);
+      ncm_vector_set (row_s, 0, ncm_fit_state_get_m2lnL_curval (fit->fstate));
+      ncm_mset_fparams_get_vector_offset (fit->mset, row_s, 1);
+    }
 
-    g_mutex_unlock (&mcmc->update_lock);
+    ncm_vector_memcpy (chain->cur, g_ptr_array_index (chain->rows, batch->nsteps - 1));
   }
 
   ncm_memory_pool_return (fit_ptr);
 }
 
 static void
-_ncm_fit_mcmc_run_mt (NcmFitMCMC *mcmc)
+_ncm_fit_mcmc_run_chains (NcmFitMCMC *mcmc)
 {
-  const guint nthreads = mcmc->n > mcmc->nthreads ? mcmc->nthreads : (mcmc->n - 1);
+  const guint nsteps      = mcmc->n / mcmc->nchains;
+  const guint batch_size  = GSL_MIN (NCM_FIT_MCMC_MAX_BATCH, GSL_MAX (nsteps / 10, 1));
+  const guint fparam_len  = ncm_mset_fparam_len (mcmc->fit->mset);
+  NcmFitMCMCBatch batch   = {mcmc, 0};
+  guint done              = 0;
 
-  if (nthreads == 0)
+  g_assert_cmpuint (mcmc->n % mcmc->nchains, ==, 0);
+
+  while (done < nsteps)
   {
-    _ncm_fit_mcmc_run_single (mcmc);
-    return;
-  }
-  
-  if (mcmc->mp != NULL)
-    ncm_memory_pool_free (mcmc->mp, TRUE);
-  mcmc->mp = ncm_memory_pool_new (&_ncm_fit_mcmc_dup_fit, mcmc, 
-                                (GDestroyNotify) &ncm_fit_free);
+    guint k, s;
+
+    batch.nsteps = GSL_MIN (batch_size, nsteps - done);
 
-  /*
-   * The line below added de main fit object to the pool, but can cause
-   * several race conditions as it is used to make the copies for the other
-   * threads. So, no.
-   */
-  //ncm_memory_pool_add (mc->mp, mc->fit);
+    for (k = 0; k < mcmc->nchains; k++)
+    {
+      NcmFitMCMCChain *chain = g_ptr_array_index (mcmc->chains, k);
+      while (chain->rows->len < batch.nsteps)
+        g_ptr_array_add (chain->rows, ncm_vector_new (fparam_len + 1));
+    }
+
+    if (mcmc->nthreads > 1)
+      ncm_func_eval_threaded_loop_full (&_ncm_fit_mcmc_chains_eval, 0, mcmc->nchains, &batch);
+    else
+      _ncm_fit_mcmc_chains_eval (0, mcmc->nchains, &batch);
+
+    mcmc->naccepted  = 0;
+    mcmc->ntotal     = 0;
+    mcmc->nbaccepted = 0;
+    mcmc->nbtotal    = 0;
+    for (k = 0; k < mcmc->nchains; k++)
+    {
+      NcmFitMCMCChain *chain = g_ptr_array_index (mcmc->chains, k);
+      mcmc->naccepted  += chain->naccepted;
+      mcmc->ntotal     += chain->ntotal;
+      mcmc->nbaccepted += chain->nbaccepted;
+      mcmc->nbtotal    += chain->nbtotal;
+    }
 
-  g_assert_cmpuint (mcmc->nthreads, >, 1);
+    /* Rows are interleaved, so that row i belongs to the chain i % nchains. */
+    for (s = 0; s < batch.nsteps; s++)
+    {
+      for (k = 0; k < mcmc->nchains; k++)
+      {
+        NcmFitMCMCChain *chain = g_ptr_array_index (mcmc->chains, k);
 
-  ncm_func_eval_threaded_loop_full (&_ncm_fit_mcmc_mt_eval, 0, mcmc->n, mcmc);  
+        _ncm_fit_mcmc_update (mcmc, mcmc->fit, g_ptr_array_index (chain->rows, s));
+        mcmc->write_index++;
+      }
+    }
+
+    done += batch.nsteps;
+
+    if ((mcmc->max_shrink > 1.0) && (ncm_mset_catalog_max_time (mcmc->mcat) >= NCM_FIT_MCMC_MIN_CONV_STEPS))
+    {
+      const gdouble shrink_factor = ncm_mset_catalog_get_shrink_factor (mcmc->mcat);
+
+      if (shrink_factor < mcmc->max_shrink)
+      {
+        if (mcmc->mtype > NCM_FIT_RUN_MSGS_NONE)
+        {
+          ncm_cfg_msg_sepa ();
+          g_message ("# NcmFitMCMC: Chains converged, shrink factor %.6g < %.6g after %u points per chain.\n", 
+                     shrink_factor, mcmc->max_shrink, ncm_mset_catalog_max_time (mcmc->mcat));
+        }
+        break;
+      }
+    }
+  }
 }
 
 /**
@@ -69,18 +69,26 @@ struct _NcmFitMCMC
   NcmMSetTransKern *tkern;
   NcmVector *theta;
   NcmVector *thetastar;
+  NcmVector *theta_b;
+  GPtrArray *blocks;
+  GArray *block_os;
+  GPtrArray *block_LLT;
+  gboolean fast_slow;
+  guint max_os;
   guint nthreads;
+  guint nchains;
+  gdouble max_shrink;
+  GPtrArray *chains;
   guint n;
   NcmMemoryPool *mp;
   gint write_index;
   gint cur_sample_id;
   guint naccepted;
   guint ntotal;
+  guint nbaccepted;
+  guint nbtotal;
   gboolean started;
   GMutex dup_fit;
-  GMutex resample_lock;
-  GMutex update_lock;
-  GCond write_cond;
 };
 
 GType ncm_fit_mcmc_get_type (void) G_GNUC_CONST;
@@ -94,10 +102,19 @@ void ncm_fit_mcmc_set_data_file (NcmFitMCMC *mcmc, const gchar *filename);
 void ncm_fit_mcmc_set_mtype (NcmFitMCMC *mcmc, NcmFitRunMsgs mtype);
 void ncm_fit_mcmc_set_trans_kern (NcmFitMCMC *mcmc, NcmMSetTransKern *tkern);
 void ncm_fit_mcmc_set_nthreads (NcmFitMCMC *mcmc, guint nthreads);
+void ncm_fit_mcmc_set_nchains (NcmFitMCMC *mcmc, guint nchains);
+void ncm_fit_mcmc_set_max_shrink (NcmFitMCMC *mcmc, gdouble max_shrink);
 void ncm_fit_mcmc_set_fiducial (NcmFitMCMC *mcmc, NcmMSet *fiduc);
 void ncm_fit_mcmc_set_rng (NcmFitMCMC *mcmc, NcmRNG *rng);
+void ncm_fit_mcmc_set_fast_slow (NcmFitMCMC *mcmc, gboolean fast_slow);
+void ncm_fit_mcmc_set_max_oversampling (NcmFitMCMC *mcmc, guint max_os);
+gboolean ncm_fit_mcmc_get_fast_slow (NcmFitMCMC *mcmc);
+guint ncm_fit_mcmc_get_max_oversampling (NcmFitMCMC *mcmc);
+guint ncm_fit_mcmc_get_nchains (NcmFitMCMC *mcmc);
+gdouble ncm_fit_mcmc_get_max_shrink (NcmFitMCMC *mcmc);
 
 gdouble ncm_fit_mcmc_get_accept_ratio (NcmFitMCMC *mcmc);
+gdouble ncm_fit_mcmc_get_block_accept_ratio (NcmFitMCMC *mcmc);
 
 void ncm_fit_mcmc_start_run (NcmFitMCMC *mcmc);
 void ncm_fit_mcmc_end_run (NcmFitMCMC *mcmc);
@@ -111,6 +128,21 @@ NcmMSetCatalog *ncm_fit_mcmc_get_catalog (NcmFitMCMC *mcmc);
 
 #define NCM_FIT_MCMC_MIN_SYNC_INTERVAL (10.0)
 
+/**
+ * NCM_FIT_MCMC_MAX_BATCH:
+ *
+ * Maximum number of steps each chain does before the threads are
+ * synchronized and the points are added to the catalog.
+ */
+#define NCM_FIT_MCMC_MAX_BATCH (1000)
+
+/**
+ * NCM_FIT_MCMC_MIN_CONV_STEPS:
+ *
+ * Minimum number of points per chain before the convergence test.
+ */
+#define NCM_FIT_MCMC_MIN_CONV_STEPS (100)
+
 G_END_DECLS
 
 #endif /* _NCM_FIT_MCMC_H_ */
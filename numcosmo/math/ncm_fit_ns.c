@@ -0,0 +1,1298 @@
+/***************************************************************************
+ *            ncm_fit_ns.c
+ *
+ *  Mon October 19 18:20:41 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_fit_ns.c
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:ncm_fit_ns
+ * @title: NcmFitNS
+ * @short_description: Nested sampling evidence and posterior estimator.
+ *
+ * Nested sampling [Skilling (2006)] estimates the Bayesian evidence
+ * $$Z = \int\mathrm{d}X\,L(X),$$
+ * where $X$ is the prior volume enclosed by the likelihood contour $L$.
+ * The prior is uniform in the box defined by the bounds of the free
+ * parameters of the #NcmMSet, any #NcmPrior included in the #NcmLikelihood
+ * is treated as part of the likelihood. The box is mapped to the unit
+ * hypercube where the sampling is done.
+ *
+ * A set of #NcmFitNS:nlive live points is first drawn from the prior. At
+ * each iteration the worst live points are removed (one per thread, see
+ * ncm_fit_ns_set_nthreads()), the prior volume shrinks as
+ * $\ln X_{i} = \ln X_{i-1} - 1/n_\mathrm{live}$ for each removed point, and
+ * the same number of new points is drawn from the prior restricted to the
+ * region with likelihood higher than the last removed point. The new points
+ * are obtained by rejection sampling from the bounding ellipsoid of the
+ * remaining live points, computed from their covariance and enlarged by
+ * #NcmFitNS:enlarge in volume. The new points are computed in parallel
+ * through ncm_func_eval_threaded_loop_full(), each thread using its own copy
+ * of the #NcmFit. The run stops when the evidence remaining in the live
+ * points, estimated as $L_\mathrm{max}X$, changes $\ln Z$ by less than
+ * #NcmFitNS:dlnZ-tol, the uncertainty of $\ln Z$ is estimated by
+ * $\sqrt{H/n_\mathrm{live}}$ where $H$ is the information.
+ *
+ * Points with the same likelihood are ordered by a uniform random tie-breaker
+ * drawn with each point, so that the run also advances on likelihood 
+ * plateaus.
+ *
+ * Every point ever sampled is added to the catalog, see
+ * ncm_fit_ns_get_catalog(), with $-2\ln L$, the iteration in which it was
+ * created, its tie-breaker and the number of likelihood evaluations used to
+ * draw it. The catalog is synchronized with its file only at the end of
+ * complete iterations, and the whole state of the sampler is reconstructed
+ * from it by ncm_fit_ns_start_run(), so that a run can be resumed from the
+ * file. The weighted posterior samples are obtained with
+ * ncm_fit_ns_get_posterior().
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif /* HAVE_CONFIG_H */
+#include "build_cfg.h"
+
+#include "math/ncm_fit_ns.h"
+#include "math/ncm_cfg.h"
+#include "math/ncm_func_eval.h"
+#include "math/ncm_util.h"
+#include "ncm_enum_types.h"
+
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_sf_gamma.h>
+
+enum
+{
+  PROP_0,
+  PROP_FIT,
+  PROP_NLIVE,
+  PROP_MTYPE,
+  PROP_NTHREADS,
+  PROP_DATA_FILE,
+  PROP_ENLARGE,
+  PROP_DLNZ_TOL,
+};
+
+G_DEFINE_TYPE (NcmFitNS, ncm_fit_ns, G_TYPE_OBJECT);
+
+static gpointer _ncm_fit_ns_worker_dup (gpointer userdata);
+static void _ncm_fit_ns_worker_free (gpointer p);
+
+static void
+ncm_fit_ns_init (NcmFitNS *ns)
+{
+  ns->fit           = NULL;
+  ns->mp            = ncm_memory_pool_new (&_ncm_fit_ns_worker_dup, ns,
+                                           &_ncm_fit_ns_worker_free);
+  ns->mcat          = NULL;
+  ns->mtype         = NCM_FIT_RUN_MSGS_NONE;
+  ns->ser           = ncm_serialize_new (NCM_SERIALIZE_OPT_CLEAN_DUP);
+  ns->live          = g_array_new (FALSE, FALSE, sizeof (guint));
+  ns->live_m2lnL    = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  ns->live_tie      = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  ns->dead          = g_array_new (FALSE, FALSE, sizeof (guint));
+  ns->dead_lnw      = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  ns->pending       = g_ptr_array_new_with_free_func ((GDestroyNotify) &ncm_vector_free);
+  ns->lb            = NULL;
+  ns->ub            = NULL;
+  ns->mu            = NULL;
+  ns->LLT           = NULL;
+  ns->u             = NULL;
+  ns->r             = 0.0;
+  ns->m2lnL_star    = GSL_POSINF;
+  ns->tie_star      = 1.0;
+  ns->enlarge       = 0.0;
+  ns->dlnZ_tol      = 0.0;
+  ns->lnX           = 0.0;
+  ns->lnZ           = GSL_NEGINF;
+  ns->H             = 0.0;
+  ns->fparam_len    = 0;
+  ns->nlive         = 0;
+  ns->nthreads      = 0;
+  ns->niter         = 0;
+  ns->ntotal        = 0;
+  ns->naccepted     = 0;
+  ns->cur_sample_id = -1; /* Represents that no samples were calculated yet. */
+  ns->started       = FALSE;
+}
+
+static void
+_ncm_fit_ns_constructed (GObject *object)
+{
+  /* Chain up : start */
+  G_OBJECT_CLASS (ncm_fit_ns_parent_class)->constructed (object);
+  {
+    NcmFitNS *ns = NCM_FIT_NS (object);
+
+    ns->fparam_len = ncm_mset_fparam_len (ns->fit->mset);
+    g_assert_cmpuint (ns->fparam_len, >, 0);
+
+    ns->mcat = ncm_mset_catalog_new (ns->fit->mset, NCM_FIT_NS_NADD_VALS, 1, FALSE,
+                                     NCM_MSET_CATALOG_M2LNL_COLNAME, NCM_MSET_CATALOG_M2LNL_SYMBOL,
+                                     "NcmFitNS:birth", "b",
+                                     "NcmFitNS:tie", "t",
+                                     "NcmFitNS:ntries", "n_t",
+                                     NULL);
+    ncm_mset_catalog_set_run_type (ns->mcat, "Nested Sampling");
+
+    ns->lb  = ncm_vector_new (ns->fparam_len);
+    ns->ub  = ncm_vector_new (ns->fparam_len);
+    ns->mu  = ncm_vector_new (ns->fparam_len);
+    ns->u   = ncm_vector_new (ns->fparam_len);
+    ns->LLT = ncm_matrix_new (ns->fparam_len, ns->fparam_len);
+  }
+}
+
+static void _ncm_fit_ns_set_fit_obj (NcmFitNS *ns, NcmFit *fit);
+
+static void
+ncm_fit_ns_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+  NcmFitNS *ns = NCM_FIT_NS (object);
+  g_return_if_fail (NCM_IS_FIT_NS (object));
+
+  switch (prop_id)
+  {
+    case PROP_FIT:
+      _ncm_fit_ns_set_fit_obj (ns, g_value_get_object (value));
+      break;
+    case PROP_NLIVE:
+      ns->nlive = g_value_get_uint (value);
+      break;
+    case PROP_MTYPE:
+      ncm_fit_ns_set_mtype (ns, g_value_get_enum (value));
+      break;
+    case PROP_NTHREADS:
+      ncm_fit_ns_set_nthreads (ns, g_value_get_uint (value));
+      break;
+    case PROP_DATA_FILE:
+      ncm_fit_ns_set_data_file (ns, g_value_get_string (value));
+      break;
+    case PROP_ENLARGE:
+      ncm_fit_ns_set_enlarge (ns, g_value_get_double (value));
+      break;
+    case PROP_DLNZ_TOL:
+      ncm_fit_ns_set_dlnZ_tol (ns, g_value_get_double (value));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+ncm_fit_ns_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+  NcmFitNS *ns = NCM_FIT_NS (object);
+  g_return_if_fail (NCM_IS_FIT_NS (object));
+
+  switch (prop_id)
+  {
+    case PROP_FIT:
+      g_value_set_object (value, ns->fit);
+      break;
+    case PROP_NLIVE:
+      g_value_set_uint (value, ns->nlive);
+      break;
+    case PROP_MTYPE:
+      g_value_set_enum (value, ns->mtype);
+      break;
+    case PROP_NTHREADS:
+      g_value_set_uint (value, ns->nthreads);
+      break;
+    case PROP_DATA_FILE:
+      g_value_set_string (value, ncm_mset_catalog_peek_filename (ns->mcat));
+      break;
+    case PROP_ENLARGE:
+      g_value_set_double (value, ns->enlarge);
+      break;
+    case PROP_DLNZ_TOL:
+      g_value_set_double (value, ns->dlnZ_tol);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+ncm_fit_ns_dispose (GObject *object)
+{
+  NcmFitNS *ns = NCM_FIT_NS (object);
+
+  ncm_fit_clear (&ns->fit);
+  ncm_serialize_clear (&ns->ser);
+  ncm_mset_catalog_clear (&ns->mcat);
+
+  ncm_vector_clear (&ns->lb);
+  ncm_vector_clear (&ns->ub);
+  ncm_vector_clear (&ns->mu);
+  ncm_vector_clear (&ns->u);
+  ncm_matrix_clear (&ns->LLT);
+
+  g_clear_pointer (&ns->live, g_array_unref);
+  g_clear_pointer (&ns->live_m2lnL, g_array_unref);
+  g_clear_pointer (&ns->live_tie, g_array_unref);
+  g_clear_pointer (&ns->dead, g_array_unref);
+  g_clear_pointer (&ns->dead_lnw, g_array_unref);
+  g_clear_pointer (&ns->pending, g_ptr_array_unref);
+
+  if (ns->mp != NULL)
+  {
+    ncm_memory_pool_free (ns->mp, TRUE);
+    ns->mp = NULL;
+  }
+
+  /* Chain up : end */
+  G_OBJECT_CLASS (ncm_fit_ns_parent_class)->dispose (object);
+}
+
+static void
+ncm_fit_ns_finalize (GObject *object)
+{
+  /* Chain up : end */
+  G_OBJECT_CLASS (ncm_fit_ns_parent_class)->finalize (object);
+}
+
+static void
+ncm_fit_ns_class_init (NcmFitNSClass *klass)
+{
+  GObjectClass* object_class = G_OBJECT_CLASS (klass);
+
+  object_class->constructed  = &_ncm_fit_ns_constructed;
+  object_class->set_property = &ncm_fit_ns_set_property;
+  object_class->get_property = &ncm_fit_ns_get_property;
+  object_class->dispose      = &ncm_fit_ns_dispose;
+  object_class->finalize     = &ncm_fit_ns_finalize;
+
+  g_object_class_install_property (object_class,
+                                   PROP_FIT,
+                                   g_param_spec_object ("fit",
+                                                        NULL,
+                                                        "Fit object",
+                                                        NCM_TYPE_FIT,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_NLIVE,
+                                   g_param_spec_uint ("nlive",
+                                                      NULL,
+                                                      "Number of live points",
+                                                      2, G_MAXUINT32, 500,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_MTYPE,
+                                   g_param_spec_enum ("mtype",
+                                                      NULL,
+                                                      "Run messages type",
+                                                      NCM_TYPE_FIT_RUN_MSGS, NCM_FIT_RUN_MSGS_SIMPLE,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_NTHREADS,
+                                   g_param_spec_uint ("nthreads",
+                                                      NULL,
+                                                      "Number of threads to run",
+                                                      0, G_MAXUINT32, 0,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_DATA_FILE,
+                                   g_param_spec_string ("data-file",
+                                                        NULL,
+                                                        "Data filename",
+                                                        NULL,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_ENLARGE,
+                                   g_param_spec_double ("enlarge",
+                                                        NULL,
+                                                        "Volume enlargement factor of the bounding ellipsoid",
+                                                        1.0, G_MAXDOUBLE, 1.25,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_DLNZ_TOL,
+                                   g_param_spec_double ("dlnZ-tol",
+                                                        NULL,
+                                                        "Tolerance on the remaining evidence",
+                                                        0.0, G_MAXDOUBLE, 1.0e-2,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+}
+
+typedef struct _NcmFitNSWorker
+{
+  NcmFit *fit;
+  NcmRNG *rng;
+  NcmVector *u;
+  NcmVector *theta;
+} NcmFitNSWorker;
+
+static gpointer
+_ncm_fit_ns_worker_dup (gpointer userdata)
+{
+  G_LOCK_DEFINE_STATIC (dup_thread);
+  NcmFitNS *ns = NCM_FIT_NS (userdata);
+
+  G_LOCK (dup_thread);
+  {
+    NcmFitNSWorker *fw = g_new (NcmFitNSWorker, 1);
+
+    fw->fit    = ncm_fit_dup (ns->fit, ns->ser);
+    fw->rng    = ncm_rng_new (NULL);
+    fw->u      = ncm_vector_new (ns->fparam_len);
+    fw->theta  = ncm_vector_new (ns->fparam_len);
+
+    ncm_rng_set_seed (fw->rng, gsl_rng_get (ns->mcat->rng->r));
+
+    ncm_serialize_reset (ns->ser);
+
+    G_UNLOCK (dup_thread);
+
+    return fw;
+  }
+}
+
+static void
+_ncm_fit_ns_worker_free (gpointer userdata)
+{
+  NcmFitNSWorker *fw = (NcmFitNSWorker *) userdata;
+
+  ncm_fit_clear (&fw->fit);
+  ncm_rng_clear (&fw->rng);
+  ncm_vector_clear (&fw->u);
+  ncm_vector_clear (&fw->theta);
+
+  g_free (fw);
+}
+
+static void
+_ncm_fit_ns_set_fit_obj (NcmFitNS *ns, NcmFit *fit)
+{
+  g_assert (ns->fit == NULL);
+  ns->fit = ncm_fit_ref (fit);
+}
+
+/**
+ * ncm_fit_ns_new:
+ * @fit: a #NcmFit
+ * @nlive: number of live points
+ * @mtype: a #NcmFitRunMsgs
+ *
+ * Creates a new nested sampler for the likelihood and model set of @fit.
+ *
+ * Returns: (transfer full): a new #NcmFitNS.
+ */
+NcmFitNS *
+ncm_fit_ns_new (NcmFit *fit, guint nlive, NcmFitRunMsgs mtype)
+{
+  NcmFitNS *ns = g_object_new (NCM_TYPE_FIT_NS,
+                               "fit",   fit,
+                               "nlive", nlive,
+                               "mtype", mtype,
+                               NULL);
+  return ns;
+}
+
+/**
+ * ncm_fit_ns_free:
+ * @ns: a #NcmFitNS
+ *
+ * Decreases the reference count of @ns.
+ *
+ */
+void
+ncm_fit_ns_free (NcmFitNS *ns)
+{
+  g_object_unref (ns);
+}
+
+/**
+ * ncm_fit_ns_clear:
+ * @ns: a #NcmFitNS
+ *
+ * Decreases the reference count of *@ns and sets the pointer *@ns to NULL.
+ *
+ */
+void
+ncm_fit_ns_clear (NcmFitNS **ns)
+{
+  g_clear_object (ns);
+}
+
+/**
+ * ncm_fit_ns_set_data_file:
+ * @ns: a #NcmFitNS
+ * @filename: a filename.
+ *
+ * Sets the catalog file, if it already contains points the run is
+ * resumed from them by ncm_fit_ns_start_run().
+ *
+ */
+void
+ncm_fit_ns_set_data_file (NcmFitNS *ns, const gchar *filename)
+{
+  const gchar *cur_filename = ncm_mset_catalog_peek_filename (ns->mcat);
+
+  if (ns->started && cur_filename != NULL)
+    g_error ("ncm_fit_ns_set_data_file: Cannot change data file during a run, call ncm_fit_ns_end_run() first.");
+
+  if (cur_filename != NULL && strcmp (cur_filename, filename) == 0)
+    return;
+
+  ncm_mset_catalog_set_file (ns->mcat, filename);
+
+  if (ns->started)
+    g_assert_cmpint (ns->cur_sample_id, ==, ns->mcat->cur_id);
+}
+
+/**
+ * ncm_fit_ns_set_mtype:
+ * @ns: a #NcmFitNS
+ * @mtype: a #NcmFitRunMsgs
+ *
+ * Sets the verbosity of the run.
+ *
+ */
+void
+ncm_fit_ns_set_mtype (NcmFitNS *ns, NcmFitRunMsgs mtype)
+{
+  ns->mtype = mtype;
+}
+
+/**
+ * ncm_fit_ns_set_nthreads:
+ * @ns: a #NcmFitNS
+ * @nthreads: number of simultaneous live points replacements
+ *
+ * Sets the number of live points replaced at each iteration, each one
+ * computed in a different thread. When @nthreads is zero or one the
+ * sampler runs serially, replacing one point per iteration.
+ *
+ */
+void
+ncm_fit_ns_set_nthreads (NcmFitNS *ns, guint nthreads)
+{
+  ns->nthreads = nthreads;
+}
+
+/**
+ * ncm_fit_ns_set_rng:
+ * @ns: a #NcmFitNS
+ * @rng: a #NcmRNG
+ *
+ * Sets the random number generator, the generator of each thread is
+ * seeded from it.
+ *
+ */
+void
+ncm_fit_ns_set_rng (NcmFitNS *ns, NcmRNG *rng)
+{
+  if (ns->started)
+    g_error ("ncm_fit_ns_set_rng: Cannot change the RNG object during a run, call ncm_fit_ns_end_run() first.");
+
+  ncm_mset_catalog_set_rng (ns->mcat, rng);
+}
+
+/**
+ * ncm_fit_ns_set_enlarge:
+ * @ns: a #NcmFitNS
+ * @enlarge: volume enlargement factor $\geq 1$
+ *
+ * Sets the factor by which the volume of the bounding ellipsoid of the
+ * live points is enlarged before sampling new points.
+ *
+ */
+void
+ncm_fit_ns_set_enlarge (NcmFitNS *ns, gdouble enlarge)
+{
+  g_assert_cmpfloat (enlarge, >=, 1.0);
+  ns->enlarge = enlarge;
+}
+
+/**
+ * ncm_fit_ns_set_dlnZ_tol:
+ * @ns: a #NcmFitNS
+ * @dlnZ_tol: tolerance on the remaining evidence
+ *
+ * Sets the stopping criterion, see ncm_fit_ns_get_remaining_dlnZ().
+ *
+ */
+void
+ncm_fit_ns_set_dlnZ_tol (NcmFitNS *ns, gdouble dlnZ_tol)
+{
+  g_assert_cmpfloat (dlnZ_tol, >=, 0.0);
+  ns->dlnZ_tol = dlnZ_tol;
+}
+
+/**
+ * ncm_fit_ns_get_nlive:
+ * @ns: a #NcmFitNS
+ *
+ * Returns: the number of live points.
+ */
+guint
+ncm_fit_ns_get_nlive (NcmFitNS *ns)
+{
+  return ns->nlive;
+}
+
+/**
+ * ncm_fit_ns_get_enlarge:
+ * @ns: a #NcmFitNS
+ *
+ * Returns: the volume enlargement factor of the bounding ellipsoid.
+ */
+gdouble
+ncm_fit_ns_get_enlarge (NcmFitNS *ns)
+{
+  return ns->enlarge;
+}
+
+/**
+ * ncm_fit_ns_get_dlnZ_tol:
+ * @ns: a #NcmFitNS
+ *
+ * Returns: the tolerance on the remaining evidence.
+ */
+gdouble
+ncm_fit_ns_get_dlnZ_tol (NcmFitNS *ns)
+{
+  return ns->dlnZ_tol;
+}
+
+/**
+ * ncm_fit_ns_get_efficiency:
+ * @ns: a #NcmFitNS
+ *
+ * Returns: the fraction of likelihood evaluations that resulted in a new
+ * live point, including the points restored from the catalog.
+ */
+gdouble
+ncm_fit_ns_get_efficiency (NcmFitNS *ns)
+{
+  return ns->naccepted * 1.0 / (ns->ntotal * 1.0);
+}
+
+static guint
+_ncm_fit_ns_nbatch (NcmFitNS *ns)
+{
+  return GSL_MAX (ns->nthreads, 1);
+}
+
+static gdouble
+_ncm_fit_ns_logaddexp (const gdouble a, const gdouble b)
+{
+  if (a == GSL_NEGINF)
+    return b;
+  else if (b == GSL_NEGINF)
+    return a;
+  else
+    return GSL_MAX (a, b) + log1p (exp (- fabs (a - b)));
+}
+
+static void
+_ncm_fit_ns_accumulate (gdouble *lnZ, gdouble *H, const gdouble lnw, const gdouble lnL)
+{
+  const gdouble lnwL = lnw + lnL;
+
+  /* Points outside the support of the likelihood do not contribute. */
+  if (lnL == GSL_NEGINF)
+    return;
+  else
+  {
+    const gdouble lnZ_new = _ncm_fit_ns_logaddexp (*lnZ, lnwL);
+    const gdouble H_old   = (*lnZ == GSL_NEGINF) ? 0.0 : exp (*lnZ - lnZ_new) * (*H + *lnZ);
+
+    *H   = exp (lnwL - lnZ_new) * lnL + H_old - lnZ_new;
+    *lnZ = lnZ_new;
+  }
+}
+
+/**
+ * ncm_fit_ns_get_remaining_dlnZ:
+ * @ns: a #NcmFitNS
+ *
+ * Estimates the evidence contained in the live points as
+ * $L_\mathrm{max}X$, where $L_\mathrm{max}$ is the largest likelihood
+ * among the live points and $X$ the current prior volume, and returns the
+ * change it would cause in $\ln Z$. The run stops when it is smaller than
+ * #NcmFitNS:dlnZ-tol.
+ *
+ * Returns: the estimated remaining $\Delta\ln Z$.
+ */
+gdouble
+ncm_fit_ns_get_remaining_dlnZ (NcmFitNS *ns)
+{
+  if ((ns->live->len == 0) || (ns->lnZ == GSL_NEGINF))
+    return GSL_POSINF;
+  else
+  {
+    gdouble m2lnL_min = GSL_POSINF;
+    guint i;
+
+    for (i = 0; i < ns->live->len; i++)
+      m2lnL_min = GSL_MIN (m2lnL_min, g_array_index (ns->live_m2lnL, gdouble, i));
+
+    return log1p (exp (-0.5 * m2lnL_min + ns->lnX - ns->lnZ));
+  }
+}
+
+/**
+ * ncm_fit_ns_get_lnZ:
+ * @ns: a #NcmFitNS
+ * @lnZ: (out): the logarithm of the evidence
+ * @lnZ_err: (out): the uncertainty of @lnZ
+ *
+ * Computes the logarithm of the evidence, including the contribution of
+ * the current live points, each one weighted by $X/n_\mathrm{live}$.
+ * The uncertainty is estimated as $\sqrt{H/n_\mathrm{live}}$, where $H$
+ * is the information (Kullback-Leibler divergence from the prior to the
+ * posterior).
+ *
+ */
+void
+ncm_fit_ns_get_lnZ (NcmFitNS *ns, gdouble *lnZ, gdouble *lnZ_err)
+{
+  const gdouble lnw_live = ns->lnX - log (ns->live->len);
+  gdouble H = ns->H;
+  guint i;
+
+  *lnZ = ns->lnZ;
+  for (i = 0; i < ns->live->len; i++)
+    _ncm_fit_ns_accumulate (lnZ, &H, lnw_live, -0.5 * g_array_index (ns->live_m2lnL, gdouble, i));
+
+  *lnZ_err = (*lnZ == GSL_NEGINF) ? GSL_POSINF : sqrt (GSL_MAX (H, 0.0) / ns->nlive);
+}
+
+static void
+_ncm_fit_ns_draw_u (NcmFitNS *ns, NcmFitNSWorker *fw)
+{
+  const guint len = ns->fparam_len;
+  guint i;
+
+  if (ns->r <= 0.0)
+  {
+    for (i = 0; i < len; i++)
+      ncm_vector_set (fw->u, i, gsl_rng_uniform (fw->rng->r));
+    return;
+  }
+
+  while (TRUE)
+  {
+    gboolean inside = TRUE;
+    gdouble norm2   = 0.0;
+    gint ret;
+
+    for (i = 0; i < len; i++)
+    {
+      const gdouble z_i = gsl_ran_ugaussian (fw->rng->r);
+      ncm_vector_set (fw->u, i, z_i);
+      norm2 += z_i * z_i;
+    }
+
+    /* Uniform point in the ball of radius r, mapped to the ellipsoid. */
+    ncm_vector_scale (fw->u, ns->r * pow (gsl_rng_uniform (fw->rng->r), 1.0 / len) / sqrt (norm2));
+
+    ret = gsl_blas_dtrmv (CblasLower, CblasNoTrans, CblasNonUnit,
+                          ncm_matrix_gsl (ns->LLT), ncm_vector_gsl (fw->u));
+    NCM_TEST_GSL_RESULT ("_ncm_fit_ns_draw_u", ret);
+
+    ncm_vector_add (fw->u, ns->mu);
+
+    for (i = 0; i < len; i++)
+    {
+      const gdouble u_i = ncm_vector_get (fw->u, i);
+      if (u_i < 0.0 || u_i > 1.0)
+      {
+        inside = FALSE;
+        break;
+      }
+    }
+
+    if (inside)
+      break;
+  }
+}
+
+static void
+_ncm_fit_ns_mt_eval (glong i, glong f, gpointer data)
+{
+  NcmFitNS *ns            = NCM_FIT_NS (data);
+  NcmFitNSWorker **fw_ptr = ncm_memory_pool_get (ns->mp);
+  NcmFitNSWorker *fw      = *fw_ptr;
+  const gboolean initial  = (ns->niter == 0);
+  glong j;
+
+  for (j = i; j < f; j++)
+  {
+    NcmVector *row_j = g_ptr_array_index (ns->pending, j);
+    guint ntries     = 0;
+    gdouble m2lnL, tie;
+
+    while (TRUE)
+    {
+      guint n;
+
+      _ncm_fit_ns_draw_u (ns, fw);
+      tie = gsl_rng_uniform (fw->rng->r);
+
+      for (n = 0; n < ns->fparam_len; n++)
+      {
+        const gdouble lb_n = ncm_vector_get (ns->lb, n);
+        const gdouble ub_n = ncm_vector_get (ns->ub, n);
+
+        ncm_vector_set (fw->theta, n, lb_n + ncm_vector_get (fw->u, n) * (ub_n - lb_n));
+      }
+
+      ncm_mset_fparams_set_vector (fw->fit->mset, fw->theta);
+      ncm_fit_m2lnL_val (fw->fit, &m2lnL);
+      ntries++;
+
+      /* 
+       * The initial points are drawn from the prior, including the ones with zero likelihood.
+       * Equal likelihoods are ordered by the random tie-breaker, so the run also advances
+       * on a plateau.
+       */
+      if (initial ? !gsl_isnan (m2lnL) : ((m2lnL < ns->m2lnL_star) || ((m2lnL == ns->m2lnL_star) && (tie < ns->tie_star))))
+        break;
+    }
+
+    ncm_vector_set (row_j, NCM_FIT_NS_M2LNL_ID, m2lnL);
+    ncm_vector_set (row_j, NCM_FIT_NS_BIRTH_ID, ns->niter);
+    ncm_vector_set (row_j, NCM_FIT_NS_TIE_ID, tie);
+    ncm_vector_set (row_j, NCM_FIT_NS_NTRIES_ID, ntries);
+    ncm_mset_fparams_get_vector_offset (fw->fit->mset, row_j, NCM_FIT_NS_NADD_VALS);
+  }
+
+  ncm_memory_pool_return (fw_ptr);
+}
+
+/* Also restores the counters, so the efficiency includes the points read from the catalog. */
+static void
+_ncm_fit_ns_add_live (NcmFitNS *ns, const guint id)
+{
+  NcmVector *row      = ncm_mset_catalog_peek_row (ns->mcat, id);
+  const gdouble m2lnL = ncm_vector_get (row, NCM_FIT_NS_M2LNL_ID);
+  const gdouble tie   = ncm_vector_get (row, NCM_FIT_NS_TIE_ID);
+
+  g_array_append_val (ns->live, id);
+  g_array_append_val (ns->live_m2lnL, m2lnL);
+  g_array_append_val (ns->live_tie, tie);
+
+  ns->ntotal += (guint) ncm_vector_get (row, NCM_FIT_NS_NTRIES_ID);
+  ns->naccepted++;
+}
+
+static void
+_ncm_fit_ns_generate (NcmFitNS *ns, const guint n)
+{
+  guint i;
+
+  while (ns->pending->len < n)
+    g_ptr_array_add (ns->pending, ncm_vector_new (ns->fparam_len + NCM_FIT_NS_NADD_VALS));
+
+  if (ns->nthreads > 1)
+    ncm_func_eval_threaded_loop_full (&_ncm_fit_ns_mt_eval, 0, n, ns);
+  else
+    _ncm_fit_ns_mt_eval (0, n, ns);
+
+  /* The catalog is only written here, in a fixed order and with complete iterations. */
+  for (i = 0; i < n; i++)
+  {
+    ncm_mset_catalog_add_from_vector (ns->mcat, g_ptr_array_index (ns->pending, i));
+    ns->cur_sample_id++;
+
+    _ncm_fit_ns_add_live (ns, ns->cur_sample_id);
+  }
+  g_assert_cmpint (ns->cur_sample_id, ==, ns->mcat->cur_id);
+
+  ncm_mset_catalog_timed_sync (ns->mcat, FALSE);
+}
+
+/* Orders the live points by their likelihood and then by the tie-breaker. */
+static gint
+_ncm_fit_ns_live_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  NcmFitNS *ns           = NCM_FIT_NS (user_data);
+  const guint pa         = *(const gsize *) a;
+  const guint pb         = *(const gsize *) b;
+  const gdouble m2lnL_a  = g_array_index (ns->live_m2lnL, gdouble, pa);
+  const gdouble m2lnL_b  = g_array_index (ns->live_m2lnL, gdouble, pb);
+
+  if (m2lnL_a != m2lnL_b)
+    return (m2lnL_a < m2lnL_b) ? -1 : 1;
+  else
+  {
+    const gdouble tie_a = g_array_index (ns->live_tie, gdouble, pa);
+    const gdouble tie_b = g_array_index (ns->live_tie, gdouble, pb);
+
+    return (tie_a < tie_b) ? -1 : ((tie_a > tie_b) ? 1 : 0);
+  }
+}
+
+static void
+_ncm_fit_ns_kill (NcmFitNS *ns, const guint k)
+{
+  const guint nlive = ns->live->len;
+  gsize *perm       = g_new (gsize, nlive);
+  gboolean *killed  = g_new0 (gboolean, nlive);
+  guint j, l;
+
+  g_assert_cmpuint (k, <, nlive);
+
+  for (j = 0; j < nlive; j++)
+    perm[j] = j;
+  g_qsort_with_data (perm, nlive, sizeof (gsize), &_ncm_fit_ns_live_cmp, ns);
+
+  /* The worst points are at the end of perm, each removal shrinks X by exp (-1 / nlive_j). */
+  for (j = 0; j < k; j++)
+  {
+    const gsize p         = perm[nlive - 1 - j];
+    const gdouble m2lnL_p = g_array_index (ns->live_m2lnL, gdouble, p);
+    const gdouble lnX_new = ns->lnX - 1.0 / (nlive - j);
+    const gdouble lnw     = ns->lnX + log (-expm1 (lnX_new - ns->lnX));
+
+    _ncm_fit_ns_accumulate (&ns->lnZ, &ns->H, lnw, -0.5 * m2lnL_p);
+
+    g_array_append_val (ns->dead, g_array_index (ns->live, guint, p));
+    g_array_append_val (ns->dead_lnw, lnw);
+
+    ns->lnX        = lnX_new;
+    ns->m2lnL_star = m2lnL_p;
+    ns->tie_star   = g_array_index (ns->live_tie, gdouble, p);
+    killed[p]      = TRUE;
+  }
+
+  for (j = 0, l = 0; j < nlive; j++)
+  {
+    if (!killed[j])
+    {
+      g_array_index (ns->live, guint, l)        = g_array_index (ns->live, guint, j);
+      g_array_index (ns->live_m2lnL, gdouble, l) = g_array_index (ns->live_m2lnL, gdouble, j);
+      g_array_index (ns->live_tie, gdouble, l)   = g_array_index (ns->live_tie, gdouble, j);
+      l++;
+    }
+  }
+  g_array_set_size (ns->live, l);
+  g_array_set_size (ns->live_m2lnL, l);
+  g_array_set_size (ns->live_tie, l);
+
+  g_free (perm);
+  g_free (killed);
+}
+
+static void
+_ncm_fit_ns_get_u (NcmFitNS *ns, const guint id, NcmVector *u)
+{
+  NcmVector *row = ncm_mset_catalog_peek_row (ns->mcat, id);
+  guint n;
+
+  for (n = 0; n < ns->fparam_len; n++)
+  {
+    const gdouble lb_n = ncm_vector_get (ns->lb, n);
+    const gdouble ub_n = ncm_vector_get (ns->ub, n);
+
+    ncm_vector_set (u, n, (ncm_vector_get (row, n + NCM_FIT_NS_NADD_VALS) - lb_n) / (ub_n - lb_n));
+  }
+}
+
+static void
+_ncm_fit_ns_update_bound (NcmFitNS *ns)
+{
+  const guint len = ns->fparam_len;
+  const guint np  = ns->live->len;
+  gdouble r2      = 0.0;
+  gdouble lnV;
+  guint i, a, b;
+  gint ret;
+
+  ncm_vector_set_zero (ns->mu);
+  for (i = 0; i < np; i++)
+  {
+    _ncm_fit_ns_get_u (ns, g_array_index (ns->live, guint, i), ns->u);
+    ncm_vector_add (ns->mu, ns->u);
+  }
+  ncm_vector_scale (ns->mu, 1.0 / np);
+
+  ncm_matrix_set_zero (ns->LLT);
+  for (i = 0; i < np; i++)
+  {
+    _ncm_fit_ns_get_u (ns, g_array_index (ns->live, guint, i), ns->u);
+    ncm_vector_sub (ns->u, ns->mu);
+
+    for (a = 0; a < len; a++)
+    {
+      const gdouble u_a = ncm_vector_get (ns->u, a);
+      for (b = 0; b < len; b++)
+        ncm_matrix_addto (ns->LLT, a, b, u_a * ncm_vector_get (ns->u, b) / (np - 1.0));
+    }
+  }
+
+  ret = ncm_matrix_cholesky_decomp (ns->LLT, 'L');
+  if (ret != 0)
+  {
+    /* Degenerate live points, falls back to the whole hypercube. */
+    ns->r = 0.0;
+    return;
+  }
+
+  for (i = 0; i < np; i++)
+  {
+    gdouble d2 = 0.0;
+
+    _ncm_fit_ns_get_u (ns, g_array_index (ns->live, guint, i), ns->u);
+    ncm_vector_sub (ns->u, ns->mu);
+
+    ret = gsl_blas_dtrsv (CblasLower, CblasNoTrans, CblasNonUnit,
+                          ncm_matrix_gsl (ns->LLT), ncm_vector_gsl (ns->u));
+    NCM_TEST_GSL_RESULT ("_ncm_fit_ns_update_bound", ret);
+
+    ret = gsl_blas_ddot (ncm_vector_gsl (ns->u), ncm_vector_gsl (ns->u), &d2);
+    NCM_TEST_GSL_RESULT ("_ncm_fit_ns_update_bound", ret);
+
+    r2 = GSL_MAX (r2, d2);
+  }
+
+  ns->r = sqrt (r2) * pow (ns->enlarge, 1.0 / len);
+
+  /* When the ellipsoid is larger than the hypercube the latter is more efficient. */
+  lnV = 0.5 * len * M_LNPI - gsl_sf_lngamma (0.5 * len + 1.0) + len * log (ns->r);
+  for (a = 0; a < len; a++)
+    lnV += log (ncm_matrix_get (ns->LLT, a, a));
+
+  if (lnV >= 0.0)
+    ns->r = 0.0;
+}
+
+static void
+_ncm_fit_ns_replay (NcmFitNS *ns)
+{
+  const gint last = ns->mcat->cur_id;
+  gint i = ns->cur_sample_id + 1;
+
+  while (i <= last)
+  {
+    NcmVector *row    = ncm_mset_catalog_peek_row (ns->mcat, i);
+    const guint birth = ncm_vector_get (row, NCM_FIT_NS_BIRTH_ID);
+
+    g_assert (row != NULL);
+
+    if (birth == 0)
+    {
+      if ((ns->niter != 0) || (ns->live->len >= ns->nlive))
+        g_error ("_ncm_fit_ns_replay: inconsistent catalog, initial point %d found after %u live points and %u iterations.",
+                 i, ns->live->len, ns->niter);
+
+      _ncm_fit_ns_add_live (ns, i);
+      i++;
+    }
+    else
+    {
+      guint k = 0;
+
+      if ((birth != ns->niter + 1) || (ns->live->len != ns->nlive))
+        g_error ("_ncm_fit_ns_replay: inconsistent catalog, point %d created in the iteration %u after the iteration %u with %u live points.",
+                 i, birth, ns->niter, ns->live->len);
+
+      while ((i + k <= last) && (ncm_vector_get (ncm_mset_catalog_peek_row (ns->mcat, i + k), NCM_FIT_NS_BIRTH_ID) == birth))
+        k++;
+
+      _ncm_fit_ns_kill (ns, k);
+      ns->niter = birth;
+
+      for (; k > 0; k--, i++)
+        _ncm_fit_ns_add_live (ns, i);
+    }
+  }
+
+  ns->cur_sample_id = last;
+}
+
+/**
+ * ncm_fit_ns_start_run:
+ * @ns: a #NcmFitNS
+ *
+ * Prepares the run. If the catalog already contains points, the state of
+ * the sampler is reconstructed from them, otherwise the live points are
+ * drawn from the prior.
+ *
+ */
+void
+ncm_fit_ns_start_run (NcmFitNS *ns)
+{
+  guint n;
+
+  if (ns->started)
+    g_error ("ncm_fit_ns_start_run: run already started, run ncm_fit_ns_end_run() first.");
+
+  switch (ns->mtype)
+  {
+    default:
+    case NCM_FIT_RUN_MSGS_FULL:
+      ncm_cfg_msg_sepa ();
+      g_message ("# NcmFitNS: Starting Nested Sampling...\n");
+      ncm_dataset_log_info (ns->fit->lh->dset);
+      ncm_cfg_msg_sepa ();
+      g_message ("# NcmFitNS: Model set:\n");
+      ncm_mset_pretty_log (ns->fit->mset);
+      break;
+    case NCM_FIT_RUN_MSGS_SIMPLE:
+      break;
+    case NCM_FIT_RUN_MSGS_NONE:
+      break;
+  }
+
+  if (ns->nlive <= ns->fparam_len + _ncm_fit_ns_nbatch (ns) + 1)
+    g_error ("ncm_fit_ns_start_run: the number of live points (%u) must be larger than the number of free parameters (%u) plus the number of threads (%u) plus one.",
+             ns->nlive, ns->fparam_len, _ncm_fit_ns_nbatch (ns));
+
+  if (ns->mcat->rng == NULL)
+  {
+    NcmRNG *rng = ncm_rng_new (NULL);
+    ncm_rng_set_random_seed (rng, FALSE);
+    ncm_fit_ns_set_rng (ns, rng);
+    if (ns->mtype > NCM_FIT_RUN_MSGS_NONE)
+      g_message ("# NcmFitNS: No RNG was defined, using algorithm: `%s' and seed: %lu.\n",
+                 ncm_rng_get_algo (rng), ncm_rng_get_seed (rng));
+    ncm_rng_free (rng);
+  }
+
+  for (n = 0; n < ns->fparam_len; n++)
+  {
+    ncm_vector_set (ns->lb, n, ncm_mset_fparam_get_lower_bound (ns->fit->mset, n));
+    ncm_vector_set (ns->ub, n, ncm_mset_fparam_get_upper_bound (ns->fit->mset, n));
+  }
+
+  ns->started   = TRUE;
+  ns->ntotal    = 0;
+  ns->naccepted = 0;
+
+  /* Only complete iterations are written to the file, see _ncm_fit_ns_generate(). */
+  ncm_mset_catalog_set_sync_mode (ns->mcat, NCM_MSET_CATALOG_SYNC_DISABLE);
+  ncm_mset_catalog_set_sync_interval (ns->mcat, NCM_FIT_NS_MIN_SYNC_INTERVAL);
+
+  ncm_mset_catalog_sync (ns->mcat, TRUE);
+
+  if (ns->mcat->first_id > 0)
+    g_error ("ncm_fit_ns_start_run: cannot use catalogs with first_id > 0.");
+
+  if (ns->mcat->cur_id > ns->cur_sample_id)
+  {
+    if (ns->mtype > NCM_FIT_RUN_MSGS_NONE)
+    {
+      ncm_cfg_msg_sepa ();
+      g_message ("# NcmFitNS: Resuming from %d points in the catalog.\n", ns->mcat->cur_id - ns->cur_sample_id);
+    }
+    _ncm_fit_ns_replay (ns);
+  }
+  else if (ns->mcat->cur_id < ns->cur_sample_id)
+    g_error ("ncm_fit_ns_start_run: Unknown error cur_id < cur_sample_id [%d < %d].",
+             ns->mcat->cur_id, ns->cur_sample_id);
+
+  if (ns->live->len < ns->nlive)
+  {
+    if (ns->mtype > NCM_FIT_RUN_MSGS_NONE)
+      g_message ("# NcmFitNS: Drawing %u live points from the prior.\n", ns->nlive - ns->live->len);
+
+    ns->r = 0.0;
+    _ncm_fit_ns_generate (ns, ns->nlive - ns->live->len);
+  }
+}
+
+/**
+ * ncm_fit_ns_end_run:
+ * @ns: a #NcmFitNS
+ *
+ * Ends the run and synchronizes the catalog with its file.
+ *
+ */
+void
+ncm_fit_ns_end_run (NcmFitNS *ns)
+{
+  ncm_mset_catalog_sync (ns->mcat, TRUE);
+  ns->started = FALSE;
+}
+
+/**
+ * ncm_fit_ns_reset:
+ * @ns: a #NcmFitNS
+ *
+ * Discards all points and resets the catalog.
+ *
+ */
+void
+ncm_fit_ns_reset (NcmFitNS *ns)
+{
+  g_array_set_size (ns->live, 0);
+  g_array_set_size (ns->live_m2lnL, 0);
+  g_array_set_size (ns->live_tie, 0);
+  g_array_set_size (ns->dead, 0);
+  g_array_set_size (ns->dead_lnw, 0);
+
+  ns->r             = 0.0;
+  ns->m2lnL_star    = GSL_POSINF;
+  ns->tie_star      = 1.0;
+  ns->lnX           = 0.0;
+  ns->lnZ           = GSL_NEGINF;
+  ns->H             = 0.0;
+  ns->niter         = 0;
+  ns->ntotal        = 0;
+  ns->naccepted     = 0;
+  ns->cur_sample_id = -1;
+  ns->started       = FALSE;
+  ncm_mset_catalog_reset (ns->mcat);
+}
+
+static void
+_ncm_fit_ns_log_state (NcmFitNS *ns)
+{
+  gdouble lnZ, lnZ_err;
+
+  ncm_fit_ns_get_lnZ (ns, &lnZ, &lnZ_err);
+  g_message ("# NcmFitNS: iteration %6u, ln(X) = % 10.4f, ln(Z) = % 12.6g +/- %8.4g, remaining dln(Z) = %8.2e, efficiency %7.4f%%.\n",
+             ns->niter, ns->lnX, lnZ, lnZ_err, ncm_fit_ns_get_remaining_dlnZ (ns),
+             ncm_fit_ns_get_efficiency (ns) * 100.0);
+}
+
+/**
+ * ncm_fit_ns_run:
+ * @ns: a #NcmFitNS
+ * @niter: maximum number of iterations
+ *
+ * Runs the nested sampler until the stopping criterion is reached (see
+ * ncm_fit_ns_get_remaining_dlnZ()) or after @niter iterations, if @niter
+ * is zero there is no limit.
+ *
+ */
+void
+ncm_fit_ns_run (NcmFitNS *ns, guint niter)
+{
+  const guint nbatch    = _ncm_fit_ns_nbatch (ns);
+  const guint log_every = GSL_MAX (ns->nlive / nbatch, 1);
+  guint i = 0;
+
+  if (!ns->started)
+    g_error ("ncm_fit_ns_run: run not started, run ncm_fit_ns_start_run() first.");
+
+  if (ns->mtype > NCM_FIT_RUN_MSGS_NONE)
+  {
+    ncm_cfg_msg_sepa ();
+    g_message ("# NcmFitNS: Running Nested Sampling with %u live points, replacing %u points per iteration.\n",
+               ns->nlive, nbatch);
+  }
+
+  while ((niter == 0) || (i < niter))
+  {
+    if (ncm_fit_ns_get_remaining_dlnZ (ns) < ns->dlnZ_tol)
+      break;
+
+    _ncm_fit_ns_kill (ns, nbatch);
+    _ncm_fit_ns_update_bound (ns);
+
+    ns->niter++;
+    _ncm_fit_ns_generate (ns, nbatch);
+
+    if ((ns->mtype > NCM_FIT_RUN_MSGS_NONE) && (ns->niter % log_every == 0))
+      _ncm_fit_ns_log_state (ns);
+
+    i++;
+  }
+
+  ncm_mset_catalog_sync (ns->mcat, FALSE);
+
+  if (ns->mtype > NCM_FIT_RUN_MSGS_NONE)
+  {
+    gdouble lnZ, lnZ_err;
+
+    ncm_fit_ns_get_lnZ (ns, &lnZ, &lnZ_err);
+    ncm_cfg_msg_sepa ();
+    _ncm_fit_ns_log_state (ns);
+    g_message ("# NcmFitNS: ln(Z) = % 22.15g +/- % 22.15g.\n", lnZ, lnZ_err);
+  }
+}
+
+/**
+ * ncm_fit_ns_get_catalog:
+ * @ns: a #NcmFitNS
+ *
+ * Gets the catalog containing every point sampled, in the order they
+ * were created. These points are not distributed as the posterior,
+ * see ncm_fit_ns_get_posterior().
+ *
+ * Returns: (transfer full): the run #NcmMSetCatalog.
+ */
+NcmMSetCatalog *
+ncm_fit_ns_get_catalog (NcmFitNS *ns)
+{
+  return ncm_mset_catalog_ref (ns->mcat);
+}
+
+static void
+_ncm_fit_ns_add_posterior (NcmFitNS *ns, NcmMSetCatalog *post, NcmVector *prow, const guint id, const gdouble lnw, const gdouble lnZ)
+{
+  NcmVector *row      = ncm_mset_catalog_peek_row (ns->mcat, id);
+  const gdouble m2lnL = ncm_vector_get (row, NCM_FIT_NS_M2LNL_ID);
+  guint n;
+
+  ncm_vector_set (prow, 0, m2lnL);
+  ncm_vector_set (prow, 1, exp (lnw - 0.5 * m2lnL - lnZ));
+
+  for (n = 0; n < ns->fparam_len; n++)
+    ncm_vector_set (prow, n + 2, ncm_vector_get (row, n + NCM_FIT_NS_NADD_VALS));
+
+  ncm_mset_catalog_add_from_vector (post, prow);
+}
+
+/**
+ * ncm_fit_ns_get_posterior:
+ * @ns: a #NcmFitNS
+ *
+ * Creates a weighted catalog containing the removed points followed by the
+ * current live points, each one weighted by its posterior mass
+ * $w_iL_i/Z$. The live points are weighted as in ncm_fit_ns_get_lnZ().
+ * The catalog is created in memory, use ncm_mset_catalog_set_file() to
+ * save it.
+ *
+ * Returns: (transfer full): a new weighted #NcmMSetCatalog.
+ */
+NcmMSetCatalog *
+ncm_fit_ns_get_posterior (NcmFitNS *ns)
+{
+  NcmMSetCatalog *post = ncm_mset_catalog_new (ns->fit->mset, 1, 1, TRUE,
+                                               NCM_MSET_CATALOG_M2LNL_COLNAME, NCM_MSET_CATALOG_M2LNL_SYMBOL,
+                                               NULL);
+  NcmVector *prow        = ncm_vector_new (ns->fparam_len + 2);
+  const gdouble lnw_live = ns->lnX - log (ns->live->len);
+  gdouble lnZ, lnZ_err;
+  guint i;
+
+  ncm_mset_catalog_set_run_type (post, "Nested Sampling posterior");
+  ncm_fit_ns_get_lnZ (ns, &lnZ, &lnZ_err);
+
+  for (i = 0; i < ns->dead->len; i++)
+    _ncm_fit_ns_add_posterior (ns, post, prow, g_array_index (ns->dead, guint, i), g_array_index (ns->dead_lnw, gdouble, i), lnZ);
+
+  for (i = 0; i < ns->live->len; i++)
+    _ncm_fit_ns_add_posterior (ns, post, prow, g_array_index (ns->live, guint, i), lnw_live, lnZ);
+
+  ncm_vector_free (prow);
+
+  return post;
+}
@@ -0,0 +1,129 @@
+/***************************************************************************
+ *            ncm_fit_ns.h
+ *
+ *  Mon October 19 18:20:41 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_fit_ns.h
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _NCM_FIT_NS_H_
+#define _NCM_FIT_NS_H_
+
+#include <glib.h>
+#include <glib-object.h>
+#include <numcosmo/build_cfg.h>
+#include <numcosmo/math/ncm_fit.h>
+#include <numcosmo/math/ncm_mset_catalog.h>
+#include <numcosmo/math/memory_pool.h>
+
+G_BEGIN_DECLS
+
+#define NCM_TYPE_FIT_NS             (ncm_fit_ns_get_type ())
+#define NCM_FIT_NS(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), NCM_TYPE_FIT_NS, NcmFitNS))
+#define NCM_FIT_NS_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), NCM_TYPE_FIT_NS, NcmFitNSClass))
+#define NCM_IS_FIT_NS(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), NCM_TYPE_FIT_NS))
+#define NCM_IS_FIT_NS_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), NCM_TYPE_FIT_NS))
+#define NCM_FIT_NS_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), NCM_TYPE_FIT_NS, NcmFitNSClass))
+
+typedef struct _NcmFitNSClass NcmFitNSClass;
+typedef struct _NcmFitNS NcmFitNS;
+
+struct _NcmFitNSClass
+{
+  /*< private >*/
+  GObjectClass parent_class;
+};
+
+struct _NcmFitNS
+{
+  /*< private >*/
+  GObject parent_instance;
+  NcmFit *fit;
+  NcmMemoryPool *mp;
+  NcmMSetCatalog *mcat;
+  NcmFitRunMsgs mtype;
+  NcmSerialize *ser;
+  GArray *live;
+  GArray *live_m2lnL;
+  GArray *live_tie;
+  GArray *dead;
+  GArray *dead_lnw;
+  GPtrArray *pending;
+  NcmVector *lb;
+  NcmVector *ub;
+  NcmVector *mu;
+  NcmMatrix *LLT;
+  NcmVector *u;
+  gdouble r;
+  gdouble m2lnL_star;
+  gdouble tie_star;
+  gdouble enlarge;
+  gdouble dlnZ_tol;
+  gdouble lnX;
+  gdouble lnZ;
+  gdouble H;
+  guint fparam_len;
+  guint nlive;
+  guint nthreads;
+  guint niter;
+  guint ntotal;
+  guint naccepted;
+  gint cur_sample_id;
+  gboolean started;
+};
+
+GType ncm_fit_ns_get_type (void) G_GNUC_CONST;
+
+NcmFitNS *ncm_fit_ns_new (NcmFit *fit, guint nlive, NcmFitRunMsgs mtype);
+void ncm_fit_ns_free (NcmFitNS *ns);
+void ncm_fit_ns_clear (NcmFitNS **ns);
+
+void ncm_fit_ns_set_data_file (NcmFitNS *ns, const gchar *filename);
+void ncm_fit_ns_set_mtype (NcmFitNS *ns, NcmFitRunMsgs mtype);
+void ncm_fit_ns_set_nthreads (NcmFitNS *ns, guint nthreads);
+void ncm_fit_ns_set_rng (NcmFitNS *ns, NcmRNG *rng);
+void ncm_fit_ns_set_enlarge (NcmFitNS *ns, gdouble enlarge);
+void ncm_fit_ns_set_dlnZ_tol (NcmFitNS *ns, gdouble dlnZ_tol);
+
+guint ncm_fit_ns_get_nlive (NcmFitNS *ns);
+gdouble ncm_fit_ns_get_enlarge (NcmFitNS *ns);
+gdouble ncm_fit_ns_get_dlnZ_tol (NcmFitNS *ns);
+gdouble ncm_fit_ns_get_efficiency (NcmFitNS *ns);
+gdouble ncm_fit_ns_get_remaining_dlnZ (NcmFitNS *ns);
+void ncm_fit_ns_get_lnZ (NcmFitNS *ns, gdouble *lnZ, gdouble *lnZ_err);
+
+void ncm_fit_ns_start_run (NcmFitNS *ns);
+void ncm_fit_ns_end_run (NcmFitNS *ns);
+void ncm_fit_ns_reset (NcmFitNS *ns);
+void ncm_fit_ns_run (NcmFitNS *ns, guint niter);
+
+NcmMSetCatalog *ncm_fit_ns_get_catalog (NcmFitNS *ns);
+NcmMSetCatalog *ncm_fit_ns_get_posterior (NcmFitNS *ns);
+
+#define NCM_FIT_NS_MIN_SYNC_INTERVAL (10.0)
+#define NCM_FIT_NS_M2LNL_ID (0)
+#define NCM_FIT_NS_BIRTH_ID (1)
+#define NCM_FIT_NS_TIE_ID (2)
+#define NCM_FIT_NS_NTRIES_ID (3)
+#define NCM_FIT_NS_NADD_VALS (4)
+
+G_END_DECLS
+
+#endif /* _NCM_FIT_NS_H_ */
@@ -0,0 +1,1306 @@
+/***************************************************************************
+ *            ncm_fit_pt.c
+ *
+ *  Mon October 19 22:07:52 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_fit_pt.c
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:ncm_fit_pt
+ * @title: NcmFitPT
+ * @short_description: Parallel tempering (replica exchange) Markov Chain Monte Carlo.
+ *
+ * Parallel tempering sampler for multimodal posteriors. The object runs
+ * #NcmFitPT:nreplicas Metropolis-Hastings chains, the replica $k$ samples the
+ * tempered distribution $\pi(\theta)L(\theta)^{\beta_k}$, where $\pi$ is
+ * the prior, given by the parameter bounds and the #NcmLikelihood priors,
+ * and $L$ is the likelihood of the #NcmDataset. Only $L$ is tempered, 
+ * and $1 = \beta_0 > \beta_1
+ * > \dots > \beta_{K-1} = 1/T_\mathrm{max}$. The hot replicas move freely
+ * between the modes and pass their states down the ladder through swaps
+ * between neighbouring temperatures.
+ *
+ * Each replica moves #NcmFitPT:nsweep times using the #NcmMSetTransKern.
+ * When it is a #NcmMSetTransKernGauss the Gaussian steps are enlarged by
+ * $\beta_k^{-1/2}$ (at most #NCM_FIT_PT_MAX_STEP_SCALE) and drawn without
+ * truncation, the proposals outside the bounds being rejected, so that
+ * the proposal remains symmetric. Other kernels are used as they are. When #NcmFitPT:nthreads is larger than one
+ * the replicas are evolved concurrently, each one using its own copy of the
+ * #NcmFit. After each sweep, swaps are proposed alternately between the
+ * even and the odd neighbouring pairs.
+ *
+ * During the first #NcmFitPT:nadapt swap rounds the interior of the ladder
+ * is adapted to equalize the swap acceptance probabilities, following
+ * [Vousden et al. (2016)][XVousden2016]. Only the $\beta = 1$ chain is added
+ * to the #NcmMSetCatalog.
+ *
+ * After the adaptation, the mean of $\ln L$ at each temperature is
+ * accumulated and the evidence is obtained by thermodynamic integration,
+ * $\ln Z = \int_0^1 \langle\ln L\rangle_\beta \mathrm{d}\beta$, see
+ * ncm_fit_pt_get_lnZ().
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif /* HAVE_CONFIG_H */
+#include "build_cfg.h"
+
+#include "math/ncm_fit_pt.h"
+#include "math/ncm_cfg.h"
+#include "math/ncm_func_eval.h"
+#include "math/ncm_mset_trans_kern_gauss.h"
+#include "ncm_enum_types.h"
+
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_blas.h>
+
+enum
+{
+  PROP_0,
+  PROP_FIT,
+  PROP_SAMPLER,
+  PROP_NREPLICAS,
+  PROP_MTYPE,
+  PROP_NTHREADS,
+  PROP_TMAX,
+  PROP_NSWEEP,
+  PROP_NADAPT,
+  PROP_DATA_FILE,
+};
+
+G_DEFINE_TYPE (NcmFitPT, ncm_fit_pt, G_TYPE_OBJECT);
+
+typedef struct _NcmFitPTReplica
+{
+  NcmRNG *rng;
+  NcmVector *theta;
+  NcmVector *thetastar;
+  NcmVector *cur;
+  gdouble m2lnP;
+  guint naccepted;
+  guint ntotal;
+} NcmFitPTReplica;
+
+static NcmFitPTReplica *
+_ncm_fit_pt_replica_new (guint fparam_len, NcmRNG *rng)
+{
+  NcmFitPTReplica *rep = g_new0 (NcmFitPTReplica, 1);
+
+  rep->rng       = ncm_rng_ref (rng);
+  rep->theta     = ncm_vector_new (fparam_len);
+  rep->thetastar = ncm_vector_new (fparam_len);
+  rep->cur       = ncm_vector_new (fparam_len + 1);
+
+  return rep;
+}
+
+static void
+_ncm_fit_pt_replica_free (gpointer data)
+{
+  NcmFitPTReplica *rep = data;
+
+  ncm_rng_free (rep->rng);
+  ncm_vector_free (rep->theta);
+  ncm_vector_free (rep->thetastar);
+  ncm_vector_free (rep->cur);
+
+  g_free (rep);
+}
+
+static void
+ncm_fit_pt_init (NcmFitPT *pt)
+{
+  pt->fit           = NULL;
+  pt->mcat          = NULL;
+  pt->mtype         = NCM_FIT_RUN_MSGS_NONE;
+  pt->nt            = ncm_timer_new ();
+  pt->ser           = ncm_serialize_new (NCM_SERIALIZE_OPT_CLEAN_DUP);
+  pt->tkern         = NULL;
+  pt->mp            = NULL;
+  pt->replicas      = g_ptr_array_new_with_free_func (&_ncm_fit_pt_replica_free);
+  pt->rows          = g_ptr_array_new_with_free_func ((GDestroyNotify) &ncm_vector_free);
+  pt->beta          = NULL;
+  pt->lngap         = NULL;
+  pt->swap_alpha    = NULL;
+  pt->lnL_stats     = NULL;
+  pt->swap_accepted = g_array_new (FALSE, TRUE, sizeof (guint));
+  pt->swap_total    = g_array_new (FALSE, TRUE, sizeof (guint));
+  pt->Tmax          = 0.0;
+  pt->nreplicas     = 0;
+  pt->nthreads      = 0;
+  pt->nsweep        = 0;
+  pt->nadapt        = 0;
+  pt->nrounds       = 0;
+  pt->n             = 0;
+  pt->cur_sample_id = -1; /* Represents that no samples were calculated yet. */
+  pt->started       = FALSE;
+  g_mutex_init (&pt->dup_fit);
+}
+
+static void
+_ncm_fit_pt_constructed (GObject *object)
+{
+  /* Chain up : start */
+  G_OBJECT_CLASS (ncm_fit_pt_parent_class)->constructed (object);
+  {
+    NcmFitPT *pt = NCM_FIT_PT (object);
+
+    pt->mcat = ncm_mset_catalog_new (pt->fit->mset, 1, 1, FALSE,
+                                     NCM_MSET_CATALOG_M2LNL_COLNAME, NCM_MSET_CATALOG_M2LNL_SYMBOL,
+                                     NULL);
+    ncm_mset_catalog_set_run_type (pt->mcat, "Parallel tempering");
+    ncm_mset_trans_kern_set_mset (pt->tkern, pt->fit->mset);
+
+    pt->beta       = ncm_vector_new (pt->nreplicas);
+    pt->lngap      = ncm_vector_new (pt->nreplicas - 1);
+    pt->swap_alpha = ncm_vector_new (pt->nreplicas - 1);
+
+    g_array_set_size (pt->swap_accepted, pt->nreplicas - 1);
+    g_array_set_size (pt->swap_total, pt->nreplicas - 1);
+  }
+}
+
+static void
+ncm_fit_pt_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+  NcmFitPT *pt = NCM_FIT_PT (object);
+  g_return_if_fail (NCM_IS_FIT_PT (object));
+
+  switch (prop_id)
+  {
+    case PROP_FIT:
+      g_assert (pt->fit == NULL);
+      pt->fit = g_value_dup_object (value);
+      break;
+    case PROP_SAMPLER:
+      g_assert (pt->tkern == NULL);
+      pt->tkern = g_value_dup_object (value);
+      break;
+    case PROP_NREPLICAS:
+      pt->nreplicas = g_value_get_uint (value);
+      break;
+    case PROP_MTYPE:
+      ncm_fit_pt_set_mtype (pt, g_value_get_enum (value));
+      break;
+    case PROP_NTHREADS:
+      ncm_fit_pt_set_nthreads (pt, g_value_get_uint (value));
+      break;
+    case PROP_TMAX:
+      ncm_fit_pt_set_Tmax (pt, g_value_get_double (value));
+      break;
+    case PROP_NSWEEP:
+      ncm_fit_pt_set_nsweep (pt, g_value_get_uint (value));
+      break;
+    case PROP_NADAPT:
+      ncm_fit_pt_set_nadapt (pt, g_value_get_uint (value));
+      break;
+    case PROP_DATA_FILE:
+      ncm_fit_pt_set_data_file (pt, g_value_get_string (value));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+ncm_fit_pt_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+  NcmFitPT *pt = NCM_FIT_PT (object);
+  g_return_if_fail (NCM_IS_FIT_PT (object));
+
+  switch (prop_id)
+  {
+    case PROP_FIT:
+      g_value_set_object (value, pt->fit);
+      break;
+    case PROP_SAMPLER:
+      g_value_set_object (value, pt->tkern);
+      break;
+    case PROP_NREPLICAS:
+      g_value_set_uint (value, pt->nreplicas);
+      break;
+    case PROP_MTYPE:
+      g_value_set_enum (value, pt->mtype);
+      break;
+    case PROP_NTHREADS:
+      g_value_set_uint (value, pt->nthreads);
+      break;
+    case PROP_TMAX:
+      g_value_set_double (value, pt->Tmax);
+      break;
+    case PROP_NSWEEP:
+      g_value_set_uint (value, pt->nsweep);
+      break;
+    case PROP_NADAPT:
+      g_value_set_uint (value, pt->nadapt);
+      break;
+    case PROP_DATA_FILE:
+      g_value_set_string (value, ncm_mset_catalog_peek_filename (pt->mcat));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+ncm_fit_pt_dispose (GObject *object)
+{
+  NcmFitPT *pt = NCM_FIT_PT (object);
+
+  ncm_fit_clear (&pt->fit);
+  ncm_mset_catalog_clear (&pt->mcat);
+  ncm_timer_clear (&pt->nt);
+  ncm_serialize_clear (&pt->ser);
+  ncm_mset_trans_kern_clear (&pt->tkern);
+
+  ncm_vector_clear (&pt->beta);
+  ncm_vector_clear (&pt->lngap);
+  ncm_vector_clear (&pt->swap_alpha);
+  ncm_stats_vec_clear (&pt->lnL_stats);
+
+  g_clear_pointer (&pt->replicas, g_ptr_array_unref);
+  g_clear_pointer (&pt->rows, g_ptr_array_unref);
+  g_clear_pointer (&pt->swap_accepted, g_array_unref);
+  g_clear_pointer (&pt->swap_total, g_array_unref);
+
+  if (pt->mp != NULL)
+  {
+    ncm_memory_pool_free (pt->mp, TRUE);
+    pt->mp = NULL;
+  }
+
+  /* Chain up : end */
+  G_OBJECT_CLASS (ncm_fit_pt_parent_class)->dispose (object);
+}
+
+static void
+ncm_fit_pt_finalize (GObject *object)
+{
+  NcmFitPT *pt = NCM_FIT_PT (object);
+
+  g_mutex_clear (&pt->dup_fit);
+
+  /* Chain up : end */
+  G_OBJECT_CLASS (ncm_fit_pt_parent_class)->finalize (object);
+}
+
+static void
+ncm_fit_pt_class_init (NcmFitPTClass *klass)
+{
+  GObjectClass* object_class = G_OBJECT_CLASS (klass);
+
+  object_class->constructed  = &_ncm_fit_pt_constructed;
+  object_class->set_property = &ncm_fit_pt_set_property;
+  object_class->get_property = &ncm_fit_pt_get_property;
+  object_class->dispose      = &ncm_fit_pt_dispose;
+  object_class->finalize     = &ncm_fit_pt_finalize;
+
+  g_object_class_install_property (object_class,
+                                   PROP_FIT,
+                                   g_param_spec_object ("fit",
+                                                        NULL,
+                                                        "Fit object",
+                                                        NCM_TYPE_FIT,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_SAMPLER,
+                                   g_param_spec_object ("sampler",
+                                                        NULL,
+                                                        "Transition kernel object",
+                                                        NCM_TYPE_MSET_TRANS_KERN,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_NREPLICAS,
+                                   g_param_spec_uint ("nreplicas",
+                                                      NULL,
+                                                      "Number of tempered replicas",
+                                                      2, G_MAXUINT32, 8,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_MTYPE,
+                                   g_param_spec_enum ("mtype",
+                                                      NULL,
+                                                      "Run messages type",
+                                                      NCM_TYPE_FIT_RUN_MSGS, NCM_FIT_RUN_MSGS_SIMPLE,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_NTHREADS,
+                                   g_param_spec_uint ("nthreads",
+                                                      NULL,
+                                                      "Number of threads to run",
+                                                      0, 100, 0,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_TMAX,
+                                   g_param_spec_double ("Tmax",
+                                                        NULL,
+                                                        "Temperature of the hottest replica",
+                                                        1.0, G_MAXDOUBLE, 1.0e3,
+                                                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_NSWEEP,
+                                   g_param_spec_uint ("nsweep",
+                                                      NULL,
+                                                      "Number of steps of each replica between swaps",
+                                                      1, G_MAXUINT32, 10,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_NADAPT,
+                                   g_param_spec_uint ("nadapt",
+                                                      NULL,
+                                                      "Number of swap rounds with ladder adaptation",
+                                                      0, G_MAXUINT32, 1000,
+                                                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_DATA_FILE,
+                                   g_param_spec_string ("data-file",
+                                                        NULL,
+                                                        "Data filename",
+                                                        NULL,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+}
+
+/**
+ * ncm_fit_pt_new:
+ * @fit: a #NcmFit
+ * @tkern: a #NcmMSetTransKern
+ * @nreplicas: number of replicas $K \geq 2$
+ * @mtype: a #NcmFitRunMsgs
+ *
+ * Creates a new parallel tempering sampler with @nreplicas replicas
+ * moved by @tkern.
+ *
+ * Returns: (transfer full): a new #NcmFitPT.
+ */
+NcmFitPT *
+ncm_fit_pt_new (NcmFit *fit, NcmMSetTransKern *tkern, guint nreplicas, NcmFitRunMsgs mtype)
+{
+  NcmFitPT *pt = g_object_new (NCM_TYPE_FIT_PT,
+                               "fit",       fit,
+                               "sampler",   tkern,
+                               "nreplicas", nreplicas,
+                               "mtype",     mtype,
+                               NULL);
+  return pt;
+}
+
+/**
+ * ncm_fit_pt_free:
+ * @pt: a #NcmFitPT
+ *
+ * Decreases the reference count of @pt.
+ *
+ */
+void
+ncm_fit_pt_free (NcmFitPT *pt)
+{
+  g_object_unref (pt);
+}
+
+/**
+ * ncm_fit_pt_clear:
+ * @pt: a #NcmFitPT
+ *
+ * Decreases the reference count of *@pt and sets the pointer *@pt to NULL.
+ *
+ */
+void
+ncm_fit_pt_clear (NcmFitPT **pt)
+{
+  g_clear_object (pt);
+}
+
+/**
+ * ncm_fit_pt_set_data_file:
+ * @pt: a #NcmFitPT
+ * @filename: a filename.
+ *
+ * Sets the catalog file. If it already contains samples all replicas start
+ * from the last one.
+ *
+ */
+void
+ncm_fit_pt_set_data_file (NcmFitPT *pt, const gchar *filename)
+{
+  const gchar *cur_filename = ncm_mset_catalog_peek_filename (pt->mcat);
+
+  if (pt->started && cur_filename != NULL)
+    g_error ("ncm_fit_pt_set_data_file: Cannot change data file during a run, call ncm_fit_pt_end_run() first.");
+
+  if (cur_filename != NULL && strcmp (cur_filename, filename) == 0)
+    return;
+
+  ncm_mset_catalog_set_file (pt->mcat, filename);
+
+  if (pt->started)
+    g_assert_cmpint (pt->cur_sample_id, ==, pt->mcat->cur_id);
+}
+
+/**
+ * ncm_fit_pt_set_mtype:
+ * @pt: a #NcmFitPT
+ * @mtype: a #NcmFitRunMsgs
+ *
+ * Sets the verbosity of the run.
+ *
+ */
+void
+ncm_fit_pt_set_mtype (NcmFitPT *pt, NcmFitRunMsgs mtype)
+{
+  pt->mtype = mtype;
+}
+
+/**
+ * ncm_fit_pt_set_rng:
+ * @pt: a #NcmFitPT
+ * @rng: a #NcmRNG
+ *
+ * Sets the random number generator, the generators of each replica are
+ * seeded from it.
+ *
+ */
+void
+ncm_fit_pt_set_rng (NcmFitPT *pt, NcmRNG *rng)
+{
+  if (pt->started)
+    g_error ("ncm_fit_pt_set_rng: Cannot change the RNG object during a run, call ncm_fit_pt_end_run() first.");
+
+  ncm_mset_catalog_set_rng (pt->mcat, rng);
+}
+
+/**
+ * ncm_fit_pt_set_nthreads:
+ * @pt: a #NcmFitPT
+ * @nthreads: number of threads
+ *
+ * Sets the number of threads. When @nthreads is larger than one the
+ * replicas are evolved concurrently.
+ *
+ */
+void
+ncm_fit_pt_set_nthreads (NcmFitPT *pt, guint nthreads)
+{
+  pt->nthreads = nthreads;
+}
+
+/**
+ * ncm_fit_pt_set_Tmax:
+ * @pt: a #NcmFitPT
+ * @Tmax: temperature of the hottest replica
+ *
+ * Sets the temperature $T_\mathrm{max} = 1 / \beta_{K-1}$ of the hottest
+ * replica, it should be large enough to flatten the barriers between the
+ * modes. The initial ladder is geometric.
+ *
+ */
+void
+ncm_fit_pt_set_Tmax (NcmFitPT *pt, gdouble Tmax)
+{
+  if (pt->started)
+    g_error ("ncm_fit_pt_set_Tmax: Cannot change the temperature ladder during a run, call ncm_fit_pt_end_run() first.");
+
+  g_assert_cmpfloat (Tmax, >=, 1.0);
+  pt->Tmax = Tmax;
+}
+
+/**
+ * ncm_fit_pt_set_nsweep:
+ * @pt: a #NcmFitPT
+ * @nsweep: number of steps between swaps
+ *
+ * Sets the number of Metropolis-Hastings steps done by each replica
+ * between two swap rounds.
+ *
+ */
+void
+ncm_fit_pt_set_nsweep (NcmFitPT *pt, guint nsweep)
+{
+  g_assert_cmpuint (nsweep, >, 0);
+  pt->nsweep = nsweep;
+}
+
+/**
+ * ncm_fit_pt_set_nadapt:
+ * @pt: a #NcmFitPT
+ * @nadapt: number of swap rounds
+ *
+ * Sets the number of swap rounds during which the temperature ladder is
+ * adapted. The thermodynamic integration uses only the rounds after
+ * the adaptation.
+ *
+ */
+void
+ncm_fit_pt_set_nadapt (NcmFitPT *pt, guint nadapt)
+{
+  if (pt->started)
+    g_error ("ncm_fit_pt_set_nadapt: Cannot change the adaptation during a run, call ncm_fit_pt_end_run() first.");
+
+  pt->nadapt = nadapt;
+}
+
+/**
+ * ncm_fit_pt_get_nreplicas:
+ * @pt: a #NcmFitPT
+ *
+ * Returns: the number of replicas.
+ */
+guint
+ncm_fit_pt_get_nreplicas (NcmFitPT *pt)
+{
+  return pt->nreplicas;
+}
+
+/**
+ * ncm_fit_pt_get_Tmax:
+ * @pt: a #NcmFitPT
+ *
+ * Returns: the temperature of the hottest replica.
+ */
+gdouble
+ncm_fit_pt_get_Tmax (NcmFitPT *pt)
+{
+  return pt->Tmax;
+}
+
+/**
+ * ncm_fit_pt_get_nsweep:
+ * @pt: a #NcmFitPT
+ *
+ * Returns: the number of steps between swaps.
+ */
+guint
+ncm_fit_pt_get_nsweep (NcmFitPT *pt)
+{
+  return pt->nsweep;
+}
+
+/**
+ * ncm_fit_pt_get_nadapt:
+ * @pt: a #NcmFitPT
+ *
+ * Returns: the number of swap rounds with ladder adaptation.
+ */
+guint
+ncm_fit_pt_get_nadapt (NcmFitPT *pt)
+{
+  return pt->nadapt;
+}
+
+/**
+ * ncm_fit_pt_get_beta:
+ * @pt: a #NcmFitPT
+ *
+ * Gets the current inverse temperatures $\beta_k$, in decreasing order.
+ *
+ * Returns: (transfer full): a copy of the inverse temperature ladder.
+ */
+NcmVector *
+ncm_fit_pt_get_beta (NcmFitPT *pt)
+{
+  return ncm_vector_dup (pt->beta);
+}
+
+/**
+ * ncm_fit_pt_get_accept_ratio:
+ * @pt: a #NcmFitPT
+ * @k: replica index
+ *
+ * Returns: the acceptance ratio of the Metropolis-Hastings steps done at
+ * the temperature $\beta_k$ in the current run.
+ */
+gdouble
+ncm_fit_pt_get_accept_ratio (NcmFitPT *pt, guint k)
+{
+  NcmFitPTReplica *rep;
+
+  g_assert_cmpuint (k, <, pt->replicas->len);
+  rep = g_ptr_array_index (pt->replicas, k);
+
+  if (rep->ntotal == 0)
+    return 0.0;
+  else
+    return rep->naccepted / (rep->ntotal * 1.0);
+}
+
+/**
+ * ncm_fit_pt_get_swap_ratio:
+ * @pt: a #NcmFitPT
+ * @k: pair index $k < K - 1$
+ *
+ * Returns: the fraction of accepted swaps between the temperatures
+ * $\beta_k$ and $\beta_{k+1}$ in the current run, zero before the first
+ * swap attempt.
+ */
+gdouble
+ncm_fit_pt_get_swap_ratio (NcmFitPT *pt, guint k)
+{
+  guint swap_total;
+
+  g_assert_cmpuint (k, <, pt->nreplicas - 1);
+  swap_total = g_array_index (pt->swap_total, guint, k);
+
+  if (swap_total == 0)
+    return 0.0;
+  else
+    return g_array_index (pt->swap_accepted, guint, k) / (swap_total * 1.0);
+}
+
+/*
+ * Trapezoidal rule using every @step-th temperature, the weight of each
+ * temperature is also added to @w when it is not NULL.
+ */
+static gdouble
+_ncm_fit_pt_ti (NcmFitPT *pt, guint step, gdouble *w)
+{
+  const guint K  = pt->nreplicas;
+  gdouble beta_a = ncm_vector_get (pt->beta, 0);
+  gdouble E_a    = ncm_stats_vec_get_mean (pt->lnL_stats, 0);
+  gdouble lnZ    = 0.0;
+  guint k        = 0;
+
+  while (k + 1 < K)
+  {
+    const guint kb       = GSL_MIN (k + step, K - 1);
+    const gdouble beta_b = ncm_vector_get (pt->beta, kb);
+    const gdouble E_b    = ncm_stats_vec_get_mean (pt->lnL_stats, kb);
+
+    lnZ += 0.5 * (beta_a - beta_b) * (E_a + E_b);
+    if (w != NULL)
+    {
+      w[k]  += 0.5 * (beta_a - beta_b);
+      w[kb] += 0.5 * (beta_a - beta_b);
+    }
+
+    beta_a = beta_b;
+    E_a    = E_b;
+    k      = kb;
+  }
+
+  /* Between zero and the hottest replica the mean is taken as constant. */
+  lnZ += beta_a * E_a;
+  if (w != NULL)
+    w[k] += beta_a;
+
+  return lnZ;
+}
+
+/**
+ * ncm_fit_pt_get_lnZ:
+ * @pt: a #NcmFitPT
+ * @lnZ: (out): the evidence logarithm
+ * @lnZ_err: (out): the estimated error on @lnZ
+ *
+ * Computes the evidence by thermodynamic integration of the means
+ * $\langle\ln L\rangle_{\beta_k}$ accumulated after the ladder adaptation,
+ * using the trapezoidal rule. The error combines in quadrature the 
+ * discretization error, estimated comparing with the same rule applied to
+ * every other temperature, and the Monte Carlo error of the means, 
+ * $\sigma^2 = \sum_k w_k^2\tau_k\mathrm{Var}_k(\ln L)/n$, where $w_k$ are
+ * the trapezoidal weights, $n$ the number of swap rounds and $\tau_k$ the
+ * integrated autocorrelation time of $\ln L$ at each temperature (taken as
+ * one when NumCosmo is compiled without FFTW).
+ *
+ * The evidence is computed with respect to the prior defined by the
+ * likelihood priors and the parameter bounds, without the normalization
+ * of the flat prior volume.
+ *
+ */
+void
+ncm_fit_pt_get_lnZ (NcmFitPT *pt, gdouble *lnZ, gdouble *lnZ_err)
+{
+  const guint K = pt->nreplicas;
+  gdouble *w    = g_new0 (gdouble, K);
+  gdouble n, disc_err, mc_var = 0.0;
+  guint k;
+
+  if ((pt->lnL_stats == NULL) || (ncm_stats_vec_get_weight (pt->lnL_stats) < 2.0))
+    g_error ("ncm_fit_pt_get_lnZ: not enough swap rounds after the ladder adaptation.");
+
+  n        = ncm_stats_vec_get_weight (pt->lnL_stats);
+  lnZ[0]   = _ncm_fit_pt_ti (pt, 1, w);
+  disc_err = lnZ[0] - _ncm_fit_pt_ti (pt, 2, NULL);
+
+  for (k = 0; k < K; k++)
+  {
+#ifdef NUMCOSMO_HAVE_FFTW3
+    const gdouble tau_k = GSL_MAX (ncm_stats_vec_get_autocorr_tau (pt->lnL_stats, k, 0, 0.0), 1.0);
+#else
+    const gdouble tau_k = 1.0;
+#endif /* NUMCOSMO_HAVE_FFTW3 */
+
+    mc_var += w[k] * w[k] * tau_k * ncm_stats_vec_get_var (pt->lnL_stats, k) / n;
+  }
+
+  lnZ_err[0] = sqrt (disc_err * disc_err + mc_var);
+
+  g_free (w);
+}
+
+static void
+_ncm_fit_pt_set_ladder (NcmFitPT *pt)
+{
+  const guint K        = pt->nreplicas;
+  const gdouble lnTmax = log (pt->Tmax);
+  gdouble norm         = 0.0;
+  gdouble cum          = 0.0;
+  guint k;
+
+  /* ln T_k = ln T_max * sum_{i < k} e^{S_i} / sum_i e^{S_i}, keeping both ends fixed. */
+  for (k = 0; k < K - 1; k++)
+    norm += exp (ncm_vector_get (pt->lngap, k));
+
+  ncm_vector_set (pt->beta, 0, 1.0);
+  for (k = 1; k < K; k++)
+  {
+    cum += exp (ncm_vector_get (pt->lngap, k - 1));
+    ncm_vector_set (pt->beta, k, exp (-lnTmax * cum / norm));
+  }
+}
+
+static gpointer
+_ncm_fit_pt_dup_fit (gpointer userdata)
+{
+  NcmFitPT *pt = NCM_FIT_PT (userdata);
+  g_mutex_lock (&pt->dup_fit);
+  {
+    NcmFit *fit = ncm_fit_dup (pt->fit, pt->ser);
+    ncm_serialize_clear_instances (pt->ser);
+    g_mutex_unlock (&pt->dup_fit);
+    return fit;
+  }
+}
+
+static void
+_ncm_fit_pt_replicas_init_eval (glong i, glong f, gpointer data)
+{
+  NcmFitPT *pt     = NCM_FIT_PT (data);
+  NcmFit **fit_ptr = ncm_memory_pool_get (pt->mp);
+  NcmFit *fit      = *fit_ptr;
+  glong k;
+
+  for (k = i; k < f; k++)
+  {
+    NcmFitPTReplica *rep = g_ptr_array_index (pt->replicas, k);
+    gdouble *m2lnL       = ncm_vector_ptr (rep->cur, 0);
+
+    ncm_mset_fparams_get_vector (pt->fit->mset, rep->theta);
+
+    do
+    {
+      if (k > 0)
+        ncm_mset_trans_kern_generate (pt->tkern, rep->theta, rep->thetastar, rep->rng);
+      else
+        ncm_vector_memcpy (rep->thetastar, rep->theta);
+
+      ncm_mset_fparams_set_vector (fit->mset, rep->thetastar);
+      ncm_fit_m2lnL_val (fit, m2lnL);
+
+      if ((k == 0) && !gsl_finite (m2lnL[0]))
+        g_error ("_ncm_fit_pt_replicas_init_eval: the likelihood is not finite at the initial point.");
+
+    } while (!gsl_finite (m2lnL[0]));
+
+    ncm_likelihood_priors_m2lnL_val (fit->lh, fit->mset, &rep->m2lnP);
+
+    ncm_mset_fparams_get_vector_offset (fit->mset, rep->cur, 1);
+  }
+
+  ncm_memory_pool_return (fit_ptr);
+}
+
+static void
+_ncm_fit_pt_replicas_init (NcmFitPT *pt)
+{
+  const guint fparam_len = ncm_mset_fparam_len (pt->fit->mset);
+  const guint len        = ncm_mset_catalog_len (pt->mcat);
+  guint k;
+
+  g_ptr_array_set_size (pt->replicas, 0);
+
+  if (pt->mp != NULL)
+    ncm_memory_pool_free (pt->mp, TRUE);
+  pt->mp = ncm_memory_pool_new (&_ncm_fit_pt_dup_fit, pt,
+                                (GDestroyNotify) &ncm_fit_free);
+
+  /* Each replica has its own RNG seeded from the catalog RNG. */
+  ncm_rng_lock (pt->mcat->rng);
+  for (k = 0; k < pt->nreplicas; k++)
+  {
+    NcmRNG *rng = ncm_rng_seeded_new (ncm_rng_get_algo (pt->mcat->rng), gsl_rng_get (pt->mcat->rng->r));
+
+    g_ptr_array_add (pt->replicas, _ncm_fit_pt_replica_new (fparam_len, rng));
+    ncm_rng_free (rng);
+  }
+  ncm_rng_unlock (pt->mcat->rng);
+
+  if (len > 0)
+  {
+    NcmVector *cur_row = ncm_mset_catalog_peek_row (pt->mcat, len - 1);
+    g_assert (cur_row != NULL);
+
+    gdouble m2lnP;
+
+    ncm_mset_fparams_set_vector_offset (pt->fit->mset, cur_row, 1);
+    ncm_likelihood_priors_m2lnL_val (pt->fit->lh, pt->fit->mset, &m2lnP);
+
+    /* Only the beta = 1 chain is saved, the other replicas restart from its last point. */
+    for (k = 0; k < pt->nreplicas; k++)
+    {
+      NcmFitPTReplica *rep = g_ptr_array_index (pt->replicas, k);
+      ncm_vector_memcpy (rep->cur, cur_row);
+      rep->m2lnP = m2lnP;
+    }
+  }
+  else if (pt->nthreads > 1)
+    ncm_func_eval_threaded_loop_full (&_ncm_fit_pt_replicas_init_eval, 0, pt->nreplicas, pt);
+  else
+    _ncm_fit_pt_replicas_init_eval (0, pt->nreplicas, pt);
+}
+
+/**
+ * ncm_fit_pt_start_run:
+ * @pt: a #NcmFitPT
+ *
+ * Prepares the replicas and the temperature ladder. The ladder starts
+ * geometric between one and #NcmFitPT:Tmax.
+ *
+ */
+void
+ncm_fit_pt_start_run (NcmFitPT *pt)
+{
+  if (pt->started)
+    g_error ("ncm_fit_pt_start_run: run already started, run ncm_fit_pt_end_run() first.");
+
+  switch (pt->mtype)
+  {
+    default:
+    case NCM_FIT_RUN_MSGS_FULL:
+      ncm_cfg_msg_sepa ();
+      g_message ("# NcmFitPT: Starting parallel tempering Markov Chain Monte Carlo...\n");
+      ncm_dataset_log_info (pt->fit->lh->dset);
+      ncm_cfg_msg_sepa ();
+      g_message ("# NcmFitPT: Model set:\n");
+      ncm_mset_pretty_log (pt->fit->mset);
+      break;
+    case NCM_FIT_RUN_MSGS_SIMPLE:
+      break;
+    case NCM_FIT_RUN_MSGS_NONE:
+      break;
+  }
+
+  if (pt->mcat->rng == NULL)
+  {
+    NcmRNG *rng = ncm_rng_new (NULL);
+    ncm_rng_set_random_seed (rng, FALSE);
+    ncm_fit_pt_set_rng (pt, rng);
+    if (pt->mtype > NCM_FIT_RUN_MSGS_NONE)
+      g_message ("# NcmFitPT: No RNG was defined, using algorithm: `%s' and seed: %lu.\n",
+                 ncm_rng_get_algo (rng), ncm_rng_get_seed (rng));
+    ncm_rng_free (rng);
+  }
+
+  pt->started = TRUE;
+  pt->nrounds = 0;
+
+  ncm_mset_catalog_set_sync_mode (pt->mcat, NCM_MSET_CATALOG_SYNC_TIMED);
+  ncm_mset_catalog_set_sync_interval (pt->mcat, NCM_FIT_PT_MIN_SYNC_INTERVAL);
+  ncm_mset_catalog_sync (pt->mcat, TRUE);
+
+  if (pt->mcat->first_id > 0)
+    g_error ("ncm_fit_pt_start_run: cannot use catalogs with first_id > 0.");
+
+  if (pt->mcat->cur_id < pt->cur_sample_id)
+    g_error ("ncm_fit_pt_start_run: Unknown error cur_id < cur_sample_id [%d < %d].",
+             pt->mcat->cur_id, pt->cur_sample_id);
+  else if ((pt->mcat->cur_id > pt->cur_sample_id) && (pt->mtype > NCM_FIT_RUN_MSGS_NONE))
+  {
+    ncm_cfg_msg_sepa ();
+    g_message ("# NcmFitPT: Continuing the chain from the point %d.\n", pt->mcat->cur_id + 1);
+  }
+  pt->cur_sample_id = pt->mcat->cur_id;
+
+  ncm_vector_set_zero (pt->lngap);
+  ncm_vector_set_zero (pt->swap_alpha);
+  _ncm_fit_pt_set_ladder (pt);
+
+  memset (pt->swap_accepted->data, 0, sizeof (guint) * pt->swap_accepted->len);
+  memset (pt->swap_total->data, 0, sizeof (guint) * pt->swap_total->len);
+
+  ncm_stats_vec_clear (&pt->lnL_stats);
+  /* The values are kept to estimate their autocorrelation, see ncm_fit_pt_get_lnZ(). */
+  pt->lnL_stats = ncm_stats_vec_new (pt->nreplicas, NCM_STATS_VEC_VAR, TRUE);
+
+  _ncm_fit_pt_replicas_init (pt);
+}
+
+/**
+ * ncm_fit_pt_end_run:
+ * @pt: a #NcmFitPT
+ *
+ * Ends the run and synchronizes the catalog with its file.
+ *
+ */
+void
+ncm_fit_pt_end_run (NcmFitPT *pt)
+{
+  if (ncm_timer_task_is_running (pt->nt))
+    ncm_timer_task_end (pt->nt);
+
+  if (pt->mp != NULL)
+  {
+    ncm_memory_pool_free (pt->mp, TRUE);
+    pt->mp = NULL;
+  }
+
+  ncm_mset_catalog_sync (pt->mcat, TRUE);
+  pt->started = FALSE;
+}
+
+/**
+ * ncm_fit_pt_reset:
+ * @pt: a #NcmFitPT
+ *
+ * Discards all samples and resets the catalog.
+ *
+ */
+void
+ncm_fit_pt_reset (NcmFitPT *pt)
+{
+  pt->n             = 0;
+  pt->nrounds       = 0;
+  pt->cur_sample_id = -1;
+  pt->started       = FALSE;
+  ncm_mset_catalog_reset (pt->mcat);
+}
+
+typedef struct _NcmFitPTSweep
+{
+  NcmFitPT *pt;
+  guint nsteps;
+} NcmFitPTSweep;
+
+/*
+ * Gaussian step enlarged by @scale and not truncated at the bounds, which
+ * keeps the proposal symmetric.
+ */
+static void
+_ncm_fit_pt_gauss_generate (NcmMSetTransKernGauss *tkerng, NcmFitPTReplica *rep, const gdouble scale)
+{
+  const guint len = ncm_vector_len (rep->theta);
+  gint ret;
+  guint i;
+
+  ncm_rng_lock (rep->rng);
+  for (i = 0; i < len; i++)
+    ncm_vector_set (rep->thetastar, i, gsl_ran_ugaussian (rep->rng->r));
+  ncm_rng_unlock (rep->rng);
+
+  ret = gsl_blas_dtrmv (CblasLower, CblasNoTrans, CblasNonUnit,
+                        ncm_matrix_gsl (tkerng->LLT), ncm_vector_gsl (rep->thetastar));
+  NCM_TEST_GSL_RESULT ("_ncm_fit_pt_gauss_generate", ret);
+
+  ncm_vector_scale (rep->thetastar, scale);
+  ncm_vector_add (rep->thetastar, rep->theta);
+}
+
+static void
+_ncm_fit_pt_sweep_eval (glong i, glong f, gpointer data)
+{
+  NcmFitPTSweep *sweep = (NcmFitPTSweep *) data;
+  NcmFitPT *pt         = sweep->pt;
+  NcmFit **fit_ptr     = ncm_memory_pool_get (pt->mp);
+  NcmFit *fit          = *fit_ptr;
+  const gboolean gauss = NCM_IS_MSET_TRANS_KERN_GAUSS (pt->tkern);
+  glong k;
+
+  for (k = i; k < f; k++)
+  {
+    NcmFitPTReplica *rep = g_ptr_array_index (pt->replicas, k);
+    const gdouble beta   = ncm_vector_get (pt->beta, k);
+    const gdouble scale  = GSL_MIN (1.0 / sqrt (beta), NCM_FIT_PT_MAX_STEP_SCALE);
+    gdouble m2lnL_cur    = ncm_vector_get (rep->cur, NCM_FIT_PT_M2LNL_ID);
+    guint s;
+
+    /* The fit object is shared by the replicas evolved in this thread, so the state is restored first. */
+    ncm_mset_fparams_set_vector_offset (fit->mset, rep->cur, 1);
+    ncm_mset_fparams_get_vector (fit->mset, rep->theta);
+
+    for (s = 0; s < sweep->nsteps; s++)
+    {
+      if (gauss)
+        _ncm_fit_pt_gauss_generate (NCM_MSET_TRANS_KERN_GAUSS (pt->tkern), rep, scale);
+      else
+        ncm_mset_trans_kern_generate (pt->tkern, rep->theta, rep->thetastar, rep->rng);
+      rep->ntotal++;
+
+      if (ncm_mset_fparam_valid_bounds (fit->mset, rep->thetastar))
+      {
+        gdouble m2lnL_star, m2lnP_star;
+
+        ncm_mset_fparams_set_vector (fit->mset, rep->thetastar);
+        ncm_fit_m2lnL_val (fit, &m2lnL_star);
+        ncm_likelihood_priors_m2lnL_val (fit->lh, fit->mset, &m2lnP_star);
+
+        /* Only the data part -2lnL - (-2ln(prior)) is tempered. */
+        if (gsl_finite (m2lnL_star) &&
+            (log (gsl_rng_uniform_pos (rep->rng->r)) < 
+             -0.5 * (beta * ((m2lnL_star - m2lnP_star) - (m2lnL_cur - rep->m2lnP)) + (m2lnP_star - rep->m2lnP))))
+        {
+          ncm_vector_memcpy (rep->theta, rep->thetastar);
+          m2lnL_cur  = m2lnL_star;
+          rep->m2lnP = m2lnP_star;
+          rep->naccepted++;
+        }
+      }
+
+      if (k == 0)
+      {
+        NcmVector *row_s = g_ptr_array_index (pt->rows, s);
+
+        ncm_vector_set (row_s, NCM_FIT_PT_M2LNL_ID, m2lnL_cur);
+        ncm_vector_memcpy2 (row_s, rep->theta, 1, 0, ncm_vector_len (rep->theta));
+      }
+    }
+
+    ncm_vector_set (rep->cur, NCM_FIT_PT_M2LNL_ID, m2lnL_cur);
+    ncm_vector_memcpy2 (rep->cur, rep->theta, 1, 0, ncm_vector_len (rep->theta));
+  }
+
+  ncm_memory_pool_return (fit_ptr);
+}
+
+static void
+_ncm_fit_pt_swap (NcmFitPT *pt)
+{
+  const guint K  = pt->nreplicas;
+  NcmRNG *rng    = pt->mcat->rng;
+  guint i;
+
+  /* Even and odd pairs alternate, which makes the replicas travel the ladder faster than random pairs. */
+  for (i = 1 + (pt->nrounds % 2); i < K; i += 2)
+  {
+    NcmFitPTReplica *rep_a = g_ptr_array_index (pt->replicas, i - 1);
+    NcmFitPTReplica *rep_b = g_ptr_array_index (pt->replicas, i);
+    const gdouble dbeta    = ncm_vector_get (pt->beta, i - 1) - ncm_vector_get (pt->beta, i);
+    const gdouble dm2lnL   = (ncm_vector_get (rep_a->cur, NCM_FIT_PT_M2LNL_ID) - rep_a->m2lnP) - 
+                             (ncm_vector_get (rep_b->cur, NCM_FIT_PT_M2LNL_ID) - rep_b->m2lnP);
+    const gdouble alpha    = GSL_MIN (1.0, exp (0.5 * dbeta * dm2lnL));
+
+    ncm_vector_set (pt->swap_alpha, i - 1, alpha);
+    g_array_index (pt->swap_total, guint, i - 1)++;
+
+    if (gsl_rng_uniform (rng->r) < alpha)
+    {
+      NcmVector *tmp      = rep_a->cur;
+      const gdouble m2lnP = rep_a->m2lnP;
+
+      rep_a->cur   = rep_b->cur;
+      rep_b->cur   = tmp;
+      rep_a->m2lnP = rep_b->m2lnP;
+      rep_b->m2lnP = m2lnP;
+      g_array_index (pt->swap_accepted, guint, i - 1)++;
+    }
+  }
+
+  if ((pt->nrounds < pt->nadapt) && (K > 2))
+  {
+    const gdouble nu    = 100.0;
+    const gdouble t0    = 1000.0;
+    const gdouble kappa = t0 / (nu * (pt->nrounds + t0));
+
+    /* A high swap probability means that the temperatures are too close, their gap is increased. */
+    for (i = 1 + (pt->nrounds % 2); i < K; i += 2)
+      ncm_vector_addto (pt->lngap, i - 1, kappa * ncm_vector_get (pt->swap_alpha, i - 1));
+
+    _ncm_fit_pt_set_ladder (pt);
+  }
+  else
+  {
+    guint k;
+
+    for (k = 0; k < K; k++)
+    {
+      NcmFitPTReplica *rep = g_ptr_array_index (pt->replicas, k);
+      ncm_stats_vec_set (pt->lnL_stats, k, -0.5 * (ncm_vector_get (rep->cur, NCM_FIT_PT_M2LNL_ID) - rep->m2lnP));
+    }
+    ncm_stats_vec_update (pt->lnL_stats);
+  }
+
+  pt->nrounds++;
+}
+
+static void
+_ncm_fit_pt_log_ladder (NcmFitPT *pt)
+{
+  const guint K = pt->nreplicas;
+  guint k;
+
+  ncm_vector_log_vals (pt->beta, "# NcmFitPT:beta:       ", "% 8.5g");
+  g_message ("# NcmFitPT:swap ratio: ");
+  for (k = 0; k < K - 1; k++)
+    g_message (" % 8.5g", ncm_fit_pt_get_swap_ratio (pt, k));
+  g_message ("\n");
+
+  if (ncm_stats_vec_get_weight (pt->lnL_stats) >= 2.0)
+  {
+    gdouble lnZ, lnZ_err;
+    ncm_fit_pt_get_lnZ (pt, &lnZ, &lnZ_err);
+    g_message ("# NcmFitPT:thermodynamic integration lnZ = % 12.8g +/- %8.5g.\n", lnZ, lnZ_err);
+  }
+}
+
+static void
+_ncm_fit_pt_update (NcmFitPT *pt, NcmVector *row)
+{
+  const guint part = 5;
+  const guint step = (pt->n / part) == 0 ? 1 : (pt->n / part);
+
+  ncm_mset_catalog_add_from_vector (pt->mcat, row);
+  pt->cur_sample_id++;
+  ncm_timer_task_increment (pt->nt);
+
+  switch (pt->mtype)
+  {
+    case NCM_FIT_RUN_MSGS_NONE:
+      break;
+    case NCM_FIT_RUN_MSGS_SIMPLE:
+    {
+      guint stepi = pt->nt->task_pos % step;
+      gboolean log_timeout = FALSE;
+      if ((pt->nt->pos_time - pt->nt->last_log_time) > 60.0)
+        log_timeout = TRUE;
+      if (log_timeout || (stepi == 0) || (pt->nt->task_pos == pt->nt->task_len))
+      {
+        ncm_mset_catalog_log_current_stats (pt->mcat);
+        g_message ("# NcmFitPT:acceptance ratio %7.4f%%.\n", ncm_fit_pt_get_accept_ratio (pt, 0) * 100.0);
+        _ncm_fit_pt_log_ladder (pt);
+        ncm_timer_task_log_elapsed (pt->nt);
+        ncm_timer_task_log_mean_time (pt->nt);
+        ncm_timer_task_log_time_left (pt->nt);
+        ncm_timer_task_log_end_datetime (pt->nt);
+      }
+      break;
+    }
+    default:
+    case NCM_FIT_RUN_MSGS_FULL:
+      ncm_mset_fparams_set_vector_offset (pt->fit->mset, row, 1);
+      ncm_fit_state_set_m2lnL_curval (pt->fit->fstate, ncm_vector_get (row, NCM_FIT_PT_M2LNL_ID));
+      pt->fit->mtype = pt->mtype;
+      ncm_fit_log_state (pt->fit);
+      ncm_mset_catalog_log_current_stats (pt->mcat);
+      g_message ("# NcmFitPT:acceptance ratio %7.4f%%.\n", ncm_fit_pt_get_accept_ratio (pt, 0) * 100.0);
+      _ncm_fit_pt_log_ladder (pt);
+      ncm_timer_task_log_elapsed (pt->nt);
+      ncm_timer_task_log_mean_time (pt->nt);
+      ncm_timer_task_log_time_left (pt->nt);
+      ncm_timer_task_log_end_datetime (pt->nt);
+      break;
+  }
+}
+
+/**
+ * ncm_fit_pt_run:
+ * @pt: a #NcmFitPT
+ * @n: total number of samples
+ *
+ * Runs the replicas until the catalog contains @n samples of the
+ * $\beta = 1$ chain.
+ *
+ */
+void
+ncm_fit_pt_run (NcmFitPT *pt, guint n)
+{
+  const guint fparam_len = ncm_mset_fparam_len (pt->fit->mset);
+  NcmFitPTSweep sweep    = {pt, 0};
+
+  if (!pt->started)
+    g_error ("ncm_fit_pt_run: run not started, run ncm_fit_pt_start_run() first.");
+
+  if (n <= (pt->cur_sample_id + 1))
+  {
+    if (pt->mtype > NCM_FIT_RUN_MSGS_NONE)
+    {
+      ncm_cfg_msg_sepa ();
+      g_message ("# NcmFitPT: Nothing to do, current sample number is %d\n", pt->cur_sample_id + 1);
+    }
+    return;
+  }
+
+  pt->n = n - (pt->cur_sample_id + 1);
+
+  if (pt->mtype > NCM_FIT_RUN_MSGS_NONE)
+  {
+    ncm_cfg_msg_sepa ();
+    g_message ("# NcmFitPT: Calculating [%06d] parallel tempering samples with %u replicas [%s]\n",
+               pt->n, pt->nreplicas, ncm_mset_trans_kern_get_name (pt->tkern));
+  }
+
+  if (ncm_timer_task_is_running (pt->nt))
+  {
+    ncm_timer_task_add_tasks (pt->nt, pt->n);
+    ncm_timer_task_continue (pt->nt);
+  }
+  else
+  {
+    ncm_timer_task_start (pt->nt, pt->n);
+    ncm_timer_set_name (pt->nt, "NcmFitPT");
+  }
+  if (pt->mtype > NCM_FIT_RUN_MSGS_NONE)
+    ncm_timer_task_log_start_datetime (pt->nt);
+
+  while (pt->cur_sample_id + 1 < n)
+  {
+    guint s;
+
+    sweep.nsteps = GSL_MIN (pt->nsweep, n - (pt->cur_sample_id + 1));
+    while (pt->rows->len < sweep.nsteps)
+      g_ptr_array_add (pt->rows, ncm_vector_new (fparam_len + 1));
+
+    if (pt->nthreads > 1)
+      ncm_func_eval_threaded_loop_full (&_ncm_fit_pt_sweep_eval, 0, pt->nreplicas, &sweep);
+    else
+      _ncm_fit_pt_sweep_eval (0, pt->nreplicas, &sweep);
+
+    _ncm_fit_pt_swap (pt);
+
+    for (s = 0; s < sweep.nsteps; s++)
+      _ncm_fit_pt_update (pt, g_ptr_array_index (pt->rows, s));
+  }
+
+  ncm_timer_task_pause (pt->nt);
+}
+
+/**
+ * ncm_fit_pt_get_catalog:
+ * @pt: a #NcmFitPT
+ *
+ * Gets the catalog containing the samples of the $\beta = 1$ chain.
+ *
+ * Returns: (transfer full): the #NcmMSetCatalog.
+ */
+NcmMSetCatalog *
+ncm_fit_pt_get_catalog (NcmFitPT *pt)
+{
+  return ncm_mset_catalog_ref (pt->mcat);
+}
@@ -0,0 +1,131 @@
+/***************************************************************************
+ *            ncm_fit_pt.h
+ *
+ *  Mon October 19 22:07:52 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_fit_pt.h
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _NCM_FIT_PT_H_
+#define _NCM_FIT_PT_H_
+
+#include <glib.h>
+#include <glib-object.h>
+#include <numcosmo/build_cfg.h>
+#include <numcosmo/math/ncm_fit.h>
+#include <numcosmo/math/ncm_mset_catalog.h>
+#include <numcosmo/math/ncm_mset_trans_kern.h>
+#include <numcosmo/math/ncm_stats_vec.h>
+#include <numcosmo/math/ncm_timer.h>
+#include <numcosmo/math/memory_pool.h>
+
+G_BEGIN_DECLS
+
+#define NCM_TYPE_FIT_PT             (ncm_fit_pt_get_type ())
+#define NCM_FIT_PT(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), NCM_TYPE_FIT_PT, NcmFitPT))
+#define NCM_FIT_PT_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), NCM_TYPE_FIT_PT, NcmFitPTClass))
+#define NCM_IS_FIT_PT(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), NCM_TYPE_FIT_PT))
+#define NCM_IS_FIT_PT_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), NCM_TYPE_FIT_PT))
+#define NCM_FIT_PT_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), NCM_TYPE_FIT_PT, NcmFitPTClass))
+
+typedef struct _NcmFitPTClass NcmFitPTClass;
+typedef struct _NcmFitPT NcmFitPT;
+
+struct _NcmFitPTClass
+{
+  /*< private >*/
+  GObjectClass parent_class;
+};
+
+struct _NcmFitPT
+{
+  /*< private >*/
+  GObject parent_instance;
+  NcmFit *fit;
+  NcmMSetCatalog *mcat;
+  NcmFitRunMsgs mtype;
+  NcmTimer *nt;
+  NcmSerialize *ser;
+  NcmMSetTransKern *tkern;
+  NcmMemoryPool *mp;
+  GPtrArray *replicas;
+  GPtrArray *rows;
+  NcmVector *beta;
+  NcmVector *lngap;
+  NcmVector *swap_alpha;
+  NcmStatsVec *lnL_stats;
+  GArray *swap_accepted;
+  GArray *swap_total;
+  gdouble Tmax;
+  guint nreplicas;
+  guint nthreads;
+  guint nsweep;
+  guint nadapt;
+  guint nrounds;
+  guint n;
+  gint cur_sample_id;
+  gboolean started;
+  GMutex dup_fit;
+};
+
+GType ncm_fit_pt_get_type (void) G_GNUC_CONST;
+
+NcmFitPT *ncm_fit_pt_new (NcmFit *fit, NcmMSetTransKern *tkern, guint nreplicas, NcmFitRunMsgs mtype);
+void ncm_fit_pt_free (NcmFitPT *pt);
+void ncm_fit_pt_clear (NcmFitPT **pt);
+
+void ncm_fit_pt_set_data_file (NcmFitPT *pt, const gchar *filename);
+void ncm_fit_pt_set_mtype (NcmFitPT *pt, NcmFitRunMsgs mtype);
+void ncm_fit_pt_set_rng (NcmFitPT *pt, NcmRNG *rng);
+void ncm_fit_pt_set_nthreads (NcmFitPT *pt, guint nthreads);
+void ncm_fit_pt_set_Tmax (NcmFitPT *pt, gdouble Tmax);
+void ncm_fit_pt_set_nsweep (NcmFitPT *pt, guint nsweep);
+void ncm_fit_pt_set_nadapt (NcmFitPT *pt, guint nadapt);
+
+guint ncm_fit_pt_get_nreplicas (NcmFitPT *pt);
+gdouble ncm_fit_pt_get_Tmax (NcmFitPT *pt);
+guint ncm_fit_pt_get_nsweep (NcmFitPT *pt);
+guint ncm_fit_pt_get_nadapt (NcmFitPT *pt);
+NcmVector *ncm_fit_pt_get_beta (NcmFitPT *pt);
+gdouble ncm_fit_pt_get_accept_ratio (NcmFitPT *pt, guint k);
+gdouble ncm_fit_pt_get_swap_ratio (NcmFitPT *pt, guint k);
+void ncm_fit_pt_get_lnZ (NcmFitPT *pt, gdouble *lnZ, gdouble *lnZ_err);
+
+void ncm_fit_pt_start_run (NcmFitPT *pt);
+void ncm_fit_pt_end_run (NcmFitPT *pt);
+void ncm_fit_pt_reset (NcmFitPT *pt);
+void ncm_fit_pt_run (NcmFitPT *pt, guint n);
+
+NcmMSetCatalog *ncm_fit_pt_get_catalog (NcmFitPT *pt);
+
+#define NCM_FIT_PT_MIN_SYNC_INTERVAL (10.0)
+#define NCM_FIT_PT_M2LNL_ID (0)
+
+/**
+ * NCM_FIT_PT_MAX_STEP_SCALE:
+ *
+ * Maximum factor applied to the steps of the transition kernel in the
+ * hottest replicas.
+ */
+#define NCM_FIT_PT_MAX_STEP_SCALE (10.0)
+
+G_END_DECLS
+
+#endif /* _NCM_FIT_PT_H_ */
@@ -28,7 +28,11 @@
  * @title: NcmLHRatio1d
  * @short_description: Likelihood ratio for one dimensional parameter analysis.
  *
- * FIXME
+ * This object computes the profile likelihood bounds of one parameter, see
+ * ncm_lh_ratio1d_find_bounds(). When #NcmLHRatio1d:nthreads is larger than
+ * one the lower and upper bounds are computed concurrently, each one with its
+ * own copy of the constrained #NcmFit and the same root finder as in the
+ * serial case.
  * 
  */
 
@@ -42,6 +46,7 @@
 #include "math/ncm_c.h"
 #include "math/ncm_cfg.h"
 #include "math/ncm_util.h"
+#include "math/ncm_func_eval.h"
 
 #include <gsl/gsl_cdf.h>
 #include <gsl/gsl_roots.h>
@@ -53,6 +58,7 @@ enum
   PROP_FIT,
   PROP_PI,
   PROP_CONSTRAINT,
+  PROP_NTHREADS,
   PROP_SIZE,
 };
 
@@ -69,6 +75,7 @@ ncm_lh_ratio1d_init (NcmLHRatio1d *lhr1d)
   lhr1d->chisquare   = 0.0;
   lhr1d->mtype       = NCM_FIT_RUN_MSGS_NONE;
   lhr1d->rtype       = NCM_LH_RATIO1D_ROOT_BRACKET;
+  lhr1d->nthreads    = 0;
 }
 
 static void
@@ -128,6 +135,9 @@ ncm_lh_ratio1d_set_property (GObject *object, guint prop_id, const GValue *value
     case PROP_CONSTRAINT:
       lhr1d->constraint = g_value_dup_object (value);
       break;
+    case PROP_NTHREADS:
+      ncm_lh_ratio1d_set_nthreads (lhr1d, g_value_get_uint (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -154,6 +164,9 @@ ncm_lh_ratio1d_get_property (GObject *object, guint prop_id, GValue *value, GPar
     case PROP_CONSTRAINT:
       g_value_set_object (value, lhr1d->constraint);
       break;
+    case PROP_NTHREADS:
+      g_value_set_uint (value, lhr1d->nthreads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -214,6 +227,13 @@ ncm_lh_ratio1d_class_init (NcmLHRatio1dClass *klass)
                                                         "Constraint",
                                                         NCM_TYPE_MSET_FUNC,
                                                         G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_NTHREADS,
+                                   g_param_spec_uint ("nthreads",
+                                                      NULL,
+                                                      "Number of threads to run",
+                                                      0, 100, 0,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
 }
 
 
@@ -289,6 +309,36 @@ ncm_lh_ratio1d_set_pindex (NcmLHRatio1d *lhr1d, NcmMSetPIndex *pi)
   lhr1d->bf = ncm_mset_param_get (lhr1d->fit->mset, pi->mid, pi->pid);
 }
 
+/**
+ * ncm_lh_ratio1d_set_nthreads:
+ * @lhr1d: a #NcmLHRatio1d
+ * @nthreads: number of threads
+ *
+ * Sets the number of threads used by ncm_lh_ratio1d_find_bounds(), when
+ * larger than one both bounds are computed concurrently. Each side then
+ * evaluates its #NcmDataset with half of the threads, see
+ * ncm_dataset_set_nthreads(), so that more than two threads are only
+ * useful when the datasets have independent #NcmData.
+ *
+ */
+void 
+ncm_lh_ratio1d_set_nthreads (NcmLHRatio1d *lhr1d, guint nthreads)
+{
+  lhr1d->nthreads = nthreads;
+}
+
+/**
+ * ncm_lh_ratio1d_get_nthreads:
+ * @lhr1d: a #NcmLHRatio1d
+ *
+ * Returns: the number of threads used by ncm_lh_ratio1d_find_bounds().
+ */
+guint 
+ncm_lh_ratio1d_get_nthreads (NcmLHRatio1d *lhr1d)
+{
+  return lhr1d->nthreads;
+}
+
 static gboolean _ncm_lh_ratio1d_log_dot = FALSE;
 
 static void
@@ -394,22 +444,39 @@ ncm_lh_ratio1d_log_finish (NcmLHRatio1d *lhr1d, gdouble pl, gdouble pu)
   }  
 }
 
+/*
+ * One side of the interval, the serial search uses the constrained fit in
+ * the #NcmLHRatio1d while the threaded search uses one copy per side.
+ */
+typedef struct _NcmLHRatio1dSide
+{
+  NcmLHRatio1d *lhr1d;
+  NcmFit *constrained;
+  gboolean log;
+  gdouble x0;
+  gdouble root;
+  guint niter;
+  guint func_eval;
+  guint grad_eval;
+} NcmLHRatio1dSide;
+
 static gdouble
 ncm_lh_ratio1d_f (gdouble x, gpointer ptr)
 {
-  NcmLHRatio1d *lhr1d = NCM_LH_RATIO1D (ptr);
+  NcmLHRatio1dSide *side = (NcmLHRatio1dSide *) ptr;
+  NcmLHRatio1d *lhr1d    = side->lhr1d;
   gdouble p = lhr1d->bf + x;
 
   p = GSL_MAX (p, lhr1d->lb);
   p = GSL_MIN (p, lhr1d->ub);
 
-  ncm_mset_param_set (lhr1d->constrained->mset, lhr1d->pi.mid, lhr1d->pi.pid, p);
+  ncm_mset_param_set (side->constrained->mset, lhr1d->pi.mid, lhr1d->pi.pid, p);
 
-  ncm_fit_run (lhr1d->constrained, NCM_FIT_RUN_MSGS_NONE);
+  ncm_fit_run (side->constrained, NCM_FIT_RUN_MSGS_NONE);
 
-  lhr1d->niter     += lhr1d->constrained->fstate->niter;
-  lhr1d->func_eval += lhr1d->constrained->fstate->func_eval;
-  lhr1d->grad_eval += lhr1d->constrained->fstate->grad_eval;
+  side->niter     += side->constrained->fstate->niter;
+  side->func_eval += side->constrained->fstate->func_eval;
+  side->grad_eval += side->constrained->fstate->grad_eval;
 
   if (p == lhr1d->lb)
   {
@@ -423,15 +490,16 @@ ncm_lh_ratio1d_f (gdouble x, gpointer ptr)
   }
 
   {
-    const gdouble m2lnL_const = ncm_fit_state_get_m2lnL_curval (lhr1d->constrained->fstate);
+    const gdouble m2lnL_const = ncm_fit_state_get_m2lnL_curval (side->constrained->fstate);
     const gdouble m2lnL = ncm_fit_state_get_m2lnL_curval (lhr1d->fit->fstate);
     return m2lnL_const - (m2lnL + lhr1d->chisquare);
   }
 }
 
 static gdouble
-ncm_lh_ratio1d_root_brent (NcmLHRatio1d *lhr1d, gdouble x0, gdouble x)
+ncm_lh_ratio1d_root_brent (NcmLHRatio1dSide *side, gdouble x0, gdouble x)
 {
+  NcmLHRatio1d *lhr1d = side->lhr1d;
   gint status;
   gint iter = 0, max_iter = 1000000;
   const gsl_root_fsolver_type *T;
@@ -440,13 +508,14 @@ ncm_lh_ratio1d_root_brent (NcmLHRatio1d *lhr1d, gdouble x0, gdouble x)
   gdouble prec = 1e-5, x1 = x;
 
   F.function = &ncm_lh_ratio1d_f;
-  F.params   = lhr1d;
+  F.params   = side;
 
   T = gsl_root_fsolver_brent;
   s = gsl_root_fsolver_alloc (T);
   gsl_root_fsolver_set (s, &F, x0, x1);
 
-  ncm_lh_ratio1d_log_root_start (lhr1d, x0, x);
+  if (side->log)
+    ncm_lh_ratio1d_log_root_start (lhr1d, x0, x);
 
   do
   {
@@ -464,9 +533,10 @@ ncm_lh_ratio1d_root_brent (NcmLHRatio1d *lhr1d, gdouble x0, gdouble x)
     x1 = gsl_root_fsolver_x_upper (s);
     status = gsl_root_test_interval (x0, x1, 0, prec);
 
-    ncm_lh_ratio1d_log_root_step (lhr1d, x0, x1);
+    if (side->log)
+      ncm_lh_ratio1d_log_root_step (lhr1d, x0, x1);
 
-    if (!gsl_finite (ncm_lh_ratio1d_f (x, lhr1d)))
+    if (!gsl_finite (ncm_lh_ratio1d_f (x, side)))
     {
       g_debug ("Ops");
       x = GSL_NAN;
@@ -476,7 +546,8 @@ ncm_lh_ratio1d_root_brent (NcmLHRatio1d *lhr1d, gdouble x0, gdouble x)
   while (status == GSL_CONTINUE && iter < max_iter);
 
   gsl_root_fsolver_free (s);
-  ncm_lh_ratio1d_log_root_finish (lhr1d, x, prec);
+  if (side->log)
+    ncm_lh_ratio1d_log_root_finish (lhr1d, x, prec);
 
   return x;
 }
@@ -503,8 +574,9 @@ ncm_lh_ratio1d_numdiff_fdf (gdouble x, gpointer p, gdouble *y, gdouble *dy)
 
 
 static gdouble
-ncm_lh_ratio1d_root_steffenson (NcmLHRatio1d *lhr1d, gdouble x0, gdouble x1)
+ncm_lh_ratio1d_root_steffenson (NcmLHRatio1dSide *side, gdouble x0, gdouble x1)
 {
+  NcmLHRatio1d *lhr1d = side->lhr1d;
   gint status;
   gint iter = 0, max_iter = 1000000;
   const gsl_root_fdfsolver_type *T;
@@ -516,13 +588,14 @@ ncm_lh_ratio1d_root_steffenson (NcmLHRatio1d *lhr1d, gdouble x0, gdouble x1)
   F.f = &ncm_lh_ratio1d_f;
   F.df = &ncm_lh_ratio1d_numdiff_df;
   F.fdf = &ncm_lh_ratio1d_numdiff_fdf;
-  F.params = lhr1d;
+  F.params = side;
 
   T = gsl_root_fdfsolver_steffenson;
   s = gsl_root_fdfsolver_alloc (T);
   gsl_root_fdfsolver_set (s, &F, x);
 
-  ncm_lh_ratio1d_log_root_start (lhr1d, x0, x);
+  if (side->log)
+    ncm_lh_ratio1d_log_root_start (lhr1d, x0, x);
   
   do
   {
@@ -540,9 +613,10 @@ ncm_lh_ratio1d_root_steffenson (NcmLHRatio1d *lhr1d, gdouble x0, gdouble x1)
     x = gsl_root_fdfsolver_root (s);
     status = gsl_root_test_delta (x, x0, 0, prec);
 
-    ncm_lh_ratio1d_log_root_step (lhr1d, x, x0);
+    if (side->log)
+      ncm_lh_ratio1d_log_root_step (lhr1d, x, x0);
 
-    if (!gsl_finite (ncm_lh_ratio1d_f (x, lhr1d)))
+    if (!gsl_finite (ncm_lh_ratio1d_f (x, side)))
     {
       g_debug ("Ops");
       x = GSL_NAN;
@@ -551,7 +625,8 @@ ncm_lh_ratio1d_root_steffenson (NcmLHRatio1d *lhr1d, gdouble x0, gdouble x1)
   }
   while (status == GSL_CONTINUE && iter < max_iter);
 
-  ncm_lh_ratio1d_log_root_finish (lhr1d, x, prec);
+  if (side->log)
+    ncm_lh_ratio1d_log_root_finish (lhr1d, x, prec);
     
   gsl_root_fdfsolver_free (s);
   return x;
@@ -559,6 +634,119 @@ ncm_lh_ratio1d_root_steffenson (NcmLHRatio1d *lhr1d, gdouble x0, gdouble x1)
 
 #define NCM_LH_RATIO1D_SCALE_INCR (1.1)
 
+/*
+ * Brackets the root moving away from the best fit starting at side->x0
+ * and then refines it using the method selected by lhr1d->rtype.
+ */
+static void
+_ncm_lh_ratio1d_side_find (NcmLHRatio1dSide *side)
+{
+  NcmLHRatio1d *lhr1d = side->lhr1d;
+  gdouble r = 0.0, x = side->x0, val;
+
+  while ((val = ncm_lh_ratio1d_f (x, side)) < 0.0)
+  {
+    if (side->log)
+      ncm_lh_ratio1d_log_param_val (lhr1d, x, val);
+    r  = x;
+    x *= NCM_LH_RATIO1D_SCALE_INCR;
+  }
+
+  if (!gsl_finite (val))
+  {
+    side->root = GSL_NAN;
+    return;
+  }
+
+  switch (lhr1d->rtype)
+  {
+    case NCM_LH_RATIO1D_ROOT_BRACKET:
+      side->root = ncm_lh_ratio1d_root_brent (side, GSL_MIN (r, x), GSL_MAX (r, x));
+      break;
+    case NCM_LH_RATIO1D_ROOT_NUMDIFF:
+      side->root = ncm_lh_ratio1d_root_steffenson (side, GSL_MIN (r, x), GSL_MAX (r, x));
+      break;
+    default:
+      g_assert_not_reached ();
+      break;
+  }
+}
+
+static void
+_ncm_lh_ratio1d_side_eval (glong i, glong f, gpointer data)
+{
+  NcmLHRatio1dSide *sides = (NcmLHRatio1dSide *) data;
+  glong j;
+
+  for (j = i; j < f; j++)
+    _ncm_lh_ratio1d_side_find (&sides[j]);
+}
+
+static void
+_ncm_lh_ratio1d_side_init (NcmLHRatio1dSide *side, NcmLHRatio1d *lhr1d, NcmFit *constrained, gdouble x0)
+{
+  side->lhr1d       = lhr1d;
+  side->constrained = constrained;
+  side->log         = TRUE;
+  side->x0          = x0;
+  side->root        = GSL_NAN;
+  side->niter       = 0;
+  side->func_eval   = 0;
+  side->grad_eval   = 0;
+}
+
+static void
+_ncm_lh_ratio1d_side_add_stats (NcmLHRatio1d *lhr1d, NcmLHRatio1dSide *side)
+{
+  lhr1d->niter     += side->niter;
+  lhr1d->func_eval += side->func_eval;
+  lhr1d->grad_eval += side->grad_eval;
+}
+
+/*
+ * The two sides run concurrently, each one with its own copy of the
+ * constrained fit. The remaining threads are split between the datasets
+ * of the two copies, see ncm_dataset_set_nthreads().
+ */
+static void
+_ncm_lh_ratio1d_find_bounds_mt (NcmLHRatio1d *lhr1d, gdouble scale, gdouble *r_min, gdouble *r_max)
+{
+  NcmSerialize *ser = ncm_serialize_new (NCM_SERIALIZE_OPT_CLEAN_DUP);
+  NcmVector *params = ncm_vector_new (ncm_mset_total_len (lhr1d->fit->mset));
+  const guint dset_nthreads = lhr1d->nthreads / 2;
+  NcmLHRatio1dSide sides[2];
+  guint i;
+
+  ncm_mset_param_get_vector (lhr1d->fit->mset, params);
+
+  for (i = 0; i < 2; i++)
+  {
+    NcmLHRatio1dSide *side = &sides[i];
+
+    _ncm_lh_ratio1d_side_init (side, lhr1d, ncm_fit_dup (lhr1d->constrained, ser), (i == 0) ? -scale : scale);
+    side->log = FALSE;
+
+    /* Both sides start from the unconstrained best fit. */
+    ncm_mset_param_set_vector (side->constrained->mset, params);
+    ncm_dataset_set_nthreads (side->constrained->lh->dset, (dset_nthreads > 1) ? dset_nthreads : 0);
+    ncm_serialize_clear_instances (ser);
+  }
+
+  ncm_func_eval_threaded_loop_full (&_ncm_lh_ratio1d_side_eval, 0, 2, sides);
+
+  for (i = 0; i < 2; i++)
+  {
+    _ncm_lh_ratio1d_side_add_stats (lhr1d, &sides[i]);
+    ncm_fit_free (sides[i].constrained);
+  }
+
+  *r_min = sides[0].root;
+  *r_max = sides[1].root;
+
+  ncm_vector_free (params);
+  ncm_serialize_free (ser);
+}
+
 /**
  * ncm_lh_ratio1d_find_bounds:
  * @lhr1d: a #NcmLHRatio1d
@@ -573,8 +761,7 @@ ncm_lh_ratio1d_root_steffenson (NcmLHRatio1d *lhr1d, gdouble x0, gdouble x1)
 void 
 ncm_lh_ratio1d_find_bounds (NcmLHRatio1d *lhr1d, gdouble clevel, NcmFitRunMsgs mtype, gdouble *lb, gdouble *ub)
 {
-  gdouble scale, r, r_min, r_max, val;
-  static gdouble (*root) (NcmLHRatio1d *lhr1d, gdouble x0, gdouble x);
+  gdouble scale;
 
   g_assert_cmpfloat (clevel, >, 0.0);
   g_assert_cmpfloat (clevel, <, 1.0);
@@ -582,47 +769,29 @@ ncm_lh_ratio1d_find_bounds (NcmLHRatio1d *lhr1d, gdouble clevel, NcmFitRunMsgs m
   lhr1d->chisquare = gsl_cdf_chisq_Qinv (1.0 - clevel, 1.0);
   scale = sqrt (lhr1d->chisquare) * 
     ncm_fit_covar_sd (lhr1d->fit, lhr1d->pi.mid, lhr1d->pi.pid);
-  r = 0.0;
-  r_min = -scale;
-  r_max =  scale;
-    
-  switch (lhr1d->rtype)
-  {
-    case NCM_LH_RATIO1D_ROOT_BRACKET:
-      root = ncm_lh_ratio1d_root_brent;
-      break;
-    case NCM_LH_RATIO1D_ROOT_NUMDIFF:
-      root = ncm_lh_ratio1d_root_steffenson;
-      break;
-    default:
-      g_assert_not_reached ();
-      break;
-  }
 
   lhr1d->mtype = mtype;
 
   ncm_lh_ratio1d_log_start (lhr1d, clevel);
-  
-  while ((val = ncm_lh_ratio1d_f (r_min, lhr1d)) < 0.0)
-  {
-    ncm_lh_ratio1d_log_param_val (lhr1d, r_min, val);
-    r = r_min;
-    r_min *= NCM_LH_RATIO1D_SCALE_INCR;
-  }
-  r_min = root (lhr1d, r_min, r);
 
-  r = 0.0;
-  while ((val = ncm_lh_ratio1d_f (r_max, lhr1d)) < 0.0)
+  if (lhr1d->nthreads > 1)
   {
-    ncm_lh_ratio1d_log_param_val (lhr1d, r_max, val);
-    r = r_max;
-    r_max *= NCM_LH_RATIO1D_SCALE_INCR;
+    _ncm_lh_ratio1d_find_bounds_mt (lhr1d, scale, lb, ub);
   }
-  r_max = root (lhr1d, r, r_max);
+  else
+  {
+    NcmLHRatio1dSide side;
 
-  *lb = r_min;
-  *ub = r_max;
+    _ncm_lh_ratio1d_side_init (&side, lhr1d, lhr1d->constrained, -scale);
+    _ncm_lh_ratio1d_side_find (&side);
+    *lb = side.root;
 
-  ncm_lh_ratio1d_log_finish (lhr1d, r_min, r_max);
-}
+    side.x0 = scale;
+    _ncm_lh_ratio1d_side_find (&side);
+    *ub = side.root;
 
+    _ncm_lh_ratio1d_side_add_stats (lhr1d, &side);
+  }
+
+  ncm_lh_ratio1d_log_finish (lhr1d, *lb, *ub);
+}
@@ -75,6 +75,7 @@ struct _NcmLHRatio1d
   gdouble lb;
   gdouble ub;
   gdouble bf;
+  guint nthreads;
   guint niter;
   guint func_eval;
   guint grad_eval;
@@ -87,6 +88,8 @@ void ncm_lh_ratio1d_free (NcmLHRatio1d *lhr1d);
 void ncm_lh_ratio1d_clear (NcmLHRatio1d **lhr1d);
 
 void ncm_lh_ratio1d_set_pindex (NcmLHRatio1d *lhr1d, NcmMSetPIndex *pi);
+void ncm_lh_ratio1d_set_nthreads (NcmLHRatio1d *lhr1d, guint nthreads);
+guint ncm_lh_ratio1d_get_nthreads (NcmLHRatio1d *lhr1d);
 void ncm_lh_ratio1d_find_bounds (NcmLHRatio1d *lhr1d, gdouble clevel, NcmFitRunMsgs mtype, gdouble *lb, gdouble *ub);
 
 G_END_DECLS
@@ -28,7 +28,16 @@
  * @title: NcmLHRatio2d
  * @short_description: Likelihood ratio object for bidimensional parameter analysis.
  *
- * FIXME
+ * This object computes the profile likelihood confidence regions of two
+ * parameters. The function ncm_lh_ratio2d_conf_region() walks along the
+ * border, one root at a time. The function ncm_lh_ratio2d_conf_region_radial()
+ * finds the border along many radial directions (in the coordinates where the
+ * Fisher ellipse is a circle) at once. Each direction uses its own copy of the
+ * constrained #NcmFit, starts from the parameters found for the closest
+ * direction already computed, and new directions are added only where the
+ * border turns faster than expected. The directions are computed in parallel
+ * when #NcmLHRatio2d:nthreads is larger than one. This method assumes that the
+ * region is star-shaped with respect to the best fit.
  * 
  */
 
@@ -43,6 +52,7 @@
 #include "math/ncm_cfg.h"
 #include "math/ncm_matrix.h"
 #include "math/ncm_util.h"
+#include "math/ncm_func_eval.h"
 
 #include <gsl/gsl_cdf.h>
 #include <gsl/gsl_roots.h>
@@ -56,6 +66,7 @@ enum
   PROP_PI1,
   PROP_PI2,
   PROP_BORDER_PREC,
+  PROP_NTHREADS,
   PROP_SIZE,
 };
 
@@ -83,6 +94,7 @@ ncm_lh_ratio2d_init (NcmLHRatio2d *lhr2d)
   lhr2d->shift[1]    = 0.0;
   lhr2d->border_prec = 0.0;
   lhr2d->angular     = FALSE;
+  lhr2d->nthreads    = 0;
 }
 
 static void _ncm_lh_ratio2d_prepare_coords (NcmLHRatio2d *lhr2d);
@@ -155,6 +167,9 @@ ncm_lh_ratio2d_set_property (GObject *object, guint prop_id, const GValue *value
     case PROP_BORDER_PREC:
       lhr2d->border_prec = g_value_get_double (value);
       break;
+    case PROP_NTHREADS:
+      ncm_lh_ratio2d_set_nthreads (lhr2d, g_value_get_uint (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -184,6 +199,9 @@ ncm_lh_ratio2d_get_property (GObject *object, guint prop_id, GValue *value, GPar
     case PROP_BORDER_PREC:
       g_value_set_double (value, lhr2d->border_prec);
       break;
+    case PROP_NTHREADS:
+      g_value_set_uint (value, lhr2d->nthreads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -254,6 +272,13 @@ ncm_lh_ratio2d_class_init (NcmLHRatio2dClass *klass)
                                                         "Border precision",
                                                         1.0e-16, 1.0e3, 1.0e-5,
                                                         G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
+  g_object_class_install_property (object_class,
+                                   PROP_NTHREADS,
+                                   g_param_spec_uint ("nthreads",
+                                                      NULL,
+                                                      "Number of threads to run",
+                                                      0, 100, 0,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_STATIC_BLURB));
 }
 
 /**
@@ -393,6 +418,33 @@ ncm_lh_ratio2d_set_pindex (NcmLHRatio2d *lhr2d, NcmMSetPIndex *pi1, NcmMSetPInde
   _ncm_lh_ratio2d_prepare_coords (lhr2d);
 }
 
+/**
+ * ncm_lh_ratio2d_set_nthreads:
+ * @lhr2d: a #NcmLHRatio2d
+ * @nthreads: number of threads
+ *
+ * Sets the number of threads used by ncm_lh_ratio2d_conf_region_radial(),
+ * values smaller than two compute the directions serially.
+ *
+ */
+void 
+ncm_lh_ratio2d_set_nthreads (NcmLHRatio2d *lhr2d, guint nthreads)
+{
+  lhr2d->nthreads = nthreads;
+}
+
+/**
+ * ncm_lh_ratio2d_get_nthreads:
+ * @lhr2d: a #NcmLHRatio2d
+ *
+ * Returns: the number of threads used by ncm_lh_ratio2d_conf_region_radial().
+ */
+guint 
+ncm_lh_ratio2d_get_nthreads (NcmLHRatio2d *lhr2d)
+{
+  return lhr2d->nthreads;
+}
+
 static gboolean _ncm_lh_ratio2d_log_dot = FALSE;
 
 static void
@@ -1030,6 +1082,422 @@ ncm_lh_ratio2d_conf_region (NcmLHRatio2d *lhr2d, gdouble clevel, gdouble expecte
   }
 }
 
+/* Parallel radial border finder */
+
+#define NCM_LH_RATIO2D_RADIAL_MIN_NDIR (8)
+#define NCM_LH_RATIO2D_RADIAL_MAX_ROUNDS (10)
+#define NCM_LH_RATIO2D_RADIAL_MAX_FACTOR (4.0)
+#define NCM_LH_RATIO2D_RADIAL_TURN_FACTOR (1.5)
+#define NCM_LH_RATIO2D_RADIAL_EXPAND (1.5)
+#define NCM_LH_RATIO2D_RADIAL_MAX_ITER (200)
+
+typedef struct _NcmLHRatio2dDir
+{
+  gdouble theta;
+  gdouble r;
+  gdouble r_guess;
+  NcmVector *x;
+  NcmVector *x_ini;
+  gboolean converged;
+} NcmLHRatio2dDir;
+
+typedef struct _NcmLHRatio2dRadial
+{
+  NcmLHRatio2d *lhr2d;
+  NcmSerialize *ser;
+  NcmMemoryPool *mp;
+  NcmVector *cbf;
+  GPtrArray *tasks;
+  gdouble m2lnL_bf;
+  GMutex dup_fit;
+  GMutex update_lock;
+} NcmLHRatio2dRadial;
+
+typedef struct _NcmLHRatio2dWorker
+{
+  NcmLHRatio2dRadial *rad;
+  NcmFit *constrained;
+  gsl_root_fsolver *s;
+  gdouble theta;
+  guint niter;
+  guint func_eval;
+  guint grad_eval;
+} NcmLHRatio2dWorker;
+
+static NcmLHRatio2dDir *
+_ncm_lh_ratio2d_dir_new (gdouble theta, gdouble r_guess, NcmVector *x_ini)
+{
+  NcmLHRatio2dDir *dir = g_slice_new (NcmLHRatio2dDir);
+
+  dir->theta     = theta;
+  dir->r         = GSL_NAN;
+  dir->r_guess   = r_guess;
+  dir->x         = NULL;
+  dir->x_ini     = (x_ini != NULL) ? ncm_vector_ref (x_ini) : NULL;
+  dir->converged = FALSE;
+
+  return dir;
+}
+
+static void
+_ncm_lh_ratio2d_dir_free (gpointer data)
+{
+  NcmLHRatio2dDir *dir = (NcmLHRatio2dDir *) data;
+
+  ncm_vector_clear (&dir->x);
+  ncm_vector_clear (&dir->x_ini);
+  g_slice_free (NcmLHRatio2dDir, dir);
+}
+
+static gint
+_ncm_lh_ratio2d_dir_cmp (gconstpointer a, gconstpointer b)
+{
+  const NcmLHRatio2dDir *dir_a = *(NcmLHRatio2dDir **) a;
+  const NcmLHRatio2dDir *dir_b = *(NcmLHRatio2dDir **) b;
+
+  return (dir_a->theta < dir_b->theta) ? -1 : ((dir_a->theta > dir_b->theta) ? 1 : 0);
+}
+
+static gpointer
+_ncm_lh_ratio2d_worker_new (gpointer userdata)
+{
+  NcmLHRatio2dRadial *rad = (NcmLHRatio2dRadial *) userdata;
+  NcmLHRatio2dWorker *w   = g_new (NcmLHRatio2dWorker, 1);
+
+  g_mutex_lock (&rad->dup_fit);
+  w->constrained = ncm_fit_dup (rad->lhr2d->constrained, rad->ser);
+  ncm_serialize_clear_instances (rad->ser);
+  g_mutex_unlock (&rad->dup_fit);
+
+  w->rad       = rad;
+  w->s         = gsl_root_fsolver_alloc (gsl_root_fsolver_brent);
+  w->theta     = 0.0;
+  w->niter     = 0;
+  w->func_eval = 0;
+  w->grad_eval = 0;
+
+  return w;
+}
+
+static void
+_ncm_lh_ratio2d_worker_free (gpointer data)
+{
+  NcmLHRatio2dWorker *w = (NcmLHRatio2dWorker *) data;
+
+  ncm_fit_clear (&w->constrained);
+  gsl_root_fsolver_free (w->s);
+  g_free (w);
+}
+
+static gdouble
+_ncm_lh_ratio2d_radial_f (gdouble r, gpointer ptr)
+{
+  NcmLHRatio2dWorker *w = (NcmLHRatio2dWorker *) ptr;
+  NcmLHRatio2d *lhr2d   = w->rad->lhr2d;
+  const gdouble alpha   = r * cos (w->theta);
+  const gdouble beta    = r * sin (w->theta);
+  gdouble p[2];
+
+  p[0] = lhr2d->bf[0] + alpha * ncm_matrix_get (lhr2d->e_vec, 0, 0) + beta * ncm_matrix_get (lhr2d->e_vec, 0, 1);
+  p[1] = lhr2d->bf[1] + alpha * ncm_matrix_get (lhr2d->e_vec, 1, 0) + beta * ncm_matrix_get (lhr2d->e_vec, 1, 1);
+
+  if (!_ncm_lh_ratio2d_inside_interval (&p[0], lhr2d->lb[0], lhr2d->ub[0], 1e-4) ||
+      !_ncm_lh_ratio2d_inside_interval (&p[1], lhr2d->lb[1], lhr2d->ub[1], 1e-4))
+    return 1.0e5;
+
+  ncm_mset_param_set_pi (w->constrained->mset, lhr2d->pi, p, 2);
+  ncm_fit_run (w->constrained, NCM_FIT_RUN_MSGS_NONE);
+
+  w->niter     += w->constrained->fstate->niter;
+  w->func_eval += w->constrained->fstate->func_eval;
+  w->grad_eval += w->constrained->fstate->grad_eval;
+
+  return ncm_fit_state_get_m2lnL_curval (w->constrained->fstate) - (w->rad->m2lnL_bf + lhr2d->chisquare);
+}
+
+static void
+_ncm_lh_ratio2d_radial_find (NcmLHRatio2dWorker *w, NcmLHRatio2dDir *dir)
+{
+  NcmLHRatio2d *lhr2d = w->rad->lhr2d;
+  const gdouble r_min = lhr2d->border_prec;
+  gdouble r0          = 0.0;
+  gdouble r1          = dir->r_guess;
+  gdouble val;
+  gsl_function F;
+  gint status, iter = 0;
+
+  w->theta = dir->theta;
+  ncm_mset_fparams_set_vector (w->constrained->mset, (dir->x_ini != NULL) ? dir->x_ini : w->rad->cbf);
+
+  /* The fit is always at the last evaluated point, so each step starts from the previous one. */
+  val = _ncm_lh_ratio2d_radial_f (r1, w);
+  if (!gsl_finite (val))
+    return;
+
+  if (val < 0.0)
+  {
+    do
+    {
+      r0  = r1;
+      r1 *= NCM_LH_RATIO2D_RADIAL_EXPAND;
+      val = _ncm_lh_ratio2d_radial_f (r1, w);
+      if (!gsl_finite (val))
+        return;
+    } while (val < 0.0);
+  }
+  else
+  {
+    gdouble rt = r1 / NCM_LH_RATIO2D_RADIAL_EXPAND;
+    while (rt > r_min)
+    {
+      val = _ncm_lh_ratio2d_radial_f (rt, w);
+      if (!gsl_finite (val))
+        return;
+      if (val < 0.0)
+      {
+        r0 = rt;
+        break;
+      }
+      r1  = rt;
+      rt /= NCM_LH_RATIO2D_RADIAL_EXPAND;
+    }
+  }
+
+  F.function = &_ncm_lh_ratio2d_radial_f;
+  F.params   = w;
+
+  gsl_root_fsolver_set (w->s, &F, r0, r1);
+  do
+  {
+    iter++;
+    status = gsl_root_fsolver_iterate (w->s);
+    if (status)
+    {
+      g_warning ("_ncm_lh_ratio2d_radial_find: %s", gsl_strerror (status));
+      return;
+    }
+    r0     = gsl_root_fsolver_x_lower (w->s);
+    r1     = gsl_root_fsolver_x_upper (w->s);
+    status = gsl_root_test_interval (r0, r1, 0.0, lhr2d->border_prec);
+  } while (status == GSL_CONTINUE && iter < NCM_LH_RATIO2D_RADIAL_MAX_ITER);
+
+  /* Brent's method evaluates the function at the returned root last. */
+  dir->r         = gsl_root_fsolver_root (w->s);
+  dir->x         = ncm_vector_new (ncm_mset_fparams_len (w->constrained->mset));
+  dir->converged = gsl_finite (dir->r);
+  ncm_mset_fparams_get_vector (w->constrained->mset, dir->x);
+}
+
+static void
+_ncm_lh_ratio2d_radial_eval (glong i, glong f, gpointer data)
+{
+  NcmLHRatio2dRadial *rad    = (NcmLHRatio2dRadial *) data;
+  NcmLHRatio2dWorker **w_ptr = ncm_memory_pool_get (rad->mp);
+  NcmLHRatio2dWorker *w      = *w_ptr;
+  glong j;
+
+  for (j = i; j < f; j++)
+    _ncm_lh_ratio2d_radial_find (w, g_ptr_array_index (rad->tasks, j));
+
+  g_mutex_lock (&rad->update_lock);
+  rad->lhr2d->niter     += w->niter;
+  rad->lhr2d->func_eval += w->func_eval;
+  rad->lhr2d->grad_eval += w->grad_eval;
+  g_mutex_unlock (&rad->update_lock);
+
+  w->niter     = 0;
+  w->func_eval = 0;
+  w->grad_eval = 0;
+
+  ncm_memory_pool_return (w_ptr);
+}
+
+static void
+_ncm_lh_ratio2d_radial_run (NcmLHRatio2dRadial *rad)
+{
+  if (rad->tasks->len == 0)
+    return;
+  
+  if (rad->lhr2d->nthreads > 1)
+    ncm_func_eval_threaded_loop_full (&_ncm_lh_ratio2d_radial_eval, 0, rad->tasks->len, rad);
+  else
+    _ncm_lh_ratio2d_radial_eval (0, rad->tasks->len, rad);
+}
+
+static gdouble
+_ncm_lh_ratio2d_radial_turn (NcmLHRatio2dDir *a, NcmLHRatio2dDir *b, NcmLHRatio2dDir *c)
+{
+  const gdouble u[2] = {b->r * cos (b->theta) - a->r * cos (a->theta), b->r * sin (b->theta) - a->r * sin (a->theta)};
+  const gdouble v[2] = {c->r * cos (c->theta) - b->r * cos (b->theta), c->r * sin (c->theta) - b->r * sin (b->theta)};
+
+  return fabs (atan2 (u[0] * v[1] - u[1] * v[0], u[0] * v[0] + u[1] * v[1]));
+}
+
+/**
+ * ncm_lh_ratio2d_conf_region_radial:
+ * @lhr2d: a #NcmLHRatio2d
+ * @clevel: the confidence level (0,1)
+ * @expected_np: expected number of points, if lesser than 1 it uses the default value of 100.
+ * @mtype: a #NcmFitRunMsgs
+ *
+ * Computes the border of the confidence region with confidence level @clevel
+ * using radial directions from the best fit. It starts with
+ * max(@expected_np / 4, 8) equally spaced directions and, at each round,
+ * bisects the angular intervals where the border turns more than
+ * $1.5 \times 2\pi/$@expected_np. The refinement stops when no interval needs
+ * to be bisected or the number of points reaches 4 @expected_np. See the 
+ * section description for details.
+ *
+ * Returns: (transfer full): a #NcmLHRatio2dRegion.
+ */
+NcmLHRatio2dRegion *
+ncm_lh_ratio2d_conf_region_radial (NcmLHRatio2d *lhr2d, gdouble clevel, gdouble expected_np, NcmFitRunMsgs mtype)
+{
+  NcmLHRatio2dRadial rad;
+  GPtrArray *dirs  = g_ptr_array_new_with_free_func (&_ncm_lh_ratio2d_dir_free);
+  gdouble theta0;
+  gdouble turn_max, dtheta_min;
+  guint ndir0, max_np, round, i;
+
+  g_assert_cmpfloat (clevel, >, 0.0);
+  g_assert_cmpfloat (clevel, <, 1.0);
+
+  if (expected_np <= 1.0)
+    expected_np = 100.0;
+
+  lhr2d->mtype     = mtype;
+  lhr2d->chisquare = gsl_cdf_chisq_Qinv (1.0 - clevel, 2);
+  ncm_lh_ratio2d_log_start (lhr2d, clevel);
+
+  rad.lhr2d    = lhr2d;
+  rad.ser      = ncm_serialize_new (NCM_SERIALIZE_OPT_CLEAN_DUP);
+  rad.tasks    = g_ptr_array_new ();
+  rad.m2lnL_bf = ncm_fit_state_get_m2lnL_curval (lhr2d->fit->fstate);
+  g_mutex_init (&rad.dup_fit);
+  g_mutex_init (&rad.update_lock);
+
+  /* The constrained fits start from the unconstrained best fit. */
+  {
+    NcmVector *params = ncm_vector_new (ncm_mset_total_len (lhr2d->fit->mset));
+
+    ncm_mset_param_get_vector (lhr2d->fit->mset, params);
+    ncm_mset_param_set_vector (lhr2d->constrained->mset, params);
+
+    rad.cbf = ncm_vector_new (ncm_mset_fparams_len (lhr2d->constrained->mset));
+    ncm_mset_fparams_get_vector (lhr2d->constrained->mset, rad.cbf);
+    ncm_vector_free (params);
+  }
+
+  rad.mp = ncm_memory_pool_new (&_ncm_lh_ratio2d_worker_new, &rad, &_ncm_lh_ratio2d_worker_free);
+
+  ndir0      = GSL_MAX (NCM_LH_RATIO2D_RADIAL_MIN_NDIR, (guint) (expected_np / 4.0));
+  max_np     = NCM_LH_RATIO2D_RADIAL_MAX_FACTOR * expected_np;
+  turn_max   = NCM_LH_RATIO2D_RADIAL_TURN_FACTOR * 2.0 * M_PI / expected_np;
+  dtheta_min = 2.0 * M_PI / (16.0 * expected_np);
+  theta0     = gsl_rng_uniform (lhr2d->rng->r) * 2.0 * M_PI;
+
+  for (i = 0; i < ndir0; i++)
+  {
+    NcmLHRatio2dDir *dir = _ncm_lh_ratio2d_dir_new (theta0 + 2.0 * M_PI * i / ndir0, sqrt (lhr2d->chisquare), NULL);
+    g_ptr_array_add (dirs, dir);
+    g_ptr_array_add (rad.tasks, dir);
+  }
+
+  for (round = 0; TRUE; round++)
+  {
+    _ncm_lh_ratio2d_radial_run (&rad);
+
+    if (mtype > NCM_FIT_RUN_MSGS_NONE)
+      g_message ("#  round %u: %u directions computed, %u total.\n", round, rad.tasks->len, dirs->len);
+
+    /* Directions where the inner fit failed are discarded. */
+    for (i = 0; i < dirs->len; )
+    {
+      NcmLHRatio2dDir *dir = g_ptr_array_index (dirs, i);
+      if (!dir->converged)
+      {
+        g_warning ("ncm_lh_ratio2d_conf_region_radial: cannot find the border at theta = % 12.8g, ignoring.", dir->theta);
+        g_ptr_array_remove_index (dirs, i);
+      }
+      else
+        i++;
+    }
+    g_ptr_array_set_size (rad.tasks, 0);
+
+    if ((dirs->len < 3) || (round + 1 >= NCM_LH_RATIO2D_RADIAL_MAX_ROUNDS) || (dirs->len >= max_np))
+      break;
+
+    for (i = 0; i < dirs->len; i++)
+    {
+      const guint n         = dirs->len;
+      NcmLHRatio2dDir *prev = g_ptr_array_index (dirs, (i + n - 1) % n);
+      NcmLHRatio2dDir *a    = g_ptr_array_index (dirs, i);
+      NcmLHRatio2dDir *b    = g_ptr_array_index (dirs, (i + 1) % n);
+      NcmLHRatio2dDir *next = g_ptr_array_index (dirs, (i + 2) % n);
+      const gdouble dtheta  = (i + 1 == n) ? (b->theta + 2.0 * M_PI - a->theta) : (b->theta - a->theta);
+      const gdouble turn    = GSL_MAX (_ncm_lh_ratio2d_radial_turn (prev, a, b), _ncm_lh_ratio2d_radial_turn (a, b, next));
+
+      if ((dtheta > dtheta_min) && (turn > turn_max) && (dirs->len + rad.tasks->len < max_np))
+      {
+        gdouble theta = a->theta + 0.5 * dtheta;
+        if (theta >= theta0 + 2.0 * M_PI)
+          theta -= 2.0 * M_PI;
+
+        /* Warm start from the neighbour with the smallest border radius. */
+        g_ptr_array_add (rad.tasks, 
+                         _ncm_lh_ratio2d_dir_new (theta, 0.5 * (a->r + b->r), (a->r <= b->r) ? a->x : b->x));
+      }
+    }
+
+    if (rad.tasks->len == 0)
+      break;
+
+    for (i = 0; i < rad.tasks->len; i++)
+      g_ptr_array_add (dirs, g_ptr_array_index (rad.tasks, i));
+    g_ptr_array_sort (dirs, &_ncm_lh_ratio2d_dir_cmp);
+  }
+
+  ncm_memory_pool_free (rad.mp, TRUE);
+  ncm_serialize_free (rad.ser);
+  ncm_vector_free (rad.cbf);
+  g_ptr_array_unref (rad.tasks);
+  g_mutex_clear (&rad.dup_fit);
+  g_mutex_clear (&rad.update_lock);
+
+  if (dirs->len == 0)
+    g_error ("ncm_lh_ratio2d_conf_region_radial: cannot find the border in any direction.");
+
+  {
+    NcmLHRatio2dRegion *rg = g_slice_new0 (NcmLHRatio2dRegion);
+
+    rg->np     = dirs->len + 1;
+    rg->p1     = ncm_vector_new (rg->np);
+    rg->p2     = ncm_vector_new (rg->np);
+    rg->clevel = clevel;
+
+    lhr2d->shift[0] = 0.0;
+    lhr2d->shift[1] = 0.0;
+    for (i = 0; i < rg->np; i++)
+    {
+      NcmLHRatio2dDir *dir = g_ptr_array_index (dirs, i % dirs->len);
+      gdouble p1, p2;
+
+      lhr2d->r     = dir->r;
+      lhr2d->theta = dir->theta;
+      ncm_lh_ratio2d_tofparam (lhr2d, &p1, &p2);
+
+      ncm_vector_set (rg->p1, i, p1);
+      ncm_vector_set (rg->p2, i, p2);
+    }
+
+    if (mtype > NCM_FIT_RUN_MSGS_NONE)
+      g_message ("#  border computed with %u points.\n", dirs->len);
+
+    g_ptr_array_unref (dirs);
+    return rg;
+  }
+}
+
 /**
  * ncm_lh_ratio2d_fisher_border:
  * @lhr2d: a #NcmFit.
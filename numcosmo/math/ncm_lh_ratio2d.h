@@ -30,6 +30,7 @@
 #include <glib-object.h>
 #include <numcosmo/build_cfg.h>
 #include <numcosmo/math/ncm_fit.h>
+#include <numcosmo/math/memory_pool.h>
 
 G_BEGIN_DECLS
 
@@ -81,6 +82,7 @@ struct _NcmLHRatio2d
   gdouble r, theta;
   gdouble shift[2];
   gboolean angular;
+  guint nthreads;
   guint niter;
   guint func_eval;
   guint grad_eval;
@@ -131,8 +133,11 @@ void ncm_lh_ratio2d_free (NcmLHRatio2d *lhr2d);
 void ncm_lh_ratio2d_clear (NcmLHRatio2d **lhr2d);
 
 void ncm_lh_ratio2d_set_pindex (NcmLHRatio2d *lhr2d, NcmMSetPIndex *pi1, NcmMSetPIndex *pi2);
+void ncm_lh_ratio2d_set_nthreads (NcmLHRatio2d *lhr2d, guint nthreads);
+guint ncm_lh_ratio2d_get_nthreads (NcmLHRatio2d *lhr2d);
 
 NcmLHRatio2dRegion *ncm_lh_ratio2d_conf_region (NcmLHRatio2d *lhr2d, gdouble clevel, gdouble expected_np, NcmFitRunMsgs mtype);
+NcmLHRatio2dRegion *ncm_lh_ratio2d_conf_region_radial (NcmLHRatio2d *lhr2d, gdouble clevel, gdouble expected_np, NcmFitRunMsgs mtype);
 NcmLHRatio2dRegion *ncm_lh_ratio2d_fisher_border (NcmLHRatio2d *lhr2d, gdouble clevel, gdouble expected_np, NcmFitRunMsgs mtype);
 NcmLHRatio2dRegion *ncm_lh_ratio2d_region_dup (NcmLHRatio2dRegion *rg);
 void ncm_lh_ratio2d_region_free (NcmLHRatio2dRegion *rg);
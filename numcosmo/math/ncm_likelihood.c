@@ -43,6 +43,7 @@
 #include "math/ncm_prior_gauss_func.h"
 #include "math/ncm_prior_flat_param.h"
 #include "math/ncm_prior_flat_func.h"
+#include "math/ncm_workspace.h"
 
 enum
 {
@@ -579,16 +580,18 @@ ncm_likelihood_leastsquares_f (NcmLikelihood *lh, NcmMSet *mset, NcmVector *f)
   
   if (data_size)
   {
-    NcmVector *data_f = ncm_vector_get_subvector (f, 0, data_size);
+    NcmWorkspace *ws  = ncm_workspace_peek ();
+    NcmVector *data_f = ncm_workspace_borrow_subvector (ws, f, 0, data_size);
     ncm_dataset_leastsquares_f (lh->dset, mset, data_f);
-    ncm_vector_free (data_f);
+    ncm_workspace_return_vector (ws, data_f);
   }
 
   if (priors_f_size)
   {
-    NcmVector *priors_f = ncm_vector_get_subvector (f, data_size, priors_f_size);
+    NcmWorkspace *ws    = ncm_workspace_peek ();
+    NcmVector *priors_f = ncm_workspace_borrow_subvector (ws, f, data_size, priors_f_size);
     ncm_likelihood_priors_leastsquares_f (lh, mset, priors_f);
-    ncm_vector_free (priors_f);
+    ncm_workspace_return_vector (ws, priors_f);
   }
   
   return;
@@ -727,10 +730,11 @@ ncm_likelihood_m2lnL_val (NcmLikelihood *lh, NcmMSet *mset, gdouble *m2lnL)
 
   if (prior_length > 0)
   {
-    NcmVector *priors_m2lnL_v = ncm_vector_get_subvector (lh->m2lnL_v, data_length, prior_length);
+    NcmWorkspace *ws          = ncm_workspace_peek ();
+    NcmVector *priors_m2lnL_v = ncm_workspace_borrow_subvector (ws, lh->m2lnL_v, data_length, prior_length);
     ncm_dataset_m2lnL_vec (lh->dset, mset, lh->m2lnL_v);
     ncm_likelihood_priors_m2lnL_vec (lh, mset, priors_m2lnL_v);
-    ncm_vector_free (priors_m2lnL_v);
+    ncm_workspace_return_vector (ws, priors_m2lnL_v);
   }
   else
   {
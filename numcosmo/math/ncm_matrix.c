@@ -40,6 +40,8 @@
 #include "math/ncm_matrix.h"
 #include "math/ncm_lapack.h"
 
+#include <string.h>
+
 #if (defined HAVE_CLAPACK_H) && (defined HAVE_CLAPACK_DPOTRF)
 #include <clapack.h>
 #else
@@ -134,6 +136,7 @@ _ncm_matrix_finalize (GObject *object)
     case NCM_MATRIX_MALLOC:
     case NCM_MATRIX_GSL_MATRIX:
     case NCM_MATRIX_DERIVED:
+    case NCM_MATRIX_ALIGNED:
       break;
     default:
       g_assert_not_reached ();
@@ -200,6 +203,28 @@ ncm_matrix_new0 (const guint nrows, const guint ncols)
   return cm;
 }
 
+/**
+ * ncm_matrix_new_aligned:
+ * @nrows: number of rows
+ * @ncols: number of columns
+ *
+ * This function allocates memory for a new #NcmMatrix of doubles
+ * with @nrows rows and @ncols columns. The rows are contiguous 
+ * (tda equal to @ncols) and the first element is aligned to 
+ * #NCM_VECTOR_ALIGNMENT bytes, the object is flagged with 
+ * #NCM_MATRIX_ALIGNED, see ncm_matrix_is_aligned().
+ *
+ * Returns: (transfer full): A new #NcmMatrix.
+ */
+NcmMatrix *
+ncm_matrix_new_aligned (const guint nrows, const guint ncols)
+{
+  gchar *p = g_malloc (sizeof (gdouble) * nrows * ncols + NCM_VECTOR_ALIGNMENT);
+  gdouble *d = (gdouble *) (((guintptr) p + NCM_VECTOR_ALIGNMENT - 1) & ~((guintptr) NCM_VECTOR_ALIGNMENT - 1));
+  NcmMatrix *cm = ncm_matrix_new_full (d, nrows, ncols, ncols, p, &g_free);
+  cm->type = NCM_MATRIX_ALIGNED;
+  return cm;
+}
 
 /**
  * ncm_matrix_new_full:
@@ -419,7 +444,9 @@ ncm_matrix_const_new_data (const gdouble *d, guint nrows, guint ncols)
  * ncm_matrix_const_new_variant:
  * @var: a variant of type "aad"
  * 
- * Creates a new constant matrix using the same memory of @var.
+ * Creates a new constant matrix using the same memory of @var. When this
+ * memory is aligned to #NCM_VECTOR_ALIGNMENT bytes the matrix is flagged
+ * with #NCM_MATRIX_ALIGNED, see ncm_matrix_is_aligned().
  * 
  * Returns: (transfer full) :a #NcmMatrix with the values from @var.
  */
@@ -434,9 +461,14 @@ ncm_matrix_const_new_variant (GVariant *var)
     gconstpointer data = g_variant_get_data (var);
     const NcmMatrix *m = ncm_matrix_const_new_data (data, nrows, ncols);
 
+    g_variant_unref (row);
+
     NCM_MATRIX (m)->pdata = g_variant_ref_sink (var);
     NCM_MATRIX (m)->pfree = (GDestroyNotify) &g_variant_unref;
 
+    if (((guintptr) data % NCM_VECTOR_ALIGNMENT) == 0)
+      NCM_MATRIX (m)->type = NCM_MATRIX_ALIGNED;
+
     return m;
   }
 }
@@ -532,7 +564,7 @@ ncm_matrix_set_from_variant (NcmMatrix *cm, GVariant *var)
     GVariant *row = g_variant_get_child_value (var, 0);
     guint nrows = g_variant_n_children (var);
     guint ncols = g_variant_n_children (row);
-    guint i, j;
+    guint i;
     g_variant_unref (row);
 
     /* Sometimes we receive a NcmMatrix in the process of instantiation. */
@@ -547,13 +579,18 @@ ncm_matrix_set_from_variant (NcmMatrix *cm, GVariant *var)
 
     for (i = 0; i < nrows; i++)
     {
+      gsize n_elements = 0;
+      const gdouble *d;
+
       row = g_variant_get_child_value (var, i);
-      for (j = 0; j < ncols; j++)
-      {
-        gdouble val = 0.0;
-        g_variant_get_child (row, j, "d", &val);
-        ncm_matrix_set (cm, i, j, val);
-      }
+      d   = g_variant_get_fixed_array (row, &n_elements, sizeof (gdouble));
+
+      if (n_elements != ncols)
+        g_error ("ncm_matrix_set_from_variant: row %u contains %zu childs, expected %u.", i, n_elements, ncols);
+
+      if (ncols > 0)
+        memcpy (ncm_matrix_ptr (cm, i, 0), d, sizeof (gdouble) * ncols);
+
       g_variant_unref (row);
     }
   }
@@ -573,20 +610,16 @@ ncm_matrix_get_variant (NcmMatrix *cm)
   guint nrows = ncm_matrix_nrows (cm);
   guint ncols = ncm_matrix_ncols (cm);
   GVariant *var;
-  GVariant **row_i_vals = g_new (GVariant *, ncols);
   GVariant **rows = g_new (GVariant *, nrows);
-  guint i, j;
+  guint i;
 
   for (i = 0; i < nrows; i++)
   {
-    for (j = 0; j < ncols; j++)
-    {
-      row_i_vals[j] = g_variant_new_double (ncm_matrix_get (cm, i, j));
-    }
-    rows[i] = g_variant_new_array (G_VARIANT_TYPE ("d"), row_i_vals, ncols);
+    rows[i] = g_variant_new_fixed_array (G_VARIANT_TYPE ("d"),
+                                         (ncols > 0) ? ncm_matrix_ptr (cm, i, 0) : NULL,
+                                         ncols, sizeof (gdouble));
   }
   var = g_variant_new_array (G_VARIANT_TYPE ("ad"), rows, nrows);
-  g_free (row_i_vals);
   g_free (rows);
   g_variant_ref_sink (var);
   return var;
@@ -883,6 +916,112 @@ ncm_matrix_dsymm (NcmMatrix *cm, gchar UL, const gdouble alpha, NcmMatrix *b, co
                ncm_matrix_data (c), ncm_matrix_gsl (c)->tda);
 }
 
+/**
+ * ncm_matrix_dsyrk:
+ * @cm: a #NcmMatrix $C$
+ * @UL: char indicating 'U'pper or 'L'ower matrix 
+ * @T: 'T' to use $A^TA$ or 'N' to use $AA^T$
+ * @alpha: a constant $\alpha$
+ * @a: a #NcmMatrix $A$
+ * @beta: a constant $\beta$
+ *
+ * Symmetric rank-k update, calculates $C = \alpha A^TA + \beta C$ 
+ * (or $C = \alpha AA^T + \beta C$ when @T is 'N') using BLAS dsyrk.
+ * Only the triangle of $C$ indicated by @UL is referenced and updated,
+ * use ncm_matrix_copy_triangle() to obtain the full matrix.
+ *
+ */
+void 
+ncm_matrix_dsyrk (NcmMatrix *cm, gchar UL, gchar T, const gdouble alpha, const NcmMatrix *a, const gdouble beta)
+{
+  const guint N = ncm_matrix_nrows (cm);
+  const guint K = (T == 'T') ? ncm_matrix_nrows (a) : ncm_matrix_ncols (a);
+
+  g_assert (UL == 'U' || UL == 'L');
+  g_assert (T == 'T' || T == 'N');
+  g_assert_cmpuint (N, ==, ncm_matrix_ncols (cm));
+  g_assert_cmpuint (N, ==, (T == 'T') ? ncm_matrix_ncols (a) : ncm_matrix_nrows (a));
+
+  cblas_dsyrk (CblasRowMajor, (UL == 'U') ? CblasUpper : CblasLower, 
+               (T == 'T') ? CblasTrans : CblasNoTrans, 
+               N, K, 
+               alpha, 
+               ncm_matrix_const_data (a), ncm_matrix_tda (a), 
+               beta, 
+               ncm_matrix_data (cm), ncm_matrix_tda (cm));
+}
+
+/**
+ * ncm_matrix_dsyr:
+ * @cm: a #NcmMatrix $C$
+ * @UL: char indicating 'U'pper or 'L'ower matrix 
+ * @alpha: a constant $\alpha$
+ * @x: a #NcmVector $x$
+ *
+ * Symmetric rank-1 update, calculates $C = \alpha xx^T + C$ using BLAS
+ * dsyr. Only the triangle of $C$ indicated by @UL is referenced and 
+ * updated.
+ *
+ */
+void 
+ncm_matrix_dsyr (NcmMatrix *cm, gchar UL, const gdouble alpha, const NcmVector *x)
+{
+  g_assert (UL == 'U' || UL == 'L');
+  g_assert_cmpuint (ncm_matrix_nrows (cm), ==, ncm_matrix_ncols (cm));
+  g_assert_cmpuint (ncm_matrix_nrows (cm), ==, ncm_vector_len (x));
+
+  cblas_dsyr (CblasRowMajor, (UL == 'U') ? CblasUpper : CblasLower, 
+              ncm_matrix_nrows (cm), 
+              alpha, 
+              ncm_vector_const_ptr (x, 0), ncm_vector_stride (x), 
+              ncm_matrix_data (cm), ncm_matrix_tda (cm));
+}
+
+/**
+ * ncm_matrix_dtrsm:
+ * @cm: a triangular #NcmMatrix $T$
+ * @UL: char indicating 'U'pper or 'L'ower matrix 
+ * @T: 'T' to solve with $T^T$ or 'N' to solve with $T$
+ * @alpha: a constant $\alpha$
+ * @b: a #NcmMatrix $B$
+ *
+ * Triangular solve with multiple right-hand sides, overwrites @b with
+ * the solution $X$ of $\text{op}(T) X = \alpha B$ using BLAS dtrsm. 
+ * The triangle of @cm indicated by @UL is used. For example, after 
+ * ncm_matrix_cholesky_decomp() with 'U', $X = L^{-1}B$ (with $LL^T$
+ * the decomposed matrix) is obtained using @UL = 'U' and @T = 'T'.
+ *
+ */
+void 
+ncm_matrix_dtrsm (NcmMatrix *cm, gchar UL, gchar T, const gdouble alpha, NcmMatrix *b)
+{
+  g_assert (UL == 'U' || UL == 'L');
+  g_assert (T == 'T' || T == 'N');
+  g_assert_cmpuint (ncm_matrix_nrows (cm), ==, ncm_matrix_ncols (cm));
+  g_assert_cmpuint (ncm_matrix_nrows (cm), ==, ncm_matrix_nrows (b));
+
+  cblas_dtrsm (CblasRowMajor, CblasLeft, (UL == 'U') ? CblasUpper : CblasLower, 
+               (T == 'T') ? CblasTrans : CblasNoTrans, CblasNonUnit, 
+               ncm_matrix_nrows (b), ncm_matrix_ncols (b), 
+               alpha, 
+               ncm_matrix_data (cm), ncm_matrix_tda (cm), 
+               ncm_matrix_data (b), ncm_matrix_tda (b));
+}
+
+/**
+ * ncm_matrix_is_aligned:
+ * @cm: a #NcmMatrix
+ *
+ * Checks whether @cm was allocated by ncm_matrix_new_aligned().
+ *
+ * Returns: whether @cm is contiguous and aligned to #NCM_VECTOR_ALIGNMENT bytes.
+ */
+gboolean
+ncm_matrix_is_aligned (const NcmMatrix *cm)
+{
+  return (cm->type == NCM_MATRIX_ALIGNED);
+}
+
 /**
  * ncm_matrix_cholesky_decomp:
  * @cm: a #NcmMatrix
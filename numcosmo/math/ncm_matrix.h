@@ -52,6 +52,7 @@ typedef struct _NcmMatrix NcmMatrix;
  * @NCM_MATRIX_MALLOC: FIXME
  * @NCM_MATRIX_GARRAY: FIXME
  * @NCM_MATRIX_DERIVED: FIXME
+ * @NCM_MATRIX_ALIGNED: contiguous data aligned to #NCM_VECTOR_ALIGNMENT bytes
  *
  * FIXME
  *
@@ -63,6 +64,7 @@ typedef enum _NcmMatrixInternal
   NCM_MATRIX_MALLOC,
   NCM_MATRIX_GARRAY,
   NCM_MATRIX_DERIVED,
+  NCM_MATRIX_ALIGNED,
 } NcmMatrixInternal;
 
 struct _NcmMatrixClass
@@ -90,6 +92,7 @@ GType ncm_matrix_get_type (void) G_GNUC_CONST;
 
 NcmMatrix *ncm_matrix_new (const guint nrows, const guint ncols);
 NcmMatrix *ncm_matrix_new0 (const guint nrows, const guint ncols);
+NcmMatrix *ncm_matrix_new_aligned (const guint nrows, const guint ncols);
 NcmMatrix *ncm_matrix_new_full (gdouble *d, guint nrows, guint ncols, guint tda, gpointer pdata, GDestroyNotify pfree);
 NcmMatrix *ncm_matrix_new_gsl (gsl_matrix *gm);
 NcmMatrix *ncm_matrix_new_gsl_static (gsl_matrix *gm);
@@ -153,6 +156,10 @@ void ncm_matrix_const_free (const NcmMatrix *cm);
 
 void ncm_matrix_copy_triangle (NcmMatrix *cm, gchar UL);
 void ncm_matrix_dsymm (NcmMatrix *cm, gchar UL, const gdouble alpha, NcmMatrix *b, const gdouble beta, NcmMatrix *c);
+void ncm_matrix_dsyrk (NcmMatrix *cm, gchar UL, gchar T, const gdouble alpha, const NcmMatrix *a, const gdouble beta);
+void ncm_matrix_dsyr (NcmMatrix *cm, gchar UL, const gdouble alpha, const NcmVector *x);
+void ncm_matrix_dtrsm (NcmMatrix *cm, gchar UL, gchar T, const gdouble alpha, NcmMatrix *b);
+gboolean ncm_matrix_is_aligned (const NcmMatrix *cm);
 
 gint ncm_matrix_cholesky_decomp (NcmMatrix *cm, gchar UL);
 gint ncm_matrix_cholesky_inverse (NcmMatrix *cm, gchar UL);
@@ -340,6 +340,11 @@ ncm_model_init (NcmModel *model)
   model->pkey    = 1;
   model->skey    = 0;
   model->reparam = NULL;
+
+  model->pstamp        = g_array_new (FALSE, TRUE, sizeof (guint64));
+  model->pstamp_params = NULL;
+  model->pstamp_key    = 0;
+  g_mutex_init (&model->pstamp_lock);
   model->ptypes  = g_array_new (FALSE, TRUE, sizeof (NcmParamType));
 
   model->submodel_array   = g_ptr_array_new ();
@@ -430,6 +435,7 @@ _ncm_model_dispose (GObject *object)
 
   ncm_vector_clear (&model->params);
   ncm_vector_clear (&model->p);
+  ncm_vector_clear (&model->pstamp_params);
 
   ncm_reparam_clear (&model->reparam);
 
@@ -449,6 +455,10 @@ _ncm_model_dispose (GObject *object)
 static void
 _ncm_model_finalize (GObject *object)
 {
+  NcmModel *model = NCM_MODEL (object);
+
+  g_array_unref (model->pstamp);
+  g_mutex_clear (&model->pstamp_lock);
 
   /* Chain up : end */
   G_OBJECT_CLASS (ncm_model_parent_class)->finalize (object);
@@ -1303,6 +1313,111 @@ ncm_model_params_save_as_default (NcmModel *model)
   }
 }
 
+/**
+ * ncm_model_state_mark_outdated:
+ * @model: a #NcmModel
+ *
+ * Marks every parameter of @model as changed, this must be called when
+ * a change in @model that is not reflected in its parameters (e.g. a
+ * change in a non-parameter property) invalidates the objects prepared
+ * with it.
+ *
+ */
+void
+ncm_model_state_mark_outdated (NcmModel *model)
+{
+  g_mutex_lock (&model->pstamp_lock);
+  ncm_vector_clear (&model->pstamp_params);
+  g_mutex_unlock (&model->pstamp_lock);
+  model->pkey++;
+}
+
+static void
+_ncm_model_params_update_stamps (NcmModel *model)
+{
+  const guint len = model->total_len;
+  guint i;
+
+  if ((model->pstamp_params != NULL) && (model->pstamp_key == model->pkey))
+    return;
+
+  if ((model->pstamp_params == NULL) || (ncm_vector_len (model->pstamp_params) != len))
+  {
+    ncm_vector_clear (&model->pstamp_params);
+    model->pstamp_params = ncm_vector_dup (model->params);
+
+    g_array_set_size (model->pstamp, len);
+    for (i = 0; i < len; i++)
+      g_array_index (model->pstamp, guint64, i) = model->pkey;
+  }
+  else
+  {
+    for (i = 0; i < len; i++)
+    {
+      const gdouble p_i = ncm_vector_get (model->params, i);
+
+      if (p_i != ncm_vector_get (model->pstamp_params, i))
+      {
+        ncm_vector_set (model->pstamp_params, i, p_i);
+        g_array_index (model->pstamp, guint64, i) = model->pkey;
+      }
+    }
+  }
+
+  model->pstamp_key = model->pkey;
+}
+
+/**
+ * ncm_model_params_update_stamps:
+ * @model: a #NcmModel
+ *
+ * Updates the per-parameter change stamps of @model. The stamp of each
+ * parameter whose value differs from the one it had in the last call
+ * is set to the current value of the parameter key. The comparison is
+ * done lazily, that is, the parameter setters only increment the key
+ * and this function is called by the consumers interested in which
+ * parameters changed (see ncm_model_ctrl_add_dep()).
+ *
+ * The stamps are updated under a lock in @model, so several threads can
+ * call this function and ncm_model_param_get_stamp() concurrently, e.g.,
+ * when the #NcmData of a #NcmDataset are evaluated in parallel (see
+ * ncm_dataset_set_nthreads()), as long as no thread changes the
+ * parameters at the same time.
+ *
+ */
+void
+ncm_model_params_update_stamps (NcmModel *model)
+{
+  g_mutex_lock (&model->pstamp_lock);
+  _ncm_model_params_update_stamps (model);
+  g_mutex_unlock (&model->pstamp_lock);
+}
+
+/**
+ * ncm_model_param_get_stamp:
+ * @model: a #NcmModel
+ * @n: parameter index
+ *
+ * Gets the value of the parameter key when the @n-th original parameter
+ * last changed, see ncm_model_params_update_stamps().
+ *
+ * Returns: the stamp of the @n-th parameter.
+ */
+guint64
+ncm_model_param_get_stamp (NcmModel *model, guint n)
+{
+  guint64 stamp;
+
+  g_assert_cmpuint (n, <, model->total_len);
+
+  g_mutex_lock (&model->pstamp_lock);
+  _ncm_model_params_update_stamps (model);
+  stamp = g_array_index (model->pstamp, guint64, n);
+  g_mutex_unlock (&model->pstamp_lock);
+
+  return stamp;
+}
+
 /**
  * ncm_model_params_copyto:
  * @model: a #NcmModel
@@ -94,6 +94,10 @@ struct _NcmModel
   guint total_len;
   guint64 pkey;
   guint64 skey;
+  GArray *pstamp;
+  NcmVector *pstamp_params;
+  guint64 pstamp_key;
+  GMutex pstamp_lock;
 };
 
 typedef gdouble (*NcmModelFunc0) (NcmModel *model);
@@ -130,6 +134,9 @@ G_INLINE_FUNC gboolean ncm_model_check_impl (NcmModel *model, guint64 impl);
 G_INLINE_FUNC guint ncm_model_len (NcmModel *model);
 G_INLINE_FUNC gboolean ncm_model_state_is_update (NcmModel *model);
 G_INLINE_FUNC void ncm_model_state_set_update (NcmModel *model);
+void ncm_model_state_mark_outdated (NcmModel *model);
+void ncm_model_params_update_stamps (NcmModel *model);
+guint64 ncm_model_param_get_stamp (NcmModel *model, guint n);
 
 G_INLINE_FUNC guint ncm_model_sparam_len (NcmModel *model);
 G_INLINE_FUNC guint ncm_model_vparam_array_len (NcmModel *model);
@@ -27,7 +27,15 @@
  * @title: NcmModelCtrl
  * @short_description: Control object for testing updates on model status.
  *
- * FIXME
+ * A #NcmModelCtrl keeps track of the last #NcmModel (and its submodels)
+ * used to prepare an object, ncm_model_ctrl_update() returns TRUE when
+ * the model or any of its parameters changed since the last call.
+ *
+ * Objects depending only on a subset of the parameters can declare it
+ * using ncm_model_ctrl_add_dep() or ncm_model_ctrl_add_indep(). In this
+ * case the per-parameter change stamps of the model (see
+ * ncm_model_params_update_stamps()) are used and only changes in the
+ * relevant parameters are reported.
  *
  */
 
@@ -57,6 +65,10 @@ ncm_model_ctrl_init (NcmModelCtrl *ctrl)
   g_ptr_array_set_free_func (ctrl->submodel_ctrl, (GDestroyNotify) ncm_model_ctrl_free);
 
   ctrl->submodel_last_update = g_array_new (TRUE, TRUE, sizeof (gboolean));
+
+  ctrl->dep_names   = g_ptr_array_new_with_free_func (g_free);
+  ctrl->indep_names = g_ptr_array_new_with_free_func (g_free);
+  ctrl->dep_mask    = g_array_new (FALSE, FALSE, sizeof (gboolean));
 }
 
 static void
@@ -69,6 +81,10 @@ ncm_model_ctrl_dispose (GObject *object)
   g_clear_pointer (&ctrl->submodel_ctrl, g_ptr_array_unref);
   g_clear_pointer (&ctrl->submodel_last_update, g_array_unref);
 
+  g_clear_pointer (&ctrl->dep_names, g_ptr_array_unref);
+  g_clear_pointer (&ctrl->indep_names, g_ptr_array_unref);
+  g_clear_pointer (&ctrl->dep_mask, g_array_unref);
+
   /* Chain up : end */
   G_OBJECT_CLASS (ncm_model_ctrl_parent_class)->dispose (object);
 }
@@ -229,6 +245,11 @@ ncm_model_ctrl_set_model (NcmModelCtrl *ctrl, NcmModel *model)
     g_weak_ref_set (&ctrl->model_wr, model);
     ctrl->pkey  = model->pkey;
     up          = TRUE;
+
+    /* The parameter indexes depend on the model, resolve them again. */
+    g_array_set_size (ctrl->dep_mask, 0);
+    if (ctrl->dep_names->len + ctrl->indep_names->len > 0)
+      ncm_model_params_update_stamps (model);
   }
 
   {
@@ -295,6 +316,136 @@ ncm_model_ctrl_force_update (NcmModelCtrl *ctrl)
   return;
 }
 
+/**
+ * ncm_model_ctrl_add_dep:
+ * @ctrl: a #NcmModelCtrl
+ * @param_name: a parameter name
+ *
+ * Declares that the object using @ctrl depends on the parameter named
+ * @param_name of the main model. Once at least one dependency is added
+ * ncm_model_ctrl_update() reports an update of the main model only when
+ * one of the declared parameters changed. For vector parameters
+ * @param_name refers to the whole vector (see ncm_vparam_name()).
+ * Names not present in the model are ignored. Changes in the submodels
+ * are always reported.
+ *
+ */
+void
+ncm_model_ctrl_add_dep (NcmModelCtrl *ctrl, const gchar *param_name)
+{
+  g_ptr_array_add (ctrl->dep_names, g_strdup (param_name));
+  g_array_set_size (ctrl->dep_mask, 0);
+}
+
+/**
+ * ncm_model_ctrl_add_indep:
+ * @ctrl: a #NcmModelCtrl
+ * @param_name: a parameter name
+ *
+ * Declares that the object using @ctrl does not depend on the parameter
+ * named @param_name of the main model, i.e., changes in this parameter
+ * alone do not trigger an update. See ncm_model_ctrl_add_dep().
+ *
+ */
+void
+ncm_model_ctrl_add_indep (NcmModelCtrl *ctrl, const gchar *param_name)
+{
+  g_ptr_array_add (ctrl->indep_names, g_strdup (param_name));
+  g_array_set_size (ctrl->dep_mask, 0);
+}
+
+/**
+ * ncm_model_ctrl_clear_deps:
+ * @ctrl: a #NcmModelCtrl
+ *
+ * Removes all declared dependencies, after this call any parameter
+ * change triggers an update.
+ *
+ */
+void
+ncm_model_ctrl_clear_deps (NcmModelCtrl *ctrl)
+{
+  g_ptr_array_set_size (ctrl->dep_names, 0);
+  g_ptr_array_set_size (ctrl->indep_names, 0);
+  g_array_set_size (ctrl->dep_mask, 0);
+}
+
+static void
+_ncm_model_ctrl_mask_names (NcmModelCtrl *ctrl, NcmModel *model, GPtrArray *names, gboolean val)
+{
+  NcmModelClass *model_class = NCM_MODEL_GET_CLASS (model);
+  guint k;
+
+  for (k = 0; k < names->len; k++)
+  {
+    const gchar *name = g_ptr_array_index (names, k);
+    guint i;
+
+    for (i = 0; i < model_class->sparam_len; i++)
+    {
+      if (g_strcmp0 (ncm_sparam_name (g_ptr_array_index (model_class->sparam, i)), name) == 0)
+        g_array_index (ctrl->dep_mask, gboolean, i) = val;
+    }
+
+    for (i = 0; i < model_class->vparam_len; i++)
+    {
+      if (g_strcmp0 (ncm_vparam_name (g_ptr_array_index (model_class->vparam, i)), name) == 0)
+      {
+        const guint len = ncm_model_vparam_len (model, i);
+        guint j;
+
+        for (j = 0; j < len; j++)
+          g_array_index (ctrl->dep_mask, gboolean, ncm_model_vparam_index (model, i, j)) = val;
+      }
+    }
+  }
+}
+
+/**
+ * ncm_model_ctrl_params_changed:
+ * @ctrl: a #NcmModelCtrl
+ * @model: a #NcmModel
+ *
+ * Checks if any parameter of @model which @ctrl depends on changed since
+ * the last update of @ctrl (see ncm_model_ctrl_add_dep()). When no
+ * dependency was declared it returns TRUE whenever the parameter key of
+ * @model changed. This function does not update @ctrl, it is used by
+ * ncm_model_ctrl_update().
+ *
+ * Returns: whether a relevant parameter of @model changed.
+ */
+gboolean
+ncm_model_ctrl_params_changed (NcmModelCtrl *ctrl, NcmModel *model)
+{
+  const guint len = ncm_model_len (model);
+  guint i;
+
+  if (ctrl->dep_names->len + ctrl->indep_names->len == 0)
+    return (ctrl->pkey != model->pkey);
+
+  if (ctrl->dep_mask->len != len)
+  {
+    const gboolean all = (ctrl->dep_names->len == 0);
+
+    g_array_set_size (ctrl->dep_mask, len);
+    for (i = 0; i < len; i++)
+      g_array_index (ctrl->dep_mask, gboolean, i) = all;
+
+    _ncm_model_ctrl_mask_names (ctrl, model, ctrl->dep_names, TRUE);
+    _ncm_model_ctrl_mask_names (ctrl, model, ctrl->indep_names, FALSE);
+  }
+
+  ncm_model_params_update_stamps (model);
+
+  for (i = 0; i < len; i++)
+  {
+    if (g_array_index (ctrl->dep_mask, gboolean, i) && (g_array_index (model->pstamp, guint64, i) > ctrl->pkey))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
 /**
  * ncm_model_ctrl_free:
  * @ctrl: a #NcmModelCtrl
@@ -58,6 +58,9 @@ struct _NcmModelCtrl
   gboolean last_update;
   GPtrArray *submodel_ctrl;
   GArray *submodel_last_update;
+  GPtrArray *dep_names;
+  GPtrArray *indep_names;
+  GArray *dep_mask;
 };
 
 GType ncm_model_ctrl_get_type (void) G_GNUC_CONST;
@@ -65,6 +68,10 @@ GType ncm_model_ctrl_get_type (void) G_GNUC_CONST;
 NcmModelCtrl *ncm_model_ctrl_new (NcmModel *model);
 gboolean ncm_model_ctrl_set_model (NcmModelCtrl *ctrl, NcmModel *model);
 void ncm_model_ctrl_force_update (NcmModelCtrl *ctrl);
+void ncm_model_ctrl_add_dep (NcmModelCtrl *ctrl, const gchar *param_name);
+void ncm_model_ctrl_add_indep (NcmModelCtrl *ctrl, const gchar *param_name);
+void ncm_model_ctrl_clear_deps (NcmModelCtrl *ctrl);
+gboolean ncm_model_ctrl_params_changed (NcmModelCtrl *ctrl, NcmModel *model);
 void ncm_model_ctrl_free (NcmModelCtrl *ctrl);
 void ncm_model_ctrl_clear (NcmModelCtrl **ctrl);
 
@@ -106,8 +113,8 @@ ncm_model_ctrl_update (NcmModelCtrl *ctrl, NcmModel *model)
   }
   else if (ctrl->pkey != model->pkey)
   {
+    ctrl->last_update = ncm_model_ctrl_params_changed (ctrl, model);
     ctrl->pkey = model->pkey;
-    ctrl->last_update = TRUE;
   }
   up = up || ctrl->last_update;
 
@@ -41,6 +41,7 @@
 #include "math/ncm_serialize.h"
 #include "math/ncm_cfg.h"
 #include "math/ncm_obj_array.h"
+#include "math/ncm_workspace.h"
 
 enum
 {
@@ -1821,6 +1822,7 @@ ncm_mset_param_set_ftype_from_fmap (NcmMSet *mset)
 void
 ncm_mset_param_set_vector (NcmMSet *mset, NcmVector *params)
 {
+  NcmWorkspace *ws = ncm_workspace_peek ();
   guint i;
   guint j = 0;
 
@@ -1833,9 +1835,9 @@ ncm_mset_param_set_vector (NcmMSet *mset, NcmVector *params)
       continue;
     else
     {
-      NcmVector *mvec = ncm_vector_get_subvector (params, j, item->added_total_params);
+      NcmVector *mvec = ncm_workspace_borrow_subvector (ws, params, j, item->added_total_params);
       ncm_model_params_set_vector (item->model, mvec);
-      ncm_vector_free (mvec);
+      ncm_workspace_return_vector (ws, mvec);
       j += item->added_total_params;
     }
   }
@@ -2435,6 +2437,53 @@ ncm_mset_fparam_get_fpi (NcmMSet *mset, NcmModelID mid, guint pid)
   }
 }
 
+/**
+ * ncm_mset_fparams_get_blocks:
+ * @mset: a #NcmMSet
+ *
+ * Groups the free parameters by the model they belong to. Each element of
+ * the returned array is a #GArray of guint containing the free parameter 
+ * indices of one model in @mset, models without free parameters are skipped.
+ * The blocks follow the order of the models in @mset.
+ *
+ * Returns: (transfer full) (element-type GArray): the free parameters blocks.
+ */
+GPtrArray *
+ncm_mset_fparams_get_blocks (NcmMSet *mset)
+{
+  GPtrArray *blocks = g_ptr_array_new_with_free_func ((GDestroyNotify) g_array_unref);
+  guint i;
+
+  g_assert (mset->valid_map);
+
+  for (i = 0; i < mset->model_array->len; i++)
+  {
+    NcmMSetItem *item = g_ptr_array_index (mset->model_array, i);
+
+    if (item->dup)
+      continue;
+    else
+    {
+      GArray *block = g_array_new (FALSE, FALSE, sizeof (guint));
+      guint n;
+
+      for (n = 0; n < mset->fparam_len; n++)
+      {
+        const NcmMSetPIndex *pi = &g_array_index (mset->pi_array, NcmMSetPIndex, n);
+        if (pi->mid == item->mid)
+          g_array_append_val (block, n);
+      }
+
+      if (block->len > 0)
+        g_ptr_array_add (blocks, block);
+      else
+        g_array_unref (block);
+    }
+  }
+
+  return blocks;
+}
+
 /**
  * ncm_mset_fparam_get_pi_by_name:
  * @mset: a #NcmMSet
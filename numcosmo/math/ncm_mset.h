@@ -250,6 +250,7 @@ void ncm_mset_fparam_set (NcmMSet *mset, guint n, const gdouble x);
 const NcmMSetPIndex *ncm_mset_fparam_get_pi (NcmMSet *mset, guint n);
 gint ncm_mset_fparam_get_fpi (NcmMSet *mset, NcmModelID mid, guint pid);
 const NcmMSetPIndex *ncm_mset_fparam_get_pi_by_name (NcmMSet *mset, const gchar *name);
+GPtrArray *ncm_mset_fparams_get_blocks (NcmMSet *mset);
 
 void ncm_mset_save (NcmMSet *mset, NcmSerialize *ser, const gchar *filename, gboolean save_comment);
 NcmMSet *ncm_mset_load (const gchar *filename, NcmSerialize *ser);
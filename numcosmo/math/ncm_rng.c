@@ -30,6 +30,17 @@
  *
  * This object encapsulates the GSL pseudo random number generator (PRNG). The purpose is to
  * add support for saving and loading state and multhreading.
+ *
+ * Besides the GSL algorithms, #NcmRNG provides the counter-based generator
+ * Philox4x32-10 (algorithm name "philox4x32-10"), see
+ * [Salmon et al. (2011)](http://dx.doi.org/10.1145/2063384.2063405).
+ * Its state is a 128 bit counter and a 64 bit key, therefore it can be
+ * advanced by an arbitrary number of draws in constant time, see
+ * ncm_rng_skip() and ncm_rng_jump(). Independent streams are obtained by
+ * deriving a key from a parent #NcmRNG and a stream identifier, see
+ * ncm_rng_stream_new(). Each thread can then use its own stream without
+ * locking, and the numbers drawn by a given stream do not depend on how the
+ * work was scheduled among the threads.
  * 
  */
 
@@ -41,6 +52,128 @@
 #include "math/ncm_rng.h"
 #include "math/ncm_cfg.h"
 
+#include <string.h>
+#include <math.h>
+#include <gsl/gsl_randist.h>
+
+/*
+ * Philox4x32-10 counter-based generator wrapped as a gsl_rng_type.
+ */
+
+#define NCM_RNG_PHILOX_M0 (0xD2511F53U)
+#define NCM_RNG_PHILOX_M1 (0xCD9E8D57U)
+#define NCM_RNG_PHILOX_W0 (0x9E3779B9U)
+#define NCM_RNG_PHILOX_W1 (0xBB67AE85U)
+#define NCM_RNG_PHILOX_ROUNDS (10)
+#define NCM_RNG_PHILOX_NAME NCM_RNG_STREAM_ALGO
+
+typedef struct _NcmRNGPhiloxState
+{
+  guint32 ctr[4];
+  guint32 key[2];
+  guint32 out[4];
+  guint32 idx;
+} NcmRNGPhiloxState;
+
+static inline void
+_ncm_rng_philox_block (const guint32 ctr_in[4], const guint32 key_in[2], guint32 out[4])
+{
+  guint32 ctr[4] = {ctr_in[0], ctr_in[1], ctr_in[2], ctr_in[3]};
+  guint32 key[2] = {key_in[0], key_in[1]};
+  gint r;
+
+  for (r = 0; r < NCM_RNG_PHILOX_ROUNDS; r++)
+  {
+    const guint64 p0 = ((guint64) NCM_RNG_PHILOX_M0) * ctr[0];
+    const guint64 p1 = ((guint64) NCM_RNG_PHILOX_M1) * ctr[2];
+    const guint32 hi0 = p0 >> 32;
+    const guint32 lo0 = (guint32) p0;
+    const guint32 hi1 = p1 >> 32;
+    const guint32 lo1 = (guint32) p1;
+
+    ctr[0] = hi1 ^ ctr[1] ^ key[0];
+    ctr[1] = lo1;
+    ctr[2] = hi0 ^ ctr[3] ^ key[1];
+    ctr[3] = lo0;
+
+    key[0] += NCM_RNG_PHILOX_W0;
+    key[1] += NCM_RNG_PHILOX_W1;
+  }
+
+  out[0] = ctr[0];
+  out[1] = ctr[1];
+  out[2] = ctr[2];
+  out[3] = ctr[3];
+}
+
+static inline void
+_ncm_rng_philox_ctr_add (NcmRNGPhiloxState *s, guint64 n)
+{
+  const guint64 lo  = ((guint64) s->ctr[0]) | (((guint64) s->ctr[1]) << 32);
+  const guint64 nlo = lo + n;
+
+  s->ctr[0] = (guint32) nlo;
+  s->ctr[1] = (guint32) (nlo >> 32);
+
+  if (nlo < lo)
+  {
+    const guint64 hi = (((guint64) s->ctr[2]) | (((guint64) s->ctr[3]) << 32)) + 1;
+    s->ctr[2] = (guint32) hi;
+    s->ctr[3] = (guint32) (hi >> 32);
+  }
+}
+
+static inline void
+_ncm_rng_philox_refill (NcmRNGPhiloxState *s)
+{
+  _ncm_rng_philox_block (s->ctr, s->key, s->out);
+  _ncm_rng_philox_ctr_add (s, 1);
+  s->idx = 0;
+}
+
+static void
+_ncm_rng_philox_set (void *vstate, unsigned long int seed)
+{
+  NcmRNGPhiloxState *s = (NcmRNGPhiloxState *) vstate;
+  const guint64 key    = seed;
+
+  memset (s, 0, sizeof (NcmRNGPhiloxState));
+  s->key[0] = (guint32) key;
+  s->key[1] = (guint32) (key >> 32);
+  s->idx    = 4;
+}
+
+static unsigned long int
+_ncm_rng_philox_get (void *vstate)
+{
+  NcmRNGPhiloxState *s = (NcmRNGPhiloxState *) vstate;
+
+  if (s->idx == 4)
+    _ncm_rng_philox_refill (s);
+
+  return s->out[s->idx++];
+}
+
+static double
+_ncm_rng_philox_get_double (void *vstate)
+{
+  return _ncm_rng_philox_get (vstate) / 4294967296.0;
+}
+
+static const gsl_rng_type _ncm_rng_philox_type = {
+  NCM_RNG_PHILOX_NAME,
+  0xffffffffUL,
+  0,
+  sizeof (NcmRNGPhiloxState),
+  &_ncm_rng_philox_set,
+  &_ncm_rng_philox_get,
+  &_ncm_rng_philox_get_double
+};
+
+#define _NCM_RNG_IS_PHILOX(rng) ((rng)->r->type == &_ncm_rng_philox_type)
+
+G_LOCK_DEFINE_STATIC (seed_hash_lock);
+
 enum
 {
   PROP_0,
@@ -324,7 +457,9 @@ ncm_rng_set_algo (NcmRNG *rng, const gchar *algo)
   const gsl_rng_type *type;
   gboolean found = FALSE;
   
-  if (algo != NULL)
+  if ((algo != NULL) && (strcmp (algo, NCM_RNG_PHILOX_NAME) == 0))
+    type = &_ncm_rng_philox_type;
+  else if (algo != NULL)
   {
     const gsl_rng_type **t;
     const gsl_rng_type **t0;
@@ -347,7 +482,7 @@ ncm_rng_set_algo (NcmRNG *rng, const gchar *algo)
 
   if (rng->r == NULL)
     rng->r = gsl_rng_alloc (type);
-  else if (strcmp (gsl_rng_name (rng->r), algo) != 0)
+  else if (rng->r->type != type)
   {
     gsl_rng_free (rng->r);
     rng->r = gsl_rng_alloc (type);
@@ -390,7 +525,12 @@ ncm_rng_check_seed (NcmRNG *rng, gulong seed)
 {
   NcmRNGClass *rng_class = NCM_RNG_GET_CLASS (rng);
   gint seed_int = seed;
-  gpointer b = g_hash_table_lookup (rng_class->seed_hash, GINT_TO_POINTER (seed_int));
+  gpointer b;
+
+  G_LOCK (seed_hash_lock);
+  b = g_hash_table_lookup (rng_class->seed_hash, GINT_TO_POINTER (seed_int));
+  G_UNLOCK (seed_hash_lock);
+
   return GPOINTER_TO_INT (b) == 0;
 }
 
@@ -411,7 +551,9 @@ ncm_rng_set_seed (NcmRNG *rng, gulong seed)
     NcmRNGClass *rng_class = NCM_RNG_GET_CLASS (rng);    
     gint seed_int = seed;
     gsl_rng_set (rng->r, seed);
+    G_LOCK (seed_hash_lock);
     g_hash_table_insert (rng_class->seed_hash, GINT_TO_POINTER (seed_int), GINT_TO_POINTER (1));
+    G_UNLOCK (seed_hash_lock);
     rng->seed_set = TRUE;
   }
 }
@@ -444,12 +586,275 @@ void
 ncm_rng_set_random_seed (NcmRNG *rng, gboolean allow_colisions)
 {
   NcmRNGClass *rng_class = NCM_RNG_GET_CLASS (rng);        
-  gulong seed = g_rand_int (rng_class->seed_gen) + 1;
+  gulong seed;
+
+  G_LOCK (seed_hash_lock);
+  seed = g_rand_int (rng_class->seed_gen) + 1;
+  G_UNLOCK (seed_hash_lock);
+
   while (!ncm_rng_check_seed (rng, seed))
+  {
+    G_LOCK (seed_hash_lock);
     seed = g_rand_int (rng_class->seed_gen) + 1;
+    G_UNLOCK (seed_hash_lock);
+  }
   ncm_rng_set_seed (rng, seed);
 }
 
+static inline guint64
+_ncm_rng_splitmix64 (guint64 x)
+{
+  x += G_GUINT64_CONSTANT (0x9E3779B97F4A7C15);
+  x  = (x ^ (x >> 30)) * G_GUINT64_CONSTANT (0xBF58476D1CE4E5B9);
+  x  = (x ^ (x >> 27)) * G_GUINT64_CONSTANT (0x94D049BB133111EB);
+  return x ^ (x >> 31);
+}
+
+static guint64
+_ncm_rng_state_hash (NcmRNG *rng)
+{
+  const guchar *name  = (const guchar *) gsl_rng_name (rng->r);
+  const guchar *state = gsl_rng_state (rng->r);
+  const gsize len     = gsl_rng_size (rng->r);
+  guint64 h           = G_GUINT64_CONSTANT (0xCBF29CE484222325);
+  gsize i;
+
+  for (i = 0; name[i] != '\0'; i++)
+  {
+    h ^= name[i];
+    h *= G_GUINT64_CONSTANT (0x100000001B3);
+  }
+  for (i = 0; i < len; i++)
+  {
+    h ^= state[i];
+    h *= G_GUINT64_CONSTANT (0x100000001B3);
+  }
+
+  return h;
+}
+
+/**
+ * ncm_rng_stream_new:
+ * @parent: a #NcmRNG
+ * @stream_id: stream identifier
+ * 
+ * Creates a new Philox4x32-10 #NcmRNG positioned at the beginning of the
+ * stream @stream_id derived from the current state of @parent, see
+ * ncm_rng_stream_set().
+ * 
+ * Returns: (transfer full): a new #NcmRNG.
+ */
+NcmRNG *
+ncm_rng_stream_new (NcmRNG *parent, guint64 stream_id)
+{
+  NcmRNG *rng = ncm_rng_new (NCM_RNG_PHILOX_NAME);
+  ncm_rng_stream_set (rng, parent, stream_id);
+  return rng;
+}
+
+/**
+ * ncm_rng_stream_set:
+ * @rng: a Philox4x32-10 #NcmRNG
+ * @parent: a #NcmRNG
+ * @stream_id: stream identifier
+ * 
+ * Positions @rng at the beginning of the stream @stream_id derived from
+ * @parent. The key of @rng is obtained hashing the algorithm name and the
+ * state of @parent together with @stream_id, and its counter is set to zero.
+ * Thus, the same parent state and @stream_id always produce the same
+ * sequence, different identifiers produce independent sequences, and
+ * @parent itself is not modified.
+ * 
+ * This function only reads @parent, so any number of threads can derive
+ * streams from the same parent as long as no thread draws from it at the
+ * same time.
+ * 
+ */
+void
+ncm_rng_stream_set (NcmRNG *rng, NcmRNG *parent, guint64 stream_id)
+{
+  NcmRNGPhiloxState *s;
+  guint64 key;
+
+  if (!_NCM_RNG_IS_PHILOX (rng))
+    g_error ("ncm_rng_stream_set: streams require the `%s' algorithm, got `%s'.", 
+             NCM_RNG_PHILOX_NAME, ncm_rng_get_algo (rng));
+
+  key = _ncm_rng_splitmix64 (_ncm_rng_state_hash (parent) ^ _ncm_rng_splitmix64 (stream_id));
+  s   = gsl_rng_state (rng->r);
+
+  _ncm_rng_philox_set (s, 0);
+  s->key[0] = (guint32) key;
+  s->key[1] = (guint32) (key >> 32);
+}
+
+/**
+ * ncm_rng_skip:
+ * @rng: a #NcmRNG
+ * @n: number of draws
+ * 
+ * Advances @rng by @n draws, i.e., the state of @rng becomes the same as
+ * after calling gsl_rng_get() @n times. For Philox4x32-10 this is done in
+ * constant time, for the other algorithms the draws are actually computed.
+ * 
+ */
+void
+ncm_rng_skip (NcmRNG *rng, guint64 n)
+{
+  if (_NCM_RNG_IS_PHILOX (rng))
+  {
+    NcmRNGPhiloxState *s = gsl_rng_state (rng->r);
+    const guint64 buf    = MIN (n, 4 - s->idx);
+    guint64 rem;
+
+    s->idx += buf;
+    n      -= buf;
+    rem     = n % 4;
+
+    _ncm_rng_philox_ctr_add (s, n / 4);
+    if (rem > 0)
+    {
+      _ncm_rng_philox_refill (s);
+      s->idx = rem;
+    }
+  }
+  else
+  {
+    guint64 i;
+    for (i = 0; i < n; i++)
+      gsl_rng_get (rng->r);
+  }
+}
+
+/**
+ * ncm_rng_jump:
+ * @rng: a Philox4x32-10 #NcmRNG
+ * 
+ * Advances the counter of @rng by $2^{64}$ blocks and discards the buffered
+ * outputs. Successive jumps provide $2^{64}$ non-overlapping substreams of
+ * $2^{66}$ draws each. Only available for Philox4x32-10.
+ * 
+ */
+void
+ncm_rng_jump (NcmRNG *rng)
+{
+  NcmRNGPhiloxState *s;
+  guint64 hi;
+
+  if (!_NCM_RNG_IS_PHILOX (rng))
+    g_error ("ncm_rng_jump: jump is only available for `%s', got `%s'.", 
+             NCM_RNG_PHILOX_NAME, ncm_rng_get_algo (rng));
+
+  s  = gsl_rng_state (rng->r);
+  hi = (((guint64) s->ctr[2]) | (((guint64) s->ctr[3]) << 32)) + 1;
+
+  s->ctr[2] = (guint32) hi;
+  s->ctr[3] = (guint32) (hi >> 32);
+  s->idx    = 4;
+}
+
+/**
+ * ncm_rng_uniform_fill:
+ * @rng: a #NcmRNG
+ * @v: a #NcmVector
+ * @xl: lower limit
+ * @xu: upper limit
+ * 
+ * Fills @v with uniform variates in $[x_l, x_u)$. It consumes one draw per
+ * element, as calling ncm_rng_uniform_gen() for each element in order. For
+ * Philox4x32-10 whole blocks are generated directly into @v. This function
+ * does not lock @rng.
+ * 
+ */
+void
+ncm_rng_uniform_fill (NcmRNG *rng, NcmVector *v, gdouble xl, gdouble xu)
+{
+  const guint len     = ncm_vector_len (v);
+  const gdouble delta = xu - xl;
+  guint i = 0;
+
+  if (_NCM_RNG_IS_PHILOX (rng))
+  {
+    NcmRNGPhiloxState *s = gsl_rng_state (rng->r);
+
+    for (; (i < len) && (s->idx < 4); i++)
+      ncm_vector_set (v, i, xl + delta * (s->out[s->idx++] / 4294967296.0));
+
+    for (; i + 4 <= len; i += 4)
+    {
+      guint32 out[4];
+
+      _ncm_rng_philox_block (s->ctr, s->key, out);
+      _ncm_rng_philox_ctr_add (s, 1);
+
+      ncm_vector_set (v, i + 0, xl + delta * (out[0] / 4294967296.0));
+      ncm_vector_set (v, i + 1, xl + delta * (out[1] / 4294967296.0));
+      ncm_vector_set (v, i + 2, xl + delta * (out[2] / 4294967296.0));
+      ncm_vector_set (v, i + 3, xl + delta * (out[3] / 4294967296.0));
+    }
+  }
+
+  for (; i < len; i++)
+    ncm_vector_set (v, i, gsl_ran_flat (rng->r, xl, xu));
+}
+
+/**
+ * ncm_rng_gaussian_fill:
+ * @rng: a #NcmRNG
+ * @v: a #NcmVector
+ * @mu: mean
+ * @sigma: standard deviation
+ * 
+ * Fills @v with Gaussian variates with mean @mu and standard deviation
+ * @sigma. For Philox4x32-10 the outputs still buffered in @rng are
+ * discarded and each new block of four draws is generated directly and
+ * transformed into four variates using the Box-Muller method, the unused
+ * outputs of the last block are discarded. For the other algorithms the
+ * ziggurat method is used element by element. This function does not 
+ * lock @rng.
+ * 
+ */
+void
+ncm_rng_gaussian_fill (NcmRNG *rng, NcmVector *v, gdouble mu, gdouble sigma)
+{
+  const guint len = ncm_vector_len (v);
+  guint i;
+
+  if (_NCM_RNG_IS_PHILOX (rng))
+  {
+    NcmRNGPhiloxState *s = gsl_rng_state (rng->r);
+    gdouble x[4];
+
+    for (i = 0; i < len; i += 4)
+    {
+      guint32 out[4];
+      guint j;
+
+      _ncm_rng_philox_block (s->ctr, s->key, out);
+      _ncm_rng_philox_ctr_add (s, 1);
+
+      for (j = 0; j < 4; j += 2)
+      {
+        const gdouble u1    = (out[j] + 0.5) / 4294967296.0;
+        const gdouble theta = 2.0 * M_PI * (out[j + 1] / 4294967296.0);
+        const gdouble r     = sigma * sqrt (-2.0 * log (u1));
+
+        x[j]     = r * cos (theta);
+        x[j + 1] = r * sin (theta);
+      }
+
+      for (j = 0; (j < 4) && (i + j < len); j++)
+        ncm_vector_set (v, i + j, mu + x[j]);
+    }
+    s->idx = 4;
+  }
+  else
+  {
+    for (i = 0; i < len; i++)
+      ncm_vector_set (v, i, mu + gsl_ran_gaussian_ziggurat (rng->r, sigma));
+  }
+}
+
 static GHashTable *rng_table = NULL;
 
 /**
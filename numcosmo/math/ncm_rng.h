@@ -29,6 +29,7 @@
 #include <glib.h>
 #include <glib-object.h>
 #include <numcosmo/build_cfg.h>
+#include <numcosmo/math/ncm_vector.h>
 
 #include <gsl/gsl_randist.h>
 
@@ -82,6 +83,14 @@ void ncm_rng_set_seed (NcmRNG *rng, gulong seed);
 gulong ncm_rng_get_seed (NcmRNG *rng);
 void ncm_rng_set_random_seed (NcmRNG *rng, gboolean allow_colisions);
 
+NcmRNG *ncm_rng_stream_new (NcmRNG *parent, guint64 stream_id);
+void ncm_rng_stream_set (NcmRNG *rng, NcmRNG *parent, guint64 stream_id);
+void ncm_rng_skip (NcmRNG *rng, guint64 n);
+void ncm_rng_jump (NcmRNG *rng);
+
+void ncm_rng_uniform_fill (NcmRNG *rng, NcmVector *v, gdouble xl, gdouble xu);
+void ncm_rng_gaussian_fill (NcmRNG *rng, NcmVector *v, gdouble mu, gdouble sigma);
+
 NcmRNG *ncm_rng_pool_get (const gchar *name);
 
 G_INLINE_FUNC gdouble ncm_rng_uniform_gen (NcmRNG *rng, const gdouble xl, const gdouble xu); 
@@ -91,6 +100,13 @@ G_INLINE_FUNC gdouble ncm_rng_exponential_gen (NcmRNG *rng, const gdouble mu);
 G_INLINE_FUNC gdouble ncm_rng_laplace_gen (NcmRNG *rng, const gdouble a);
 G_INLINE_FUNC gdouble ncm_rng_exppow_gen (NcmRNG *rng, const gdouble a, const gdouble b);
 
+/**
+ * NCM_RNG_STREAM_ALGO:
+ *
+ * Name of the counter-based algorithm used by the #NcmRNG streams.
+ */
+#define NCM_RNG_STREAM_ALGO "philox4x32-10"
+
 G_END_DECLS
 
 #endif /* _NCM_RNG_H_ */
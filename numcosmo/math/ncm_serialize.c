@@ -44,6 +44,8 @@
 #include "math/ncm_matrix.h"
 #include "ncm_enum_types.h"
 #include <gio/gio.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 enum
 {
@@ -67,10 +69,16 @@ ncm_serialize_init (NcmSerialize *ser)
                                                &g_free);
   ser->saved_name_ser = g_hash_table_new_full (&g_str_hash, &g_str_equal, &g_free,
                                                (GDestroyNotify)&g_variant_unref);
+
+  ser->shared_name_ptr = g_hash_table_new_full (&g_str_hash, &g_str_equal, &g_free,
+                                                &g_object_unref);
+  ser->shared_ptr_name = g_hash_table_new_full (&g_direct_hash, &g_direct_equal, &g_object_unref,
+                                                &g_free);
   
   ser->is_named_regex  = g_regex_new ("^\\s*([A-Za-z][A-Za-z0-9\\+\\_]+)\\s*\\[([A-Za-z0-9\\:]+)\\]\\s*$", 0, 0, &error);
   ser->parse_obj_regex = g_regex_new ("^\\s*([A-Za-z][A-Za-z0-9\\+\\_]+\\s*(?:\\[[A-Za-z0-9\\:]+\\])?)\\s*([\\{]?.*[\\}]?)\\s*$", 0, 0, &error);
   ser->autosave_count  = 0;
+  ser->shared_count    = 0;
 }
 
 static void
@@ -118,12 +126,18 @@ _ncm_serialize_finalize (GObject *object)
   g_hash_table_remove_all (ser->saved_ptr_name);
   g_hash_table_remove_all (ser->saved_name_ser);
 
+  g_hash_table_remove_all (ser->shared_name_ptr);
+  g_hash_table_remove_all (ser->shared_ptr_name);
+
   g_hash_table_unref (ser->name_ptr);
   g_hash_table_unref (ser->ptr_name);
 
   g_hash_table_unref (ser->saved_ptr_name);
   g_hash_table_unref (ser->saved_name_ser);
 
+  g_hash_table_unref (ser->shared_name_ptr);
+  g_hash_table_unref (ser->shared_ptr_name);
+
   g_regex_unref (ser->is_named_regex);
   g_regex_unref (ser->parse_obj_regex);
 
@@ -230,7 +244,8 @@ ncm_serialize_clear (NcmSerialize **ser)
  * @ser: a #NcmSerialize.
  *
  * Releases all objects in @ser and erase all serialized
- * objects.
+ * objects. The shared instances, see ncm_serialize_share(),
+ * are kept.
  *
  */
 void
@@ -273,6 +288,7 @@ ncm_serialize_log_stats (NcmSerialize *ser)
   g_message ("# NcmSerialize: ptr_name         %u\n", g_hash_table_size (ser->ptr_name));
   g_message ("# NcmSerialize: saved_ptr_name   %u\n", g_hash_table_size (ser->saved_ptr_name));
   g_message ("# NcmSerialize: saved_name_ser   %u\n", g_hash_table_size (ser->saved_name_ser));
+  g_message ("# NcmSerialize: shared           %u\n", g_hash_table_size (ser->shared_ptr_name));
 }
 
 /**
@@ -414,6 +430,115 @@ ncm_serialize_set (NcmSerialize *ser, gpointer obj, const gchar *name, gboolean
   }
 }
 
+/**
+ * ncm_serialize_share:
+ * @ser: a #NcmSerialize.
+ * @obj: (type GObject): a #GObject.
+ *
+ * Adds @obj to the shared instances of @ser. A shared instance is
+ * serialized as a reference and deserialized as a new reference to
+ * the same @obj, hence every duplicate created through @ser using
+ * ncm_serialize_dup_obj() points to the same instance. This is meant
+ * for large immutable objects (e.g. data covariances) that should not
+ * be copied for each thread.
+ *
+ * Differently from the named instances, the shared instances are not
+ * removed by ncm_serialize_reset() and ncm_serialize_clear_instances(),
+ * use ncm_serialize_clear_shared() to release them. The caller must
+ * guarantee that @obj is not modified while it is shared.
+ *
+ */
+void
+ncm_serialize_share (NcmSerialize *ser, gpointer obj)
+{
+  g_assert (G_IS_OBJECT (obj));
+
+  if (g_hash_table_lookup_extended (ser->shared_ptr_name, obj, NULL, NULL))
+    return;
+  else
+  {
+    gchar *name = g_strdup_printf (NCM_SERIALIZE_SHARED_NAME NCM_SERIALIZE_AUTOSAVE_NFORMAT, ser->shared_count);
+
+    g_hash_table_insert (ser->shared_name_ptr,
+                         g_strdup (name), g_object_ref (obj));
+    g_hash_table_insert (ser->shared_ptr_name,
+                         g_object_ref (obj), name);
+
+    ser->shared_count++;
+  }
+}
+
+/* Index of a shared instance name, G_MAXUINT if @name is not of the form shared:N. */
+static guint
+_ncm_serialize_shared_index (const gchar *name)
+{
+  const gsize len = strlen (NCM_SERIALIZE_SHARED_NAME);
+  gchar *endptr   = NULL;
+  guint64 index;
+
+  if (!g_str_has_prefix (name, NCM_SERIALIZE_SHARED_NAME))
+    return G_MAXUINT;
+
+  index = g_ascii_strtoull (name + len, &endptr, 10);
+  if ((endptr == name + len) || (*endptr != '\0') || (index >= G_MAXUINT))
+    return G_MAXUINT;
+
+  return index;
+}
+
+static gint
+_ncm_serialize_shared_cmp (gconstpointer a, gconstpointer b)
+{
+  const guint ia = _ncm_serialize_shared_index (a);
+  const guint ib = _ncm_serialize_shared_index (b);
+
+  return (ia < ib) ? -1 : ((ia > ib) ? 1 : 0);
+}
+
+/**
+ * ncm_serialize_is_shared:
+ * @ser: a #NcmSerialize.
+ * @obj: (type GObject): a #GObject.
+ *
+ * Checks if @obj is a shared instance of @ser.
+ *
+ * Returns: whether @obj is shared in @ser.
+ */
+gboolean
+ncm_serialize_is_shared (NcmSerialize *ser, gpointer obj)
+{
+  g_assert (G_IS_OBJECT (obj));
+  return g_hash_table_lookup_extended (ser->shared_ptr_name, obj, NULL, NULL);
+}
+
+/**
+ * ncm_serialize_count_shared:
+ * @ser: a #NcmSerialize.
+ *
+ * Counts the number of shared instances in @ser.
+ *
+ * Returns: the number of shared instances in @ser.
+ */
+guint
+ncm_serialize_count_shared (NcmSerialize *ser)
+{
+  return g_hash_table_size (ser->shared_ptr_name);
+}
+
+/**
+ * ncm_serialize_clear_shared:
+ * @ser: a #NcmSerialize.
+ *
+ * Releases all shared instances in @ser.
+ *
+ */
+void
+ncm_serialize_clear_shared (NcmSerialize *ser)
+{
+  g_hash_table_remove_all (ser->shared_name_ptr);
+  g_hash_table_remove_all (ser->shared_ptr_name);
+}
+
 static void
 _ncm_serialize_save_ser (NcmSerialize *ser, gchar *name, gpointer obj, GVariant *ser_var)
 {
@@ -744,6 +869,82 @@ ncm_serialize_from_file (NcmSerialize *ser, const gchar *filename)
   return obj;
 }
 
+static GObject *
+_ncm_serialize_zero_copy_new (GType gtype, GVariant *params)
+{
+  GObject *obj = NULL;
+
+  if (g_variant_n_children (params) != 1)
+    return NULL;
+
+  if (gtype == NCM_TYPE_VECTOR)
+  {
+    GVariant *val = g_variant_lookup_value (params, "values", G_VARIANT_TYPE (NCM_SERIALIZE_VECTOR_TYPE));
+    if (val != NULL)
+    {
+      if (g_variant_n_children (val) > 0)
+      {
+        NcmVector *v = NCM_VECTOR (ncm_vector_const_new_variant (val));
+
+        /* The file only guarantees 8 byte alignment, misaligned payloads are copied. */
+        if (!ncm_vector_is_aligned (v))
+        {
+          NcmVector *v_aligned = ncm_vector_new_aligned (ncm_vector_len (v));
+
+          ncm_vector_memcpy (v_aligned, v);
+          ncm_vector_free (v);
+          v = v_aligned;
+        }
+
+        obj = G_OBJECT (v);
+      }
+      g_variant_unref (val);
+    }
+  }
+  else if (gtype == NCM_TYPE_MATRIX)
+  {
+    GVariant *val = g_variant_lookup_value (params, "values", G_VARIANT_TYPE (NCM_SERIALIZE_MATRIX_TYPE));
+    if (val != NULL)
+    {
+      const gsize nrows = g_variant_n_children (val);
+      gsize ncols       = 0;
+      gsize i;
+
+      for (i = 0; i < nrows; i++)
+      {
+        GVariant *row  = g_variant_get_child_value (val, i);
+        const gsize nc = g_variant_n_children (row);
+        g_variant_unref (row);
+
+        if (i == 0)
+          ncols = nc;
+        else if (nc != ncols)
+          break;
+      }
+
+      /* Only contiguous and rectangular matrices can use the variant memory. */
+      if ((nrows > 0) && (ncols > 0) && (i == nrows))
+      {
+        NcmMatrix *m = NCM_MATRIX (ncm_matrix_const_new_variant (val));
+
+        if (!ncm_matrix_is_aligned (m))
+        {
+          NcmMatrix *m_aligned = ncm_matrix_new_aligned (nrows, ncols);
+
+          ncm_matrix_memcpy (m_aligned, m);
+          ncm_matrix_free (m);
+          m = m_aligned;
+        }
+
+        obj = G_OBJECT (m);
+      }
+      g_variant_unref (val);
+    }
+  }
+
+  return obj;
+}
+
 /**
  * ncm_serialize_from_name_params:
  * @ser: a #NcmSerialize.
@@ -777,8 +978,14 @@ ncm_serialize_from_name_params (NcmSerialize *ser, const gchar *obj_name, GVaria
 
   g_match_info_free (match_info);
 
-  if ((name != NULL) && ncm_serialize_contain_name (ser, name))
-    obj = ncm_serialize_get_by_name (ser, name);
+  if (name != NULL)
+  {
+    gpointer shared_obj = NULL;
+    if (g_hash_table_lookup_extended (ser->shared_name_ptr, name, NULL, &shared_obj))
+      obj = g_object_ref (shared_obj);
+    else if (ncm_serialize_contain_name (ser, name))
+      obj = ncm_serialize_get_by_name (ser, name);
+  }
 
   if (obj != NULL)
   {
@@ -1068,6 +1275,56 @@ ncm_serialize_gvalue_to_gvariant (NcmSerialize *ser, GValue *val)
   return var;
 }
 
+/*
+ * Serializes the read-write properties of @obj, returns NULL when @obj
+ * has no properties.
+ */
+static GVariant *
+_ncm_serialize_obj_params (NcmSerialize *ser, GObject *obj)
+{
+  GObjectClass *klass = G_OBJECT_GET_CLASS (obj);
+  guint n_properties, i;
+  GParamSpec **prop   = g_object_class_list_properties (klass, &n_properties);
+  GVariantBuilder b;
+
+  if (n_properties == 0)
+  {
+    g_free (prop);
+    return NULL;
+  }
+
+  g_variant_builder_init (&b, G_VARIANT_TYPE (NCM_SERIALIZE_PROPERTIES_TYPE));
+
+  for (i = 0; i < n_properties; i++)
+  {
+    GVariant *var = NULL;
+    GValue val = G_VALUE_INIT;
+
+    if ((prop[i]->flags & G_PARAM_READWRITE) != G_PARAM_READWRITE)
+      continue;
+
+    g_value_init (&val, prop[i]->value_type);
+    g_object_get_property (obj, prop[i]->name, &val);
+
+    var = ncm_serialize_gvalue_to_gvariant (ser, &val);
+
+    if (var == NULL)
+    {
+      g_value_unset (&val);
+      continue;
+    }
+
+    g_variant_builder_add (&b, NCM_SERIALIZE_PROPERTY_TYPE, prop[i]->name, var);
+
+    g_variant_unref (var);
+    g_value_unset (&val);
+  }
+
+  g_free (prop);
+
+  return g_variant_builder_end (&b);
+}
+
 /**
  * ncm_serialize_to_variant:
  * @ser: a #NcmSerialize.
@@ -1083,8 +1340,15 @@ ncm_serialize_to_variant (NcmSerialize *ser, GObject *obj)
   GVariant *ser_var;
   gchar *obj_name = g_strdup (G_OBJECT_TYPE_NAME (obj));
   gchar *saved_name = NULL;
+  gchar *shared_name = NULL;
 
-  if (ncm_serialize_contain_instance (ser, obj))
+  if (g_hash_table_lookup_extended (ser->shared_ptr_name, obj, NULL, (gpointer *)&shared_name))
+  {
+    gchar *fname = g_strdup_printf ("%s[%s]", obj_name, shared_name);
+    ser_var = g_variant_ref_sink (g_variant_new (NCM_SERIALIZE_OBJECT_TYPE, fname, NULL));
+    g_free (fname);
+  }
+  else if (ncm_serialize_contain_instance (ser, obj))
   {
     gchar *ni_name = ncm_serialize_peek_name (ser, obj);
     gchar *fname = g_strdup_printf ("%s[%s]", obj_name, ni_name);
@@ -1101,9 +1365,7 @@ ncm_serialize_to_variant (NcmSerialize *ser, GObject *obj)
   }
   else
   {
-    GObjectClass *klass = G_OBJECT_GET_CLASS (obj);
-    guint n_properties, i;
-    GParamSpec **prop   = g_object_class_list_properties (klass, &n_properties);
+    GVariant *params;
     gchar *name = NULL;
 
     if (ser->opts & NCM_SERIALIZE_OPT_AUTONAME_SER)
@@ -1118,50 +1380,13 @@ ncm_serialize_to_variant (NcmSerialize *ser, GObject *obj)
 
       ser->autosave_count++;
     }
-    
-    if (n_properties == 0)
-    {
-      g_free (prop);
-      ser_var = g_variant_ref_sink (g_variant_new (NCM_SERIALIZE_OBJECT_TYPE, obj_name, NULL));
-    }
-    else
-    {
-      GVariantBuilder b;
-      GVariant *params;
-
-      g_variant_builder_init (&b, G_VARIANT_TYPE (NCM_SERIALIZE_PROPERTIES_TYPE));
-
-      for (i = 0; i < n_properties; i++)
-      {
-        GVariant *var = NULL;
-        GValue val = G_VALUE_INIT;
-
-        if ((prop[i]->flags & G_PARAM_READWRITE) != G_PARAM_READWRITE)
-          continue;
 
-        g_value_init (&val, prop[i]->value_type);
-        g_object_get_property (obj, prop[i]->name, &val);
-
-        var = ncm_serialize_gvalue_to_gvariant (ser, &val);
-
-        if (var == NULL)
-        {
-          g_value_unset (&val);
-          continue;
-        }
-
-        g_variant_builder_add (&b, NCM_SERIALIZE_PROPERTY_TYPE, prop[i]->name, var);
-
-        g_variant_unref (var);
-        g_value_unset (&val);
-      }
-
-      params = g_variant_builder_end (&b);
-
-      g_free (prop);
+    params = _ncm_serialize_obj_params (ser, obj);
 
+    if (params == NULL)
+      ser_var = g_variant_ref_sink (g_variant_new (NCM_SERIALIZE_OBJECT_TYPE, obj_name, NULL));
+    else
       ser_var = g_variant_ref_sink (g_variant_new (NCM_SERIALIZE_OBJECT_FORMAT, obj_name, params));
-    }
 
     if (name != NULL)
     {
@@ -1243,12 +1468,208 @@ ncm_serialize_to_file (NcmSerialize *ser, GObject *obj, const gchar *filename)
 }
 
 
+/**
+ * ncm_serialize_to_binfile:
+ * @ser: a #NcmSerialize
+ * @obj: a #GObject
+ * @filename: File where to save the serialized version of the object
+ *
+ * Serializes @obj and saves the binary #GVariant representation in @filename.
+ * The numeric payloads of #NcmVector and #NcmMatrix objects are stored as raw
+ * (8 byte aligned) double arrays, the file is prefixed by a magic number used
+ * to detect the byte order on load, see ncm_serialize_from_binfile().
+ *
+ * The shared instances of @ser, see ncm_serialize_share(), are stored in full
+ * in a separated table (in the order they were shared) and the object graph
+ * refers to them by name.
+ *
+ */
+void
+ncm_serialize_to_binfile (NcmSerialize *ser, GObject *obj, const gchar *filename)
+{
+  GError *error     = NULL;
+  GList *names      = g_list_sort (g_hash_table_get_keys (ser->shared_name_ptr), &_ncm_serialize_shared_cmp);
+  GVariant *ser_var = ncm_serialize_to_variant (ser, obj);
+  GVariant *bin_var, *shared_var;
+  GVariantBuilder b;
+  GList *l;
+
+  g_assert (filename != NULL);
+
+  g_variant_builder_init (&b, G_VARIANT_TYPE (NCM_SERIALIZE_BINFILE_SHARED_TYPE));
+
+  for (l = names; l != NULL; l = l->next)
+  {
+    GObject *sobj    = g_hash_table_lookup (ser->shared_name_ptr, l->data);
+    GVariant *params = _ncm_serialize_obj_params (ser, sobj);
+    gchar *fname     = g_strdup_printf ("%s[%s]", G_OBJECT_TYPE_NAME (sobj), (gchar *) l->data);
+
+    if (params == NULL)
+      g_variant_builder_add (&b, NCM_SERIALIZE_OBJECT_TYPE, fname, NULL);
+    else
+      g_variant_builder_add (&b, NCM_SERIALIZE_OBJECT_FORMAT, fname, params);
+
+    g_free (fname);
+  }
+
+  shared_var = g_variant_builder_end (&b);
+  bin_var    = g_variant_ref_sink (g_variant_new (NCM_SERIALIZE_BINFILE_FORMAT, NCM_SERIALIZE_BINFILE_MAGIC, shared_var, ser_var));
+
+  if (!g_file_set_contents (filename, g_variant_get_data (bin_var), g_variant_get_size (bin_var), &error))
+    g_error ("ncm_serialize_to_binfile: cannot save to file %s: %s",
+             filename, error->message);
+
+  g_list_free (names);
+  g_variant_unref (bin_var);
+  g_variant_unref (ser_var);
+}
+
+/*
+ * Loads the table of shared instances adding them to the shared instances
+ * of @ser under the same names. Only the #NcmVector and #NcmMatrix in this
+ * table use the file memory when @zero_copy is TRUE.
+ */
+static void
+_ncm_serialize_load_shared (NcmSerialize *ser, GVariant *shared_var, gboolean zero_copy, const gchar *filename)
+{
+  const gsize nshared = g_variant_n_children (shared_var);
+  gsize i;
+
+  for (i = 0; i < nshared; i++)
+  {
+    GVariant *entry        = g_variant_get_child_value (shared_var, i);
+    GVariant *key_var      = g_variant_get_child_value (entry, 0);
+    GVariant *params       = g_variant_get_child_value (entry, 1);
+    const gchar *fname     = g_variant_get_string (key_var, NULL);
+    GMatchInfo *match_info = NULL;
+    GObject *sobj          = NULL;
+    gchar *type_name, *name;
+    guint index;
+    GType gtype;
+
+    if (!g_regex_match (ser->is_named_regex, fname, 0, &match_info))
+      g_error ("ncm_serialize_from_binfile: invalid shared instance `%s' in file %s.", fname, filename);
+
+    type_name = g_match_info_fetch (match_info, 1);
+    name      = g_match_info_fetch (match_info, 2);
+    index     = _ncm_serialize_shared_index (name);
+    gtype     = g_type_from_name (type_name);
+    g_match_info_free (match_info);
+
+    if (index == G_MAXUINT)
+      g_error ("ncm_serialize_from_binfile: invalid shared instance `%s' in file %s.", fname, filename);
+    if (g_hash_table_lookup_extended (ser->shared_name_ptr, name, NULL, NULL))
+      g_error ("ncm_serialize_from_binfile: shared instance `%s' of file %s already in use, see ncm_serialize_clear_shared().",
+               name, filename);
+    if (gtype == 0)
+      g_error ("ncm_serialize_from_binfile: object `%s' is not registered.", type_name);
+
+    if (zero_copy)
+      sobj = _ncm_serialize_zero_copy_new (gtype, params);
+
+    if (sobj == NULL)
+      sobj = ncm_serialize_from_name_params (ser, type_name, params);
+
+    g_hash_table_insert (ser->shared_name_ptr, g_strdup (name), g_object_ref (sobj));
+    g_hash_table_insert (ser->shared_ptr_name, g_object_ref (sobj), g_strdup (name));
+    ser->shared_count = MAX (ser->shared_count, index + 1);
+
+    g_object_unref (sobj);
+    g_free (type_name);
+    g_free (name);
+    g_variant_unref (params);
+    g_variant_unref (key_var);
+    g_variant_unref (entry);
+  }
+}
+
+/**
+ * ncm_serialize_from_binfile:
+ * @ser: a #NcmSerialize.
+ * @filename: File containing the binary serialized version of the object.
+ * @zero_copy: whether the shared #NcmVector and #NcmMatrix use the file memory
+ *
+ * Loads the object saved by ncm_serialize_to_binfile() in @filename. The
+ * shared instances stored in the file are added to the shared instances of
+ * @ser under the same names, hence @ser must not contain shared instances
+ * with these names, see ncm_serialize_clear_shared().
+ *
+ * The file is memory mapped read-only. When @zero_copy is TRUE the shared
+ * #NcmVector and #NcmMatrix objects use the mapped memory directly whenever it
+ * is aligned to #NCM_VECTOR_ALIGNMENT bytes, otherwise they are copied to
+ * aligned memory. Shared instances must never be modified, see
+ * ncm_serialize_share(), all other objects are always created with their own
+ * copy of the data.
+ *
+ * Returns: (transfer full): A new #GObject.
+ */
+GObject *
+ncm_serialize_from_binfile (NcmSerialize *ser, const gchar *filename, gboolean zero_copy)
+{
+  GError *error = NULL;
+  GMappedFile *mfile;
+  GVariant *bin_var, *magic_var, *shared_var, *obj_var;
+  GObject *obj;
+  guint32 magic;
+  gint fd;
+
+  g_assert (filename != NULL);
+
+  fd = g_open (filename, O_RDONLY, 0);
+  if (fd < 0)
+    g_error ("ncm_serialize_from_binfile: cannot open file %s.", filename);
+
+  mfile = g_mapped_file_new_from_fd (fd, FALSE, &error);
+  close (fd);
+  if (mfile == NULL)
+    g_error ("ncm_serialize_from_binfile: cannot map file %s: %s",
+             filename, error->message);
+
+  g_assert_cmpuint (g_mapped_file_get_length (mfile), >, 0);
+
+  bin_var = g_variant_ref_sink (g_variant_new_from_data (G_VARIANT_TYPE (NCM_SERIALIZE_BINFILE_TYPE),
+                                                         g_mapped_file_get_contents (mfile),
+                                                         g_mapped_file_get_length (mfile),
+                                                         FALSE,
+                                                         (GDestroyNotify) &g_mapped_file_unref,
+                                                         mfile));
+  if (!g_variant_is_normal_form (bin_var))
+    g_error ("ncm_serialize_from_binfile: file %s is not a valid binary serialization file.", filename);
+
+  magic_var = g_variant_get_child_value (bin_var, 0);
+  magic     = g_variant_get_uint32 (magic_var);
+  g_variant_unref (magic_var);
+
+  if (magic == GUINT32_SWAP_LE_BE (NCM_SERIALIZE_BINFILE_MAGIC))
+  {
+    GVariant *swap_var = g_variant_byteswap (bin_var);
+    g_variant_unref (bin_var);
+    bin_var = g_variant_take_ref (swap_var);
+  }
+  else if (magic != NCM_SERIALIZE_BINFILE_MAGIC)
+    g_error ("ncm_serialize_from_binfile: file %s is not a valid binary serialization file (magic %x).", filename, magic);
+
+  shared_var = g_variant_get_child_value (bin_var, 1);
+  obj_var    = g_variant_get_child_value (bin_var, 2);
+
+  _ncm_serialize_load_shared (ser, shared_var, zero_copy, filename);
+  obj = ncm_serialize_from_variant (ser, obj_var);
+
+  g_variant_unref (obj_var);
+  g_variant_unref (shared_var);
+  g_variant_unref (bin_var);
+
+  return obj;
+}
+
 /**
  * ncm_serialize_dup_obj:
  * @ser: a #NcmSerialize.
  * @obj: a #GObject.
  *
- * Duplicates @obj by serializing and deserializing a new object.
+ * Duplicates @obj by serializing and deserializing a new object. The object
+ * graph is kept in its in-memory binary #GVariant form, no string is
+ * generated or parsed.
  *
  * Returns: (transfer full): A duplicate of @obj.
  */
@@ -1614,6 +2035,40 @@ ncm_serialize_global_to_file (GObject *obj, const gchar *filename)
   ncm_serialize_unref (ser);
 }
 
+/**
+ * ncm_serialize_global_to_binfile:
+ * @obj: a #GObject.
+ * @filename: File where to save the serialized version of the object
+ *
+ * Global version of ncm_serialize_to_binfile().
+ *
+ */
+void
+ncm_serialize_global_to_binfile (GObject *obj, const gchar *filename)
+{
+  NcmSerialize *ser = ncm_serialize_global ();
+  ncm_serialize_to_binfile (ser, obj, filename);
+  ncm_serialize_unref (ser);
+}
+
+/**
+ * ncm_serialize_global_from_binfile:
+ * @filename: File containing the binary serialized version of the object.
+ * @zero_copy: whether the shared #NcmVector and #NcmMatrix use the file memory
+ *
+ * Global version of ncm_serialize_from_binfile().
+ *
+ * Returns: (transfer full): A new #GObject.
+ */
+GObject *
+ncm_serialize_global_from_binfile (const gchar *filename, gboolean zero_copy)
+{
+  NcmSerialize *ser = ncm_serialize_global ();
+  GObject *ret = ncm_serialize_from_binfile (ser, filename, zero_copy);
+  ncm_serialize_unref (ser);
+  return ret;
+}
+
 /**
  * ncm_serialize_global_dup_obj:
  * @obj: a #GObject.
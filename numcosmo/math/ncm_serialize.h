@@ -75,10 +75,13 @@ struct _NcmSerialize
   GHashTable *ptr_name;
   GHashTable *saved_ptr_name;
   GHashTable *saved_name_ser;
+  GHashTable *shared_name_ptr;
+  GHashTable *shared_ptr_name;
   GRegex *is_named_regex;
   GRegex *parse_obj_regex;
   NcmSerializeOpt opts;
   guint autosave_count;
+  guint shared_count;
 };
 
 GType ncm_serialize_get_type (void) G_GNUC_CONST;
@@ -103,6 +106,11 @@ gchar *ncm_serialize_peek_name (NcmSerialize *ser, gpointer obj);
 void ncm_serialize_set (NcmSerialize *ser, gpointer obj, const gchar *name, gboolean overwrite);
 gboolean ncm_serialize_is_named (NcmSerialize *ser, const gchar *serobj, gchar **name);
 
+void ncm_serialize_share (NcmSerialize *ser, gpointer obj);
+gboolean ncm_serialize_is_shared (NcmSerialize *ser, gpointer obj);
+guint ncm_serialize_count_shared (NcmSerialize *ser);
+void ncm_serialize_clear_shared (NcmSerialize *ser);
+
 void ncm_serialize_set_property (NcmSerialize *ser, GObject *obj, const gchar *prop_str);
 void ncm_serialize_set_property_from_key_file (NcmSerialize *ser, GObject *obj, const gchar *prop_file);
 
@@ -114,6 +122,8 @@ GVariant *ncm_serialize_gvalue_to_gvariant (NcmSerialize *ser, GValue *val);
 GVariant *ncm_serialize_to_variant (NcmSerialize *ser, GObject *obj);
 gchar *ncm_serialize_to_string (NcmSerialize *ser, GObject *obj, gboolean valid_variant);
 void ncm_serialize_to_file (NcmSerialize *ser, GObject *obj, const gchar *filename);
+void ncm_serialize_to_binfile (NcmSerialize *ser, GObject *obj, const gchar *filename);
+GObject *ncm_serialize_from_binfile (NcmSerialize *ser, const gchar *filename, gboolean zero_copy);
 GObject *ncm_serialize_dup_obj (NcmSerialize *ser, GObject *obj);
 
 /* Global NcmSerialize object */
@@ -143,6 +153,8 @@ GVariant *ncm_serialize_global_gvalue_to_gvariant (GValue *val);
 GVariant *ncm_serialize_global_to_variant (GObject *obj);
 gchar *ncm_serialize_global_to_string (GObject *obj, gboolean valid_variant);
 void ncm_serialize_global_to_file (GObject *obj, const gchar *filename);
+void ncm_serialize_global_to_binfile (GObject *obj, const gchar *filename);
+GObject *ncm_serialize_global_from_binfile (const gchar *filename, gboolean zero_copy);
 GObject *ncm_serialize_global_dup_obj (GObject *obj);
 
 #define NCM_SERIALIZE_PROPERTY_TYPE "{sv}"
@@ -154,6 +166,11 @@ GObject *ncm_serialize_global_dup_obj (GObject *obj);
 #define NCM_SERIALIZE_STRV_TYPE "as"
 #define NCM_SERIALIZE_AUTOSAVE_NAME "S"
 #define NCM_SERIALIZE_AUTOSAVE_NFORMAT "%u"
+#define NCM_SERIALIZE_SHARED_NAME "shared:"
+#define NCM_SERIALIZE_BINFILE_MAGIC (0x4E434D42)
+#define NCM_SERIALIZE_BINFILE_SHARED_TYPE "a"NCM_SERIALIZE_OBJECT_TYPE
+#define NCM_SERIALIZE_BINFILE_TYPE "(u"NCM_SERIALIZE_BINFILE_SHARED_TYPE NCM_SERIALIZE_OBJECT_TYPE")"
+#define NCM_SERIALIZE_BINFILE_FORMAT "(u@"NCM_SERIALIZE_BINFILE_SHARED_TYPE"@"NCM_SERIALIZE_OBJECT_TYPE")"
 
 G_END_DECLS
 
@@ -125,7 +125,7 @@ ncm_sf_sbessel_recur_next (NcmSFSBesselRecur *jlrec)
     {
       const gdouble temp = jlrec->jlp1[i] * (2.0 * jlrec->l + 3.0) / x - jlrec->jl[i];
       jlrec->jl[i] = jlrec->jlp1[i];
-      jlrec->jl[i] = temp;
+      jlrec->jlp1[i] = temp;
     }
   }
   jlrec->l++;
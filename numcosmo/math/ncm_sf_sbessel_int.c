@@ -150,9 +150,7 @@ ncm_sf_sbessel_jl_xj_integral_recur_set (NcmSFSphericalBesselIntegRecur *xnjlrec
       gdouble x = ncm_grid_get_node_d (x_grid, j);
       xnjlrec->int_jl_xn[i][j]   = ncm_sf_sbessel_jl_xj_integral (l + 0, i, x);
       xnjlrec->int_jlp1_xn[i][j] = ncm_sf_sbessel_jl_xj_integral (l + 1, i, x);
-      printf ("%.15g %.15g %.15g %ld %d\n", x, xnjlrec->int_jl_xn[i][j], xnjlrec->int_jlp1_xn[i][j], l, i);
     }
-    printf ("\n\n");
   }
   xnjlrec->prepared = TRUE;
 }
@@ -189,7 +187,7 @@ ncm_sf_sbessel_jl_xj_integral_recur_next (NcmSFSphericalBesselIntegRecur *xnjlre
     {
       const gdouble temp = jlrec->jlp1[j] * (2.0 * jlrec->l + 3.0) / x - jlrec->jl[j];
       jlrec->jl[j] = jlrec->jlp1[j];
-      jlrec->jl[j] = temp;
+      jlrec->jlp1[j] = temp;
     }
 
     for (i = 0; i < 4; i++)
@@ -267,9 +265,6 @@ ncm_sf_sbessel_jl_xj_integral_recur_goto (NcmSFSphericalBesselIntegRecur *xnjlre
   glong sub = labs(l - xnjlrec->jlrec->l);
   glong i;
 
-  if (sub != 0)
-    printf ("# Moving %ld positions %s\n", sub, sign == -1 ? "backward" : "forward");
-
   if (sub == 0)
     return 0;
   if (sign == 1)
@@ -0,0 +1,898 @@
+/***************************************************************************
+ *            ncm_sf_sbessel_table.c
+ *
+ *  Mon October 19 16:02:11 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_sf_sbessel_table.c
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:ncm_sf_sbessel_table
+ * @title: NcmSFSBesselTable
+ * @short_description: Precomputed tables of spherical Bessel functions and their integrals.
+ *
+ * This object contains the spherical Bessel functions $j_\ell(x)$ for
+ * $\ell_\mathrm{min} \leq \ell \leq \ell_\mathrm{max} + 1$ tabulated on a
+ * uniform grid $x_i \leq x \leq x_f$ and, optionally, the integrals
+ * $$I^n_\ell(x) = \int_0^x\mathrm{d}t\,t^nj_\ell(t), \qquad n = 0, \dots, 3,$$
+ * for $\ell_\mathrm{min} \leq \ell \leq \ell_\mathrm{max}$.
+ *
+ * The functions are computed for all $\ell$ at once at each node using
+ * Steed's method, and the integrals are accumulated node by node using an
+ * eight-point Gauss-Legendre rule in each interval. Both loops run on the
+ * NumCosmo thread pool. The values between nodes are obtained by cubic
+ * Hermite interpolation using the exact derivatives
+ * $j_\ell^\prime = \ell j_\ell / x - j_{\ell+1}$ and
+ * ${I^n_\ell}^\prime = x^n j_\ell$. The interpolation error scales as
+ * $\Delta x^4$, so grids with $\Delta x \lesssim 0.1$ give relative errors
+ * of order $10^{-7}$. Use ncm_sf_sbessel_table_validate() to compare a
+ * table against the multiple precision implementations
+ * ncm_sf_sbessel() and ncm_sf_sbessel_jl_xj_integral().
+ *
+ * A table is immutable after construction, so it can be shared between
+ * threads without locking. ncm_sf_sbessel_table_save() writes the table
+ * in a binary format (host byte order) that ncm_sf_sbessel_table_load()
+ * maps into memory read-only, so different processes using the same file
+ * also share the same physical pages. ncm_sf_sbessel_table_cached_new()
+ * combines both: it generates the table file in the NumCosmo
+ * configuration directory only once and returns the same mapped instance
+ * to all callers in the process.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif /* HAVE_CONFIG_H */
+#include "build_cfg.h"
+
+#include "math/ncm_sf_sbessel_table.h"
+#include "math/ncm_sf_sbessel.h"
+#include "math/ncm_sf_sbessel_int.h"
+#include "math/ncm_func_eval.h"
+#include "math/ncm_cfg.h"
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_sf_bessel.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <errno.h>
+
+G_DEFINE_BOXED_TYPE (NcmSFSBesselTable, ncm_sf_sbessel_table, ncm_sf_sbessel_table_ref, ncm_sf_sbessel_table_free);
+
+#define NCM_SF_SBESSEL_TABLE_MAGIC "NCMSBT01"
+#define NCM_SF_SBESSEL_TABLE_BYTE_ORDER 0x01020304
+#define NCM_SF_SBESSEL_TABLE_GL_N 4
+
+typedef struct _NcmSFSBesselTableHeader
+{
+  gchar magic[8];
+  guint32 byte_order;
+  guint32 lmin;
+  guint32 lmax;
+  guint32 nx;
+  guint32 with_int;
+  guint32 pad0;
+  gdouble xi;
+  gdouble xf;
+  gchar pad1[16];
+} NcmSFSBesselTableHeader;
+
+G_STATIC_ASSERT (sizeof (NcmSFSBesselTableHeader) == 64);
+
+/* Positive nodes and weights of the eight-point Gauss-Legendre rule. */
+static const gdouble _ncm_sf_sbessel_table_gl_x[NCM_SF_SBESSEL_TABLE_GL_N] = {
+  0.1834346424956498049394761, 0.5255324099163289858177390,
+  0.7966664774136267395915539, 0.9602898564975362316835609
+};
+static const gdouble _ncm_sf_sbessel_table_gl_w[NCM_SF_SBESSEL_TABLE_GL_N] = {
+  0.3626837833783619829651504, 0.3137066458778872873379622,
+  0.2223810344533744705443560, 0.1012285362903762591525314
+};
+
+G_LOCK_DEFINE_STATIC (sbessel_table_cache);
+static GHashTable *_sbessel_table_cache = NULL;
+
+#define _NCM_SF_SBESSEL_TABLE_NL_JL(tab) ((gsize)((tab)->lmax - (tab)->lmin + 2))
+#define _NCM_SF_SBESSEL_TABLE_NL_INT(tab) ((gsize)((tab)->lmax - (tab)->lmin + 1))
+#define _NCM_SF_SBESSEL_TABLE_JL_SIZE(tab) (_NCM_SF_SBESSEL_TABLE_NL_JL (tab) * (tab)->nx)
+#define _NCM_SF_SBESSEL_TABLE_INT_SIZE(tab) ((tab)->with_int ? (NCM_SF_SBESSEL_TABLE_NINT * _NCM_SF_SBESSEL_TABLE_NL_INT (tab) * (tab)->nx) : 0)
+#define _NCM_SF_SBESSEL_TABLE_MIN_CHUNK (16)
+#define _NCM_SF_SBESSEL_TABLE_EVAL_CHUNK (64)
+
+static NcmSFSBesselTable *
+_ncm_sf_sbessel_table_alloc (const guint lmin, const guint lmax, const gdouble xi, const gdouble xf, const guint nx, const gboolean with_int)
+{
+  NcmSFSBesselTable *tab = g_new0 (NcmSFSBesselTable, 1);
+
+  g_assert_cmpuint (lmax, >=, lmin);
+  g_assert_cmpuint (nx, >, 1);
+  g_assert_cmpfloat (xi, >=, 0.0);
+  g_assert_cmpfloat (xf, >, xi);
+
+  tab->ref_count = 1;
+  tab->key       = NULL;
+  tab->lmin      = lmin;
+  tab->lmax      = lmax;
+  tab->nx        = nx;
+  tab->xi        = xi;
+  tab->xf        = xf;
+  tab->dx        = (xf - xi) / (nx - 1.0);
+  tab->with_int  = with_int;
+  tab->mfile     = NULL;
+  tab->mem       = NULL;
+  tab->jl        = NULL;
+  tab->int_jl_xn = NULL;
+
+  return tab;
+}
+
+static void
+_ncm_sf_sbessel_table_fill_jl (glong i, glong f, gpointer data)
+{
+  NcmSFSBesselTable *tab = data;
+  gdouble *jl            = tab->mem;
+  gdouble *jl_x          = g_new (gdouble, tab->lmax + 2);
+  glong ix;
+
+  for (ix = i; ix < f; ix++)
+  {
+    const gdouble x = ncm_sf_sbessel_table_get_x (tab, ix);
+    guint l;
+
+    gsl_sf_bessel_jl_steed_array (tab->lmax + 1, x, jl_x);
+
+    for (l = tab->lmin; l <= tab->lmax + 1; l++)
+      jl[(l - tab->lmin) * tab->nx + ix] = jl_x[l];
+  }
+
+  g_free (jl_x);
+}
+
+static void
+_ncm_sf_sbessel_table_add_interval (NcmSFSBesselTable *tab, gdouble *int_jl_xn, const glong ix, const gdouble a, const gdouble b, gdouble *jl_x)
+{
+  const gsize nl_int = _NCM_SF_SBESSEL_TABLE_NL_INT (tab);
+  const gdouble c    = 0.5 * (a + b);
+  const gdouble hw   = 0.5 * (b - a);
+  gint k, s;
+
+  for (k = 0; k < NCM_SF_SBESSEL_TABLE_GL_N; k++)
+  {
+    for (s = -1; s <= 1; s += 2)
+    {
+      const gdouble t = c + s * hw * _ncm_sf_sbessel_table_gl_x[k];
+      const gdouble w = hw * _ncm_sf_sbessel_table_gl_w[k];
+      gdouble tn      = w;
+      guint n;
+
+      gsl_sf_bessel_jl_steed_array (tab->lmax, t, jl_x);
+
+      for (n = 0; n < NCM_SF_SBESSEL_TABLE_NINT; n++)
+      {
+        gdouble *row_n = &int_jl_xn[n * nl_int * tab->nx];
+        guint l;
+
+        for (l = tab->lmin; l <= tab->lmax; l++)
+          row_n[(l - tab->lmin) * tab->nx + ix] += tn * jl_x[l];
+
+        tn *= t;
+      }
+    }
+  }
+}
+
+static void
+_ncm_sf_sbessel_table_fill_int_step (glong i, glong f, gpointer data)
+{
+  NcmSFSBesselTable *tab = data;
+  gdouble *int_jl_xn     = &tab->mem[_NCM_SF_SBESSEL_TABLE_JL_SIZE (tab)];
+  gdouble *jl_x          = g_new (gdouble, tab->lmax + 1);
+  glong ix;
+
+  for (ix = i; ix < f; ix++)
+  {
+    if (ix == 0)
+    {
+      /* The first node accumulates the integral from zero. */
+      if (tab->xi > 0.0)
+      {
+        const glong nsub = GSL_MAX (1, (glong) ceil (tab->xi / tab->dx));
+        const gdouble h  = tab->xi / nsub;
+        glong j;
+
+        for (j = 0; j < nsub; j++)
+          _ncm_sf_sbessel_table_add_interval (tab, int_jl_xn, ix, j * h, (j + 1) * h, jl_x);
+      }
+    }
+    else
+    {
+      _ncm_sf_sbessel_table_add_interval (tab, int_jl_xn, ix,
+                                          ncm_sf_sbessel_table_get_x (tab, ix - 1),
+                                          ncm_sf_sbessel_table_get_x (tab, ix),
+                                          jl_x);
+    }
+  }
+
+  g_free (jl_x);
+}
+
+static void
+_ncm_sf_sbessel_table_fill_int_sum (glong i, glong f, gpointer data)
+{
+  NcmSFSBesselTable *tab = data;
+  gdouble *int_jl_xn     = &tab->mem[_NCM_SF_SBESSEL_TABLE_JL_SIZE (tab)];
+  glong r;
+
+  for (r = i; r < f; r++)
+  {
+    gdouble *row = &int_jl_xn[r * tab->nx];
+    guint ix;
+
+    for (ix = 1; ix < tab->nx; ix++)
+      row[ix] += row[ix - 1];
+  }
+}
+
+typedef struct _NcmSFSBesselTableLoop
+{
+  NcmFuncEvalLoop lfunc;
+  NcmSFSBesselTable *tab;
+  glong i;
+  glong n;
+  glong nchunks;
+} NcmSFSBesselTableLoop;
+
+static void
+_ncm_sf_sbessel_table_loop_chunk (glong c0, glong c1, gpointer data)
+{
+  NcmSFSBesselTableLoop *loop = data;
+  glong c;
+
+  for (c = c0; c < c1; c++)
+  {
+    const glong li = loop->i + (c * loop->n) / loop->nchunks;
+    const glong lf = loop->i + ((c + 1) * loop->n) / loop->nchunks;
+
+    loop->lfunc (li, lf, loop->tab);
+  }
+}
+
+/*
+ * Splits [i, f) in at most NCM_THREAD_POOL_MAX chunks of at least
+ * _NCM_SF_SBESSEL_TABLE_MIN_CHUNK indices and sends one worker per chunk,
+ * short ranges are evaluated serially.
+ */
+static void
+_ncm_sf_sbessel_table_loop (NcmFuncEvalLoop lfunc, glong i, glong f, NcmSFSBesselTable *tab)
+{
+  const glong n       = f - i;
+  const glong nchunks = GSL_MIN (NCM_THREAD_POOL_MAX, n / _NCM_SF_SBESSEL_TABLE_MIN_CHUNK);
+
+  if (nchunks <= 1)
+    lfunc (i, f, tab);
+  else
+  {
+    NcmSFSBesselTableLoop loop = {lfunc, tab, i, n, nchunks};
+    ncm_func_eval_threaded_loop_full (&_ncm_sf_sbessel_table_loop_chunk, 0, nchunks, &loop);
+  }
+}
+
+/**
+ * ncm_sf_sbessel_table_new:
+ * @lmin: minimum $\ell$
+ * @lmax: maximum $\ell$
+ * @xi: first node $x_i \geq 0$
+ * @xf: last node $x_f > x_i$
+ * @nx: number of nodes
+ * @with_int: whether to also compute the integrals $I^n_\ell(x)$
+ *
+ * Computes a new table with $j_\ell(x)$ for
+ * $\ell = $ @lmin$, \dots, $ @lmax$ + 1$ on @nx uniformly spaced nodes in
+ * [@xi, @xf] and, if @with_int is TRUE, the integrals $I^n_\ell(x)$ for
+ * $\ell = $ @lmin$, \dots, $ @lmax.
+ *
+ * Returns: (transfer full): a new #NcmSFSBesselTable.
+ */
+NcmSFSBesselTable *
+ncm_sf_sbessel_table_new (const guint lmin, const guint lmax, const gdouble xi, const gdouble xf, const guint nx, const gboolean with_int)
+{
+  NcmSFSBesselTable *tab = _ncm_sf_sbessel_table_alloc (lmin, lmax, xi, xf, nx, with_int);
+  const gsize jl_size    = _NCM_SF_SBESSEL_TABLE_JL_SIZE (tab);
+  const gsize int_size   = _NCM_SF_SBESSEL_TABLE_INT_SIZE (tab);
+
+  tab->mem = g_new0 (gdouble, jl_size + int_size);
+
+  _ncm_sf_sbessel_table_loop (&_ncm_sf_sbessel_table_fill_jl, 0, tab->nx, tab);
+
+  if (with_int)
+  {
+    _ncm_sf_sbessel_table_loop (&_ncm_sf_sbessel_table_fill_int_step, 0, tab->nx, tab);
+    _ncm_sf_sbessel_table_loop (&_ncm_sf_sbessel_table_fill_int_sum, 0, NCM_SF_SBESSEL_TABLE_NINT * _NCM_SF_SBESSEL_TABLE_NL_INT (tab), tab);
+  }
+
+  tab->jl        = tab->mem;
+  tab->int_jl_xn = with_int ? &tab->mem[jl_size] : NULL;
+
+  return tab;
+}
+
+/**
+ * ncm_sf_sbessel_table_load:
+ * @filename: a file created by ncm_sf_sbessel_table_save()
+ *
+ * Maps the table in @filename into memory (read-only). The file must have
+ * been created in a machine with the same byte order.
+ *
+ * Returns: (transfer full): a new #NcmSFSBesselTable.
+ */
+NcmSFSBesselTable *
+ncm_sf_sbessel_table_load (const gchar *filename)
+{
+  GError *error                  = NULL;
+  GMappedFile *mfile             = g_mapped_file_new (filename, FALSE, &error);
+  const NcmSFSBesselTableHeader *header;
+  NcmSFSBesselTable *tab;
+  const gchar *contents;
+  gsize len;
+
+  if (mfile == NULL)
+    g_error ("ncm_sf_sbessel_table_load: cannot map file `%s': %s.", filename, error->message);
+
+  len      = g_mapped_file_get_length (mfile);
+  contents = g_mapped_file_get_contents (mfile);
+
+  if (len < sizeof (NcmSFSBesselTableHeader))
+    g_error ("ncm_sf_sbessel_table_load: file `%s' is too short.", filename);
+
+  header = (const NcmSFSBesselTableHeader *) contents;
+
+  if (memcmp (header->magic, NCM_SF_SBESSEL_TABLE_MAGIC, 8) != 0)
+    g_error ("ncm_sf_sbessel_table_load: `%s' is not a spherical Bessel table file.", filename);
+  if (header->byte_order != NCM_SF_SBESSEL_TABLE_BYTE_ORDER)
+    g_error ("ncm_sf_sbessel_table_load: `%s' was created in a machine with a different byte order.", filename);
+
+  tab = _ncm_sf_sbessel_table_alloc (header->lmin, header->lmax, header->xi, header->xf, header->nx, header->with_int);
+
+  {
+    const gsize jl_size  = _NCM_SF_SBESSEL_TABLE_JL_SIZE (tab);
+    const gsize int_size = _NCM_SF_SBESSEL_TABLE_INT_SIZE (tab);
+
+    if (len != sizeof (NcmSFSBesselTableHeader) + sizeof (gdouble) * (jl_size + int_size))
+      g_error ("ncm_sf_sbessel_table_load: file `%s' has the wrong size (%"G_GSIZE_FORMAT" != %"G_GSIZE_FORMAT").",
+               filename, len, sizeof (NcmSFSBesselTableHeader) + sizeof (gdouble) * (jl_size + int_size));
+
+    tab->mfile     = mfile;
+    tab->jl        = (const gdouble *) (contents + sizeof (NcmSFSBesselTableHeader));
+    tab->int_jl_xn = tab->with_int ? &tab->jl[jl_size] : NULL;
+  }
+
+  return tab;
+}
+
+/**
+ * ncm_sf_sbessel_table_cached_new:
+ * @lmin: minimum $\ell$
+ * @lmax: maximum $\ell$
+ * @xi: first node $x_i \geq 0$
+ * @xf: last node $x_f > x_i$
+ * @nx: number of nodes
+ * @with_int: whether to also compute the integrals $I^n_\ell(x)$
+ *
+ * Same as ncm_sf_sbessel_table_new() but the table is stored in the
+ * NumCosmo configuration directory the first time it is requested and
+ * mapped from there afterwards. Within a process the same instance is
+ * returned while it is referenced.
+ *
+ * Returns: (transfer full): a #NcmSFSBesselTable.
+ */
+NcmSFSBesselTable *
+ncm_sf_sbessel_table_cached_new (const guint lmin, const guint lmax, const gdouble xi, const gdouble xf, const guint nx, const gboolean with_int)
+{
+  gchar *range    = g_strdup_printf ("%.17g:%.17g", xi, xf);
+  gchar *hash     = g_compute_checksum_for_string (G_CHECKSUM_MD5, range, -1);
+  gchar *filename = g_strdup_printf ("sbessel_table_%u_%u_%u_%d_%s.dat", lmin, lmax, nx, with_int ? 1 : 0, hash);
+  NcmSFSBesselTable *tab;
+
+  G_LOCK (sbessel_table_cache);
+  if (_sbessel_table_cache == NULL)
+    _sbessel_table_cache = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, NULL);
+
+  tab = g_hash_table_lookup (_sbessel_table_cache, filename);
+
+  if (tab != NULL)
+  {
+    g_atomic_int_inc (&tab->ref_count);
+  }
+  else
+  {
+    gchar *full_filename = ncm_cfg_get_fullpath ("%s", filename);
+
+    if (!g_file_test (full_filename, G_FILE_TEST_EXISTS))
+    {
+      NcmSFSBesselTable *tab_new = ncm_sf_sbessel_table_new (lmin, lmax, xi, xf, nx, with_int);
+
+      ncm_sf_sbessel_table_save (tab_new, full_filename);
+      ncm_sf_sbessel_table_free (tab_new);
+    }
+
+    tab      = ncm_sf_sbessel_table_load (full_filename);
+    tab->key = filename;
+    filename = NULL;
+
+    g_hash_table_insert (_sbessel_table_cache, tab->key, tab);
+    g_free (full_filename);
+  }
+  G_UNLOCK (sbessel_table_cache);
+
+  g_free (range);
+  g_free (hash);
+  g_free (filename);
+
+  return tab;
+}
+
+/**
+ * ncm_sf_sbessel_table_ref:
+ * @tab: a #NcmSFSBesselTable
+ *
+ * Increases the reference count of @tab by one atomically.
+ *
+ * Returns: (transfer full): @tab.
+ */
+NcmSFSBesselTable *
+ncm_sf_sbessel_table_ref (NcmSFSBesselTable *tab)
+{
+  g_atomic_int_inc (&tab->ref_count);
+  return tab;
+}
+
+static void
+_ncm_sf_sbessel_table_destroy (NcmSFSBesselTable *tab)
+{
+  if (tab->mfile != NULL)
+    g_mapped_file_unref (tab->mfile);
+  g_free (tab->mem);
+  g_free (tab->key);
+  g_free (tab);
+}
+
+/**
+ * ncm_sf_sbessel_table_free:
+ * @tab: a #NcmSFSBesselTable
+ *
+ * Atomically decreases the reference count of @tab by one. If the reference count
+ * drops to 0, all memory allocated by @tab is released.
+ *
+ */
+void
+ncm_sf_sbessel_table_free (NcmSFSBesselTable *tab)
+{
+  if (tab->key != NULL)
+  {
+    G_LOCK (sbessel_table_cache);
+    if (g_atomic_int_dec_and_test (&tab->ref_count))
+    {
+      g_hash_table_remove (_sbessel_table_cache, tab->key);
+      _ncm_sf_sbessel_table_destroy (tab);
+    }
+    G_UNLOCK (sbessel_table_cache);
+  }
+  else if (g_atomic_int_dec_and_test (&tab->ref_count))
+  {
+    _ncm_sf_sbessel_table_destroy (tab);
+  }
+}
+
+/**
+ * ncm_sf_sbessel_table_clear:
+ * @tab: a #NcmSFSBesselTable
+ *
+ * If *@tab is different from NULL, atomically decreases the reference count of
+ * *@tab by one. If the reference count drops to 0, all memory allocated by
+ * *@tab is released and *@tab is set to NULL.
+ *
+ */
+void
+ncm_sf_sbessel_table_clear (NcmSFSBesselTable **tab)
+{
+  g_clear_pointer (tab, ncm_sf_sbessel_table_free);
+}
+
+/**
+ * ncm_sf_sbessel_table_save:
+ * @tab: a #NcmSFSBesselTable
+ * @filename: output filename
+ *
+ * Saves @tab in @filename. The file is first written to a temporary file in
+ * the same directory and then renamed, so concurrent processes never map a
+ * partially written table.
+ *
+ */
+void
+ncm_sf_sbessel_table_save (NcmSFSBesselTable *tab, const gchar *filename)
+{
+  NcmSFSBesselTableHeader header;
+  const gsize jl_size  = _NCM_SF_SBESSEL_TABLE_JL_SIZE (tab);
+  const gsize int_size = _NCM_SF_SBESSEL_TABLE_INT_SIZE (tab);
+  gchar *tmp_filename  = g_strdup_printf ("%s.XXXXXX", filename);
+  gint fd              = g_mkstemp (tmp_filename);
+  FILE *f;
+
+  if (fd == -1)
+    g_error ("ncm_sf_sbessel_table_save: cannot create temporary file `%s': %s.", tmp_filename, g_strerror (errno));
+
+  f = fdopen (fd, "wb");
+  g_assert (f != NULL);
+
+  memset (&header, 0, sizeof (NcmSFSBesselTableHeader));
+  memcpy (header.magic, NCM_SF_SBESSEL_TABLE_MAGIC, 8);
+  header.byte_order = NCM_SF_SBESSEL_TABLE_BYTE_ORDER;
+  header.lmin       = tab->lmin;
+  header.lmax       = tab->lmax;
+  header.nx         = tab->nx;
+  header.with_int   = tab->with_int ? 1 : 0;
+  header.xi         = tab->xi;
+  header.xf         = tab->xf;
+
+  if ((fwrite (&header, sizeof (NcmSFSBesselTableHeader), 1, f) != 1) ||
+      (fwrite (tab->jl, sizeof (gdouble), jl_size, f) != jl_size) ||
+      ((int_size > 0) && (fwrite (tab->int_jl_xn, sizeof (gdouble), int_size, f) != int_size)))
+    g_error ("ncm_sf_sbessel_table_save: error writing to `%s': %s.", tmp_filename, g_strerror (errno));
+
+  if (fclose (f) != 0)
+    g_error ("ncm_sf_sbessel_table_save: error closing `%s': %s.", tmp_filename, g_strerror (errno));
+
+  if (g_rename (tmp_filename, filename) != 0)
+    g_error ("ncm_sf_sbessel_table_save: cannot rename `%s' to `%s': %s.", tmp_filename, filename, g_strerror (errno));
+
+  g_free (tmp_filename);
+}
+
+/**
+ * ncm_sf_sbessel_table_get_lmin:
+ * @tab: a #NcmSFSBesselTable
+ *
+ * Returns: the minimum $\ell$ of @tab.
+ */
+guint
+ncm_sf_sbessel_table_get_lmin (NcmSFSBesselTable *tab)
+{
+  return tab->lmin;
+}
+
+/**
+ * ncm_sf_sbessel_table_get_lmax:
+ * @tab: a #NcmSFSBesselTable
+ *
+ * Returns: the maximum $\ell$ of @tab, $j_{\ell_\mathrm{max}+1}$ is also tabulated.
+ */
+guint
+ncm_sf_sbessel_table_get_lmax (NcmSFSBesselTable *tab)
+{
+  return tab->lmax;
+}
+
+/**
+ * ncm_sf_sbessel_table_get_nx:
+ * @tab: a #NcmSFSBesselTable
+ *
+ * Returns: the number of nodes of @tab.
+ */
+guint
+ncm_sf_sbessel_table_get_nx (NcmSFSBesselTable *tab)
+{
+  return tab->nx;
+}
+
+/**
+ * ncm_sf_sbessel_table_get_xi:
+ * @tab: a #NcmSFSBesselTable
+ *
+ * Returns: the first node of @tab.
+ */
+gdouble
+ncm_sf_sbessel_table_get_xi (NcmSFSBesselTable *tab)
+{
+  return tab->xi;
+}
+
+/**
+ * ncm_sf_sbessel_table_get_xf:
+ * @tab: a #NcmSFSBesselTable
+ *
+ * Returns: the last node of @tab.
+ */
+gdouble
+ncm_sf_sbessel_table_get_xf (NcmSFSBesselTable *tab)
+{
+  return tab->xf;
+}
+
+/**
+ * ncm_sf_sbessel_table_get_x:
+ * @tab: a #NcmSFSBesselTable
+ * @i: node index
+ *
+ * Returns: the @i-th node of @tab.
+ */
+gdouble
+ncm_sf_sbessel_table_get_x (NcmSFSBesselTable *tab, const guint i)
+{
+  return (i + 1 == tab->nx) ? tab->xf : (tab->xi + i * tab->dx);
+}
+
+/**
+ * ncm_sf_sbessel_table_has_int:
+ * @tab: a #NcmSFSBesselTable
+ *
+ * Returns: whether @tab contains the integrals $I^n_\ell(x)$.
+ */
+gboolean
+ncm_sf_sbessel_table_has_int (NcmSFSBesselTable *tab)
+{
+  return tab->with_int;
+}
+
+/**
+ * ncm_sf_sbessel_table_peek_jl: (skip)
+ * @tab: a #NcmSFSBesselTable
+ * @l: $\ell$
+ *
+ * Returns: (transfer none): the array with the @nx values of $j_\ell$ at the nodes.
+ */
+const gdouble *
+ncm_sf_sbessel_table_peek_jl (NcmSFSBesselTable *tab, const guint l)
+{
+  g_assert_cmpuint (l, >=, tab->lmin);
+  g_assert_cmpuint (l, <=, tab->lmax + 1);
+
+  return &tab->jl[(l - tab->lmin) * tab->nx];
+}
+
+/**
+ * ncm_sf_sbessel_table_peek_int_jl_xn: (skip)
+ * @tab: a #NcmSFSBesselTable
+ * @l: $\ell$
+ * @n: power $n$
+ *
+ * Returns: (transfer none): the array with the @nx values of $I^n_\ell$ at the nodes.
+ */
+const gdouble *
+ncm_sf_sbessel_table_peek_int_jl_xn (NcmSFSBesselTable *tab, const guint l, const guint n)
+{
+  g_assert (tab->with_int);
+  g_assert_cmpuint (l, >=, tab->lmin);
+  g_assert_cmpuint (l, <=, tab->lmax);
+  g_assert_cmpuint (n, <, NCM_SF_SBESSEL_TABLE_NINT);
+
+  return &tab->int_jl_xn[(n * _NCM_SF_SBESSEL_TABLE_NL_INT (tab) + (l - tab->lmin)) * tab->nx];
+}
+
+static inline void
+_ncm_sf_sbessel_table_locate (NcmSFSBesselTable *tab, const gdouble x, guint *i, gdouble *t)
+{
+  const gdouble u = (x - tab->xi) / tab->dx;
+  guint k;
+
+  if (G_UNLIKELY ((x < tab->xi) || (x > tab->xf)))
+    g_error ("ncm_sf_sbessel_table: x = % 22.15g outside the table range [% 22.15g, % 22.15g].", x, tab->xi, tab->xf);
+
+  k = (guint) u;
+  if (k > tab->nx - 2)
+    k = tab->nx - 2;
+
+  i[0] = k;
+  t[0] = u - k;
+}
+
+static inline gdouble
+_ncm_sf_sbessel_table_djl (const guint l, const gdouble x, const gdouble jl, const gdouble jlp1)
+{
+  if (x == 0.0)
+    return (l == 1) ? (1.0 / 3.0) : 0.0;
+  else
+    return l * jl / x - jlp1;
+}
+
+static inline gdouble
+_ncm_sf_sbessel_table_hermite (const gdouble t, const gdouble h, const gdouble y0, const gdouble m0, const gdouble y1, const gdouble m1)
+{
+  const gdouble t2 = t * t;
+  const gdouble t3 = t2 * t;
+
+  return (2.0 * t3 - 3.0 * t2 + 1.0) * y0 + (t3 - 2.0 * t2 + t) * h * m0 + (3.0 * t2 - 2.0 * t3) * y1 + (t3 - t2) * h * m1;
+}
+
+/**
+ * ncm_sf_sbessel_table_eval_jl:
+ * @tab: a #NcmSFSBesselTable
+ * @l: $\ell$
+ * @x: $x$
+ *
+ * Returns: $j_\ell(x)$ interpolated from @tab.
+ */
+gdouble
+ncm_sf_sbessel_table_eval_jl (NcmSFSBesselTable *tab, const guint l, const gdouble x)
+{
+  const gdouble *jl   = ncm_sf_sbessel_table_peek_jl (tab, l);
+  const gdouble *jlp1 = jl + tab->nx;
+  guint i;
+  gdouble t;
+
+  g_assert_cmpuint (l, <=, tab->lmax);
+  _ncm_sf_sbessel_table_locate (tab, x, &i, &t);
+
+  {
+    const gdouble x0 = ncm_sf_sbessel_table_get_x (tab, i);
+    const gdouble x1 = ncm_sf_sbessel_table_get_x (tab, i + 1);
+
+    return _ncm_sf_sbessel_table_hermite (t, tab->dx,
+                                          jl[i],     _ncm_sf_sbessel_table_djl (l, x0, jl[i],     jlp1[i]),
+                                          jl[i + 1], _ncm_sf_sbessel_table_djl (l, x1, jl[i + 1], jlp1[i + 1]));
+  }
+}
+
+/**
+ * ncm_sf_sbessel_table_eval_jl_array:
+ * @tab: a #NcmSFSBesselTable
+ * @l: $\ell$
+ * @x: (array length=len): array of $x$
+ * @jl: (out caller-allocates) (array length=len): output array
+ * @len: number of points
+ *
+ * Interpolates $j_\ell$ at the @len points in @x. The points are processed
+ * in chunks, the range of each chunk is checked once and the nodes are
+ * located in a first pass, the interpolation is then done in a second pass
+ * without branches (the derivative at $x = 0$ is chosen by a select).
+ *
+ */
+void
+ncm_sf_sbessel_table_eval_jl_array (NcmSFSBesselTable *tab, const guint l, const gdouble *x, gdouble *jl, const gsize len)
+{
+  const gdouble *jl_l   = ncm_sf_sbessel_table_peek_jl (tab, l);
+  const gdouble *jl_lp1 = jl_l + tab->nx;
+  const gdouble dx      = tab->dx;
+  const gdouble xi      = tab->xi;
+  const gdouble lf      = l;
+  const gdouble dj_0    = (l == 1) ? (1.0 / 3.0) : 0.0;
+  const guint kmax      = tab->nx - 2;
+  guint i[_NCM_SF_SBESSEL_TABLE_EVAL_CHUNK];
+  gdouble t[_NCM_SF_SBESSEL_TABLE_EVAL_CHUNK];
+  gsize p0;
+
+  g_assert_cmpuint (l, <=, tab->lmax);
+
+  for (p0 = 0; p0 < len; p0 += _NCM_SF_SBESSEL_TABLE_EVAL_CHUNK)
+  {
+    const gsize n      = GSL_MIN (len - p0, _NCM_SF_SBESSEL_TABLE_EVAL_CHUNK);
+    const gdouble *x_c = &x[p0];
+    gdouble *jl_c      = &jl[p0];
+    gdouble x_min      = x_c[0];
+    gdouble x_max      = x_c[0];
+    gsize p;
+
+    for (p = 1; p < n; p++)
+    {
+      x_min = GSL_MIN (x_min, x_c[p]);
+      x_max = GSL_MAX (x_max, x_c[p]);
+    }
+
+    if (G_UNLIKELY ((x_min < tab->xi) || (x_max > tab->xf)))
+      g_error ("ncm_sf_sbessel_table_eval_jl_array: x in [% 22.15g, % 22.15g] outside the table range [% 22.15g, % 22.15g].", 
+               x_min, x_max, tab->xi, tab->xf);
+
+    for (p = 0; p < n; p++)
+    {
+      const gdouble u = (x_c[p] - xi) / dx;
+      const guint k   = GSL_MIN ((guint) u, kmax);
+
+      i[p] = k;
+      t[p] = u - k;
+    }
+
+    for (p = 0; p < n; p++)
+    {
+      const guint k    = i[p];
+      const gdouble x0 = xi + k * dx;
+      const gdouble x1 = x0 + dx;
+      const gdouble m0 = (x0 == 0.0) ? dj_0 : (lf * jl_l[k] / x0 - jl_lp1[k]);
+      const gdouble m1 = lf * jl_l[k + 1] / x1 - jl_lp1[k + 1];
+
+      jl_c[p] = _ncm_sf_sbessel_table_hermite (t[p], dx, jl_l[k], m0, jl_l[k + 1], m1);
+    }
+  }
+}
+
+/**
+ * ncm_sf_sbessel_table_eval_int_jl_xn:
+ * @tab: a #NcmSFSBesselTable
+ * @l: $\ell$
+ * @n: power $n \leq 3$
+ * @x: $x$
+ *
+ * Returns: $I^n_\ell(x) = \int_0^x\mathrm{d}t\,t^nj_\ell(t)$ interpolated from @tab.
+ */
+gdouble
+ncm_sf_sbessel_table_eval_int_jl_xn (NcmSFSBesselTable *tab, const guint l, const guint n, const gdouble x)
+{
+  const gdouble *I_n = ncm_sf_sbessel_table_peek_int_jl_xn (tab, l, n);
+  const gdouble *jl  = ncm_sf_sbessel_table_peek_jl (tab, l);
+  guint i;
+  gdouble t;
+
+  _ncm_sf_sbessel_table_locate (tab, x, &i, &t);
+
+  {
+    const gdouble x0 = ncm_sf_sbessel_table_get_x (tab, i);
+    const gdouble x1 = ncm_sf_sbessel_table_get_x (tab, i + 1);
+
+    return _ncm_sf_sbessel_table_hermite (t, tab->dx,
+                                          I_n[i],     gsl_pow_int (x0, n) * jl[i],
+                                          I_n[i + 1], gsl_pow_int (x1, n) * jl[i + 1]);
+  }
+}
+
+/**
+ * ncm_sf_sbessel_table_validate:
+ * @tab: a #NcmSFSBesselTable
+ * @nsamples: number of samples
+ * @abstol: absolute tolerance
+ *
+ * Compares @nsamples interpolated values of $j_\ell(x)$ (and of
+ * $I^n_\ell(x)$ if present) against the multiple precision implementations
+ * ncm_sf_sbessel() and ncm_sf_sbessel_jl_xj_integral(). The samples are
+ * deterministic, spread over all $\ell$ and placed between the nodes.
+ * For each sample the error is computed as
+ * $\vert f_\mathrm{tab} - f_\mathrm{mp}\vert / (\vert f_\mathrm{mp}\vert + \epsilon\max(1, x^n))$,
+ * where $\epsilon$ is @abstol and $n = 0$ for $j_\ell$.
+ *
+ * Returns: the largest error found.
+ */
+gdouble
+ncm_sf_sbessel_table_validate (NcmSFSBesselTable *tab, const guint nsamples, const gdouble abstol)
+{
+  const guint nl = tab->lmax - tab->lmin + 1;
+  gdouble max_err = 0.0;
+  guint s;
+
+  for (s = 0; s < nsamples; s++)
+  {
+    const guint l   = tab->lmin + (guint) ((s * 7919UL) % nl);
+    const gdouble x = tab->xi + (tab->xf - tab->xi) * (s + 0.5) / nsamples;
+
+    {
+      const gdouble jl_tab = ncm_sf_sbessel_table_eval_jl (tab, l, x);
+      const gdouble jl_mp  = ncm_sf_sbessel (l, x);
+
+      max_err = GSL_MAX (max_err, fabs (jl_tab - jl_mp) / (fabs (jl_mp) + abstol));
+    }
+
+    if (tab->with_int)
+    {
+      const guint n        = s % NCM_SF_SBESSEL_TABLE_NINT;
+      const gdouble I_tab  = ncm_sf_sbessel_table_eval_int_jl_xn (tab, l, n, x);
+      const gdouble I_mp   = ncm_sf_sbessel_jl_xj_integral (l, n, x);
+
+      max_err = GSL_MAX (max_err, fabs (I_tab - I_mp) / (fabs (I_mp) + abstol * GSL_MAX (1.0, gsl_pow_int (x, n))));
+    }
+  }
+
+  return max_err;
+}
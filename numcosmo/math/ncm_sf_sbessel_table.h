@@ -0,0 +1,100 @@
+/***************************************************************************
+ *            ncm_sf_sbessel_table.h
+ *
+ *  Mon October 19 16:02:11 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_sf_sbessel_table.h
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _NCM_SF_SBESSEL_TABLE_H_
+#define _NCM_SF_SBESSEL_TABLE_H_
+
+#include <glib.h>
+#include <glib-object.h>
+#include <numcosmo/build_cfg.h>
+
+G_BEGIN_DECLS
+
+#define NCM_TYPE_SF_SBESSEL_TABLE (ncm_sf_sbessel_table_get_type ())
+
+typedef struct _NcmSFSBesselTable NcmSFSBesselTable;
+
+/**
+ * NcmSFSBesselTable:
+ *
+ * Read-only table of spherical Bessel functions and their integrals.
+ */
+struct _NcmSFSBesselTable
+{
+  /*< private >*/
+  gint ref_count;
+  gchar *key;
+  guint lmin;
+  guint lmax;
+  guint nx;
+  gdouble xi;
+  gdouble xf;
+  gdouble dx;
+  gboolean with_int;
+  GMappedFile *mfile;
+  gdouble *mem;
+  const gdouble *jl;
+  const gdouble *int_jl_xn;
+};
+
+/**
+ * NCM_SF_SBESSEL_TABLE_NINT:
+ *
+ * Number of tabulated integrals $\int_0^x\mathrm{d}t\,t^nj_\ell(t)$,
+ * $n = 0, \dots, 3$.
+ */
+#define NCM_SF_SBESSEL_TABLE_NINT 4
+
+GType ncm_sf_sbessel_table_get_type (void) G_GNUC_CONST;
+
+NcmSFSBesselTable *ncm_sf_sbessel_table_new (const guint lmin, const guint lmax, const gdouble xi, const gdouble xf, const guint nx, const gboolean with_int);
+NcmSFSBesselTable *ncm_sf_sbessel_table_load (const gchar *filename);
+NcmSFSBesselTable *ncm_sf_sbessel_table_cached_new (const guint lmin, const guint lmax, const gdouble xi, const gdouble xf, const guint nx, const gboolean with_int);
+NcmSFSBesselTable *ncm_sf_sbessel_table_ref (NcmSFSBesselTable *tab);
+void ncm_sf_sbessel_table_free (NcmSFSBesselTable *tab);
+void ncm_sf_sbessel_table_clear (NcmSFSBesselTable **tab);
+
+void ncm_sf_sbessel_table_save (NcmSFSBesselTable *tab, const gchar *filename);
+
+guint ncm_sf_sbessel_table_get_lmin (NcmSFSBesselTable *tab);
+guint ncm_sf_sbessel_table_get_lmax (NcmSFSBesselTable *tab);
+guint ncm_sf_sbessel_table_get_nx (NcmSFSBesselTable *tab);
+gdouble ncm_sf_sbessel_table_get_xi (NcmSFSBesselTable *tab);
+gdouble ncm_sf_sbessel_table_get_xf (NcmSFSBesselTable *tab);
+gdouble ncm_sf_sbessel_table_get_x (NcmSFSBesselTable *tab, const guint i);
+gboolean ncm_sf_sbessel_table_has_int (NcmSFSBesselTable *tab);
+
+const gdouble *ncm_sf_sbessel_table_peek_jl (NcmSFSBesselTable *tab, const guint l);
+const gdouble *ncm_sf_sbessel_table_peek_int_jl_xn (NcmSFSBesselTable *tab, const guint l, const guint n);
+
+gdouble ncm_sf_sbessel_table_eval_jl (NcmSFSBesselTable *tab, const guint l, const gdouble x);
+void ncm_sf_sbessel_table_eval_jl_array (NcmSFSBesselTable *tab, const guint l, const gdouble *x, gdouble *jl, const gsize len);
+gdouble ncm_sf_sbessel_table_eval_int_jl_xn (NcmSFSBesselTable *tab, const guint l, const guint n, const gdouble x);
+
+gdouble ncm_sf_sbessel_table_validate (NcmSFSBesselTable *tab, const guint nsamples, const gdouble abstol);
+
+G_END_DECLS
+
+#endif /* _NCM_SF_SBESSEL_TABLE_H_ */
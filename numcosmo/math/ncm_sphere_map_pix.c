@@ -40,7 +40,7 @@
 #include "math/ncm_util.h"
 #include "math/ncm_cfg.h"
 #include "math/ncm_c.h"
-#include "math/ncm_timer.h"
+#include "math/ncm_func_eval.h"
 #include "ncm_enum_types.h"
 
 #include <gsl/gsl_sf_legendre.h>
@@ -86,6 +86,15 @@
 
 #include <gsl/gsl_sf_trig.h>
 
+#define NCM_SPHERE_MAP_PIX_FFT_MIDDLE_BATCH 16
+#define NCM_SPHERE_MAP_PIX_ANG2PIX_BLOCK 256
+
+typedef struct _NcmSphereMapPixRange
+{
+  gint64 first;
+  gint64 last;
+} NcmSphereMapPixRange;
+
 enum
 {
   PROP_0,
@@ -113,6 +122,7 @@ ncm_sphere_map_pix_init (NcmSphereMapPix *pix)
   pix->coordsys          = NCM_SPHERE_MAP_PIX_COORD_SYS_LEN;
   pix->pvec              = NULL;
   pix->fft_pvec          = NULL;
+  pix->partial           = g_array_new (FALSE, FALSE, sizeof (NcmSphereMapPixRange));
   pix->fft_plan_r2c      = g_ptr_array_new ();
   pix->fft_plan_c2r      = g_ptr_array_new ();
 #ifdef NUMCOSMO_HAVE_FFTW3
@@ -124,12 +134,14 @@ ncm_sphere_map_pix_init (NcmSphereMapPix *pix)
   g_ptr_array_set_free_func (pix->fft_plan_c2r, (GDestroyNotify)fftw_destroy_plan);
 #  endif
 #endif
-  pix->Ylm = NULL;
-  pix->alm = NULL;
-  pix->Cl  = NULL;
-  pix->t   = ncm_timer_new ();
+  pix->ylm_tab = NULL;
+  pix->alm     = NULL;
+  pix->Cl_lm   = NULL;
+  pix->Cl      = NULL;
 }
 
+static void _ncm_sphere_map_pix_ylm_tab_clear (NcmSphereMapPixYlmTab **ylm_tab);
+
 static void
 _ncm_sphere_map_pix_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
 {
@@ -187,8 +199,9 @@ _ncm_sphere_map_pix_dispose (GObject *object)
 {
   NcmSphereMapPix *pix = NCM_SPHERE_MAP_PIX (object);
 
-  ncm_vector_clear (&pix->Ylm);
+  _ncm_sphere_map_pix_ylm_tab_clear (&pix->ylm_tab);
   ncm_vector_clear (&pix->alm);
+  ncm_vector_clear (&pix->Cl_lm);
   ncm_vector_clear (&pix->Cl);
   
   
@@ -202,11 +215,13 @@ _ncm_sphere_map_pix_finalize (GObject *object)
   NcmSphereMapPix *pix = NCM_SPHERE_MAP_PIX (object);
 
   ncm_sphere_map_pix_set_nside (pix, 0);
+  g_array_unref (pix->partial);
   g_ptr_array_unref (pix->fft_plan_r2c);
   g_ptr_array_unref (pix->fft_plan_c2r);
 
-  ncm_vector_clear (&pix->Ylm);
+  _ncm_sphere_map_pix_ylm_tab_clear (&pix->ylm_tab);
   ncm_vector_clear (&pix->alm);
+  ncm_vector_clear (&pix->Cl_lm);
   ncm_vector_clear (&pix->Cl);
   
   
@@ -352,6 +367,9 @@ ncm_sphere_map_pix_set_nside (NcmSphereMapPix *pix, gint64 nside)
 #endif
     g_ptr_array_set_size (pix->fft_plan_r2c, 0);
     g_ptr_array_set_size (pix->fft_plan_c2r, 0);
+
+    _ncm_sphere_map_pix_ylm_tab_clear (&pix->ylm_tab);
+    g_array_set_size (pix->partial, 0);
     
     if (nside > 0)
     {
@@ -629,21 +647,20 @@ ncm_sphere_map_pix_set_lmax (NcmSphereMapPix *pix, guint lmax)
 {
   if (pix->lmax != lmax)
   {
-    ncm_vector_clear (&pix->Ylm);
+    _ncm_sphere_map_pix_ylm_tab_clear (&pix->ylm_tab);
     ncm_vector_clear (&pix->alm);
+    ncm_vector_clear (&pix->Cl_lm);
     ncm_vector_clear (&pix->Cl);
     pix->lmax = lmax;
     
     if (pix->lmax > 0)
     {
-      gsize Ylm_size  = gsl_sf_legendre_array_n (pix->lmax);
-
-      pix->Ylm = ncm_vector_new (Ylm_size);
-      pix->alm = ncm_vector_new (2 * NCM_SPHERE_MAP_PIX_ALM_SIZE (pix->lmax));
-      pix->Cl  = ncm_vector_new (pix->lmax + 1);
+      pix->alm   = ncm_vector_new (2 * NCM_SPHERE_MAP_PIX_ALM_SIZE (pix->lmax));
+      pix->Cl_lm = ncm_vector_new (NCM_SPHERE_MAP_PIX_ALM_SIZE (pix->lmax));
+      pix->Cl    = ncm_vector_new (pix->lmax + 1);
 
-      ncm_vector_set_zero (pix->Ylm);
       ncm_vector_set_zero (pix->alm);
+      ncm_vector_set_zero (pix->Cl_lm);
       ncm_vector_set_zero (pix->Cl);
     }
   }
@@ -669,6 +686,195 @@ ncm_sphere_map_pix_clear_pixels (NcmSphereMapPix *pix)
     _fft_vec_set_zero (pix->pvec, pix->npix);
 }
 
+/**
+ * ncm_sphere_map_pix_get_pix:
+ * @pix: a #NcmSphereMapPix
+ * @index: pixel index in the current ordering of @pix
+ *
+ * Returns: the value of the pixel @index.
+ */
+gdouble
+ncm_sphere_map_pix_get_pix (NcmSphereMapPix *pix, const gint64 index)
+{
+  g_assert_cmpint (index, >=, 0);
+  g_assert_cmpint (index, <, pix->npix);
+
+  return _fft_vec_idx (pix->pvec, index);
+}
+
+static gint
+_ncm_sphere_map_pix_range_cmp (gconstpointer a, gconstpointer b)
+{
+  const NcmSphereMapPixRange *ra = a;
+  const NcmSphereMapPixRange *rb = b;
+
+  return (ra->first < rb->first) ? -1 : ((ra->first > rb->first) ? 1 : 0);
+}
+
+/**
+ * ncm_sphere_map_pix_partial_add_pixels:
+ * @pix: a #NcmSphereMapPix
+ * @first: first pixel (RING ordering)
+ * @last: last pixel (RING ordering)
+ *
+ * Adds the closed interval of pixels [@first, @last], in the RING
+ * ordering, to the partial sky selection of @pix. The selection restricts
+ * the pixels read and written by the FITS functions and the points binned
+ * by ncm_sphere_map_pix_add_to_ang_array(). Overlapping and adjacent
+ * intervals are merged, and the selection is kept when the map ordering
+ * changes. An empty selection means the full sky.
+ *
+ */
+void
+ncm_sphere_map_pix_partial_add_pixels (NcmSphereMapPix *pix, const gint64 first, const gint64 last)
+{
+  NcmSphereMapPixRange range = {first, last};
+  guint i, j;
+
+  g_assert_cmpint (pix->nside, >, 0);
+  g_assert_cmpint (first, >=, 0);
+  g_assert_cmpint (last, >=, first);
+  g_assert_cmpint (last, <, pix->npix);
+
+  g_array_append_val (pix->partial, range);
+  g_array_sort (pix->partial, _ncm_sphere_map_pix_range_cmp);
+
+  for (i = 0, j = 1; j < pix->partial->len; j++)
+  {
+    NcmSphereMapPixRange *r_i = &g_array_index (pix->partial, NcmSphereMapPixRange, i);
+    NcmSphereMapPixRange *r_j = &g_array_index (pix->partial, NcmSphereMapPixRange, j);
+
+    if (r_j->first <= r_i->last + 1)
+      r_i->last = GSL_MAX (r_i->last, r_j->last);
+    else
+    {
+      i++;
+      g_array_index (pix->partial, NcmSphereMapPixRange, i) = *r_j;
+    }
+  }
+
+  g_array_set_size (pix->partial, i + 1);
+}
+
+/**
+ * ncm_sphere_map_pix_partial_add_rings:
+ * @pix: a #NcmSphereMapPix
+ * @r_first: first ring index
+ * @r_last: last ring index
+ *
+ * Adds all pixels in the rings @r_first to @r_last (inclusive) to the
+ * partial sky selection, see ncm_sphere_map_pix_partial_add_pixels().
+ *
+ */
+void
+ncm_sphere_map_pix_partial_add_rings (NcmSphereMapPix *pix, const gint64 r_first, const gint64 r_last)
+{
+  g_assert_cmpint (r_first, >=, 0);
+  g_assert_cmpint (r_last, >=, r_first);
+  g_assert_cmpint (r_last, <, pix->nrings);
+
+  ncm_sphere_map_pix_partial_add_pixels (pix,
+                                         ncm_sphere_map_pix_get_ring_first_index (pix, r_first),
+                                         ncm_sphere_map_pix_get_ring_first_index (pix, r_last) + ncm_sphere_map_pix_get_ring_size (pix, r_last) - 1);
+}
+
+/**
+ * ncm_sphere_map_pix_partial_clear:
+ * @pix: a #NcmSphereMapPix
+ *
+ * Removes the partial sky selection, i.e., selects the full sky.
+ *
+ */
+void
+ncm_sphere_map_pix_partial_clear (NcmSphereMapPix *pix)
+{
+  g_array_set_size (pix->partial, 0);
+}
+
+/**
+ * ncm_sphere_map_pix_partial_is_full_sky:
+ * @pix: a #NcmSphereMapPix
+ *
+ * Returns: whether @pix has no partial sky selection.
+ */
+gboolean
+ncm_sphere_map_pix_partial_is_full_sky (NcmSphereMapPix *pix)
+{
+  return (pix->partial->len == 0);
+}
+
+/**
+ * ncm_sphere_map_pix_partial_get_npix:
+ * @pix: a #NcmSphereMapPix
+ *
+ * Returns: the number of pixels in the partial sky selection (the total number
+ * of pixels for the full sky).
+ */
+gint64
+ncm_sphere_map_pix_partial_get_npix (NcmSphereMapPix *pix)
+{
+  if (pix->partial->len == 0)
+  {
+    return pix->npix;
+  }
+  else
+  {
+    gint64 npix = 0;
+    guint i;
+
+    for (i = 0; i < pix->partial->len; i++)
+    {
+      const NcmSphereMapPixRange *r_i = &g_array_index (pix->partial, NcmSphereMapPixRange, i);
+      npix += r_i->last - r_i->first + 1;
+    }
+
+    return npix;
+  }
+}
+
+static gboolean
+_ncm_sphere_map_pix_partial_contains_ring (NcmSphereMapPix *pix, const gint64 ring_index)
+{
+  gint64 lo = 0;
+  gint64 hi = (gint64) pix->partial->len - 1;
+
+  if (pix->partial->len == 0)
+    return TRUE;
+
+  while (lo <= hi)
+  {
+    const gint64 mid = (lo + hi) / 2;
+    const NcmSphereMapPixRange *r_mid = &g_array_index (pix->partial, NcmSphereMapPixRange, mid);
+
+    if (ring_index < r_mid->first)
+      hi = mid - 1;
+    else if (ring_index > r_mid->last)
+      lo = mid + 1;
+    else
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/**
+ * ncm_sphere_map_pix_partial_contains:
+ * @pix: a #NcmSphereMapPix
+ * @index: pixel index in the current ordering of @pix
+ *
+ * Returns: whether the pixel @index belongs to the partial sky selection.
+ */
+gboolean
+ncm_sphere_map_pix_partial_contains (NcmSphereMapPix *pix, const gint64 index)
+{
+  if (pix->partial->len == 0)
+    return TRUE;
+  else if (pix->order == NCM_SPHERE_MAP_PIX_ORDER_NEST)
+    return _ncm_sphere_map_pix_partial_contains_ring (pix, ncm_sphere_map_pix_nest2ring (pix, index));
+  else
+    return _ncm_sphere_map_pix_partial_contains_ring (pix, index);
+}
+
 /**
  * ncm_sphere_map_pix_nest2ring: 
  * @pix: a #NcmSphereMapPix
@@ -1346,13 +1552,133 @@ ncm_sphere_map_pix_add_to_ang (NcmSphereMapPix *pix, const gdouble theta, const
   _fft_vec_idx (pix->pvec, index) += s;
 }
 
+/**
+ * ncm_sphere_map_pix_ang2pix_array:
+ * @pix: a #NcmSphereMapPix
+ * @theta: (array length=len): array of $\theta$
+ * @phi: (array length=len): array of $\phi$
+ * @index: (out caller-allocates) (array length=len): output pixel indexes
+ * @len: number of points
+ *
+ * Computes the pixel indexes (in the current ordering of @pix) of @len
+ * points. The points are processed in blocks: all trigonometric functions
+ * of a block are computed first in a tight loop and then binned, which
+ * is considerably faster than calling ncm_sphere_map_pix_ang2pix_ring() or
+ * ncm_sphere_map_pix_ang2pix_nest() for each point.
+ *
+ */
+void
+ncm_sphere_map_pix_ang2pix_array (NcmSphereMapPix *pix, const gdouble *theta, const gdouble *phi, gint64 *index, const gsize len)
+{
+  gdouble z[NCM_SPHERE_MAP_PIX_ANG2PIX_BLOCK];
+  gdouble onemz2[NCM_SPHERE_MAP_PIX_ANG2PIX_BLOCK];
+  gsize i0;
+
+  for (i0 = 0; i0 < len; i0 += NCM_SPHERE_MAP_PIX_ANG2PIX_BLOCK)
+  {
+    const gsize nb = GSL_MIN (NCM_SPHERE_MAP_PIX_ANG2PIX_BLOCK, len - i0);
+    const gdouble *theta_b = &theta[i0];
+    const gdouble *phi_b   = &phi[i0];
+    gint64 *index_b        = &index[i0];
+    gsize j;
+
+    for (j = 0; j < nb; j++)
+    {
+      const gdouble cos_theta = cos (theta_b[j]);
+      const gdouble sin_theta = sin (theta_b[j]);
+
+      z[j]      = cos_theta;
+      onemz2[j] = (theta_b[j] > 0.1) ? (1.0 - cos_theta * cos_theta) : (sin_theta * sin_theta);
+    }
+
+    switch (pix->order)
+    {
+      case NCM_SPHERE_MAP_PIX_ORDER_NEST:
+        for (j = 0; j < nb; j++)
+          _ncm_sphere_map_pix_zphi2pix_nest (pix, z[j], onemz2[j], phi_b[j], &index_b[j]);
+        break;
+      case NCM_SPHERE_MAP_PIX_ORDER_RING:
+        for (j = 0; j < nb; j++)
+          _ncm_sphere_map_pix_zphi2pix_ring (pix, z[j], onemz2[j], phi_b[j], &index_b[j]);
+        break;
+      default:
+        g_assert_not_reached ();
+        break;
+    }
+  }
+}
+
+static void
+_ncm_sphere_map_pix_bin_index (NcmSphereMapPix *pix, const gint64 *index, const gdouble *s, const gsize len)
+{
+  const gboolean full_sky = ncm_sphere_map_pix_partial_is_full_sky (pix);
+  gsize i;
+
+  if (full_sky && (s == NULL))
+  {
+    for (i = 0; i < len; i++)
+      _fft_vec_idx (pix->pvec, index[i]) += 1.0;
+  }
+  else if (full_sky)
+  {
+    for (i = 0; i < len; i++)
+      _fft_vec_idx (pix->pvec, index[i]) += s[i];
+  }
+  else
+  {
+    for (i = 0; i < len; i++)
+    {
+      if (ncm_sphere_map_pix_partial_contains (pix, index[i]))
+        _fft_vec_idx (pix->pvec, index[i]) += (s != NULL) ? s[i] : 1.0;
+    }
+  }
+}
+
+/**
+ * ncm_sphere_map_pix_add_to_ang_array:
+ * @pix: a #NcmSphereMapPix
+ * @theta: (array length=len): array of $\theta$
+ * @phi: (array length=len): array of $\phi$
+ * @s: (array length=len) (allow-none): array of signals or NULL
+ * @len: number of points
+ *
+ * Adds the signals @s (or one for each point when @s is NULL) to the pixels
+ * containing the points ($\theta$, $\phi$), see
+ * ncm_sphere_map_pix_ang2pix_array(). Points outside the partial sky
+ * selection are discarded.
+ *
+ */
+void
+ncm_sphere_map_pix_add_to_ang_array (NcmSphereMapPix *pix, const gdouble *theta, const gdouble *phi, const gdouble *s, const gsize len)
+{
+  gint64 index[NCM_SPHERE_MAP_PIX_ANG2PIX_BLOCK];
+  gsize i0;
+
+  for (i0 = 0; i0 < len; i0 += NCM_SPHERE_MAP_PIX_ANG2PIX_BLOCK)
+  {
+    const gsize nb = GSL_MIN (NCM_SPHERE_MAP_PIX_ANG2PIX_BLOCK, len - i0);
+
+    ncm_sphere_map_pix_ang2pix_array (pix, &theta[i0], &phi[i0], index, nb);
+    _ncm_sphere_map_pix_bin_index (pix, index, (s != NULL) ? &s[i0] : NULL, nb);
+  }
+}
+
 /**
  * ncm_sphere_map_pix_load_fits:
  * @pix: a #NcmSphereMapPix
  * @fits_file: fits filename
  * @signal_name: (allow-none): signal column name in @fits_file
  *
- * FIXME 
+ * Loads the map in @fits_file into @pix. Both full sky (implicit indexing)
+ * and partial sky (explicit indexing, with a PIXEL column) HEALPix maps are
+ * supported. The rows are read in chunks of at most
+ * #NCM_SPHERE_MAP_PIX_FITS_CHUNK, so the memory used in addition to the map
+ * itself is bounded.
+ * 
+ * If @pix has a partial sky selection (see
+ * ncm_sphere_map_pix_partial_add_pixels()) and the same nside as the file,
+ * only the selected pixels are read and all others are set to zero. When the
+ * file is in RING ordering only the rows of the selected pixels are read.
  * 
  */
 void
@@ -1361,10 +1687,12 @@ ncm_sphere_map_pix_load_fits (NcmSphereMapPix *pix, const gchar *fits_file, cons
   gchar comment[FLEN_COMMENT];
   gchar ordering[FLEN_VALUE];
   gchar coordsys[FLEN_VALUE];
+  gchar indxschm[FLEN_VALUE];
   gint  status, hdutype, anynul;   
   glong nside, nfields, naxis2;
   gint signal_i = 0;
   const gchar *sname = signal_name != NULL ?  signal_name : NCM_SPHERE_MAP_PIX_DEFAULT_SIGNAL;
+  gboolean explicit_index = FALSE;
   fitsfile *fptr;
 
   status = 0;
@@ -1392,27 +1720,26 @@ ncm_sphere_map_pix_load_fits (NcmSphereMapPix *pix, const gchar *fits_file, cons
   fits_read_key_lng (fptr, "NAXIS2", &naxis2, comment, &status); 
   NCM_FITS_ERROR(status);
 
-  g_assert_cmpint (naxis2, ==, ncm_sphere_map_pix_get_npix (pix));
+  if (fits_read_key (fptr, TSTRING, "INDXSCHM", indxschm, comment, &status))
+  {
+    indxschm[0] = '\0';
+    status      = 0;
+  }
+  
+  explicit_index = g_str_has_prefix (indxschm, "EXPLICIT");
+
+  if (!explicit_index)
+    g_assert_cmpint (naxis2, ==, ncm_sphere_map_pix_get_npix (pix));
 
   if (fits_get_colnum (fptr, CASESEN, (gchar *)sname, &signal_i, &status))
     g_error ("ncm_sphere_map_pix_load_fits: signal column named `%s' not found in `%s'.",
              sname, fits_file);
 
-#ifdef HAVE_FFTW3F
-  fits_read_col_flt (fptr, signal_i, 1, 1, naxis2, NCM_SPHERE_MAP_PIX_HEALPIX_NULLVAL, 
-                     _fft_vec_ptr (pix->pvec, 0), &anynul, &status); 
-#elif defined (HAVE_FFTW3)
-  fits_read_col_dbl (fptr, signal_i, 1, 1, naxis2, NCM_SPHERE_MAP_PIX_HEALPIX_NULLVAL, 
-                     _fft_vec_ptr (pix->pvec, 0), &anynul, &status); 
-#else
-  fits_read_col_flt (fptr, signal_i, 1, 1, naxis2, NCM_SPHERE_MAP_PIX_HEALPIX_NULLVAL, 
-                     _fft_vec_ptr (pix->pvec, 0), &anynul, &status); 
-#endif  
-  NCM_FITS_ERROR (status);
-
   if (fits_read_key (fptr, TSTRING, "ORDERING", ordering, comment, &status)) 
   {
     g_warning ("ncm_sphere_map_pix_load_fits: Could not find ORDERING in the fits file, assuming RING.");
+    ordering[0] = 'R';
+    ordering[1] = '\0';
     status = 0;
   }
 
@@ -1438,6 +1765,91 @@ ncm_sphere_map_pix_load_fits (NcmSphereMapPix *pix, const gchar *fits_file, cons
   }
 
   ncm_sphere_map_pix_set_coordsys (pix, *coordsys);
+
+  {
+    const gint64 npix       = ncm_sphere_map_pix_get_npix (pix);
+    const gboolean full_sky = ncm_sphere_map_pix_partial_is_full_sky (pix);
+    const glong chunk       = GSL_MAX (1, GSL_MIN (naxis2, NCM_SPHERE_MAP_PIX_FITS_CHUNK));
+    gdouble *signal         = g_new (gdouble, chunk);
+
+    if (explicit_index || !full_sky)
+      ncm_sphere_map_pix_clear_pixels (pix);
+
+    if (explicit_index)
+    {
+      gint64 *pixel = g_new (gint64, chunk);
+      gint pixel_i  = 0;
+      glong row;
+
+      if (fits_get_colnum (fptr, CASEINSEN, (gchar *)NCM_SPHERE_MAP_PIX_DEFAULT_PIXEL, &pixel_i, &status))
+        g_error ("ncm_sphere_map_pix_load_fits: pixel column named `%s' not found in `%s'.",
+                 NCM_SPHERE_MAP_PIX_DEFAULT_PIXEL, fits_file);
+
+      for (row = 0; row < naxis2; row += chunk)
+      {
+        const glong n = GSL_MIN (chunk, naxis2 - row);
+        glong i;
+
+        fits_read_col_lnglong (fptr, pixel_i, 1 + row, 1, n, -1, (LONGLONG *)pixel, &anynul, &status);
+        NCM_FITS_ERROR (status);
+
+        fits_read_col_dbl (fptr, signal_i, 1 + row, 1, n, NCM_SPHERE_MAP_PIX_HEALPIX_NULLVAL, 
+                           signal, &anynul, &status); 
+        NCM_FITS_ERROR (status);
+
+        for (i = 0; i < n; i++)
+        {
+          if ((pixel[i] < 0) || (pixel[i] >= npix))
+            g_error ("ncm_sphere_map_pix_load_fits: invalid pixel index `%"G_GINT64_FORMAT"' in `%s'.", pixel[i], fits_file);
+
+          if (full_sky || ncm_sphere_map_pix_partial_contains (pix, pixel[i]))
+            _fft_vec_idx (pix->pvec, pixel[i]) = signal[i];
+        }
+      }
+
+      g_free (pixel);
+    }
+    else
+    {
+      /* In RING ordering the partial sky ranges are also ranges of rows. */
+      const gboolean ring_partial = !full_sky && (pix->order == NCM_SPHERE_MAP_PIX_ORDER_RING);
+      const guint nranges         = ring_partial ? pix->partial->len : 1;
+      guint r;
+
+      for (r = 0; r < nranges; r++)
+      {
+        const gint64 first = ring_partial ? g_array_index (pix->partial, NcmSphereMapPixRange, r).first : 0;
+        const gint64 last  = ring_partial ? g_array_index (pix->partial, NcmSphereMapPixRange, r).last  : npix - 1;
+        gint64 p;
+
+        for (p = first; p <= last; p += chunk)
+        {
+          const gint64 n = GSL_MIN (chunk, last - p + 1);
+          gint64 i;
+
+          fits_read_col_dbl (fptr, signal_i, 1 + p, 1, n, NCM_SPHERE_MAP_PIX_HEALPIX_NULLVAL, 
+                             signal, &anynul, &status); 
+          NCM_FITS_ERROR (status);
+
+          if (full_sky || ring_partial)
+          {
+            for (i = 0; i < n; i++)
+              _fft_vec_idx (pix->pvec, p + i) = signal[i];
+          }
+          else
+          {
+            for (i = 0; i < n; i++)
+            {
+              if (ncm_sphere_map_pix_partial_contains (pix, p + i))
+                _fft_vec_idx (pix->pvec, p + i) = signal[i];
+            }
+          }
+        }
+      }
+    }
+
+    g_free (signal);
+  }
   
   fits_close_file (fptr, &status);
   NCM_FITS_ERROR (status);
@@ -1448,21 +1860,30 @@ ncm_sphere_map_pix_load_fits (NcmSphereMapPix *pix, const gchar *fits_file, cons
  * @pix: a #NcmSphereMapPix
  * @fits_file: fits filename
  * @signal_name: (allow-none): signal column name in @fits_file
- * @overwrite: FIXME
+ * @overwrite: whether to overwrite an existing @fits_file
  *
- * FIXME 
+ * Saves @pix in the HEALPix format. If @pix has a partial sky selection only
+ * the selected pixels are saved, using explicit indexing (PIXEL and signal
+ * columns). The rows are written in chunks of at most
+ * #NCM_SPHERE_MAP_PIX_FITS_CHUNK.
  * 
  */
 void
 ncm_sphere_map_pix_save_fits (NcmSphereMapPix *pix, const gchar *fits_file, const gchar *signal_name, gboolean overwrite)
 {    
-  const gchar *sname = signal_name != NULL ?  signal_name : NCM_SPHERE_MAP_PIX_DEFAULT_SIGNAL;
-  const gchar *ttype[] = { sname };
-  const gchar *tform[] = { "1E" };
-  const gint64 npix    = ncm_sphere_map_pix_get_npix (pix);
-  const gchar extname[] = "BINTABLE";  
+  const gchar *sname           = signal_name != NULL ?  signal_name : NCM_SPHERE_MAP_PIX_DEFAULT_SIGNAL;
+  const gboolean full_sky      = ncm_sphere_map_pix_partial_is_full_sky (pix);
+  const gchar *ttype_full[]    = { sname };
+  const gchar *tform_full[]    = { "1E" };
+  const gchar *ttype_partial[] = { NCM_SPHERE_MAP_PIX_DEFAULT_PIXEL, sname };
+  const gchar *tform_partial[] = { "1K", "1E" };
+  const gint64 npix            = ncm_sphere_map_pix_get_npix (pix);
+  const gint64 nrows           = ncm_sphere_map_pix_partial_get_npix (pix);
+  const gchar extname[]        = "BINTABLE";  
   fitsfile *fptr;
   gint status = 0;
+
+  g_assert_cmpint (npix, >, 0);
  
   if (overwrite && g_file_test (fits_file, G_FILE_TEST_EXISTS))
     g_unlink (fits_file);
@@ -1470,7 +1891,10 @@ ncm_sphere_map_pix_save_fits (NcmSphereMapPix *pix, const gchar *fits_file, cons
   fits_create_file (&fptr, fits_file, &status);
   NCM_FITS_ERROR (status);
 
-  fits_create_tbl (fptr, BINARY_TBL, npix, 1, (gchar **)ttype, (gchar **)tform, NULL, extname, &status);
+  if (full_sky)
+    fits_create_tbl (fptr, BINARY_TBL, nrows, 1, (gchar **)ttype_full, (gchar **)tform_full, NULL, extname, &status);
+  else
+    fits_create_tbl (fptr, BINARY_TBL, nrows, 2, (gchar **)ttype_partial, (gchar **)tform_partial, NULL, extname, &status);
   NCM_FITS_ERROR (status);
 
   {
@@ -1480,30 +1904,42 @@ ncm_sphere_map_pix_save_fits (NcmSphereMapPix *pix, const gchar *fits_file, cons
     NCM_FITS_ERROR (status);
   }
 
+  if (full_sky)
   {
     glong firstpix = 0;
+    glong lastpix  = npix - 1;
+    
     fits_write_key (fptr, TLONG, "FIRSTPIX", &firstpix,
                     "First pixel # (0 based)", &status);
     NCM_FITS_ERROR (status);
-  }
 
-  {
-    glong lastpix = npix - 1;
     fits_write_key (fptr, TLONG, "LASTPIX", &lastpix,
                     "Last pixel # (0 based)", &status);
     NCM_FITS_ERROR (status);
-  }
 
-  {
     fits_write_key (fptr, TSTRING, "INDXSCHM", (gchar *) "IMPLICIT",
                     "Indexing: IMPLICIT or EXPLICIT", &status);
     NCM_FITS_ERROR (status);
+
+    fits_write_key (fptr, TSTRING, "OBJECT", (gchar *) "FULLSKY",
+                    "Sky coverage, either FULLSKY or PARTIAL", &status);
+    NCM_FITS_ERROR (status);
   }
-  
+  else
   {
-    fits_write_key (fptr, TSTRING, "INDXSCHM", (gchar *) "IMPLICIT",
+    glong obs_npix = nrows;
+
+    fits_write_key (fptr, TSTRING, "INDXSCHM", (gchar *) "EXPLICIT",
                     "Indexing: IMPLICIT or EXPLICIT", &status);
     NCM_FITS_ERROR (status);
+
+    fits_write_key (fptr, TSTRING, "OBJECT", (gchar *) "PARTIAL",
+                    "Sky coverage, either FULLSKY or PARTIAL", &status);
+    NCM_FITS_ERROR (status);
+
+    fits_write_key (fptr, TLONG, "OBS_NPIX", &obs_npix,
+                    "Number of pixels observed and recorded", &status);
+    NCM_FITS_ERROR (status);
   }
 
   {
@@ -1528,24 +1964,66 @@ ncm_sphere_map_pix_save_fits (NcmSphereMapPix *pix, const gchar *fits_file, cons
     g_free (coordsys);
   }
 
-#ifdef HAVE_FFTW3F
-  fits_write_col (fptr, TFLOAT, 1, 1, 1, npix, _fft_vec_ptr (pix->pvec, 0), &status);
-  NCM_FITS_ERROR (status);
-#elif defined (HAVE_FFTW3)
   {
-    gint64 i;
-    for (i = 0; i < npix; i++)
+    const gint64 chunk = GSL_MIN (nrows, NCM_SPHERE_MAP_PIX_FITS_CHUNK);
+    gfloat *signal     = g_new (gfloat, chunk);
+
+    if (full_sky)
     {
-      gfloat v_i = _fft_vec_idx (pix->pvec, i);
-      fits_write_col (fptr, TFLOAT, 1, 1 + i, 1, 1, &v_i, &status);
-      NCM_FITS_ERROR (status);
+      gint64 p;
+      
+      for (p = 0; p < npix; p += chunk)
+      {
+        const gint64 n = GSL_MIN (chunk, npix - p);
+        gint64 i;
+
+        for (i = 0; i < n; i++)
+          signal[i] = _fft_vec_idx (pix->pvec, p + i);
+
+        fits_write_col (fptr, TFLOAT, 1, 1 + p, 1, n, signal, &status);
+        NCM_FITS_ERROR (status);
+      }
     }
-  }
-#else
-  fits_write_col (fptr, TFLOAT, 1, 1, 1, npix, _fft_vec_ptr (pix->pvec, 0), &status);
-  NCM_FITS_ERROR (status);
-#endif
+    else
+    {
+      gint64 *pixel = g_new (gint64, chunk);
+      gint64 row    = 0;
+      gint64 n      = 0;
+      guint r;
+
+      for (r = 0; r < pix->partial->len; r++)
+      {
+        const NcmSphereMapPixRange *r_i = &g_array_index (pix->partial, NcmSphereMapPixRange, r);
+        gint64 ring_index;
+
+        for (ring_index = r_i->first; ring_index <= r_i->last; ring_index++)
+        {
+          const gint64 p = (pix->order == NCM_SPHERE_MAP_PIX_ORDER_NEST) ? ncm_sphere_map_pix_ring2nest (pix, ring_index) : ring_index;
+
+          pixel[n]  = p;
+          signal[n] = _fft_vec_idx (pix->pvec, p);
+          n++;
+
+          if ((n == chunk) || ((r + 1 == pix->partial->len) && (ring_index == r_i->last)))
+          {
+            fits_write_col (fptr, TLONGLONG, 1, 1 + row, 1, n, pixel, &status);
+            NCM_FITS_ERROR (status);
 
+            fits_write_col (fptr, TFLOAT, 2, 1 + row, 1, n, signal, &status);
+            NCM_FITS_ERROR (status);
+
+            row += n;
+            n    = 0;
+          }
+        }
+      }
+
+      g_assert_cmpint (row, ==, nrows);
+      g_free (pixel);
+    }
+
+    g_free (signal);
+  }
 
   fits_close_file (fptr, &status);
   NCM_FITS_ERROR (status);
@@ -1566,7 +2044,12 @@ _ncm_sphere_map_pix_radec_to_ang (const gdouble RA, const gdouble DEC, gdouble *
  * @DEC: DEC column name in @fits_file
  * @S: (allow-none): Signal column name in @fits_file
  *
- * FIXME 
+ * Bins the objects of the catalog @fits_file into @pix, adding the signal
+ * @S (or one if @S is NULL) of each object to the pixel containing its
+ * position. The catalog is streamed in chunks of at most
+ * #NCM_SPHERE_MAP_PIX_FITS_CHUNK rows which are binned using
+ * ncm_sphere_map_pix_add_to_ang_array(), hence objects outside the partial
+ * sky selection of @pix are discarded.
  * 
  */
 void 
@@ -1579,7 +2062,6 @@ ncm_sphere_map_pix_load_from_fits_catalog (NcmSphereMapPix *pix, const gchar *fi
   gint DEC_col = 0;
   gint S_col   = 0;
   fitsfile *fptr;
-  gint64 i;
 
   status = 0;
 
@@ -1610,49 +2092,47 @@ ncm_sphere_map_pix_load_from_fits_catalog (NcmSphereMapPix *pix, const gchar *fi
   fits_read_key_lng (fptr, "NAXIS2", &naxis2, comment, &status); 
   NCM_FITS_ERROR(status);
 
-  if (S != NULL)
   {
-    for (i = 0; i < naxis2; i++)
+    const glong chunk = GSL_MAX (1, GSL_MIN (naxis2, NCM_SPHERE_MAP_PIX_FITS_CHUNK));
+    gdouble *RA_c     = g_new (gdouble, 4 * chunk);
+    gdouble *DEC_c    = &RA_c[chunk];
+    gdouble *theta    = &RA_c[2 * chunk];
+    gdouble *phi      = &RA_c[3 * chunk];
+    gdouble *S_c      = (S != NULL) ? g_new (gdouble, chunk) : NULL;
+    glong row;
+
+    for (row = 0; row < naxis2; row += chunk)
     {
-      gdouble RA_i, DEC_i, theta, phi;
-      gdouble S_i;
+      const glong n = GSL_MIN (chunk, naxis2 - row);
+      glong i;
 
-      fits_read_col_dbl (fptr, RA_col, 1 + i, 1, 1, NCM_SPHERE_MAP_PIX_HEALPIX_NULLVAL, 
-                         &RA_i, &anynul, &status); 
+      fits_read_col_dbl (fptr, RA_col, 1 + row, 1, n, NCM_SPHERE_MAP_PIX_HEALPIX_NULLVAL, 
+                         RA_c, &anynul, &status); 
       NCM_FITS_ERROR (status);
 
-      fits_read_col_dbl (fptr, DEC_col, 1 + i, 1, 1, NCM_SPHERE_MAP_PIX_HEALPIX_NULLVAL, 
-                         &DEC_i, &anynul, &status); 
+      fits_read_col_dbl (fptr, DEC_col, 1 + row, 1, n, NCM_SPHERE_MAP_PIX_HEALPIX_NULLVAL, 
+                         DEC_c, &anynul, &status); 
       NCM_FITS_ERROR (status);
 
-      fits_read_col_dbl (fptr, S_col, 1 + i, 1, 1, NCM_SPHERE_MAP_PIX_HEALPIX_NULLVAL, 
-                         &S_i, &anynul, &status); 
-      NCM_FITS_ERROR (status);
+      if (S != NULL)
+      {
+        fits_read_col_dbl (fptr, S_col, 1 + row, 1, n, NCM_SPHERE_MAP_PIX_HEALPIX_NULLVAL, 
+                           S_c, &anynul, &status); 
+        NCM_FITS_ERROR (status);
+      }
 
-      _ncm_sphere_map_pix_radec_to_ang (RA_i, DEC_i, &theta, &phi);
+      for (i = 0; i < n; i++)
+        _ncm_sphere_map_pix_radec_to_ang (RA_c[i], DEC_c[i], &theta[i], &phi[i]);
 
-      ncm_sphere_map_pix_add_to_ang (pix, theta, phi, S_i);
+      ncm_sphere_map_pix_add_to_ang_array (pix, theta, phi, S_c, n);
     }
-  }
-  else
-  {
-    for (i = 0; i < naxis2; i++)
-    {
-      gdouble RA_i, DEC_i, theta, phi;
-
-      fits_read_col_dbl (fptr, RA_col, 1 + i, 1, 1, NCM_SPHERE_MAP_PIX_HEALPIX_NULLVAL, 
-                         &RA_i, &anynul, &status); 
-      NCM_FITS_ERROR (status);
 
-      fits_read_col_dbl (fptr, DEC_col, 1 + i, 1, 1, NCM_SPHERE_MAP_PIX_HEALPIX_NULLVAL, 
-                         &DEC_i, &anynul, &status); 
-      NCM_FITS_ERROR (status);
-
-      _ncm_sphere_map_pix_radec_to_ang (RA_i, DEC_i, &theta, &phi);
-
-      ncm_sphere_map_pix_add_to_ang (pix, theta, phi, 1.0);
-    }
+    g_free (RA_c);
+    g_free (S_c);
   }
+
+  fits_close_file (fptr, &status);
+  NCM_FITS_ERROR (status);
 }
 
 static void
@@ -1661,18 +2141,23 @@ _ncm_sphere_map_pix_prepare_fft (NcmSphereMapPix *pix)
 #ifdef NUMCOSMO_HAVE_FFTW3
   if (pix->fft_plan_r2c->len == 0)
   {
-    const gint64 npix      = ncm_sphere_map_pix_get_npix (pix);
-    const gint64 nring_cap = ncm_sphere_map_pix_get_nrings_cap (pix);
-    gpointer temp_pix      = _fft_vec_alloc (pix->npix);
+    const gint64 npix          = ncm_sphere_map_pix_get_npix (pix);
+    const gint64 nring_cap     = ncm_sphere_map_pix_get_nrings_cap (pix);
+    const gint ring_size       = pix->middle_rings_size;
+    const gint nrings_middle   = ncm_sphere_map_pix_get_nrings_middle (pix);
+    const gint64 cap_size      = ncm_sphere_map_pix_get_cap_size (pix);
+    gpointer temp_pix          = _fft_vec_alloc (pix->npix);
     gint r_i;
 
     ncm_cfg_load_fftw_wisdom ("ncm_sphere_map_pix_nside_%ld", ncm_sphere_map_pix_get_nside (pix));
+
+    /* Planning may overwrite the input arrays. */
+    _fft_vec_memcpy (temp_pix, pix->pvec, pix->npix);
+
 #  ifdef HAVE_FFTW3F
 
     pix->fft_pvec = fftwf_alloc_complex (npix);
 
-    _fft_vec_memcpy (temp_pix, pix->pvec, pix->npix);
-
     for (r_i = 0; r_i < nring_cap; r_i++)
     {
       const gint ring_size       = ncm_sphere_map_pix_get_ring_size (pix, r_i);
@@ -1696,36 +2181,32 @@ _ncm_sphere_map_pix_prepare_fft (NcmSphereMapPix *pix)
                                                      1, dist,
                                                      fftw_default_flags | FFTW_DESTROY_INPUT);
       
-      printf ("Preparing plan for %ld and %ld size %d | npix %ld | %p\n", ring_fi_north, ring_fi_south, ring_size, pix->npix, plan_r2c);
       g_ptr_array_add (pix->fft_plan_r2c, plan_r2c);
       g_ptr_array_add (pix->fft_plan_c2r, plan_c2r);
     }
+    for (r_i = 0; r_i < nrings_middle; r_i += NCM_SPHERE_MAP_PIX_FFT_MIDDLE_BATCH)
     {
-      const gint ring_size     = pix->middle_rings_size;
-      const gint nrings_middle = ncm_sphere_map_pix_get_nrings_middle (pix);
-      const gint cap_size      = ncm_sphere_map_pix_get_cap_size (pix);
-
-      gfloat *pvec               = pix->pvec;
-      complex float *fft_pvec    = pix->fft_pvec;
+      const gint nrings_batch  = GSL_MIN (NCM_SPHERE_MAP_PIX_FFT_MIDDLE_BATCH, nrings_middle - r_i);
+      const gint64 batch_fi    = cap_size + r_i * ring_size;
+      gfloat *pvec             = pix->pvec;
+      complex float *fft_pvec  = pix->fft_pvec;
 
-      fftwf_plan plan_r2c = fftwf_plan_many_dft_r2c (1, &ring_size, nrings_middle,
-                                                     &pvec[cap_size], NULL, 
+      fftwf_plan plan_r2c = fftwf_plan_many_dft_r2c (1, &ring_size, nrings_batch,
+                                                     &pvec[batch_fi], NULL, 
                                                      1, ring_size,
-                                                     &fft_pvec[cap_size], NULL,
+                                                     &fft_pvec[batch_fi], NULL,
                                                      1, ring_size,
                                                      fftw_default_flags | FFTW_DESTROY_INPUT);
 
-      fftwf_plan plan_c2r = fftwf_plan_many_dft_c2r (1, &ring_size, nrings_middle,
-                                                     &fft_pvec[cap_size], NULL,
+      fftwf_plan plan_c2r = fftwf_plan_many_dft_c2r (1, &ring_size, nrings_batch,
+                                                     &fft_pvec[batch_fi], NULL,
                                                      1, ring_size,
-                                                     &pvec[cap_size], NULL,
+                                                     &pvec[batch_fi], NULL,
                                                      1, ring_size,
                                                      fftw_default_flags | FFTW_DESTROY_INPUT);
-      printf ("Preparing plan for %d and %d x %d | npix %ld | %p\n", cap_size, nrings_middle, ring_size, pix->npix, plan_r2c);
       g_ptr_array_add (pix->fft_plan_r2c, plan_r2c);
       g_ptr_array_add (pix->fft_plan_c2r, plan_c2r);
     }  
-    fflush (stdout);
     
 #  else
 
@@ -1756,24 +2237,23 @@ _ncm_sphere_map_pix_prepare_fft (NcmSphereMapPix *pix)
       g_ptr_array_add (pix->fft_plan_r2c, plan_r2c);
       g_ptr_array_add (pix->fft_plan_c2r, plan_c2r);
     }
+    for (r_i = 0; r_i < nrings_middle; r_i += NCM_SPHERE_MAP_PIX_FFT_MIDDLE_BATCH)
     {
-      const gint ring_size     = pix->middle_rings_size;
-      const gint nrings_middle = ncm_sphere_map_pix_get_nrings_middle (pix);
-      const gint cap_size      = ncm_sphere_map_pix_get_cap_size (pix);
+      const gint nrings_batch  = GSL_MIN (NCM_SPHERE_MAP_PIX_FFT_MIDDLE_BATCH, nrings_middle - r_i);
+      const gint64 batch_fi    = cap_size + r_i * ring_size;
+      gdouble *pvec            = pix->pvec;
+      complex double *fft_pvec = pix->fft_pvec;
 
-      gdouble *pvec               = pix->pvec;
-      complex double *fft_pvec    = pix->fft_pvec;
-
-      fftw_plan plan_r2c = fftw_plan_many_dft_r2c (1, &ring_size, nrings_middle,
-                                                   &pvec[cap_size], NULL, 
+      fftw_plan plan_r2c = fftw_plan_many_dft_r2c (1, &ring_size, nrings_batch,
+                                                   &pvec[batch_fi], NULL, 
                                                    1, ring_size,
-                                                   &fft_pvec[cap_size], NULL,
+                                                   &fft_pvec[batch_fi], NULL,
                                                    1, ring_size,
                                                    fftw_default_flags | FFTW_DESTROY_INPUT);
-      fftw_plan plan_c2r = fftw_plan_many_dft_c2r (1, &ring_size, nrings_middle,
-                                                   &fft_pvec[cap_size], NULL,
+      fftw_plan plan_c2r = fftw_plan_many_dft_c2r (1, &ring_size, nrings_batch,
+                                                   &fft_pvec[batch_fi], NULL,
                                                    1, ring_size,
-                                                   &pvec[cap_size], NULL,
+                                                   &pvec[batch_fi], NULL,
                                                    1, ring_size,
                                                    fftw_default_flags | FFTW_DESTROY_INPUT);
 
@@ -1790,82 +2270,344 @@ _ncm_sphere_map_pix_prepare_fft (NcmSphereMapPix *pix)
 #endif
 }
 
-#ifdef NUMCOSMO_HAVE_FFTW3
-static void
-_ncm_sphere_map_pix_get_alm_from_circle (NcmSphereMapPix *pix, gint64 r_i, gboolean Cl_only)
-{
-  const gint64 ring_size   = ncm_sphere_map_pix_get_ring_size (pix, r_i);
-  const gint64 ring_size_2 = ring_size / 2;
-  const gint64 ring_fi     = ncm_sphere_map_pix_get_ring_first_index (pix, r_i);
-  const _fft_complex *Fim  = &((_fft_complex *)pix->fft_pvec)[ring_fi];
-  const gdouble pix_area   = 4.0 * M_PI / pix->npix;
-  gdouble theta_i = 0.0, phi_0 = 0.0, x = 0.0;
-  gint64 m;
+/*
+ * Legendre tables
+ *
+ * The normalized associated Legendre functions $Y_{\ell{}m}(\theta)$ are 
+ * computed on the fly for each ring using the usual three terms recursion in
+ * $\ell$ at fixed $m$, 
+ * $$Y_{\ell{}m} = \alpha_{\ell{}m}\left(x Y_{\ell-1,m} - \beta_{\ell{}m}Y_{\ell-2,m}\right),$$
+ * starting from $Y_{mm}$. The recursion coefficients, the logarithm of the
+ * $Y_{mm}$ normalization and the ring geometry depend only on (nside, lmax),
+ * they are kept in a #NcmSphereMapPixYlmTab which is shared by all maps with
+ * the same nside and lmax. The values are computed with a floating exponent 
+ * to avoid underflows of $Y_{mm}$ near the poles. The northern and southern 
+ * rings are processed together since $Y_{\ell{}m}(-x) = (-1)^{\ell+m}Y_{\ell{}m}(x)$.
+ * 
+ */
 
-  ncm_sphere_map_pix_pix2ang_ring (pix, ring_fi, &theta_i, &phi_0);
+struct _NcmSphereMapPixYlmTab
+{
+  gint ref_count;
+  gchar *key;
+  gint64 nrings_north;
+  gint64 *ring_fi_n;
+  gint64 *ring_fi_s;
+  gint64 *ring_size;
+  gdouble *phi_0_n;
+  gdouble *phi_0_s;
+  gdouble *x;
+  gdouble *lnsin;
+  gdouble *lnYmm;
+  gdouble *alpha;
+  gdouble *beta;
+};
 
-  x = cos (theta_i);
+#define _NCM_SPHERE_MAP_PIX_YLM_BIG     (1.0e150)
+#define _NCM_SPHERE_MAP_PIX_YLM_LN_BIG  (345.38776394910684) /* ln (1.0e150) */
+#define _NCM_SPHERE_MAP_PIX_YLM_LN_TINY (-414.46531673892821) /* ln (1.0e-180), values below 1.0e-180 x 1.0e150 are dropped. */
 
-printf ("Legendre?!S % 21.15g\n", ncm_timer_elapsed (pix->t));fflush (stdout);
-  gsl_sf_legendre_array_e (GSL_SF_LEGENDRE_SPHARM, pix->lmax, x, -1.0, ncm_vector_data (pix->Ylm));
-printf ("Legendre?!F % 21.15g\n", ncm_timer_elapsed (pix->t));fflush (stdout);
+G_LOCK_DEFINE_STATIC (ylm_tab_cache);
+static GHashTable *_ylm_tab_cache = NULL;
 
-  if (Cl_only)
+static NcmSphereMapPixYlmTab *
+_ncm_sphere_map_pix_ylm_tab_new (NcmSphereMapPix *pix)
+{
+  NcmSphereMapPixYlmTab *ylm_tab = g_new0 (NcmSphereMapPixYlmTab, 1);
+  const gint64 nrings            = ncm_sphere_map_pix_get_nrings (pix);
+  const gint64 lmax              = pix->lmax;
+  const gsize alm_size           = NCM_SPHERE_MAP_PIX_ALM_SIZE (lmax);
+  gdouble lnfact                 = 0.0;
+  gint64 r_i, m;
+
+  ylm_tab->ref_count    = 1;
+  ylm_tab->nrings_north = (nrings + 1) / 2;
+
+  ylm_tab->ring_fi_n = g_new (gint64, ylm_tab->nrings_north);
+  ylm_tab->ring_fi_s = g_new (gint64, ylm_tab->nrings_north);
+  ylm_tab->ring_size = g_new (gint64, ylm_tab->nrings_north);
+  ylm_tab->phi_0_n   = g_new (gdouble, ylm_tab->nrings_north);
+  ylm_tab->phi_0_s   = g_new (gdouble, ylm_tab->nrings_north);
+  ylm_tab->x         = g_new (gdouble, ylm_tab->nrings_north);
+  ylm_tab->lnsin     = g_new (gdouble, ylm_tab->nrings_north);
+  ylm_tab->lnYmm     = g_new (gdouble, lmax + 1);
+  ylm_tab->alpha     = g_new (gdouble, alm_size);
+  ylm_tab->beta      = g_new (gdouble, alm_size);
+
+  for (r_i = 0; r_i < ylm_tab->nrings_north; r_i++)
+  {
+    gdouble theta_n = 0.0, theta_s = 0.0;
+    
+    ylm_tab->ring_fi_n[r_i] = ncm_sphere_map_pix_get_ring_first_index (pix, r_i);
+    ylm_tab->ring_fi_s[r_i] = ncm_sphere_map_pix_get_ring_first_index (pix, nrings - r_i - 1);
+    ylm_tab->ring_size[r_i] = ncm_sphere_map_pix_get_ring_size (pix, r_i);
+
+    ncm_sphere_map_pix_pix2ang_ring (pix, ylm_tab->ring_fi_n[r_i], &theta_n, &ylm_tab->phi_0_n[r_i]);
+    ncm_sphere_map_pix_pix2ang_ring (pix, ylm_tab->ring_fi_s[r_i], &theta_s, &ylm_tab->phi_0_s[r_i]);
+
+    ylm_tab->x[r_i]     = cos (theta_n);
+    ylm_tab->lnsin[r_i] = log (sin (theta_n));
+  }
+
+  for (m = 0; m <= lmax; m++)
   {
-    for (m = 0; m <= pix->lmax; m++)
-    {
-      gint64 l;
-      gint fft_ring_index = m % ring_size;
+    const gsize m_start = NCM_SPHERE_MAP_PIX_M_START (lmax, m);
+    gint64 l;
 
-      _fft_complex phase = cexp (-I * phi_0 * m);
+    if (m > 0)
+      lnfact += log ((2.0 * m - 1.0) / (2.0 * m));
 
-      if (fft_ring_index <= ring_size_2)
-        phase *= Fim[fft_ring_index];
-      else
-        phase *= conj (Fim[ring_size - fft_ring_index]);
+    ylm_tab->lnYmm[m] = 0.5 * (log ((2.0 * m + 1.0) / (4.0 * M_PI)) + lnfact);
 
-      for (l = m; l <= pix->lmax; l++)
-      {
-        gsize lm_index = gsl_sf_legendre_array_index (l, m);
-        const complex double alm = ncm_vector_fast_get (pix->Ylm, lm_index) * phase * pix_area;        
-        ncm_vector_fast_addto (pix->Cl, l, creal (alm * conj (alm)));
-      }
+    ylm_tab->alpha[m_start] = 0.0;
+    ylm_tab->beta[m_start]  = 0.0;
+    
+    for (l = m + 1; l <= lmax; l++)
+    {
+      const gdouble l2   = l * 1.0 * l;
+      const gdouble lm12 = (l - 1.0) * (l - 1.0);
+      const gdouble m2   = m * 1.0 * m;
+
+      ylm_tab->alpha[m_start + l - m] = sqrt ((4.0 * l2 - 1.0) / (l2 - m2));
+      ylm_tab->beta[m_start + l - m]  = sqrt ((lm12 - m2) / (4.0 * lm12 - 1.0));
     }
   }
-  else
+
+  return ylm_tab;
+}
+
+static void
+_ncm_sphere_map_pix_ylm_tab_free (NcmSphereMapPixYlmTab *ylm_tab)
+{
+  g_free (ylm_tab->key);
+  g_free (ylm_tab->ring_fi_n);
+  g_free (ylm_tab->ring_fi_s);
+  g_free (ylm_tab->ring_size);
+  g_free (ylm_tab->phi_0_n);
+  g_free (ylm_tab->phi_0_s);
+  g_free (ylm_tab->x);
+  g_free (ylm_tab->lnsin);
+  g_free (ylm_tab->lnYmm);
+  g_free (ylm_tab->alpha);
+  g_free (ylm_tab->beta);
+  g_free (ylm_tab);
+}
+
+static void
+_ncm_sphere_map_pix_ylm_tab_clear (NcmSphereMapPixYlmTab **ylm_tab)
+{
+  if (*ylm_tab != NULL)
   {
-printf ("Loop?!S % 21.15g\n", ncm_timer_elapsed (pix->t));fflush (stdout);
-    _fft_complex emIphi_0 = cexp (-I * phi_0);
-    _fft_complex phase    = 1.0;
+    G_LOCK (ylm_tab_cache);
+    (*ylm_tab)->ref_count--;
+    if ((*ylm_tab)->ref_count == 0)
+    {
+      g_hash_table_remove (_ylm_tab_cache, (*ylm_tab)->key);
+      _ncm_sphere_map_pix_ylm_tab_free (*ylm_tab);
+    }
+    G_UNLOCK (ylm_tab_cache);
     
-    for (m = 0; m <= pix->lmax; m++)
+    *ylm_tab = NULL;
+  }
+}
+
+static void
+_ncm_sphere_map_pix_prepare_ylm_tab (NcmSphereMapPix *pix)
+{
+  if (pix->ylm_tab == NULL)
+  {
+    gchar *key = g_strdup_printf ("%ld:%u", pix->nside, pix->lmax);
+
+    G_LOCK (ylm_tab_cache);
+    if (_ylm_tab_cache == NULL)
+      _ylm_tab_cache = g_hash_table_new (g_str_hash, g_str_equal);
+
+    pix->ylm_tab = g_hash_table_lookup (_ylm_tab_cache, key);
+    if (pix->ylm_tab != NULL)
     {
-      gint64 l;
-      gint fft_ring_index = m % ring_size;
-      _fft_complex Fim_i;
+      pix->ylm_tab->ref_count++;
+      g_free (key);
+    }
+    else
+    {
+      pix->ylm_tab      = _ncm_sphere_map_pix_ylm_tab_new (pix);
+      pix->ylm_tab->key = key;
+      g_hash_table_insert (_ylm_tab_cache, key, pix->ylm_tab);
+    }
+    G_UNLOCK (ylm_tab_cache);
+  }
+}
 
-      if (fft_ring_index <= ring_size_2)
-        Fim_i = Fim[fft_ring_index];
-      else
-        Fim_i = conj (Fim[ring_size - fft_ring_index]);
+#define _NCM_SPHERE_MAP_PIX_YLM_RESCALE(y_lm1,y_lm2,lnscale,scale) \
+G_STMT_START { \
+  if (fabs (y_lm1) > _NCM_SPHERE_MAP_PIX_YLM_BIG) \
+  { \
+    y_lm1   /= _NCM_SPHERE_MAP_PIX_YLM_BIG; \
+    y_lm2   /= _NCM_SPHERE_MAP_PIX_YLM_BIG; \
+    lnscale += _NCM_SPHERE_MAP_PIX_YLM_LN_BIG; \
+    scale    = (lnscale > _NCM_SPHERE_MAP_PIX_YLM_LN_TINY) ? exp (lnscale) : 0.0; \
+  } \
+} G_STMT_END
+
+#ifdef NUMCOSMO_HAVE_FFTW3
+typedef struct _NcmSphereMapPixSHTArg
+{
+  NcmSphereMapPix *pix;
+  gboolean Cl_only;
+} NcmSphereMapPixSHTArg;
+
+static void
+_ncm_sphere_map_pix_fft_r2c_mt (glong i, glong f, gpointer data)
+{
+  NcmSphereMapPix *pix = NCM_SPHERE_MAP_PIX (data);
+  glong p;
 
-      for (l = m; l <= pix->lmax; l++)
+  for (p = i; p < f; p++)
+  {
+#  ifdef HAVE_FFTW3F
+    fftwf_execute (g_ptr_array_index (pix->fft_plan_r2c, p));
+#  else
+    fftw_execute (g_ptr_array_index (pix->fft_plan_r2c, p));
+#  endif
+  }
+}
+
+static void
+_ncm_sphere_map_pix_fft_c2r_mt (glong i, glong f, gpointer data)
+{
+  NcmSphereMapPix *pix = NCM_SPHERE_MAP_PIX (data);
+  glong p;
+
+  for (p = i; p < f; p++)
+  {
+#  ifdef HAVE_FFTW3F
+    fftwf_execute (g_ptr_array_index (pix->fft_plan_c2r, p));
+#  else
+    fftw_execute (g_ptr_array_index (pix->fft_plan_c2r, p));
+#  endif
+  }
+}
+
+static complex double
+_ncm_sphere_map_pix_get_ring_Fm (NcmSphereMapPix *pix, const gint64 ring_fi, const gint64 ring_size, const gint64 m)
+{
+  const _fft_complex *Fim = &((_fft_complex *)pix->fft_pvec)[ring_fi];
+  const gint64 k          = m % ring_size;
+
+  if (2 * k <= ring_size)
+    return Fim[k];
+  else
+    return conj (Fim[ring_size - k]);
+}
+
+static void
+_ncm_sphere_map_pix_get_alm_m (NcmSphereMapPix *pix, const gint64 m, gboolean Cl_only, complex double *alm_m, gdouble *Cl_m)
+{
+  NcmSphereMapPixYlmTab *ylm_tab = pix->ylm_tab;
+  const gint64 lmax              = pix->lmax;
+  const gsize m_start            = NCM_SPHERE_MAP_PIX_M_START (lmax, m);
+  const gdouble *alpha           = &ylm_tab->alpha[m_start];
+  const gdouble *beta            = &ylm_tab->beta[m_start];
+  const gdouble pix_area         = 4.0 * M_PI / pix->npix;
+  gint64 r_i, l;
+
+  memset (alm_m, 0, sizeof (complex double) * (lmax - m + 1));
+  memset (Cl_m, 0, sizeof (gdouble) * (lmax - m + 1));
+
+  for (r_i = 0; r_i < ylm_tab->nrings_north; r_i++)
+  {
+    const gint64 ring_size   = ylm_tab->ring_size[r_i];
+    const gboolean has_south = (ylm_tab->ring_fi_s[r_i] != ylm_tab->ring_fi_n[r_i]);
+    const gdouble x          = ylm_tab->x[r_i];
+    const complex double F_n = _ncm_sphere_map_pix_get_ring_Fm (pix, ylm_tab->ring_fi_n[r_i], ring_size, m) * cexp (-I * ylm_tab->phi_0_n[r_i] * m) * pix_area;
+    const complex double F_s = has_south ? _ncm_sphere_map_pix_get_ring_Fm (pix, ylm_tab->ring_fi_s[r_i], ring_size, m) * cexp (-I * ylm_tab->phi_0_s[r_i] * m) * pix_area : 0.0;
+    const complex double E   = F_n + F_s;
+    const complex double O   = F_n - F_s;
+    const gdouble F2         = creal (F_n * conj (F_n)) + creal (F_s * conj (F_s));
+    gdouble lnscale          = ylm_tab->lnYmm[m] + m * ylm_tab->lnsin[r_i];
+    gdouble scale            = (lnscale > _NCM_SPHERE_MAP_PIX_YLM_LN_TINY) ? exp (lnscale) : 0.0;
+    gdouble y_lm1            = (m % 2 == 0) ? 1.0 : -1.0;
+    gdouble y_lm2            = 0.0;
+
+    for (l = m; l <= lmax; l++)
+    {
+      if (l > m)
       {
-        gsize lm_index = gsl_sf_legendre_array_index (l, m);
+        const gdouble y_l = alpha[l - m] * (x * y_lm1 - beta[l - m] * y_lm2);
 
-        /*printf ("%ld %ld %ld\n", l, m, lm_index);*/
-        
-        const complex double alm = ncm_vector_fast_get (pix->Ylm, lm_index) * Fim_i * phase * pix_area;
+        y_lm2 = y_lm1;
+        y_lm1 = y_l;
+        _NCM_SPHERE_MAP_PIX_YLM_RESCALE (y_lm1, y_lm2, lnscale, scale);
+      }
 
-        ncm_vector_fast_addto (pix->alm, 2 * lm_index + 0, creal (alm));
-        ncm_vector_fast_addto (pix->alm, 2 * lm_index + 1, cimag (alm));
+      if (scale != 0.0)
+      {
+        const gdouble Y_lm = y_lm1 * scale;
 
-        ncm_vector_fast_addto (pix->Cl, l, creal (alm * conj (alm)));
+        if (!Cl_only)
+          alm_m[l - m] += Y_lm * (((l - m) % 2 == 0) ? E : O);
+        Cl_m[l - m] += Y_lm * Y_lm * F2;
       }
+    }
+  }
 
-      phase *= emIphi_0;
+  for (l = m; l <= lmax; l++)
+  {
+    const gsize lm_index = gsl_sf_legendre_array_index (l, m);
+
+    if (!Cl_only)
+    {
+      ncm_vector_fast_set (pix->alm, 2 * lm_index + 0, creal (alm_m[l - m]));
+      ncm_vector_fast_set (pix->alm, 2 * lm_index + 1, cimag (alm_m[l - m]));
     }
-printf ("Loop?!F % 21.15g\n", ncm_timer_elapsed (pix->t));fflush (stdout);
+    ncm_vector_fast_set (pix->Cl_lm, lm_index, Cl_m[l - m]);
+  }
+}
+
+static void
+_ncm_sphere_map_pix_get_alm_mt (glong i, glong f, gpointer data)
+{
+  NcmSphereMapPixSHTArg *arg = (NcmSphereMapPixSHTArg *) data;
+  NcmSphereMapPix *pix       = arg->pix;
+  complex double *alm_m      = g_new (complex double, pix->lmax + 1);
+  gdouble *Cl_m              = g_new (gdouble, pix->lmax + 1);
+  glong m;
+
+  for (m = i; m < f; m++)
+    _ncm_sphere_map_pix_get_alm_m (pix, m, arg->Cl_only, alm_m, Cl_m);
+
+  g_free (alm_m);
+  g_free (Cl_m);
+}
+
+static void
+_ncm_sphere_map_pix_map2alm (NcmSphereMapPix *pix, gboolean Cl_only)
+{
+  NcmSphereMapPixSHTArg arg = {pix, Cl_only};
+  guint l;
+
+  _ncm_sphere_map_pix_prepare_fft (pix);
+  _ncm_sphere_map_pix_prepare_ylm_tab (pix);
+
+  ncm_sphere_map_pix_set_order (pix, NCM_SPHERE_MAP_PIX_ORDER_RING);
+
+  /* Ring FFTs, each plan transforms a pair of polar rings or a batch of equatorial rings. */
+  ncm_func_eval_threaded_loop_full (&_ncm_sphere_map_pix_fft_r2c_mt, 0, pix->fft_plan_r2c->len, pix);
+
+  /* Legendre transforms, each $m$ is independent and writes only to its own $a_{\ell{}m}$. */
+  ncm_func_eval_threaded_loop_full (&_ncm_sphere_map_pix_get_alm_mt, 0, pix->lmax + 1, &arg);
+
+  /* The per-$m$ contributions are summed in a fixed order, so the result does not depend on the number of threads. */
+  for (l = 0; l <= pix->lmax; l++)
+  {
+    const gsize l0_index = gsl_sf_legendre_array_index (l, 0);
+    gdouble Cl = 0.0;
+    guint m;
+
+    for (m = 0; m <= l; m++)
+      Cl += ncm_vector_fast_get (pix->Cl_lm, l0_index + m);
+
+    ncm_vector_fast_set (pix->Cl, l, Cl);
   }
 }
 #endif
@@ -1877,62 +2619,24 @@ printf ("Loop?!F % 21.15g\n", ncm_timer_elapsed (pix->t));fflush (stdout);
  * Calculates the $a_{\ell{}m}$ from the map @pix, using $\ell_\mathrm{max}$
  * set by ncm_sphere_map_pix_set_lmax(). If $\ell_\mathrm{max} = 0$
  * nothing is done.
+ *
+ * The ring FFTs and the Legendre transforms (one for each $m$) are
+ * distributed over the threads of the NumCosmo thread pool, see
+ * ncm_func_eval_set_max_threads(). The Legendre recursion tables are shared
+ * among all maps with the same nside and $\ell_\mathrm{max}$.
  * 
  */
 void
 ncm_sphere_map_pix_prepare_alm (NcmSphereMapPix *pix)
 {
 #ifdef NUMCOSMO_HAVE_FFTW3
-  gint i;
-
   if (pix->lmax == 0)
   {
     g_warning ("ncm_sphere_map_pix_prepare_alm: lmax equal to zero, returning...");
     return;
   }
 
-
-/*
-  gfloat *pixels   = pix->pvec;
-  for (i = 0; i < pix->npix; i++)
-  {
-    printf ("%u % 13.7g\n", i, pixels[i]);
-  }
-*/
-  
-  _ncm_sphere_map_pix_prepare_fft (pix);
-
-  ncm_sphere_map_pix_set_order (pix, NCM_SPHERE_MAP_PIX_ORDER_RING);
-
-  printf ("Peforming ffts!\n");
-  ncm_timer_start (pix->t);
-    
-  for (i = 0; i < pix->fft_plan_r2c->len; i++)
-  {
-#  ifdef HAVE_FFTW3F
-    fftwf_execute (g_ptr_array_index (pix->fft_plan_r2c, i));    
-#  else
-    fftw_execute (g_ptr_array_index (pix->fft_plan_r2c, i));
-#endif
-  }
-  printf ("Peforming ffts! Done!\n");
-  fflush (stdout);
-  
-  {
-    const gint64 nrings = ncm_sphere_map_pix_get_nrings (pix);
-    gint64 r_i;
-
-    ncm_vector_set_zero (pix->alm);
-    ncm_vector_set_zero (pix->Cl);
-    
-    for (r_i = 0; r_i < nrings; r_i++)
-    {
-      printf ("Calculating from ring %ld\n", r_i);fflush (stdout);
-printf ("Full?!S % 21.15g\n", ncm_timer_elapsed (pix->t));fflush (stdout);
-      _ncm_sphere_map_pix_get_alm_from_circle (pix, r_i, FALSE);
-printf ("Full?!F % 21.15g\n", ncm_timer_elapsed (pix->t));fflush (stdout);
-    }
-  }
+  _ncm_sphere_map_pix_map2alm (pix, FALSE);
 #else
   g_error ("ncm_sphere_map_pix_prepare_alm: no fftw3 support, to use this function recompile NumCosmo with fftw.");
 #endif
@@ -1951,37 +2655,13 @@ void
 ncm_sphere_map_pix_prepare_Cl (NcmSphereMapPix *pix)
 {
 #ifdef NUMCOSMO_HAVE_FFTW3
-  gint i;
-
   if (pix->lmax == 0)
   {
     g_warning ("ncm_sphere_map_pix_prepare_alm: lmax equal to zero, returning...");
     return;
   }
 
-  _ncm_sphere_map_pix_prepare_fft (pix);
-
-  ncm_sphere_map_pix_set_order (pix, NCM_SPHERE_MAP_PIX_ORDER_RING);
-  
-  for (i = 0; i < pix->fft_plan_r2c->len; i++)
-  {
-#  ifdef HAVE_FFTW3F
-    fftwf_execute (g_ptr_array_index (pix->fft_plan_r2c, i));    
-#  else
-    fftw_execute (g_ptr_array_index (pix->fft_plan_r2c, i));
-#endif
-  } 
-  {
-    const gint64 nrings = ncm_sphere_map_pix_get_nrings (pix);
-    gint64 r_i;
-
-    ncm_vector_set_zero (pix->Cl);
-    
-    for (r_i = 0; r_i < nrings; r_i++)
-    {
-      _ncm_sphere_map_pix_get_alm_from_circle (pix, r_i, TRUE);
-    }
-  }
+  _ncm_sphere_map_pix_map2alm (pix, TRUE);
 #else
   g_error ("ncm_sphere_map_pix_prepare_Cl: no fftw3 support, to use this function recompile NumCosmo with fftw.");
 #endif
@@ -2049,86 +2729,95 @@ ncm_sphere_map_pix_add_noise (NcmSphereMapPix *pix, const gdouble sd, NcmRNG *rn
 }
 
 #ifdef NUMCOSMO_HAVE_FFTW3
-static complex double
-_ncm_sphere_map_pix_get_D_m (NcmSphereMapPix *pix, const gdouble phi_0, const gint64 ring_size, const gint64 m)
+static void
+_ncm_sphere_map_pix_set_ring_Fm (NcmSphereMapPix *pix, const gint64 ring_fi, const gint64 ring_size, const gdouble phi_0, const complex double *D)
 {
-  gint64 l;
-  complex double D_m = 0.0;
-  _fft_complex phase = cexp (I * phi_0 * m);
+  _fft_complex *Fim = &((_fft_complex *)pix->fft_pvec)[ring_fi];
+  gint64 m;
 
-  for (l = m; l <= pix->lmax; l++)
+  memset (Fim, 0, sizeof (_fft_complex) * (ring_size / 2 + 1));
+
+  /* 
+   * Folds the frequencies $\pm m$ into the ring_size / 2 + 1 
+   * Fourier coefficients of a real ring.
+   */
+  for (m = 0; m <= pix->lmax; m++)
   {
-    gsize lm_index            = gsl_sf_legendre_array_index (l, m);
-    const complex double alm  = ncm_vector_fast_get (pix->alm, 2 * lm_index + 0) + I * ncm_vector_fast_get (pix->alm, 2 * lm_index + 1);
-    const complex double d_lm = alm * ncm_vector_fast_get (pix->Ylm, lm_index);
-    D_m += d_lm;
-  }
+    const complex double D_m = D[m] * cexp (I * phi_0 * m);
+    const gint64 k           = m % ring_size;
 
-  return D_m * phase;  
+    if ((k == 0) || (2 * k == ring_size))
+      Fim[k] += (m == 0) ? D_m : 2.0 * creal (D_m);
+    else if (2 * k < ring_size)
+      Fim[k] += D_m;
+    else
+      Fim[ring_size - k] += conj (D_m);
+  }
 }
 
 static void
-_ncm_sphere_map_pix_get_circle_from_alm (NcmSphereMapPix *pix, gint64 r_i)
+_ncm_sphere_map_pix_get_circle_mt (glong i, glong f, gpointer data)
 {
-  const gint64 ring_size  = ncm_sphere_map_pix_get_ring_size (pix, r_i);
-  const gint64 ring_fi    = ncm_sphere_map_pix_get_ring_first_index (pix, r_i);
-  _fft_complex *Fim  = &((_fft_complex *)pix->fft_pvec)[ring_fi];
-  gdouble theta_i    = 0.0, phi_0 = 0.0, x = 0.0;
-  gint64 ring_size_2 = ring_size / 2;
-  gboolean ring_even = (ring_size % 2 == 0);
-  gint64 mmax        = GSL_MIN (pix->lmax + 1, ring_size_2 + (ring_size % 2));
-  gint64 m, mr;
-
-  ncm_sphere_map_pix_pix2ang_ring (pix, ring_fi, &theta_i, &phi_0);
+  NcmSphereMapPix *pix           = NCM_SPHERE_MAP_PIX (data);
+  NcmSphereMapPixYlmTab *ylm_tab = pix->ylm_tab;
+  const gint64 lmax              = pix->lmax;
+  complex double *D_n            = g_new (complex double, lmax + 1);
+  complex double *D_s            = g_new (complex double, lmax + 1);
+  glong r_i;
 
-  x = cos (theta_i);
+  for (r_i = i; r_i < f; r_i++)
+  {
+    const gdouble x = ylm_tab->x[r_i];
+    gint64 m;
 
-  gsl_sf_legendre_array_e (GSL_SF_LEGENDRE_SPHARM, pix->lmax, x, -1.0, ncm_vector_data (pix->Ylm));
+    for (m = 0; m <= lmax; m++)
+    {
+      const gsize m_start  = NCM_SPHERE_MAP_PIX_M_START (lmax, m);
+      const gdouble *alpha = &ylm_tab->alpha[m_start];
+      const gdouble *beta  = &ylm_tab->beta[m_start];
+      gdouble lnscale      = ylm_tab->lnYmm[m] + m * ylm_tab->lnsin[r_i];
+      gdouble scale        = (lnscale > _NCM_SPHERE_MAP_PIX_YLM_LN_TINY) ? exp (lnscale) : 0.0;
+      gdouble y_lm1        = (m % 2 == 0) ? 1.0 : -1.0;
+      gdouble y_lm2        = 0.0;
+      complex double D_e   = 0.0;
+      complex double D_o   = 0.0;
+      gint64 l;
 
-  memset (Fim, 0, sizeof (_fft_complex) * ring_size);
+      for (l = m; l <= lmax; l++)
+      {
+        if (l > m)
+        {
+          const gdouble y_l = alpha[l - m] * (x * y_lm1 - beta[l - m] * y_lm2);
+
+          y_lm2 = y_lm1;
+          y_lm1 = y_l;
+          _NCM_SPHERE_MAP_PIX_YLM_RESCALE (y_lm1, y_lm2, lnscale, scale);
+        }
+
+        if (scale != 0.0)
+        {
+          const gsize lm_index       = gsl_sf_legendre_array_index (l, m);
+          const complex double alm   = ncm_vector_fast_get (pix->alm, 2 * lm_index + 0) + I * ncm_vector_fast_get (pix->alm, 2 * lm_index + 1);
+          const complex double d_lm  = alm * y_lm1 * scale;
+
+          if ((l - m) % 2 == 0)
+            D_e += d_lm;
+          else
+            D_o += d_lm;
+        }
+      }
 
-  mr = m = 0;
-  {
-    /*printf ("# Calculating m =  000, ring_size = % 04ld.\n", ring_size);*/
-    {
-      complex double D_0 = _ncm_sphere_map_pix_get_D_m (pix, phi_0, ring_size, mr);
-      /*printf ("# Calculating m =  000, mr =  000, single D_0.\n");*/
-      Fim[m] = D_0;
-    }
-    for (mr = ring_size; mr <= pix->lmax; mr += ring_size)
-    {
-      complex double D_mr = _ncm_sphere_map_pix_get_D_m (pix, phi_0, ring_size, mr);
-      /*printf ("# Calculating m =  000, mr = % 04ld, D_mr + conj (D_mr).\n", mr);*/
-      Fim[m] += 2.0 * creal (D_mr);
-    }
-  }
-  
-  for (m = 1; m < mmax; m++)
-  {
-    /*printf ("# Calculating m = % 04ld, ring_size = % 04ld.\n", m, ring_size);*/
-    for (mr = m; mr <= pix->lmax; mr += ring_size)
-    {
-      complex double D_mr = _ncm_sphere_map_pix_get_D_m (pix, phi_0, ring_size, mr);
-      /*printf ("# Calculating m = % 04ld, mr = % 04ld, D_mr.\n", m, mr);*/
-      Fim[m] += D_mr;  
-    }
-    for (mr = m - ring_size; -mr <= pix->lmax; mr -= ring_size)
-    {
-      complex double D_mr = _ncm_sphere_map_pix_get_D_m (pix, phi_0, ring_size, labs (mr));
-      /*printf ("# Calculating m = % 04ld, mr = % 04ld, conj (D_|mr|).\n", m, mr);*/
-      Fim[m] += conj (D_mr);
-    }
-  }
-  if (pix->lmax >= ring_size_2 && ring_even)
-  {
-    /*printf ("# Calculating m = % 04ld, ring_size = % 04ld.\n", m, ring_size);*/
-    for (mr = m; mr <= pix->lmax; mr += ring_size)
-    {
-      complex double D_mr = _ncm_sphere_map_pix_get_D_m (pix, phi_0, ring_size, mr);
-      /*printf ("# Calculating m = % 04ld, mr = % 04ld, D_mr + conj (D_mr).\n", m, mr);*/
-      Fim[m] += 2.0 * creal (D_mr);
+      D_n[m] = D_e + D_o;
+      D_s[m] = D_e - D_o;
     }
+
+    _ncm_sphere_map_pix_set_ring_Fm (pix, ylm_tab->ring_fi_n[r_i], ylm_tab->ring_size[r_i], ylm_tab->phi_0_n[r_i], D_n);
+    if (ylm_tab->ring_fi_s[r_i] != ylm_tab->ring_fi_n[r_i])
+      _ncm_sphere_map_pix_set_ring_Fm (pix, ylm_tab->ring_fi_s[r_i], ylm_tab->ring_size[r_i], ylm_tab->phi_0_s[r_i], D_s);
   }
+
+  g_free (D_n);
+  g_free (D_s);
 }
 #endif
 
@@ -2136,19 +2825,14 @@ _ncm_sphere_map_pix_get_circle_from_alm (NcmSphereMapPix *pix, gint64 r_i)
  * ncm_sphere_map_pix_alm2map:
  * @pix: a #NcmSphereMapPix
  * 
- * Compute map pixels from current $a_{\ell{}m}$.
+ * Compute map pixels from current $a_{\ell{}m}$. The rings are distributed
+ * over the threads of the NumCosmo thread pool.
  * 
  */
 void 
 ncm_sphere_map_pix_alm2map (NcmSphereMapPix *pix)
 {
 #ifdef NUMCOSMO_HAVE_FFTW3
-  guint i;
-
-  /*gfloat *temp_pix = _fft_vec_alloc (pix->npix);*/
-  /*gfloat *pixels   = pix->pvec;*/
-  /*_fft_vec_memcpy (temp_pix, pix->pvec, pix->npix);*/
-  
   g_assert_cmpuint (pix->nside, >, 0);
   if (pix->lmax == 0)
   {
@@ -2157,35 +2841,12 @@ ncm_sphere_map_pix_alm2map (NcmSphereMapPix *pix)
   }
 
   _ncm_sphere_map_pix_prepare_fft (pix);
+  _ncm_sphere_map_pix_prepare_ylm_tab (pix);
 
   pix->order = NCM_SPHERE_MAP_PIX_ORDER_RING;
 
-  {
-    const gint64 nrings = ncm_sphere_map_pix_get_nrings (pix);
-    gint64 r_i;
-    
-    for (r_i = 0; r_i < nrings; r_i++)
-    {
-      _ncm_sphere_map_pix_get_circle_from_alm (pix, r_i);
-    }
-  }
-
-  for (i = 0; i < pix->fft_plan_c2r->len; i++)
-  {
-#  ifdef HAVE_FFTW3F
-    fftwf_execute (g_ptr_array_index (pix->fft_plan_c2r, i));    
-#  else
-    fftw_execute (g_ptr_array_index (pix->fft_plan_c2r, i));
-#endif
-  } 
-
-/*
-  for (i = 0; i < pix->npix; i++)
-  {
-    printf ("%u % 13.7g % 13.7g\n", i, temp_pix[i], pixels[i]);
-  }
-*/
-
+  ncm_func_eval_threaded_loop_full (&_ncm_sphere_map_pix_get_circle_mt, 0, pix->ylm_tab->nrings_north, pix);
+  ncm_func_eval_threaded_loop_full (&_ncm_sphere_map_pix_fft_c2r_mt, 0, pix->fft_plan_c2r->len, pix);
 #else
   g_error ("ncm_sphere_map_pix_alm2map: no fftw3 support, to use this function recompile NumCosmo with fftw.");
 #endif
@@ -48,6 +48,7 @@ G_BEGIN_DECLS
 
 typedef struct _NcmSphereMapPixClass NcmSphereMapPixClass;
 typedef struct _NcmSphereMapPix NcmSphereMapPix;
+typedef struct _NcmSphereMapPixYlmTab NcmSphereMapPixYlmTab;
 
 struct _NcmSphereMapPixClass
 {
@@ -104,13 +105,14 @@ struct _NcmSphereMapPix
   NcmSphereMapPixCoordSys coordsys;
   gpointer pvec;
   gpointer fft_pvec;
+  GArray *partial;
   GPtrArray *fft_plan_r2c;
   GPtrArray *fft_plan_c2r;
   guint lmax;
-  NcmVector *Ylm;
+  NcmSphereMapPixYlmTab *ylm_tab;
   NcmVector *alm;
+  NcmVector *Cl_lm;
   NcmVector *Cl;
-  NcmTimer *t;
 };
 
 GType ncm_sphere_map_pix_get_type (void) G_GNUC_CONST;
@@ -142,6 +144,14 @@ void ncm_sphere_map_pix_set_lmax (NcmSphereMapPix *pix, guint lmax);
 guint ncm_sphere_map_pix_get_lmax (NcmSphereMapPix *pix);
 
 void ncm_sphere_map_pix_clear_pixels (NcmSphereMapPix *pix);
+gdouble ncm_sphere_map_pix_get_pix (NcmSphereMapPix *pix, const gint64 index);
+
+void ncm_sphere_map_pix_partial_add_pixels (NcmSphereMapPix *pix, const gint64 first, const gint64 last);
+void ncm_sphere_map_pix_partial_add_rings (NcmSphereMapPix *pix, const gint64 r_first, const gint64 r_last);
+void ncm_sphere_map_pix_partial_clear (NcmSphereMapPix *pix);
+gboolean ncm_sphere_map_pix_partial_is_full_sky (NcmSphereMapPix *pix);
+gint64 ncm_sphere_map_pix_partial_get_npix (NcmSphereMapPix *pix);
+gboolean ncm_sphere_map_pix_partial_contains (NcmSphereMapPix *pix, const gint64 index);
 
 gint64 ncm_sphere_map_pix_nest2ring (NcmSphereMapPix *pix, const gint64 nest_index);
 gint64 ncm_sphere_map_pix_ring2nest (NcmSphereMapPix *pix, const gint64 ring_index);
@@ -151,12 +161,14 @@ void ncm_sphere_map_pix_pix2vec_nest (NcmSphereMapPix *pix, const gint64 nest_in
 void ncm_sphere_map_pix_pix2vec_ring (NcmSphereMapPix *pix, const gint64 ring_index, NcmTriVec *vec);
 void ncm_sphere_map_pix_ang2pix_nest (NcmSphereMapPix *pix, const gdouble theta, const gdouble phi, gint64 *nest_index);
 void ncm_sphere_map_pix_ang2pix_ring (NcmSphereMapPix *pix, const gdouble theta, const gdouble phi, gint64 *ring_index);
+void ncm_sphere_map_pix_ang2pix_array (NcmSphereMapPix *pix, const gdouble *theta, const gdouble *phi, gint64 *index, const gsize len);
 
 void ncm_sphere_map_pix_vec2pix_ring (NcmSphereMapPix *pix, NcmTriVec *vec, gint64 *ring_index);
 void ncm_sphere_map_pix_vec2pix_nest (NcmSphereMapPix *pix, NcmTriVec *vec, gint64 *nest_index);
 
 void ncm_sphere_map_pix_add_to_vec (NcmSphereMapPix *pix, NcmTriVec *vec, const gdouble s);
 void ncm_sphere_map_pix_add_to_ang (NcmSphereMapPix *pix, const gdouble theta, const gdouble phi, const gdouble s);
+void ncm_sphere_map_pix_add_to_ang_array (NcmSphereMapPix *pix, const gdouble *theta, const gdouble *phi, const gdouble *s, const gsize len);
 
 void ncm_sphere_map_pix_load_fits (NcmSphereMapPix *pix, const gchar *fits_file, const gchar *signal_name);
 void ncm_sphere_map_pix_save_fits (NcmSphereMapPix *pix, const gchar *fits_file, const gchar *signal_name, gboolean overwrite);
@@ -199,6 +211,8 @@ G_STMT_START { \
 
 #define NCM_SPHERE_MAP_PIX_HEALPIX_NULLVAL (-1.6375e30)
 #define NCM_SPHERE_MAP_PIX_DEFAULT_SIGNAL "SIGNAL"
+#define NCM_SPHERE_MAP_PIX_DEFAULT_PIXEL "PIXEL"
+#define NCM_SPHERE_MAP_PIX_FITS_CHUNK (65536)
 
 #define NCM_SPHERE_MAP_PIX_ALM_SIZE(lmax) (((lmax)*(lmax) + 3*(lmax) + 2)/2) 
 #define NCM_SPHERE_MAP_PIX_M_START(lmax,m) ((2*(lmax)*(m)-(m)*(m)+3*(m))/2)
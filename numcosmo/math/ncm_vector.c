@@ -54,6 +54,7 @@
 #endif
 
 #include <complex.h>
+#include <string.h>
 #ifdef NUMCOSMO_HAVE_FFTW3
 #include <fftw3.h>
 #endif /* NUMCOSMO_HAVE_FFTW3 */
@@ -130,6 +131,27 @@ ncm_vector_new_fftw (guint size)
   return cv;
 }
 
+/**
+ * ncm_vector_new_aligned:
+ * @n: defines the size of the vector.
+ *
+ * This function allocates memory for a new #NcmVector of double
+ * with @n components. The data is unit-stride and its first element
+ * is aligned to #NCM_VECTOR_ALIGNMENT bytes, the object is flagged
+ * with #NCM_VECTOR_ALIGNED, see ncm_vector_is_aligned().
+ *
+ * Returns: (transfer full): A new #NcmVector.
+ */
+NcmVector *
+ncm_vector_new_aligned (gsize n)
+{
+  gchar *p = g_malloc (sizeof (gdouble) * n + NCM_VECTOR_ALIGNMENT);
+  gdouble *d = (gdouble *) (((guintptr) p + NCM_VECTOR_ALIGNMENT - 1) & ~((guintptr) NCM_VECTOR_ALIGNMENT - 1));
+  NcmVector *cv = ncm_vector_new_full (d, n, 1, p, &g_free);
+  cv->type = NCM_VECTOR_ALIGNED;
+  return cv;
+}
+
 /**
  * ncm_vector_new_gsl: (skip)
  * @gv: vector from GNU Scientific Library (GSL) to be converted into a #NcmVector.
@@ -342,7 +364,9 @@ ncm_vector_const_ref (const NcmVector *cv)
  * @var: a #GVariant of the type "ad".
  *
  * This function convert a #GVariant array to a #NcmVector. Since it returns 
- * a constant #NcmVector it uses the same memory of @var.
+ * a constant #NcmVector it uses the same memory of @var. When this memory
+ * is aligned to #NCM_VECTOR_ALIGNMENT bytes the vector is flagged with
+ * #NCM_VECTOR_ALIGNED, see ncm_vector_is_aligned().
  *
  * Returns: (transfer full): A new #NcmVector. 
  */
@@ -356,6 +380,9 @@ ncm_vector_const_new_variant (GVariant *var)
   NCM_VECTOR (v)->pdata = g_variant_ref_sink (var);
   NCM_VECTOR (v)->pfree = (GDestroyNotify) &g_variant_unref;
 
+  if (((guintptr) data % NCM_VECTOR_ALIGNMENT) == 0)
+    NCM_VECTOR (v)->type = NCM_VECTOR_ALIGNED;
+
   return v;
 }
 
@@ -441,16 +468,26 @@ GVariant *
 ncm_vector_get_variant (const NcmVector *v)
 {
   guint n = ncm_vector_len (v);
-  GVariantBuilder builder;
   GVariant *var;
-  guint i;
 
-  g_variant_builder_init (&builder, G_VARIANT_TYPE ("ad"));
+  if (ncm_vector_stride (v) == 1)
+  {
+    var = g_variant_new_fixed_array (G_VARIANT_TYPE ("d"),
+                                     (n > 0) ? ncm_vector_const_ptr (v, 0) : NULL,
+                                     n, sizeof (gdouble));
+  }
+  else
+  {
+    GVariantBuilder builder;
+    guint i;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("ad"));
 
-  for (i = 0; i < n; i++)
-    g_variant_builder_add (&builder, "d", ncm_vector_get (v, i));
+    for (i = 0; i < n; i++)
+      g_variant_builder_add (&builder, "d", ncm_vector_get (v, i));
 
-  var = g_variant_builder_end (&builder);
+    var = g_variant_builder_end (&builder);
+  }
   g_variant_ref_sink (var);
 
   return var;
@@ -879,12 +916,21 @@ ncm_vector_set_from_variant (NcmVector *cv, GVariant *var)
   else if (n != ncm_vector_len (cv))
     g_error ("set_property: cannot set vector values, variant contains %zu childs but vector dimension is %u", n, ncm_vector_len (cv));
 
-  for (i = 0; i < n; i++)
+  if (n > 0)
   {
-    gdouble val = 0.0;
-    g_variant_get_child (var, i, "d", &val);
-    ncm_vector_set (cv, i, val);
-  }    
+    gsize n_elements = 0;
+    const gdouble *d = g_variant_get_fixed_array (var, &n_elements, sizeof (gdouble));
+
+    g_assert_cmpuint (n_elements, ==, n);
+
+    if (ncm_vector_stride (cv) == 1)
+      memcpy (ncm_vector_ptr (cv, 0), d, sizeof (gdouble) * n);
+    else
+    {
+      for (i = 0; i < n; i++)
+        ncm_vector_set (cv, i, d[i]);
+    }
+  }
 }
 
 /**
@@ -904,6 +950,146 @@ ncm_vector_dnrm2 (const NcmVector *cv)
                       ncm_vector_stride (cv));
 }
 
+/**
+ * ncm_vector_is_aligned:
+ * @cv: a #NcmVector
+ *
+ * Checks whether @cv was allocated by ncm_vector_new_aligned().
+ *
+ * Returns: whether @cv is unit-stride and aligned to #NCM_VECTOR_ALIGNMENT bytes.
+ */
+gboolean
+ncm_vector_is_aligned (const NcmVector *cv)
+{
+  return (cv->type == NCM_VECTOR_ALIGNED);
+}
+
+/**
+ * ncm_vector_axpby:
+ * @cv1: a #NcmVector $y$
+ * @alpha: a constant $\alpha$
+ * @cv2: a #NcmVector $x$
+ * @beta: a constant $\beta$
+ *
+ * Calculates inplace $y = \alpha x + \beta y$. Unit-stride vectors
+ * are updated in a single pass, otherwise it falls back to BLAS
+ * dscal and daxpy.
+ *
+ */
+void
+ncm_vector_axpby (NcmVector *cv1, const gdouble alpha, const NcmVector *cv2, const gdouble beta)
+{
+  const guint n = ncm_vector_len (cv1);
+
+  g_assert_cmpuint (n, ==, ncm_vector_len (cv2));
+
+  if ((ncm_vector_stride (cv1) == 1) && (ncm_vector_stride (cv2) == 1))
+  {
+    gdouble *y = ncm_vector_ptr (cv1, 0);
+    const gdouble *x = ncm_vector_const_ptr (cv2, 0);
+    guint i;
+
+    for (i = 0; i < n; i++)
+      y[i] = alpha * x[i] + beta * y[i];
+  }
+  else
+  {
+    cblas_dscal (n, beta, ncm_vector_ptr (cv1, 0), ncm_vector_stride (cv1));
+    cblas_daxpy (n, alpha, 
+                 ncm_vector_const_ptr (cv2, 0), ncm_vector_stride (cv2), 
+                 ncm_vector_ptr (cv1, 0), ncm_vector_stride (cv1));
+  }
+}
+
+/**
+ * ncm_vector_dot_mask:
+ * @cv1: a #NcmVector
+ * @cv2: a #NcmVector
+ * @mask: (element-type gboolean): a #GArray of gboolean
+ *
+ * Calculates the dot product of @cv1 and @cv2 using only the 
+ * components $i$ where @mask[$i$] is TRUE. The array @mask must
+ * have the same length as the vectors.
+ *
+ * Returns: $\sum_{i,\,\text{mask}_i} \text{cv1}_i\text{cv2}_i$.
+ */
+gdouble
+ncm_vector_dot_mask (const NcmVector *cv1, const NcmVector *cv2, const GArray *mask)
+{
+  const guint n = ncm_vector_len (cv1);
+  const gboolean *m = (const gboolean *) mask->data;
+  const gdouble *x = ncm_vector_const_ptr (cv1, 0);
+  const gdouble *y = ncm_vector_const_ptr (cv2, 0);
+  const guint sx = ncm_vector_stride (cv1);
+  const guint sy = ncm_vector_stride (cv2);
+  gdouble res = 0.0;
+  guint i;
+
+  g_assert_cmpuint (n, ==, ncm_vector_len (cv2));
+  g_assert_cmpuint (n, ==, mask->len);
+
+  if ((sx == 1) && (sy == 1))
+  {
+    for (i = 0; i < n; i++)
+      res += m[i] ? x[i] * y[i] : 0.0;
+  }
+  else
+  {
+    for (i = 0; i < n; i++)
+      res += m[i] ? x[i * sx] * y[i * sy] : 0.0;
+  }
+
+  return res;
+}
+
+/**
+ * ncm_vector_wsumsq:
+ * @cv: a #NcmVector
+ * @w: (allow-none): a #NcmVector of weights
+ *
+ * Calculates the weighted sum of squares of the components of @cv. 
+ * When @w is NULL all weights are one and it reduces to the BLAS ddot
+ * of @cv with itself.
+ *
+ * Returns: $\sum_i w_i \text{cv}_i^2$.
+ */
+gdouble
+ncm_vector_wsumsq (const NcmVector *cv, const NcmVector *w)
+{
+  const guint n = ncm_vector_len (cv);
+
+  if (w == NULL)
+  {
+    return cblas_ddot (n, 
+                       ncm_vector_const_ptr (cv, 0), ncm_vector_stride (cv),
+                       ncm_vector_const_ptr (cv, 0), ncm_vector_stride (cv));
+  }
+  else
+  {
+    const gdouble *x = ncm_vector_const_ptr (cv, 0);
+    const gdouble *wx = ncm_vector_const_ptr (w, 0);
+    const guint sx = ncm_vector_stride (cv);
+    const guint sw = ncm_vector_stride (w);
+    gdouble res = 0.0;
+    guint i;
+
+    g_assert_cmpuint (n, ==, ncm_vector_len (w));
+
+    if ((sx == 1) && (sw == 1))
+    {
+      for (i = 0; i < n; i++)
+        res += wx[i] * x[i] * x[i];
+    }
+    else
+    {
+      for (i = 0; i < n; i++)
+        res += wx[i * sw] * x[i * sx] * x[i * sx];
+    }
+
+    return res;
+  }
+}
+
 /**
  * ncm_vector_sum_cpts: 
  * @cv: a @NcmVector
@@ -944,6 +1130,7 @@ _ncm_vector_finalize (GObject *object)
     case NCM_VECTOR_MALLOC:
     case NCM_VECTOR_GSL_VECTOR:
     case NCM_VECTOR_DERIVED:
+    case NCM_VECTOR_ALIGNED:
       break;
     default:
       g_assert_not_reached ();
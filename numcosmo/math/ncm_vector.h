@@ -57,6 +57,7 @@ struct _NcmVectorClass
  * @NCM_VECTOR_MALLOC: FIXME
  * @NCM_VECTOR_ARRAY: FIXME
  * @NCM_VECTOR_DERIVED: FIXME
+ * @NCM_VECTOR_ALIGNED: unit-stride data aligned to #NCM_VECTOR_ALIGNMENT bytes
  *
  * FIXME
  *
@@ -68,8 +69,18 @@ typedef enum _NcmVectorInternal
   NCM_VECTOR_MALLOC,
   NCM_VECTOR_ARRAY,
   NCM_VECTOR_DERIVED,
+  NCM_VECTOR_ALIGNED,
 } NcmVectorInternal;
 
+/**
+ * NCM_VECTOR_ALIGNMENT:
+ *
+ * Alignment in bytes of the data allocated by ncm_vector_new_aligned()
+ * and ncm_matrix_new_aligned().
+ *
+ */
+#define NCM_VECTOR_ALIGNMENT (64)
+
 struct _NcmVector
 {
   /*< private >*/
@@ -89,6 +100,7 @@ GType ncm_vector_get_type (void) G_GNUC_CONST;
 NcmVector *ncm_vector_new (gsize n);
 NcmVector *ncm_vector_new_full (gdouble *d, gsize size, gsize stride, gpointer pdata, GDestroyNotify pfree);
 NcmVector *ncm_vector_new_fftw (guint size);
+NcmVector *ncm_vector_new_aligned (gsize n);
 NcmVector *ncm_vector_new_gsl (gsl_vector *gv);
 NcmVector *ncm_vector_new_gsl_static (gsl_vector *gv);
 NcmVector *ncm_vector_new_array (GArray *a);
@@ -113,6 +125,10 @@ void ncm_vector_log_vals_func (const NcmVector *v, const gchar *prestr, const gc
 void ncm_vector_set_from_variant (NcmVector *cv, GVariant *var);
 
 gdouble ncm_vector_dnrm2 (const NcmVector *cv);
+gboolean ncm_vector_is_aligned (const NcmVector *cv);
+void ncm_vector_axpby (NcmVector *cv1, const gdouble alpha, const NcmVector *cv2, const gdouble beta);
+gdouble ncm_vector_dot_mask (const NcmVector *cv1, const NcmVector *cv2, const GArray *mask);
+gdouble ncm_vector_wsumsq (const NcmVector *cv, const NcmVector *w);
 
 G_INLINE_FUNC gdouble ncm_vector_sum_cpts (const NcmVector *cv);
 G_INLINE_FUNC const NcmVector *ncm_vector_const_new_gsl (const gsl_vector *v);
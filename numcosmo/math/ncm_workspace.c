@@ -0,0 +1,491 @@
+/***************************************************************************
+ *            ncm_workspace.c
+ *
+ *  Mon October 19 10:21:37 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_workspace.c
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:ncm_workspace
+ * @title: NcmWorkspace
+ * @short_description: Per-thread stack of temporary vectors and matrices.
+ *
+ * Functions evaluated inside likelihood calls frequently need temporary
+ * #NcmVector's and #NcmMatrix's, or vector and matrix views of a part of
+ * their arguments. Creating them at each call costs one #GObject
+ * instantiation plus (for non-views) a memory allocation.
+ *
+ * A #NcmWorkspace keeps the objects returned to it and hands them back on the
+ * next borrow with compatible dimensions. Each thread has its own workspace,
+ * obtained through ncm_workspace_peek(), hence no locking is involved.
+ * Objects must be returned to the same workspace in the reverse order they
+ * were borrowed (stack discipline), e.g.,
+ * |[
+ * NcmWorkspace *ws = ncm_workspace_peek ();
+ * NcmVector *tmp   = ncm_workspace_borrow_vector (ws, n);
+ * NcmVector *f_i   = ncm_workspace_borrow_subvector (ws, f, pos, m);
+ *
+ * ...
+ *
+ * ncm_workspace_return_vector (ws, f_i);
+ * ncm_workspace_return_vector (ws, tmp);
+ * ]|
+ *
+ * The vectors and matrices are allocated with ncm_vector_new_aligned() and
+ * ncm_matrix_new_aligned(). The views borrowed through
+ * ncm_workspace_borrow_subvector() and ncm_workspace_borrow_submatrix() hold
+ * a reference to their parent object until they are returned.
+ *
+ * The number of borrows and the number of objects actually created by the
+ * workspace are recorded, see ncm_workspace_get_nalloc() and
+ * ncm_workspace_get_nborrow(). These can be used to check that a given code
+ * path does not allocate after the first call.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif /* HAVE_CONFIG_H */
+#include "build_cfg.h"
+
+#include "math/ncm_workspace.h"
+
+typedef enum _NcmWorkspaceKind
+{
+  _NCM_WORKSPACE_VECTOR = 0,
+  _NCM_WORKSPACE_MATRIX,
+  _NCM_WORKSPACE_VECTOR_VIEW,
+  _NCM_WORKSPACE_MATRIX_VIEW,
+} _NcmWorkspaceKind;
+
+typedef struct _NcmWorkspaceItem
+{
+  gpointer obj;
+  _NcmWorkspaceKind kind;
+} _NcmWorkspaceItem;
+
+static void
+_ncm_workspace_free (gpointer p)
+{
+  NcmWorkspace *ws = (NcmWorkspace *) p;
+
+  if (ws->stack->len > 0)
+    g_warning ("_ncm_workspace_free: thread finished with %u objects borrowed from its workspace.", ws->stack->len);
+
+  ncm_workspace_trim (ws);
+
+  g_array_unref (ws->stack);
+  g_ptr_array_unref (ws->vec_cache);
+  g_ptr_array_unref (ws->mat_cache);
+  g_ptr_array_unref (ws->vview_cache);
+  g_ptr_array_unref (ws->mview_cache);
+
+  g_slice_free (NcmWorkspace, ws);
+}
+
+static GPrivate _ncm_workspace_key = G_PRIVATE_INIT (&_ncm_workspace_free);
+
+/**
+ * ncm_workspace_peek:
+ *
+ * Gets the workspace of the calling thread, creating it if necessary.
+ *
+ * Returns: (transfer none): the #NcmWorkspace of the current thread.
+ */
+NcmWorkspace *
+ncm_workspace_peek (void)
+{
+  NcmWorkspace *ws = g_private_get (&_ncm_workspace_key);
+
+  if (ws == NULL)
+  {
+    ws = g_slice_new (NcmWorkspace);
+
+    ws->stack       = g_array_new (FALSE, FALSE, sizeof (_NcmWorkspaceItem));
+    ws->vec_cache   = g_ptr_array_new ();
+    ws->mat_cache   = g_ptr_array_new ();
+    ws->vview_cache = g_ptr_array_new ();
+    ws->mview_cache = g_ptr_array_new ();
+    ws->nalloc      = 0;
+    ws->nborrow     = 0;
+
+    g_private_set (&_ncm_workspace_key, ws);
+  }
+
+  return ws;
+}
+
+static void
+_ncm_workspace_push (NcmWorkspace *ws, gpointer obj, _NcmWorkspaceKind kind)
+{
+  _NcmWorkspaceItem item = {obj, kind};
+
+  g_array_append_val (ws->stack, item);
+  ws->nborrow++;
+}
+
+static _NcmWorkspaceKind
+_ncm_workspace_pop (NcmWorkspace *ws, gpointer obj)
+{
+  _NcmWorkspaceItem *item;
+  _NcmWorkspaceKind kind;
+
+  if (ws->stack->len == 0)
+    g_error ("_ncm_workspace_pop: returning an object to an empty workspace.");
+
+  item = &g_array_index (ws->stack, _NcmWorkspaceItem, ws->stack->len - 1);
+  if (item->obj != obj)
+    g_error ("_ncm_workspace_pop: objects must be returned in the reverse order they were borrowed.");
+
+  kind = item->kind;
+  g_array_set_size (ws->stack, ws->stack->len - 1);
+
+  return kind;
+}
+
+static gpointer
+_ncm_workspace_cache_pop (GPtrArray *cache)
+{
+  gpointer obj = NULL;
+
+  if (cache->len > 0)
+  {
+    obj = g_ptr_array_index (cache, cache->len - 1);
+    g_ptr_array_set_size (cache, cache->len - 1);
+  }
+
+  return obj;
+}
+
+/**
+ * ncm_workspace_borrow_vector:
+ * @ws: a #NcmWorkspace
+ * @n: vector length
+ *
+ * Borrows a vector of length @n from @ws, its data are aligned to
+ * #NCM_VECTOR_ALIGNMENT bytes. Its contents are undefined.
+ *
+ * Returns: (transfer none): a #NcmVector of length @n.
+ */
+NcmVector *
+ncm_workspace_borrow_vector (NcmWorkspace *ws, const guint n)
+{
+  NcmVector *cv = NULL;
+  guint i;
+
+  for (i = ws->vec_cache->len; i > 0; i--)
+  {
+    NcmVector *cv_i = g_ptr_array_index (ws->vec_cache, i - 1);
+
+    if (ncm_vector_len (cv_i) == n)
+    {
+      cv = cv_i;
+      g_ptr_array_remove_index_fast (ws->vec_cache, i - 1);
+      break;
+    }
+  }
+
+  if (cv == NULL)
+  {
+    cv = ncm_vector_new_aligned (n);
+    ws->nalloc++;
+  }
+
+  _ncm_workspace_push (ws, cv, _NCM_WORKSPACE_VECTOR);
+
+  return cv;
+}
+
+/**
+ * ncm_workspace_borrow_matrix:
+ * @ws: a #NcmWorkspace
+ * @nrows: number of rows
+ * @ncols: number of columns
+ *
+ * Borrows a @nrows x @ncols matrix from @ws, its data are aligned to
+ * #NCM_VECTOR_ALIGNMENT bytes. Its contents are undefined.
+ *
+ * Returns: (transfer none): a #NcmMatrix.
+ */
+NcmMatrix *
+ncm_workspace_borrow_matrix (NcmWorkspace *ws, const guint nrows, const guint ncols)
+{
+  NcmMatrix *cm = NULL;
+  guint i;
+
+  for (i = ws->mat_cache->len; i > 0; i--)
+  {
+    NcmMatrix *cm_i = g_ptr_array_index (ws->mat_cache, i - 1);
+
+    if ((ncm_matrix_nrows (cm_i) == nrows) && (ncm_matrix_ncols (cm_i) == ncols))
+    {
+      cm = cm_i;
+      g_ptr_array_remove_index_fast (ws->mat_cache, i - 1);
+      break;
+    }
+  }
+
+  if (cm == NULL)
+  {
+    cm = ncm_matrix_new_aligned (nrows, ncols);
+    ws->nalloc++;
+  }
+
+  _ncm_workspace_push (ws, cm, _NCM_WORKSPACE_MATRIX);
+
+  return cm;
+}
+
+/**
+ * ncm_workspace_borrow_subvector:
+ * @ws: a #NcmWorkspace
+ * @cv: a #NcmVector
+ * @k: first element of the view
+ * @size: view length
+ *
+ * Borrows a view of the elements [@k, @k + @size) of @cv, see
+ * ncm_vector_get_subvector(). The view holds a reference to @cv until it
+ * is returned.
+ *
+ * Returns: (transfer none): a #NcmVector view of @cv.
+ */
+NcmVector *
+ncm_workspace_borrow_subvector (NcmWorkspace *ws, NcmVector *cv, const guint k, const guint size)
+{
+  NcmVector *scv = _ncm_workspace_cache_pop (ws->vview_cache);
+
+  if (scv == NULL)
+  {
+    scv = g_object_new (NCM_TYPE_VECTOR, NULL);
+    ws->nalloc++;
+  }
+
+  scv->vv    = gsl_vector_subvector (ncm_vector_gsl (cv), k, size);
+  scv->type  = NCM_VECTOR_DERIVED;
+  scv->pdata = g_object_ref (cv);
+  scv->pfree = &g_object_unref;
+
+  _ncm_workspace_push (ws, scv, _NCM_WORKSPACE_VECTOR_VIEW);
+
+  return scv;
+}
+
+/**
+ * ncm_workspace_borrow_submatrix:
+ * @ws: a #NcmWorkspace
+ * @cm: a #NcmMatrix
+ * @k1: first row of the view
+ * @k2: first column of the view
+ * @nrows: number of rows of the view
+ * @ncols: number of columns of the view
+ *
+ * Borrows a view of the block of @cm starting at (@k1, @k2), see
+ * ncm_matrix_get_submatrix(). The view holds a reference to @cm until it
+ * is returned.
+ *
+ * Returns: (transfer none): a #NcmMatrix view of @cm.
+ */
+NcmMatrix *
+ncm_workspace_borrow_submatrix (NcmWorkspace *ws, NcmMatrix *cm, const guint k1, const guint k2, const guint nrows, const guint ncols)
+{
+  NcmMatrix *scm = _ncm_workspace_cache_pop (ws->mview_cache);
+
+  if (scm == NULL)
+  {
+    scm = g_object_new (NCM_TYPE_MATRIX, NULL);
+    ws->nalloc++;
+  }
+
+  scm->mv    = gsl_matrix_submatrix (ncm_matrix_gsl (cm), k1, k2, nrows, ncols);
+  scm->type  = NCM_MATRIX_DERIVED;
+  scm->pdata = g_object_ref (cm);
+  scm->pfree = &g_object_unref;
+
+  _ncm_workspace_push (ws, scm, _NCM_WORKSPACE_MATRIX_VIEW);
+
+  return scm;
+}
+
+/**
+ * ncm_workspace_return_vector:
+ * @ws: a #NcmWorkspace
+ * @cv: a #NcmVector
+ *
+ * Returns @cv, borrowed with ncm_workspace_borrow_vector() or
+ * ncm_workspace_borrow_subvector(), to @ws. It must be the last object
+ * borrowed from @ws and not yet returned.
+ *
+ */
+void
+ncm_workspace_return_vector (NcmWorkspace *ws, NcmVector *cv)
+{
+  const _NcmWorkspaceKind kind = _ncm_workspace_pop (ws, cv);
+  GPtrArray *cache;
+
+  switch (kind)
+  {
+    case _NCM_WORKSPACE_VECTOR:
+      cache = ws->vec_cache;
+      break;
+    case _NCM_WORKSPACE_VECTOR_VIEW:
+      cache = ws->vview_cache;
+      break;
+    default:
+      g_error ("ncm_workspace_return_vector: object was not borrowed as a vector.");
+      return;
+  }
+
+  /* Objects referenced elsewhere are released instead of reused. */
+  if ((G_OBJECT (cv)->ref_count > 1) || (cache->len >= NCM_WORKSPACE_MAX_CACHED))
+    ncm_vector_free (cv);
+  else
+  {
+    /* Cached views drop their parent. */
+    if (cv->pdata != NULL)
+    {
+      cv->pfree (cv->pdata);
+      cv->pdata = NULL;
+      cv->pfree = NULL;
+    }
+    g_ptr_array_add (cache, cv);
+  }
+}
+
+/**
+ * ncm_workspace_return_matrix:
+ * @ws: a #NcmWorkspace
+ * @cm: a #NcmMatrix
+ *
+ * Returns @cm, borrowed with ncm_workspace_borrow_matrix() or
+ * ncm_workspace_borrow_submatrix(), to @ws. It must be the last object
+ * borrowed from @ws and not yet returned.
+ *
+ */
+void
+ncm_workspace_return_matrix (NcmWorkspace *ws, NcmMatrix *cm)
+{
+  const _NcmWorkspaceKind kind = _ncm_workspace_pop (ws, cm);
+  GPtrArray *cache;
+
+  switch (kind)
+  {
+    case _NCM_WORKSPACE_MATRIX:
+      cache = ws->mat_cache;
+      break;
+    case _NCM_WORKSPACE_MATRIX_VIEW:
+      cache = ws->mview_cache;
+      break;
+    default:
+      g_error ("ncm_workspace_return_matrix: object was not borrowed as a matrix.");
+      return;
+  }
+
+  if ((G_OBJECT (cm)->ref_count > 1) || (cache->len >= NCM_WORKSPACE_MAX_CACHED))
+    ncm_matrix_free (cm);
+  else
+  {
+    if (cm->pdata != NULL)
+    {
+      cm->pfree (cm->pdata);
+      cm->pdata = NULL;
+      cm->pfree = NULL;
+    }
+    g_ptr_array_add (cache, cm);
+  }
+}
+
+/**
+ * ncm_workspace_depth:
+ * @ws: a #NcmWorkspace
+ *
+ * Returns: the number of objects currently borrowed from @ws.
+ */
+guint
+ncm_workspace_depth (NcmWorkspace *ws)
+{
+  return ws->stack->len;
+}
+
+/**
+ * ncm_workspace_get_nalloc:
+ * @ws: a #NcmWorkspace
+ *
+ * Returns: the number of objects created by @ws since the last call of ncm_workspace_reset_stats().
+ */
+gulong
+ncm_workspace_get_nalloc (NcmWorkspace *ws)
+{
+  return ws->nalloc;
+}
+
+/**
+ * ncm_workspace_get_nborrow:
+ * @ws: a #NcmWorkspace
+ *
+ * Returns: the number of borrows from @ws since the last call of ncm_workspace_reset_stats().
+ */
+gulong
+ncm_workspace_get_nborrow (NcmWorkspace *ws)
+{
+  return ws->nborrow;
+}
+
+/**
+ * ncm_workspace_reset_stats:
+ * @ws: a #NcmWorkspace
+ *
+ * Resets the allocation and borrow counters of @ws.
+ *
+ */
+void
+ncm_workspace_reset_stats (NcmWorkspace *ws)
+{
+  ws->nalloc  = 0;
+  ws->nborrow = 0;
+}
+
+static void
+_ncm_workspace_cache_clear (GPtrArray *cache, GDestroyNotify free_func)
+{
+  guint i;
+
+  for (i = 0; i < cache->len; i++)
+    free_func (g_ptr_array_index (cache, i));
+
+  g_ptr_array_set_size (cache, 0);
+}
+
+/**
+ * ncm_workspace_trim:
+ * @ws: a #NcmWorkspace
+ *
+ * Releases all objects cached in @ws. The objects currently borrowed are
+ * not affected.
+ *
+ */
+void
+ncm_workspace_trim (NcmWorkspace *ws)
+{
+  _ncm_workspace_cache_clear (ws->vec_cache, (GDestroyNotify) &ncm_vector_free);
+  _ncm_workspace_cache_clear (ws->mat_cache, (GDestroyNotify) &ncm_matrix_free);
+  _ncm_workspace_cache_clear (ws->vview_cache, (GDestroyNotify) &ncm_vector_free);
+  _ncm_workspace_cache_clear (ws->mview_cache, (GDestroyNotify) &ncm_matrix_free);
+}
@@ -0,0 +1,76 @@
+/***************************************************************************
+ *            ncm_workspace.h
+ *
+ *  Mon October 19 10:21:37 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_workspace.h
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _NCM_WORKSPACE_H_
+#define _NCM_WORKSPACE_H_
+
+#include <glib.h>
+#include <glib-object.h>
+#include <numcosmo/build_cfg.h>
+#include <numcosmo/math/ncm_vector.h>
+#include <numcosmo/math/ncm_matrix.h>
+
+G_BEGIN_DECLS
+
+typedef struct _NcmWorkspace NcmWorkspace;
+
+/**
+ * NcmWorkspace:
+ *
+ * Per-thread stack of temporary #NcmVector and #NcmMatrix objects.
+ */
+struct _NcmWorkspace
+{
+  /*< private >*/
+  GArray *stack;
+  GPtrArray *vec_cache;
+  GPtrArray *mat_cache;
+  GPtrArray *vview_cache;
+  GPtrArray *mview_cache;
+  gulong nalloc;
+  gulong nborrow;
+};
+
+NcmWorkspace *ncm_workspace_peek (void);
+
+NcmVector *ncm_workspace_borrow_vector (NcmWorkspace *ws, const guint n);
+NcmMatrix *ncm_workspace_borrow_matrix (NcmWorkspace *ws, const guint nrows, const guint ncols);
+NcmVector *ncm_workspace_borrow_subvector (NcmWorkspace *ws, NcmVector *cv, const guint k, const guint size);
+NcmMatrix *ncm_workspace_borrow_submatrix (NcmWorkspace *ws, NcmMatrix *cm, const guint k1, const guint k2, const guint nrows, const guint ncols);
+
+void ncm_workspace_return_vector (NcmWorkspace *ws, NcmVector *cv);
+void ncm_workspace_return_matrix (NcmWorkspace *ws, NcmMatrix *cm);
+
+guint ncm_workspace_depth (NcmWorkspace *ws);
+gulong ncm_workspace_get_nalloc (NcmWorkspace *ws);
+gulong ncm_workspace_get_nborrow (NcmWorkspace *ws);
+void ncm_workspace_reset_stats (NcmWorkspace *ws);
+void ncm_workspace_trim (NcmWorkspace *ws);
+
+#define NCM_WORKSPACE_MAX_CACHED (64)
+
+G_END_DECLS
+
+#endif /* _NCM_WORKSPACE_H_ */
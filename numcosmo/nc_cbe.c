@@ -1663,6 +1663,81 @@ _nc_cbe_update_callbacks (NcCBE *cbe)
     cbe->call = _nc_cbe_call_spectra;
 }
 
+/*
+ * Stage dependencies
+ * 
+ * The CLASS stages are run in the order bg -> thermo -> pert -> prim -> 
+ * nonlin -> transfer -> spectra -> lensing. The NcHICosmo parameters enter
+ * from bg on, the NcHIReion parameters from thermo on and the NcHIPrim 
+ * parameters only from prim on. When no non-linear corrections are applied 
+ * (nl_none) the transfer functions do not depend on the primordial spectrum,
+ * therefore, a change in the NcHIPrim parameters only requires re-running 
+ * prim, nonlin, spectra and lensing, re-using the perturbation sources and the
+ * transfer functions already computed.
+ * 
+ */
+
+static gboolean
+_nc_cbe_prim_indep_transfer (NcCBE *cbe)
+{
+  return (cbe->priv->pnl.method == nl_none);
+}
+
+static void
+_nc_cbe_rerun_prim (NcCBE *cbe, NcHICosmo *cosmo)
+{
+  struct precision *ppr  = (struct precision *)cbe->prec->priv;
+  const gboolean lensing = (cbe->free == &_nc_cbe_free_lensing);
+
+  g_assert (cbe->allocated);
+
+  if (lensing)
+  {
+    if (lensing_free (&cbe->priv->ple) == _FAILURE_)
+      g_error ("_nc_cbe_rerun_prim: Error running lensing_free `%s'\n", cbe->priv->ple.error_message);
+  }
+  if (spectra_free (&cbe->priv->psp) == _FAILURE_)
+    g_error ("_nc_cbe_rerun_prim: Error running spectra_free `%s'\n", cbe->priv->psp.error_message);
+  if (nonlinear_free (&cbe->priv->pnl) == _FAILURE_)
+    g_error ("_nc_cbe_rerun_prim: Error running nonlinear_free `%s'\n", cbe->priv->pnl.error_message);
+  if (primordial_free (&cbe->priv->ppm) == _FAILURE_)
+    g_error ("_nc_cbe_rerun_prim: Error running primordial_free `%s'\n", cbe->priv->ppm.error_message);
+
+  _nc_cbe_set_prim (cbe, cosmo);
+  if (primordial_init (ppr, &cbe->priv->ppt, &cbe->priv->ppm) == _FAILURE_)
+    g_error ("_nc_cbe_rerun_prim: Error running primordial_init `%s'\n", cbe->priv->ppm.error_message);  
+
+  _nc_cbe_set_nonlin (cbe, cosmo);
+  if (nonlinear_init (ppr, &cbe->priv->pba, &cbe->priv->pth, &cbe->priv->ppt, &cbe->priv->ppm, &cbe->priv->pnl) == _FAILURE_)
+    g_error ("_nc_cbe_rerun_prim: Error running nonlinear_init `%s'\n", cbe->priv->pnl.error_message);
+
+  _nc_cbe_set_spectra (cbe, cosmo);
+  if (spectra_init (ppr, &cbe->priv->pba, &cbe->priv->ppt, &cbe->priv->ppm, &cbe->priv->pnl, &cbe->priv->ptr, &cbe->priv->psp) == _FAILURE_)
+    g_error ("_nc_cbe_rerun_prim: Error running spectra_init `%s'\n", cbe->priv->psp.error_message);  
+
+  if (lensing)
+  {
+    _nc_cbe_set_lensing (cbe, cosmo);
+    if (lensing_init (ppr, &cbe->priv->ppt, &cbe->priv->psp, &cbe->priv->pnl, &cbe->priv->ple) == _FAILURE_)
+      g_error ("_nc_cbe_rerun_prim: Error running lensing_init `%s'\n", cbe->priv->ple.error_message);
+  }
+}
+
+static void
+_nc_cbe_rerun_thermo (NcCBE *cbe, NcHICosmo *cosmo)
+{
+  struct precision *ppr = (struct precision *)cbe->prec->priv;
+
+  g_assert (cbe->thermodyn_prepared);
+
+  if (thermodynamics_free (&cbe->priv->pth) == _FAILURE_)
+    g_error ("_nc_cbe_rerun_thermo: Error running thermodynamics_free `%s'\n", cbe->priv->pth.error_message);
+
+  _nc_cbe_set_thermo (cbe, cosmo);
+  if (thermodynamics_init (ppr, &cbe->priv->pba, &cbe->priv->pth) == _FAILURE_)
+    g_error ("_nc_cbe_rerun_thermo: Error running thermodynamics_init `%s'\n", cbe->priv->pth.error_message);
+}
+
 /**
  * nc_cbe_thermodyn_prepare:
  * @cbe: a #NcCBE
@@ -1742,7 +1817,11 @@ nc_cbe_prepare (NcCBE *cbe, NcHICosmo *cosmo)
  * @cbe: a #NcCBE
  * @cosmo: a #NcHICosmo
  * 
- * Prepares all necessary Class structures.
+ * Prepares all necessary Class structures. Only the stages affected by
+ * the parameters that changed since the last call are recomputed, i.e.,
+ * if only the #NcHIPrim parameters changed the perturbations and transfer 
+ * functions are re-used, and if only the #NcHIReion parameters changed
+ * the background is re-used.
  * 
  */
 void
@@ -1758,14 +1837,14 @@ nc_cbe_prepare_if_needed (NcCBE *cbe, NcHICosmo *cosmo)
   {
     gboolean cosmo_up = ncm_model_ctrl_model_last_update (cbe->ctrl_cosmo);
     gboolean prim_up  = ncm_model_ctrl_submodel_last_update (cbe->ctrl_cosmo, nc_hiprim_id ());
+    gboolean reion_up = ncm_model_ctrl_model_has_submodel (cbe->ctrl_cosmo, nc_hireion_id ()) && 
+      ncm_model_ctrl_submodel_last_update (cbe->ctrl_cosmo, nc_hireion_id ());
 
-    /*printf ("cosmo_up %d prim_up %d [%p]\n", cosmo_up, prim_up, cosmo);*/
-    
-    if (cosmo_up)
+    if (cosmo_up || (reion_up && !cbe->thermodyn_prepared))
     {    
       nc_cbe_prepare (cbe, cosmo);
     }
-    else if (prim_up)
+    else if (reion_up)
     {
       if (cbe->allocated)
       {
@@ -1773,12 +1852,36 @@ nc_cbe_prepare_if_needed (NcCBE *cbe, NcHICosmo *cosmo)
         cbe->free (cbe);
         cbe->allocated = FALSE;
       }
+
+      _nc_cbe_rerun_thermo (cbe, cosmo);
+
       if (cbe->call != NULL)
       {
         cbe->call (cbe, cosmo);
         cbe->allocated = TRUE;
       }
     }
+    else if (prim_up)
+    {
+      if (cbe->allocated && _nc_cbe_prim_indep_transfer (cbe))
+      {
+        _nc_cbe_rerun_prim (cbe, cosmo);
+      }
+      else
+      {
+        if (cbe->allocated)
+        {
+          g_assert (cbe->free != NULL);
+          cbe->free (cbe);
+          cbe->allocated = FALSE;
+        }
+        if (cbe->call != NULL)
+        {
+          cbe->call (cbe, cosmo);
+          cbe->allocated = TRUE;
+        }
+      }
+    }
   }
 }
 
@@ -350,6 +350,9 @@ nc_distance_init (NcDistance *dist)
   dist->comoving_distance_spline = NULL;
 
   dist->ctrl = ncm_model_ctrl_new (NULL);
+
+  /* The helium primordial abundance enters only the recombination history. */
+  ncm_model_ctrl_add_indep (dist->ctrl, "Yp");
 }
 
 /**
@@ -319,7 +319,11 @@ nc_snia_dist_cov_clear (NcSNIADistCov **dcov)
 void
 nc_snia_dist_cov_set_empty_fac (NcSNIADistCov *dcov, gboolean enable)
 {
-  dcov->empty_fac = enable;
+  if (dcov->empty_fac != enable)
+  {
+    dcov->empty_fac = enable;
+    ncm_model_state_mark_outdated (NCM_MODEL (dcov));
+  }
 }
 
 /**
@@ -368,7 +372,11 @@ _nc_snia_dist_cov_calc_empty_fac (NcSNIADistCov *dcov, gdouble z_cmb)
  * @snia_cov: a #NcDataSNIACov
  * @cov: a #NcmMatrix
  *
- * FIXME
+ * Computes the covariance of the SNIa distance moduli into @cov,
+ * combining the magnitude, width and colour components of @snia_cov
+ * with the current values of $\alpha$ and $\beta$ and adding the
+ * diagonal intrinsic, peculiar velocity, redshift and lensing
+ * variances. The full matrix (both triangles) is filled.
  *
  */
 void
@@ -385,7 +393,7 @@ nc_snia_dist_cov_calc (NcSNIADistCov *dcov, NcDataSNIACov *snia_cov, NcmMatrix *
   const gdouble var_pecz       = exp (2.0 * LNSIGMA_PECZ);
   const gdouble var_lens       = exp (2.0 * LNSIGMA_LENS);
   const guint mu_len           = snia_cov->mu_len;
-  register guint i, j, ij;
+  guint i, j, ij;
 
   g_assert (NCM_DATA (snia_cov)->init);
 
@@ -395,30 +403,31 @@ nc_snia_dist_cov_calc (NcSNIADistCov *dcov, NcDataSNIACov *snia_cov, NcmMatrix *
   else if (ncm_model_vparam_len (model, NC_SNIA_DIST_COV_LNSIGMA_INT) < snia_cov->dataset_len)
     g_error ("nc_snia_dist_cov_calc: model dataset is smaller then the used by the data: %u < %u.",
              ncm_model_vparam_len (model, NC_SNIA_DIST_COV_LNSIGMA_INT), snia_cov->dataset_len);
-  ij = 0;
 
   for (i = 0; i < dcov->var_int->len; i++)
   {
     g_array_index (dcov->var_int, gdouble, i) = exp (2.0 * ncm_model_orig_vparam_get (model, NC_SNIA_DIST_COV_LNSIGMA_INT, i));
   }
 
+  /* 
+   * The six components are packed contiguously for each element of the
+   * upper triangle, so the alpha-beta dependent part is assembled in a
+   * single sequential pass and then copied to the lower triangle.
+   */
+  ij = 0;
   for (i = 0; i < mu_len; i++)
   {
     for (j = i; j < mu_len; j++)
     {
-      const gdouble mag_mag       = ncm_vector_fast_get (snia_cov->cov_packed, NC_DATA_SNIA_COV_ORDER_LENGTH * ij + NC_DATA_SNIA_COV_ORDER_MAG_MAG);
-      const gdouble mag_width     = ncm_vector_fast_get (snia_cov->cov_packed, NC_DATA_SNIA_COV_ORDER_LENGTH * ij + NC_DATA_SNIA_COV_ORDER_MAG_WIDTH);
-      const gdouble mag_colour    = ncm_vector_fast_get (snia_cov->cov_packed, NC_DATA_SNIA_COV_ORDER_LENGTH * ij + NC_DATA_SNIA_COV_ORDER_MAG_COLOUR);
-      const gdouble width_width   = ncm_vector_fast_get (snia_cov->cov_packed, NC_DATA_SNIA_COV_ORDER_LENGTH * ij + NC_DATA_SNIA_COV_ORDER_WIDTH_WIDTH);
-      const gdouble width_colour  = ncm_vector_fast_get (snia_cov->cov_packed, NC_DATA_SNIA_COV_ORDER_LENGTH * ij + NC_DATA_SNIA_COV_ORDER_WIDTH_COLOUR);
-      const gdouble colour_colour = ncm_vector_fast_get (snia_cov->cov_packed, NC_DATA_SNIA_COV_ORDER_LENGTH * ij + NC_DATA_SNIA_COV_ORDER_COLOUR_COLOUR);
+      const gdouble *comp = ncm_vector_ptr (snia_cov->cov_packed, NC_DATA_SNIA_COV_ORDER_LENGTH * ij);
+
       ncm_matrix_set (cov, i, j,
-                      mag_mag
-                      + alpha2 * width_width
-                      + beta2 * colour_colour
-                      + two_alpha * mag_width
-                      - two_beta * mag_colour
-                      - two_alpha_beta * width_colour
+                      comp[NC_DATA_SNIA_COV_ORDER_MAG_MAG]
+                      + alpha2 * comp[NC_DATA_SNIA_COV_ORDER_WIDTH_WIDTH]
+                      + beta2 * comp[NC_DATA_SNIA_COV_ORDER_COLOUR_COLOUR]
+                      + two_alpha * comp[NC_DATA_SNIA_COV_ORDER_MAG_WIDTH]
+                      - two_beta * comp[NC_DATA_SNIA_COV_ORDER_MAG_COLOUR]
+                      - two_alpha_beta * comp[NC_DATA_SNIA_COV_ORDER_WIDTH_COLOUR]
                       );
       ij++;
     }
@@ -436,6 +445,8 @@ nc_snia_dist_cov_calc (NcSNIADistCov *dcov, NcDataSNIACov *snia_cov, NcmMatrix *
       ncm_matrix_addto (cov, i, i, var_tot);
     }
   }
+
+  ncm_matrix_copy_triangle (cov, 'U');
 }
 
 /**
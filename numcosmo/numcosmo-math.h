@@ -63,6 +63,7 @@
 #include <numcosmo/math/ncm_mpsf_sbessel_int.h>
 #include <numcosmo/math/ncm_sf_sbessel.h>
 #include <numcosmo/math/ncm_sf_sbessel_int.h>
+#include <numcosmo/math/ncm_sf_sbessel_table.h>
 #include <numcosmo/math/ncm_mpsf_0F1.h>
 #include <numcosmo/math/ncm_fftlog.h>
 #include <numcosmo/math/ncm_fftlog_tophatwin2.h>
@@ -84,7 +85,9 @@
 #include <numcosmo/math/ncm_data_gauss.h>
 #include <numcosmo/math/ncm_data_gauss_cov.h>
 #include <numcosmo/math/ncm_data_gauss_diag.h>
+#include <numcosmo/math/ncm_data_gauss_lin.h>
 #include <numcosmo/math/ncm_data_poisson.h>
+#include <numcosmo/math/ncm_data_emu.h>
 #include <numcosmo/math/ncm_dataset.h>
 #include <numcosmo/math/ncm_likelihood.h>
 #include <numcosmo/math/ncm_prior.h>
@@ -120,13 +123,18 @@
 #include <numcosmo/math/ncm_fit_esmcmc_walker.h>
 #include <numcosmo/math/ncm_fit_esmcmc_walker_stretch.h>
 #include <numcosmo/math/ncm_fit_esmcmc_walker_walk.h>
+#include <numcosmo/math/ncm_fit_ns.h>
+#include <numcosmo/math/ncm_fit_hmc.h>
+#include <numcosmo/math/ncm_fit_pt.h>
 #include <numcosmo/math/ncm_lh_ratio1d.h>
 #include <numcosmo/math/ncm_lh_ratio2d.h>
+#include <numcosmo/math/ncm_fisher.h>
 #include <numcosmo/math/ncm_abc.h>
 #include <numcosmo/math/ncm_quaternion.h>
 
 /* Utilities */
 #include <numcosmo/math/memory_pool.h>
+#include <numcosmo/math/ncm_workspace.h>
 #include <numcosmo/math/mpq_tree.h>
 #include <numcosmo/math/integral.h>
 #include <numcosmo/math/poly.h>
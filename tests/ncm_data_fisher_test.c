@@ -0,0 +1,176 @@
+/***************************************************************************
+ *            ncm_data_fisher_test.c
+ *
+ *  Mon October 19 15:12:40 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_data_fisher_test.c
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Gaussian data whose mean and covariance both depend on the NcHICosmo
+ * in the NcmMSet. The redshifts are fixed by the number of points, so
+ * the objects are completely described by the parent properties and
+ * can be duplicated through NcmSerialize.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#undef GSL_RANGE_CHECK_OFF
+#endif /* HAVE_CONFIG_H */
+#include <numcosmo/numcosmo.h>
+#include "ncm_data_fisher_test.h"
+
+#define _NCM_DATA_FISHER_TEST_ZMAX (2.0)
+#define _NCM_DATA_FISHER_TEST_FRAC (5.0e-2)
+#define _NCM_DATA_FISHER_TEST_CORR (0.5)
+
+static gdouble
+_ncm_data_fisher_test_z (guint np, guint i)
+{
+  return _NCM_DATA_FISHER_TEST_ZMAX * (i + 1.0) / np;
+}
+
+G_DEFINE_TYPE (NcmDataGaussCovFisherTest, ncm_data_gauss_cov_fisher_test, NCM_TYPE_DATA_GAUSS_COV);
+G_DEFINE_TYPE (NcmDataGaussDiagFisherTest, ncm_data_gauss_diag_fisher_test, NCM_TYPE_DATA_GAUSS_DIAG);
+
+static void
+ncm_data_gauss_cov_fisher_test_init (NcmDataGaussCovFisherTest *cov_test)
+{
+}
+
+static void _ncm_data_gauss_cov_fisher_test_mean_func (NcmDataGaussCov *gauss, NcmMSet *mset, NcmVector *vp);
+static gboolean _ncm_data_gauss_cov_fisher_test_cov_func (NcmDataGaussCov *gauss, NcmMSet *mset, NcmMatrix *cov);
+
+static void
+ncm_data_gauss_cov_fisher_test_class_init (NcmDataGaussCovFisherTestClass *klass)
+{
+  NcmDataGaussCovClass *gauss_class = NCM_DATA_GAUSS_COV_CLASS (klass);
+
+  gauss_class->mean_func = &_ncm_data_gauss_cov_fisher_test_mean_func;
+  gauss_class->cov_func  = &_ncm_data_gauss_cov_fisher_test_cov_func;
+}
+
+static void
+_ncm_data_gauss_cov_fisher_test_mean_func (NcmDataGaussCov *gauss, NcmMSet *mset, NcmVector *vp)
+{
+  NcHICosmo *cosmo = NC_HICOSMO (ncm_mset_peek (mset, nc_hicosmo_id ()));
+  guint i;
+
+  for (i = 0; i < gauss->np; i++)
+    ncm_vector_set (vp, i, nc_hicosmo_H (cosmo, _ncm_data_fisher_test_z (gauss->np, i)));
+}
+
+/* C_ij = f^2 H_i H_j rho^|i - j|, a fixed fractional error with exponentially decaying correlations. */
+static gboolean
+_ncm_data_gauss_cov_fisher_test_cov_func (NcmDataGaussCov *gauss, NcmMSet *mset, NcmMatrix *cov)
+{
+  NcHICosmo *cosmo = NC_HICOSMO (ncm_mset_peek (mset, nc_hicosmo_id ()));
+  guint i, j;
+
+  for (i = 0; i < gauss->np; i++)
+  {
+    const gdouble sigma_i = _NCM_DATA_FISHER_TEST_FRAC * nc_hicosmo_H (cosmo, _ncm_data_fisher_test_z (gauss->np, i));
+
+    for (j = i; j < gauss->np; j++)
+    {
+      const gdouble sigma_j = _NCM_DATA_FISHER_TEST_FRAC * nc_hicosmo_H (cosmo, _ncm_data_fisher_test_z (gauss->np, j));
+      const gdouble cov_ij  = sigma_i * sigma_j * gsl_pow_int (_NCM_DATA_FISHER_TEST_CORR, j - i);
+
+      ncm_matrix_set (cov, i, j, cov_ij);
+      ncm_matrix_set (cov, j, i, cov_ij);
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+ * ncm_data_gauss_cov_fisher_test_new:
+ * @np: number of points
+ *
+ * Returns: (transfer full): a new #NcmDataGaussCovFisherTest with @np points.
+ */
+NcmData *
+ncm_data_gauss_cov_fisher_test_new (guint np)
+{
+  return g_object_new (NCM_TYPE_DATA_GAUSS_COV_FISHER_TEST,
+                       "n-points", np,
+                       NULL);
+}
+
+static void
+ncm_data_gauss_diag_fisher_test_init (NcmDataGaussDiagFisherTest *diag_test)
+{
+}
+
+static void _ncm_data_gauss_diag_fisher_test_mean_func (NcmDataGaussDiag *diag, NcmMSet *mset, NcmVector *vp);
+static gboolean _ncm_data_gauss_diag_fisher_test_sigma_func (NcmDataGaussDiag *diag, NcmMSet *mset, NcmVector *sigma);
+
+static void
+ncm_data_gauss_diag_fisher_test_class_init (NcmDataGaussDiagFisherTestClass *klass)
+{
+  NcmDataGaussDiagClass *diag_class = NCM_DATA_GAUSS_DIAG_CLASS (klass);
+
+  diag_class->mean_func  = &_ncm_data_gauss_diag_fisher_test_mean_func;
+  diag_class->sigma_func = &_ncm_data_gauss_diag_fisher_test_sigma_func;
+}
+
+static void
+_ncm_data_gauss_diag_fisher_test_mean_func (NcmDataGaussDiag *diag, NcmMSet *mset, NcmVector *vp)
+{
+  NcHICosmo *cosmo = NC_HICOSMO (ncm_mset_peek (mset, nc_hicosmo_id ()));
+  guint i;
+
+  for (i = 0; i < diag->np; i++)
+  {
+    const gdouble z = _ncm_data_fisher_test_z (diag->np, i);
+    ncm_vector_set (vp, i, nc_hicosmo_H (cosmo, z) / (1.0 + z));
+  }
+}
+
+/* sigma_i = f (1 + z_i) H_i, a fractional error growing with the redshift. */
+static gboolean
+_ncm_data_gauss_diag_fisher_test_sigma_func (NcmDataGaussDiag *diag, NcmMSet *mset, NcmVector *sigma)
+{
+  NcHICosmo *cosmo = NC_HICOSMO (ncm_mset_peek (mset, nc_hicosmo_id ()));
+  guint i;
+
+  for (i = 0; i < diag->np; i++)
+  {
+    const gdouble z = _ncm_data_fisher_test_z (diag->np, i);
+    ncm_vector_set (sigma, i, _NCM_DATA_FISHER_TEST_FRAC * (1.0 + z) * nc_hicosmo_H (cosmo, z));
+  }
+
+  return TRUE;
+}
+
+/**
+ * ncm_data_gauss_diag_fisher_test_new:
+ * @np: number of points
+ *
+ * Returns: (transfer full): a new #NcmDataGaussDiagFisherTest with @np points.
+ */
+NcmData *
+ncm_data_gauss_diag_fisher_test_new (guint np)
+{
+  return g_object_new (NCM_TYPE_DATA_GAUSS_DIAG_FISHER_TEST,
+                       "n-points", np,
+                       NULL);
+}
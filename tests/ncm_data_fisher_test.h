@@ -0,0 +1,80 @@
+/***************************************************************************
+ *            ncm_data_fisher_test.h
+ *
+ *  Mon October 19 15:12:40 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_data_fisher_test.h
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _NCM_DATA_FISHER_TEST_H_
+#define _NCM_DATA_FISHER_TEST_H_
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define NCM_TYPE_DATA_GAUSS_COV_FISHER_TEST             (ncm_data_gauss_cov_fisher_test_get_type ())
+#define NCM_DATA_GAUSS_COV_FISHER_TEST(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), NCM_TYPE_DATA_GAUSS_COV_FISHER_TEST, NcmDataGaussCovFisherTest))
+#define NCM_DATA_GAUSS_COV_FISHER_TEST_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), NCM_TYPE_DATA_GAUSS_COV_FISHER_TEST, NcmDataGaussCovFisherTestClass))
+#define NCM_IS_DATA_GAUSS_COV_FISHER_TEST(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), NCM_TYPE_DATA_GAUSS_COV_FISHER_TEST))
+#define NCM_IS_DATA_GAUSS_COV_FISHER_TEST_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), NCM_TYPE_DATA_GAUSS_COV_FISHER_TEST))
+#define NCM_DATA_GAUSS_COV_FISHER_TEST_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), NCM_TYPE_DATA_GAUSS_COV_FISHER_TEST, NcmDataGaussCovFisherTestClass))
+
+#define NCM_TYPE_DATA_GAUSS_DIAG_FISHER_TEST             (ncm_data_gauss_diag_fisher_test_get_type ())
+#define NCM_DATA_GAUSS_DIAG_FISHER_TEST(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), NCM_TYPE_DATA_GAUSS_DIAG_FISHER_TEST, NcmDataGaussDiagFisherTest))
+#define NCM_DATA_GAUSS_DIAG_FISHER_TEST_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), NCM_TYPE_DATA_GAUSS_DIAG_FISHER_TEST, NcmDataGaussDiagFisherTestClass))
+#define NCM_IS_DATA_GAUSS_DIAG_FISHER_TEST(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), NCM_TYPE_DATA_GAUSS_DIAG_FISHER_TEST))
+#define NCM_IS_DATA_GAUSS_DIAG_FISHER_TEST_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), NCM_TYPE_DATA_GAUSS_DIAG_FISHER_TEST))
+#define NCM_DATA_GAUSS_DIAG_FISHER_TEST_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), NCM_TYPE_DATA_GAUSS_DIAG_FISHER_TEST, NcmDataGaussDiagFisherTestClass))
+
+typedef struct _NcmDataGaussCovFisherTestClass NcmDataGaussCovFisherTestClass;
+typedef struct _NcmDataGaussCovFisherTest NcmDataGaussCovFisherTest;
+typedef struct _NcmDataGaussDiagFisherTestClass NcmDataGaussDiagFisherTestClass;
+typedef struct _NcmDataGaussDiagFisherTest NcmDataGaussDiagFisherTest;
+
+struct _NcmDataGaussCovFisherTestClass
+{
+  NcmDataGaussCovClass parent_class;
+};
+
+struct _NcmDataGaussCovFisherTest
+{
+  NcmDataGaussCov parent_instance;
+};
+
+struct _NcmDataGaussDiagFisherTestClass
+{
+  NcmDataGaussDiagClass parent_class;
+};
+
+struct _NcmDataGaussDiagFisherTest
+{
+  NcmDataGaussDiag parent_instance;
+};
+
+GType ncm_data_gauss_cov_fisher_test_get_type (void) G_GNUC_CONST;
+GType ncm_data_gauss_diag_fisher_test_get_type (void) G_GNUC_CONST;
+
+NcmData *ncm_data_gauss_cov_fisher_test_new (guint np);
+NcmData *ncm_data_gauss_diag_fisher_test_new (guint np);
+
+G_END_DECLS
+
+#endif /* _NCM_DATA_FISHER_TEST_H_ */
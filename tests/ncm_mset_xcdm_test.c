@@ -0,0 +1,70 @@
+/***************************************************************************
+ *            ncm_mset_xcdm_test.c
+ *
+ *  Mon October 19 17:40:12 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_mset_xcdm_test.c
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * NcmMSet shared by the tests, a NcHICosmoDEXcdm with Omega_c and w free
+ * in a box around the fiducial values.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#undef GSL_RANGE_CHECK_OFF
+#endif /* HAVE_CONFIG_H */
+#include <numcosmo/numcosmo.h>
+#include "ncm_mset_xcdm_test.h"
+
+/**
+ * ncm_mset_xcdm_test_new:
+ * @free_H0: whether $H_0$ is also free
+ *
+ * Creates a #NcmMSet containing a #NcHICosmoDEXcdm with $\Omega_c \in [0.2, 0.3]$
+ * and $w \in [-1.2, -0.8]$ free, the free parameter map is already prepared.
+ *
+ * Returns: (transfer full): a new #NcmMSet.
+ */
+NcmMSet *
+ncm_mset_xcdm_test_new (gboolean free_H0)
+{
+  NcHICosmo *cosmo = NC_HICOSMO (nc_hicosmo_de_xcdm_new ());
+  NcmModel *model  = NCM_MODEL (cosmo);
+  NcmMSet *mset;
+
+  ncm_model_param_set_lower_bound (model, NC_HICOSMO_DE_OMEGA_C, 0.2);
+  ncm_model_param_set_upper_bound (model, NC_HICOSMO_DE_OMEGA_C, 0.3);
+  ncm_model_param_set_lower_bound (model, NC_HICOSMO_DE_XCDM_W, -1.2);
+  ncm_model_param_set_upper_bound (model, NC_HICOSMO_DE_XCDM_W, -0.8);
+
+  if (free_H0)
+    ncm_model_param_set_ftype (model, NC_HICOSMO_DE_H0, NCM_PARAM_TYPE_FREE);
+  ncm_model_param_set_ftype (model, NC_HICOSMO_DE_OMEGA_C, NCM_PARAM_TYPE_FREE);
+  ncm_model_param_set_ftype (model, NC_HICOSMO_DE_XCDM_W, NCM_PARAM_TYPE_FREE);
+
+  mset = ncm_mset_new (cosmo, NULL);
+  ncm_mset_prepare_fparam_map (mset);
+
+  nc_hicosmo_free (cosmo);
+
+  return mset;
+}
@@ -0,0 +1,37 @@
+/***************************************************************************
+ *            ncm_mset_xcdm_test.h
+ *
+ *  Mon October 19 17:40:12 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * ncm_mset_xcdm_test.h
+ * Copyright (C) 2026 Sandro Dias Pinto Vitenti <sandro@isoftware.com.br>
+ *
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _NCM_MSET_XCDM_TEST_H_
+#define _NCM_MSET_XCDM_TEST_H_
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+NcmMSet *ncm_mset_xcdm_test_new (gboolean free_H0);
+
+G_END_DECLS
+
+#endif /* _NCM_MSET_XCDM_TEST_H_ */
@@ -0,0 +1,174 @@
+/***************************************************************************
+ *            test_nc_cbe.c
+ *
+ *  Mon October 19 09:12:37 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * numcosmo
+ * Copyright (C) Sandro Dias Pinto Vitenti 2026 <sandro@isoftware.com.br>
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#undef GSL_RANGE_CHECK_OFF
+#endif /* HAVE_CONFIG_H */
+#include <numcosmo/numcosmo.h>
+
+#include <math.h>
+#include <glib.h>
+#include <glib-object.h>
+
+#define TEST_NC_CBE_LMAX 400
+
+typedef struct _TestNcCBE
+{
+  NcCBE *cbe;
+  NcHICosmo *cosmo;
+  NcHIReion *reion;
+  NcHIPrim *prim;
+} TestNcCBE;
+
+void test_nc_cbe_new (TestNcCBE *test, gconstpointer pdata);
+void test_nc_cbe_free (TestNcCBE *test, gconstpointer pdata);
+
+void test_nc_cbe_prepare_if_needed_prim (TestNcCBE *test, gconstpointer pdata);
+void test_nc_cbe_prepare_if_needed_reion (TestNcCBE *test, gconstpointer pdata);
+
+gint
+main (gint argc, gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  ncm_cfg_init ();
+  ncm_cfg_enable_gsl_err_handler ();
+
+  g_test_add ("/nc/cbe/prepare_if_needed/prim", TestNcCBE, NULL,
+              &test_nc_cbe_new,
+              &test_nc_cbe_prepare_if_needed_prim,
+              &test_nc_cbe_free);
+  g_test_add ("/nc/cbe/prepare_if_needed/reion", TestNcCBE, NULL,
+              &test_nc_cbe_new,
+              &test_nc_cbe_prepare_if_needed_reion,
+              &test_nc_cbe_free);
+
+  g_test_run ();
+}
+
+static NcCBE *
+_test_nc_cbe_cbe_new (void)
+{
+  NcCBE *cbe = nc_cbe_new ();
+
+  nc_cbe_set_target_Cls (cbe, NC_DATA_CMB_TYPE_TT);
+  nc_cbe_set_lensed_Cls (cbe, FALSE);
+  nc_cbe_set_scalar_lmax (cbe, TEST_NC_CBE_LMAX);
+
+  return cbe;
+}
+
+void
+test_nc_cbe_new (TestNcCBE *test, gconstpointer pdata)
+{
+  test->cosmo = nc_hicosmo_new_from_name (NC_TYPE_HICOSMO, "NcHICosmoDEXcdm");
+  test->reion = NC_HIREION (nc_hireion_camb_new ());
+  test->prim  = NC_HIPRIM (nc_hiprim_power_law_new ());
+
+  nc_hicosmo_de_set_wmap5_params (NC_HICOSMO_DE (test->cosmo));
+  ncm_model_orig_param_set (NCM_MODEL (test->cosmo), NC_HICOSMO_DE_XCDM_W, -1.0);
+
+  ncm_model_add_submodel (NCM_MODEL (test->cosmo), NCM_MODEL (test->reion));
+  ncm_model_add_submodel (NCM_MODEL (test->cosmo), NCM_MODEL (test->prim));
+
+  test->cbe = _test_nc_cbe_cbe_new ();
+  g_assert (NC_IS_CBE (test->cbe));
+}
+
+void
+test_nc_cbe_free (TestNcCBE *test, gconstpointer pdata)
+{
+  NcCBE *cbe = test->cbe;
+
+  nc_hiprim_free (test->prim);
+  nc_hireion_free (test->reion);
+  nc_hicosmo_free (test->cosmo);
+
+  NCM_TEST_FREE (nc_cbe_free, cbe);
+}
+
+/*
+ * Compares the spectrum obtained by re-running only part of the stages
+ * with the one obtained by a new object which runs all of them.
+ */
+static void
+_test_nc_cbe_cmp_full (TestNcCBE *test)
+{
+  NcCBE *cbe_full    = _test_nc_cbe_cbe_new ();
+  NcmVector *TT      = ncm_vector_new (TEST_NC_CBE_LMAX + 1);
+  NcmVector *TT_full = ncm_vector_new (TEST_NC_CBE_LMAX + 1);
+  guint l;
+
+  nc_cbe_prepare_if_needed (test->cbe, test->cosmo);
+  nc_cbe_get_all_Cls (test->cbe, TT, NULL, NULL, NULL);
+
+  nc_cbe_prepare (cbe_full, test->cosmo);
+  nc_cbe_get_all_Cls (cbe_full, TT_full, NULL, NULL, NULL);
+
+  for (l = 2; l <= TEST_NC_CBE_LMAX; l++)
+    ncm_assert_cmpdouble_e (ncm_vector_get (TT, l), ==, ncm_vector_get (TT_full, l), 1.0e-10);
+
+  ncm_vector_free (TT);
+  ncm_vector_free (TT_full);
+  nc_cbe_free (cbe_full);
+}
+
+void
+test_nc_cbe_prepare_if_needed_prim (TestNcCBE *test, gconstpointer pdata)
+{
+  NcmVector *TT0 = ncm_vector_new (TEST_NC_CBE_LMAX + 1);
+  NcmVector *TT1 = ncm_vector_new (TEST_NC_CBE_LMAX + 1);
+
+  nc_cbe_prepare_if_needed (test->cbe, test->cosmo);
+  nc_cbe_get_all_Cls (test->cbe, TT0, NULL, NULL, NULL);
+
+  /* Only the primordial spectrum changes, the transfer functions are re-used. */
+  ncm_model_orig_param_set (NCM_MODEL (test->prim), NC_HIPRIM_POWER_LAW_N_SA, 0.9);
+  _test_nc_cbe_cmp_full (test);
+
+  nc_cbe_get_all_Cls (test->cbe, TT1, NULL, NULL, NULL);
+  g_assert_cmpfloat (fabs (ncm_vector_get (TT1, TEST_NC_CBE_LMAX) / ncm_vector_get (TT0, TEST_NC_CBE_LMAX) - 1.0), >, 1.0e-3);
+
+  /* A background change after a partial update. */
+  ncm_model_orig_param_set (NCM_MODEL (test->cosmo), NC_HICOSMO_DE_OMEGA_C, 0.25);
+  _test_nc_cbe_cmp_full (test);
+
+  ncm_vector_free (TT0);
+  ncm_vector_free (TT1);
+}
+
+void
+test_nc_cbe_prepare_if_needed_reion (TestNcCBE *test, gconstpointer pdata)
+{
+  nc_cbe_prepare_if_needed (test->cbe, test->cosmo);
+
+  /* Only the reionization changes, the background is re-used. */
+  ncm_model_orig_param_set (NCM_MODEL (test->reion), NC_HIREION_CAMB_HII_HEII_Z, 8.0);
+  _test_nc_cbe_cmp_full (test);
+
+  /* Both the reionization and the primordial spectrum change. */
+  ncm_model_orig_param_set (NCM_MODEL (test->reion), NC_HIREION_CAMB_HII_HEII_Z, 12.0);
+  ncm_model_orig_param_set (NCM_MODEL (test->prim), NC_HIPRIM_POWER_LAW_N_SA, 1.0);
+  _test_nc_cbe_cmp_full (test);
+}
@@ -0,0 +1,292 @@
+/***************************************************************************
+ *            test_nc_data_snia_cov.c
+ *
+ *  Mon October 19 21:05:18 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * numcosmo
+ * Copyright (C) Sandro Dias Pinto Vitenti 2026 <sandro@isoftware.com.br>
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#undef GSL_RANGE_CHECK_OFF
+#endif /* HAVE_CONFIG_H */
+#include <numcosmo/numcosmo.h>
+
+#include <math.h>
+#include <glib.h>
+#include <glib-object.h>
+
+#define TEST_NC_DATA_SNIA_COV_MU_LEN 23
+#define TEST_NC_DATA_SNIA_COV_NSETS 2
+
+typedef struct _TestNcDataSNIACov
+{
+  NcDataSNIACov *snia_cov;
+  NcSNIADistCov *dcov;
+  NcDistance *dist;
+  NcmRNG *rng;
+} TestNcDataSNIACov;
+
+void test_nc_data_snia_cov_new (TestNcDataSNIACov *test, gconstpointer pdata);
+void test_nc_data_snia_cov_free (TestNcDataSNIACov *test, gconstpointer pdata);
+
+void test_nc_data_snia_cov_calc (TestNcDataSNIACov *test, gconstpointer pdata);
+void test_nc_data_snia_cov_calc_set_cov_full (TestNcDataSNIACov *test, gconstpointer pdata);
+void test_nc_data_snia_cov_share (TestNcDataSNIACov *test, gconstpointer pdata);
+
+gint
+main (gint argc, gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  ncm_cfg_init ();
+  ncm_cfg_enable_gsl_err_handler ();
+
+  g_test_add ("/nc/data_snia_cov/calc", TestNcDataSNIACov, NULL,
+              &test_nc_data_snia_cov_new,
+              &test_nc_data_snia_cov_calc,
+              &test_nc_data_snia_cov_free);
+  g_test_add ("/nc/data_snia_cov/calc/set_cov_full", TestNcDataSNIACov, NULL,
+              &test_nc_data_snia_cov_new,
+              &test_nc_data_snia_cov_calc_set_cov_full,
+              &test_nc_data_snia_cov_free);
+  g_test_add ("/nc/data_snia_cov/share", TestNcDataSNIACov, NULL,
+              &test_nc_data_snia_cov_new,
+              &test_nc_data_snia_cov_share,
+              &test_nc_data_snia_cov_free);
+
+  g_test_run ();
+}
+
+/* A random positive definite 3 mu_len x 3 mu_len matrix, A A^T plus a diagonal. */
+static NcmMatrix *
+_test_nc_data_snia_cov_cov_full_new (TestNcDataSNIACov *test)
+{
+  const guint tmu_len = 3 * TEST_NC_DATA_SNIA_COV_MU_LEN;
+  NcmMatrix *A        = ncm_matrix_new (tmu_len, tmu_len);
+  NcmMatrix *cov_full = ncm_matrix_new (tmu_len, tmu_len);
+  guint i, j;
+
+  for (i = 0; i < tmu_len; i++)
+  {
+    for (j = 0; j < tmu_len; j++)
+      ncm_matrix_set (A, i, j, ncm_rng_gaussian_gen (test->rng, 0.0, 1.0e-2));
+  }
+
+  ncm_matrix_dsyrk (cov_full, 'U', 'N', 1.0, A, 0.0);
+  for (i = 0; i < tmu_len; i++)
+    ncm_matrix_addto (cov_full, i, i, 1.0e-3);
+  ncm_matrix_copy_triangle (cov_full, 'U');
+
+  ncm_matrix_free (A);
+
+  return cov_full;
+}
+
+static NcmVector *
+_test_nc_data_snia_cov_vector_new (TestNcDataSNIACov *test, const gdouble xl, const gdouble xu)
+{
+  NcmVector *v = ncm_vector_new (TEST_NC_DATA_SNIA_COV_MU_LEN);
+  guint i;
+
+  for (i = 0; i < TEST_NC_DATA_SNIA_COV_MU_LEN; i++)
+    ncm_vector_set (v, i, ncm_rng_uniform_gen (test->rng, xl, xu));
+
+  return v;
+}
+
+void
+test_nc_data_snia_cov_new (TestNcDataSNIACov *test, gconstpointer pdata)
+{
+  const guint mu_len  = TEST_NC_DATA_SNIA_COV_MU_LEN;
+  GArray *abs_mag_set = g_array_sized_new (FALSE, FALSE, sizeof (guint32), mu_len);
+  NcmMatrix *cov_full;
+  NcmVector *z_cmb, *v;
+  guint i;
+
+  test->rng      = ncm_rng_seeded_new (NULL, g_test_rand_int ());
+  test->dist     = nc_distance_new (2.0);
+  test->dcov     = nc_snia_dist_cov_new (test->dist, TEST_NC_DATA_SNIA_COV_NSETS);
+  test->snia_cov = NC_DATA_SNIA_COV (nc_data_snia_cov_new (FALSE));
+
+  ncm_data_gauss_cov_set_size (NCM_DATA_GAUSS_COV (test->snia_cov), mu_len);
+
+  z_cmb = _test_nc_data_snia_cov_vector_new (test, 0.01, 1.2);
+  nc_data_snia_cov_set_z_cmb (test->snia_cov, z_cmb);
+  nc_data_snia_cov_set_z_he (test->snia_cov, z_cmb);
+
+  v = _test_nc_data_snia_cov_vector_new (test, 1.0e-3, 1.0e-2);
+  nc_data_snia_cov_set_sigma_z (test->snia_cov, v);
+  ncm_vector_free (v);
+
+  v = _test_nc_data_snia_cov_vector_new (test, 20.0, 25.0);
+  nc_data_snia_cov_set_mag (test->snia_cov, v);
+  ncm_vector_free (v);
+
+  v = _test_nc_data_snia_cov_vector_new (test, -1.0, 1.0);
+  nc_data_snia_cov_set_width (test->snia_cov, v);
+  ncm_vector_free (v);
+
+  v = _test_nc_data_snia_cov_vector_new (test, -0.1, 0.1);
+  nc_data_snia_cov_set_colour (test->snia_cov, v);
+  ncm_vector_free (v);
+
+  v = _test_nc_data_snia_cov_vector_new (test, 9.0, 11.0);
+  nc_data_snia_cov_set_thirdpar (test->snia_cov, v);
+  ncm_vector_free (v);
+
+  for (i = 0; i < mu_len; i++)
+  {
+    const guint32 set_i = i % TEST_NC_DATA_SNIA_COV_NSETS;
+    g_array_append_val (abs_mag_set, set_i);
+  }
+  nc_data_snia_cov_set_abs_mag_set (test->snia_cov, abs_mag_set);
+
+  cov_full = _test_nc_data_snia_cov_cov_full_new (test);
+  nc_data_snia_cov_set_cov_full (test->snia_cov, cov_full);
+
+  g_assert (NCM_DATA (test->snia_cov)->init);
+
+  ncm_model_orig_param_set (NCM_MODEL (test->dcov), NC_SNIA_DIST_COV_ALPHA, 1.3);
+  ncm_model_orig_param_set (NCM_MODEL (test->dcov), NC_SNIA_DIST_COV_BETA, 3.2);
+  for (i = 0; i < TEST_NC_DATA_SNIA_COV_NSETS; i++)
+    ncm_model_orig_vparam_set (NCM_MODEL (test->dcov), NC_SNIA_DIST_COV_LNSIGMA_INT, i, log (0.1 + 0.02 * i));
+
+  ncm_matrix_free (cov_full);
+  g_array_unref (abs_mag_set);
+  ncm_vector_free (z_cmb);
+}
+
+void
+test_nc_data_snia_cov_free (TestNcDataSNIACov *test, gconstpointer pdata)
+{
+  NcDataSNIACov *snia_cov = test->snia_cov;
+
+  nc_snia_dist_cov_free (test->dcov);
+  nc_distance_free (test->dist);
+  ncm_rng_free (test->rng);
+
+  NCM_TEST_FREE (ncm_data_free, NCM_DATA (snia_cov));
+}
+
+/*
+ * Compares the covariance assembled by nc_snia_dist_cov_calc() with the
+ * one computed directly from the mag/width/colour blocks of cov_full.
+ */
+static void
+_test_nc_data_snia_cov_cmp_cov_full (TestNcDataSNIACov *test, NcmMatrix *cov_full)
+{
+  const guint mu_len    = TEST_NC_DATA_SNIA_COV_MU_LEN;
+  const gdouble alpha   = ncm_model_orig_param_get (NCM_MODEL (test->dcov), NC_SNIA_DIST_COV_ALPHA);
+  const gdouble beta    = ncm_model_orig_param_get (NCM_MODEL (test->dcov), NC_SNIA_DIST_COV_BETA);
+  const gdouble coef[3] = {1.0, alpha, -beta};
+  NcmMatrix *cov        = ncm_matrix_new (mu_len, mu_len);
+  guint i, j, a, b;
+
+  nc_snia_dist_cov_calc (test->dcov, test->snia_cov, cov);
+
+  for (i = 0; i < mu_len; i++)
+  {
+    for (j = 0; j < mu_len; j++)
+    {
+      gdouble cov_ij = (i == j) ? nc_snia_dist_cov_extra_var (test->dcov, test->snia_cov, i) : 0.0;
+
+      for (a = 0; a < 3; a++)
+      {
+        for (b = 0; b < 3; b++)
+          cov_ij += coef[a] * coef[b] * ncm_matrix_get (cov_full, a * mu_len + i, b * mu_len + j);
+      }
+
+      ncm_assert_cmpdouble_e (ncm_matrix_get (cov, i, j), ==, cov_ij, 1.0e-12);
+    }
+  }
+
+  ncm_matrix_free (cov);
+}
+
+void
+test_nc_data_snia_cov_calc (TestNcDataSNIACov *test, gconstpointer pdata)
+{
+  _test_nc_data_snia_cov_cmp_cov_full (test, nc_data_snia_cov_peek_cov_full (test->snia_cov));
+
+  ncm_model_orig_param_set (NCM_MODEL (test->dcov), NC_SNIA_DIST_COV_ALPHA, 0.2);
+  ncm_model_orig_param_set (NCM_MODEL (test->dcov), NC_SNIA_DIST_COV_BETA, -1.1);
+  _test_nc_data_snia_cov_cmp_cov_full (test, nc_data_snia_cov_peek_cov_full (test->snia_cov));
+}
+
+void
+test_nc_data_snia_cov_calc_set_cov_full (TestNcDataSNIACov *test, gconstpointer pdata)
+{
+  NcmMatrix *cov_full = _test_nc_data_snia_cov_cov_full_new (test);
+
+  _test_nc_data_snia_cov_cmp_cov_full (test, nc_data_snia_cov_peek_cov_full (test->snia_cov));
+
+  /* The packed components must follow a new cov_full. */
+  nc_data_snia_cov_set_cov_full (test->snia_cov, cov_full);
+  _test_nc_data_snia_cov_cmp_cov_full (test, cov_full);
+
+  ncm_matrix_free (cov_full);
+}
+
+void
+test_nc_data_snia_cov_share (TestNcDataSNIACov *test, gconstpointer pdata)
+{
+  const guint mu_len  = TEST_NC_DATA_SNIA_COV_MU_LEN;
+  NcmSerialize *ser   = ncm_serialize_new (NCM_SERIALIZE_OPT_CLEAN_DUP);
+  NcmMatrix *cov_full = nc_data_snia_cov_peek_cov_full (test->snia_cov);
+  NcmMatrix *inv_cov_full;
+  NcDataSNIACov *snia_dup;
+  guint i, j;
+
+  g_object_set (test->snia_cov, "has-complete-cov", TRUE, NULL);
+  nc_data_snia_cov_set_cov_full (test->snia_cov, cov_full);
+
+  /* The inverse of the mag-mag block in the upper triangle of inv_cov_mm. */
+  inv_cov_full = ncm_matrix_dup (cov_full);
+  g_assert_cmpint (ncm_matrix_cholesky_decomp (inv_cov_full, 'U'), ==, 0);
+  g_assert_cmpint (ncm_matrix_cholesky_inverse (inv_cov_full, 'U'), ==, 0);
+
+  for (i = 0; i < mu_len; i++)
+  {
+    for (j = i; j < mu_len; j++)
+      ncm_assert_cmpdouble_e (ncm_matrix_get (test->snia_cov->inv_cov_mm, i, j), ==, ncm_matrix_get (inv_cov_full, i, j), 1.0e-10);
+  }
+
+  /* A copy made after sharing the payload reuses everything derived from cov_full. */
+  ncm_data_share_payload (NCM_DATA (test->snia_cov), ser);
+  snia_dup = NC_DATA_SNIA_COV (ncm_data_dup (NCM_DATA (test->snia_cov), ser));
+  ncm_serialize_reset (ser);
+
+  g_assert (snia_dup->has_complete_cov);
+  g_assert (snia_dup->cov_full == test->snia_cov->cov_full);
+  g_assert (snia_dup->cov_packed == test->snia_cov->cov_packed);
+  g_assert (snia_dup->inv_cov_mm == test->snia_cov->inv_cov_mm);
+
+  /* A new cov_full in the copy leaves the original untouched. */
+  cov_full = _test_nc_data_snia_cov_cov_full_new (test);
+  nc_data_snia_cov_set_cov_full (snia_dup, cov_full);
+
+  g_assert (snia_dup->cov_packed != test->snia_cov->cov_packed);
+  g_assert (snia_dup->inv_cov_mm != test->snia_cov->inv_cov_mm);
+  _test_nc_data_snia_cov_cmp_cov_full (test, nc_data_snia_cov_peek_cov_full (test->snia_cov));
+
+  ncm_matrix_free (cov_full);
+  ncm_matrix_free (inv_cov_full);
+  ncm_data_free (NCM_DATA (snia_dup));
+  ncm_serialize_free (ser);
+}
@@ -0,0 +1,332 @@
+/***************************************************************************
+ *            test_ncm_data_emu.c
+ *
+ *  Tue October 20 11:02:18 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * numcosmo
+ * Copyright (C) Sandro Dias Pinto Vitenti 2026 <sandro@isoftware.com.br>
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#undef GSL_RANGE_CHECK_OFF
+#endif /* HAVE_CONFIG_H */
+#include <numcosmo/numcosmo.h>
+
+#include <math.h>
+#include <glib.h>
+#include <glib-object.h>
+
+#include "ncm_mset_xcdm_test.h"
+
+typedef struct _TestNcmDataEmu
+{
+  NcmDataEmu *emu;
+  NcmData *data;
+  NcmMSet *mset;
+  NcmRNG *rng;
+} TestNcmDataEmu;
+
+void test_ncm_data_emu_new (TestNcmDataEmu *test, gconstpointer pdata);
+void test_ncm_data_emu_free (TestNcmDataEmu *test, gconstpointer pdata);
+
+void test_ncm_data_emu_train (TestNcmDataEmu *test, gconstpointer pdata);
+void test_ncm_data_emu_train_mt (TestNcmDataEmu *test, gconstpointer pdata);
+void test_ncm_data_emu_train_at (TestNcmDataEmu *test, gconstpointer pdata);
+void test_ncm_data_emu_fallback (TestNcmDataEmu *test, gconstpointer pdata);
+void test_ncm_data_emu_refine (TestNcmDataEmu *test, gconstpointer pdata);
+void test_ncm_data_emu_serialize (TestNcmDataEmu *test, gconstpointer pdata);
+
+gint
+main (gint argc, gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  ncm_cfg_init ();
+  ncm_cfg_enable_gsl_err_handler ();
+
+  g_test_add ("/ncm/data_emu/train", TestNcmDataEmu, NULL,
+              &test_ncm_data_emu_new,
+              &test_ncm_data_emu_train,
+              &test_ncm_data_emu_free);
+  g_test_add ("/ncm/data_emu/train/mt", TestNcmDataEmu, NULL,
+              &test_ncm_data_emu_new,
+              &test_ncm_data_emu_train_mt,
+              &test_ncm_data_emu_free);
+  g_test_add ("/ncm/data_emu/train_at", TestNcmDataEmu, NULL,
+              &test_ncm_data_emu_new,
+              &test_ncm_data_emu_train_at,
+              &test_ncm_data_emu_free);
+  g_test_add ("/ncm/data_emu/fallback", TestNcmDataEmu, NULL,
+              &test_ncm_data_emu_new,
+              &test_ncm_data_emu_fallback,
+              &test_ncm_data_emu_free);
+  g_test_add ("/ncm/data_emu/refine", TestNcmDataEmu, NULL,
+              &test_ncm_data_emu_new,
+              &test_ncm_data_emu_refine,
+              &test_ncm_data_emu_free);
+  g_test_add ("/ncm/data_emu/serialize", TestNcmDataEmu, NULL,
+              &test_ncm_data_emu_new,
+              &test_ncm_data_emu_serialize,
+              &test_ncm_data_emu_free);
+
+  g_test_run ();
+}
+
+void
+test_ncm_data_emu_new (TestNcmDataEmu *test, gconstpointer pdata)
+{
+  NcDistance *dist = nc_distance_new (2.0);
+
+  test->mset = ncm_mset_xcdm_test_new (FALSE);
+  test->data = NCM_DATA (nc_data_bao_rdv_new_from_id (dist, NC_DATA_BAO_RDV_PERCIVAL2010));
+  test->emu  = ncm_data_emu_new (test->data, 1.0e-2);
+  test->rng  = ncm_rng_seeded_new (NULL, g_test_rand_int_range (1, G_MAXINT32));
+
+  g_assert (NCM_IS_DATA_EMU (test->emu));
+  g_assert_cmpuint (ncm_data_emu_get_ntrain (test->emu), ==, 0);
+
+  nc_distance_free (dist);
+}
+
+void
+test_ncm_data_emu_free (TestNcmDataEmu *test, gconstpointer pdata)
+{
+  NcmDataEmu *emu = test->emu;
+
+  ncm_data_clear (&test->data);
+  ncm_mset_clear (&test->mset);
+  ncm_rng_clear (&test->rng);
+
+  NCM_TEST_FREE (ncm_data_emu_free, emu);
+}
+
+/*
+ * Sets the free parameters of the test NcmMSet to the i-th training point,
+ * the training set is read through the object properties. Returns the
+ * training value.
+ */
+static gdouble
+_test_ncm_data_emu_set_train_point (TestNcmDataEmu *test, guint i)
+{
+  const guint dim = ncm_mset_fparams_len (test->mset);
+  NcmVector *x    = ncm_vector_new (dim);
+  NcmMatrix *tx   = NULL;
+  NcmVector *ty   = NULL;
+  NcmVector *lb   = NULL;
+  NcmVector *ub   = NULL;
+  gdouble y;
+  guint j;
+
+  g_object_get (test->emu,
+                "train-x", &tx,
+                "train-y", &ty,
+                "lower-bounds", &lb,
+                "upper-bounds", &ub,
+                NULL);
+
+  g_assert_cmpuint (ncm_matrix_ncols (tx), ==, dim);
+  g_assert_cmpuint (i, <, ncm_vector_len (ty));
+
+  for (j = 0; j < dim; j++)
+  {
+    const gdouble lb_j = ncm_vector_get (lb, j);
+    const gdouble ub_j = ncm_vector_get (ub, j);
+    ncm_vector_set (x, j, lb_j + ncm_matrix_get (tx, i, j) * (ub_j - lb_j));
+  }
+  ncm_mset_fparams_set_vector (test->mset, x);
+  y = ncm_vector_get (ty, i);
+
+  ncm_matrix_free (tx);
+  ncm_vector_free (ty);
+  ncm_vector_free (lb);
+  ncm_vector_free (ub);
+  ncm_vector_free (x);
+
+  return y;
+}
+
+static void
+_test_ncm_data_emu_check_train (TestNcmDataEmu *test)
+{
+  gdouble max_sd = 0.0;
+  guint i;
+
+  /* The GP interpolates the training set. */
+  for (i = 0; i < ncm_data_emu_get_ntrain (test->emu); i++)
+  {
+    const gdouble y = _test_ncm_data_emu_set_train_point (test, i);
+    gdouble m2lnL, sd;
+
+    ncm_data_emu_predict (test->emu, test->mset, &m2lnL, &sd);
+
+    ncm_assert_cmpdouble_e (m2lnL, ==, y, 1.0e-3);
+    max_sd = GSL_MAX (max_sd, sd);
+  }
+  g_assert_cmpfloat (max_sd, <, 1.0e-2 * ncm_data_emu_get_amplitude (test->emu));
+}
+
+void
+test_ncm_data_emu_train (TestNcmDataEmu *test, gconstpointer pdata)
+{
+  ncm_data_emu_train (test->emu, test->mset, 40, test->rng);
+
+  g_assert_cmpuint (ncm_data_emu_get_ntrain (test->emu), ==, 40);
+  _test_ncm_data_emu_check_train (test);
+}
+
+void
+test_ncm_data_emu_train_mt (TestNcmDataEmu *test, gconstpointer pdata)
+{
+  guint i;
+
+  ncm_data_emu_set_nthreads (test->emu, 2);
+  ncm_data_emu_train (test->emu, test->mset, 40, test->rng);
+
+  g_assert_cmpuint (ncm_data_emu_get_ntrain (test->emu), ==, 40);
+  _test_ncm_data_emu_check_train (test);
+
+  /* Each stored value must be the true likelihood at its point. */
+  for (i = 0; i < 5; i++)
+  {
+    const gdouble y = _test_ncm_data_emu_set_train_point (test, i);
+    gdouble m2lnL;
+
+    ncm_data_m2lnL_val (test->data, test->mset, &m2lnL);
+    ncm_assert_cmpdouble_e (m2lnL, ==, y, 1.0e-12);
+  }
+}
+
+void
+test_ncm_data_emu_train_at (TestNcmDataEmu *test, gconstpointer pdata)
+{
+  NcmSerialize *ser = ncm_serialize_new (NCM_SERIALIZE_OPT_CLEAN_DUP);
+  const gdouble Omega_c[] = {0.2123, 0.2456, 0.2789};
+  const gdouble w[]       = {-1.1234, -0.9567, -0.8321};
+  NcmDataEmu *emu_dup;
+  guint i;
+
+  ncm_data_emu_train (test->emu, test->mset, 20, test->rng);
+
+  /* Three points are less than 25%, the decomposition is only extended. */
+  for (i = 0; i < G_N_ELEMENTS (Omega_c); i++)
+  {
+    ncm_mset_param_set (test->mset, nc_hicosmo_id (), NC_HICOSMO_DE_OMEGA_C, Omega_c[i]);
+    ncm_mset_param_set (test->mset, nc_hicosmo_id (), NC_HICOSMO_DE_XCDM_W, w[i]);
+    ncm_data_emu_train_at (test->emu, test->mset);
+  }
+  g_assert_cmpuint (ncm_data_emu_get_ntrain (test->emu), ==, 20 + G_N_ELEMENTS (Omega_c));
+  _test_ncm_data_emu_check_train (test);
+
+  /* The copy decomposes the same training set from scratch. */
+  emu_dup = NCM_DATA_EMU (ncm_data_dup (NCM_DATA (test->emu), ser));
+
+  for (i = 0; i < 10; i++)
+  {
+    gdouble m2lnL, sd, m2lnL_dup, sd_dup;
+
+    ncm_mset_param_set (test->mset, nc_hicosmo_id (), NC_HICOSMO_DE_OMEGA_C, 0.2 + 0.01 * i);
+    ncm_mset_param_set (test->mset, nc_hicosmo_id (), NC_HICOSMO_DE_XCDM_W, -1.2 + 0.04 * i);
+
+    ncm_data_emu_predict (test->emu, test->mset, &m2lnL, &sd);
+    ncm_data_emu_predict (emu_dup, test->mset, &m2lnL_dup, &sd_dup);
+
+    ncm_assert_cmpdouble_e (m2lnL_dup, ==, m2lnL, 1.0e-7);
+    ncm_assert_cmpdouble_e (sd_dup + 1.0, ==, sd + 1.0, 1.0e-7);
+  }
+
+  /* Resampling the data keeps the training set. */
+  ncm_data_resample (NCM_DATA (test->emu), test->mset, test->rng);
+  g_assert_cmpuint (ncm_data_emu_get_ntrain (test->emu), ==, 20 + G_N_ELEMENTS (Omega_c));
+
+  ncm_data_emu_free (emu_dup);
+  ncm_serialize_free (ser);
+}
+
+void
+test_ncm_data_emu_fallback (TestNcmDataEmu *test, gconstpointer pdata)
+{
+  NcmData *data = NCM_DATA (test->emu);
+  gdouble m2lnL_emu, m2lnL;
+  guint ntrain;
+
+  ncm_data_emu_train (test->emu, test->mset, 20, test->rng);
+  ntrain = ncm_data_emu_get_ntrain (test->emu);
+
+  /* With a zero tolerance every call uses the original likelihood. */
+  ncm_data_emu_set_err_tol (test->emu, 0.0);
+  ncm_mset_param_set (test->mset, nc_hicosmo_id (), NC_HICOSMO_DE_OMEGA_C, 0.2345);
+  ncm_mset_param_set (test->mset, nc_hicosmo_id (), NC_HICOSMO_DE_XCDM_W, -0.9876);
+
+  ncm_data_m2lnL_val (data, test->mset, &m2lnL_emu);
+  ncm_data_m2lnL_val (test->data, test->mset, &m2lnL);
+
+  ncm_assert_cmpdouble_e (m2lnL_emu, ==, m2lnL, 1.0e-12);
+  ncm_assert_cmpdouble (ncm_data_emu_get_emu_ratio (test->emu), ==, 0.0);
+
+  /* The evaluation does not change the training set. */
+  g_assert_cmpuint (ncm_data_emu_get_ntrain (test->emu), ==, ntrain);
+
+  /* Once the point is added it is emulated. */
+  ncm_data_emu_train_at (test->emu, test->mset);
+  g_assert_cmpuint (ncm_data_emu_get_ntrain (test->emu), ==, ntrain + 1);
+
+  ncm_data_emu_set_err_tol (test->emu, 1.0e-2 * ncm_data_emu_get_amplitude (test->emu));
+  ncm_data_m2lnL_val (data, test->mset, &m2lnL_emu);
+
+  ncm_assert_cmpdouble_e (m2lnL_emu, ==, m2lnL, 1.0e-3);
+  g_assert_cmpuint (ncm_data_emu_get_ntrain (test->emu), ==, ntrain + 1);
+  ncm_assert_cmpdouble (ncm_data_emu_get_emu_ratio (test->emu), >, 0.0);
+}
+
+void
+test_ncm_data_emu_refine (TestNcmDataEmu *test, gconstpointer pdata)
+{
+  ncm_data_emu_train (test->emu, test->mset, 20, test->rng);
+  ncm_data_emu_refine (test->emu, test->mset, 200, 10, test->rng);
+
+  g_assert_cmpuint (ncm_data_emu_get_ntrain (test->emu), >, 20);
+  g_assert_cmpuint (ncm_data_emu_get_ntrain (test->emu), <=, 30);
+  _test_ncm_data_emu_check_train (test);
+}
+
+void
+test_ncm_data_emu_serialize (TestNcmDataEmu *test, gconstpointer pdata)
+{
+  NcmSerialize *ser = ncm_serialize_new (NCM_SERIALIZE_OPT_CLEAN_DUP);
+  NcmDataEmu *emu_dup;
+  gdouble m2lnL, sd, m2lnL_dup, sd_dup;
+
+  ncm_data_emu_train (test->emu, test->mset, 20, test->rng);
+
+  emu_dup = NCM_DATA_EMU (ncm_data_dup (NCM_DATA (test->emu), ser));
+
+  g_assert (NCM_IS_DATA_EMU (emu_dup));
+  g_assert_cmpuint (ncm_data_emu_get_ntrain (emu_dup), ==, ncm_data_emu_get_ntrain (test->emu));
+
+  ncm_mset_param_set (test->mset, nc_hicosmo_id (), NC_HICOSMO_DE_OMEGA_C, 0.2567);
+  ncm_mset_param_set (test->mset, nc_hicosmo_id (), NC_HICOSMO_DE_XCDM_W, -1.0321);
+
+  ncm_data_emu_predict (test->emu, test->mset, &m2lnL, &sd);
+  ncm_data_emu_predict (emu_dup, test->mset, &m2lnL_dup, &sd_dup);
+
+  ncm_assert_cmpdouble_e (m2lnL_dup, ==, m2lnL, 1.0e-10);
+  ncm_assert_cmpdouble_e (sd_dup + 1.0, ==, sd + 1.0, 1.0e-10);
+
+  ncm_data_emu_free (emu_dup);
+  ncm_serialize_free (ser);
+}
@@ -42,6 +42,8 @@ void test_ncm_data_gauss_cov_test_new (TestNcmDataGaussCovTest *test, gconstpoin
 void test_ncm_data_gauss_cov_test_free (TestNcmDataGaussCovTest *test, gconstpointer pdata);
 void test_ncm_data_gauss_cov_test_sanity (TestNcmDataGaussCovTest *test, gconstpointer pdata);
 void test_ncm_data_gauss_cov_test_resample (TestNcmDataGaussCovTest *test, gconstpointer pdata);
+void test_ncm_data_gauss_cov_test_lin (TestNcmDataGaussCovTest *test, gconstpointer pdata);
+void test_ncm_data_gauss_cov_test_share (TestNcmDataGaussCovTest *test, gconstpointer pdata);
 
 gint
 main (gint argc, gchar *argv[])
@@ -60,6 +62,16 @@ main (gint argc, gchar *argv[])
               &test_ncm_data_gauss_cov_test_resample,
               &test_ncm_data_gauss_cov_test_free);
 
+  g_test_add ("/ncm/data_gauss_cov_test/lin", TestNcmDataGaussCovTest, NULL,
+              &test_ncm_data_gauss_cov_test_new,
+              &test_ncm_data_gauss_cov_test_lin,
+              &test_ncm_data_gauss_cov_test_free);
+
+  g_test_add ("/ncm/data_gauss_cov_test/share", TestNcmDataGaussCovTest, NULL,
+              &test_ncm_data_gauss_cov_test_new,
+              &test_ncm_data_gauss_cov_test_share,
+              &test_ncm_data_gauss_cov_test_free);
+
   g_test_run ();
 }
 
@@ -160,3 +172,133 @@ test_ncm_data_gauss_cov_test_resample (TestNcmDataGaussCovTest *test, gconstpoin
   ncm_stats_vec_clear (&stat);
   ncm_vector_clear (&mean);
 }
+
+void
+test_ncm_data_gauss_cov_test_lin (TestNcmDataGaussCovTest *test, gconstpointer pdata)
+{
+  NcmDataGaussCov *gauss = NCM_DATA_GAUSS_COV (test->data);
+  NcmMatrix *D = ncm_matrix_new (gauss->np, 1);
+  NcmRNG *rng = ncm_rng_new (NULL);
+  const gdouble a0 = test->gcov_test->a;
+  gdouble m2lnL_0, m2lnL_p, m2lnL_m, m2lnL_min, F, h;
+  gdouble m2lnL_prof, m2lnL_prof_shift, m2lnL_marg;
+  guint i;
+
+  ncm_data_resample (test->data, NULL, rng);
+
+  /* 
+   * The unprofiled likelihood is quadratic in the constant offset a, the
+   * first pass estimates its curvature F and the second uses h ~ 1 / sqrt (F).
+   */
+  h = 1.0e-2;
+  for (i = 0; i < 2; i++)
+  {
+    ncm_data_m2lnL_val (test->data, NULL, &m2lnL_0);
+    test->gcov_test->a = a0 + h;
+    ncm_data_m2lnL_val (test->data, NULL, &m2lnL_p);
+    test->gcov_test->a = a0 - h;
+    ncm_data_m2lnL_val (test->data, NULL, &m2lnL_m);
+    test->gcov_test->a = a0;
+
+    F = (m2lnL_p + m2lnL_m - 2.0 * m2lnL_0) / (2.0 * h * h);
+    h = 1.0 / sqrt (F);
+  }
+  m2lnL_min = m2lnL_0 - gsl_pow_2 (m2lnL_p - m2lnL_m) / (8.0 * (m2lnL_p + m2lnL_m - 2.0 * m2lnL_0));
+
+  ncm_matrix_set_all (D, 1.0);
+  ncm_data_gauss_cov_set_lin_design (gauss, D);
+  g_assert (ncm_data_gauss_cov_peek_lin_design (gauss) != D);
+  g_assert_cmpuint (ncm_data_gauss_cov_lin_len (gauss), ==, 1);
+  g_assert_cmpuint (ncm_data_get_dof (test->data), ==, gauss->np - 1);
+
+  ncm_data_m2lnL_val (test->data, NULL, &m2lnL_prof);
+  ncm_assert_cmpdouble_e (m2lnL_prof, ==, m2lnL_min, 1.0e-6);
+  g_assert_cmpfloat (m2lnL_prof, <=, m2lnL_0 * (1.0 + 1.0e-10));
+
+  /* The profiled likelihood does not depend on the offset. */
+  test->gcov_test->a = a0 + 10.0 * h;
+  ncm_data_m2lnL_val (test->data, NULL, &m2lnL_prof_shift);
+  ncm_assert_cmpdouble_e (m2lnL_prof_shift, ==, m2lnL_prof, 1.0e-6);
+  test->gcov_test->a = a0;
+
+  ncm_data_gauss_cov_set_lin_marg (gauss, TRUE);
+  ncm_data_m2lnL_val (test->data, NULL, &m2lnL_marg);
+  ncm_assert_cmpdouble_e (m2lnL_marg - m2lnL_prof, ==, log (F), 1.0e-6);
+
+  /* The least squares residuals reproduce the profiled chi^2. */
+  {
+    NcmVector *f = ncm_vector_new (gauss->np);
+    gdouble chi2;
+
+    ncm_data_leastsquares_f (test->data, NULL, f);
+    gsl_blas_ddot (ncm_vector_gsl (f), ncm_vector_gsl (f), &chi2);
+    ncm_assert_cmpdouble_e (chi2, ==, m2lnL_prof, 1.0e-6);
+
+    ncm_vector_free (f);
+  }
+
+  ncm_data_gauss_cov_set_lin_design (gauss, NULL);
+  g_assert_cmpuint (ncm_data_get_dof (test->data), ==, gauss->np);
+
+  ncm_rng_free (rng);
+  ncm_matrix_free (D);
+}
+
+void
+test_ncm_data_gauss_cov_test_share (TestNcmDataGaussCovTest *test, gconstpointer pdata)
+{
+  NcmDataGaussCov *gauss = NCM_DATA_GAUSS_COV (test->data);
+  NcmSerialize *ser = ncm_serialize_new (NCM_SERIALIZE_OPT_CLEAN_DUP);
+  NcmRNG *rng = ncm_rng_new (NULL);
+  NcmData *data_dup;
+  NcmDataGaussCovTest *gcov_dup;
+  gdouble m2lnL, m2lnL_dup;
+
+  ncm_data_resample (test->data, NULL, rng);
+  ncm_data_share_payload (test->data, ser);
+  g_assert (ncm_serialize_is_shared (ser, gauss->cov));
+  g_assert (!ncm_serialize_is_shared (ser, gauss->y));
+  g_assert_cmpuint (ncm_serialize_count_shared (ser), ==, 1);
+
+  /* Sharing twice does not register a new instance. */
+  ncm_data_share_payload (test->data, ser);
+  g_assert_cmpuint (ncm_serialize_count_shared (ser), ==, 1);
+
+  data_dup = ncm_data_dup (test->data, ser);
+  gcov_dup = NCM_DATA_GAUSS_COV_TEST (data_dup);
+  ncm_serialize_reset (ser);
+
+  g_assert (NCM_DATA_GAUSS_COV (data_dup)->cov == gauss->cov);
+  g_assert (NCM_DATA_GAUSS_COV (data_dup)->y != gauss->y);
+
+  gcov_dup->a = test->gcov_test->a;
+  gcov_dup->b = test->gcov_test->b;
+  gcov_dup->c = test->gcov_test->c;
+  gcov_dup->d = test->gcov_test->d;
+
+  ncm_data_m2lnL_val (test->data, NULL, &m2lnL);
+  ncm_data_m2lnL_val (data_dup, NULL, &m2lnL_dup);
+  ncm_assert_cmpdouble_e (m2lnL_dup, ==, m2lnL, 1.0e-15);
+
+  /* The copy resamples only its own mean. */
+  ncm_data_resample (data_dup, NULL, rng);
+  ncm_data_m2lnL_val (test->data, NULL, &m2lnL_dup);
+  ncm_assert_cmpdouble_e (m2lnL_dup, ==, m2lnL, 1.0e-15);
+  ncm_data_free (data_dup);
+
+  /* The shared instances survive the reset. */
+  g_assert_cmpuint (ncm_serialize_count_shared (ser), ==, 1);
+  data_dup = ncm_data_dup (test->data, ser);
+  g_assert (NCM_DATA_GAUSS_COV (data_dup)->cov == gauss->cov);
+  ncm_data_free (data_dup);
+  ncm_serialize_reset (ser);
+
+  ncm_serialize_clear_shared (ser);
+  g_assert_cmpuint (ncm_serialize_count_shared (ser), ==, 0);
+  data_dup = ncm_data_dup (test->data, ser);
+  g_assert (NCM_DATA_GAUSS_COV (data_dup)->cov != gauss->cov);
+  ncm_data_free (data_dup);
+
+  ncm_rng_free (rng);
+  ncm_serialize_free (ser);
+}
@@ -0,0 +1,309 @@
+/***************************************************************************
+ *            test_ncm_dataset.c
+ *
+ *  Tue October 20 15:02:11 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * numcosmo
+ * Copyright (C) Sandro Dias Pinto Vitenti 2026 <sandro@isoftware.com.br>
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#undef GSL_RANGE_CHECK_OFF
+#endif /* HAVE_CONFIG_H */
+#include <numcosmo/numcosmo.h>
+
+#include <math.h>
+#include <glib.h>
+#include <glib-object.h>
+
+#include "ncm_mset_xcdm_test.h"
+
+typedef struct _TestNcmDataset
+{
+  NcmDataset *dset;
+  NcmMSet *mset;
+  NcmRNG *rng;
+} TestNcmDataset;
+
+void test_ncm_dataset_new (TestNcmDataset *test, gconstpointer pdata);
+void test_ncm_dataset_free (TestNcmDataset *test, gconstpointer pdata);
+
+void test_ncm_dataset_dependencies (TestNcmDataset *test, gconstpointer pdata);
+void test_ncm_dataset_m2lnL_mt (TestNcmDataset *test, gconstpointer pdata);
+void test_ncm_dataset_leastsquares_f_mt (TestNcmDataset *test, gconstpointer pdata);
+void test_ncm_dataset_leastsquares_f_workspace (TestNcmDataset *test, gconstpointer pdata);
+void test_ncm_dataset_resample_streams (TestNcmDataset *test, gconstpointer pdata);
+
+gint
+main (gint argc, gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  ncm_cfg_init ();
+  ncm_cfg_enable_gsl_err_handler ();
+
+  g_test_add ("/ncm/dataset/dependencies", TestNcmDataset, NULL,
+              &test_ncm_dataset_new,
+              &test_ncm_dataset_dependencies,
+              &test_ncm_dataset_free);
+  g_test_add ("/ncm/dataset/m2lnL/mt", TestNcmDataset, NULL,
+              &test_ncm_dataset_new,
+              &test_ncm_dataset_m2lnL_mt,
+              &test_ncm_dataset_free);
+  g_test_add ("/ncm/dataset/leastsquares_f/mt", TestNcmDataset, NULL,
+              &test_ncm_dataset_new,
+              &test_ncm_dataset_leastsquares_f_mt,
+              &test_ncm_dataset_free);
+  g_test_add ("/ncm/dataset/leastsquares_f/workspace", TestNcmDataset, NULL,
+              &test_ncm_dataset_new,
+              &test_ncm_dataset_leastsquares_f_workspace,
+              &test_ncm_dataset_free);
+  g_test_add ("/ncm/dataset/resample/streams", TestNcmDataset, NULL,
+              &test_ncm_dataset_new,
+              &test_ncm_dataset_resample_streams,
+              &test_ncm_dataset_free);
+
+  g_test_run ();
+}
+
+void
+test_ncm_dataset_new (TestNcmDataset *test, gconstpointer pdata)
+{
+  NcDistance *dist1 = nc_distance_new (2.0);
+  NcDistance *dist2 = nc_distance_new (2.0);
+  NcDistance *dist3 = nc_distance_new (2.0);
+  NcmData *data;
+
+  test->mset = ncm_mset_xcdm_test_new (FALSE);
+
+  test->dset = ncm_dataset_new ();
+  test->rng  = ncm_rng_seeded_new (NULL, g_test_rand_int_range (1, G_MAXINT32));
+
+  /* The first and the third share dist1, the others are independent. */
+  data = NCM_DATA (nc_data_bao_rdv_new_from_id (dist1, NC_DATA_BAO_RDV_PERCIVAL2010));
+  ncm_dataset_append_data (test->dset, data);
+  ncm_data_free (data);
+
+  data = NCM_DATA (nc_data_bao_rdv_new_from_id (dist2, NC_DATA_BAO_RDV_BEUTLER2011));
+  ncm_dataset_append_data (test->dset, data);
+  ncm_data_free (data);
+
+  data = NCM_DATA (nc_data_bao_rdv_new_from_id (dist1, NC_DATA_BAO_RDV_PADMANABHAN2012));
+  ncm_dataset_append_data (test->dset, data);
+  ncm_data_free (data);
+
+  data = NCM_DATA (nc_data_bao_dvdv_new_from_id (dist3, NC_DATA_BAO_DVDV_PERCIVAL2010));
+  ncm_dataset_append_data (test->dset, data);
+  ncm_data_free (data);
+
+  g_assert (NCM_IS_DATASET (test->dset));
+  g_assert_cmpuint (ncm_dataset_get_length (test->dset), ==, 4);
+
+  nc_distance_free (dist1);
+  nc_distance_free (dist2);
+  nc_distance_free (dist3);
+}
+
+void
+test_ncm_dataset_free (TestNcmDataset *test, gconstpointer pdata)
+{
+  NcmDataset *dset = test->dset;
+
+  ncm_mset_clear (&test->mset);
+  ncm_rng_clear (&test->rng);
+
+  NCM_TEST_FREE (ncm_dataset_free, dset);
+}
+
+static void
+_test_ncm_dataset_set_random_params (TestNcmDataset *test)
+{
+  const guint fparams_len = ncm_mset_fparams_len (test->mset);
+  guint i;
+
+  for (i = 0; i < fparams_len; i++)
+  {
+    const gdouble lb = ncm_mset_fparam_get_lower_bound (test->mset, i);
+    const gdouble ub = ncm_mset_fparam_get_upper_bound (test->mset, i);
+
+    ncm_mset_fparam_set (test->mset, i, ncm_rng_uniform_gen (test->rng, lb, ub));
+  }
+}
+
+void
+test_ncm_dataset_dependencies (TestNcmDataset *test, gconstpointer pdata)
+{
+  NcDistance *dist = nc_distance_new (2.0);
+  NcmData *data;
+
+  g_assert_cmpuint (ncm_dataset_get_nindep (test->dset), ==, 3);
+
+  /* A data using a new NcDistance is a new group. */
+  data = NCM_DATA (nc_data_bao_rdv_new_from_id (dist, NC_DATA_BAO_RDV_KAZIN2014));
+  ncm_dataset_append_data (test->dset, data);
+  g_assert_cmpuint (ncm_dataset_get_nindep (test->dset), ==, 4);
+
+  /* The same object appended twice is a single group. */
+  ncm_dataset_append_data (test->dset, data);
+  g_assert_cmpuint (ncm_dataset_get_nindep (test->dset), ==, 4);
+
+  ncm_data_free (data);
+  nc_distance_free (dist);
+}
+
+void
+test_ncm_dataset_m2lnL_mt (TestNcmDataset *test, gconstpointer pdata)
+{
+  const guint len  = ncm_dataset_get_length (test->dset);
+  NcmVector *v_s   = ncm_vector_new (len);
+  NcmVector *v_mt  = ncm_vector_new (len);
+  guint i;
+
+  ncm_dataset_set_nthreads (test->dset, 4);
+  g_assert_cmpuint (ncm_dataset_get_nthreads (test->dset), ==, 4);
+
+  for (i = 0; i < 10; i++)
+  {
+    gdouble m2lnL_s, m2lnL_mt;
+    guint j;
+
+    _test_ncm_dataset_set_random_params (test);
+
+    ncm_dataset_set_nthreads (test->dset, 0);
+    ncm_dataset_m2lnL_val (test->dset, test->mset, &m2lnL_s);
+    ncm_dataset_m2lnL_vec (test->dset, test->mset, v_s);
+
+    ncm_dataset_set_nthreads (test->dset, 4);
+    ncm_dataset_m2lnL_val (test->dset, test->mset, &m2lnL_mt);
+    ncm_dataset_m2lnL_vec (test->dset, test->mset, v_mt);
+
+    /* The partial sums are combined in the same order. */
+    g_assert_cmpfloat (m2lnL_s, ==, m2lnL_mt);
+    for (j = 0; j < len; j++)
+      g_assert_cmpfloat (ncm_vector_get (v_s, j), ==, ncm_vector_get (v_mt, j));
+  }
+
+  ncm_vector_free (v_s);
+  ncm_vector_free (v_mt);
+}
+
+void
+test_ncm_dataset_leastsquares_f_mt (TestNcmDataset *test, gconstpointer pdata)
+{
+  const guint n   = ncm_dataset_get_n (test->dset);
+  NcmVector *f_s  = ncm_vector_new (n);
+  NcmVector *f_mt = ncm_vector_new (n);
+  guint i;
+
+  for (i = 0; i < 10; i++)
+  {
+    guint j;
+
+    _test_ncm_dataset_set_random_params (test);
+
+    ncm_dataset_set_nthreads (test->dset, 0);
+    ncm_dataset_leastsquares_f (test->dset, test->mset, f_s);
+
+    ncm_dataset_set_nthreads (test->dset, 4);
+    ncm_dataset_leastsquares_f (test->dset, test->mset, f_mt);
+
+    for (j = 0; j < n; j++)
+      g_assert_cmpfloat (ncm_vector_get (f_s, j), ==, ncm_vector_get (f_mt, j));
+  }
+
+  ncm_vector_free (f_s);
+  ncm_vector_free (f_mt);
+}
+
+void
+test_ncm_dataset_leastsquares_f_workspace (TestNcmDataset *test, gconstpointer pdata)
+{
+  const guint len  = ncm_dataset_get_length (test->dset);
+  const guint n    = ncm_dataset_get_n (test->dset);
+  NcmVector *f     = ncm_vector_new (n);
+  NcmWorkspace *ws = ncm_workspace_peek ();
+  const guint ntests = 10;
+  guint i;
+
+  ncm_dataset_set_nthreads (test->dset, 0);
+  ncm_dataset_leastsquares_f (test->dset, test->mset, f);
+
+  /* After the first call the temporaries must all come from the workspace. */
+  ncm_workspace_reset_stats (ws);
+  for (i = 0; i < ntests; i++)
+  {
+    _test_ncm_dataset_set_random_params (test);
+    ncm_dataset_leastsquares_f (test->dset, test->mset, f);
+  }
+
+  g_assert_cmpuint (ncm_workspace_get_nalloc (ws), ==, 0);
+  g_assert_cmpuint (ncm_workspace_get_nborrow (ws), ==, ntests * len);
+  g_assert_cmpuint (ncm_workspace_depth (ws), ==, 0);
+
+  ncm_vector_free (f);
+}
+
+void
+test_ncm_dataset_resample_streams (TestNcmDataset *test, gconstpointer pdata)
+{
+  const guint len    = ncm_dataset_get_length (test->dset);
+  const gulong seed  = g_test_rand_int_range (1, G_MAXINT32);
+  NcmRNG *rng_a      = ncm_rng_seeded_new (NULL, seed);
+  NcmRNG *rng_b      = ncm_rng_seeded_new (NULL, seed);
+  NcmVector *m2lnL_i = ncm_vector_new (len);
+  guint i;
+
+  /* By default the data draw in order from the generator passed. */
+  g_assert (!ncm_dataset_get_rng_streams (test->dset));
+  ncm_dataset_resample (test->dset, test->mset, rng_a);
+
+  for (i = 0; i < len; i++)
+    ncm_dataset_m2lnL_i_val (test->dset, test->mset, i, ncm_vector_ptr (m2lnL_i, i));
+
+  for (i = 0; i < len; i++)
+  {
+    gdouble m2lnL;
+
+    ncm_data_resample (ncm_dataset_peek_data (test->dset, i), test->mset, rng_b);
+    ncm_dataset_m2lnL_i_val (test->dset, test->mset, i, &m2lnL);
+    g_assert_cmpfloat (m2lnL, ==, ncm_vector_get (m2lnL_i, i));
+  }
+  g_assert_cmpuint (gsl_rng_get (rng_a->r), ==, gsl_rng_get (rng_b->r));
+
+  /* With streams the realization depends only on the parent state, which advances by one draw. */
+  ncm_dataset_set_rng_streams (test->dset, TRUE);
+  ncm_dataset_resample (test->dset, test->mset, rng_a);
+
+  for (i = 0; i < len; i++)
+    ncm_dataset_m2lnL_i_val (test->dset, test->mset, i, ncm_vector_ptr (m2lnL_i, i));
+
+  ncm_dataset_resample (test->dset, test->mset, rng_b);
+
+  for (i = 0; i < len; i++)
+  {
+    gdouble m2lnL;
+
+    ncm_dataset_m2lnL_i_val (test->dset, test->mset, i, &m2lnL);
+    g_assert_cmpfloat (m2lnL, ==, ncm_vector_get (m2lnL_i, i));
+  }
+  g_assert_cmpuint (gsl_rng_get (rng_a->r), ==, gsl_rng_get (rng_b->r));
+
+  ncm_vector_free (m2lnL_i);
+  ncm_rng_free (rng_a);
+  ncm_rng_free (rng_b);
+}
@@ -0,0 +1,440 @@
+/***************************************************************************
+ *            test_ncm_fisher.c
+ *
+ *  Tue October 20 16:42:05 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * numcosmo
+ * Copyright (C) Sandro Dias Pinto Vitenti 2026 <sandro@isoftware.com.br>
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#undef GSL_RANGE_CHECK_OFF
+#endif /* HAVE_CONFIG_H */
+#include <numcosmo/numcosmo.h>
+
+#include <math.h>
+#include <glib.h>
+#include <glib-object.h>
+
+#include "ncm_data_fisher_test.h"
+#include "ncm_mset_xcdm_test.h"
+
+typedef struct _TestNcmFisher
+{
+  NcmFisher *fisher;
+  NcmDataset *dset;
+  NcmMSet *mset;
+  NcmData *data_cov;
+  NcmData *data_diag;
+  NcmMatrix *cov0;
+  NcmVector *sigma0;
+} TestNcmFisher;
+
+void test_ncm_fisher_new (TestNcmFisher *test, gconstpointer pdata);
+void test_ncm_fisher_new_cov_func (TestNcmFisher *test, gconstpointer pdata);
+void test_ncm_fisher_free (TestNcmFisher *test, gconstpointer pdata);
+
+void test_ncm_fisher_hessian (TestNcmFisher *test, gconstpointer pdata);
+void test_ncm_fisher_lin (TestNcmFisher *test, gconstpointer pdata);
+void test_ncm_fisher_wmean (TestNcmFisher *test, gconstpointer pdata);
+void test_ncm_fisher_mt (TestNcmFisher *test, gconstpointer pdata);
+void test_ncm_fisher_cov_func (TestNcmFisher *test, gconstpointer pdata);
+
+gint
+main (gint argc, gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  ncm_cfg_init ();
+  ncm_cfg_enable_gsl_err_handler ();
+
+  g_test_add ("/ncm/fisher/hessian", TestNcmFisher, NULL,
+              &test_ncm_fisher_new,
+              &test_ncm_fisher_hessian,
+              &test_ncm_fisher_free);
+  g_test_add ("/ncm/fisher/lin", TestNcmFisher, NULL,
+              &test_ncm_fisher_new,
+              &test_ncm_fisher_lin,
+              &test_ncm_fisher_free);
+  g_test_add ("/ncm/fisher/wmean", TestNcmFisher, NULL,
+              &test_ncm_fisher_new,
+              &test_ncm_fisher_wmean,
+              &test_ncm_fisher_free);
+  g_test_add ("/ncm/fisher/mt", TestNcmFisher, NULL,
+              &test_ncm_fisher_new,
+              &test_ncm_fisher_mt,
+              &test_ncm_fisher_free);
+  g_test_add ("/ncm/fisher/cov_func", TestNcmFisher, NULL,
+              &test_ncm_fisher_new_cov_func,
+              &test_ncm_fisher_cov_func,
+              &test_ncm_fisher_free);
+
+  g_test_run ();
+}
+
+/* Data equal to the fiducial means, the fiducial point is the best fit. */
+static void
+_test_ncm_fisher_set_fiducial_data (TestNcmFisher *test)
+{
+  NcmVector *mu_cov  = ncm_vector_new (ncm_data_get_length (test->data_cov));
+  NcmVector *mu_diag = ncm_vector_new (ncm_data_get_length (test->data_diag));
+
+  ncm_data_gauss_cov_eval_mean (NCM_DATA_GAUSS_COV (test->data_cov), test->mset, mu_cov);
+  ncm_data_gauss_diag_eval_mean (NCM_DATA_GAUSS_DIAG (test->data_diag), test->mset, mu_diag);
+
+  g_object_set (test->data_cov, "mean", mu_cov, NULL);
+  g_object_set (test->data_diag, "mean", mu_diag, NULL);
+
+  ncm_vector_free (mu_cov);
+  ncm_vector_free (mu_diag);
+}
+
+void
+test_ncm_fisher_new (TestNcmFisher *test, gconstpointer pdata)
+{
+  NcDistance *dist = nc_distance_new (2.0);
+
+  test->mset   = ncm_mset_xcdm_test_new (TRUE);
+  test->cov0   = NULL;
+  test->sigma0 = NULL;
+
+  test->data_cov  = NCM_DATA (nc_data_bao_dhr_dar_new_from_id (dist, NC_DATA_BAO_DHR_DAR_SDSS_DR11_2015));
+  test->data_diag = NCM_DATA (nc_data_hubble_new_from_id (NC_DATA_HUBBLE_SIMON2005));
+
+  g_assert (NCM_IS_DATA_GAUSS_COV (test->data_cov));
+  g_assert (NCM_IS_DATA_GAUSS_DIAG (test->data_diag));
+
+  _test_ncm_fisher_set_fiducial_data (test);
+
+  test->dset = ncm_dataset_new ();
+  ncm_dataset_append_data (test->dset, test->data_cov);
+  ncm_dataset_append_data (test->dset, test->data_diag);
+
+  test->fisher = ncm_fisher_new (test->dset, test->mset);
+  g_assert (NCM_IS_FISHER (test->fisher));
+  g_assert_cmpuint (ncm_fisher_get_richardson_levels (test->fisher), ==, NCM_FISHER_DEFAULT_RICHARDSON_LEVELS);
+
+  nc_distance_free (dist);
+}
+
+void
+test_ncm_fisher_new_cov_func (TestNcmFisher *test, gconstpointer pdata)
+{
+  test->mset = ncm_mset_xcdm_test_new (TRUE);
+
+  /* Both the mean and the covariance depend on the cosmology. */
+  test->data_cov  = ncm_data_gauss_cov_fisher_test_new (12);
+  test->data_diag = ncm_data_gauss_diag_fisher_test_new (10);
+
+  g_assert (ncm_data_gauss_cov_has_cov_func (NCM_DATA_GAUSS_COV (test->data_cov)));
+  g_assert (ncm_data_gauss_diag_has_sigma_func (NCM_DATA_GAUSS_DIAG (test->data_diag)));
+
+  /* -2lnL includes ln det C, whose second derivatives enter the Fisher matrix. */
+  g_object_set (test->data_cov, "use-norma", TRUE, NULL);
+
+  _test_ncm_fisher_set_fiducial_data (test);
+  ncm_data_set_init (test->data_cov, TRUE);
+  ncm_data_set_init (test->data_diag, TRUE);
+
+  /* Fiducial covariances, the data are distributed with these. */
+  test->cov0   = ncm_matrix_new (ncm_data_get_length (test->data_cov), ncm_data_get_length (test->data_cov));
+  test->sigma0 = ncm_vector_new (ncm_data_get_length (test->data_diag));
+
+  ncm_data_gauss_cov_eval_cov (NCM_DATA_GAUSS_COV (test->data_cov), test->mset, test->cov0);
+  ncm_data_gauss_diag_eval_sigma (NCM_DATA_GAUSS_DIAG (test->data_diag), test->mset, test->sigma0);
+
+  test->dset = ncm_dataset_new ();
+  ncm_dataset_append_data (test->dset, test->data_cov);
+  ncm_dataset_append_data (test->dset, test->data_diag);
+
+  test->fisher = ncm_fisher_new (test->dset, test->mset);
+  g_assert (NCM_IS_FISHER (test->fisher));
+}
+
+void
+test_ncm_fisher_free (TestNcmFisher *test, gconstpointer pdata)
+{
+  NcmFisher *fisher = test->fisher;
+
+  ncm_data_clear (&test->data_cov);
+  ncm_data_clear (&test->data_diag);
+  ncm_dataset_clear (&test->dset);
+  ncm_mset_clear (&test->mset);
+  ncm_matrix_clear (&test->cov0);
+  ncm_vector_clear (&test->sigma0);
+
+  NCM_TEST_FREE (ncm_fisher_free, fisher);
+}
+
+/*
+ * Expected value of -2lnL over data drawn at the fiducial point. The data
+ * vectors are the fiducial means, so the value returned by the dataset is
+ * (mu - mu_0)^T C^{-1} (mu - mu_0) (plus ln det C + const when use-norma
+ * is set). For model dependent covariances the missing terms are added:
+ * tr (C^{-1} C_0) for the NcmDataGaussCov and, since NcmDataGaussDiag has
+ * no normalization, sum_i (sigma_0i^2 / sigma_i^2 + 2 ln sigma_i).
+ */
+static gdouble
+_test_ncm_fisher_m2lnL (TestNcmFisher *test, NcmVector *theta0, guint a, gdouble ha, guint b, gdouble hb)
+{
+  gdouble m2lnL;
+
+  ncm_mset_fparams_set_vector (test->mset, theta0);
+  ncm_mset_fparam_set (test->mset, a, ncm_vector_get (theta0, a) + ha);
+  ncm_mset_fparam_set (test->mset, b, ncm_mset_fparam_get (test->mset, b) + hb);
+  ncm_dataset_m2lnL_val (test->dset, test->mset, &m2lnL);
+
+  if (test->cov0 != NULL)
+  {
+    NcmMatrix *LLT = ncm_data_gauss_cov_peek_cholesky (NCM_DATA_GAUSS_COV (test->data_cov), test->mset);
+    NcmMatrix *M   = ncm_matrix_dup (test->cov0);
+    guint i;
+
+    /* M = L^{-1} C_0 L^{-T}, tr (M) = tr (C^{-1} C_0). */
+    ncm_matrix_dtrsm (LLT, 'U', 'T', 1.0, M);
+    ncm_matrix_transpose (M);
+    ncm_matrix_dtrsm (LLT, 'U', 'T', 1.0, M);
+
+    for (i = 0; i < ncm_matrix_nrows (M); i++)
+      m2lnL += ncm_matrix_get (M, i, i);
+
+    ncm_matrix_free (M);
+  }
+
+  if (test->sigma0 != NULL)
+  {
+    NcmVector *sigma = ncm_vector_dup (test->sigma0);
+    guint i;
+
+    ncm_data_gauss_diag_eval_sigma (NCM_DATA_GAUSS_DIAG (test->data_diag), test->mset, sigma);
+
+    for (i = 0; i < ncm_vector_len (sigma); i++)
+    {
+      const gdouble sigma_i = ncm_vector_get (sigma, i);
+      m2lnL += gsl_pow_2 (ncm_vector_get (test->sigma0, i) / sigma_i) + 2.0 * log (sigma_i);
+    }
+
+    ncm_vector_free (sigma);
+  }
+
+  return m2lnL;
+}
+
+/*
+ * At the fiducial point the expected -2lnL is
+ * E_0 + dtheta^T F dtheta + O(dtheta^3), so the Fisher matrix is half of
+ * its numerical Hessian. The symmetric differences cancel the odd terms.
+ */
+static void
+_test_ncm_fisher_check_hessian (TestNcmFisher *test)
+{
+  const guint nfree = ncm_mset_fparam_len (test->mset);
+  NcmMatrix *F      = ncm_fisher_peek_matrix (test->fisher);
+  NcmVector *theta0 = ncm_vector_new (nfree);
+  guint a, b;
+
+  ncm_mset_fparams_get_vector (test->mset, theta0);
+
+  for (a = 0; a < nfree; a++)
+  {
+    const gdouble ha = 1.0e-3 * ncm_mset_fparam_get_scale (test->mset, a);
+
+    for (b = a; b < nfree; b++)
+    {
+      const gdouble hb = 1.0e-3 * ncm_mset_fparam_get_scale (test->mset, b);
+      const gdouble F_ab = ncm_matrix_get (F, a, b);
+      gdouble H_ab;
+
+      if (a == b)
+      {
+        H_ab = (_test_ncm_fisher_m2lnL (test, theta0, a, +ha, a, 0.0) +
+                _test_ncm_fisher_m2lnL (test, theta0, a, -ha, a, 0.0) -
+                2.0 * _test_ncm_fisher_m2lnL (test, theta0, a, 0.0, a, 0.0)) / (ha * ha);
+      }
+      else
+      {
+        H_ab = (_test_ncm_fisher_m2lnL (test, theta0, a, +ha, b, +hb) -
+                _test_ncm_fisher_m2lnL (test, theta0, a, +ha, b, -hb) -
+                _test_ncm_fisher_m2lnL (test, theta0, a, -ha, b, +hb) +
+                _test_ncm_fisher_m2lnL (test, theta0, a, -ha, b, -hb)) / (4.0 * ha * hb);
+      }
+
+      g_assert_cmpfloat (F_ab, ==, ncm_matrix_get (F, b, a));
+      g_assert_cmpfloat (fabs (F_ab - 0.5 * H_ab), <, 1.0e-3 * sqrt (ncm_matrix_get (F, a, a) * ncm_matrix_get (F, b, b)));
+    }
+  }
+
+  ncm_mset_fparams_set_vector (test->mset, theta0);
+  ncm_vector_free (theta0);
+}
+
+static void
+_test_ncm_fisher_check_covar (TestNcmFisher *test)
+{
+  const guint nfree = ncm_mset_fparam_len (test->mset);
+  NcmMatrix *F      = ncm_fisher_peek_matrix (test->fisher);
+  NcmMatrix *covar  = ncm_fisher_peek_covar (test->fisher);
+  NcmMatrix *I      = ncm_matrix_new (nfree, nfree);
+  guint a, b;
+
+  gsl_blas_dgemm (CblasNoTrans, CblasNoTrans, 1.0, ncm_matrix_gsl (F), ncm_matrix_gsl (covar), 0.0, ncm_matrix_gsl (I));
+
+  for (a = 0; a < nfree; a++)
+  {
+    g_assert_cmpfloat (ncm_matrix_get (covar, a, a), >, 0.0);
+    for (b = 0; b < nfree; b++)
+      g_assert_cmpfloat (fabs (ncm_matrix_get (I, a, b) - ((a == b) ? 1.0 : 0.0)), <, 1.0e-8);
+  }
+
+  ncm_matrix_free (I);
+}
+
+void
+test_ncm_fisher_hessian (TestNcmFisher *test, gconstpointer pdata)
+{
+  const guint nfree = ncm_mset_fparam_len (test->mset);
+  NcmVector *err;
+  guint a;
+
+  ncm_fisher_compute (test->fisher);
+
+  g_assert (ncm_fisher_peek_matrix (test->fisher) != NULL);
+  g_assert_cmpuint (ncm_matrix_nrows (ncm_fisher_peek_matrix (test->fisher)), ==, nfree);
+  g_assert_cmpuint (ncm_matrix_nrows (ncm_fisher_peek_mean_deriv (test->fisher, 0)), ==, nfree);
+  g_assert_cmpuint (ncm_matrix_ncols (ncm_fisher_peek_mean_deriv (test->fisher, 1)), ==, ncm_data_get_length (test->data_diag));
+
+  err = ncm_fisher_peek_deriv_err (test->fisher);
+  for (a = 0; a < nfree; a++)
+    g_assert_cmpfloat (ncm_vector_get (err, a), <, 1.0e-4);
+
+  _test_ncm_fisher_check_hessian (test);
+  _test_ncm_fisher_check_covar (test);
+}
+
+void
+test_ncm_fisher_lin (TestNcmFisher *test, gconstpointer pdata)
+{
+  const guint nfree = ncm_mset_fparam_len (test->mset);
+  const guint np    = ncm_data_get_length (test->data_cov);
+  NcmMatrix *D      = ncm_matrix_new (np, 1);
+  NcmMatrix *F0;
+  guint a;
+
+  ncm_fisher_compute (test->fisher);
+  F0 = ncm_matrix_dup (ncm_fisher_peek_matrix (test->fisher));
+
+  /* An unknown offset in the covariance data, profiled in -2lnL. */
+  ncm_matrix_set_all (D, 1.0);
+  ncm_data_gauss_cov_set_lin_design (NCM_DATA_GAUSS_COV (test->data_cov), D);
+
+  ncm_fisher_compute (test->fisher);
+  _test_ncm_fisher_check_hessian (test);
+
+  /* The nuisance parameter can only remove information. */
+  for (a = 0; a < nfree; a++)
+    g_assert_cmpfloat (ncm_matrix_get (ncm_fisher_peek_matrix (test->fisher), a, a), <=, ncm_matrix_get (F0, a, a) * (1.0 + 1.0e-10));
+
+  ncm_matrix_free (D);
+  ncm_matrix_free (F0);
+}
+
+void
+test_ncm_fisher_wmean (TestNcmFisher *test, gconstpointer pdata)
+{
+  const guint nfree = ncm_mset_fparam_len (test->mset);
+  NcmMatrix *F0;
+  guint a;
+
+  ncm_fisher_compute (test->fisher);
+  F0 = ncm_matrix_dup (ncm_fisher_peek_matrix (test->fisher));
+
+  /* The weighted mean subtraction profiles a constant offset of the diagonal data. */
+  g_object_set (test->data_diag, "w-mean", TRUE, NULL);
+
+  ncm_fisher_compute (test->fisher);
+  _test_ncm_fisher_check_hessian (test);
+  _test_ncm_fisher_check_covar (test);
+
+  for (a = 0; a < nfree; a++)
+    g_assert_cmpfloat (ncm_matrix_get (ncm_fisher_peek_matrix (test->fisher), a, a), <=, ncm_matrix_get (F0, a, a) * (1.0 + 1.0e-10));
+
+  ncm_matrix_free (F0);
+}
+
+void
+test_ncm_fisher_mt (TestNcmFisher *test, gconstpointer pdata)
+{
+  const guint nfree = ncm_mset_fparam_len (test->mset);
+  NcmMatrix *F0;
+  NcmMatrix *F;
+  guint nthreads, a, b;
+
+  ncm_fisher_compute (test->fisher);
+  F0 = ncm_matrix_dup (ncm_fisher_peek_matrix (test->fisher));
+
+  /* One thread per parameter, then fewer threads than parameters. */
+  for (nthreads = nfree; nthreads > 1; nthreads--)
+  {
+    ncm_fisher_set_nthreads (test->fisher, nthreads);
+    ncm_fisher_compute (test->fisher);
+    F = ncm_fisher_peek_matrix (test->fisher);
+
+    /* The same evaluations in a different order. */
+    for (a = 0; a < nfree; a++)
+    {
+      for (b = 0; b < nfree; b++)
+        g_assert_cmpfloat (fabs (ncm_matrix_get (F, a, b) - ncm_matrix_get (F0, a, b)), <=, 1.0e-12 * sqrt (ncm_matrix_get (F0, a, a) * ncm_matrix_get (F0, b, b)));
+    }
+
+    _test_ncm_fisher_check_covar (test);
+  }
+
+  ncm_matrix_free (F0);
+}
+
+void
+test_ncm_fisher_cov_func (TestNcmFisher *test, gconstpointer pdata)
+{
+  const guint nfree = ncm_mset_fparam_len (test->mset);
+  NcmMatrix *F0;
+  NcmMatrix *F;
+  guint a, b;
+
+  ncm_fisher_compute (test->fisher);
+
+  g_assert_cmpuint (ncm_matrix_nrows (ncm_fisher_peek_matrix (test->fisher)), ==, nfree);
+
+  /* Checks the tr (C^{-1} C_a C^{-1} C_b) / 2 and 2 sum sigma_a sigma_b / sigma^2 terms. */
+  _test_ncm_fisher_check_hessian (test);
+  _test_ncm_fisher_check_covar (test);
+
+  /* The copies evaluate their own covariances, which are not shared. */
+  F0 = ncm_matrix_dup (ncm_fisher_peek_matrix (test->fisher));
+
+  ncm_fisher_set_nthreads (test->fisher, 3);
+  ncm_fisher_compute (test->fisher);
+  F = ncm_fisher_peek_matrix (test->fisher);
+
+  for (a = 0; a < nfree; a++)
+  {
+    for (b = 0; b < nfree; b++)
+      g_assert_cmpfloat (fabs (ncm_matrix_get (F, a, b) - ncm_matrix_get (F0, a, b)), <=, 1.0e-12 * sqrt (ncm_matrix_get (F0, a, a) * ncm_matrix_get (F0, b, b)));
+  }
+
+  ncm_matrix_free (F0);
+}
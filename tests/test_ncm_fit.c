@@ -0,0 +1,280 @@
+/***************************************************************************
+ *            test_ncm_fit.c
+ *
+ *  Mon October 19 19:02:44 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * numcosmo
+ * Copyright (C) Sandro Dias Pinto Vitenti 2026 <sandro@isoftware.com.br>
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#undef GSL_RANGE_CHECK_OFF
+#endif /* HAVE_CONFIG_H */
+#include <numcosmo/numcosmo.h>
+
+#include <math.h>
+#include <glib.h>
+#include <glib-object.h>
+
+#include "ncm_mset_xcdm_test.h"
+
+#define TEST_NCM_FIT_CACHE_SIZE 3
+
+typedef struct _TestNcmFit
+{
+  NcmFit *fit;
+  NcmMSet *mset;
+  NcmDataset *dset;
+  NcmLikelihood *lh;
+} TestNcmFit;
+
+void test_ncm_fit_new (TestNcmFit *test, gconstpointer pdata);
+void test_ncm_fit_free (TestNcmFit *test, gconstpointer pdata);
+
+void test_ncm_fit_cache_lru (TestNcmFit *test, gconstpointer pdata);
+void test_ncm_fit_cache_size (TestNcmFit *test, gconstpointer pdata);
+void test_ncm_fit_cache_resample (TestNcmFit *test, gconstpointer pdata);
+void test_ncm_fit_cache_grad_type (TestNcmFit *test, gconstpointer pdata);
+
+gint
+main (gint argc, gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  ncm_cfg_init ();
+  ncm_cfg_enable_gsl_err_handler ();
+
+  g_test_add ("/ncm/fit/cache/lru", TestNcmFit, NULL,
+              &test_ncm_fit_new,
+              &test_ncm_fit_cache_lru,
+              &test_ncm_fit_free);
+  g_test_add ("/ncm/fit/cache/size", TestNcmFit, NULL,
+              &test_ncm_fit_new,
+              &test_ncm_fit_cache_size,
+              &test_ncm_fit_free);
+  g_test_add ("/ncm/fit/cache/resample", TestNcmFit, NULL,
+              &test_ncm_fit_new,
+              &test_ncm_fit_cache_resample,
+              &test_ncm_fit_free);
+  g_test_add ("/ncm/fit/cache/grad_type", TestNcmFit, NULL,
+              &test_ncm_fit_new,
+              &test_ncm_fit_cache_grad_type,
+              &test_ncm_fit_free);
+
+  g_test_run ();
+}
+
+void
+test_ncm_fit_new (TestNcmFit *test, gconstpointer pdata)
+{
+  NcmData *data = NCM_DATA (nc_data_hubble_new_from_id (NC_DATA_HUBBLE_SIMON2005));
+
+  test->mset = ncm_mset_xcdm_test_new (FALSE);
+  test->dset = ncm_dataset_new ();
+  ncm_dataset_append_data (test->dset, data);
+
+  test->lh  = ncm_likelihood_new (test->dset);
+  test->fit = ncm_fit_new (NCM_FIT_TYPE_GSL_MMS, "nmsimplex2", test->lh, test->mset, NCM_FIT_GRAD_NUMDIFF_FORWARD);
+  g_assert (NCM_IS_FIT (test->fit));
+  g_assert_cmpuint (ncm_fit_get_cache_size (test->fit), ==, 0);
+
+  ncm_fit_set_cache_size (test->fit, TEST_NCM_FIT_CACHE_SIZE);
+
+  ncm_data_free (data);
+}
+
+void
+test_ncm_fit_free (TestNcmFit *test, gconstpointer pdata)
+{
+  NcmFit *fit = test->fit;
+
+  ncm_likelihood_clear (&test->lh);
+  ncm_dataset_clear (&test->dset);
+  ncm_mset_clear (&test->mset);
+
+  NCM_TEST_FREE (ncm_fit_free, fit);
+}
+
+/* The i-th test point, only Omega_c (the first free parameter) changes. */
+static void
+_test_ncm_fit_set_point (TestNcmFit *test, guint i)
+{
+  ncm_mset_fparam_set (test->mset, 0, 0.21 + 0.02 * i);
+}
+
+/* Evaluates the i-th point through the cache and compares with the likelihood. */
+static void
+_test_ncm_fit_eval (TestNcmFit *test, guint i)
+{
+  gdouble m2lnL, m2lnL_lh;
+
+  _test_ncm_fit_set_point (test, i);
+
+  ncm_fit_m2lnL_val (test->fit, &m2lnL);
+  ncm_likelihood_m2lnL_val (test->lh, test->mset, &m2lnL_lh);
+
+  ncm_assert_cmpdouble (m2lnL, ==, m2lnL_lh);
+}
+
+static void
+_test_ncm_fit_assert_stats (TestNcmFit *test, gulong nhit, gulong nmiss)
+{
+  gulong fit_nhit, fit_nmiss;
+
+  ncm_fit_cache_get_stats (test->fit, &fit_nhit, &fit_nmiss);
+
+  g_assert_cmpuint (fit_nhit, ==, nhit);
+  g_assert_cmpuint (fit_nmiss, ==, nmiss);
+}
+
+void
+test_ncm_fit_cache_lru (TestNcmFit *test, gconstpointer pdata)
+{
+  /* Fills the cache, the order from the most to the least recent is 2 1 0. */
+  _test_ncm_fit_eval (test, 0);
+  _test_ncm_fit_eval (test, 1);
+  _test_ncm_fit_eval (test, 2);
+  _test_ncm_fit_assert_stats (test, 0, 3);
+
+  /* A hit moves 0 to the front: 0 2 1. */
+  _test_ncm_fit_eval (test, 0);
+  _test_ncm_fit_assert_stats (test, 1, 3);
+
+  /* A new point evicts the least recently used one (1): 3 0 2. */
+  _test_ncm_fit_eval (test, 3);
+  _test_ncm_fit_assert_stats (test, 1, 4);
+
+  _test_ncm_fit_eval (test, 2);
+  _test_ncm_fit_eval (test, 0);
+  _test_ncm_fit_eval (test, 3);
+  _test_ncm_fit_assert_stats (test, 4, 4);
+
+  _test_ncm_fit_eval (test, 1);
+  _test_ncm_fit_assert_stats (test, 4, 5);
+
+  ncm_fit_cache_clear (test->fit);
+  _test_ncm_fit_assert_stats (test, 0, 0);
+
+  _test_ncm_fit_eval (test, 1);
+  _test_ncm_fit_assert_stats (test, 0, 1);
+}
+
+void
+test_ncm_fit_cache_size (TestNcmFit *test, gconstpointer pdata)
+{
+  _test_ncm_fit_eval (test, 0);
+  _test_ncm_fit_eval (test, 1);
+  _test_ncm_fit_eval (test, 2);
+  _test_ncm_fit_assert_stats (test, 0, 3);
+
+  /* Shrinking keeps only the most recent point. */
+  ncm_fit_set_cache_size (test->fit, 1);
+  g_assert_cmpuint (ncm_fit_get_cache_size (test->fit), ==, 1);
+
+  _test_ncm_fit_eval (test, 2);
+  _test_ncm_fit_assert_stats (test, 1, 3);
+  _test_ncm_fit_eval (test, 1);
+  _test_ncm_fit_assert_stats (test, 1, 4);
+
+  /* Disabled, the evaluations bypass the cache. */
+  ncm_fit_set_cache_size (test->fit, 0);
+  g_assert_cmpuint (ncm_fit_get_cache_size (test->fit), ==, 0);
+
+  _test_ncm_fit_eval (test, 1);
+  _test_ncm_fit_eval (test, 1);
+  _test_ncm_fit_assert_stats (test, 1, 4);
+}
+
+void
+test_ncm_fit_cache_resample (TestNcmFit *test, gconstpointer pdata)
+{
+  NcmRNG *rng     = ncm_rng_seeded_new (NULL, g_test_rand_int ());
+  NcmData *data   = ncm_dataset_peek_data (test->dset, 0);
+  guint64 version = ncm_dataset_get_version (test->dset);
+  gdouble m2lnL0, m2lnL1;
+
+  _test_ncm_fit_set_point (test, 0);
+  ncm_fit_m2lnL_val (test->fit, &m2lnL0);
+  _test_ncm_fit_assert_stats (test, 0, 1);
+
+  /* A new realization of the data, the cached value is not reused. */
+  ncm_dataset_resample (test->dset, test->mset, rng);
+  g_assert_cmpuint (ncm_dataset_get_version (test->dset), >, version);
+
+  _test_ncm_fit_eval (test, 0);
+  _test_ncm_fit_assert_stats (test, 0, 2);
+
+  ncm_fit_m2lnL_val (test->fit, &m2lnL1);
+  _test_ncm_fit_assert_stats (test, 1, 2);
+  g_assert_cmpfloat (m2lnL0, !=, m2lnL1);
+
+  /* Any change marked in the data also drops the cache. */
+  version = ncm_dataset_get_version (test->dset);
+  ncm_data_mark_changed (data);
+  g_assert_cmpuint (ncm_dataset_get_version (test->dset), >, version);
+
+  _test_ncm_fit_eval (test, 0);
+  _test_ncm_fit_assert_stats (test, 1, 3);
+
+  /* So does a new prior. */
+  ncm_likelihood_priors_add_gauss_param (test->lh, nc_hicosmo_id (), NC_HICOSMO_DE_OMEGA_C, 0.25, 0.01);
+
+  _test_ncm_fit_eval (test, 0);
+  _test_ncm_fit_assert_stats (test, 1, 4);
+
+  ncm_rng_free (rng);
+}
+
+void
+test_ncm_fit_cache_grad_type (TestNcmFit *test, gconstpointer pdata)
+{
+  const guint fparam_len = ncm_mset_fparam_len (test->mset);
+  NcmVector *grad_forward = ncm_vector_new (fparam_len);
+  NcmVector *grad_central = ncm_vector_new (fparam_len);
+  NcmVector *grad         = ncm_vector_new (fparam_len);
+  gulong nhit, nmiss;
+  guint i;
+
+  _test_ncm_fit_set_point (test, 1);
+  ncm_fit_m2lnL_grad (test->fit, grad_forward);
+
+  ncm_fit_cache_get_stats (test->fit, &nhit, &nmiss);
+  ncm_fit_m2lnL_grad (test->fit, grad);
+  _test_ncm_fit_assert_stats (test, nhit + 1, nmiss);
+
+  for (i = 0; i < fparam_len; i++)
+    ncm_assert_cmpdouble (ncm_vector_get (grad, i), ==, ncm_vector_get (grad_forward, i));
+
+  /* The cached forward difference must not be returned for the central one. */
+  ncm_fit_set_grad_type (test->fit, NCM_FIT_GRAD_NUMDIFF_CENTRAL);
+  _test_ncm_fit_set_point (test, 1);
+  ncm_fit_m2lnL_grad (test->fit, grad_central);
+
+  ncm_fit_set_cache_size (test->fit, 0);
+  ncm_fit_m2lnL_grad (test->fit, grad);
+
+  for (i = 0; i < fparam_len; i++)
+  {
+    ncm_assert_cmpdouble (ncm_vector_get (grad_central, i), ==, ncm_vector_get (grad, i));
+    g_assert_cmpfloat (ncm_vector_get (grad_central, i), !=, ncm_vector_get (grad_forward, i));
+  }
+
+  ncm_vector_free (grad_forward);
+  ncm_vector_free (grad_central);
+  ncm_vector_free (grad);
+}
@@ -39,8 +39,10 @@ void test_ncm_matrix_new_data_slice (void);
 void test_ncm_matrix_new_data_malloc (void);
 void test_ncm_matrix_new_data_static (void);
 void test_ncm_matrix_new_data_static_tda (void);
+void test_ncm_matrix_new_aligned (void);
 void test_ncm_matrix_operations (void);
 void test_ncm_matrix_add_mul (void);
+void test_ncm_matrix_blas (void);
 void test_ncm_matrix_free (void);
 void test_ncm_matrix_submatrix (void);
 void test_ncm_matrix_serialization (void);
@@ -59,8 +61,10 @@ main (gint argc, gchar *argv[])
   g_test_add_func ("/ncm/matrix/new_data_malloc", &test_ncm_matrix_new_data_malloc);
   g_test_add_func ("/ncm/matrix/new_data_static", &test_ncm_matrix_new_data_static);
   g_test_add_func ("/ncm/matrix/new_data_static_tda", &test_ncm_matrix_new_data_static_tda);
+  g_test_add_func ("/ncm/matrix/new_aligned", &test_ncm_matrix_new_aligned);
   g_test_add_func ("/ncm/matrix/operations", &test_ncm_matrix_operations);
   g_test_add_func ("/ncm/matrix/add_mul", &test_ncm_matrix_add_mul);
+  g_test_add_func ("/ncm/matrix/blas", &test_ncm_matrix_blas);
   g_test_add_func ("/ncm/matrix/submatrix", &test_ncm_matrix_submatrix);
   g_test_add_func ("/ncm/matrix/serialization", &test_ncm_matrix_serialization);
   g_test_add_func ("/ncm/matrix/free", &test_ncm_matrix_free);
@@ -419,6 +423,91 @@ test_ncm_matrix_add_mul (void)
   NCM_TEST_FREE (ncm_matrix_free, sm);
 }
 
+void
+test_ncm_matrix_new_aligned (void)
+{
+  NcmMatrix *mm = ncm_matrix_new_aligned (_NCM_MATRIX_TEST_NROW, _NCM_MATRIX_TEST_NCOL);
+  test_ncm_matrix_new_sanity (mm);
+
+  g_assert (ncm_matrix_is_aligned (mm));
+  g_assert (!ncm_matrix_is_aligned (m));
+  g_assert_cmpuint (ncm_matrix_tda (mm), ==, _NCM_MATRIX_TEST_NCOL);
+  g_assert_cmpuint (GPOINTER_TO_SIZE (ncm_matrix_data (mm)) % NCM_VECTOR_ALIGNMENT, ==, 0);
+
+  NCM_TEST_FREE (ncm_matrix_free, mm);
+}
+
+void
+test_ncm_matrix_blas (void)
+{
+  NcmMatrix *a = ncm_matrix_new_aligned (_NCM_MATRIX_TEST_NROW, _NCM_MATRIX_TEST_NCOL);
+  NcmMatrix *c = ncm_matrix_new_aligned (_NCM_MATRIX_TEST_NCOL, _NCM_MATRIX_TEST_NCOL);
+  NcmMatrix *b = ncm_matrix_new (_NCM_MATRIX_TEST_NCOL, 3);
+  NcmMatrix *x = ncm_matrix_new (_NCM_MATRIX_TEST_NCOL, 3);
+  NcmVector *v = ncm_vector_new_aligned (_NCM_MATRIX_TEST_NCOL);
+  NcmMatrix *c0;
+  const gdouble alpha = g_test_rand_double ();
+  guint i, j, k;
+
+  for (i = 0; i < _NCM_MATRIX_TEST_NROW; i++)
+    for (j = 0; j < _NCM_MATRIX_TEST_NCOL; j++)
+      ncm_matrix_set (a, i, j, g_test_rand_double ());
+  for (i = 0; i < _NCM_MATRIX_TEST_NCOL; i++)
+  {
+    ncm_vector_set (v, i, g_test_rand_double ());
+    for (j = 0; j < 3; j++)
+      ncm_matrix_set (b, i, j, g_test_rand_double ());
+  }
+
+  /* C = A^T A + I, only the upper triangle is computed. */
+  ncm_matrix_set_identity (c);
+  ncm_matrix_dsyrk (c, 'U', 'T', 1.0, a, 1.0);
+  for (i = 0; i < _NCM_MATRIX_TEST_NCOL; i++)
+  {
+    for (j = i; j < _NCM_MATRIX_TEST_NCOL; j++)
+    {
+      gdouble c_ij = (i == j) ? 1.0 : 0.0;
+      for (k = 0; k < _NCM_MATRIX_TEST_NROW; k++)
+        c_ij += ncm_matrix_get (a, k, i) * ncm_matrix_get (a, k, j);
+      ncm_assert_cmpdouble_e (ncm_matrix_get (c, i, j), ==, c_ij, 1.0e-13);
+    }
+  }
+
+  /* C = C + alpha v v^T. */
+  c0 = ncm_matrix_dup (c);
+  ncm_matrix_dsyr (c, 'U', alpha, v);
+  for (i = 0; i < _NCM_MATRIX_TEST_NCOL; i++)
+  {
+    for (j = i; j < _NCM_MATRIX_TEST_NCOL; j++)
+    {
+      const gdouble c_ij = ncm_matrix_get (c0, i, j) + alpha * ncm_vector_get (v, i) * ncm_vector_get (v, j);
+      ncm_assert_cmpdouble_e (ncm_matrix_get (c, i, j), ==, c_ij, 1.0e-13);
+    }
+  }
+
+  /* Solves U^T X = B with C = U^T U. */
+  ncm_matrix_copy_triangle (c, 'U');
+  g_assert_cmpint (ncm_matrix_cholesky_decomp (c, 'U'), ==, 0);
+  ncm_matrix_memcpy (x, b);
+  ncm_matrix_dtrsm (c, 'U', 'T', 1.0, x);
+  for (i = 0; i < _NCM_MATRIX_TEST_NCOL; i++)
+  {
+    for (j = 0; j < 3; j++)
+    {
+      gdouble b_ij = 0.0;
+      for (k = 0; k <= i; k++)
+        b_ij += ncm_matrix_get (c, k, i) * ncm_matrix_get (x, k, j);
+      g_assert_cmpfloat (fabs (b_ij - ncm_matrix_get (b, i, j)), <, 1.0e-12);
+    }
+  }
+
+  ncm_vector_free (v);
+  ncm_matrix_free (c0);
+  ncm_matrix_free (x);
+  ncm_matrix_free (b);
+  ncm_matrix_free (c);
+  ncm_matrix_free (a);
+}
 
 void
 test_ncm_matrix_serialization (void)
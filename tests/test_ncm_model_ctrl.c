@@ -46,6 +46,7 @@ void test_ncm_model_ctrl_free (TestNcmModelCtrl *test, gconstpointer pdata);
 void test_ncm_model_ctrl_model_update (TestNcmModelCtrl *test, gconstpointer pdata);
 void test_ncm_model_ctrl_update (TestNcmModelCtrl *test, gconstpointer pdata);
 void test_ncm_model_ctrl_submodel_update (TestNcmModelCtrl *test, gconstpointer pdata);
+void test_ncm_model_ctrl_deps (TestNcmModelCtrl *test, gconstpointer pdata);
 
 void test_ncm_model_ctrl_traps (TestNcmModelCtrl *test, gconstpointer pdata);
 void test_ncm_model_ctrl_invalid_submodel_last_update (TestNcmModelCtrl *test, gconstpointer pdata);
@@ -72,6 +73,11 @@ main (gint argc, gchar *argv[])
               &test_ncm_model_ctrl_submodel_update, 
               &test_ncm_model_ctrl_free);
 
+  g_test_add ("/ncm/model_ctrl/deps", TestNcmModelCtrl, NULL, 
+              &test_ncm_model_ctrl_new, 
+              &test_ncm_model_ctrl_deps, 
+              &test_ncm_model_ctrl_free);
+
   g_test_add ("/ncm/model_ctrl/traps", TestNcmModelCtrl, NULL,
               &test_ncm_model_ctrl_new,
               &test_ncm_model_ctrl_traps,
@@ -284,6 +290,49 @@ test_ncm_model_ctrl_submodel_update (TestNcmModelCtrl *test, gconstpointer pdata
   }
 }
 
+void
+test_ncm_model_ctrl_deps (TestNcmModelCtrl *test, gconstpointer pdata)
+{
+  NcmModelCtrl *ctrl_Yp = ncm_model_ctrl_new (NULL);
+  guint Yp_i, H0_i;
+
+  g_assert (ncm_model_orig_param_index_from_name (test->model, "Yp", &Yp_i));
+  g_assert (ncm_model_orig_param_index_from_name (test->model, "H0", &H0_i));
+
+  ncm_model_ctrl_add_indep (test->ctrl, "Yp");
+  ncm_model_ctrl_add_dep (ctrl_Yp, "Yp");
+
+  g_assert (ncm_model_ctrl_update (test->ctrl, test->model));
+  g_assert (ncm_model_ctrl_update (ctrl_Yp, test->model));
+
+  /* Only the objects depending on Yp are updated. */
+  ncm_model_orig_param_set (test->model, Yp_i, ncm_model_orig_param_get (test->model, Yp_i) * 0.999);
+  g_assert (!ncm_model_ctrl_update (test->ctrl, test->model));
+  g_assert (ncm_model_ctrl_update (ctrl_Yp, test->model));
+  g_assert_cmpuint (ncm_model_param_get_stamp (test->model, Yp_i), >, ncm_model_param_get_stamp (test->model, H0_i));
+
+  ncm_model_orig_param_set (test->model, H0_i, ncm_model_orig_param_get (test->model, H0_i) * 0.999);
+  g_assert (ncm_model_ctrl_update (test->ctrl, test->model));
+  g_assert (!ncm_model_ctrl_update (ctrl_Yp, test->model));
+
+  /* Setting the same value does not change the stamps. */
+  ncm_model_orig_param_set (test->model, H0_i, ncm_model_orig_param_get (test->model, H0_i));
+  g_assert (!ncm_model_ctrl_update (test->ctrl, test->model));
+  g_assert (!ncm_model_ctrl_update (ctrl_Yp, test->model));
+
+  /* Changes outside the parameters affect everyone. */
+  ncm_model_state_mark_outdated (test->model);
+  g_assert (ncm_model_ctrl_update (test->ctrl, test->model));
+  g_assert (ncm_model_ctrl_update (ctrl_Yp, test->model));
+
+  /* Without dependencies any change is reported. */
+  ncm_model_ctrl_clear_deps (ctrl_Yp);
+  ncm_model_orig_param_set (test->model, H0_i, ncm_model_orig_param_get (test->model, H0_i));
+  g_assert (ncm_model_ctrl_update (ctrl_Yp, test->model));
+
+  NCM_TEST_FREE (ncm_model_ctrl_free, ctrl_Yp);
+}
+
 void
 test_ncm_model_ctrl_traps (TestNcmModelCtrl *test, gconstpointer pdata)
 {
@@ -0,0 +1,248 @@
+/***************************************************************************
+ *            test_ncm_rng.c
+ *
+ *  Mon October 19 23:12:40 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * numcosmo
+ * Copyright (C) Sandro Dias Pinto Vitenti 2026 <sandro@isoftware.com.br>
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#undef GSL_RANGE_CHECK_OFF
+#endif /* HAVE_CONFIG_H */
+#include <numcosmo/numcosmo.h>
+
+#include <math.h>
+#include <glib.h>
+#include <glib-object.h>
+
+typedef struct _TestNcmRNG
+{
+  NcmRNG *rng;
+  guint ntests;
+} TestNcmRNG;
+
+void test_ncm_rng_new (TestNcmRNG *test, gconstpointer pdata);
+void test_ncm_rng_free (TestNcmRNG *test, gconstpointer pdata);
+
+void test_ncm_rng_philox_kat (TestNcmRNG *test, gconstpointer pdata);
+void test_ncm_rng_skip (TestNcmRNG *test, gconstpointer pdata);
+void test_ncm_rng_jump (TestNcmRNG *test, gconstpointer pdata);
+void test_ncm_rng_state (TestNcmRNG *test, gconstpointer pdata);
+void test_ncm_rng_stream (TestNcmRNG *test, gconstpointer pdata);
+void test_ncm_rng_fill (TestNcmRNG *test, gconstpointer pdata);
+
+gint
+main (gint argc, gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  ncm_cfg_init ();
+  ncm_cfg_enable_gsl_err_handler ();
+
+  g_test_add ("/ncm/rng/philox/kat", TestNcmRNG, NULL,
+              &test_ncm_rng_new,
+              &test_ncm_rng_philox_kat,
+              &test_ncm_rng_free);
+  g_test_add ("/ncm/rng/skip", TestNcmRNG, NULL,
+              &test_ncm_rng_new,
+              &test_ncm_rng_skip,
+              &test_ncm_rng_free);
+  g_test_add ("/ncm/rng/jump", TestNcmRNG, NULL,
+              &test_ncm_rng_new,
+              &test_ncm_rng_jump,
+              &test_ncm_rng_free);
+  g_test_add ("/ncm/rng/state", TestNcmRNG, NULL,
+              &test_ncm_rng_new,
+              &test_ncm_rng_state,
+              &test_ncm_rng_free);
+  g_test_add ("/ncm/rng/stream", TestNcmRNG, NULL,
+              &test_ncm_rng_new,
+              &test_ncm_rng_stream,
+              &test_ncm_rng_free);
+  g_test_add ("/ncm/rng/fill", TestNcmRNG, NULL,
+              &test_ncm_rng_new,
+              &test_ncm_rng_fill,
+              &test_ncm_rng_free);
+
+  g_test_run ();
+}
+
+void
+test_ncm_rng_new (TestNcmRNG *test, gconstpointer pdata)
+{
+  test->rng    = ncm_rng_seeded_new (NCM_RNG_STREAM_ALGO, g_test_rand_int_range (1, G_MAXINT32));
+  test->ntests = 1000;
+
+  g_assert (NCM_IS_RNG (test->rng));
+  g_assert_cmpstr (ncm_rng_get_algo (test->rng), ==, NCM_RNG_STREAM_ALGO);
+}
+
+void
+test_ncm_rng_free (TestNcmRNG *test, gconstpointer pdata)
+{
+  NcmRNG *rng = test->rng;
+
+  ncm_rng_free (rng);
+  g_assert (!NCM_IS_RNG (rng));
+}
+
+void
+test_ncm_rng_philox_kat (TestNcmRNG *test, gconstpointer pdata)
+{
+  /* Known answer for counter = 0 and key = 0 (Random123 kat_vectors). */
+  const gulong kat[4] = {0x6627e8d5UL, 0xe169c58dUL, 0xbc57ac4cUL, 0x9b00dbd8UL};
+  guint i;
+
+  ncm_rng_set_seed (test->rng, 0);
+  for (i = 0; i < 4; i++)
+    g_assert_cmpuint (gsl_rng_get (test->rng->r), ==, kat[i]);
+}
+
+void
+test_ncm_rng_skip (TestNcmRNG *test, gconstpointer pdata)
+{
+  NcmRNG *rng = ncm_rng_seeded_new (NCM_RNG_STREAM_ALGO, ncm_rng_get_seed (test->rng));
+  NcmRNG *mt  = ncm_rng_seeded_new ("mt19937", 123);
+  NcmRNG *mt2 = ncm_rng_seeded_new ("mt19937", 123);
+  guint i;
+
+  for (i = 0; i < test->ntests; i++)
+  {
+    const guint n = g_test_rand_int_range (0, 37);
+    guint j;
+
+    for (j = 0; j < n; j++)
+      gsl_rng_get (test->rng->r);
+    ncm_rng_skip (rng, n);
+
+    g_assert_cmpuint (gsl_rng_get (test->rng->r), ==, gsl_rng_get (rng->r));
+  }
+
+  for (i = 0; i < 100; i++)
+    gsl_rng_get (mt->r);
+  ncm_rng_skip (mt2, 100);
+  g_assert_cmpuint (gsl_rng_get (mt->r), ==, gsl_rng_get (mt2->r));
+
+  ncm_rng_free (rng);
+  ncm_rng_free (mt);
+  ncm_rng_free (mt2);
+}
+
+void
+test_ncm_rng_jump (TestNcmRNG *test, gconstpointer pdata)
+{
+  NcmRNG *rng = ncm_rng_seeded_new (NCM_RNG_STREAM_ALGO, ncm_rng_get_seed (test->rng));
+  guint i, nequal = 0;
+
+  ncm_rng_jump (rng);
+  for (i = 0; i < test->ntests; i++)
+    nequal += (gsl_rng_get (test->rng->r) == gsl_rng_get (rng->r)) ? 1 : 0;
+
+  g_assert_cmpuint (nequal, <, 5);
+
+  ncm_rng_free (rng);
+}
+
+void
+test_ncm_rng_state (TestNcmRNG *test, gconstpointer pdata)
+{
+  NcmRNG *rng = ncm_rng_new (NCM_RNG_STREAM_ALGO);
+  gchar *state;
+  guint i;
+
+  ncm_rng_skip (test->rng, g_test_rand_int_range (0, 100));
+  state = ncm_rng_get_state (test->rng);
+  ncm_rng_set_state (rng, state);
+
+  for (i = 0; i < test->ntests; i++)
+    g_assert_cmpuint (gsl_rng_get (test->rng->r), ==, gsl_rng_get (rng->r));
+
+  g_free (state);
+  ncm_rng_free (rng);
+}
+
+void
+test_ncm_rng_stream (TestNcmRNG *test, gconstpointer pdata)
+{
+  NcmRNG *parent = ncm_rng_seeded_new ("mt19937", g_test_rand_int_range (1, G_MAXINT32));
+  NcmRNG *s0     = ncm_rng_stream_new (parent, 0);
+  NcmRNG *s0b    = ncm_rng_stream_new (parent, 0);
+  NcmRNG *s1     = ncm_rng_stream_new (parent, 1);
+  guint i, nequal = 0;
+
+  g_assert_cmpstr (ncm_rng_get_algo (s0), ==, NCM_RNG_STREAM_ALGO);
+
+  for (i = 0; i < test->ntests; i++)
+  {
+    const gulong a = gsl_rng_get (s0->r);
+    g_assert_cmpuint (a, ==, gsl_rng_get (s0b->r));
+    nequal += (a == gsl_rng_get (s1->r)) ? 1 : 0;
+  }
+  g_assert_cmpuint (nequal, <, 5);
+
+  /* The streams change when the parent state changes. */
+  ncm_rng_stream_set (s0b, parent, 0);
+  gsl_rng_get (parent->r);
+  ncm_rng_stream_set (s1, parent, 0);
+
+  nequal = 0;
+  for (i = 0; i < test->ntests; i++)
+    nequal += (gsl_rng_get (s0b->r) == gsl_rng_get (s1->r)) ? 1 : 0;
+  g_assert_cmpuint (nequal, <, 5);
+
+  ncm_rng_free (parent);
+  ncm_rng_free (s0);
+  ncm_rng_free (s0b);
+  ncm_rng_free (s1);
+}
+
+void
+test_ncm_rng_fill (TestNcmRNG *test, gconstpointer pdata)
+{
+  const guint n   = 100003;
+  NcmVector *v    = ncm_vector_new (n);
+  NcmStatsVec *sv = ncm_stats_vec_new (1, NCM_STATS_VEC_VAR, FALSE);
+  guint i;
+
+  ncm_rng_uniform_fill (test->rng, v, -1.0, 3.0);
+  for (i = 0; i < n; i++)
+  {
+    const gdouble x = ncm_vector_get (v, i);
+    g_assert_cmpfloat (x, >=, -1.0);
+    g_assert_cmpfloat (x, <, 3.0);
+    ncm_stats_vec_set (sv, 0, x);
+    ncm_stats_vec_update (sv);
+  }
+  ncm_assert_cmpdouble_e (ncm_stats_vec_get_mean (sv, 0), ==, 1.0, 2.0e-2);
+  ncm_assert_cmpdouble_e (ncm_stats_vec_get_var (sv, 0), ==, 16.0 / 12.0, 3.0e-2);
+
+  ncm_stats_vec_reset (sv, TRUE);
+
+  ncm_rng_gaussian_fill (test->rng, v, 2.0, 0.5);
+  for (i = 0; i < n; i++)
+  {
+    ncm_stats_vec_set (sv, 0, ncm_vector_get (v, i));
+    ncm_stats_vec_update (sv);
+  }
+  ncm_assert_cmpdouble_e (ncm_stats_vec_get_mean (sv, 0), ==, 2.0, 1.0e-2);
+  ncm_assert_cmpdouble_e (ncm_stats_vec_get_var (sv, 0), ==, 0.25, 3.0e-2);
+
+  ncm_stats_vec_free (sv);
+  ncm_vector_free (v);
+}
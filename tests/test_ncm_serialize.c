@@ -29,6 +29,8 @@
 #endif /* HAVE_CONFIG_H */
 #include <numcosmo/numcosmo.h>
 
+#include <unistd.h>
+
 typedef struct _TestNcmSerialize
 {
   NcmSerialize *ser;
@@ -46,6 +48,8 @@ static void test_ncm_serialize_from_string_params_named (TestNcmSerialize *test,
 static void test_ncm_serialize_from_string_nest_named (TestNcmSerialize *test, gconstpointer pdata);
 static void test_ncm_serialize_from_string_nest_samename (TestNcmSerialize *test, gconstpointer pdata);
 
+static void test_ncm_serialize_binfile (TestNcmSerialize *test, gconstpointer pdata);
+
 static void test_ncm_serialize_traps (TestNcmSerialize *test, gconstpointer pdata);
 static void test_ncm_serialize_global_invalid_from_string_syntax (TestNcmSerialize *test, gconstpointer pdata);
 static void test_ncm_serialize_global_invalid_from_string_nonexist (TestNcmSerialize *test, gconstpointer pdata);
@@ -90,6 +94,11 @@ main (gint argc, gchar *argv[])
               &test_ncm_serialize_from_string_nest_samename,
               &test_ncm_serialize_free);
 
+  g_test_add ("/ncm/serialize/binfile", TestNcmSerialize, NULL,
+              &test_ncm_serialize_new,
+              &test_ncm_serialize_binfile,
+              &test_ncm_serialize_free);
+
   g_test_add ("/ncm/serialize/traps", TestNcmSerialize, NULL,
               &test_ncm_serialize_new,
               &test_ncm_serialize_traps,
@@ -330,6 +339,95 @@ test_ncm_serialize_from_string_nest_samename (TestNcmSerialize *test, gconstpoin
   NCM_TEST_FREE (ncm_spline_free, s);
 }
 
+void
+test_ncm_serialize_binfile (TestNcmSerialize *test, gconstpointer pdata)
+{
+  const guint nrows = g_test_rand_int_range (1, 50);
+  const guint ncols = g_test_rand_int_range (1, 50);
+  NcmMatrix *m      = ncm_matrix_new (nrows, ncols);
+  NcmVector *v      = ncm_vector_new (ncols);
+  GError *error     = NULL;
+  gchar *mfile      = NULL;
+  gchar *vfile      = NULL;
+  gint mfd          = g_file_open_tmp ("test_ncm_serialize_mXXXXXX", &mfile, &error);
+  gint vfd          = g_file_open_tmp ("test_ncm_serialize_vXXXXXX", &vfile, &error);
+  NcmMatrix *m_dup, *m_dup2, *m_sh;
+  NcmVector *v_dup;
+  guint i, j;
+
+  g_assert_cmpint (mfd, >=, 0);
+  g_assert_cmpint (vfd, >=, 0);
+  close (mfd);
+  close (vfd);
+
+  for (i = 0; i < nrows; i++)
+    for (j = 0; j < ncols; j++)
+      ncm_matrix_set (m, i, j, g_test_rand_double ());
+  for (j = 0; j < ncols; j++)
+    ncm_vector_set (v, j, g_test_rand_double ());
+
+  ncm_serialize_to_binfile (test->ser, G_OBJECT (m), mfile);
+  ncm_serialize_to_binfile (test->ser, G_OBJECT (v), vfile);
+  ncm_serialize_clear_instances (test->ser);
+
+  m_dup = NCM_MATRIX (ncm_serialize_from_binfile (test->ser, mfile, TRUE));
+  v_dup = NCM_VECTOR (ncm_serialize_from_binfile (test->ser, vfile, TRUE));
+
+  g_assert_cmpuint (ncm_matrix_nrows (m_dup), ==, nrows);
+  g_assert_cmpuint (ncm_matrix_ncols (m_dup), ==, ncols);
+  g_assert_cmpuint (ncm_vector_len (v_dup), ==, ncols);
+
+  for (i = 0; i < nrows; i++)
+    for (j = 0; j < ncols; j++)
+      g_assert_cmpfloat (ncm_matrix_get (m_dup, i, j), ==, ncm_matrix_get (m, i, j));
+  for (j = 0; j < ncols; j++)
+    g_assert_cmpfloat (ncm_vector_get (v_dup, j), ==, ncm_vector_get (v, j));
+
+  /* The loaded objects are private copies, changing them must not affect the file. */
+  ncm_matrix_set_all (m_dup, -1.0);
+  ncm_vector_set_all (v_dup, -1.0);
+
+  ncm_serialize_clear_instances (test->ser);
+  m_dup2 = NCM_MATRIX (ncm_serialize_from_binfile (test->ser, mfile, TRUE));
+  for (i = 0; i < nrows; i++)
+    for (j = 0; j < ncols; j++)
+      g_assert_cmpfloat (ncm_matrix_get (m_dup2, i, j), ==, ncm_matrix_get (m, i, j));
+
+  /* Only the shared instances use the file memory, always aligned. */
+  ncm_serialize_share (test->ser, m);
+  ncm_serialize_to_binfile (test->ser, G_OBJECT (m), mfile);
+  ncm_serialize_clear_shared (test->ser);
+
+  m_sh = NCM_MATRIX (ncm_serialize_from_binfile (test->ser, mfile, TRUE));
+  g_assert (m_sh != m);
+  g_assert (ncm_serialize_is_shared (test->ser, m_sh));
+  g_assert (ncm_matrix_is_aligned (m_sh));
+  for (i = 0; i < nrows; i++)
+    for (j = 0; j < ncols; j++)
+      g_assert_cmpfloat (ncm_matrix_get (m_sh, i, j), ==, ncm_matrix_get (m, i, j));
+  ncm_matrix_free (m_sh);
+
+  ncm_serialize_clear_shared (test->ser);
+  m_sh = NCM_MATRIX (ncm_serialize_from_binfile (test->ser, mfile, FALSE));
+  g_assert (ncm_serialize_is_shared (test->ser, m_sh));
+  for (i = 0; i < nrows; i++)
+    for (j = 0; j < ncols; j++)
+      g_assert_cmpfloat (ncm_matrix_get (m_sh, i, j), ==, ncm_matrix_get (m, i, j));
+  ncm_matrix_free (m_sh);
+  ncm_serialize_clear_shared (test->ser);
+
+  ncm_matrix_free (m_dup2);
+  ncm_matrix_free (m_dup);
+  ncm_vector_free (v_dup);
+  ncm_matrix_free (m);
+  ncm_vector_free (v);
+
+  g_unlink (mfile);
+  g_unlink (vfile);
+  g_free (mfile);
+  g_free (vfile);
+}
+
 void
 test_ncm_serialize_traps (TestNcmSerialize *test, gconstpointer pdata)
 {
@@ -29,14 +29,27 @@
 #include <numcosmo/numcosmo.h>
 
 #include <gsl/gsl_sf_bessel.h>
+#include <glib/gstdio.h>
 
 #define NTOT 10000
 #define XMAX 8.0
 #define L 1200
 
+void test_ncm_sf_sbessel_table_mp (void);
+void test_ncm_sf_sbessel_table_recur (void);
+void test_ncm_sf_sbessel_table_save_load (void);
+
 gint
 main (gint argc, gchar *argv[])
 {
+  g_test_init (&argc, &argv, NULL);
+  ncm_cfg_init ();
+  ncm_cfg_enable_gsl_err_handler ();
+
+  g_test_add_func ("/ncm/sf/sbessel/table/mp", &test_ncm_sf_sbessel_table_mp);
+  g_test_add_func ("/ncm/sf/sbessel/table/recur", &test_ncm_sf_sbessel_table_recur);
+  g_test_add_func ("/ncm/sf/sbessel/table/save_load", &test_ncm_sf_sbessel_table_save_load);
+
   if (FALSE)
   {
     GTimer *bench = g_timer_new ();
@@ -46,10 +59,6 @@ main (gint argc, gchar *argv[])
 
     memset (time_elap, 0, sizeof (gdouble) * NTOT);
 
-    g_test_init (&argc, &argv, NULL);
-    ncm_cfg_init ();
-    //cfg_enable_gsl_err_handler ();
-
     for (j = 430; j <= L; j++)
     {
       printf ("# L = %u\n", j);
@@ -81,4 +90,120 @@ main (gint argc, gchar *argv[])
       printf ("% 20.15g %e\n", x, time_elap[i]);
     }
   }
+
+  g_test_run ();
+}
+
+void
+test_ncm_sf_sbessel_table_mp (void)
+{
+  NcmSFSBesselTable *tab = ncm_sf_sbessel_table_new (0, 60, 0.0, 50.0, 1001, TRUE);
+
+  g_assert_cmpfloat (ncm_sf_sbessel_table_validate (tab, 200, 1.0e-6), <, 1.0e-4);
+
+  {
+    gdouble x[NTOT / 100], jl[NTOT / 100];
+    guint i;
+
+    for (i = 0; i < NTOT / 100; i++)
+      x[i] = 50.0 * i / (NTOT / 100 - 1.0);
+
+    ncm_sf_sbessel_table_eval_jl_array (tab, 7, x, jl, NTOT / 100);
+
+    for (i = 0; i < NTOT / 100; i++)
+      g_assert_cmpfloat (fabs (jl[i] - ncm_sf_sbessel_table_eval_jl (tab, 7, x[i])), <=, 1.0e-15);
+  }
+
+  ncm_sf_sbessel_table_free (tab);
+}
+
+void
+test_ncm_sf_sbessel_table_recur (void)
+{
+  NcmSFSBesselTable *tab = ncm_sf_sbessel_table_new (10, 40, 0.5, 30.0, 600, TRUE);
+  const guint nx         = ncm_sf_sbessel_table_get_nx (tab);
+  guint l;
+
+  /* The tabulated values must satisfy the exact recurrence relations. */
+  for (l = 11; l <= 39; l++)
+  {
+    const gdouble *jlm1 = ncm_sf_sbessel_table_peek_jl (tab, l - 1);
+    const gdouble *jl   = ncm_sf_sbessel_table_peek_jl (tab, l);
+    const gdouble *jlp1 = ncm_sf_sbessel_table_peek_jl (tab, l + 1);
+    const gdouble *I2m1 = ncm_sf_sbessel_table_peek_int_jl_xn (tab, l - 1, 2);
+    const gdouble *I2p1 = ncm_sf_sbessel_table_peek_int_jl_xn (tab, l + 1, 2);
+    guint i;
+
+    for (i = 0; i < nx; i++)
+    {
+      const gdouble x = ncm_sf_sbessel_table_get_x (tab, i);
+      const gdouble rec_jl  = (2.0 * l + 1.0) * jl[i] / x;
+      const gdouble rec_int = (2.0 * l + 1.0) * x * x * jl[i];
+      const gdouble scale   = fabs ((1.0 - l) * I2p1[i]) + fabs ((2.0 + l) * I2m1[i]) + fabs (rec_int);
+
+      g_assert_cmpfloat (fabs ((1.0 - l) * I2p1[i] + (2.0 + l) * I2m1[i] - rec_int), <=, 1.0e-9 * scale + 1.0e-12);
+      g_assert_cmpfloat (fabs (jlm1[i] + jlp1[i] - rec_jl), <=, 1.0e-10 * fabs (rec_jl) + 1.0e-14);
+    }
+  }
+
+  ncm_sf_sbessel_table_free (tab);
+}
+
+void
+test_ncm_sf_sbessel_table_save_load (void)
+{
+  NcmSFSBesselTable *tab = ncm_sf_sbessel_table_new (2, 20, 0.0, 20.0, 201, TRUE);
+  gchar *tmp_dir         = g_dir_make_tmp ("test_ncm_sf_sbessel_XXXXXX", NULL);
+  gchar *filename        = g_build_filename (tmp_dir, "table.dat", NULL);
+  NcmSFSBesselTable *tab_load;
+  guint l, n, i;
+
+  ncm_sf_sbessel_table_save (tab, filename);
+  tab_load = ncm_sf_sbessel_table_load (filename);
+
+  g_assert_cmpuint (ncm_sf_sbessel_table_get_lmin (tab_load), ==, 2);
+  g_assert_cmpuint (ncm_sf_sbessel_table_get_lmax (tab_load), ==, 20);
+  g_assert_cmpuint (ncm_sf_sbessel_table_get_nx (tab_load), ==, 201);
+  g_assert (ncm_sf_sbessel_table_has_int (tab_load));
+
+  for (l = 2; l <= 20; l++)
+  {
+    const gdouble *jl      = ncm_sf_sbessel_table_peek_jl (tab, l);
+    const gdouble *jl_load = ncm_sf_sbessel_table_peek_jl (tab_load, l);
+
+    for (i = 0; i < 201; i++)
+      g_assert_cmpfloat (jl[i], ==, jl_load[i]);
+
+    for (n = 0; n < NCM_SF_SBESSEL_TABLE_NINT; n++)
+    {
+      const gdouble *I_n      = ncm_sf_sbessel_table_peek_int_jl_xn (tab, l, n);
+      const gdouble *I_n_load = ncm_sf_sbessel_table_peek_int_jl_xn (tab_load, l, n);
+
+      for (i = 0; i < 201; i++)
+        g_assert_cmpfloat (I_n[i], ==, I_n_load[i]);
+    }
+  }
+
+  {
+    NcmSFSBesselTable *tab_c1 = ncm_sf_sbessel_table_cached_new (0, 5, 0.0, 5.0, 51, FALSE);
+    NcmSFSBesselTable *tab_c2 = ncm_sf_sbessel_table_cached_new (0, 5, 0.0, 5.0, 51, FALSE);
+    gchar *cache_file         = ncm_cfg_get_fullpath ("%s", tab_c1->key);
+
+    g_assert (tab_c1 == tab_c2);
+    g_assert (g_file_test (cache_file, G_FILE_TEST_EXISTS));
+
+    ncm_sf_sbessel_table_free (tab_c1);
+    ncm_sf_sbessel_table_free (tab_c2);
+
+    g_unlink (cache_file);
+    g_free (cache_file);
+  }
+
+  ncm_sf_sbessel_table_free (tab_load);
+  ncm_sf_sbessel_table_free (tab);
+
+  g_unlink (filename);
+  g_rmdir (tmp_dir);
+  g_free (filename);
+  g_free (tmp_dir);
 }
@@ -31,6 +31,7 @@
 #include <math.h>
 #include <glib.h>
 #include <glib-object.h>
+#include <glib/gstdio.h>
 
 typedef struct _TestNcmSphereMapPix
 {
@@ -44,8 +45,11 @@ void test_ncm_sphere_map_pix_free (TestNcmSphereMapPix *test, gconstpointer pdat
 void test_ncm_sphere_map_pix_sanity (TestNcmSphereMapPix *test, gconstpointer pdata);
 void test_ncm_sphere_map_pix_angles (TestNcmSphereMapPix *test, gconstpointer pdata);
 void test_ncm_sphere_map_pix_ring (TestNcmSphereMapPix *test, gconstpointer pdata);
+void test_ncm_sphere_map_pix_ang2pix_array (TestNcmSphereMapPix *test, gconstpointer pdata);
+void test_ncm_sphere_map_pix_partial (TestNcmSphereMapPix *test, gconstpointer pdata);
 void test_ncm_sphere_map_pix_pix2alm (TestNcmSphereMapPix *test, gconstpointer pdata);
 void test_ncm_sphere_map_pix_pix2alm2pix (TestNcmSphereMapPix *test, gconstpointer pdata);
+void test_ncm_sphere_map_pix_pix2alm_threads (TestNcmSphereMapPix *test, gconstpointer pdata);
 
 void test_ncm_sphere_map_pix_traps (TestNcmSphereMapPix *test, gconstpointer pdata);
 void test_ncm_sphere_map_pix_invalid_nside (TestNcmSphereMapPix *test, gconstpointer pdata);
@@ -71,6 +75,16 @@ main (gint argc, gchar *argv[])
               &test_ncm_sphere_map_pix_new,
               &test_ncm_sphere_map_pix_ring,
               &test_ncm_sphere_map_pix_free);
+
+  g_test_add ("/ncm/sphere_map_pix/ang2pix/array", TestNcmSphereMapPix, NULL,
+              &test_ncm_sphere_map_pix_new,
+              &test_ncm_sphere_map_pix_ang2pix_array,
+              &test_ncm_sphere_map_pix_free);
+
+  g_test_add ("/ncm/sphere_map_pix/partial", TestNcmSphereMapPix, NULL,
+              &test_ncm_sphere_map_pix_new,
+              &test_ncm_sphere_map_pix_partial,
+              &test_ncm_sphere_map_pix_free);
   
   g_test_add ("/ncm/sphere_map_pix/pix2alm", TestNcmSphereMapPix, NULL,
               &test_ncm_sphere_map_pix_new,
@@ -82,6 +96,11 @@ main (gint argc, gchar *argv[])
               &test_ncm_sphere_map_pix_pix2alm2pix,
               &test_ncm_sphere_map_pix_free);
 
+  g_test_add ("/ncm/sphere_map_pix/pix2alm/threads", TestNcmSphereMapPix, NULL,
+              &test_ncm_sphere_map_pix_new,
+              &test_ncm_sphere_map_pix_pix2alm_threads,
+              &test_ncm_sphere_map_pix_free);
+
   g_test_add ("/ncm/sphere_map_pix/traps", TestNcmSphereMapPix, NULL,
               &test_ncm_sphere_map_pix_new,
               &test_ncm_sphere_map_pix_traps,
@@ -230,6 +249,134 @@ test_ncm_sphere_map_pix_ring (TestNcmSphereMapPix *test, gconstpointer pdata)
   }
 }
 
+void
+test_ncm_sphere_map_pix_ang2pix_array (TestNcmSphereMapPix *test, gconstpointer pdata)
+{
+  const gsize np = 10000;
+  gdouble *theta = g_new (gdouble, np);
+  gdouble *phi   = g_new (gdouble, np);
+  gint64 *index  = g_new (gint64, np);
+  gint o;
+  gsize i;
+
+  g_assert (test->pix != NULL);
+
+  for (i = 0; i < np; i++)
+  {
+    theta[i] = acos (g_test_rand_double_range (-1.0, 1.0));
+    phi[i]   = g_test_rand_double_range (0.0, 2.0 * M_PI);
+  }
+
+  for (o = 0; o < 2; o++)
+  {
+    const NcmSphereMapPixOrder order = (o == 0) ? NCM_SPHERE_MAP_PIX_ORDER_RING : NCM_SPHERE_MAP_PIX_ORDER_NEST;
+
+    ncm_sphere_map_pix_set_order (test->pix, order);
+    ncm_sphere_map_pix_ang2pix_array (test->pix, theta, phi, index, np);
+
+    for (i = 0; i < np; i++)
+    {
+      gint64 index_i = -1;
+
+      if (order == NCM_SPHERE_MAP_PIX_ORDER_RING)
+        ncm_sphere_map_pix_ang2pix_ring (test->pix, theta[i], phi[i], &index_i);
+      else
+        ncm_sphere_map_pix_ang2pix_nest (test->pix, theta[i], phi[i], &index_i);
+
+      g_assert_cmpint (index[i], ==, index_i);
+    }
+  }
+
+  g_free (theta);
+  g_free (phi);
+  g_free (index);
+}
+
+void
+test_ncm_sphere_map_pix_partial (TestNcmSphereMapPix *test, gconstpointer pdata)
+{
+  const gint64 nrings = ncm_sphere_map_pix_get_nrings (test->pix);
+  const gint64 r_a    = nrings / 4;
+  const gint64 r_b    = nrings / 2;
+  const gint64 fi_a   = ncm_sphere_map_pix_get_ring_first_index (test->pix, r_a);
+  const gint64 li_b   = ncm_sphere_map_pix_get_ring_first_index (test->pix, r_b) + ncm_sphere_map_pix_get_ring_size (test->pix, r_b) - 1;
+  const gsize np      = 10000;
+  gdouble *theta      = g_new (gdouble, np);
+  gdouble *phi        = g_new (gdouble, np);
+  gdouble total       = 0.0;
+  gint64 nin          = 0;
+  gint64 i;
+
+  g_assert (test->pix != NULL);
+  g_assert (ncm_sphere_map_pix_partial_is_full_sky (test->pix));
+
+  /* Overlapping intervals must be merged. */
+  ncm_sphere_map_pix_partial_add_rings (test->pix, r_a, r_b);
+  ncm_sphere_map_pix_partial_add_pixels (test->pix, fi_a + 1, fi_a + 10);
+  g_assert (!ncm_sphere_map_pix_partial_is_full_sky (test->pix));
+  g_assert_cmpint (ncm_sphere_map_pix_partial_get_npix (test->pix), ==, li_b - fi_a + 1);
+
+  g_assert (!ncm_sphere_map_pix_partial_contains (test->pix, fi_a - 1));
+  g_assert (ncm_sphere_map_pix_partial_contains (test->pix, fi_a));
+  g_assert (ncm_sphere_map_pix_partial_contains (test->pix, li_b));
+  g_assert (!ncm_sphere_map_pix_partial_contains (test->pix, li_b + 1));
+
+  for (i = 0; i < np; i++)
+  {
+    gint64 ring_index = -1;
+
+    theta[i] = acos (g_test_rand_double_range (-1.0, 1.0));
+    phi[i]   = g_test_rand_double_range (0.0, 2.0 * M_PI);
+
+    ncm_sphere_map_pix_ang2pix_ring (test->pix, theta[i], phi[i], &ring_index);
+    if ((ring_index >= fi_a) && (ring_index <= li_b))
+      nin++;
+  }
+
+  ncm_sphere_map_pix_set_order (test->pix, NCM_SPHERE_MAP_PIX_ORDER_NEST);
+  ncm_sphere_map_pix_add_to_ang_array (test->pix, theta, phi, NULL, np);
+  ncm_sphere_map_pix_set_order (test->pix, NCM_SPHERE_MAP_PIX_ORDER_RING);
+
+  for (i = 0; i < ncm_sphere_map_pix_get_npix (test->pix); i++)
+  {
+    gdouble theta_i, phi_i;
+    gint64 index_i = -1;
+
+    ncm_sphere_map_pix_pix2ang_ring (test->pix, i, &theta_i, &phi_i);
+    ncm_sphere_map_pix_ang2pix_ring (test->pix, theta_i, phi_i, &index_i);
+    g_assert_cmpint (index_i, ==, i);
+
+    total += ncm_sphere_map_pix_get_pix (test->pix, i);
+  }
+
+  g_assert_cmpfloat (total, ==, nin);
+
+#ifdef NUMCOSMO_HAVE_CFITSIO
+  {
+    gchar *tmp_dir          = g_dir_make_tmp ("test_ncm_sphere_map_pix_XXXXXX", NULL);
+    gchar *filename         = g_build_filename (tmp_dir, "partial.fits", NULL);
+    NcmSphereMapPix *pix_in = ncm_sphere_map_pix_new (test->nside);
+
+    ncm_sphere_map_pix_save_fits (test->pix, filename, NULL, TRUE);
+    ncm_sphere_map_pix_load_fits (pix_in, filename, NULL);
+
+    g_assert_cmpint (ncm_sphere_map_pix_get_order (pix_in), ==, NCM_SPHERE_MAP_PIX_ORDER_RING);
+
+    for (i = 0; i < ncm_sphere_map_pix_get_npix (test->pix); i++)
+      g_assert_cmpfloat (ncm_sphere_map_pix_get_pix (pix_in, i), ==, ncm_sphere_map_pix_get_pix (test->pix, i));
+
+    ncm_sphere_map_pix_free (pix_in);
+    g_unlink (filename);
+    g_rmdir (tmp_dir);
+    g_free (filename);
+    g_free (tmp_dir);
+  }
+#endif /* NUMCOSMO_HAVE_CFITSIO */
+
+  g_free (theta);
+  g_free (phi);
+}
+
 void
 test_ncm_sphere_map_pix_pix2alm (TestNcmSphereMapPix *test, gconstpointer pdata)
 {
@@ -276,6 +423,51 @@ test_ncm_sphere_map_pix_pix2alm2pix (TestNcmSphereMapPix *test, gconstpointer pd
   ncm_rng_free (rng);
 }
 
+void
+test_ncm_sphere_map_pix_pix2alm_threads (TestNcmSphereMapPix *test, gconstpointer pdata)
+{
+  NcmSphereMapPix *pix = ncm_sphere_map_pix_new (test->nside);
+  NcmRNG *rng          = ncm_rng_seeded_new (NULL, g_test_rand_int ());
+  const gulong seed    = ncm_rng_get_seed (rng);
+  const guint lmax     = 2 * test->nside;
+  guint l, m;
+  
+  g_assert (test->pix != NULL);
+
+  ncm_sphere_map_pix_add_noise (test->pix, 1.0, rng);
+  ncm_rng_set_seed (rng, seed);
+  ncm_sphere_map_pix_add_noise (pix, 1.0, rng);
+
+  ncm_sphere_map_pix_set_lmax (test->pix, lmax);
+  ncm_sphere_map_pix_set_lmax (pix, lmax);
+
+  ncm_func_eval_set_max_threads (1);
+  ncm_sphere_map_pix_prepare_alm (test->pix);
+  ncm_func_eval_set_max_threads (4);
+  ncm_sphere_map_pix_prepare_alm (pix);
+  ncm_func_eval_set_max_threads (NCM_THREAD_POOL_MAX);
+
+  /* Maps with the same nside and lmax share the Legendre tables. */
+  g_assert (pix->ylm_tab == test->pix->ylm_tab);
+
+  for (l = 0; l <= lmax; l++)
+  {
+    g_assert_cmpfloat (ncm_sphere_map_pix_get_Cl (test->pix, l), ==, ncm_sphere_map_pix_get_Cl (pix, l));
+    for (m = 0; m <= l; m++)
+    {
+      gdouble Re_alm1, Im_alm1, Re_alm2, Im_alm2;
+
+      ncm_sphere_map_pix_get_alm (test->pix, l, m, &Re_alm1, &Im_alm1);
+      ncm_sphere_map_pix_get_alm (pix, l, m, &Re_alm2, &Im_alm2);
+
+      g_assert_cmpfloat (Re_alm1, ==, Re_alm2);
+      g_assert_cmpfloat (Im_alm1, ==, Im_alm2);
+    }
+  }
+
+  ncm_sphere_map_pix_free (pix);
+  ncm_rng_free (rng);
+}
 
 void
 test_ncm_sphere_map_pix_traps (TestNcmSphereMapPix *test, gconstpointer pdata)
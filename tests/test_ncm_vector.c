@@ -55,10 +55,13 @@ void test_ncm_vector_data_malloc_new (TestNcmVector *test, gconstpointer pdata);
 void test_ncm_vector_data_malloc_free (TestNcmVector *test, gconstpointer pdata);
 void test_ncm_vector_data_static_new (TestNcmVector *test, gconstpointer pdata);
 void test_ncm_vector_data_static_free (TestNcmVector *test, gconstpointer pdata);
+void test_ncm_vector_aligned_new (TestNcmVector *test, gconstpointer pdata);
+void test_ncm_vector_aligned_free (TestNcmVector *test, gconstpointer pdata);
 void test_ncm_vector_data_const_new (TestNcmVector *test, gconstpointer pdata);
 void test_ncm_vector_data_const_free (TestNcmVector *test, gconstpointer pdata);
 void test_ncm_vector_sanity (TestNcmVector *test, gconstpointer pdata);
 void test_ncm_vector_operations (TestNcmVector *test, gconstpointer pdata);
+void test_ncm_vector_kernels (TestNcmVector *test, gconstpointer pdata);
 void test_ncm_vector_subvector (TestNcmVector *test, gconstpointer pdata);
 void test_ncm_vector_variant (TestNcmVector *test, gconstpointer pdata);
 void test_ncm_vector_serialization (TestNcmVector *test, gconstpointer pdata);
@@ -83,6 +86,11 @@ main (gint argc, gchar *argv[])
               &test_ncm_vector_operations, 
               &test_ncm_vector_free);
 
+  g_test_add ("/ncm/vector/default/kernels", TestNcmVector, NULL, 
+              &test_ncm_vector_new, 
+              &test_ncm_vector_kernels, 
+              &test_ncm_vector_free);
+
   g_test_add ("/ncm/vector/default/subvector", TestNcmVector, NULL, 
               &test_ncm_vector_new, 
               &test_ncm_vector_subvector,
@@ -228,6 +236,38 @@ main (gint argc, gchar *argv[])
               &test_ncm_vector_serialization,
               &test_ncm_vector_data_static_free);
 
+  /* Aligned vector allocation */
+
+  g_test_add ("/ncm/vector/aligned/sanity", TestNcmVector, NULL, 
+              &test_ncm_vector_aligned_new, 
+              &test_ncm_vector_sanity, 
+              &test_ncm_vector_aligned_free);
+
+  g_test_add ("/ncm/vector/aligned/operations", TestNcmVector, NULL, 
+              &test_ncm_vector_aligned_new, 
+              &test_ncm_vector_operations, 
+              &test_ncm_vector_aligned_free);
+
+  g_test_add ("/ncm/vector/aligned/kernels", TestNcmVector, NULL, 
+              &test_ncm_vector_aligned_new, 
+              &test_ncm_vector_kernels, 
+              &test_ncm_vector_aligned_free);
+
+  g_test_add ("/ncm/vector/aligned/subvector", TestNcmVector, NULL, 
+              &test_ncm_vector_aligned_new, 
+              &test_ncm_vector_subvector,
+              &test_ncm_vector_aligned_free);
+
+  g_test_add ("/ncm/vector/aligned/variant", TestNcmVector, NULL, 
+              &test_ncm_vector_aligned_new, 
+              &test_ncm_vector_variant,
+              &test_ncm_vector_aligned_free);
+
+  g_test_add ("/ncm/vector/aligned/serialization", TestNcmVector, NULL, 
+              &test_ncm_vector_aligned_new, 
+              &test_ncm_vector_serialization,
+              &test_ncm_vector_aligned_free);
+
   /* Data static vector allocation */
 
   g_test_add ("/ncm/vector/data_const/sanity", TestNcmVector, NULL, 
@@ -359,6 +399,26 @@ test_ncm_vector_data_static_free (TestNcmVector *test, gconstpointer pdata)
   NCM_TEST_FREE (ncm_vector_free, v);
 }
 
+void
+test_ncm_vector_aligned_new (TestNcmVector *test, gconstpointer pdata)
+{
+  guint v_size = test->v_size = g_test_rand_int_range (_TEST_NCM_VECTOR_MIN_SIZE, _TEST_NCM_VECTOR_STATIC_SIZE);
+  NcmVector *v = test->v = ncm_vector_new_aligned (v_size);
+
+  g_assert_cmpuint (ncm_vector_len (v), ==, v_size);
+  g_assert_cmpuint (ncm_vector_stride (v), ==, 1);
+  g_assert (ncm_vector_is_aligned (v));
+  g_assert_cmpuint (GPOINTER_TO_SIZE (ncm_vector_data (v)) % NCM_VECTOR_ALIGNMENT, ==, 0);
+  _random_fill (test->v);
+}
+
+void
+test_ncm_vector_aligned_free (TestNcmVector *test, gconstpointer pdata)
+{
+  NcmVector *v = test->v;
+  NCM_TEST_FREE (ncm_vector_free, v);
+}
+
 void
 test_ncm_vector_data_const_new (TestNcmVector *test, gconstpointer pdata)
 {
@@ -591,6 +651,63 @@ test_ncm_vector_variant (TestNcmVector *test, gconstpointer pdata)
   NCM_TEST_FAIL (g_variant_unref (var); fprintf (stderr, "fail (%s)", g_variant_get_type_string (var)));
 }
 
+void
+test_ncm_vector_kernels (TestNcmVector *test, gconstpointer pdata)
+{
+  guint v_size = test->v_size;
+  NcmVector *v = test->v;
+  NcmVector *x = ncm_vector_new (v_size);
+  NcmVector *w = ncm_vector_new (v_size);
+  NcmVector *y = ncm_vector_dup (v);
+  gdouble *sd = g_new (gdouble, 2 * v_size);
+  NcmVector *xs = ncm_vector_new_data_static (sd, v_size, 2);
+  GArray *mask = g_array_new (FALSE, FALSE, sizeof (gboolean));
+  const gdouble alpha = g_test_rand_double_range (-2.0, 2.0);
+  const gdouble beta = g_test_rand_double_range (-2.0, 2.0);
+  gdouble dot = 0.0, wss = 0.0, ss = 0.0;
+  guint i;
+
+  _random_fill (x);
+  _random_fill (w);
+  ncm_vector_memcpy (xs, x);
+  g_array_set_size (mask, v_size);
+
+  for (i = 0; i < v_size; i++)
+  {
+    const gdouble v_i = ncm_vector_get (v, i);
+    const gdouble x_i = ncm_vector_get (x, i);
+    const gboolean m_i = g_test_rand_bit ();
+
+    g_array_index (mask, gboolean, i) = m_i;
+    dot += m_i ? v_i * x_i : 0.0;
+    wss += ncm_vector_get (w, i) * v_i * v_i;
+    ss  += v_i * v_i;
+  }
+
+  ncm_assert_cmpdouble_e (ncm_vector_dot_mask (v, x, mask), ==, dot, 1.0e-14);
+  ncm_assert_cmpdouble_e (ncm_vector_dot_mask (v, xs, mask), ==, dot, 1.0e-14);
+  ncm_assert_cmpdouble_e (ncm_vector_wsumsq (v, w), ==, wss, 1.0e-14);
+  ncm_assert_cmpdouble_e (ncm_vector_wsumsq (v, NULL), ==, ss, 1.0e-14);
+
+  /* Unit stride and strided paths must agree. */
+  ncm_vector_axpby (y, alpha, x, beta);
+  ncm_vector_axpby (xs, beta, v, alpha);
+  for (i = 0; i < v_size; i++)
+  {
+    const gdouble y_i = alpha * ncm_vector_get (x, i) + beta * ncm_vector_get (v, i);
+
+    g_assert_cmpfloat (fabs (ncm_vector_get (y, i) - y_i), <, 1.0e-14);
+    g_assert_cmpfloat (fabs (ncm_vector_get (xs, i) - y_i), <, 1.0e-14);
+  }
+
+  g_array_unref (mask);
+  ncm_vector_free (xs);
+  g_free (sd);
+  ncm_vector_free (y);
+  ncm_vector_free (w);
+  ncm_vector_free (x);
+}
+
 void
 test_ncm_vector_serialization (TestNcmVector *test, gconstpointer pdata)
 {
@@ -0,0 +1,254 @@
+/***************************************************************************
+ *            test_ncm_workspace.c
+ *
+ *  Mon October 19 10:21:37 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * numcosmo
+ * Copyright (C) Sandro Dias Pinto Vitenti 2026 <sandro@isoftware.com.br>
+ * numcosmo is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * numcosmo is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#undef GSL_RANGE_CHECK_OFF
+#endif /* HAVE_CONFIG_H */
+#include <numcosmo/numcosmo.h>
+
+#include <math.h>
+#include <glib.h>
+#include <glib-object.h>
+
+typedef struct _TestNcmWorkspace
+{
+  NcmWorkspace *ws;
+  guint n;
+} TestNcmWorkspace;
+
+void test_ncm_workspace_new (TestNcmWorkspace *test, gconstpointer pdata);
+void test_ncm_workspace_free (TestNcmWorkspace *test, gconstpointer pdata);
+
+void test_ncm_workspace_reuse (TestNcmWorkspace *test, gconstpointer pdata);
+void test_ncm_workspace_views (TestNcmWorkspace *test, gconstpointer pdata);
+void test_ncm_workspace_threads (TestNcmWorkspace *test, gconstpointer pdata);
+void test_ncm_workspace_traps (TestNcmWorkspace *test, gconstpointer pdata);
+void test_ncm_workspace_invalid_order (TestNcmWorkspace *test, gconstpointer pdata);
+
+gint
+main (gint argc, gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  ncm_cfg_init ();
+  ncm_cfg_enable_gsl_err_handler ();
+
+  g_test_add ("/ncm/workspace/reuse", TestNcmWorkspace, NULL,
+              &test_ncm_workspace_new,
+              &test_ncm_workspace_reuse,
+              &test_ncm_workspace_free);
+  g_test_add ("/ncm/workspace/views", TestNcmWorkspace, NULL,
+              &test_ncm_workspace_new,
+              &test_ncm_workspace_views,
+              &test_ncm_workspace_free);
+  g_test_add ("/ncm/workspace/threads", TestNcmWorkspace, NULL,
+              &test_ncm_workspace_new,
+              &test_ncm_workspace_threads,
+              &test_ncm_workspace_free);
+#if !((GLIB_MAJOR_VERSION == 2) && (GLIB_MINOR_VERSION < 38))
+  g_test_add ("/ncm/workspace/traps", TestNcmWorkspace, NULL,
+              &test_ncm_workspace_new,
+              &test_ncm_workspace_traps,
+              &test_ncm_workspace_free);
+  g_test_add ("/ncm/workspace/invalid/order/subprocess", TestNcmWorkspace, NULL,
+              &test_ncm_workspace_new,
+              &test_ncm_workspace_invalid_order,
+              &test_ncm_workspace_free);
+#endif
+
+  g_test_run ();
+}
+
+void
+test_ncm_workspace_new (TestNcmWorkspace *test, gconstpointer pdata)
+{
+  test->ws = ncm_workspace_peek ();
+  test->n  = g_test_rand_int_range (1, 100);
+
+  g_assert (test->ws != NULL);
+  g_assert (test->ws == ncm_workspace_peek ());
+
+  ncm_workspace_trim (test->ws);
+  ncm_workspace_reset_stats (test->ws);
+}
+
+void
+test_ncm_workspace_free (TestNcmWorkspace *test, gconstpointer pdata)
+{
+  g_assert_cmpuint (ncm_workspace_depth (test->ws), ==, 0);
+  ncm_workspace_trim (test->ws);
+}
+
+void
+test_ncm_workspace_reuse (TestNcmWorkspace *test, gconstpointer pdata)
+{
+  NcmWorkspace *ws = test->ws;
+  NcmVector *v1    = ncm_workspace_borrow_vector (ws, test->n);
+  NcmMatrix *m1    = ncm_workspace_borrow_matrix (ws, test->n, test->n + 1);
+  NcmVector *v2, *v3;
+  NcmMatrix *m2;
+
+  g_assert_cmpuint (ncm_vector_len (v1), ==, test->n);
+  g_assert_cmpuint (ncm_matrix_nrows (m1), ==, test->n);
+  g_assert_cmpuint (ncm_matrix_ncols (m1), ==, test->n + 1);
+  g_assert_cmpuint (ncm_workspace_depth (ws), ==, 2);
+  g_assert (ncm_vector_is_aligned (v1));
+  g_assert (ncm_matrix_is_aligned (m1));
+
+  ncm_workspace_return_matrix (ws, m1);
+  ncm_workspace_return_vector (ws, v1);
+  g_assert_cmpuint (ncm_workspace_depth (ws), ==, 0);
+  g_assert_cmpuint (ncm_workspace_get_nalloc (ws), ==, 2);
+
+  /* Same dimensions, the same objects must be handed back. */
+  v2 = ncm_workspace_borrow_vector (ws, test->n);
+  m2 = ncm_workspace_borrow_matrix (ws, test->n, test->n + 1);
+  g_assert (v2 == v1);
+  g_assert (m2 == m1);
+  g_assert_cmpuint (ncm_workspace_get_nalloc (ws), ==, 2);
+
+  /* A different length needs a new vector. */
+  v3 = ncm_workspace_borrow_vector (ws, test->n + 1);
+  g_assert (v3 != v2);
+  g_assert_cmpuint (ncm_vector_len (v3), ==, test->n + 1);
+  g_assert_cmpuint (ncm_workspace_get_nalloc (ws), ==, 3);
+
+  ncm_workspace_return_vector (ws, v3);
+  ncm_workspace_return_matrix (ws, m2);
+
+  /* A vector referenced elsewhere is not reused. */
+  ncm_vector_ref (v2);
+  ncm_workspace_return_vector (ws, v2);
+  v1 = ncm_workspace_borrow_vector (ws, test->n);
+  g_assert (v1 != v2);
+  ncm_workspace_return_vector (ws, v1);
+  ncm_vector_free (v2);
+
+  g_assert_cmpuint (ncm_workspace_get_nborrow (ws), ==, 6);
+}
+
+void
+test_ncm_workspace_views (TestNcmWorkspace *test, gconstpointer pdata)
+{
+  NcmWorkspace *ws = test->ws;
+  NcmVector *v     = ncm_vector_new (2 * test->n);
+  NcmMatrix *m     = ncm_matrix_new (2 * test->n, 3);
+  guint r, i, j;
+
+  for (i = 0; i < 2 * test->n; i++)
+  {
+    ncm_vector_set (v, i, i);
+    for (j = 0; j < 3; j++)
+      ncm_matrix_set (m, i, j, 10.0 * i + j);
+  }
+
+  for (r = 0; r < 3; r++)
+  {
+    const guint k   = g_test_rand_int_range (0, test->n);
+    NcmVector *sv   = ncm_workspace_borrow_subvector (ws, v, k, test->n);
+    NcmMatrix *sm   = ncm_workspace_borrow_submatrix (ws, m, k, 1, test->n, 2);
+
+    g_assert_cmpuint (ncm_vector_len (sv), ==, test->n);
+    g_assert_cmpuint (ncm_matrix_nrows (sm), ==, test->n);
+    g_assert_cmpuint (ncm_matrix_ncols (sm), ==, 2);
+
+    /* The views hold their parents while borrowed. */
+    g_assert_cmpuint (G_OBJECT (v)->ref_count, ==, 2);
+    g_assert_cmpuint (G_OBJECT (m)->ref_count, ==, 2);
+
+    for (i = 0; i < test->n; i++)
+    {
+      g_assert_cmpfloat (ncm_vector_get (sv, i), ==, k + i);
+      for (j = 0; j < 2; j++)
+        g_assert_cmpfloat (ncm_matrix_get (sm, i, j), ==, 10.0 * (k + i) + j + 1);
+    }
+
+    ncm_vector_set (sv, 0, -1.0);
+    g_assert_cmpfloat (ncm_vector_get (v, k), ==, -1.0);
+    ncm_vector_set (v, k, k);
+
+    ncm_workspace_return_matrix (ws, sm);
+    ncm_workspace_return_vector (ws, sv);
+
+    g_assert_cmpuint (G_OBJECT (v)->ref_count, ==, 1);
+    g_assert_cmpuint (G_OBJECT (m)->ref_count, ==, 1);
+  }
+
+  /* The view objects are reused. */
+  g_assert_cmpuint (ncm_workspace_get_nalloc (ws), ==, 2);
+
+  /* A view referenced elsewhere keeps its parent alive after being returned. */
+  {
+    NcmVector *sv = ncm_vector_ref (ncm_workspace_borrow_subvector (ws, v, 1, test->n));
+
+    ncm_workspace_return_vector (ws, sv);
+    ncm_vector_free (v);
+
+    g_assert_cmpfloat (ncm_vector_get (sv, 0), ==, 1.0);
+    ncm_vector_free (sv);
+  }
+
+  ncm_matrix_free (m);
+}
+
+static gpointer
+_test_ncm_workspace_thread (gpointer data)
+{
+  NcmWorkspace *ws = ncm_workspace_peek ();
+  NcmVector *v     = ncm_workspace_borrow_vector (ws, GPOINTER_TO_UINT (data));
+
+  ncm_workspace_return_vector (ws, v);
+
+  return ws;
+}
+
+void
+test_ncm_workspace_threads (TestNcmWorkspace *test, gconstpointer pdata)
+{
+  GThread *thread = g_thread_new ("test_ncm_workspace", &_test_ncm_workspace_thread, GUINT_TO_POINTER (test->n));
+  gpointer ws     = g_thread_join (thread);
+
+  g_assert (ws != test->ws);
+  g_assert_cmpuint (ncm_workspace_get_nalloc (test->ws), ==, 0);
+  g_assert_cmpuint (ncm_workspace_depth (test->ws), ==, 0);
+}
+
+void
+test_ncm_workspace_traps (TestNcmWorkspace *test, gconstpointer pdata)
+{
+#if !((GLIB_MAJOR_VERSION == 2) && (GLIB_MINOR_VERSION < 38))
+  g_test_trap_subprocess ("/ncm/workspace/invalid/order/subprocess", 0, 0);
+  g_test_trap_assert_failed ();
+#endif
+}
+
+void
+test_ncm_workspace_invalid_order (TestNcmWorkspace *test, gconstpointer pdata)
+{
+  NcmVector *v1 = ncm_workspace_borrow_vector (test->ws, test->n);
+  NcmVector *v2 = ncm_workspace_borrow_vector (test->ws, test->n);
+
+  ncm_workspace_return_vector (test->ws, v1);
+  ncm_workspace_return_vector (test->ws, v2);
+}
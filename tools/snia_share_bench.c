@@ -0,0 +1,198 @@
+/***************************************************************************
+ *            snia_share_bench.c
+ *
+ *  Mon October 19 10:31:12 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * snia_share_bench.c
+ *
+ * Copyright (C) 2026 - Sandro Dias Pinto Vitenti
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif /* HAVE_CONFIG_H */
+#include <numcosmo/numcosmo.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/*
+ * Resident set size in MiB from /proc/self/statm, NaN where it is not
+ * available.
+ */
+static gdouble
+_snia_share_bench_rss (void)
+{
+  gchar *contents = NULL;
+  gdouble rss     = GSL_NAN;
+
+  if (g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL))
+  {
+    gulong size, resident;
+
+    if (sscanf (contents, "%lu %lu", &size, &resident) == 2)
+      rss = resident * (gdouble) sysconf (_SC_PAGESIZE) / (1024.0 * 1024.0);
+
+    g_free (contents);
+  }
+
+  return rss;
+}
+
+gint
+main (gint argc, gchar *argv[])
+{
+  gint nthreads_max  = NCM_THREAD_POOL_MAX;
+  gchar *catalog_id  = NULL;
+  gboolean no_share  = FALSE;
+
+  GError *error = NULL;
+  GOptionContext *context;
+  GOptionEntry entries[] =
+  {
+    { "nthreads-max", 't', 0, G_OPTION_ARG_INT,    &nthreads_max, "Largest number of worker copies, the count is doubled from one up to this value.", NULL },
+    { "catalog-id",   'c', 0, G_OPTION_ARG_STRING, &catalog_id,   "SNIa catalog id (default NC_DATA_SNIA_COV_JLA_SNLS3_SDSS_SYS_STAT).", NULL },
+    { "no-share",     'n', 0, G_OPTION_ARG_NONE,   &no_share,     "Do not share the dataset payload, deep-copy every worker.", NULL },
+    { NULL }
+  };
+
+  ncm_cfg_init ();
+
+  context = g_option_context_new ("- benchmarks the NcmFitESMCMC worker duplication on an SNIa dataset.");
+  g_option_context_set_summary (context, "worker duplication benchmark");
+  g_option_context_set_description (context, "Run once with and once without --no-share, the memory of one run is reused by the other when both are done in the same process.");
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+  {
+    g_print ("option parsing failed: %s\n", error->message);
+    exit (1);
+  }
+
+  g_option_context_free (context);
+
+  g_assert_cmpint (nthreads_max, >, 0);
+
+  {
+    NcDataSNIAId snia_id       = NC_DATA_SNIA_COV_JLA_SNLS3_SDSS_SYS_STAT;
+    NcHICosmo *cosmo           = nc_hicosmo_new_from_name (NC_TYPE_HICOSMO, "NcHICosmoDEXcdm");
+    NcDistance *dist           = nc_distance_new (3.0);
+    NcmData *data              = nc_data_snia_cov_new (FALSE);
+    NcmDataset *dset           = ncm_dataset_new ();
+    NcmSerialize *ser          = ncm_serialize_new (NCM_SERIALIZE_OPT_CLEAN_DUP);
+    GPtrArray *workers         = g_ptr_array_new_with_free_func ((GDestroyNotify) &ncm_fit_free);
+    GTimer *bench              = g_timer_new ();
+    NcSNIADistCov *dcov;
+    NcmLikelihood *lh;
+    NcmMSet *mset;
+    NcmFit *fit;
+    gdouble rss0, t_dup = 0.0, t_eval = 0.0;
+    gint nthreads;
+
+    if (catalog_id != NULL)
+    {
+      const GEnumValue *snia_id_val = ncm_cfg_get_enum_by_id_name_nick (NC_TYPE_DATA_SNIA_ID, catalog_id);
+      if (snia_id_val == NULL)
+        g_error ("snia_share_bench: unknown catalog id `%s'.", catalog_id);
+      snia_id = snia_id_val->value;
+    }
+
+    g_assert (snia_id >= NC_DATA_SNIA_COV_START && snia_id <= NC_DATA_SNIA_COV_END);
+
+    nc_data_snia_load_cat (NC_DATA_SNIA_COV (data), snia_id);
+    dcov = nc_snia_dist_cov_new (dist, nc_data_snia_cov_sigma_int_len (NC_DATA_SNIA_COV (data)));
+
+    mset = ncm_mset_new (cosmo, dcov, NULL);
+    ncm_dataset_append_data (dset, data);
+    lh   = ncm_likelihood_new (dset);
+    fit  = ncm_fit_new (NCM_FIT_TYPE_GSL_MMS, "nmsimplex2", lh, mset, NCM_FIT_GRAD_NUMDIFF_FORWARD);
+
+    {
+      gdouble m2lnL;
+      ncm_fit_m2lnL_val (fit, &m2lnL);
+    }
+
+    printf ("# SNIa catalog: %s, %u supernovae, payload %s.\n",
+            ncm_data_peek_desc (data), NC_DATA_SNIA_COV (data)->mu_len,
+            no_share ? "deep-copied" : "shared");
+    printf ("# %8s %14s %14s %14s %14s\n", "copies", "dup (s)", "1st eval (s)", "RSS (MiB)", "RSS/copy (MiB)");
+
+    rss0 = _snia_share_bench_rss ();
+
+    /* The copies accumulate, so the memory released by one row is not reused by the next. */
+    for (nthreads = 1; nthreads <= nthreads_max; nthreads *= 2)
+    {
+      gdouble rss;
+      guint i;
+
+      for (i = workers->len; i < nthreads; i++)
+      {
+        NcmFit *fit_dup;
+        gdouble m2lnL;
+
+        /* Same steps as the NcmFitESMCMC worker duplication. */
+        g_timer_start (bench);
+        if (!no_share)
+          ncm_dataset_share_payload (dset, ser);
+        fit_dup = ncm_fit_dup (fit, ser);
+        ncm_serialize_reset (ser);
+        t_dup += g_timer_elapsed (bench, NULL);
+
+        /* The first evaluation builds the covariance and its decomposition. */
+        g_timer_start (bench);
+        ncm_fit_m2lnL_val (fit_dup, &m2lnL);
+        t_eval += g_timer_elapsed (bench, NULL);
+
+        if (!no_share)
+        {
+          NcDataSNIACov *snia_dup = NC_DATA_SNIA_COV (ncm_dataset_peek_data (fit_dup->lh->dset, 0));
+          g_assert (snia_dup->cov_full == NC_DATA_SNIA_COV (data)->cov_full);
+          g_assert (snia_dup->cov_packed == NC_DATA_SNIA_COV (data)->cov_packed);
+          if (snia_dup->has_complete_cov)
+            g_assert (snia_dup->inv_cov_mm == NC_DATA_SNIA_COV (data)->inv_cov_mm);
+        }
+
+        g_ptr_array_add (workers, fit_dup);
+      }
+
+      rss = _snia_share_bench_rss () - rss0;
+
+      printf ("  %8d %14.6e %14.6e %14.3f %14.3f\n",
+              nthreads, t_dup, t_eval, rss, rss / nthreads);
+      fflush (stdout);
+    }
+
+    g_ptr_array_unref (workers);
+    g_timer_destroy (bench);
+    ncm_serialize_clear (&ser);
+    ncm_fit_free (fit);
+    ncm_likelihood_free (lh);
+    ncm_dataset_free (dset);
+    ncm_data_free (data);
+    ncm_mset_free (mset);
+    nc_snia_dist_cov_free (dcov);
+    nc_distance_free (dist);
+    nc_hicosmo_free (cosmo);
+  }
+
+  g_free (catalog_id);
+
+  return 0;
+}
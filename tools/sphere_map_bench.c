@@ -0,0 +1,135 @@
+/***************************************************************************
+ *            sphere_map_bench.c
+ *
+ *  Mon October 19 10:12:31 2026
+ *  Copyright  2026  Sandro Dias Pinto Vitenti
+ *  <sandro@isoftware.com.br>
+ ****************************************************************************/
+/*
+ * sphere_map_bench.c
+ *
+ * Copyright (C) 2026 - Sandro Dias Pinto Vitenti
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif /* HAVE_CONFIG_H */
+#include <numcosmo/numcosmo.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+gint
+main (gint argc, gchar *argv[])
+{
+  gint nside_min     = 32;
+  gint nside_max     = 512;
+  gint nthreads_max  = NCM_THREAD_POOL_MAX;
+  gdouble lmax_fac   = 2.0;
+  gint nrep          = 2;
+
+  GError *error = NULL;
+  GOptionContext *context;
+  GOptionEntry entries[] =
+  {
+    { "nside-min",    'n', 0, G_OPTION_ARG_INT,    &nside_min,    "Smallest nside (default 32).", NULL },
+    { "nside-max",    'N', 0, G_OPTION_ARG_INT,    &nside_max,    "Largest nside (default 512).", NULL },
+    { "nthreads-max", 't', 0, G_OPTION_ARG_INT,    &nthreads_max, "Largest number of threads, the thread count is doubled from one up to this value.", NULL },
+    { "lmax-factor",  'l', 0, G_OPTION_ARG_DOUBLE, &lmax_fac,     "lmax = lmax-factor x nside (default 2).", NULL },
+    { "repeat",       'r', 0, G_OPTION_ARG_INT,    &nrep,         "Number of transforms for each configuration (default 2).", NULL },
+    { NULL }
+  };
+
+  ncm_cfg_init ();
+
+  context = g_option_context_new ("- benchmarks the NcmSphereMapPix spherical harmonic transforms.");
+  g_option_context_set_summary (context, "spherical harmonic transforms benchmark");
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+  {
+    g_print ("option parsing failed: %s\n", error->message);
+    exit (1);
+  }
+
+  g_option_context_free (context);
+
+  g_assert_cmpint (nside_min, >, 0);
+  g_assert_cmpint (nside_max, >=, nside_min);
+  g_assert_cmpint (nthreads_max, >, 0);
+  g_assert_cmpint (nrep, >, 0);
+
+  {
+    NcmRNG *rng   = ncm_rng_seeded_new (NULL, 123);
+    GTimer *bench = g_timer_new ();
+    gint nside;
+
+    printf ("# %6s %8s %6s %8s %14s %14s %14s %14s\n", "nside", "lmax", "nthr", "setup", "map2alm (s)", "alm2map (s)", "map2alm alm/s", "alm2map alm/s");
+
+    for (nside = nside_min; nside <= nside_max; nside *= 2)
+    {
+      const guint lmax   = lmax_fac * nside;
+      const gdouble nalm = NCM_SPHERE_MAP_PIX_ALM_SIZE (lmax);
+      gint nthreads;
+
+      for (nthreads = 1; nthreads <= nthreads_max; nthreads *= 2)
+      {
+        NcmSphereMapPix *pix = ncm_sphere_map_pix_new (nside);
+        gdouble t_setup, t_map2alm = 0.0, t_alm2map = 0.0;
+        gint i;
+
+        ncm_func_eval_set_max_threads (nthreads);
+        ncm_sphere_map_pix_set_lmax (pix, lmax);
+
+        /* The first transform includes the FFT plans and the Legendre tables. */
+        ncm_sphere_map_pix_add_noise (pix, 1.0, rng);
+        g_timer_start (bench);
+        ncm_sphere_map_pix_prepare_alm (pix);
+        t_setup = g_timer_elapsed (bench, NULL);
+
+        for (i = 0; i < nrep; i++)
+        {
+          ncm_sphere_map_pix_clear_pixels (pix);
+          ncm_sphere_map_pix_add_noise (pix, 1.0, rng);
+
+          g_timer_start (bench);
+          ncm_sphere_map_pix_prepare_alm (pix);
+          t_map2alm += g_timer_elapsed (bench, NULL);
+
+          g_timer_start (bench);
+          ncm_sphere_map_pix_alm2map (pix);
+          t_alm2map += g_timer_elapsed (bench, NULL);
+        }
+
+        t_map2alm /= nrep;
+        t_alm2map /= nrep;
+
+        printf ("  %6d %8u %6d %8.3f %14.6e %14.6e %14.6e %14.6e\n",
+                nside, lmax, nthreads, t_setup - t_map2alm,
+                t_map2alm, t_alm2map, nalm / t_map2alm, nalm / t_alm2map);
+        fflush (stdout);
+
+        ncm_sphere_map_pix_free (pix);
+      }
+    }
+
+    ncm_func_eval_set_max_threads (NCM_THREAD_POOL_MAX);
+    g_timer_destroy (bench);
+    ncm_rng_free (rng);
+  }
+
+  return 0;
+}